@@ -4,6 +4,9 @@ def add_file_downloads(confs : dict) -> list:
         @param confs kconfig vars, dict type
         @return list type, items is dict type
     '''
+    # Linux use local ffmpeg libraries
+    if confs.get("PLATFORM_LINUX", None) and not confs.get("CONFIG_COMPONENTS_COMPILE_FROM_SOURCE", None):
+        return []
     version = f"{confs['CONFIG_FFMPEG_VERSION_MAJOR']}.{confs['CONFIG_FFMPEG_VERSION_MINOR']}.{confs['CONFIG_FFMPEG_VERSION_PATCH']}.{confs['CONFIG_FFMPEG_COMPILED_VERSION']}"
     url = f"https://github.com/sipeed/MaixCDK/releases/download/v0.0.0/ffmpeg_libs_n{version}.tar.xz"
     if version == "4.4.4.1":
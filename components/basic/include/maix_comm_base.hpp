@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add read_conn and write_conn for multiple connections device.
  */
 
 #pragma once
@@ -92,5 +93,36 @@ namespace maix::comm
          * @maixcdk maix.comm.CommBase.read
          */
         virtual Bytes *read(int len, int timeout) = 0;
+
+        /**
+         * Receive data from one of the connections, for device have multiple connections, e.g. socket server.
+         * Default implementation is read of single connection device, connection id is always 0.
+         * @param conn output, connection id of received data
+         * @param buff data buffer to store received data
+         * @param buff_len data buffer length
+         * @param timeout unit ms, 0 means return immediately, -1 means block until data received, >0 means block until data received or timeout.
+         * @return received data length, < 0 means error, value is -err.Err,
+         *         -err.ERR_NOT_OPEN with conn >= 0 means this connection is closed.
+         * @maixcdk maix.comm.CommBase.read_conn
+         */
+        virtual int read_conn(int *conn, uint8_t *buff, int buff_len, int timeout)
+        {
+            *conn = 0;
+            return read(buff, buff_len, -1, timeout);
+        }
+
+        /**
+         * Send data to one connection, for device have multiple connections, e.g. socket server.
+         * Default implementation is write of single connection device.
+         * @param conn connection id got from read_conn, -1 means all connections.
+         * @param buff data buffer
+         * @param len data length
+         * @return sent data length, < 0 means error, value is -err.Err.
+         * @maixcdk maix.comm.CommBase.write_conn
+         */
+        virtual int write_conn(int conn, const uint8_t *buff, int len)
+        {
+            return write(buff, len);
+        }
     };
 }
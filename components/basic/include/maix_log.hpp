@@ -3,17 +3,45 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add log level, asynchronous mode, file and syslog output, rate limit.
  */
 
 #ifndef __MAIX_LOG_H
 #define __MAIX_LOG_H
 
 #include <stdio.h>
+#include <stdint.h>
 #include "global_config.h"
 #include <stdarg.h>
+#include <string>
+#include "maix_err.hpp"
+
+/**
+ * Max log level compiled in, log functions of higher level are empty inline functions,
+ * set by CONFIG_LOG_LEVEL_MAX in menuconfig, 0: none, 1: error, 2: warn, 3: info, 4: debug.
+ */
+#ifdef CONFIG_LOG_LEVEL_MAX
+#define MAIX_LOG_LEVEL_MAX CONFIG_LOG_LEVEL_MAX
+#else
+#define MAIX_LOG_LEVEL_MAX 4
+#endif
 
 namespace maix::log
 {
+    /**
+     * Log level
+     * @maixcdk maix.log.LogLevel
+     */
+    enum LogLevel
+    {
+        LEVEL_NONE = 0,  // no log, print() not affected
+        LEVEL_ERROR,
+        LEVEL_WARN,
+        LEVEL_INFO,
+        LEVEL_DEBUG,
+    };
+
+#if MAIX_LOG_LEVEL_MAX >= 1
     /**
      * print error log
      * @param fmt format string
@@ -21,7 +49,11 @@ namespace maix::log
      * @maixcdk maix.log.error
     */
     void error(const char *fmt, ...);
+#else
+    inline void error(const char *fmt, ...) { (void)fmt; }
+#endif
 
+#if MAIX_LOG_LEVEL_MAX >= 2
     /**
      * print warning log
      * @param fmt format string
@@ -29,7 +61,11 @@ namespace maix::log
      * @maixcdk maix.log.warn
     */
     void warn(const char *fmt, ...);
+#else
+    inline void warn(const char *fmt, ...) { (void)fmt; }
+#endif
 
+#if MAIX_LOG_LEVEL_MAX >= 3
     /**
      * print info log
      * @param fmt format string
@@ -37,7 +73,11 @@ namespace maix::log
      * @maixcdk maix.log.info
     */
     void info(const char *fmt, ...);
+#else
+    inline void info(const char *fmt, ...) { (void)fmt; }
+#endif
 
+#if MAIX_LOG_LEVEL_MAX >= 4
     /**
      * print debug log
      * @param fmt format string
@@ -45,8 +85,12 @@ namespace maix::log
      * @maixcdk maix.log.debug
     */
     void debug(const char *fmt, ...);
+#else
+    inline void debug(const char *fmt, ...) { (void)fmt; }
+#endif
 
 
+#if MAIX_LOG_LEVEL_MAX >= 1
     /**
      * print error log, but not add '\n' at end
      * @param fmt format string
@@ -54,7 +98,11 @@ namespace maix::log
      * @maixcdk maix.log.error0
     */
     void error0(const char *fmt, ...);
+#else
+    inline void error0(const char *fmt, ...) { (void)fmt; }
+#endif
 
+#if MAIX_LOG_LEVEL_MAX >= 2
     /**
      * print warning log, but not add '\n' at end
      * @param fmt format string
@@ -62,7 +110,11 @@ namespace maix::log
      * @maixcdk maix.log.warn0
     */
     void warn0(const char *fmt, ...);
+#else
+    inline void warn0(const char *fmt, ...) { (void)fmt; }
+#endif
 
+#if MAIX_LOG_LEVEL_MAX >= 3
     /**
      * print info log, but not add '\n' at end
      * @param fmt format string
@@ -70,7 +122,11 @@ namespace maix::log
      * @maixcdk maix.log.info0
     */
     void info0(const char *fmt, ...);
+#else
+    inline void info0(const char *fmt, ...) { (void)fmt; }
+#endif
 
+#if MAIX_LOG_LEVEL_MAX >= 4
     /**
      * print debug log, but not add '\n' at end
      * @param fmt format string
@@ -78,6 +134,9 @@ namespace maix::log
      * @maixcdk maix.log.debug0
     */
     void debug0(const char *fmt, ...);
+#else
+    inline void debug0(const char *fmt, ...) { (void)fmt; }
+#endif
 
     /**
      * same as printf, but recommend use this function instead of printf
@@ -88,6 +147,98 @@ namespace maix::log
     */
     void print(const char *fmt, ...);
 
+    /**
+     * Set log level at runtime, logs of higher level are ignored.
+     * @param level log level, default LEVEL_DEBUG(debug log only printed in debug build).
+     * @maixcdk maix.log.set_level
+     */
+    void set_level(log::LogLevel level);
+
+    /**
+     * Get current log level
+     * @return log level
+     * @maixcdk maix.log.get_level
+     */
+    log::LogLevel get_level();
+
+    /**
+     * Enable or disable asynchronous log.
+     * In asynchronous mode, log functions only copy format string pointer and arguments to a lock free ring buffer of the calling thread,
+     * a background thread formats them and writes to stdout, file and syslog in time order, so log not block real time threads like camera and NN.
+     * String literals(format and %s args) are stored by pointer, other strings are copied, so args can be freed after log function return.
+     * If ring buffer is full, the log is dropped and counted, a warning with dropped number will be printed later.
+     * Logs not flushed when program crash will be lost, call flush() to wait all logs written.
+     * Exit of program(call exit or return from main) will flush and stop automatically.
+     * @param enable true to start background thread, false to flush all logs and stop background thread.
+     * @param ring_size ring buffer size of each thread, unit byte, rounded up to power of 2, only affect threads log first time after this call.
+     * @param flush_interval_ms background thread write logs every flush_interval_ms, error log and ring half full wakeup it immediately.
+     * @return err::Err type, err::ERR_NONE if success.
+     * @maixcdk maix.log.set_async
+     */
+    err::Err set_async(bool enable, int ring_size = 65536, int flush_interval_ms = 10);
+
+    /**
+     * Whether asynchronous log enabled
+     * @return true if enabled
+     * @maixcdk maix.log.is_async
+     */
+    bool is_async();
+
+    /**
+     * Wait all logs in ring buffers written to outputs, only useful in asynchronous mode.
+     * @maixcdk maix.log.flush
+     */
+    void flush();
+
+    /**
+     * Enable or disable output log to stdout
+     * @param enable default true.
+     * @maixcdk maix.log.set_stdout
+     */
+    void set_stdout(bool enable);
+
+    /**
+     * Output log to file, with time and thread id prefix every line.
+     * When file size exceed max_size, file is renamed to path.1(path.1 to path.2, ...) and a new file created.
+     * @param path file path, empty string to close file output.
+     * @param max_size max file size, unit byte.
+     * @param max_files max number of rotated files(path.1 ~ path.max_files) kept, 0 means truncate file when reach max_size.
+     * @return err::Err type, err::ERR_IO if open file failed.
+     * @maixcdk maix.log.set_file
+     */
+    err::Err set_file(const std::string &path, int max_size = 1048576, int max_files = 3);
+
+    /**
+     * Output log to syslog socket, message format "<priority>ident[pid]: log".
+     * @param ident tag of log, empty string to disable syslog output.
+     * @param path unix datagram socket path of syslog daemon.
+     * @return err::Err type, err::ERR_IO if create socket failed.
+     * @maixcdk maix.log.set_syslog
+     */
+    err::Err set_syslog(const std::string &ident, const std::string &path = "/dev/log");
+
+    /**
+     * Limit log count of every call site(format string) of every thread per second, error log also limited.
+     * Logs over limit are dropped, and number of them printed with the next log of the call site.
+     * @param max_per_second max log count per call site per second, 0 means no limit.
+     * @maixcdk maix.log.set_rate_limit
+     */
+    void set_rate_limit(int max_per_second);
+
+    /**
+     * Total number of logs dropped because of ring buffer full
+     * @return dropped count
+     * @maixcdk maix.log.dropped_count
+     */
+    uint64_t dropped_count();
+
+    /**
+     * Total number of logs dropped by rate limit
+     * @return suppressed count
+     * @maixcdk maix.log.suppressed_count
+     */
+    uint64_t suppressed_count();
+
 } // namespace maix::log
 
 
@@ -3,6 +3,8 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add slice by 8 CRC16, scatter-gather encode and FrameRing.
+ * @update 2026.10.18: Ring buffer decoder and Protocol.decode_all.
  */
 
 #pragma once
@@ -11,6 +13,7 @@
 #include <tuple>
 #include <valarray>
 #include <string>
+#include <vector>
 #include "maix_err.hpp"
 #include "maix_type.hpp"
 
@@ -39,6 +42,7 @@ namespace maix
         {
             CMD_APP_MAX = 0xC8,     //  200, max app custom CMD value should < CMD_APP_MAX
 
+            CMD_SYS_METRICS  = 0xF7, // query recent system metrics(cpu, memory, temperature)
             CMD_SET_REPORT   = 0xF8, // set auto upload data mode
             CMD_APP_LIST     = 0xF9,
             CMD_START_APP    = 0xFA,
@@ -232,6 +236,9 @@ namespace maix
 
         private:
             int _body_buff_len;
+            bool _body_view{false}; // body points to Protocol's buffer, not owned
+
+            friend class Protocol;
         };
 
         /**
@@ -290,6 +297,24 @@ namespace maix
             */
             protocol::MSG *decode(const Bytes *new_data = nullptr);
 
+            /**
+             * Decode all complete messages in data queue.
+             * Returned messages are reused and their body point to data queue directly(no copy),
+             * so no memory allocation in steady state, they are only valid until next push_data or decode call,
+             * and don't delete them.
+             * @param new_data new data add to data queue, if null, only decode.
+             * @param len new data length, can be 0.
+             * @return decoded messages, empty if no message decoded.
+             * @maixcdk maix.protocol.Protocol.decode_all
+            */
+            const std::vector<protocol::MSG *> &decode_all(const uint8_t *new_data = nullptr, size_t len = 0);
+
+            /**
+             * Data length in data queue, not decoded yet
+             * @maixpy maix.protocol.Protocol.data_len
+            */
+            int data_len() { return _data_len; }
+
             /**
              * Encode response ok(success) message to buffer
              * @param buff output buffer
@@ -376,9 +401,22 @@ namespace maix
 
         private:
             int _buff_size;
-            uint8_t *_buff;
+            uint8_t *_buff;         // ring buffer
+            int _head;              // read position
             int _data_len;
             uint32_t _header;
+            int _frame_len;         // length of frame at head whose header is valid, 0 means not found yet
+            uint16_t _crc;          // CRC of first _crc_len bytes of frame at head
+            int _crc_len;
+            uint8_t *_linear;       // copy of frame wrapped at buffer end
+            std::vector<protocol::MSG *> _msgs;  // reused messages of decode_all
+            std::vector<protocol::MSG *> _batch;
+
+            uint8_t _at(int offset);
+            void _skip(int len);
+            bool _find_header();
+            int _find_frame();
+            uint8_t *_frame_data(int frame_len);
         };
 
         /**
@@ -398,6 +436,16 @@ namespace maix
         */
         uint16_t crc16_IBM(const Bytes *data);
 
+        /**
+         * @brief Update CRC16-IBM with more data, for calculate CRC of data not in one buffer.
+         * @param crc last CRC value, 0 for the first block
+         * @param data data
+         * @param len data length
+         * @return new CRC16-IBM value, uint16_t type.
+         * @maixcdk maix.protocol.crc16_IBM_update
+        */
+        uint16_t crc16_IBM_update(uint16_t crc, const uint8_t *data, size_t len);
+
         /**
          * @brief Encode message to buffer
          * @param out_buff output buffer
@@ -413,5 +461,112 @@ namespace maix
         */
         int encode(uint8_t *out_buff, int out_buff_len, uint8_t cmd, uint8_t flags, uint8_t *body, int body_len, uint8_t code = 0xFF, const uint8_t version = VERSION);
 
+        /**
+         * @brief Encode message head and tail only, body is not copied, for scatter-gather send(writev, sendmsg),
+         *        a frame is head + body + tail.
+         * @param head output head buffer, at least 11 bytes
+         * @param tail output tail(CRC) buffer, at least 2 bytes
+         * @param cmd CMD value
+         * @param flags FLAGS value, @see maix.protocol.FLAGS
+         * @param body message body, can be null, used to calculate CRC
+         * @param body_len message body length, can be 0
+         * @param code error code, only for error message, that is FLAGS.FLAG_ERR in flags
+         * @param version protocol version
+         * @return head length(10 or 11), if < 0, means error, and the error code is -err.Err
+         * @maixcdk maix.protocol.encode_head_tail
+        */
+        int encode_head_tail(uint8_t *head, uint8_t *tail, uint8_t cmd, uint8_t flags, const uint8_t *body, int body_len, uint8_t code = 0xFF, const uint8_t version = VERSION);
+
+        /**
+         * @brief Ring buffer of encoded frames, encode messages directly into it and send from it,
+         *        no memory allocation per message.
+         * Every frame is stored continuously, so one frame can be sent by one write call.
+         * Not thread safe, lock it yourself if encode and send in different threads.
+         * @maixcdk maix.protocol.FrameRing
+        */
+        class FrameRing
+        {
+        public:
+            /**
+             * @brief Construct a new FrameRing object
+             * @param size buffer size, should larger than max frame size(body length + 13)
+             * @param buff buffer provided by caller, if nullptr, will alloc one and free it when destruct.
+             * @maixcdk maix.protocol.FrameRing.FrameRing
+            */
+            FrameRing(int size, uint8_t *buff = nullptr);
+            ~FrameRing();
+
+            /**
+             * @brief Encode message to ring buffer
+             * @param cmd CMD value
+             * @param flags FLAGS value, @see maix.protocol.FLAGS
+             * @param body message body, can be null
+             * @param body_len message body length, can be 0
+             * @param code error code, only for error message, that is FLAGS.FLAG_ERR in flags
+             * @return encoded data length, if < 0, means error, and the error code is -err.Err,
+             *         -err::ERR_BUFF_FULL means no enough space, consume some data first.
+             * @maixcdk maix.protocol.FrameRing.encode
+            */
+            int encode(uint8_t cmd, uint8_t flags, const uint8_t *body, int body_len, uint8_t code = 0xFF);
+
+            /**
+             * @brief Reserve continuous space for one frame, write it and call commit.
+             * @param len space length
+             * @return space address, nullptr if no enough space.
+             * @maixcdk maix.protocol.FrameRing.reserve
+            */
+            uint8_t *reserve(int len);
+
+            /**
+             * @brief Commit data written to reserved space
+             * @param len data length, should <= reserved length
+             * @maixcdk maix.protocol.FrameRing.commit
+            */
+            void commit(int len);
+
+            /**
+             * @brief Get continuous data to send, may be several frames.
+             * @param data output data address
+             * @return data length, 0 if no data.
+             * @maixcdk maix.protocol.FrameRing.peek
+            */
+            int peek(uint8_t **data);
+
+            /**
+             * @brief Remove sent data
+             * @param len data length, should <= the length peek returned.
+             * @maixcdk maix.protocol.FrameRing.consume
+            */
+            void consume(int len);
+
+            /**
+             * @brief Data length in ring buffer
+             * @maixcdk maix.protocol.FrameRing.used
+            */
+            int used() { return _used; }
+
+            /**
+             * @brief Buffer size
+             * @maixcdk maix.protocol.FrameRing.size
+            */
+            int size() { return _size; }
+
+            /**
+             * @brief Remove all data
+             * @maixcdk maix.protocol.FrameRing.clear
+            */
+            void clear();
+
+        private:
+            uint8_t *_buff;
+            bool _is_alloc;
+            int _size;
+            int _head;     // read position
+            int _tail;     // write position
+            int _wrap;     // end of data at buffer end after write position wrapped to 0, -1 means not wrapped
+            int _used;
+            int _reserved;
+        };
+
     } // namespace protocol
 } // namespace maix
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add MetricsSampler, cpu_usage return usage since last call.
  */
 
 #pragma once
@@ -10,6 +11,8 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <stdint.h>
+#include "maix_err.hpp"
 
 namespace maix::sys
 {
@@ -101,7 +104,8 @@ namespace maix::sys
 
     /**
      * Get CPU usage
-     * @return CPU usage, dict type, e.g. {"cpu": 50.0, "cpu0": 50, "cpu1": 50}
+     * @return CPU usage since last call(first call is since boot), dict type, e.g. {"cpu": 50.0, "cpu0": 50, "cpu1": 50}
+     *         use MetricsSampler to get usage of fixed interval and history.
      * @maixpy maix.sys.cpu_usage
      */
     std::map<std::string, float> cpu_usage();
@@ -129,6 +133,178 @@ namespace maix::sys
      */
     std::vector<std::map<std::string, std::string>> disk_partitions(bool only_disk = true);
 
+    /**
+     * Max CPU cores number recorded by MetricsSampler
+     * @maixpy maix.sys.METRICS_MAX_CORES
+     */
+    const int METRICS_MAX_CORES = 8;
+
+    /**
+     * One sample of system metrics, all values are 0 if not available(e.g. file not exist)
+     * @maixpy maix.sys.Metrics
+     */
+    class Metrics
+    {
+    public:
+        /**
+         * Sample time, time::ticks_ms() value, unit ms
+         * @maixpy maix.sys.Metrics.timestamp
+         */
+        uint64_t timestamp;
+
+        /**
+         * CPU usage of all cores since last sample, unit %, first sample is usage since boot
+         * @maixpy maix.sys.Metrics.cpu
+         */
+        float cpu;
+
+        /**
+         * CPU cores number, max METRICS_MAX_CORES
+         * @maixpy maix.sys.Metrics.core_num
+         */
+        int core_num;
+
+        /**
+         * CPU usage of every core since last sample, unit %
+         * @maixcdk maix.sys.Metrics.cores
+         */
+        float cores[METRICS_MAX_CORES];
+
+        /**
+         * Total memory size, unit Byte
+         * @maixpy maix.sys.Metrics.mem_total
+         */
+        uint64_t mem_total;
+
+        /**
+         * Used memory size(total - available), unit Byte
+         * @maixpy maix.sys.Metrics.mem_used
+         */
+        uint64_t mem_used;
+
+        /**
+         * CPU temperature, unit degree
+         * @maixpy maix.sys.Metrics.temp
+         */
+        float temp;
+
+        /**
+         * Resident memory size of the sampled process, unit Byte
+         * @maixpy maix.sys.Metrics.rss
+         */
+        uint64_t rss;
+
+        /**
+         * Threads number of the sampled process
+         * @maixpy maix.sys.Metrics.threads
+         */
+        int threads;
+
+        /**
+         * CPU usage of every core
+         * @return usage list, unit %
+         * @maixpy maix.sys.Metrics.cpu_cores
+         */
+        std::vector<float> cpu_cores()
+        {
+            return std::vector<float>(cores, cores + core_num);
+        }
+    };
+
+    /**
+     * System metrics sampler.
+     * A background thread samples CPU usage(delta of /proc/stat between two samples), memory, temperature,
+     * RSS and threads number of one process at fixed interval, and keeps recent samples in a ring buffer.
+     * Files are kept open and read with pread to fixed buffers, no memory allocation when sampling.
+     * Read samples(latest, history) is lock free and not block the sampler, so can be called frequently.
+     * @maixpy maix.sys.MetricsSampler
+     */
+    class MetricsSampler
+    {
+    public:
+        /**
+         * Construct a new MetricsSampler object, open metrics files, not start sampling.
+         * @param interval_ms sample interval, unit ms.
+         * @param history number of recent samples to keep.
+         * @param root root directory of procfs and sysfs, default "" means "/",
+         *             can be set to a fake directory with proc/stat, proc/meminfo, proc/<pid>/status
+         *             and sys/class/thermal/thermal_zone0/temp files for test.
+         * @param pid process to sample RSS and threads, -1 means current process.
+         * @maixpy maix.sys.MetricsSampler.__init__
+         * @maixcdk maix.sys.MetricsSampler.MetricsSampler
+         */
+        MetricsSampler(int interval_ms = 1000, int history = 60, const std::string &root = "", int pid = -1);
+        ~MetricsSampler();
+
+        /**
+         * Start background sampling thread, take the first sample immediately.
+         * @return err::Err type, err::ERR_BUSY if already started.
+         * @maixpy maix.sys.MetricsSampler.start
+         */
+        err::Err start();
+
+        /**
+         * Stop background sampling thread.
+         * @return err::Err type
+         * @maixpy maix.sys.MetricsSampler.stop
+         */
+        err::Err stop();
+
+        /**
+         * Is background sampling thread running
+         * @return true if running
+         * @maixpy maix.sys.MetricsSampler.is_running
+         */
+        bool is_running();
+
+        /**
+         * Take one sample now and push to history, for using without background thread.
+         * @return err::Err type, err::ERR_BUSY if background thread is running.
+         * @maixpy maix.sys.MetricsSampler.sample
+         */
+        err::Err sample();
+
+        /**
+         * Get the latest sample
+         * @return latest sample, timestamp is 0 if no sample yet.
+         * @maixpy maix.sys.MetricsSampler.latest
+         */
+        sys::Metrics latest();
+
+        /**
+         * Get recent samples
+         * @param num max number of samples, -1 means all kept samples.
+         * @return samples from old to new.
+         * @maixpy maix.sys.MetricsSampler.history
+         */
+        std::vector<sys::Metrics> history(int num = -1);
+
+        /**
+         * Get total number of samples taken
+         * @return samples count
+         * @maixpy maix.sys.MetricsSampler.count
+         */
+        uint64_t count();
+
+        /**
+         * Get sample interval
+         * @return interval, unit ms
+         * @maixpy maix.sys.MetricsSampler.interval
+         */
+        int interval();
+
+    private:
+        void *_param;
+    };
+
+    /**
+     * Get the process wide metrics sampler, created and started with default args at the first call,
+     * used by modules like comm protocol to share one sampling thread.
+     * @return MetricsSampler object pointer, do not delete it.
+     * @maixcdk maix.sys.metrics_sampler
+     */
+    sys::MetricsSampler *metrics_sampler();
+
     /**
      * register default signal handle
      * @maixpy maix.sys.register_default_signal_handle
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add strides, views(slice, select, transpose), quantization parameters and math ops.
  */
 
 #pragma once
@@ -10,6 +11,7 @@
 #include <vector>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string>
 #include <array>
 #include <numeric>
@@ -17,6 +19,7 @@
 #include <tuple>
 #include <map>
 #include <valarray>
+#include <initializer_list>
 #include "maix_log.hpp"
 #include "maix_err.hpp"
 
@@ -89,7 +92,43 @@ namespace maix
         };
 
         /**
-         * Tensor class
+         * Convert float16(IEEE 754 half) to float32
+         * @maixcdk maix.tensor.fp16_to_fp32
+         */
+        inline float fp16_to_fp32(uint16_t h)
+        {
+            uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+            uint32_t exp = (h >> 10) & 0x1f;
+            uint32_t mant = h & 0x3ff;
+            uint32_t bits;
+            if (exp == 0x1f)
+                bits = sign | 0x7f800000 | (mant << 13);
+            else if (exp != 0)
+                bits = sign | ((exp + 112) << 23) | (mant << 13);
+            else if (mant == 0)
+                bits = sign;
+            else
+            {
+                // subnormal, normalize it
+                exp = 113;
+                while (!(mant & 0x400))
+                {
+                    mant <<= 1;
+                    --exp;
+                }
+                bits = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+            }
+            float f;
+            memcpy(&f, &bits, 4);
+            return f;
+        }
+
+        /**
+         * Tensor class.
+         * Tensor is a n-dimension array with shape and strides, strides are in element unit(not byte),
+         * so slice, select and transpose can return a view share the same memory without copy.
+         * Integer tensors can have quantization parameters, real value = (raw - zero_point) * scale,
+         * get, at, dequantize and math ops return real value.
          * @maixpy maix.tensor.Tensor
          */
         class Tensor
@@ -100,6 +139,8 @@ namespace maix
                 _dtype = DType::FLOAT32;
                 _data = nullptr;
                 _is_alloc = false;
+                _scale = 1.0f;
+                _zero_point = 0;
             }
 
             /**
@@ -116,6 +157,9 @@ namespace maix
                 _dtype = dtype;
                 _data = data;
                 _is_alloc = false;
+                _scale = 1.0f;
+                _zero_point = 0;
+                _strides = _contiguous_strides(shape);
                 int size = 1;
                 for (size_t i = 0; i < shape.size(); i++)
                 {
@@ -129,6 +173,37 @@ namespace maix
                 }
             }
 
+            /**
+             * Tensor constructor with strides, for data not stored continuously, e.g. NPU output with aligned rows.
+             * The memory is not owned by this object.
+             * @param shape tensor shape, a int list
+             * @param dtype tensor element data type, see DType of this module
+             * @param data pointer to data content, can not be nullptr
+             * @param strides step of each dimension, element unit(not byte), size must be the same as shape
+             * @maixcdk maix.tensor.Tensor.Tensor
+             */
+            Tensor(std::vector<int> shape, tensor::DType dtype, void *data, std::vector<int> strides)
+            {
+                if (!data || strides.size() != shape.size())
+                {
+                    log::error("tensor data is null or strides not match shape\n");
+                    throw err::Exception(err::ERR_ARGS);
+                }
+                _shape = shape;
+                _strides = strides;
+                _dtype = dtype;
+                _data = data;
+                _is_alloc = false;
+                _scale = 1.0f;
+                _zero_point = 0;
+            }
+
+            /**
+             * Copy constructor, data is copied(deep copy) to new continuous memory,
+             * dtype and quantization parameters are kept.
+             */
+            Tensor(const Tensor &t);
+
             ~Tensor()
             {
                 if(_is_alloc)
@@ -177,6 +252,31 @@ namespace maix
             */
             std::vector<int> shape() { return _shape; }
 
+            /**
+             * get tensor strides
+             * @return step of each dimension, element unit(not byte), a int list
+             * @maixpy maix.tensor.Tensor.strides
+            */
+            std::vector<int> strides() { return _strides; }
+
+            /**
+             * Whether elements are stored continuously in row-major order,
+             * views got from slice, select or transpose may be not contiguous.
+             * @return true if contiguous
+             * @maixpy maix.tensor.Tensor.is_contiguous
+            */
+            bool is_contiguous()
+            {
+                int64_t step = 1;
+                for (int i = (int)_shape.size() - 1; i >= 0; --i)
+                {
+                    if (_shape[i] != 1 && _strides[i] != step)
+                        return false;
+                    step *= _shape[i];
+                }
+                return true;
+            }
+
             /**
              * expand tensor shape
              * @param axis axis to expand
@@ -193,12 +293,15 @@ namespace maix
                     log::error("axis out of range\n");
                     return;
                 }
+                int stride = (size_t)axis < _shape.size() ? _shape[axis] * _strides[axis] : 1;
                 _shape.insert(_shape.begin() + axis, 1);
+                _strides.insert(_strides.begin() + axis, stride);
             }
 
             /**
              * reshape tensor shape, if size not match, it will throw an err::Exception
              * @param shape new shape
+             * @throw err::Exception if size not match or tensor is not contiguous(call contiguous() first)
              * @maixpy maix.tensor.Tensor.reshape
             */
             void reshape(std::vector<int> shape)
@@ -213,16 +316,23 @@ namespace maix
                     log::error("reshape size not match\n");
                     throw err::Exception(err::ERR_ARGS);
                 }
+                if (!is_contiguous())
+                {
+                    log::error("reshape tensor not contiguous\n");
+                    throw err::Exception(err::ERR_NOT_PERMIT);
+                }
                 _shape = shape;
+                _strides = _contiguous_strides(shape);
             }
 
             /**
              * Flatten tensor shape to 1D
+             * @throw err::Exception if tensor is not contiguous(call contiguous() first)
              * @maixpy maix.tensor.Tensor.flatten
             */
             void flatten()
             {
-                _shape = {size_int()};
+                reshape({size_int()});
             }
 
             int size_int()
@@ -249,58 +359,207 @@ namespace maix
             void *data() { return _data; }
 
             /**
-             * get tensor data and return a list
-             * @return list type data
-             * @maixpy maix.tensor.Tensor.to_float_list
+             * Set quantization parameters of integer tensor, real value = (raw - zero_point) * scale.
+             * @param scale quantization scale
+             * @param zero_point quantization zero point
+             * @maixpy maix.tensor.Tensor.set_quant
             */
-            std::valarray<float>* to_float_list()
+            void set_quant(float scale, int zero_point = 0)
             {
-                return new std::valarray<float>((float*)_data, size_int());
+                _scale = scale;
+                _zero_point = zero_point;
             }
 
-            void operator=(Tensor &t)
+            /**
+             * get quantization scale
+             * @return scale, default 1.0
+             * @maixpy maix.tensor.Tensor.scale
+            */
+            float scale() { return _scale; }
+
+            /**
+             * get quantization zero point
+             * @return zero point, default 0
+             * @maixpy maix.tensor.Tensor.zero_point
+            */
+            int zero_point() { return _zero_point; }
+
+            /**
+             * Element offset of index, element unit, used with get() to read elements fast in C++.
+             * @param idx index of each dimension, size must be the same as shape, not checked.
+             * @return offset from data(), element unit
+             * @maixcdk maix.tensor.Tensor.offset
+            */
+            inline int64_t offset(std::initializer_list<int> idx) const
             {
-                printf("copy tensor %d, %d\n", _is_alloc, size_int());
-                if(_is_alloc && size_int() < t.size_int())
-                {
-                    free(_data);
-                    _data = nullptr;
-                }
-                else if(!_is_alloc && size_int() !=0 && size_int() < t.size_int())
+                int64_t off = 0;
+                const int *s = _strides.data();
+                for (int i : idx)
+                    off += (int64_t)i * *s++;
+                return off;
+            }
+
+            /**
+             * Element offset of index, element unit, used with get() to read elements fast in C++.
+             * @param idx index of each dimension, size must be the same as shape, not checked.
+             * @return offset from data(), element unit
+             * @maixcdk maix.tensor.Tensor.offset
+            */
+            inline int64_t offset(const std::vector<int> &idx) const
+            {
+                int64_t off = 0;
+                for (size_t i = 0; i < idx.size(); ++i)
+                    off += (int64_t)idx[i] * _strides[i];
+                return off;
+            }
+
+            /**
+             * Read element as float, integer elements are dequantized, float16 is converted.
+             * @param off element offset from data(), see offset()
+             * @return element real value
+             * @maixcdk maix.tensor.Tensor.get
+            */
+            inline float get(int64_t off) const
+            {
+                switch (_dtype)
                 {
-                    log::error("tensor copy: size not match\n");
-                    throw err::Exception(err::ERR_ARGS);
+                case DType::FLOAT32:
+                    return ((float *)_data)[off];
+                case DType::INT8:
+                    return (((int8_t *)_data)[off] - _zero_point) * _scale;
+                case DType::UINT8:
+                    return (((uint8_t *)_data)[off] - _zero_point) * _scale;
+                case DType::INT16:
+                    return (((int16_t *)_data)[off] - _zero_point) * _scale;
+                case DType::UINT16:
+                    return (((uint16_t *)_data)[off] - _zero_point) * _scale;
+                case DType::INT32:
+                    return (((int32_t *)_data)[off] - _zero_point) * _scale;
+                case DType::UINT32:
+                    return ((int64_t)((uint32_t *)_data)[off] - _zero_point) * _scale;
+                case DType::FLOAT16:
+                    return fp16_to_fp32(((uint16_t *)_data)[off]);
+                case DType::FLOAT64:
+                    return (float)((double *)_data)[off];
+                case DType::BOOL:
+                    return ((uint8_t *)_data)[off] ? 1.0f : 0.0f;
+                default:
+                    return 0;
                 }
-                _shape = t.shape();
-                _dtype = t.dtype();
-                if (!_data)
+            }
+
+            /**
+             * Get element real value at index, integer elements are dequantized.
+             * @param idx index of each dimension, wrong index will throw an err::Exception
+             * @return element value
+             * @maixpy maix.tensor.Tensor.at
+            */
+            float at(const std::vector<int> &idx)
+            {
+                if (idx.size() != _shape.size())
+                    throw err::Exception(err::ERR_ARGS, "index dims not match");
+                for (size_t i = 0; i < idx.size(); ++i)
                 {
-                    _data = malloc(t.size_int() * dtype_size[t.dtype()]);
-                    _is_alloc = true;
+                    if (idx[i] < 0 || idx[i] >= _shape[i])
+                        throw err::Exception(err::ERR_ARGS, "index out of range");
                 }
-                memcpy(_data, t.data(), t.size_int() * dtype_size[t.dtype()]);
+                return get(offset(idx));
             }
 
+            /**
+             * get tensor data and return a list, integer elements are dequantized
+             * @return list type data
+             * @maixpy maix.tensor.Tensor.to_float_list
+            */
+            std::valarray<float>* to_float_list();
+
+            /**
+             * Copy data from another tensor, shape, dtype and quantization parameters are copied too.
+             * If this tensor not own memory and memory size not enough will throw an err::Exception.
+             */
+            void operator=(Tensor &t);
+
+            /**
+             * Slice along one axis without copy, like data[start:stop:step] in python.
+             * @param axis axis to slice, negative means count from the last axis
+             * @param start start index, negative means count from the end
+             * @param stop stop index(not included), negative means count from the end, out of range will be clipped
+             * @param step step, must > 0
+             * @return view tensor share memory with this tensor, this tensor must be kept alive when using view,
+             *         wrong args will throw an err::Exception. you need to delete it after use in C++.
+             * @maixpy maix.tensor.Tensor.slice
+            */
+            tensor::Tensor *slice(int axis, int start, int stop, int step = 1);
+
+            /**
+             * Select one index of axis without copy, the axis is removed, like data[:, index] in python.
+             * @param axis axis to select, negative means count from the last axis
+             * @param index index in axis, negative means count from the end
+             * @return view tensor share memory with this tensor, this tensor must be kept alive when using view,
+             *         wrong args will throw an err::Exception. you need to delete it after use in C++.
+             * @maixpy maix.tensor.Tensor.select
+            */
+            tensor::Tensor *select(int axis, int index);
+
+            /**
+             * Permute axes without copy.
+             * @param axes new order of axes, e.g. [0, 2, 3, 1] convert NCHW to NHWC, empty means reverse all axes.
+             * @return view tensor share memory with this tensor, this tensor must be kept alive when using view,
+             *         wrong args will throw an err::Exception. you need to delete it after use in C++.
+             * @maixpy maix.tensor.Tensor.transpose
+            */
+            tensor::Tensor *transpose(const std::vector<int> &axes = std::vector<int>());
+
+            /**
+             * Copy to new contiguous tensor, dtype and quantization parameters are kept.
+             * @return new tensor, you need to delete it after use in C++.
+             * @maixpy maix.tensor.Tensor.contiguous
+            */
+            tensor::Tensor *contiguous();
+
+            /**
+             * Convert to float32 contiguous tensor, integer elements are dequantized with scale and zero_point.
+             * @return new float32 tensor, you need to delete it after use in C++.
+             * @maixpy maix.tensor.Tensor.dequantize
+            */
+            tensor::Tensor *dequantize();
+
+            /**
+             * Sigmoid of every element.
+             * @param out float32 output tensor with the same shape, can be a view,
+             *            nullptr means in place, only float32 tensor support in place.
+             * @return err::Err type, ERR_ARGS if out shape or dtype not match.
+             * @maixpy maix.tensor.Tensor.sigmoid
+            */
+            err::Err sigmoid(tensor::Tensor *out = nullptr);
+
+            /**
+             * Exponential of every element.
+             * @param out float32 output tensor with the same shape, can be a view,
+             *            nullptr means in place, only float32 tensor support in place.
+             * @return err::Err type, ERR_ARGS if out shape or dtype not match.
+             * @maixpy maix.tensor.Tensor.exp
+            */
+            err::Err exp(tensor::Tensor *out = nullptr);
+
+            /**
+             * Softmax along axis.
+             * @param axis axis to do softmax, negative means count from the last axis
+             * @param out float32 output tensor with the same shape, can be a view,
+             *            nullptr means in place, only float32 tensor support in place.
+             * @return err::Err type, ERR_ARGS if axis wrong or out shape or dtype not match.
+             * @maixpy maix.tensor.Tensor.softmax
+            */
+            err::Err softmax(int axis = -1, tensor::Tensor *out = nullptr);
 
             /**
              * argmax of tensor
-             * @param axis By default, the index is into the flattened array, otherwise along the specified axis., wrong axis will throw an err::Exception
-             * @return argmax result, you need to delete it after use in C++.
+             * @param axis By default, the index is into the flattened array, otherwise along the specified axis, negative means count from the last axis.
+             *             wrong axis will throw an err::Exception
+             * @return argmax result, int32 tensor, shape is {1} for flattened array, or shape remove axis, you need to delete it after use in C++.
              * @maixpy maix.tensor.Tensor.argmax
             */
-           tensor::Tensor *argmax(int axis = 0xffff)
-           {
-                if(axis != 0xffff)
-                {
-                        log::error("only support flatten now\n");
-                        throw err::Exception(err::ERR_NOT_IMPL);
-                }
-                int max_idx = _get_argmax0(_dtype, _data, size_int());
-                tensor::Tensor *ret = new tensor::Tensor({1}, tensor::DType::INT32);
-                int *ret_data = (int *)ret->data();
-                ret_data[0] = max_idx;
-                return ret;
-           }
+            tensor::Tensor *argmax(int axis = 0xffff);
 
             /**
              * argmax1, flattened data max index
@@ -309,6 +568,13 @@ namespace maix
             */
             int argmax1()
             {
+                if (!is_contiguous())
+                {
+                    tensor::Tensor *ret = argmax();
+                    int idx = ((int *)ret->data())[0];
+                    delete ret;
+                    return idx;
+                }
                 return _get_argmax0(_dtype, _data, size_int());
             }
 
@@ -324,8 +590,14 @@ namespace maix
                     log::error("k > tensor size\n");
                     throw err::Exception(err::ERR_ARGS);
                 }
+                if (!is_contiguous())
+                {
+                    log::error("topk tensor not contiguous\n");
+                    throw err::Exception(err::ERR_NOT_PERMIT);
+                }
 
                 tensor::Tensor *value = new tensor::Tensor({k}, _dtype);
+                value->set_quant(_scale, _zero_point);
                 std::vector<int> *index = new std::vector<int>(k);
 
                 #define SORT_TOP_K(type) do{\
@@ -377,11 +649,28 @@ namespace maix
 
         private:
             std::vector<int> _shape;
+            std::vector<int> _strides;
             DType _dtype;
             void *_data;
             bool _is_alloc;
+            float _scale;
+            int _zero_point;
 
         private:
+            static std::vector<int> _contiguous_strides(const std::vector<int> &shape)
+            {
+                std::vector<int> strides(shape.size());
+                int step = 1;
+                for (int i = (int)shape.size() - 1; i >= 0; --i)
+                {
+                    strides[i] = step;
+                    step *= shape[i];
+                }
+                return strides;
+            }
+
+            tensor::Tensor *_view(const std::vector<int> &shape, const std::vector<int> &strides, int64_t offset);
+
             template <typename T>
             static int _get_argmax(T dtype, void *data, size_t size)
             {
@@ -467,22 +756,28 @@ namespace maix
             }
 
             /**
-             * Add tensor
+             * Add tensor, tensor index is the add order, add tensor with existing key will replace it and keep index.
              * @maixpy maix.tensor.Tensors.add_tensor
             */
             void add_tensor(const std::string &key, tensor::Tensor *tensor, bool copy, bool auto_delete)
             {
                 if(copy)
                 {
-                    tensor::Tensor *t = new tensor::Tensor(*tensor);
-                    tensors[key] = t;
-                    _auto_delete[key] = true;
+                    tensor = new tensor::Tensor(*tensor);
+                    auto_delete = true;
+                }
+                auto it = std::find(_keys.begin(), _keys.end(), key);
+                if (it == _keys.end())
+                {
+                    _keys.push_back(key);
+                    _list.push_back(tensor);
                 }
                 else
                 {
-                    tensors[key] = tensor;
-                    _auto_delete[key] = auto_delete;
+                    _list[it - _keys.begin()] = tensor;
                 }
+                tensors[key] = tensor;
+                _auto_delete[key] = auto_delete;
             }
 
             /**
@@ -491,6 +786,12 @@ namespace maix
             */
             void rm_tensor(const std::string &key)
             {
+                auto it = std::find(_keys.begin(), _keys.end(), key);
+                if (it != _keys.end())
+                {
+                    _list.erase(_list.begin() + (it - _keys.begin()));
+                    _keys.erase(it);
+                }
                 tensors.erase(key);
             }
 
@@ -531,6 +832,21 @@ namespace maix
                 return tensors[key];
             }
 
+            /**
+             * Get tensor by index, index is the add order, e.g. model output order, no map lookup.
+             * @param idx tensor index, negative means count from the end, out of range will throw an err::Exception
+             * @maixpy maix.tensor.Tensors.get_tensor
+             * @maixcdk maix.tensor.Tensors.get_tensor
+            */
+            tensor::Tensor *get_tensor(int idx)
+            {
+                if (idx < 0)
+                    idx += _list.size();
+                if (idx < 0 || (size_t)idx >= _list.size())
+                    throw err::Exception(err::ERR_ARGS, "tensor index out of range");
+                return _list[idx];
+            }
+
             /**
              * Operator []
              * @maixpy maix.tensor.Tensors.__getitem__
@@ -541,6 +857,30 @@ namespace maix
                 return tensors[key];
             }
 
+            /**
+             * Operator [] by index, index is the add order
+             * @maixpy maix.tensor.Tensors.__getitem__
+             * @maixcdk maix.tensor.Tensors.[]
+            */
+            tensor::Tensor *operator[](int idx)
+            {
+                return get_tensor(idx);
+            }
+
+            /**
+             * Get tensor name by index, index is the add order
+             * @param idx tensor index, negative means count from the end, out of range will throw an err::Exception
+             * @maixpy maix.tensor.Tensors.get_name
+            */
+            std::string get_name(int idx)
+            {
+                if (idx < 0)
+                    idx += _keys.size();
+                if (idx < 0 || (size_t)idx >= _keys.size())
+                    throw err::Exception(err::ERR_ARGS, "tensor index out of range");
+                return _keys[idx];
+            }
+
             /**
              * Size
              * @maixpy maix.tensor.Tensors.__len__
@@ -567,12 +907,14 @@ namespace maix
 
         public:
             /**
-             * Tensors data, dict type
+             * Tensors data, dict type, use add_tensor and rm_tensor to modify it, or index lookup will not be updated.
              * @maixpy maix.tensor.Tensors.tensors
             */
             std::map<std::string, tensor::Tensor*> tensors;
         private:
             std::map<std::string, bool> _auto_delete;
+            std::vector<std::string> _keys;
+            std::vector<tensor::Tensor *> _list;
         };
 
 
@@ -3,12 +3,17 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add work stealing thread pool, parallel_for, CPU affinity and real time priority.
  */
 
 #pragma once
 
 #include <functional>
+#include <future>
+#include <memory>
+#include <vector>
 #include "maix_type.hpp"
+#include "maix_err.hpp"
 
 namespace maix
 {
@@ -58,6 +63,139 @@ namespace maix
 
         void sleep_ms(uint32_t ms);
 
+        /**
+         * Get CPU core number online
+         * @return CPU core number, at least 1
+         * @maixpy maix.thread.cpu_count
+         */
+        int cpu_count();
+
+        /**
+         * Bind current thread to CPU cores
+         * @param cpus CPU core indexes, e.g. [1] or [0, 1], empty means all cores
+         * @return err::ERR_NONE if success, err::ERR_ARGS if core index invalid, err::ERR_RUNTIME if system call failed
+         * @maixpy maix.thread.set_cpu_affinity
+         */
+        err::Err set_cpu_affinity(const std::vector<int> &cpus);
+
+        /**
+         * Set real time priority of current thread, use SCHED_FIFO policy.
+         * Need root or CAP_SYS_NICE, a busy real time thread can starve normal threads, so use it carefully.
+         * @param priority [1, 99], bigger is higher, 0 means back to normal(SCHED_OTHER) policy
+         * @return err::ERR_NONE if success, err::ERR_ARGS if priority invalid, err::ERR_NOT_PERMIT if no permission
+         * @maixpy maix.thread.set_realtime_priority
+         */
+        err::Err set_realtime_priority(int priority);
+
+        /**
+         * Work stealing thread pool.
+         * Every worker has its own task deque, tasks submitted in a worker go to its own deque and are taken LIFO(cache hot),
+         * tasks submitted from other threads are distributed to workers round robin,
+         * idle workers steal the oldest tasks from others, so a worker blocked by a long task does not hold up the rest.
+         * Usually use the process wide pool by thread::pool() and thread::parallel_for, instead of creating new pools.
+         * @maixcdk maix.thread.ThreadPool
+         */
+        class ThreadPool
+        {
+        public:
+            /**
+             * Create workers
+             * @param num_threads worker number, <= 0 means CPU core number
+             * @param cpus CPU cores workers bind to, worker i binds to cpus[i % cpus.size()], empty means no binding
+             * @param priority > 0 means run workers with SCHED_FIFO real time priority [1, 99], see set_realtime_priority, 0 means normal
+             * @maixcdk maix.thread.ThreadPool.ThreadPool
+             */
+            ThreadPool(int num_threads = 0, const std::vector<int> &cpus = {}, int priority = 0);
+
+            /**
+             * Run all queued tasks then stop workers
+             */
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool &) = delete;
+            ThreadPool &operator=(const ThreadPool &) = delete;
+
+            /**
+             * Run func in pool
+             * @param func function without arguments, use lambda capture to pass arguments
+             * @return future of func's return value, exception thrown by func is rethrown by future.get()
+             * @maixcdk maix.thread.ThreadPool.submit
+             */
+            template <typename F>
+            std::future<decltype(std::declval<F>()())> submit(F func)
+            {
+                typedef decltype(func()) R;
+                std::shared_ptr<std::packaged_task<R()>> task = std::make_shared<std::packaged_task<R()>>(std::move(func));
+                std::future<R> future = task->get_future();
+                _push([task]() { (*task)(); });
+                return future;
+            }
+
+            /**
+             * Split [begin, end) into chunks and run func(chunk_begin, chunk_end) in pool, return after all chunks finished.
+             * Caller thread runs chunks too, so call it in a pool task(nested) is safe.
+             * @param begin range begin, e.g. first row
+             * @param end range end(not included), e.g. image height
+             * @param func function process [chunk_begin, chunk_end), chunks run concurrently so they should write different memory,
+             *             exception thrown by func is rethrown after all chunks finished.
+             * @param grain chunk size is a multiple of grain except the last one, e.g. 2 for rows of YUV420SP, 1 by default.
+             *              Also the min chunk size, too small chunk costs more on scheduling than computing.
+             * @param num_threads max threads(including caller) used, <= 0 means thread::parallel_threads()
+             * @maixcdk maix.thread.ThreadPool.parallel_for
+             */
+            void parallel_for(int begin, int end, const std::function<void(int, int)> &func, int grain = 1, int num_threads = 0);
+
+            /**
+             * Get worker number
+             * @maixcdk maix.thread.ThreadPool.size
+             */
+            int size();
+
+        private:
+            void _push(std::function<void()> task);
+            void *_param;
+        };
+
+        /**
+         * Get the process wide thread pool, created at first call with thread::cpu_count() workers if not configured by config_pool.
+         * The reference is only valid until config_pool replaces the pool, so don't keep it or use it concurrently with config_pool,
+         * thread::parallel_for holds the pool by itself and is always safe.
+         * @maixcdk maix.thread.pool
+         */
+        thread::ThreadPool &pool();
+
+        /**
+         * Recreate the process wide thread pool, e.g. bind workers to big cores or use real time priority.
+         * Better call it at program start, the old pool is deleted after its running thread::parallel_for calls return and queued tasks finish,
+         * references got from thread::pool() before become invalid then.
+         * @param num_threads worker number, <= 0 means CPU core number
+         * @param cpus CPU cores workers bind to, empty means no binding
+         * @param priority > 0 means SCHED_FIFO real time priority, 0 means normal
+         * @maixcdk maix.thread.config_pool
+         */
+        void config_pool(int num_threads = 0, const std::vector<int> &cpus = {}, int priority = 0);
+
+        /**
+         * Set max threads used by thread::parallel_for and image operators(e.g. Image.to_format, Image.resize of YUV image).
+         * @param num threads number including caller thread, 1 means single thread, <= 0 means CPU core number(default)
+         * @param current_thread_only true to only affect operators called in current thread, e.g. limit threads
+         *                            used in one pipeline stage, false to set the global default.
+         * @maixpy maix.thread.set_parallel_threads
+         */
+        void set_parallel_threads(int num, bool current_thread_only = false);
+
+        /**
+         * Get max threads used by thread::parallel_for and image operators in current thread
+         * @return threads number, >= 1
+         * @maixpy maix.thread.parallel_threads
+         */
+        int parallel_threads();
+
+        /**
+         * Split [begin, end) into chunks and run them in the process wide pool, @see ThreadPool::parallel_for
+         * @maixcdk maix.thread.parallel_for
+         */
+        void parallel_for(int begin, int end, const std::function<void(int, int)> &func, int grain = 1, int num_threads = 0);
 
     }; // namespace thread
 };     // namespace maix
@@ -3,91 +3,1038 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add asynchronous mode with per thread lock free ring buffer, file and syslog output,
+ *                     rate limit, fix shared static buffer of error().
  */
 
 
 #include "maix_log.hpp"
 #include "maix_err.hpp"
 #include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <link.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
 
 namespace maix::log
 {
+#define LOG_RECORD_MAX   2048     // max size of one record in ring buffer
+#define LOG_LINE_MAX     1024     // max length of one formatted log
+#define LOG_SPEC_MAX     32       // max length of one conversion specification, e.g. "%-08.3lf"
+#define LOG_RATE_SLOTS   16       // rate limit slots of every thread, indexed by format string pointer
+#define LOG_RO_RANGE_MAX 256      // max read only segments to check string literals
+#define LOG_BATCH_MAX    4096     // max records written by background thread in one batch
 
-    static char log_buf[512];
+    enum
+    {
+        REC_PAD      = 0x01,      // padding to end of ring buffer, skip it
+        REC_NEWLINE  = 0x02,      // add '\n' at end
+        REC_FMT_COPY = 0x04,      // format string copied after header, not a literal
+        REC_PREFIX   = 0x08,      // add level prefix like "-- [E] "
+    };
 
-    void error(const char *fmt, ...)
+    enum
+    {
+        ARG_NONE = 0,             // "%%", no argument
+        ARG_INT,
+        ARG_DOUBLE,
+        ARG_STR,
+        ARG_PTR,
+        ARG_BAD,                  // not supported by asynchronous mode, e.g. %n %m %ls, format in caller thread instead
+    };
+
+#define STR_PTR_FLAG (1ULL << 63) // string slot flag, string stored as pointer in next slot, or else copied after slot
+
+    /**
+     * Record header in ring buffer, followed by copied format string(REC_FMT_COPY) and 8 bytes aligned argument slots.
+     */
+    typedef struct alignas(8)
+    {
+        uint32_t size;            // total size include header, multiple of 8
+        uint8_t flags;
+        uint8_t level;
+        uint16_t fmt_len;         // length of copied format string
+        uint32_t suppressed;      // logs of the same call site dropped by rate limit before this log
+        uint32_t reserved;
+        uint64_t time_ns;         // CLOCK_REALTIME
+        const char *fmt;
+    } log_record_t;
+
+    typedef struct
+    {
+        const char *start;        // point to '%'
+        int len;                  // length include '%' and conversion
+        int prec;                 // precision, -1 no precision, -2 precision is '*'
+        char conv;                // conversion character
+        char length;              // length modifier, 'H': hh, 'q': ll, others are same as format
+        uint8_t stars;            // number of '*' of width and precision
+    } fmt_spec_t;
+
+    typedef struct
+    {
+        const char *fmt;
+        uint64_t window;          // second of current window
+        uint32_t count;
+        uint32_t suppressed;
+    } rate_slot_t;
+
+    typedef struct
+    {
+        uintptr_t start;
+        uintptr_t end;
+    } ro_range_t;
+
+    /**
+     * Single producer single consumer ring buffer of records, producer is the owner thread, consumer is background thread.
+     */
+    class LogRing
+    {
+    public:
+        LogRing(uint32_t size, int tid)
+            : tid(tid), _size(size), _mask(size - 1)
+        {
+            _buff = new uint64_t[size / 8];
+        }
+
+        ~LogRing()
+        {
+            delete[] _buff;
+        }
+
+        bool push(const void *rec, uint32_t size)
+        {
+            uint64_t tail = _tail.load(std::memory_order_relaxed);
+            uint32_t off = tail & _mask;
+            uint32_t contiguous = _size - off;
+            uint32_t need = size > contiguous ? size + contiguous : size;
+            if (need > _size - (tail - _head_cache))
+            {
+                _head_cache = _head.load(std::memory_order_acquire);
+                if (need > _size - (tail - _head_cache))
+                    return false;
+            }
+            uint8_t *buff = (uint8_t *)_buff;
+            if (size > contiguous)
+            {
+                log_record_t *pad = (log_record_t *)(buff + off);
+                pad->size = contiguous;
+                pad->flags = REC_PAD;
+                tail += contiguous;
+                off = 0;
+            }
+            memcpy(buff + off, rec, size);
+            _tail.store(tail + size, std::memory_order_release);
+            return true;
+        }
+
+        bool half_full()
+        {
+            uint64_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail - _head_cache <= _size / 2)
+                return false;
+            _head_cache = _head.load(std::memory_order_acquire);
+            return tail - _head_cache > _size / 2;
+        }
+
+        const log_record_t *front()
+        {
+            uint64_t head = _head.load(std::memory_order_relaxed);
+            uint64_t tail = _tail.load(std::memory_order_acquire);
+            while (head != tail)
+            {
+                const log_record_t *rec = (const log_record_t *)((uint8_t *)_buff + (head & _mask));
+                if (!(rec->flags & REC_PAD))
+                    return rec;
+                head += rec->size;
+                _head.store(head, std::memory_order_release);
+            }
+            return NULL;
+        }
+
+        void pop(const log_record_t *rec)
+        {
+            _head.store(_head.load(std::memory_order_relaxed) + rec->size, std::memory_order_release);
+        }
+
+        int tid;
+        std::atomic<uint64_t> dropped{0};  // only written by owner thread
+        uint64_t dropped_reported = 0;     // only used by background thread
+        std::atomic<bool> closed{false};   // owner thread exited
+
+    private:
+        uint64_t *_buff;
+        uint32_t _size;
+        uint32_t _mask;
+        alignas(64) std::atomic<uint64_t> _head{0};
+        alignas(64) std::atomic<uint64_t> _tail{0};
+        uint64_t _head_cache = 0;
+    };
+
+    typedef struct
+    {
+        std::mutex config_lock;           // set_async
+        std::mutex rings_lock;            // rings list
+        std::vector<LogRing *> rings;
+        std::mutex drain_lock;            // only one thread consume rings
+        std::vector<LogRing *> drain_rings;
+        std::mutex out_lock;              // outputs and their buffers
+        bool out_stdout = true;
+        std::string out_buff;
+        int file_fd = -1;
+        std::string file_path;
+        uint64_t file_size = 0;
+        uint64_t file_max_size = 0;
+        int file_max_files = 0;
+        bool file_line_start = true;
+        std::string file_buff;
+        int syslog_fd = -1;
+        std::string syslog_ident;
+        struct sockaddr_un syslog_addr;
+        std::thread *thread = nullptr;
+        std::mutex wait_lock;
+        std::condition_variable wait_cond;
+        uint32_t ring_size = 65536;
+        int flush_interval_ms = 10;
+        bool atexit_registered = false;
+        ro_range_t ro_ranges[LOG_RO_RANGE_MAX]; // sorted read only segments of loaded objects
+        int ro_num = 0;
+    } log_state_t;
+
+    // atomics are constant initialized, safe to use by log in static constructors of other files
+    static std::atomic<int> g_level{LEVEL_DEBUG};
+    static std::atomic<bool> g_async{false};
+    static std::atomic<bool> g_running{false};
+    static std::atomic<bool> g_wakeup{false};
+    static std::atomic<int> g_rate_limit{0};
+    static std::atomic<uint64_t> g_suppressed{0};
+    static std::atomic<uint64_t> g_dropped_exited{0};
+    static pthread_key_t g_ring_key;
+    static pthread_once_t g_ring_key_once = PTHREAD_ONCE_INIT;
+    static thread_local LogRing *tl_ring = nullptr;
+    static thread_local int tl_tid = 0;
+    static thread_local rate_slot_t tl_rate[LOG_RATE_SLOTS];
+
+    static const char *level_prefix[] = {"", "-- [E] ", "-- [W] ", "-- [I] ", "-- [D] "};
+    static const char level_char[] = {' ', 'E', 'W', 'I', 'D'};
+    static const int level_syslog[] = {6, 3, 4, 6, 7};  // syslog severity, 3: err, 4: warning, 6: info, 7: debug
+
+    static log_state_t &_state()
+    {
+        // never destructed, log can be used in static destructors
+        static log_state_t *state = new log_state_t();
+        return *state;
+    }
+
+    static inline uint64_t _now_ns()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    static inline int _gettid()
+    {
+        if (tl_tid == 0)
+            tl_tid = (int)syscall(SYS_gettid);
+        return tl_tid;
+    }
+
+    static inline uint32_t _align8(uint32_t n)
+    {
+        return (n + 7) & ~7U;
+    }
+
+    /**
+     * Parse one conversion specification, p point to '%'.
+     * @return pointer after the specification, NULL if not supported(positional argument, too long, or incomplete).
+     */
+    static const char *_parse_spec(const char *p, fmt_spec_t *spec)
+    {
+        spec->start = p++;
+        spec->stars = 0;
+        spec->prec = -1;
+        spec->length = 0;
+        while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' || *p == '\'')
+            ++p;
+        if (*p == '*')
+        {
+            ++spec->stars;
+            ++p;
+        }
+        else
+        {
+            while (*p >= '0' && *p <= '9')
+                ++p;
+        }
+        if (*p == '$')
+            return NULL;
+        if (*p == '.')
+        {
+            ++p;
+            if (*p == '*')
+            {
+                ++spec->stars;
+                spec->prec = -2;
+                ++p;
+            }
+            else
+            {
+                spec->prec = 0;
+                while (*p >= '0' && *p <= '9')
+                    spec->prec = spec->prec * 10 + (*p++ - '0');
+            }
+        }
+        switch (*p)
+        {
+        case 'h':
+            ++p;
+            spec->length = 'h';
+            if (*p == 'h')
+            {
+                spec->length = 'H';
+                ++p;
+            }
+            break;
+        case 'l':
+            ++p;
+            spec->length = 'l';
+            if (*p == 'l')
+            {
+                spec->length = 'q';
+                ++p;
+            }
+            break;
+        case 'q':
+        case 'L':
+        case 'j':
+        case 'z':
+        case 't':
+            spec->length = *p++;
+            break;
+        default:
+            break;
+        }
+        spec->conv = *p;
+        if (*p == '\0' || p + 1 - spec->start >= LOG_SPEC_MAX)
+            return NULL;
+        ++p;
+        spec->len = p - spec->start;
+        return p;
+    }
+
+    static int _arg_kind(const fmt_spec_t &spec)
+    {
+        switch (spec.conv)
+        {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            return ARG_INT;
+        case 'c':
+            return spec.length == 'l' ? ARG_BAD : ARG_INT;
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            return ARG_DOUBLE;
+        case 's':
+            return spec.length == 'l' ? ARG_BAD : ARG_STR;
+        case 'p':
+            return ARG_PTR;
+        case '%':
+            return spec.stars == 0 ? ARG_NONE : ARG_BAD;
+        default:
+            return ARG_BAD;
+        }
+    }
+
+    static int _collect_ro_range(struct dl_phdr_info *info, size_t, void *data)
+    {
+        log_state_t *s = (log_state_t *)data;
+        for (int i = 0; i < info->dlpi_phnum && s->ro_num < LOG_RO_RANGE_MAX; ++i)
+        {
+            const ElfW(Phdr) *phdr = &info->dlpi_phdr[i];
+            if (phdr->p_type != PT_LOAD || (phdr->p_flags & PF_W))
+                continue;
+            s->ro_ranges[s->ro_num].start = info->dlpi_addr + phdr->p_vaddr;
+            s->ro_ranges[s->ro_num].end = info->dlpi_addr + phdr->p_vaddr + phdr->p_memsz;
+            ++s->ro_num;
+        }
+        return 0;
+    }
+
+    static void _update_ro_ranges()
+    {
+        log_state_t &s = _state();
+        s.ro_num = 0;
+        dl_iterate_phdr(_collect_ro_range, &s);
+        std::sort(s.ro_ranges, s.ro_ranges + s.ro_num, [](const ro_range_t &a, const ro_range_t &b) { return a.start < b.start; });
+    }
+
+    /**
+     * Whether string is in read only segment of executable or shared library, i.e. string literal,
+     * which will not be freed or changed, can be stored by pointer.
+     * Libraries loaded by dlopen after set_async are not included, their strings will be copied.
+     */
+    static bool _is_literal(const char *str)
+    {
+        log_state_t &s = _state();
+        uintptr_t addr = (uintptr_t)str;
+        int lo = 0, hi = s.ro_num;
+        while (lo < hi)
+        {
+            int mid = (lo + hi) / 2;
+            if (s.ro_ranges[mid].start <= addr)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo > 0 && addr < s.ro_ranges[lo - 1].end;
+    }
+
+    /**
+     * Encode format string pointer and arguments to record, no formatting.
+     * If format not supported, format it here and store as "%s" string.
+     * @return record size
+     */
+    static uint32_t _encode(uint8_t *buff, uint8_t level, uint8_t flags, uint32_t suppressed, uint64_t time_ns, const char *fmt, va_list args)
+    {
+        log_record_t *rec = (log_record_t *)buff;
+        uint8_t *p = buff + sizeof(log_record_t);
+        uint8_t *end = buff + LOG_RECORD_MAX;
+        rec->level = level;
+        rec->suppressed = suppressed;
+        rec->reserved = 0;
+        rec->time_ns = time_ns;
+        rec->fmt = fmt;
+        rec->fmt_len = 0;
+        bool ok = true;
+        if (!_is_literal(fmt))
+        {
+            size_t len = strnlen(fmt, LOG_LINE_MAX);
+            if (len >= LOG_LINE_MAX)
+                ok = false;
+            else
+            {
+                memcpy(p, fmt, len + 1);
+                rec->fmt_len = len;
+                flags |= REC_FMT_COPY;
+                p += _align8(len + 1);
+            }
+        }
+        va_list ap;
+        va_copy(ap, args);
+        const char *f = fmt;
+        while (ok && (f = strchr(f, '%')) != NULL)
+        {
+            fmt_spec_t spec;
+            f = _parse_spec(f, &spec);
+            int kind = f ? _arg_kind(spec) : ARG_BAD;
+            // stars, value, string header and string pointer at most 5 slots
+            if (kind == ARG_BAD || end - p < 5 * 8)
+            {
+                ok = false;
+                break;
+            }
+            int prec = spec.prec;
+            for (int i = 0; i < spec.stars; ++i)
+            {
+                int v = va_arg(ap, int);
+                *(int64_t *)p = v;
+                p += 8;
+                if (i == spec.stars - 1 && prec == -2)
+                    prec = v;
+            }
+            switch (kind)
+            {
+            case ARG_INT:
+            {
+                int64_t v;
+                switch (spec.length)
+                {
+                case 'l':
+                    v = va_arg(ap, long);
+                    break;
+                case 'q':
+                    v = va_arg(ap, long long);
+                    break;
+                case 'j':
+                    v = va_arg(ap, intmax_t);
+                    break;
+                case 'z':
+                    v = va_arg(ap, ssize_t);
+                    break;
+                case 't':
+                    v = va_arg(ap, ptrdiff_t);
+                    break;
+                default:
+                    v = va_arg(ap, int);
+                    break;
+                }
+                *(int64_t *)p = v;
+                p += 8;
+                break;
+            }
+            case ARG_DOUBLE:
+                *(double *)p = spec.length == 'L' ? (double)va_arg(ap, long double) : va_arg(ap, double);
+                p += 8;
+                break;
+            case ARG_PTR:
+                *(const void **)p = va_arg(ap, const void *);
+                p += 8;
+                break;
+            case ARG_STR:
+            {
+                const char *str = va_arg(ap, const char *);
+                if (!str)
+                    str = "(null)";
+                if (_is_literal(str))
+                {
+                    *(uint64_t *)p = STR_PTR_FLAG;
+                    *(const char **)(p + 8) = str;
+                    p += 16;
+                    break;
+                }
+                // precision limit length, string may not end with '\0', e.g. "%.*s"
+                size_t max = end - p - 8 - 1;
+                if (prec >= 0 && (size_t)prec < max)
+                    max = prec;
+                size_t len = strnlen(str, max);
+                *(uint64_t *)p = len;
+                memcpy(p + 8, str, len);
+                p[8 + len] = '\0';
+                p += 8 + _align8(len + 1);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+        va_end(ap);
+        if (!ok)
+        {
+            flags &= ~REC_FMT_COPY;
+            rec->fmt = "%s";
+            rec->fmt_len = 0;
+            p = buff + sizeof(log_record_t);
+            int len = vsnprintf((char *)p + 8, end - p - 8, fmt, args);
+            len = std::max(0, std::min(len, (int)(end - p - 8 - 1)));
+            *(uint64_t *)p = len;
+            p += 8 + _align8(len + 1);
+        }
+        rec->flags = flags;
+        rec->size = p - buff;
+        return rec->size;
+    }
+
+    template <typename T>
+    static int _format_arg(char *out, int size, const char *spec, int stars, const int *star_args, T v)
+    {
+        if (stars == 0)
+            return snprintf(out, size, spec, v);
+        if (stars == 1)
+            return snprintf(out, size, spec, star_args[0], v);
+        return snprintf(out, size, spec, star_args[0], star_args[1], v);
+    }
+
+    /**
+     * Format record to string in background thread.
+     * @return length of formatted string
+     */
+    static int _format_record(const log_record_t *rec, char *out, int size)
+    {
+        const uint8_t *p = (const uint8_t *)(rec + 1);
+        const char *fmt = rec->fmt;
+        if (rec->flags & REC_FMT_COPY)
+        {
+            fmt = (const char *)p;
+            p += _align8(rec->fmt_len + 1);
+        }
+        int n = 0;
+        const char *f = fmt;
+        while (*f && n < size - 1)
+        {
+            const char *pct = strchr(f, '%');
+            int literal = pct ? pct - f : strlen(f);
+            literal = std::min(literal, size - 1 - n);
+            memcpy(out + n, f, literal);
+            n += literal;
+            if (!pct)
+                break;
+            fmt_spec_t spec;
+            f = _parse_spec(pct, &spec);  // already checked by _encode
+            int kind = _arg_kind(spec);
+            int star_args[2];
+            for (int i = 0; i < spec.stars; ++i)
+            {
+                star_args[i] = (int)*(const int64_t *)p;
+                p += 8;
+            }
+            char spec_str[LOG_SPEC_MAX];
+            int spec_len = 0;
+            for (int i = 0; i < spec.len; ++i)
+            {
+                // long double stored as double
+                if (kind == ARG_DOUBLE && spec.start[i] == 'L')
+                    continue;
+                spec_str[spec_len++] = spec.start[i];
+            }
+            spec_str[spec_len] = '\0';
+            int ret = 0;
+            switch (kind)
+            {
+            case ARG_NONE:
+                ret = snprintf(out + n, size - n, "%%");
+                break;
+            case ARG_INT:
+            {
+                int64_t v = *(const int64_t *)p;
+                p += 8;
+                switch (spec.length)
+                {
+                case 'l':
+                    ret = _format_arg(out + n, size - n, spec_str, spec.stars, star_args, (long)v);
+                    break;
+                case 'q':
+                    ret = _format_arg(out + n, size - n, spec_str, spec.stars, star_args, (long long)v);
+                    break;
+                case 'j':
+                    ret = _format_arg(out + n, size - n, spec_str, spec.stars, star_args, (intmax_t)v);
+                    break;
+                case 'z':
+                    ret = _format_arg(out + n, size - n, spec_str, spec.stars, star_args, (ssize_t)v);
+                    break;
+                case 't':
+                    ret = _format_arg(out + n, size - n, spec_str, spec.stars, star_args, (ptrdiff_t)v);
+                    break;
+                default:
+                    ret = _format_arg(out + n, size - n, spec_str, spec.stars, star_args, (int)v);
+                    break;
+                }
+                break;
+            }
+            case ARG_DOUBLE:
+                ret = _format_arg(out + n, size - n, spec_str, spec.stars, star_args, *(const double *)p);
+                p += 8;
+                break;
+            case ARG_PTR:
+                ret = _format_arg(out + n, size - n, spec_str, spec.stars, star_args, *(const void *const *)p);
+                p += 8;
+                break;
+            case ARG_STR:
+            {
+                uint64_t header = *(const uint64_t *)p;
+                const char *str;
+                if (header & STR_PTR_FLAG)
+                {
+                    str = *(const char *const *)(p + 8);
+                    p += 16;
+                }
+                else
+                {
+                    str = (const char *)(p + 8);
+                    p += 8 + _align8(header + 1);
+                }
+                ret = _format_arg(out + n, size - n, spec_str, spec.stars, star_args, str);
+                break;
+            }
+            default:
+                break;
+            }
+            if (ret > 0)
+                n += std::min(ret, size - 1 - n);
+        }
+        out[n] = '\0';
+        return n;
+    }
+
+    static void _file_rotate(log_state_t &s)
+    {
+        close(s.file_fd);
+        s.file_fd = -1;
+        if (s.file_max_files > 0)
+        {
+            for (int i = s.file_max_files - 1; i >= 1; --i)
+                rename((s.file_path + "." + std::to_string(i)).c_str(), (s.file_path + "." + std::to_string(i + 1)).c_str());
+            rename(s.file_path.c_str(), (s.file_path + ".1").c_str());
+        }
+        s.file_fd = open(s.file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        s.file_size = 0;
+    }
+
+    static void _file_flush(log_state_t &s)
+    {
+        size_t off = 0;
+        while (off < s.file_buff.size() && s.file_fd >= 0)
+        {
+            ssize_t ret = write(s.file_fd, s.file_buff.data() + off, s.file_buff.size() - off);
+            if (ret <= 0)
+                break;
+            off += ret;
+        }
+        s.file_buff.clear();
+    }
+
+    static void _out_flush(log_state_t &s)
+    {
+        if (!s.out_buff.empty())
+        {
+            fwrite(s.out_buff.data(), 1, s.out_buff.size(), stdout);
+            fflush(stdout);
+            s.out_buff.clear();
+        }
+        _file_flush(s);
+    }
+
+    /**
+     * Append one formatted log to outputs, must hold out_lock, call _out_flush to write stdout and file.
+     */
+    static void _out_append(log_state_t &s, int level, uint8_t flags, uint64_t time_ns, int tid, const char *msg, int len)
+    {
+        const char *prefix = (flags & REC_PREFIX) ? level_prefix[level] : "";
+        if (s.out_stdout)
+        {
+            s.out_buff.append(prefix);
+            s.out_buff.append(msg, len);
+            if (flags & REC_NEWLINE)
+                s.out_buff.push_back('\n');
+        }
+        if (s.file_fd >= 0)
+        {
+            char head[64];
+            int head_len = 0;
+            if (s.file_line_start)
+            {
+                time_t sec = time_ns / 1000000000ULL;
+                struct tm tm;
+                localtime_r(&sec, &tm);
+                head_len = snprintf(head, sizeof(head), "%04d-%02d-%02d %02d:%02d:%02d.%06d %5d %c ",
+                                    tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+                                    (int)(time_ns % 1000000000ULL / 1000), tid, level_char[level]);
+            }
+            size_t line_len = head_len + len + ((flags & REC_NEWLINE) ? 1 : 0);
+            if (s.file_max_size > 0 && s.file_size + line_len > s.file_max_size && s.file_line_start)
+            {
+                _file_flush(s);
+                _file_rotate(s);
+            }
+            s.file_buff.append(head, head_len);
+            s.file_buff.append(msg, len);
+            if (flags & REC_NEWLINE)
+                s.file_buff.push_back('\n');
+            s.file_size += line_len;
+            s.file_line_start = (flags & REC_NEWLINE) || (len > 0 && msg[len - 1] == '\n');
+        }
+        if (s.syslog_fd >= 0 && level != LEVEL_NONE)
+        {
+            char buff[LOG_LINE_MAX + 128];
+            int n = snprintf(buff, sizeof(buff), "<%d>%s[%d]: %.*s", 8 + level_syslog[level], s.syslog_ident.c_str(), (int)getpid(), len, msg);
+            n = std::min(n, (int)sizeof(buff) - 1);
+            sendto(s.syslog_fd, buff, n, MSG_DONTWAIT | MSG_NOSIGNAL, (struct sockaddr *)&s.syslog_addr, sizeof(s.syslog_addr));
+        }
+    }
+
+    static void _out_suppressed(log_state_t &s, uint64_t time_ns, int tid, uint32_t suppressed)
+    {
+        char msg[64];
+        int len = snprintf(msg, sizeof(msg), "%u logs dropped by rate limit", suppressed);
+        _out_append(s, LEVEL_WARN, REC_PREFIX | REC_NEWLINE, time_ns, tid, msg, len);
+    }
+
+    /**
+     * Write all records in rings to outputs in time order, called by background thread and flush.
+     * @return number of records written
+     */
+    static int _drain()
+    {
+        log_state_t &s = _state();
+        std::lock_guard<std::mutex> drain_lock(s.drain_lock);
+        std::vector<LogRing *> &rings = s.drain_rings;
+        {
+            std::lock_guard<std::mutex> lock(s.rings_lock);
+            rings = s.rings;
+        }
+        char msg[LOG_LINE_MAX];
+        int total = 0;
+        std::lock_guard<std::mutex> out_lock(s.out_lock);
+        for (int count = 0; count < LOG_BATCH_MAX; ++count)
+        {
+            LogRing *ring = NULL;
+            const log_record_t *rec = NULL;
+            for (LogRing *r : rings)
+            {
+                const log_record_t *front = r->front();
+                if (front && (!rec || front->time_ns < rec->time_ns))
+                {
+                    rec = front;
+                    ring = r;
+                }
+            }
+            if (!rec)
+                break;
+            if (rec->suppressed)
+                _out_suppressed(s, rec->time_ns, ring->tid, rec->suppressed);
+            int len = _format_record(rec, msg, sizeof(msg));
+            _out_append(s, rec->level, rec->flags, rec->time_ns, ring->tid, msg, len);
+            ring->pop(rec);
+            ++total;
+        }
+        bool has_closed = false;
+        for (LogRing *r : rings)
+        {
+            uint64_t dropped = r->dropped.load(std::memory_order_relaxed);
+            if (dropped != r->dropped_reported)
+            {
+                int len = snprintf(msg, sizeof(msg), "%llu logs of thread %d dropped, ring buffer full",
+                                   (unsigned long long)(dropped - r->dropped_reported), r->tid);
+                _out_append(s, LEVEL_WARN, REC_PREFIX | REC_NEWLINE, _now_ns(), r->tid, msg, len);
+                r->dropped_reported = dropped;
+            }
+            has_closed |= r->closed.load(std::memory_order_acquire);
+        }
+        _out_flush(s);
+        if (has_closed)
+        {
+            // owner thread exited, delete ring when it's empty
+            std::lock_guard<std::mutex> lock(s.rings_lock);
+            for (auto it = s.rings.begin(); it != s.rings.end();)
+            {
+                LogRing *r = *it;
+                if (r->closed.load(std::memory_order_acquire) && !r->front())
+                {
+                    g_dropped_exited.fetch_add(r->dropped.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    delete r;
+                    it = s.rings.erase(it);
+                }
+                else
+                    ++it;
+            }
+        }
+        return total;
+    }
+
+    static void _wakeup()
+    {
+        if (!g_wakeup.exchange(true, std::memory_order_acq_rel))
+            _state().wait_cond.notify_one();
+    }
+
+    static void _consumer_loop()
+    {
+        log_state_t &s = _state();
+        pthread_setname_np(pthread_self(), "maix_log");
+        while (true)
+        {
+            bool running = g_running.load(std::memory_order_acquire);
+            int n = _drain();
+            if (!running)
+                break;
+            if (n < LOG_BATCH_MAX)
+            {
+                std::unique_lock<std::mutex> lock(s.wait_lock);
+                s.wait_cond.wait_for(lock, std::chrono::milliseconds(s.flush_interval_ms), [] {
+                    return g_wakeup.load(std::memory_order_acquire) || !g_running.load(std::memory_order_acquire);
+                });
+                g_wakeup.store(false, std::memory_order_release);
+            }
+        }
+    }
+
+    static void _ring_release(void *arg)
+    {
+        ((LogRing *)arg)->closed.store(true, std::memory_order_release);
+        tl_ring = nullptr;
+    }
+
+    static void _ring_key_create()
+    {
+        pthread_key_create(&g_ring_key, _ring_release);
+    }
+
+    static LogRing *_thread_ring()
+    {
+        if (tl_ring)
+            return tl_ring;
+        log_state_t &s = _state();
+        pthread_once(&g_ring_key_once, _ring_key_create);
+        LogRing *ring = new LogRing(s.ring_size, _gettid());
+        {
+            std::lock_guard<std::mutex> lock(s.rings_lock);
+            s.rings.push_back(ring);
+        }
+        pthread_setspecific(g_ring_key, ring);
+        tl_ring = ring;
+        return ring;
+    }
+
+    /**
+     * Check rate limit of call site.
+     * @param suppressed return number of logs dropped before this log.
+     * @return true if log allowed
+     */
+    static bool _rate_check(const char *key, uint64_t time_ns, uint32_t *suppressed)
+    {
+        int limit = g_rate_limit.load(std::memory_order_relaxed);
+        if (limit <= 0)
+            return true;
+        rate_slot_t &slot = tl_rate[((uintptr_t)key >> 3) % LOG_RATE_SLOTS];
+        uint64_t window = time_ns / 1000000000ULL;
+        if (slot.fmt != key)
+        {
+            slot.fmt = key;
+            slot.count = 0;
+            slot.suppressed = 0;
+            slot.window = window;
+        }
+        else if (slot.window != window)
+        {
+            slot.window = window;
+            slot.count = 0;
+        }
+        if (slot.count >= (uint32_t)limit)
+        {
+            ++slot.suppressed;
+            g_suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        ++slot.count;
+        *suppressed = slot.suppressed;
+        slot.suppressed = 0;
+        return true;
+    }
+
+    /**
+     * Log entry of all log functions
+     * @param key call site for rate limit, usually the format string
+     */
+    static void _log(int level, uint8_t flags, const char *key, const char *fmt, va_list args)
+    {
+        if (level > g_level.load(std::memory_order_relaxed))
+            return;
+        uint64_t time_ns = _now_ns();
+        uint32_t suppressed = 0;
+        if (level != LEVEL_NONE && !_rate_check(key, time_ns, &suppressed))
+            return;
+        if (g_async.load(std::memory_order_acquire))
+        {
+            LogRing *ring = _thread_ring();
+            alignas(8) uint8_t rec[LOG_RECORD_MAX];
+            uint32_t size = _encode(rec, level, flags, suppressed, time_ns, fmt, args);
+            if (!ring->push(rec, size))
+            {
+                ring->dropped.store(ring->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                _wakeup();
+                return;
+            }
+            if (level == LEVEL_ERROR || ring->half_full())
+                _wakeup();
+            return;
+        }
+        char msg[LOG_LINE_MAX];
+        int len = vsnprintf(msg, sizeof(msg), fmt, args);
+        len = std::max(0, std::min(len, (int)sizeof(msg) - 1));
+        log_state_t &s = _state();
+        std::lock_guard<std::mutex> lock(s.out_lock);
+        if (suppressed)
+            _out_suppressed(s, time_ns, _gettid(), suppressed);
+        _out_append(s, level, flags, time_ns, _gettid(), msg, len);
+        _out_flush(s);
+    }
+
+    static void _log_error(uint8_t flags, const char *fmt, va_list args)
     {
-        static const char *err_start = "-- [E] ";
         // print error and call err::set_error
+        char msg[LOG_LINE_MAX];
+        va_list ap;
+        va_copy(ap, args);
+        vsnprintf(msg, sizeof(msg), fmt, ap);
+        va_end(ap);
+        err::set_error(level_prefix[LEVEL_ERROR] + std::string(msg));
+        _log(LEVEL_ERROR, flags, fmt, fmt, args);
+    }
+
+#if MAIX_LOG_LEVEL_MAX >= 1
+    void error(const char *fmt, ...)
+    {
         va_list args;
         va_start(args, fmt);
-        printf("%s", err_start);
-        vsnprintf(log_buf, sizeof(log_buf), fmt, args);
-        printf("%s\n", log_buf);
+        _log_error(REC_PREFIX | REC_NEWLINE, fmt, args);
         va_end(args);
-        err::set_error(err_start + std::string(log_buf));
     }
 
     void error0(const char *fmt, ...)
     {
-        static const char *err_start = "-- [E] ";
-        // print error and call err::set_error
         va_list args;
         va_start(args, fmt);
-        printf("%s", err_start);
-        vsnprintf(log_buf, sizeof(log_buf), fmt, args);
-        printf("%s", log_buf);
+        _log_error(REC_PREFIX, fmt, args);
         va_end(args);
-        err::set_error(err_start + std::string(log_buf));
     }
+#endif
 
+#if MAIX_LOG_LEVEL_MAX >= 2
     void warn(const char *fmt, ...)
     {
         va_list args;
         va_start(args, fmt);
-        printf("-- [W] ");
-        vprintf(fmt, args);
+        _log(LEVEL_WARN, REC_PREFIX | REC_NEWLINE, fmt, fmt, args);
         va_end(args);
-        printf("\n");
     }
 
     void warn0(const char *fmt, ...)
     {
         va_list args;
         va_start(args, fmt);
-        printf("-- [W] ");
-        vprintf(fmt, args);
+        _log(LEVEL_WARN, REC_PREFIX, fmt, fmt, args);
         va_end(args);
     }
+#endif
 
+#if MAIX_LOG_LEVEL_MAX >= 3
     void info(const char *fmt, ...)
     {
         va_list args;
         va_start(args, fmt);
-        printf("-- [I] ");
-        vprintf(fmt, args);
+        _log(LEVEL_INFO, REC_PREFIX | REC_NEWLINE, fmt, fmt, args);
         va_end(args);
-        printf("\n");
     }
 
     void info0(const char *fmt, ...)
     {
         va_list args;
         va_start(args, fmt);
-        printf("-- [I] ");
-        vprintf(fmt, args);
+        _log(LEVEL_INFO, REC_PREFIX, fmt, fmt, args);
         va_end(args);
     }
+#endif
 
+#if MAIX_LOG_LEVEL_MAX >= 4
     void debug(const char *fmt, ...)
     {
 #if DEBUG
         va_list args;
         va_start(args, fmt);
-        printf("-- [D] ");
-        vprintf(fmt, args);
+        _log(LEVEL_DEBUG, REC_PREFIX | REC_NEWLINE, fmt, fmt, args);
         va_end(args);
-        printf("\n");
 #else
         (void)fmt;
 #endif
@@ -98,20 +1045,178 @@ namespace maix::log
 #if DEBUG
         va_list args;
         va_start(args, fmt);
-        printf("-- [D] ");
-        vprintf(fmt, args);
+        _log(LEVEL_DEBUG, REC_PREFIX, fmt, fmt, args);
         va_end(args);
 #else
         (void)fmt;
 #endif
     }
+#endif
 
     void print(const char *fmt, ...)
     {
         va_list args;
         va_start(args, fmt);
-        vprintf(fmt, args);
+        _log(LEVEL_NONE, 0, fmt, fmt, args);
         va_end(args);
     }
 
+    void set_level(log::LogLevel level)
+    {
+        g_level.store(level, std::memory_order_relaxed);
+    }
+
+    log::LogLevel get_level()
+    {
+        return (log::LogLevel)g_level.load(std::memory_order_relaxed);
+    }
+
+    static void _async_exit()
+    {
+        set_async(false);
+    }
+
+    err::Err set_async(bool enable, int ring_size, int flush_interval_ms)
+    {
+        log_state_t &s = _state();
+        std::lock_guard<std::mutex> lock(s.config_lock);
+        if (!enable)
+        {
+            if (!s.thread)
+                return err::ERR_NONE;
+            g_async.store(false, std::memory_order_release);
+            g_running.store(false, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> wait_lock(s.wait_lock);
+                s.wait_cond.notify_one();
+            }
+            s.thread->join();
+            delete s.thread;
+            s.thread = nullptr;
+            // logs pushed by other threads during stop
+            while (_drain() > 0)
+                ;
+            return err::ERR_NONE;
+        }
+        if (ring_size < LOG_RECORD_MAX * 4 || flush_interval_ms <= 0)
+            return err::ERR_ARGS;
+        uint32_t size = LOG_RECORD_MAX * 4;
+        while (size < (uint32_t)ring_size && size < (1U << 30))
+            size <<= 1;
+        s.ring_size = size;
+        s.flush_interval_ms = flush_interval_ms;
+        if (s.thread)
+            return err::ERR_NONE;
+        _update_ro_ranges();
+        g_running.store(true, std::memory_order_release);
+        try
+        {
+            s.thread = new std::thread(_consumer_loop);
+        }
+        catch (const std::exception &e)
+        {
+            g_running.store(false, std::memory_order_release);
+            fprintf(stderr, "-- [E] create log thread failed: %s\n", e.what());
+            return err::ERR_RUNTIME;
+        }
+        if (!s.atexit_registered)
+        {
+            atexit(_async_exit);
+            s.atexit_registered = true;
+        }
+        g_async.store(true, std::memory_order_release);
+        return err::ERR_NONE;
+    }
+
+    bool is_async()
+    {
+        return g_async.load(std::memory_order_relaxed);
+    }
+
+    void flush()
+    {
+        if (!g_async.load(std::memory_order_acquire))
+            return;
+        while (_drain() > 0)
+            ;
+    }
+
+    void set_stdout(bool enable)
+    {
+        log_state_t &s = _state();
+        std::lock_guard<std::mutex> lock(s.out_lock);
+        _out_flush(s);
+        s.out_stdout = enable;
+    }
+
+    err::Err set_file(const std::string &path, int max_size, int max_files)
+    {
+        log_state_t &s = _state();
+        std::lock_guard<std::mutex> lock(s.out_lock);
+        _out_flush(s);
+        if (s.file_fd >= 0)
+        {
+            close(s.file_fd);
+            s.file_fd = -1;
+        }
+        if (path.empty())
+            return err::ERR_NONE;
+        if (max_size < 0 || max_files < 0)
+            return err::ERR_ARGS;
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0)
+            return err::ERR_IO;
+        s.file_fd = fd;
+        s.file_path = path;
+        s.file_size = lseek(fd, 0, SEEK_END);
+        s.file_max_size = max_size;
+        s.file_max_files = max_files;
+        s.file_line_start = true;
+        return err::ERR_NONE;
+    }
+
+    err::Err set_syslog(const std::string &ident, const std::string &path)
+    {
+        log_state_t &s = _state();
+        std::lock_guard<std::mutex> lock(s.out_lock);
+        if (s.syslog_fd >= 0)
+        {
+            close(s.syslog_fd);
+            s.syslog_fd = -1;
+        }
+        if (ident.empty())
+            return err::ERR_NONE;
+        if (path.size() >= sizeof(s.syslog_addr.sun_path))
+            return err::ERR_ARGS;
+        int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            return err::ERR_IO;
+        memset(&s.syslog_addr, 0, sizeof(s.syslog_addr));
+        s.syslog_addr.sun_family = AF_UNIX;
+        strncpy(s.syslog_addr.sun_path, path.c_str(), sizeof(s.syslog_addr.sun_path) - 1);
+        s.syslog_fd = fd;
+        s.syslog_ident = ident;
+        return err::ERR_NONE;
+    }
+
+    void set_rate_limit(int max_per_second)
+    {
+        g_rate_limit.store(max_per_second, std::memory_order_relaxed);
+    }
+
+    uint64_t dropped_count()
+    {
+        log_state_t &s = _state();
+        uint64_t total = g_dropped_exited.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(s.rings_lock);
+        for (LogRing *r : s.rings)
+            total += r->dropped.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    uint64_t suppressed_count()
+    {
+        return g_suppressed.load(std::memory_order_relaxed);
+    }
+
 } // namespace maix::log
@@ -3,85 +3,251 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Ring buffer decoder, resume header search and CRC, decode_all.
  */
 
 
 #include "maix_protocol.hpp"
 #include <string.h>
 #include <assert.h>
+#include <algorithm>
 
 namespace maix::protocol
 {
     uint32_t HEADER = 0xBBACCAAA;
-    uint16_t crc16_IBM(uint8_t *ptr, size_t len)
-    {
-        unsigned int i;
-        uint16_t crc = 0x0000;
 
-        while (len--)
+    /**
+     * slice by 8 tables of CRC16-IBM(reflected 0x8005 = 0xA001),
+     * table[k][b] is CRC of byte b followed by k zero bytes.
+     */
+    struct CRC16Table
+    {
+        uint16_t table[8][256];
+        constexpr CRC16Table() : table()
         {
-            crc ^= *ptr++;
-            for (i = 0; i < 8; ++i)
+            for (int b = 0; b < 256; ++b)
             {
-                if (crc & 1)
-                    crc = (crc >> 1) ^ 0xA001;
-                else
-                    crc = (crc >> 1);
+                uint16_t crc = b;
+                for (int i = 0; i < 8; ++i)
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+                table[0][b] = crc;
+            }
+            for (int k = 1; k < 8; ++k)
+            {
+                for (int b = 0; b < 256; ++b)
+                    table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xFF];
             }
         }
+    };
+    static constexpr CRC16Table _crc16_table;
 
+    uint16_t crc16_IBM_update(uint16_t crc, const uint8_t *ptr, size_t len)
+    {
+        const uint16_t (*t)[256] = _crc16_table.table;
+        while (len >= 8)
+        {
+            crc ^= ptr[0] | (ptr[1] << 8);
+            crc = t[7][crc & 0xFF] ^ t[6][crc >> 8] ^ t[5][ptr[2]] ^ t[4][ptr[3]] ^
+                  t[3][ptr[4]] ^ t[2][ptr[5]] ^ t[1][ptr[6]] ^ t[0][ptr[7]];
+            ptr += 8;
+            len -= 8;
+        }
+        while (len--)
+            crc = (crc >> 8) ^ t[0][(crc ^ *ptr++) & 0xFF];
         return crc;
     }
 
+    uint16_t crc16_IBM(uint8_t *ptr, size_t len)
+    {
+        return crc16_IBM_update(0x0000, ptr, len);
+    }
+
     uint16_t crc16_IBM(const Bytes *bytes)
     {
         return crc16_IBM(bytes->data, bytes->size());
     }
 
+    /**
+     * write header, data len, flags, cmd and code(if code != 0xFF), return written length
+     */
+    static int _encode_head(uint8_t *out, uint8_t cmd, uint8_t flags, int body_len, uint8_t code, const uint8_t version)
+    {
+        int head_len = code != 0xFF ? 11 : 10;
+        uint32_t data_len = body_len + head_len - 8 + 2;
+        out[0] = HEADER & 0xFF;
+        out[1] = HEADER >> 8 & 0xFF;
+        out[2] = HEADER >> 16 & 0xFF;
+        out[3] = HEADER >> 24 & 0xFF;
+        out[4] = data_len & 0xFF;
+        out[5] = data_len >> 8 & 0xFF;
+        out[6] = data_len >> 16 & 0xFF;
+        out[7] = data_len >> 24 & 0xFF;
+        out[8] = flags | version;
+        out[9] = cmd;
+        if (code != 0xFF)
+            out[10] = code;
+        return head_len;
+    }
+
     int encode(uint8_t *out_buff, int out_buff_len,
                uint8_t cmd, uint8_t flags, uint8_t *body, int body_len,
                uint8_t code,
                const uint8_t version)
     {
-        assert((uint64_t)out_buff % 4 == 0);
-
         if (version != VERSION)
             return -err::ERR_ARGS;
-        if (out_buff_len < body_len + 12)
+        int frame_len = body_len + (code != 0xFF ? 13 : 12);
+        if (out_buff_len < frame_len)
             return -err::ERR_ARGS;
-        ((uint32_t *)out_buff)[0] = HEADER;
-        ((uint32_t *)out_buff)[1] = body_len + 4;
-        out_buff[8] = flags | version;
-        out_buff[9] = cmd;
-        if (code != 0xFF)
+        int head_len = _encode_head(out_buff, cmd, flags, body_len, code, version);
+        if (body_len > 0)
+            memcpy(out_buff + head_len, body, body_len);
+        uint16_t crc16 = crc16_IBM(out_buff, head_len + body_len);
+        out_buff[head_len + body_len] = crc16 & 0xFF;
+        out_buff[head_len + body_len + 1] = crc16 >> 8 & 0xFF;
+        return frame_len;
+    }
+
+    int encode_head_tail(uint8_t *head, uint8_t *tail, uint8_t cmd, uint8_t flags, const uint8_t *body, int body_len,
+                         uint8_t code, const uint8_t version)
+    {
+        if (version != VERSION || body_len < 0 || (body_len > 0 && !body))
+            return -err::ERR_ARGS;
+        int head_len = _encode_head(head, cmd, flags, body_len, code, version);
+        uint16_t crc16 = crc16_IBM_update(0x0000, head, head_len);
+        crc16 = crc16_IBM_update(crc16, body, body_len);
+        tail[0] = crc16 & 0xFF;
+        tail[1] = crc16 >> 8 & 0xFF;
+        return head_len;
+    }
+
+    FrameRing::FrameRing(int size, uint8_t *buff)
+    {
+        if (size <= 0)
+            throw err::Exception(err::ERR_ARGS, "FrameRing size should > 0");
+        _is_alloc = buff == nullptr;
+        _buff = buff ? buff : new uint8_t[size];
+        _size = size;
+        clear();
+    }
+
+    FrameRing::~FrameRing()
+    {
+        if (_is_alloc)
+            delete[] _buff;
+    }
+
+    void FrameRing::clear()
+    {
+        _head = 0;
+        _tail = 0;
+        _wrap = -1;
+        _used = 0;
+        _reserved = 0;
+    }
+
+    uint8_t *FrameRing::reserve(int len)
+    {
+        if (len <= 0)
+            return nullptr;
+        if (_wrap < 0)
+        {
+            if (_size - _tail >= len)
+            {
+                _reserved = len;
+                return _buff + _tail;
+            }
+            // not enough space at end, wrap to start
+            if (_head >= len)
+            {
+                _wrap = _tail;
+                _tail = 0;
+                _reserved = len;
+                return _buff;
+            }
+            return nullptr;
+        }
+        if (_head - _tail >= len)
         {
-            out_buff[10] = code;
-            memcpy(out_buff + 11, body, body_len);
-            uint16_t crc16 = crc16_IBM(out_buff, body_len + 11);
-            out_buff[11 + body_len] = crc16 & 0xFF;
-            out_buff[12 + body_len] = crc16 >> 8 & 0xFF;
-            return body_len + 13;
+            _reserved = len;
+            return _buff + _tail;
         }
-        memcpy(out_buff + 10, body, body_len);
-        uint16_t crc16 = crc16_IBM(out_buff, body_len + 10);
-        out_buff[10 + body_len] = crc16 & 0xFF;
-        out_buff[11 + body_len] = crc16 >> 8 & 0xFF;
-        return body_len + 12;
+        return nullptr;
     }
 
-    Bytes *encode_resp_ok(uint8_t cmd, uint8_t *body, int body_len)
+    void FrameRing::commit(int len)
+    {
+        if (len > _reserved)
+            len = _reserved;
+        _tail += len;
+        _used += len;
+        _reserved = 0;
+        if (_wrap >= 0 && _head == _wrap)
+        {
+            // all data before wrap point has been consumed
+            _head = 0;
+            _wrap = -1;
+        }
+    }
+
+    int FrameRing::peek(uint8_t **data)
+    {
+        *data = _buff + _head;
+        if (_wrap >= 0)
+            return _wrap - _head;
+        return _tail - _head;
+    }
+
+    void FrameRing::consume(int len)
+    {
+        int n = _wrap >= 0 ? _wrap - _head : _tail - _head;
+        if (len > n)
+            len = n;
+        _head += len;
+        _used -= len;
+        if (_wrap >= 0 && _head == _wrap)
+        {
+            _head = 0;
+            _wrap = -1;
+        }
+        if (_wrap < 0 && _head == _tail)
+        {
+            _head = 0;
+            _tail = 0;
+        }
+    }
+
+    int FrameRing::encode(uint8_t cmd, uint8_t flags, const uint8_t *body, int body_len, uint8_t code)
     {
-        uint8_t *buff = new uint8_t[12 + body_len];
-        int len = encode(buff, 12 + body_len, cmd, FLAG_RESP | FLAG_RESP_OK, body, body_len);
+        int frame_len = body_len + (code != 0xFF ? 13 : 12);
+        if (frame_len > _size)
+            return -err::ERR_ARGS;
+        uint8_t *buff = reserve(frame_len);
+        if (!buff)
+            return -err::ERR_BUFF_FULL;
+        int len = protocol::encode(buff, frame_len, cmd, flags, (uint8_t *)body, body_len, code);
+        commit(len < 0 ? 0 : len);
+        return len;
+    }
+
+    static Bytes *_encode_bytes(uint8_t cmd, uint8_t flags, uint8_t *body, int body_len, uint8_t code = 0xFF)
+    {
+        int frame_len = body_len + (code != 0xFF ? 13 : 12);
+        Bytes *ret = new Bytes(nullptr, frame_len);
+        int len = encode(ret->data, frame_len, cmd, flags, body, body_len, code);
         if (len < 0)
         {
-            delete[] buff;
+            delete ret;
             return nullptr;
         }
-        Bytes *ret = new Bytes(buff, len, true, false);
         return ret;
     }
 
+    Bytes *encode_resp_ok(uint8_t cmd, uint8_t *body, int body_len)
+    {
+        return _encode_bytes(cmd, FLAG_RESP | FLAG_RESP_OK, body, body_len);
+    }
+
     Bytes *encode_resp_ok(uint8_t cmd, Bytes *body)
     {
         int body_len = body->size();
@@ -90,15 +256,7 @@ namespace maix::protocol
 
     Bytes *encode_resp_err(uint8_t cmd, err::Err code, const std::string &msg)
     {
-        uint8_t *buff = new uint8_t[13 + msg.length()];
-        int len = encode(buff, 13 + msg.length(), cmd, FLAG_RESP | FLAG_RESP_ERR, (uint8_t *)msg.c_str(), msg.length(), code);
-        if (len < 0)
-        {
-            delete[] buff;
-            return nullptr;
-        }
-        Bytes *ret = new Bytes(buff, len, true, false);
-        return ret;
+        return _encode_bytes(cmd, FLAG_RESP | FLAG_RESP_ERR, (uint8_t *)msg.c_str(), msg.length(), code);
     }
 
     int encode_resp_ok(uint8_t *buff, int buff_len, uint8_t cmd, uint8_t *body, int body_len)
@@ -111,69 +269,25 @@ namespace maix::protocol
         return encode(buff, buff_len, cmd, FLAG_RESP | FLAG_RESP_ERR, (uint8_t *)msg.c_str(), msg.length(), code);
     }
 
-    bool get_msg(uint8_t *data, int len, MSG *frame, int *idx, const uint32_t header=HEADER)
+    /**
+     * parse a whole valid frame, body is copied or points to frame data
+     */
+    static void _parse_frame(MSG *msg, uint8_t *frame, int frame_len, bool view)
     {
-        size_t data_len = 0;
-
-        *idx = 0;
-        if (len < 12)
-            return false;
-        // find header
-        uint32_t i = 0;
-        bool found = false;
-        for (; i < (uint32_t)len - 4; i++)
+        msg->version = frame[8] & FLAG_VERSION_MASK;
+        msg->is_resp = frame[8] & FLAG_IS_RESP_MASK;
+        msg->is_req = !msg->is_resp;
+        msg->resp_ok = frame[8] & FLAG_RESP_OK_MASK;
+        msg->cmd = frame[9];
+        msg->has_been_replied = false;
+        int body_len = frame_len - 12;
+        if (view)
         {
-            if (data[i] == (header & 0xFF) &&
-                data[i + 1] == ((header >> 8) & 0xFF) &&
-                data[i + 2] == ((header >> 16) & 0xFF) &&
-                data[i + 3] == ((header >> 24) & 0xFF))
-            {
-                found = true;
-                break;
-            }
+            msg->body = frame + 10;
+            msg->body_len = body_len;
         }
-        // len >= 12
-        if (!found)
-        {
-            *idx = i;
-            return false;
-        }
-        if (len - i < 12)
-            return false;
-
-        // get data_len, and check data length
-        data_len = data[i + 4] | (data[i + 5] << 8) | (data[i + 6] << 16) | (data[i + 7] << 24);
-        if (data_len > len - i - 8)
-            return false;
-        *idx = i + 8 + data_len;
-        // check crc
-        uint16_t crc16 = crc16_IBM(data + i, data_len + 6);
-        if (data[i + 6 + data_len] != (crc16 & 0xFF) || data[i + 7 + data_len] != (crc16 >> 8 & 0xFF))
-        {
-            return false;
-        }
-        // parse data
-        frame->version = data[i + 8] & FLAG_VERSION_MASK;
-        frame->is_resp = data[i + 8] & FLAG_IS_RESP_MASK;
-        frame->is_req = !frame->is_resp;
-        frame->resp_ok = data[i + 8] & FLAG_RESP_OK_MASK;
-        frame->cmd = data[i + 9];
-        frame->set_body(data + i + 10, data_len - 4);
-        frame->body_len = data_len - 4;
-        return true;
-    }
-
-    std::tuple<MSG *, int> get_msg(uint8_t *data, int len)
-    {
-        MSG *frame = new MSG();
-        int idx = 0;
-        if (get_msg(data, len, frame, &idx))
-            return std::make_tuple(frame, idx);
         else
-        {
-            delete frame;
-            return std::make_tuple(nullptr, idx);
-        }
+            msg->set_body(frame + 10, body_len);
     }
 
     MSG::MSG()
@@ -190,7 +304,7 @@ namespace maix::protocol
 
     MSG::~MSG()
     {
-        if (body)
+        if (body && !_body_view)
         {
             delete[] body;
         }
@@ -218,28 +332,14 @@ namespace maix::protocol
 
     Bytes *MSG::encode_report(uint8_t *body, int body_len)
     {
-        uint8_t *buff = new uint8_t[12 + body_len];
-        int len = protocol::encode(buff, 12 + body_len, this->cmd, FLAG_RESP | FLAG_RESP_OK | FLAG_REPORT, body, body_len);
-        if (len < 0)
-        {
-            delete[] buff;
-            return nullptr;
-        }
-        Bytes *ret = new Bytes(buff, len, true, false);
-        return ret;
+        return _encode_bytes(this->cmd, FLAG_RESP | FLAG_RESP_OK | FLAG_REPORT, body, body_len);
     }
 
     Bytes *MSG::encode_report(Bytes *body)
     {
-        uint8_t *buff = new uint8_t[12 + body_len];
-        int len = protocol::encode(buff, 12 + body_len, this->cmd, FLAG_RESP | FLAG_RESP_OK | FLAG_REPORT, body->data, (int)body->size());
-        if (len < 0)
-        {
-            delete[] buff;
-            return nullptr;
-        }
-        Bytes *ret = new Bytes(buff, len, true, false);
-        return ret;
+        if (!body)
+            return _encode_bytes(this->cmd, FLAG_RESP | FLAG_RESP_OK | FLAG_REPORT, nullptr, 0);
+        return _encode_bytes(this->cmd, FLAG_RESP | FLAG_RESP_OK | FLAG_REPORT, body->data, (int)body->size());
     }
 
     int MSG::encode_resp_err(uint8_t *buff, int buff_len, err::Err code, const std::string &msg)
@@ -254,6 +354,12 @@ namespace maix::protocol
 
     void MSG::set_body(uint8_t *body_new, int body_len)
     {
+        if (_body_view)
+        {
+            body = nullptr;
+            _body_buff_len = 0;
+            _body_view = false;
+        }
         if ((body && _body_buff_len < body_len))
         {
             delete[] body;
@@ -291,15 +397,7 @@ namespace maix::protocol
 
     Bytes *Protocol::encode_report(uint8_t cmd, uint8_t *body, int body_len)
     {
-        uint8_t *buff = new uint8_t[12 + body_len];
-        int len = protocol::encode(buff, 12 + body_len, cmd, FLAG_RESP | FLAG_RESP_OK | FLAG_REPORT, body, body_len);
-        if (len < 0)
-        {
-            delete[] buff;
-            return nullptr;
-        }
-        Bytes *ret = new Bytes(buff, len, true, false);
-        return ret;
+        return _encode_bytes(cmd, FLAG_RESP | FLAG_RESP_OK | FLAG_REPORT, body, body_len);
     }
 
     Bytes *Protocol::encode_report(uint8_t cmd, Bytes *body)
@@ -321,28 +419,146 @@ namespace maix::protocol
     {
         _buff_size = buff_size;
         _buff = new uint8_t[buff_size];
+        _head = 0;
         _data_len = 0;
         _header = header;
         HEADER = header;
+        _frame_len = 0;
+        _crc = 0;
+        _crc_len = 0;
+        _linear = nullptr;
     }
 
     Protocol::~Protocol()
     {
         delete[] _buff;
+        if (_linear)
+            delete[] _linear;
+        for (auto msg : _msgs)
+            delete msg;
     }
 
     err::Err Protocol::push_data(uint8_t *new_data, int len)
     {
         if (_data_len + len > _buff_size)
             return err::ERR_BUFF_FULL;
-        memcpy(_buff + _data_len, new_data, len);
+        int tail = _head + _data_len;
+        if (tail >= _buff_size)
+            tail -= _buff_size;
+        int first = std::min(len, _buff_size - tail);
+        memcpy(_buff + tail, new_data, first);
+        if (len > first)
+            memcpy(_buff, new_data + first, len - first);
         _data_len += len;
         return err::ERR_NONE;
     }
 
     err::Err Protocol::push_data(const Bytes *new_data)
     {
-        return push_data((uint8_t *)&new_data[0], new_data->size());
+        return push_data(new_data->data, new_data->size());
+    }
+
+    uint8_t Protocol::_at(int offset)
+    {
+        int pos = _head + offset;
+        return _buff[pos < _buff_size ? pos : pos - _buff_size];
+    }
+
+    void Protocol::_skip(int len)
+    {
+        if (len <= 0)
+            return;
+        _head += len;
+        if (_head >= _buff_size)
+            _head -= _buff_size;
+        _data_len -= len;
+        if (_data_len == 0)
+            _head = 0; // keep data continuous as long as possible
+        _frame_len = 0;
+        _crc_len = 0;
+    }
+
+    /**
+     * drop data until header at head, return false if not found
+     */
+    bool Protocol::_find_header()
+    {
+        uint8_t h0 = _header & 0xFF;
+        while (_data_len >= 4)
+        {
+            // header start positions in continuous part from head
+            int n = std::min(_data_len - 3, _buff_size - _head);
+            uint8_t *p = (uint8_t *)memchr(_buff + _head, h0, n);
+            if (!p)
+            {
+                _skip(n);
+                continue;
+            }
+            _skip(p - (_buff + _head));
+            if (_at(1) == ((_header >> 8) & 0xFF) &&
+                _at(2) == ((_header >> 16) & 0xFF) &&
+                _at(3) == ((_header >> 24) & 0xFF))
+                return true;
+            _skip(1);
+        }
+        return false;
+    }
+
+    /**
+     * find next complete and valid frame at head, return frame length, 0 if not found.
+     * Search and CRC calculate resume from where last call stopped.
+     */
+    int Protocol::_find_frame()
+    {
+        while (true)
+        {
+            if (_frame_len == 0)
+            {
+                if (!_find_header() || _data_len < 8)
+                    return 0;
+                uint32_t data_len = _at(4) | (_at(5) << 8) | (_at(6) << 16) | ((uint32_t)_at(7) << 24);
+                // flags + cmd + crc at least, and frame can be put in buffer, or it's not a real header
+                if (data_len < 4 || data_len > (uint32_t)_buff_size - 8)
+                {
+                    _skip(1);
+                    continue;
+                }
+                _frame_len = data_len + 8;
+                _crc = 0;
+                _crc_len = 0;
+            }
+            int crc_end = std::min(_data_len, _frame_len - 2);
+            while (_crc_len < crc_end)
+            {
+                int pos = _head + _crc_len;
+                if (pos >= _buff_size)
+                    pos -= _buff_size;
+                int n = std::min(crc_end - _crc_len, _buff_size - pos);
+                _crc = crc16_IBM_update(_crc, _buff + pos, n);
+                _crc_len += n;
+            }
+            if (_data_len < _frame_len)
+                return 0;
+            if (_at(_frame_len - 2) != (_crc & 0xFF) || _at(_frame_len - 1) != (_crc >> 8 & 0xFF))
+            {
+                // maybe header appears in data by chance, search from next byte
+                _skip(1);
+                continue;
+            }
+            return _frame_len;
+        }
+    }
+
+    uint8_t *Protocol::_frame_data(int frame_len)
+    {
+        if (_head + frame_len <= _buff_size)
+            return _buff + _head;
+        if (!_linear)
+            _linear = new uint8_t[_buff_size];
+        int first = _buff_size - _head;
+        memcpy(_linear, _buff + _head, first);
+        memcpy(_linear + first, _buff, frame_len - first);
+        return _linear;
     }
 
     MSG *Protocol::decode(uint8_t *new_data, size_t len)
@@ -351,26 +567,46 @@ namespace maix::protocol
         {
             push_data(new_data, len);
         }
+        int frame_len = _find_frame();
+        if (frame_len == 0)
+            return nullptr;
         MSG *frame = new MSG();
-        int idx = 0;
-        if (get_msg(_buff, _data_len, frame, &idx, _header))
+        _parse_frame(frame, _frame_data(frame_len), frame_len, false);
+        _skip(frame_len);
+        return frame;
+    }
+
+    const std::vector<MSG *> &Protocol::decode_all(const uint8_t *new_data, size_t len)
+    {
+        _batch.clear();
+        if (len > 0)
         {
-            memmove(_buff, _buff + idx, _data_len - idx);
-            _data_len -= idx;
-            return frame;
+            push_data((uint8_t *)new_data, len);
         }
-        if (idx > 0)
+        int frame_len;
+        while ((frame_len = _find_frame()) > 0)
         {
-            memmove(_buff, _buff + idx, _data_len - idx);
-            _data_len -= idx;
+            // only one frame can across buffer end in one batch, so _linear is not overwritten
+            if (_batch.size() == _msgs.size())
+                _msgs.push_back(new MSG());
+            MSG *msg = _msgs[_batch.size()];
+            if (msg->body && !msg->_body_view)
+                delete[] msg->body;
+            msg->_body_view = true;
+            msg->_body_buff_len = 0;
+            _parse_frame(msg, _frame_data(frame_len), frame_len, true);
+            _batch.push_back(msg);
+            // data is not overwritten until next push_data, so view is still valid after skip
+            _skip(frame_len);
         }
-        delete frame;
-        return nullptr;
+        return _batch;
     }
 
     MSG *Protocol::decode(const Bytes *new_data)
     {
-        return decode((uint8_t *)&new_data[0], new_data->size());
+        if (!new_data)
+            return decode((uint8_t *)nullptr, 0);
+        return decode(new_data->data, new_data->size());
     }
 
 } // namespace maix::protocol
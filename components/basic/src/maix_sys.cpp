@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add MetricsSampler, read proc files with pread to fixed buffers.
  */
 
 
@@ -26,9 +27,169 @@
 #include <iomanip>
 #include <iterator>
 #include <iostream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <errno.h>
 
 namespace maix::sys
 {
+    /**
+     * Read small file(procfs, sysfs) from offset 0 to buff with pread, so fd can be kept open and read again.
+     * @return data length, buff is '\0' terminated, -1 if failed.
+     */
+    static int _pread_file(int fd, char *buff, int size)
+    {
+        if (fd < 0)
+            return -1;
+        int len = 0;
+        while (len < size - 1)
+        {
+            ssize_t n = pread(fd, buff + len, size - 1 - len, len);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return -1;
+            }
+            if (n == 0)
+                break;
+            len += n;
+        }
+        buff[len] = 0;
+        return len;
+    }
+
+    static uint64_t _parse_u64(const char *&p)
+    {
+        while (*p == ' ' || *p == '\t')
+            ++p;
+        uint64_t v = 0;
+        while (*p >= '0' && *p <= '9')
+            v = v * 10 + (*p++ - '0');
+        return v;
+    }
+
+    static const char *_next_line(const char *p)
+    {
+        p = strchr(p, '\n');
+        return p ? p + 1 : nullptr;
+    }
+
+    /**
+     * Find "key" at line start and parse the number after it, e.g. "MemTotal:" of /proc/meminfo.
+     * @return true if found
+     */
+    static bool _parse_key_u64(const char *buff, const char *key, uint64_t *value)
+    {
+        size_t key_len = strlen(key);
+        for (const char *p = buff; p && *p; p = _next_line(p))
+        {
+            if (strncmp(p, key, key_len) == 0)
+            {
+                p += key_len;
+                *value = _parse_u64(p);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // max cores of /proc/stat parsed, index 0 is all cores
+    #define CPU_TIMES_MAX_CORES 64
+
+    typedef struct
+    {
+        uint64_t total[CPU_TIMES_MAX_CORES + 1];
+        uint64_t idle[CPU_TIMES_MAX_CORES + 1];
+        int core_num;
+    } cpu_times_t;
+
+    /**
+     * Parse cpu lines at the start of /proc/stat
+     * @return 0 if success, -1 if no cpu line
+     */
+    static int _parse_cpu_times(const char *buff, cpu_times_t *t)
+    {
+        bool found = false;
+        t->core_num = 0;
+        for (const char *p = buff; p && strncmp(p, "cpu", 3) == 0; p = _next_line(p))
+        {
+            const char *q = p + 3;
+            int idx = 0;
+            if (*q != ' ')
+            {
+                idx = (int)_parse_u64(q) + 1;
+                if (idx > CPU_TIMES_MAX_CORES)
+                    continue;
+                t->core_num = std::max(t->core_num, idx);
+            }
+            // user nice system idle iowait irq softirq steal, guest time is already in user and nice
+            uint64_t total = 0, v[8];
+            for (int i = 0; i < 8; ++i)
+            {
+                v[i] = _parse_u64(q);
+                total += v[i];
+            }
+            t->total[idx] = total;
+            t->idle[idx] = v[3] + v[4];
+            found = true;
+        }
+        return found ? 0 : -1;
+    }
+
+    static float _cpu_times_usage(const cpu_times_t *prev, const cpu_times_t *curr, int idx)
+    {
+        uint64_t total = prev ? curr->total[idx] - prev->total[idx] : curr->total[idx];
+        uint64_t idle = prev ? curr->idle[idx] - prev->idle[idx] : curr->idle[idx];
+        // counters may go back when cpu offline and online
+        if (total == 0 || (int64_t)total < 0 || idle > total)
+            return 0;
+        return 100.0f * (total - idle) / total;
+    }
+
+    static int _open_file(const std::string &path)
+    {
+        return ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+
+    static bool _read_meminfo(int fd, char *buff, int size, uint64_t *total, uint64_t *used)
+    {
+        if (_pread_file(fd, buff, size) <= 0)
+            return false;
+        uint64_t total_kb = 0, avail_kb = 0;
+        if (!_parse_key_u64(buff, "MemTotal:", &total_kb))
+            return false;
+        if (!_parse_key_u64(buff, "MemAvailable:", &avail_kb))
+        {
+            // old kernel without MemAvailable
+            uint64_t free_kb = 0, buffers_kb = 0, cached_kb = 0;
+            _parse_key_u64(buff, "MemFree:", &free_kb);
+            _parse_key_u64(buff, "Buffers:", &buffers_kb);
+            _parse_key_u64(buff, "Cached:", &cached_kb);
+            avail_kb = free_kb + buffers_kb + cached_kb;
+        }
+        *total = total_kb * 1024;
+        *used = avail_kb < total_kb ? (total_kb - avail_kb) * 1024 : 0;
+        return true;
+    }
+
+    static bool _read_temp(int fd, float *temp)
+    {
+        char buff[32];
+        if (_pread_file(fd, buff, sizeof(buff)) <= 0)
+            return false;
+        const char *p = buff;
+        bool neg = *p == '-';
+        if (neg)
+            ++p;
+        int64_t v = (int64_t)_parse_u64(p);
+        *temp = (neg ? -v : v) / 1000.0f;
+        return true;
+    }
     std::string os_version()
     {
         FILE *file = fopen("/boot/ver", "r");
@@ -210,34 +371,16 @@ namespace maix::sys
     std::map<std::string, int> memory_info()
     {
         std::map<std::string, int> res;
-        FILE *file = fopen("/proc/meminfo", "r");
-        if (!file)
+        static int fd = _open_file("/proc/meminfo");
+        char buff[2048];
+        uint64_t total = 0, used = 0;
+        if (!_read_meminfo(fd, buff, sizeof(buff), &total, &used))
         {
-            log::error("Cannot open /proc/meminfo");
+            log::error("Cannot read /proc/meminfo");
             return res;
         }
-
-        unsigned long total_memory = 0;
-        unsigned long free_memory = 0;
-        char line[256];
-
-        while (fgets(line, sizeof(line), file))
-        {
-            if (sscanf(line, "MemTotal: %lu kB", &total_memory) == 1)
-            {
-                // printf("Total memory: %lu kB\n", total_memory);
-            }
-            if (sscanf(line, "MemAvailable: %lu kB", &free_memory) == 1)
-            {
-                // printf("MemAvailable memory: %lu kB\n", free_memory);
-                break;
-            }
-        }
-
-        fclose(file);
-
-        res["used"] = (total_memory - free_memory) * 1024;
-        res["total"] = total_memory * 1024;
+        res["used"] = used;
+        res["total"] = total;
 #if PLATFORM_MAIXCAM
         res["hw_total"] = 256 * 1024 * 1024;
 #else
@@ -323,46 +466,38 @@ namespace maix::sys
     std::map<std::string, float> cpu_temp()
     {
         std::map<std::string, float> res;
-        FILE *file = fopen("/sys/class/thermal/thermal_zone0/temp", "r");
-        if (!file)
+        static int fd = _open_file("/sys/class/thermal/thermal_zone0/temp");
+        float temp = 0;
+        if (!_read_temp(fd, &temp))
         {
-            perror("Cannot open /sys/class/thermal/thermal_zone0/temp");
+            log::error("Cannot read /sys/class/thermal/thermal_zone0/temp");
             return res;
         }
-        int temp = 0;
-        if (fscanf(file, "%d", &temp) == 1)
-        {
-            // printf("CPU temp: %d\n", temp);
-        }
-        fclose(file);
-        res["cpu"] = temp / 1000.0;
+        res["cpu"] = temp;
         return res;
     }
 
     std::map<std::string, float> cpu_usage()
     {
         std::map<std::string, float> usage;
-
-        std::ifstream proc_stat("/proc/stat");
-        std::string line;
-        while (std::getline(proc_stat, line))
+        static int fd = _open_file("/proc/stat");
+        static std::mutex lock;
+        static cpu_times_t prev;
+        static bool has_prev = false;
+        cpu_times_t curr;
+        char buff[8192];
+        if (_pread_file(fd, buff, sizeof(buff)) <= 0 || _parse_cpu_times(buff, &curr) != 0)
         {
-            std::istringstream iss(line);
-            std::vector<std::string> words((std::istream_iterator<std::string>(iss)), std::istream_iterator<std::string>());
-
-            if (words[0].substr(0, 3) == "cpu")
-            {
-                long total_time = 0;
-                for (size_t i = 1; i < words.size(); i++)
-                    total_time += std::stol(words[i]);
-
-                long idle_time = std::stol(words[4]); // idle time is 4th field
-                float cpu_usage = 100 * (1 - (float)idle_time / total_time);
-
-                usage[words[0]] = cpu_usage;
-            }
+            log::error("Cannot read /proc/stat");
+            return usage;
         }
-
+        std::lock_guard<std::mutex> guard(lock);
+        const cpu_times_t *last = has_prev ? &prev : nullptr;
+        usage["cpu"] = _cpu_times_usage(last, &curr, 0);
+        for (int i = 1; i <= curr.core_num; ++i)
+            usage["cpu" + std::to_string(i - 1)] = _cpu_times_usage(last, &curr, i);
+        prev = curr;
+        has_prev = true;
         return usage;
     }
 
@@ -447,6 +582,245 @@ namespace maix::sys
         return partitions;
     }
 
+    typedef struct
+    {
+        std::atomic<uint32_t> seq; // odd when writing
+        Metrics m;
+    } metrics_slot_t;
+
+    typedef struct
+    {
+        int interval_ms;
+        int history;
+        int stat_fd;
+        int meminfo_fd;
+        int temp_fd;
+        int status_fd;
+        char buff[8192];
+        cpu_times_t prev;
+        bool has_prev;
+        std::unique_ptr<metrics_slot_t[]> slots;
+        std::atomic<uint64_t> count;
+        std::thread *thread;
+        std::mutex mutex;
+        std::condition_variable cond;
+        bool stop;
+    } metrics_param_t;
+
+    static void _metrics_read(metrics_param_t *param, Metrics &m)
+    {
+        memset(&m, 0, sizeof(m));
+        m.timestamp = time::ticks_ms();
+        cpu_times_t curr;
+        if (_pread_file(param->stat_fd, param->buff, sizeof(param->buff)) > 0 && _parse_cpu_times(param->buff, &curr) == 0)
+        {
+            const cpu_times_t *last = param->has_prev ? &param->prev : nullptr;
+            m.cpu = _cpu_times_usage(last, &curr, 0);
+            m.core_num = std::min(curr.core_num, METRICS_MAX_CORES);
+            for (int i = 0; i < m.core_num; ++i)
+                m.cores[i] = _cpu_times_usage(last, &curr, i + 1);
+            param->prev = curr;
+            param->has_prev = true;
+        }
+        _read_meminfo(param->meminfo_fd, param->buff, sizeof(param->buff), &m.mem_total, &m.mem_used);
+        _read_temp(param->temp_fd, &m.temp);
+        if (_pread_file(param->status_fd, param->buff, sizeof(param->buff)) > 0)
+        {
+            uint64_t v = 0;
+            if (_parse_key_u64(param->buff, "VmRSS:", &v))
+                m.rss = v * 1024;
+            if (_parse_key_u64(param->buff, "Threads:", &v))
+                m.threads = v;
+        }
+    }
+
+    /**
+     * Only one writer(sampler thread or sample()), readers check slot seq to get complete sample without lock.
+     */
+    static void _metrics_push(metrics_param_t *param, const Metrics &m)
+    {
+        uint64_t count = param->count.load(std::memory_order_relaxed);
+        metrics_slot_t &slot = param->slots[count % param->history];
+        uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy((void *)&slot.m, &m, sizeof(m));
+        slot.seq.store(seq + 2, std::memory_order_release);
+        param->count.store(count + 1, std::memory_order_release);
+    }
+
+    static bool _metrics_get(metrics_param_t *param, uint64_t idx, Metrics &m)
+    {
+        metrics_slot_t &slot = param->slots[idx % param->history];
+        while (1)
+        {
+            uint32_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            memcpy((void *)&m, (const void *)&slot.m, sizeof(m));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == seq)
+                break;
+        }
+        // overwritten by newer sample when reading
+        return param->count.load(std::memory_order_acquire) <= idx + param->history;
+    }
+
+    MetricsSampler::MetricsSampler(int interval_ms, int history, const std::string &root, int pid)
+    {
+        if (interval_ms <= 0 || history <= 0)
+            throw err::Exception(err::ERR_ARGS, "interval_ms and history must > 0");
+        metrics_param_t *param = new metrics_param_t();
+        param->interval_ms = interval_ms;
+        param->history = history;
+        param->slots.reset(new metrics_slot_t[history]);
+        for (int i = 0; i < history; ++i)
+            param->slots[i].seq.store(0);
+        param->count.store(0);
+        param->has_prev = false;
+        param->thread = nullptr;
+        param->stop = false;
+        std::string proc = root + "/proc/";
+        std::string pid_str = pid < 0 ? "self" : std::to_string(pid);
+        param->stat_fd = _open_file(proc + "stat");
+        param->meminfo_fd = _open_file(proc + "meminfo");
+        param->status_fd = _open_file(proc + pid_str + "/status");
+        param->temp_fd = _open_file(root + "/sys/class/thermal/thermal_zone0/temp");
+        if (param->stat_fd < 0)
+            log::warn("open %sstat failed, no cpu usage", proc.c_str());
+        _param = param;
+    }
+
+    MetricsSampler::~MetricsSampler()
+    {
+        stop();
+        metrics_param_t *param = (metrics_param_t *)_param;
+        int fds[] = {param->stat_fd, param->meminfo_fd, param->status_fd, param->temp_fd};
+        for (int fd : fds)
+        {
+            if (fd >= 0)
+                ::close(fd);
+        }
+        delete param;
+    }
+
+    err::Err MetricsSampler::start()
+    {
+        metrics_param_t *param = (metrics_param_t *)_param;
+        if (param->thread)
+            return err::ERR_BUSY;
+        Metrics m;
+        _metrics_read(param, m);
+        _metrics_push(param, m);
+        param->stop = false;
+        param->thread = new std::thread([param]() {
+            auto next = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> lock(param->mutex);
+            while (1)
+            {
+                next += std::chrono::milliseconds(param->interval_ms);
+                if (param->cond.wait_until(lock, next, [param]() { return param->stop; }))
+                    break;
+                lock.unlock();
+                Metrics m;
+                _metrics_read(param, m);
+                _metrics_push(param, m);
+                lock.lock();
+            }
+        });
+        return err::ERR_NONE;
+    }
+
+    err::Err MetricsSampler::stop()
+    {
+        metrics_param_t *param = (metrics_param_t *)_param;
+        if (!param->thread)
+            return err::ERR_NONE;
+        {
+            std::lock_guard<std::mutex> lock(param->mutex);
+            param->stop = true;
+        }
+        param->cond.notify_all();
+        param->thread->join();
+        delete param->thread;
+        param->thread = nullptr;
+        return err::ERR_NONE;
+    }
+
+    bool MetricsSampler::is_running()
+    {
+        return ((metrics_param_t *)_param)->thread != nullptr;
+    }
+
+    err::Err MetricsSampler::sample()
+    {
+        metrics_param_t *param = (metrics_param_t *)_param;
+        if (param->thread)
+            return err::ERR_BUSY;
+        Metrics m;
+        _metrics_read(param, m);
+        _metrics_push(param, m);
+        return err::ERR_NONE;
+    }
+
+    sys::Metrics MetricsSampler::latest()
+    {
+        metrics_param_t *param = (metrics_param_t *)_param;
+        Metrics m;
+        while (1)
+        {
+            uint64_t count = param->count.load(std::memory_order_acquire);
+            if (count == 0)
+            {
+                memset(&m, 0, sizeof(m));
+                break;
+            }
+            if (_metrics_get(param, count - 1, m))
+                break;
+        }
+        return m;
+    }
+
+    std::vector<sys::Metrics> MetricsSampler::history(int num)
+    {
+        metrics_param_t *param = (metrics_param_t *)_param;
+        uint64_t count = param->count.load(std::memory_order_acquire);
+        uint64_t n = std::min(count, (uint64_t)param->history);
+        if (num >= 0 && (uint64_t)num < n)
+            n = num;
+        std::vector<sys::Metrics> res;
+        res.reserve(n);
+        Metrics m;
+        for (uint64_t idx = count - n; idx < count; ++idx)
+        {
+            // skip samples overwritten when reading, only happens if reader is slower than history * interval
+            if (_metrics_get(param, idx, m))
+                res.push_back(m);
+        }
+        return res;
+    }
+
+    uint64_t MetricsSampler::count()
+    {
+        return ((metrics_param_t *)_param)->count.load(std::memory_order_acquire);
+    }
+
+    int MetricsSampler::interval()
+    {
+        return ((metrics_param_t *)_param)->interval_ms;
+    }
+
+    sys::MetricsSampler *metrics_sampler()
+    {
+        static sys::MetricsSampler sampler;
+        static std::once_flag started;
+        std::call_once(started, []() { sampler.start(); });
+        return &sampler;
+    }
+
     void poweroff()
     {
         int ret = system("poweroff");
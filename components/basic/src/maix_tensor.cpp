@@ -0,0 +1,639 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#include "maix_tensor.hpp"
+#include <math.h>
+
+namespace maix::tensor
+{
+    typedef float v4f __attribute__((vector_size(16)));
+    typedef int32_t v4i __attribute__((vector_size(16)));
+
+    /**
+     * exp of 4 floats, cephes polynomial, relative error < 2e-7 in [-87, 88]
+     */
+    static inline v4f _exp4(v4f x)
+    {
+        const v4f hi = {88.3762626647949f, 88.3762626647949f, 88.3762626647949f, 88.3762626647949f};
+        const v4f lo = {-87.3365447504f, -87.3365447504f, -87.3365447504f, -87.3365447504f};
+        x = x > hi ? hi : x;
+        x = x < lo ? lo : x;
+        v4f fx = x * 1.44269504088896341f + 0.5f;
+        v4f t = __builtin_convertvector(__builtin_convertvector(fx, v4i), v4f);
+        t = t + __builtin_convertvector(t > fx, v4f); // floor, true is -1
+        x = x - t * 0.693359375f - t * -2.12194440e-4f;
+        v4f y = 1.9875691500e-4f * x + 1.3981999507e-3f;
+        y = y * x + 8.3334519073e-3f;
+        y = y * x + 4.1665795894e-2f;
+        y = y * x + 1.6666665459e-1f;
+        y = y * x + 5.0000001201e-1f;
+        y = y * x * x + x + 1.0f;
+        v4i e = (__builtin_convertvector(t, v4i) + 127) << 23;
+        return y * (v4f)e;
+    }
+
+    static inline v4f _load4(const float *p)
+    {
+        v4f v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static inline void _store4(float *p, v4f v)
+    {
+        memcpy(p, &v, sizeof(v));
+    }
+
+    template <bool SIGMOID>
+    static void _exp_line(const float *src, float *dst, int n)
+    {
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            v4f x = _load4(src + i);
+            _store4(dst + i, SIGMOID ? 1.0f / (1.0f + _exp4(-x)) : _exp4(x));
+        }
+        if (i < n)
+        {
+            v4f x = {0, 0, 0, 0};
+            memcpy(&x, src + i, (n - i) * sizeof(float));
+            x = SIGMOID ? 1.0f / (1.0f + _exp4(-x)) : _exp4(x);
+            memcpy(dst + i, &x, (n - i) * sizeof(float));
+        }
+    }
+
+    /**
+     * exp(x - max) in place and return sum
+     */
+    static float _exp_sub_sum(float *data, int n, float max)
+    {
+        v4f sum4 = {0, 0, 0, 0};
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            v4f y = _exp4(_load4(data + i) - max);
+            _store4(data + i, y);
+            sum4 += y;
+        }
+        float sum = sum4[0] + sum4[1] + sum4[2] + sum4[3];
+        if (i < n)
+        {
+            v4f x = {0, 0, 0, 0};
+            memcpy(&x, data + i, (n - i) * sizeof(float));
+            x = _exp4(x - max);
+            memcpy(data + i, &x, (n - i) * sizeof(float));
+            for (int k = 0; k < n - i; ++k)
+                sum += x[k];
+        }
+        return sum;
+    }
+
+    static void _softmax_line(float *data, int n)
+    {
+        float max = data[0];
+        for (int i = 1; i < n; ++i)
+            max = data[i] > max ? data[i] : max;
+        float r = 1.0f / _exp_sub_sum(data, n, max);
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+            _store4(data + i, _load4(data + i) * r);
+        for (; i < n; ++i)
+            data[i] *= r;
+    }
+
+    /**
+     * softmax of m columns, n rows, rows are continuous, row i of src at src + i * src_stride.
+     * src and dst can be the same memory.
+     */
+    static void _softmax_rows(const float *src, int64_t src_stride, float *dst, int64_t dst_stride, int n, int m, float *max, float *sum)
+    {
+        memcpy(max, src, m * sizeof(float));
+        for (int i = 1; i < n; ++i)
+        {
+            const float *row = src + i * src_stride;
+            int j = 0;
+            for (; j + 4 <= m; j += 4)
+            {
+                v4f v = _load4(row + j);
+                v4f mx = _load4(max + j);
+                _store4(max + j, v > mx ? v : mx);
+            }
+            for (; j < m; ++j)
+                max[j] = row[j] > max[j] ? row[j] : max[j];
+        }
+        memset(sum, 0, m * sizeof(float));
+        for (int i = 0; i < n; ++i)
+        {
+            const float *row = src + i * src_stride;
+            float *o = dst + i * dst_stride;
+            int j = 0;
+            for (; j + 4 <= m; j += 4)
+            {
+                v4f y = _exp4(_load4(row + j) - _load4(max + j));
+                _store4(o + j, y);
+                _store4(sum + j, _load4(sum + j) + y);
+            }
+            for (; j < m; ++j)
+            {
+                v4f x = {row[j] - max[j], 0, 0, 0};
+                o[j] = _exp4(x)[0];
+                sum[j] += o[j];
+            }
+        }
+        for (int j = 0; j < m; ++j)
+            sum[j] = 1.0f / sum[j];
+        for (int i = 0; i < n; ++i)
+        {
+            float *o = dst + i * dst_stride;
+            int j = 0;
+            for (; j + 4 <= m; j += 4)
+                _store4(o + j, _load4(o + j) * _load4(sum + j));
+            for (; j < m; ++j)
+                o[j] *= sum[j];
+        }
+    }
+
+    /**
+     * read n elements with stride to float buffer, integer dequantized
+     */
+    static void _load_line(const Tensor &t, const void *data, DType dtype, int64_t off, int stride, int n, float *buf)
+    {
+        if (dtype == DType::FLOAT32 && stride == 1)
+        {
+            memcpy(buf, (const float *)data + off, n * sizeof(float));
+            return;
+        }
+        for (int i = 0; i < n; ++i, off += stride)
+            buf[i] = t.get(off);
+    }
+
+    static void _store_line(float *data, int64_t off, int stride, int n, const float *buf)
+    {
+        if (stride == 1)
+        {
+            memcpy(data + off, buf, n * sizeof(float));
+            return;
+        }
+        for (int i = 0; i < n; ++i, off += stride)
+            data[off] = buf[i];
+    }
+
+    /**
+     * call fn(off0, off1) for every line along axis, offsets are the line start element of a and b.
+     */
+    template <typename F>
+    static void _for_lines(const std::vector<int> &shape, const std::vector<int> &s0, const std::vector<int> &s1, int axis, F fn)
+    {
+        int nd = shape.size();
+        std::vector<int> dims, st0, st1;
+        for (int i = 0; i < nd; ++i)
+        {
+            if (i == axis)
+                continue;
+            dims.push_back(shape[i]);
+            st0.push_back(s0[i]);
+            st1.push_back(s1[i]);
+        }
+        int64_t lines = 1;
+        for (int d : dims)
+            lines *= d;
+        std::vector<int> idx(dims.size(), 0);
+        int64_t o0 = 0, o1 = 0;
+        for (int64_t l = 0; l < lines; ++l)
+        {
+            fn(o0, o1);
+            for (int d = (int)dims.size() - 1; d >= 0; --d)
+            {
+                o0 += st0[d];
+                o1 += st1[d];
+                if (++idx[d] < dims[d])
+                    break;
+                o0 -= (int64_t)st0[d] * dims[d];
+                o1 -= (int64_t)st1[d] * dims[d];
+                idx[d] = 0;
+            }
+        }
+    }
+
+    static int _check_axis(int axis, int nd)
+    {
+        if (axis < 0)
+            axis += nd;
+        if (axis < 0 || axis >= nd)
+        {
+            log::error("axis %d out of range\n", axis);
+            throw err::Exception(err::ERR_ARGS, "axis out of range");
+        }
+        return axis;
+    }
+
+    /**
+     * copy elements of src to contiguous memory dst, same dtype
+     */
+    static void _copy_contiguous(const std::vector<int> &shape, const std::vector<int> &strides, DType dtype, const void *src, void *dst)
+    {
+        int nd = shape.size();
+        int64_t size = 1;
+        for (int d : shape)
+            size *= d;
+        if (nd == 0 || size == 0)
+            return;
+        int esize = dtype_size[dtype];
+        std::vector<int> cs(nd);
+        int64_t step = 1;
+        bool contiguous = true;
+        for (int i = nd - 1; i >= 0; --i)
+        {
+            cs[i] = step;
+            if (shape[i] != 1 && strides[i] != step)
+                contiguous = false;
+            step *= shape[i];
+        }
+        if (contiguous)
+        {
+            memcpy(dst, src, size * esize);
+            return;
+        }
+        int n = shape[nd - 1];
+        int s = strides[nd - 1];
+        _for_lines(shape, strides, cs, nd - 1, [&](int64_t o0, int64_t o1) {
+            const uint8_t *p = (const uint8_t *)src + o0 * esize;
+            uint8_t *q = (uint8_t *)dst + o1 * esize;
+            if (s == 1)
+            {
+                memcpy(q, p, (size_t)n * esize);
+                return;
+            }
+            for (int i = 0; i < n; ++i, p += (int64_t)s * esize, q += esize)
+                memcpy(q, p, esize);
+        });
+    }
+
+    Tensor::Tensor(const Tensor &t)
+    {
+        _shape = t._shape;
+        _strides = _contiguous_strides(t._shape);
+        _dtype = t._dtype;
+        _scale = t._scale;
+        _zero_point = t._zero_point;
+        int64_t size = 1;
+        for (int d : _shape)
+            size *= d;
+        _data = malloc(size * dtype_size[_dtype]);
+        _is_alloc = true;
+        if (t._data)
+            _copy_contiguous(t._shape, t._strides, t._dtype, t._data, _data);
+    }
+
+    void Tensor::operator=(Tensor &t)
+    {
+        if (this == &t)
+            return;
+        int64_t bytes = (int64_t)t.size_int() * dtype_size[t._dtype];
+        int64_t curr = (int64_t)size_int() * dtype_size[_dtype];
+        if (_is_alloc && curr < bytes)
+        {
+            free(_data);
+            _data = nullptr;
+            _is_alloc = false;
+        }
+        else if (!_is_alloc && _data && curr < bytes)
+        {
+            log::error("tensor copy: size not match\n");
+            throw err::Exception(err::ERR_ARGS);
+        }
+        if (!_data)
+        {
+            _data = malloc(bytes);
+            _is_alloc = true;
+        }
+        _shape = t._shape;
+        _strides = _contiguous_strides(t._shape);
+        _dtype = t._dtype;
+        _scale = t._scale;
+        _zero_point = t._zero_point;
+        _copy_contiguous(t._shape, t._strides, t._dtype, t._data, _data);
+    }
+
+    std::valarray<float> *Tensor::to_float_list()
+    {
+        if (_dtype == DType::FLOAT32 && is_contiguous())
+            return new std::valarray<float>((float *)_data, size_int());
+        std::valarray<float> *ret = new std::valarray<float>(size_int());
+        if (ret->size() == 0)
+            return ret;
+        int nd = _shape.size();
+        int n = _shape[nd - 1];
+        std::vector<int> cs = _contiguous_strides(_shape);
+        float *out = &(*ret)[0];
+        _for_lines(_shape, _strides, cs, nd - 1, [&](int64_t o0, int64_t o1) {
+            _load_line(*this, _data, _dtype, o0, _strides[nd - 1], n, out + o1);
+        });
+        return ret;
+    }
+
+    tensor::Tensor *Tensor::_view(const std::vector<int> &shape, const std::vector<int> &strides, int64_t offset)
+    {
+        uint8_t *p = (uint8_t *)_data + offset * dtype_size[_dtype];
+        tensor::Tensor *t = new tensor::Tensor(shape, _dtype, p, strides);
+        t->set_quant(_scale, _zero_point);
+        return t;
+    }
+
+    tensor::Tensor *Tensor::slice(int axis, int start, int stop, int step)
+    {
+        axis = _check_axis(axis, _shape.size());
+        if (step <= 0)
+            throw err::Exception(err::ERR_ARGS, "slice step must > 0");
+        int dim = _shape[axis];
+        if (start < 0)
+            start += dim;
+        if (stop < 0)
+            stop += dim;
+        start = std::max(0, std::min(start, dim));
+        stop = std::max(start, std::min(stop, dim));
+        std::vector<int> shape = _shape;
+        std::vector<int> strides = _strides;
+        shape[axis] = (stop - start + step - 1) / step;
+        strides[axis] = _strides[axis] * step;
+        return _view(shape, strides, (int64_t)start * _strides[axis]);
+    }
+
+    tensor::Tensor *Tensor::select(int axis, int index)
+    {
+        axis = _check_axis(axis, _shape.size());
+        if (index < 0)
+            index += _shape[axis];
+        if (index < 0 || index >= _shape[axis])
+            throw err::Exception(err::ERR_ARGS, "select index out of range");
+        std::vector<int> shape = _shape;
+        std::vector<int> strides = _strides;
+        shape.erase(shape.begin() + axis);
+        strides.erase(strides.begin() + axis);
+        return _view(shape, strides, (int64_t)index * _strides[axis]);
+    }
+
+    tensor::Tensor *Tensor::transpose(const std::vector<int> &axes)
+    {
+        int nd = _shape.size();
+        std::vector<int> order = axes;
+        if (order.empty())
+        {
+            for (int i = nd - 1; i >= 0; --i)
+                order.push_back(i);
+        }
+        if ((int)order.size() != nd)
+            throw err::Exception(err::ERR_ARGS, "transpose axes size not match");
+        std::vector<bool> used(nd, false);
+        std::vector<int> shape(nd), strides(nd);
+        for (int i = 0; i < nd; ++i)
+        {
+            int a = _check_axis(order[i], nd);
+            if (used[a])
+                throw err::Exception(err::ERR_ARGS, "transpose axes repeated");
+            used[a] = true;
+            shape[i] = _shape[a];
+            strides[i] = _strides[a];
+        }
+        return _view(shape, strides, 0);
+    }
+
+    tensor::Tensor *Tensor::contiguous()
+    {
+        return new tensor::Tensor(*this);
+    }
+
+    tensor::Tensor *Tensor::dequantize()
+    {
+        tensor::Tensor *t = new tensor::Tensor(_shape, DType::FLOAT32);
+        int nd = _shape.size();
+        if (nd == 0 || size_int() == 0)
+            return t;
+        int n = _shape[nd - 1];
+        float *out = (float *)t->data();
+        _for_lines(_shape, _strides, t->_strides, nd - 1, [&](int64_t o0, int64_t o1) {
+            _load_line(*this, _data, _dtype, o0, _strides[nd - 1], n, out + o1);
+        });
+        return t;
+    }
+
+    /**
+     * check out tensor for math ops and return it, nullptr out means this tensor(must be float32)
+     */
+    static Tensor *_check_out(Tensor *self, Tensor *out)
+    {
+        if (!out)
+            out = self;
+        if (out->dtype() != DType::FLOAT32)
+        {
+            log::error("output tensor must be float32\n");
+            return nullptr;
+        }
+        if (out->shape() != self->shape())
+        {
+            log::error("output tensor shape not match\n");
+            return nullptr;
+        }
+        return out;
+    }
+
+    /**
+     * run fn(buf, n) on every line along axis, data is read to buf as float, then write to out.
+     * contiguous float32 lines are processed in place of out without buffer.
+     */
+    template <typename F>
+    static void _map_lines(Tensor &t, const std::vector<int> &strides, Tensor *out, int axis, F fn)
+    {
+        std::vector<int> shape = t.shape();
+        std::vector<int> out_strides = out->strides();
+        int nd = shape.size();
+        if (nd == 0 || t.size_int() == 0)
+            return;
+        // whole tensor as one line if both contiguous and op is elementwise(axis < 0)
+        if (axis < 0 && t.is_contiguous() && out->is_contiguous())
+        {
+            int n = t.size_int();
+            float *o = (float *)out->data();
+            if (t.dtype() == DType::FLOAT32)
+            {
+                if (o != t.data())
+                    memcpy(o, t.data(), n * sizeof(float));
+            }
+            else
+                _load_line(t, t.data(), t.dtype(), 0, 1, n, o);
+            fn(o, n);
+            return;
+        }
+        if (axis < 0)
+            axis = nd - 1;
+        int n = shape[axis];
+        int s0 = strides[axis], s1 = out_strides[axis];
+        std::vector<float> buf(n);
+        float *o = (float *)out->data();
+        _for_lines(shape, strides, out_strides, axis, [&](int64_t o0, int64_t o1) {
+            if (s1 == 1 && t.dtype() == DType::FLOAT32 && s0 == 1)
+            {
+                if (o + o1 != (float *)t.data() + o0)
+                    memcpy(o + o1, (float *)t.data() + o0, n * sizeof(float));
+                fn(o + o1, n);
+                return;
+            }
+            _load_line(t, t.data(), t.dtype(), o0, s0, n, buf.data());
+            fn(buf.data(), n);
+            _store_line(o, o1, s1, n, buf.data());
+        });
+    }
+
+    err::Err Tensor::sigmoid(tensor::Tensor *out)
+    {
+        out = _check_out(this, out);
+        if (!out)
+            return err::ERR_ARGS;
+        _map_lines(*this, _strides, out, -1, [](float *p, int n) { _exp_line<true>(p, p, n); });
+        return err::ERR_NONE;
+    }
+
+    err::Err Tensor::exp(tensor::Tensor *out)
+    {
+        out = _check_out(this, out);
+        if (!out)
+            return err::ERR_ARGS;
+        _map_lines(*this, _strides, out, -1, [](float *p, int n) { _exp_line<false>(p, p, n); });
+        return err::ERR_NONE;
+    }
+
+    err::Err Tensor::softmax(int axis, tensor::Tensor *out)
+    {
+        if (_shape.empty())
+            return err::ERR_ARGS;
+        if (axis < 0)
+            axis += _shape.size();
+        if (axis < 0 || (size_t)axis >= _shape.size())
+        {
+            log::error("axis out of range\n");
+            return err::ERR_ARGS;
+        }
+        out = _check_out(this, out);
+        if (!out)
+            return err::ERR_ARGS;
+        int nd = _shape.size();
+        std::vector<int> out_strides = out->strides();
+        if (_dtype == DType::FLOAT32 && axis != nd - 1 && _strides[nd - 1] == 1 && out_strides[nd - 1] == 1)
+        {
+            // softmax of many columns at once, read continuous rows instead of jumping along axis
+            std::vector<int> sh = _shape;
+            sh[axis] = 1;
+            int n = _shape[axis];
+            int m = _shape[nd - 1];
+            int64_t s0 = _strides[axis], s1 = out_strides[axis];
+            std::vector<float> max(m), sum(m);
+            _for_lines(sh, _strides, out_strides, nd - 1, [&](int64_t o0, int64_t o1) {
+                const float *src = (const float *)_data + o0;
+                float *dst = (float *)out->data() + o1;
+                _softmax_rows(src, s0, dst, s1, n, m, max.data(), sum.data());
+            });
+            return err::ERR_NONE;
+        }
+        _map_lines(*this, _strides, out, axis, [](float *p, int n) { _softmax_line(p, n); });
+        return err::ERR_NONE;
+    }
+
+    tensor::Tensor *Tensor::argmax(int axis)
+    {
+        int nd = _shape.size();
+        if (axis == 0xffff)
+        {
+            tensor::Tensor *ret = new tensor::Tensor({1}, tensor::DType::INT32);
+            int *ret_data = (int *)ret->data();
+            if (is_contiguous() && _dtype != DType::FLOAT16)
+            {
+                ret_data[0] = _get_argmax0(_dtype, _data, size_int());
+                return ret;
+            }
+            std::valarray<float> *values = to_float_list();
+            float *p = &(*values)[0];
+            ret_data[0] = std::max_element(p, p + values->size()) - p;
+            delete values;
+            return ret;
+        }
+        axis = _check_axis(axis, nd);
+        if (_shape[axis] == 0)
+            throw err::Exception(err::ERR_ARGS, "argmax of empty axis");
+        std::vector<int> shape = _shape;
+        shape.erase(shape.begin() + axis);
+        if (shape.empty())
+            shape.push_back(1);
+        tensor::Tensor *ret = new tensor::Tensor(shape, tensor::DType::INT32);
+        // strides of ret with a 0 stride axis inserted, so lines of this tensor map to elements of ret
+        std::vector<int> rs = _contiguous_strides(_shape);
+        for (int i = 0; i < axis; ++i)
+            rs[i] /= _shape[axis];
+        rs[axis] = 0;
+        int n = _shape[axis];
+        int s = _strides[axis];
+        int32_t *out = (int32_t *)ret->data();
+        if (_dtype == DType::FLOAT32 && axis != nd - 1 && _strides[nd - 1] == 1)
+        {
+            // compare whole continuous rows instead of jumping along axis, e.g. class axis of yolo output(1, 80, 8400)
+            std::vector<int> sh = _shape;
+            sh[axis] = 1;
+            int m = _shape[nd - 1];
+            std::vector<float> max(m);
+            _for_lines(sh, _strides, rs, nd - 1, [&](int64_t o0, int64_t o1) {
+                const float *p = (const float *)_data + o0;
+                int32_t *idx = out + o1;
+                memcpy(max.data(), p, m * sizeof(float));
+                memset(idx, 0, m * sizeof(int32_t));
+                for (int i = 1; i < n; ++i)
+                {
+                    const float *q = p + (int64_t)i * s;
+                    for (int j = 0; j < m; ++j)
+                    {
+                        if (q[j] > max[j])
+                        {
+                            max[j] = q[j];
+                            idx[j] = i;
+                        }
+                    }
+                }
+            });
+            return ret;
+        }
+        _for_lines(_shape, _strides, rs, axis, [&](int64_t o0, int64_t o1) {
+            if (_dtype == DType::FLOAT32)
+            {
+                const float *p = (const float *)_data + o0;
+                float max = p[0];
+                int idx = 0;
+                for (int i = 1; i < n; ++i)
+                {
+                    if (p[(int64_t)i * s] > max)
+                    {
+                        max = p[(int64_t)i * s];
+                        idx = i;
+                    }
+                }
+                out[o1] = idx;
+                return;
+            }
+            float max = get(o0);
+            int idx = 0;
+            for (int i = 1; i < n; ++i)
+            {
+                float v = get(o0 + (int64_t)i * s);
+                if (v > max)
+                {
+                    max = v;
+                    idx = i;
+                }
+            }
+            out[o1] = idx;
+        });
+        return ret;
+    }
+
+} // namespace maix::tensor
@@ -0,0 +1,376 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#include "maix_thread.hpp"
+#include "maix_log.hpp"
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+namespace maix::thread
+{
+    class Worker
+    {
+    public:
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks; // owner push and pop back, thieves take front
+        thread::Thread *thread = nullptr;
+    };
+
+    typedef struct
+    {
+        std::vector<Worker *> workers;
+        std::mutex mutex; // only for idle workers sleep and wake up
+        std::condition_variable cond;
+        std::atomic<int> pending; // tasks in all deques
+        std::atomic<uint32_t> next;
+        bool stop;
+        std::vector<int> cpus;
+        int priority;
+    } pool_param_t;
+
+    /**
+     * One parallel_for call, chunks are claimed by an atomic index,
+     * so the caller and whichever workers get the helper tasks first share the work.
+     */
+    class ParallelJob
+    {
+    public:
+        std::atomic<int> next{0};
+        std::atomic<int> done{0};
+        int begin;
+        int end;
+        int chunk;
+        int chunks;
+        const std::function<void(int, int)> *func; // only used after a chunk claimed, caller is waiting then
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::exception_ptr error;
+
+        void run()
+        {
+            int i;
+            while ((i = next.fetch_add(1)) < chunks)
+            {
+                int b = begin + i * chunk;
+                try
+                {
+                    (*func)(b, std::min(end, b + chunk));
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error)
+                        error = std::current_exception();
+                }
+                if (done.fetch_add(1) + 1 == chunks)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    cond.notify_all();
+                }
+            }
+        }
+    };
+
+    static thread_local pool_param_t *_tls_pool = nullptr;
+    static thread_local thread::ThreadPool *_tls_pool_obj = nullptr;
+    static thread_local int _tls_worker = -1;
+    static thread_local int _tls_parallel_threads = 0;
+    static std::atomic<int> _parallel_threads{0};
+    static std::mutex _pool_mutex;
+    // never destructed, workers may still be used by other static objects' destructors at exit
+    static std::shared_ptr<thread::ThreadPool> &_pool = *new std::shared_ptr<thread::ThreadPool>();
+
+    int cpu_count()
+    {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        return n > 0 ? (int)n : 1;
+    }
+
+    err::Err set_cpu_affinity(const std::vector<int> &cpus)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (cpus.empty())
+        {
+            long n = sysconf(_SC_NPROCESSORS_CONF);
+            for (int i = 0; i < n && i < CPU_SETSIZE; ++i)
+                CPU_SET(i, &set);
+        }
+        for (int cpu : cpus)
+        {
+            if (cpu < 0 || cpu >= CPU_SETSIZE)
+            {
+                log::error("invalid cpu index %d\n", cpu);
+                return err::ERR_ARGS;
+            }
+            CPU_SET(cpu, &set);
+        }
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (ret != 0)
+        {
+            log::error("set cpu affinity failed: %s\n", strerror(ret));
+            return ret == EINVAL ? err::ERR_ARGS : err::ERR_RUNTIME;
+        }
+        return err::ERR_NONE;
+    }
+
+    err::Err set_realtime_priority(int priority)
+    {
+        if (priority < 0 || priority > sched_get_priority_max(SCHED_FIFO))
+        {
+            log::error("invalid priority %d, should be in [0, %d]\n", priority, sched_get_priority_max(SCHED_FIFO));
+            return err::ERR_ARGS;
+        }
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = priority;
+        int ret = pthread_setschedparam(pthread_self(), priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param);
+        if (ret != 0)
+        {
+            log::error("set real time priority failed: %s\n", strerror(ret));
+            return ret == EPERM ? err::ERR_NOT_PERMIT : err::ERR_RUNTIME;
+        }
+        return err::ERR_NONE;
+    }
+
+    static bool _take_task(pool_param_t *p, int id, std::function<void()> &task)
+    {
+        Worker *self = p->workers[id];
+        {
+            std::lock_guard<std::mutex> lock(self->lock);
+            if (!self->tasks.empty())
+            {
+                task = std::move(self->tasks.back());
+                self->tasks.pop_back();
+                return true;
+            }
+        }
+        int n = (int)p->workers.size();
+        for (int i = 1; i < n; ++i)
+        {
+            Worker *victim = p->workers[(id + i) % n];
+            std::lock_guard<std::mutex> lock(victim->lock);
+            if (!victim->tasks.empty())
+            {
+                task = std::move(victim->tasks.front());
+                victim->tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void _worker_loop(thread::ThreadPool *pool, pool_param_t *p, int id)
+    {
+        _tls_pool = p;
+        _tls_pool_obj = pool;
+        _tls_worker = id;
+        if (!p->cpus.empty())
+            set_cpu_affinity({p->cpus[id % p->cpus.size()]});
+        if (p->priority > 0)
+            set_realtime_priority(p->priority);
+        std::function<void()> task;
+        while (true)
+        {
+            if (_take_task(p, id, task))
+            {
+                --p->pending;
+                task(); // tasks wrapped by submit and parallel_for never throw
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(p->mutex);
+            p->cond.wait(lock, [p]() { return p->pending > 0 || p->stop; });
+            if (p->stop && p->pending <= 0)
+                break;
+        }
+    }
+
+    ThreadPool::ThreadPool(int num_threads, const std::vector<int> &cpus, int priority)
+    {
+        pool_param_t *p = new pool_param_t();
+        p->pending = 0;
+        p->next = 0;
+        p->stop = false;
+        p->cpus = cpus;
+        p->priority = priority;
+        if (num_threads <= 0)
+            num_threads = cpu_count();
+        for (int i = 0; i < num_threads; ++i)
+            p->workers.push_back(new Worker());
+        for (int i = 0; i < num_threads; ++i)
+        {
+            p->workers[i]->thread = new thread::Thread([this, p, i](void *args) {
+                _worker_loop(this, p, i);
+            });
+        }
+        _param = p;
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        pool_param_t *p = (pool_param_t *)_param;
+        {
+            std::lock_guard<std::mutex> lock(p->mutex);
+            p->stop = true;
+        }
+        p->cond.notify_all();
+        // join all before delete, running workers may still steal from deques of stopped ones
+        for (Worker *w : p->workers)
+            w->thread->join();
+        for (Worker *w : p->workers)
+        {
+            delete w->thread;
+            delete w;
+        }
+        delete p;
+    }
+
+    int ThreadPool::size()
+    {
+        return (int)((pool_param_t *)_param)->workers.size();
+    }
+
+    void ThreadPool::_push(std::function<void()> task)
+    {
+        pool_param_t *p = (pool_param_t *)_param;
+        int id = _tls_pool == p ? _tls_worker : (int)(p->next++ % p->workers.size());
+        Worker *w = p->workers[id];
+        {
+            std::lock_guard<std::mutex> lock(w->lock);
+            w->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(p->mutex);
+            ++p->pending;
+        }
+        p->cond.notify_one();
+    }
+
+    void ThreadPool::parallel_for(int begin, int end, const std::function<void(int, int)> &func, int grain, int num_threads)
+    {
+        int n = end - begin;
+        if (n <= 0)
+            return;
+        if (grain < 1)
+            grain = 1;
+        if (num_threads <= 0)
+            num_threads = parallel_threads();
+        num_threads = std::min(num_threads, size() + 1);
+        int max_chunks = (n + grain - 1) / grain;
+        if (num_threads <= 1 || max_chunks <= 1)
+        {
+            func(begin, end);
+            return;
+        }
+        // a few chunks per thread, so threads slowed down by other tasks or interrupts take less chunks
+        int chunks = std::min(max_chunks, num_threads * 4);
+        int chunk = ((n + chunks - 1) / chunks + grain - 1) / grain * grain;
+        chunks = (n + chunk - 1) / chunk;
+
+        std::shared_ptr<ParallelJob> job = std::make_shared<ParallelJob>();
+        job->begin = begin;
+        job->end = end;
+        job->chunk = chunk;
+        job->chunks = chunks;
+        job->func = &func;
+        int helpers = std::min(num_threads, chunks) - 1;
+        for (int i = 0; i < helpers; ++i)
+            _push([job]() { job->run(); });
+        job->run();
+        if (job->done < chunks)
+        {
+            std::unique_lock<std::mutex> lock(job->mutex);
+            job->cond.wait(lock, [&job, chunks]() { return job->done >= chunks; });
+        }
+        if (job->error)
+            std::rethrow_exception(job->error);
+    }
+
+    static void _delete_pool(thread::ThreadPool *pool)
+    {
+        // last user is a task running in this pool, worker can't join itself, so delete in another thread
+        if (_tls_pool_obj == pool)
+        {
+            std::thread([pool]() { delete pool; }).detach();
+            return;
+        }
+        delete pool;
+    }
+
+    static std::shared_ptr<thread::ThreadPool> _shared_pool()
+    {
+        std::lock_guard<std::mutex> lock(_pool_mutex);
+        if (!_pool)
+            _pool = std::shared_ptr<thread::ThreadPool>(new thread::ThreadPool(), _delete_pool);
+        return _pool;
+    }
+
+    thread::ThreadPool &pool()
+    {
+        return *_shared_pool();
+    }
+
+    void config_pool(int num_threads, const std::vector<int> &cpus, int priority)
+    {
+        std::shared_ptr<thread::ThreadPool> old;
+        {
+            std::lock_guard<std::mutex> lock(_pool_mutex);
+            old = _pool;
+            _pool = std::shared_ptr<thread::ThreadPool>(new thread::ThreadPool(num_threads, cpus, priority), _delete_pool);
+        }
+        // parallel_for calls running in old pool hold it, it's deleted after the last one returns,
+        // and queued tasks of old pool may use pool(), so release it without lock
+        old.reset();
+    }
+
+    void set_parallel_threads(int num, bool current_thread_only)
+    {
+        if (num < 0)
+            num = 0;
+        if (current_thread_only)
+            _tls_parallel_threads = num;
+        else
+            _parallel_threads = num;
+    }
+
+    int parallel_threads()
+    {
+        static const int cores = cpu_count();
+        if (_tls_parallel_threads > 0)
+            return _tls_parallel_threads;
+        int num = _parallel_threads;
+        return num > 0 ? num : cores;
+    }
+
+    void parallel_for(int begin, int end, const std::function<void(int, int)> &func, int grain, int num_threads)
+    {
+        // run in caller thread directly if no need to split, so single core devices never create the pool
+        if (num_threads <= 0)
+            num_threads = parallel_threads();
+        if (end - begin <= std::max(grain, 1) || num_threads <= 1)
+        {
+            if (end > begin)
+                func(begin, end);
+            return;
+        }
+        // hold the pool, config_pool may replace it meanwhile
+        std::shared_ptr<thread::ThreadPool> p = _shared_pool();
+        p->parallel_for(begin, end, func, grain, num_threads);
+    }
+} // namespace maix::thread
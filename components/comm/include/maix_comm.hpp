@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Support tcp and unix socket method, reply to the connection request come from, report to all connections.
  */
 
 
@@ -11,10 +12,12 @@
 #include <stdint.h>
 #include <tuple>
 #include <string>
+#include <map>
 #include "maix_type.hpp"
 #include "maix_err.hpp"
 #include "maix_protocol.hpp"
 #include "maix_comm_base.hpp"
+#include "maix_comm_socket.hpp"
 
 namespace maix
 {
@@ -31,21 +34,35 @@ namespace maix
         {
         public:
             /**
-             * Construct a new CommProtocol object
+             * Construct a new CommProtocol object, communication method is decided by system config comm.method,
+             * support "uart", "tcp"(server, port is config comm.tcp_port, default 5555)
+             * and "unix"(unix domain socket server, path is config comm.unix_path, default /tmp/maix_comm.sock).
              * @param buff_size buffer size, default to 1024 bytes
              * @maixpy maix.comm.CommProtocol.__init__
              * @maixcdk maix.comm.CommProtocol.CommProtocol
              */
             CommProtocol(int buff_size = 1024, uint32_t header=maix::protocol::HEADER);
+
+            /**
+             * Construct a new CommProtocol object with communication object
+             * @param comm communication object, will be opened if not opened, not deleted by CommProtocol.
+             * @param buff_size buffer size of each connection, default to 1024 bytes
+             * @maixcdk maix.comm.CommProtocol.CommProtocol
+             */
+            CommProtocol(CommBase *comm, int buff_size = 1024, uint32_t header=maix::protocol::HEADER);
             ~CommProtocol();
 
             /**
-             * Read data to buffer, and try to decode it as maix.protocol.MSG object
+             * Read data to buffer, and try to decode it as maix.protocol.MSG object.
+             * Data of every connection is decoded separately, resp_ok and resp_err will send to the connection of the last got message,
+             * report will send to all connections.
+             * @param timeout unit ms, 0 means return immediately, -1 means block until valid frame got,
+             *                >0 means block until valid frame got or timeout. default 0.
              * @return decoded data, if nullptr, means no valid frame found.
              *         Attentioin, delete it after use in C++.
              * @maixpy maix.comm.CommProtocol.get_msg
              */
-            protocol::MSG *get_msg();
+            protocol::MSG *get_msg(int timeout = 0);
 
             /**
              * Send response ok(success) message
@@ -81,7 +98,8 @@ namespace maix
             err::Err resp_ok(uint8_t cmd, Bytes *body = nullptr);
 
             /**
-             * Send report message
+             * Send report message to all connections, e.g. all clients of tcp or unix socket.
+             * Sent in caller thread, a socket client not receiving data blocks it up to 1s, then the client is closed.
              * @param buff output buffer
              * @param buff_len output buffer length
              * @param cmd CMD value
@@ -93,7 +111,8 @@ namespace maix
             err::Err report(uint8_t *buff, int buff_len, uint8_t cmd, uint8_t *body = nullptr, int body_len = 0);
 
             /**
-             * Send report message
+             * Send report message to all connections, e.g. all clients of tcp or unix socket.
+             * Sent in caller thread, a socket client not receiving data blocks it up to 1s, then the client is closed.
              * @param cmd CMD value
              * @param body report body, can be null
              * @param body_len report body length, can be 0
@@ -104,7 +123,8 @@ namespace maix
             err::Err report(uint8_t cmd, uint8_t *body = nullptr, int body_len = 0);
 
             /**
-             * Send report message
+             * Send report message to all connections, e.g. all clients of tcp or unix socket.
+             * Sent in caller thread, a socket client not receiving data blocks it up to 1s, then the client is closed.
              * @param cmd CMD value
              * @param body report body, can be null
              * @return encoded data, if nullptr, means error, and the error code is -err.Err.
@@ -143,9 +163,18 @@ namespace maix
             protocol::Protocol *_p;
             std::string _comm_method;
             CommBase *_comm;
+            bool      _own_comm;
             CommBase *_get_comm_obj(const std::string &method);
             uint8_t  *_tmp_buff;
             int       _tmp_buff_len;
+            int       _buff_size;
+            uint32_t  _header;
+            std::map<int, protocol::Protocol *> _conn_p;  // decoder of each connection, connection 0 use _p
+            int       _conn;                              // connection of last message
+            int       _write(const uint8_t *data, int len, bool to_all = false);
+            protocol::Protocol *_decoder(int conn);
+            protocol::MSG *_decode_msg(int wait);
+            void      _init(int buff_size, uint32_t header);
         };
     } // namespace comm
 } // namespace maix
@@ -0,0 +1,121 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "maix_type.hpp"
+#include "maix_err.hpp"
+#include "maix_comm_base.hpp"
+
+namespace maix::comm
+{
+    /**
+     * TCP or Unix domain socket server, accept multiple clients.
+     * One event loop thread accepts clients and receives data of all clients into per client ring buffer by vectored read,
+     * read_conn get data of one client, write_conn send to the client the data come from.
+     * write and read without connection id means all clients(write) or any client(read).
+     * @maixcdk maix.comm.SocketServer
+     */
+    class SocketServer : public CommBase
+    {
+    public:
+        /**
+         * Construct a new SocketServer object, you need to call open() to start it.
+         * @param type "tcp" or "unix"
+         * @param addr for tcp, "ip:port", e.g. "0.0.0.0:5555", ip can be omitted, e.g. ":5555".
+         *             for unix, socket file path, e.g. "/tmp/maix_comm.sock".
+         * @param max_clients max clients number, new clients will be closed when reach this limit.
+         * @param buff_size receive buffer size of each client, data of client will not be read when buffer full.
+         * @maixcdk maix.comm.SocketServer.SocketServer
+         */
+        SocketServer(const std::string &type, const std::string &addr, int max_clients = 16, int buff_size = 65536);
+        ~SocketServer();
+
+        /**
+         * Start listen and event loop, if already opened, do nothing and return err.ERR_NONE.
+         * @return open error code, err.Err type.
+         * @maixcdk maix.comm.SocketServer.open
+         */
+        err::Err open();
+
+        /**
+         * Stop event loop and close all connections.
+         * @return err.Err type.
+         * @maixcdk maix.comm.SocketServer.close
+         */
+        err::Err close();
+
+        /**
+         * Check if opened
+         * @maixcdk maix.comm.SocketServer.is_open
+         */
+        bool is_open();
+
+        /**
+         * Send data to all clients one by one in caller thread, @see write_conn
+         * @return sent data length, < 0 means error, value is -err.Err.
+         * @maixcdk maix.comm.SocketServer.write
+         */
+        int write(const uint8_t *buff, int len);
+
+        /**
+         * Send data to all clients one by one in caller thread, @see write_conn
+         * @return sent data length, < 0 means error, value is -err.Err.
+         * @maixcdk maix.comm.SocketServer.write
+         */
+        int write(Bytes &data);
+
+        /**
+         * Receive data from any client, @see read_conn
+         * @param recv_len only support -1, means read received data.
+         * @maixcdk maix.comm.SocketServer.read
+         */
+        int read(uint8_t *buff, int buff_len, int recv_len = -1, int timeout = 0);
+
+        /**
+         * Receive data from any client, @see read_conn
+         * @maixcdk maix.comm.SocketServer.read
+         */
+        Bytes *read(int len = -1, int timeout = 0);
+
+        /**
+         * Receive data from one client, clients with data are served in turn.
+         * @param conn output, client connection id
+         * @param buff data buffer to store received data
+         * @param buff_len data buffer length
+         * @param timeout unit ms, 0 means return immediately, -1 means block until data received, >0 means block until data received or timeout.
+         * @return received data length, < 0 means error, value is -err.Err,
+         *         -err.ERR_NOT_OPEN with conn >= 0 means this client disconnected and all its data have been read.
+         * @maixcdk maix.comm.SocketServer.read_conn
+         */
+        int read_conn(int *conn, uint8_t *buff, int buff_len, int timeout);
+
+        /**
+         * Send data to one client, block until all data sent or 1s timeout, client failed to send is closed.
+         * When send to all clients, clients are sent one by one, so a client not receiving data delays others up to 1s.
+         * @param conn client connection id got from read_conn, -1 means all clients.
+         * @return sent data length, < 0 means error, value is -err.Err.
+         * @maixcdk maix.comm.SocketServer.write_conn
+         */
+        int write_conn(int conn, const uint8_t *buff, int len);
+
+        /**
+         * Connected clients number
+         * @maixcdk maix.comm.SocketServer.client_count
+         */
+        int client_count();
+
+    private:
+        std::string _type;
+        std::string _addr;
+        int _max_clients;
+        int _buff_size;
+        void *_param;
+    };
+} // namespace maix::comm
@@ -3,6 +3,8 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Support tcp and unix socket method, decode every connection separately, report to all connections.
+ * @update 2026.10.18: Add CMD_SYS_METRICS.
  */
 
 
@@ -30,6 +32,16 @@ namespace maix::comm
             }
             return new uart::UART(ports[ports.size() - 1], 115200);
         }
+        else if(method == "tcp")
+        {
+            std::string port = app::get_sys_config_kv("comm", "tcp_port", "5555");
+            return new SocketServer("tcp", ":" + port);
+        }
+        else if(method == "unix")
+        {
+            std::string path = app::get_sys_config_kv("comm", "unix_path", "/tmp/maix_comm.sock");
+            return new SocketServer("unix", path);
+        }
         else
         {
             log::error("not support comm method: %s\n", method.c_str());
@@ -37,43 +49,89 @@ namespace maix::comm
         }
     }
 
-    CommProtocol::CommProtocol(int buff_size, uint32_t header)
+    void CommProtocol::_init(int buff_size, uint32_t header)
     {
-        _tmp_buff_len = 128;
+        // socket may receive a lot of data at once, read it with less system calls
+        _tmp_buff_len = 4096;
         _tmp_buff = new uint8_t[_tmp_buff_len];
-        if(!_tmp_buff)
-        {
-            throw std::bad_alloc();
-        }
+        _buff_size = buff_size;
+        _header = header;
+        _conn = 0;
         _p = new protocol::Protocol(buff_size, header);
+    }
+
+    CommProtocol::CommProtocol(int buff_size, uint32_t header)
+    {
+        _init(buff_size, header);
+        _own_comm = true;
         _comm_method = app::get_sys_config_kv("comm", "method", "uart");
         _comm = _get_comm_obj(_comm_method);
         if(!_comm)
         {
-            log::error("get comm object %d failed\n", _comm_method.c_str());
+            log::error("get comm object %s failed\n", _comm_method.c_str());
             throw std::runtime_error("get comm object failed");
         }
         err::Err e = _comm->open();
         if(e != err::ERR_NONE)
         {
-            log::error("open comm object %d failed: %d\n", _comm_method.c_str(), e);
+            log::error("open comm object %s failed: %d\n", _comm_method.c_str(), e);
             throw std::runtime_error("open comm object failed");
         }
     }
 
+    CommProtocol::CommProtocol(CommBase *comm, int buff_size, uint32_t header)
+    {
+        if(!comm)
+            throw err::Exception(err::ERR_ARGS, "comm object is null");
+        _init(buff_size, header);
+        _own_comm = false;
+        _comm = comm;
+        if(!_comm->is_open())
+        {
+            err::Err e = _comm->open();
+            if(e != err::ERR_NONE)
+            {
+                delete _p;
+                delete[] _tmp_buff;
+                throw err::Exception(e, "open comm object failed");
+            }
+        }
+    }
+
     CommProtocol::~CommProtocol()
     {
-        if(_comm)
+        if(_comm && _own_comm)
         {
             _comm->close();
             delete _comm;
-            _comm = nullptr;
         }
+        _comm = nullptr;
         if(_tmp_buff)
         {
-            delete _tmp_buff;
+            delete[] _tmp_buff;
             _tmp_buff = nullptr;
         }
+        for(auto &it : _conn_p)
+            delete it.second;
+        _conn_p.clear();
+        delete _p;
+    }
+
+    protocol::Protocol *CommProtocol::_decoder(int conn)
+    {
+        if(conn == 0)
+            return _p;
+        auto it = _conn_p.find(conn);
+        if(it != _conn_p.end())
+            return it->second;
+        protocol::Protocol *p = new protocol::Protocol(_buff_size, _header);
+        _conn_p[conn] = p;
+        return p;
+    }
+
+    int CommProtocol::_write(const uint8_t *data, int len, bool to_all)
+    {
+        return _comm->write_conn(to_all ? -1 : _conn, data, len);
     }
 
     static std::vector<std::string> find_string(char* data, uint32_t data_len, uint32_t try_find_cnt=0)
@@ -324,6 +382,38 @@ namespace maix::comm
             delete[] buff;
             break;
         }
+        case maix::protocol::CMD_SYS_METRICS: {
+            // request body: samples number(1B), empty means 1, response from old to new, see protocol doc
+            int num = msg->body_len > 0 ? msg->body[0] : 1;
+            std::vector<sys::Metrics> samples = sys::metrics_sampler()->history(num);
+            std::vector<uint8_t> buff;
+            buff.reserve(1 + samples.size() * (25 + sys::METRICS_MAX_CORES * 2));
+            auto put = [&buff](uint32_t v, int bytes) {
+                for (int i = 0; i < bytes; ++i)
+                    buff.push_back((v >> (i * 8)) & 0xFF);
+            };
+            put(samples.size(), 1);
+            for (auto &m : samples)
+            {
+                put((uint32_t)m.timestamp, 4);
+                put((uint32_t)(m.cpu * 100), 2);
+                put(m.core_num, 1);
+                for (int i = 0; i < m.core_num; ++i)
+                    put((uint32_t)(m.cores[i] * 100), 2);
+                put((uint32_t)(m.mem_total / 1024), 4);
+                put((uint32_t)(m.mem_used / 1024), 4);
+                put((uint32_t)(int16_t)(m.temp * 100), 2);
+                put((uint32_t)(m.rss / 1024), 4);
+                put(m.threads, 2);
+            }
+            auto resp_ret = this->resp_ok(maix::protocol::CMD_SYS_METRICS, buff.data(), buff.size());
+            if (resp_ret != err::Err::ERR_NONE) {
+                log::error("[%s:%d] resp_ok failed, code = %u",
+                    __PRETTY_FUNCTION__, __LINE__, (uint8_t)resp_ret);
+            }
+            msg->has_been_replied = true;
+            break;
+        }
         case maix::protocol::CMD_KEY:
         case maix::protocol::CMD_TOUCH:
         case maix::protocol::CMD_SET_REPORT:
@@ -337,26 +427,68 @@ namespace maix::comm
         log::info("[%s:%d] Finish...", __PRETTY_FUNCTION__, __LINE__);
     }
 
-    protocol::MSG *CommProtocol::get_msg()
+    protocol::MSG *CommProtocol::_decode_msg(int wait)
     {
         protocol::MSG *msg = nullptr;
         int rx_len = 0;
         while(1)
         {
-            rx_len = _comm->read(_tmp_buff, _tmp_buff_len, -1, 0);
+            int conn = 0;
+            rx_len = _comm->read_conn(&conn, _tmp_buff, _tmp_buff_len, wait);
+            wait = 0;
             if(rx_len == 0)
             {
                 break;
             }
+            else if(rx_len == -err::ERR_NOT_OPEN && conn > 0)
+            {
+                // connection closed, drop its data
+                auto it = _conn_p.find(conn);
+                if(it != _conn_p.end())
+                {
+                    delete it->second;
+                    _conn_p.erase(it);
+                }
+                continue;
+            }
             else if(rx_len < 0)
             {
                 log::error("read error: %d, %s\n", -rx_len, err::to_str((err::Err)-rx_len).c_str());
                 time::sleep_ms(10);
                 break;
             }
-            _p->push_data(_tmp_buff, rx_len);
+            if(_decoder(conn)->push_data(_tmp_buff, rx_len) != err::ERR_NONE)
+                log::warn("connection %d buffer full, drop %d bytes\n", conn, rx_len);
         }
+        // connection 0 is single connection device, others are clients of socket server
+        _conn = 0;
         msg = _p->decode(nullptr, 0);
+        for(auto it = _conn_p.begin(); !msg && it != _conn_p.end(); ++it)
+        {
+            msg = it->second->decode(nullptr, 0);
+            if(msg)
+                _conn = it->first;
+        }
+        return msg;
+    }
+
+    protocol::MSG *CommProtocol::get_msg(int timeout)
+    {
+        uint64_t t = time::ticks_ms();
+        protocol::MSG *msg = _decode_msg(0);
+        // wait data in comm object instead of sleep to get message as soon as possible
+        while(!msg && timeout != 0 && !app::need_exit())
+        {
+            int wait = 100;
+            if(timeout > 0)
+            {
+                int remain = timeout - (int)(time::ticks_ms() - t);
+                if(remain <= 0)
+                    break;
+                wait = std::min(wait, remain);
+            }
+            msg = _decode_msg(wait);
+        }
         if (nullptr != msg)
             this->execute_cmd(msg);
         return msg;
@@ -369,7 +501,7 @@ namespace maix::comm
         {
             return (err::Err)-len;
         }
-        len = _comm->write(buff, len);
+        len = _write(buff, len);
         if(len < 0)
         {
             return (err::Err)-len;
@@ -384,7 +516,7 @@ namespace maix::comm
         {
             return err::ERR_RUNTIME;
         }
-        int len = _comm->write(buff->data, buff->size());
+        int len = _write(buff->data, buff->size());
         delete buff;
         if(len < 0)
         {
@@ -400,7 +532,7 @@ namespace maix::comm
         {
             return err::ERR_RUNTIME;
         }
-        int len = _comm->write(buff->data, buff->size());
+        int len = _write(buff->data, buff->size());
         delete buff;
         if(len < 0)
         {
@@ -416,7 +548,7 @@ namespace maix::comm
         {
             return (err::Err)-len;
         }
-        len = _comm->write(buff, len);
+        len = _write(buff, len, true);
         if(len < 0)
         {
             return (err::Err)-len;
@@ -431,7 +563,7 @@ namespace maix::comm
         {
             return err::ERR_RUNTIME;
         }
-        int len = _comm->write(buff->data, buff->size());
+        int len = _write(buff->data, buff->size(), true);
         delete buff;
         if(len < 0)
         {
@@ -447,7 +579,7 @@ namespace maix::comm
         {
             return err::ERR_RUNTIME;
         }
-        int len = _comm->write(buff->data, buff->size());
+        int len = _write(buff->data, buff->size(), true);
         delete buff;
         if(len < 0)
         {
@@ -463,7 +595,7 @@ namespace maix::comm
         {
             return (err::Err)-len;
         }
-        len = _comm->write(buff, len);
+        len = _write(buff, len);
         if(len < 0)
         {
             return (err::Err)-len;
@@ -478,7 +610,7 @@ namespace maix::comm
         {
             return err::ERR_RUNTIME;
         }
-        int len = _comm->write(buff->data, buff->size());
+        int len = _write(buff->data, buff->size());
         delete buff;
         if(len < 0)
         {
@@ -0,0 +1,533 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#include "maix_comm_socket.hpp"
+#include "maix_basic.hpp"
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace maix::comm
+{
+    /**
+     * One client, rx ring buffer is written by event loop and read by read_conn,
+     * fd is closed when the last reference released, so write_conn can use it without lock.
+     */
+    typedef struct conn_s
+    {
+        int fd;
+        int id;
+        std::vector<uint8_t> ring;
+        int head;       // read position
+        int len;        // data length
+        bool queued;    // in ready queue
+        bool closed;    // peer closed or error, remove after data read
+        bool paused;    // EPOLLIN disabled because ring full
+        std::mutex write_lock;
+
+        ~conn_s()
+        {
+            if (fd >= 0)
+                ::close(fd);
+        }
+    } conn_t;
+
+    typedef std::shared_ptr<conn_t> conn_ptr;
+
+    typedef struct
+    {
+        int listen_fd;
+        int epoll_fd;
+        int event_fd;
+        std::thread *thread;
+        bool stop;
+        std::mutex lock;
+        std::condition_variable cond;
+        std::map<int, conn_ptr> conns;
+        std::deque<conn_ptr> ready;     // clients have data or closed, served in turn
+        int next_id;
+    } socket_param_t;
+
+    SocketServer::SocketServer(const std::string &type, const std::string &addr, int max_clients, int buff_size)
+    {
+        if (type != "tcp" && type != "unix")
+            throw err::Exception(err::ERR_ARGS, "socket type only support tcp and unix");
+        _type = type;
+        _addr = addr;
+        _max_clients = max_clients;
+        _buff_size = buff_size;
+        _param = nullptr;
+    }
+
+    SocketServer::~SocketServer()
+    {
+        close();
+    }
+
+    static int _listen(const std::string &type, const std::string &addr)
+    {
+        int fd = -1;
+        if (type == "tcp")
+        {
+            size_t pos = addr.rfind(':');
+            std::string ip = pos == std::string::npos ? "" : addr.substr(0, pos);
+            int port = atoi(pos == std::string::npos ? addr.c_str() : addr.c_str() + pos + 1);
+            struct sockaddr_in sa;
+            memset(&sa, 0, sizeof(sa));
+            sa.sin_family = AF_INET;
+            sa.sin_port = htons(port);
+            sa.sin_addr.s_addr = htonl(INADDR_ANY);
+            if (!ip.empty() && inet_pton(AF_INET, ip.c_str(), &sa.sin_addr) != 1)
+            {
+                log::error("invalid ip: %s\n", ip.c_str());
+                return -1;
+            }
+            fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0)
+                return -1;
+            int opt = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+            if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0)
+            {
+                log::error("bind %s failed: %s\n", addr.c_str(), strerror(errno));
+                ::close(fd);
+                return -1;
+            }
+        }
+        else
+        {
+            struct sockaddr_un sa;
+            memset(&sa, 0, sizeof(sa));
+            sa.sun_family = AF_UNIX;
+            if (addr.size() >= sizeof(sa.sun_path))
+            {
+                log::error("unix socket path too long: %s\n", addr.c_str());
+                return -1;
+            }
+            strcpy(sa.sun_path, addr.c_str());
+            unlink(addr.c_str());
+            fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0)
+                return -1;
+            if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0)
+            {
+                log::error("bind %s failed: %s\n", addr.c_str(), strerror(errno));
+                ::close(fd);
+                return -1;
+            }
+        }
+        if (listen(fd, 16) < 0)
+        {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    static void _set_events(socket_param_t *param, conn_t *c, bool in)
+    {
+        struct epoll_event ev;
+        ev.events = in ? EPOLLIN | EPOLLRDHUP : 0;
+        ev.data.u64 = c->id;
+        epoll_ctl(param->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+    }
+
+    // call with lock held
+    static void _mark_ready(socket_param_t *param, const conn_ptr &c)
+    {
+        if (!c->queued)
+        {
+            c->queued = true;
+            param->ready.push_back(c);
+            param->cond.notify_one();
+        }
+    }
+
+    // call with lock held
+    static void _remove_conn(socket_param_t *param, conn_ptr c)
+    {
+        epoll_ctl(param->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+        shutdown(c->fd, SHUT_RDWR);
+        c->closed = true;
+        param->conns.erase(c->id);
+        _mark_ready(param, c);
+    }
+
+    static void _accept(socket_param_t *param, bool tcp, int max_clients, int buff_size)
+    {
+        while (1)
+        {
+            int fd = accept4(param->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+                break;
+            std::lock_guard<std::mutex> lk(param->lock);
+            if ((int)param->conns.size() >= max_clients)
+            {
+                log::warn("socket server clients reach max %d, reject new client\n", max_clients);
+                ::close(fd);
+                continue;
+            }
+            if (tcp)
+            {
+                int opt = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+            }
+            conn_ptr c = std::make_shared<conn_t>();
+            c->fd = fd;
+            c->id = param->next_id++;
+            c->ring.resize(buff_size);
+            c->head = 0;
+            c->len = 0;
+            c->queued = false;
+            c->closed = false;
+            c->paused = false;
+            struct epoll_event ev;
+            ev.events = EPOLLIN | EPOLLRDHUP;
+            ev.data.u64 = c->id;
+            if (epoll_ctl(param->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+            {
+                c->fd = -1;
+                ::close(fd);
+                continue;
+            }
+            param->conns[c->id] = c;
+        }
+    }
+
+    /**
+     * read socket to free space of ring buffer, two segments at most, by one readv
+     */
+    static void _recv(socket_param_t *param, int id)
+    {
+        std::lock_guard<std::mutex> lk(param->lock);
+        auto it = param->conns.find(id);
+        if (it == param->conns.end())
+            return;
+        conn_ptr c = it->second;
+        int size = c->ring.size();
+        while (1)
+        {
+            int free_len = size - c->len;
+            if (free_len == 0)
+            {
+                // stop reading until read_conn take some data
+                c->paused = true;
+                _set_events(param, c.get(), false);
+                return;
+            }
+            int tail = c->head + c->len;
+            if (tail >= size)
+                tail -= size;
+            struct iovec iov[2];
+            int iov_num = 1;
+            iov[0].iov_base = c->ring.data() + tail;
+            iov[0].iov_len = std::min(free_len, size - tail);
+            if ((int)iov[0].iov_len < free_len)
+            {
+                iov[1].iov_base = c->ring.data();
+                iov[1].iov_len = free_len - iov[0].iov_len;
+                iov_num = 2;
+            }
+            ssize_t n = readv(c->fd, iov, iov_num);
+            if (n > 0)
+            {
+                c->len += n;
+                _mark_ready(param, c);
+                if (n < free_len)
+                    return; // all data read
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return;
+            if (n < 0 && errno == EINTR)
+                continue;
+            _remove_conn(param, c);
+            return;
+        }
+    }
+
+    static void _loop(socket_param_t *param, bool tcp, int max_clients, int buff_size)
+    {
+        struct epoll_event events[64];
+        while (!param->stop)
+        {
+            int n = epoll_wait(param->epoll_fd, events, 64, 500);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                log::error("epoll_wait failed: %s\n", strerror(errno));
+                break;
+            }
+            for (int i = 0; i < n; ++i)
+            {
+                int64_t id = (int64_t)events[i].data.u64;
+                if (id == -1)
+                    _accept(param, tcp, max_clients, buff_size);
+                else if (id == -2)
+                {
+                    uint64_t v;
+                    if (::read(param->event_fd, &v, sizeof(v)) < 0)
+                    {
+                        // nothing to do, only wake up
+                    }
+                }
+                else if (events[i].events & EPOLLIN)
+                    _recv(param, id); // read all data before handle peer close
+                else
+                {
+                    // EPOLLRDHUP without EPOLLIN, or error, EPOLLHUP and EPOLLERR are reported even paused
+                    std::lock_guard<std::mutex> lk(param->lock);
+                    auto it = param->conns.find(id);
+                    if (it != param->conns.end())
+                        _remove_conn(param, it->second);
+                }
+            }
+        }
+    }
+
+    err::Err SocketServer::open()
+    {
+        if (_param)
+            return err::ERR_NONE;
+        socket_param_t *param = new socket_param_t();
+        param->listen_fd = _listen(_type, _addr);
+        param->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        param->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (param->listen_fd < 0 || param->epoll_fd < 0 || param->event_fd < 0)
+        {
+            log::error("socket server open %s %s failed\n", _type.c_str(), _addr.c_str());
+            if (param->listen_fd >= 0)
+                ::close(param->listen_fd);
+            if (param->epoll_fd >= 0)
+                ::close(param->epoll_fd);
+            if (param->event_fd >= 0)
+                ::close(param->event_fd);
+            delete param;
+            return err::ERR_IO;
+        }
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = (uint64_t)-1;
+        epoll_ctl(param->epoll_fd, EPOLL_CTL_ADD, param->listen_fd, &ev);
+        ev.events = EPOLLIN;
+        ev.data.u64 = (uint64_t)-2;
+        epoll_ctl(param->epoll_fd, EPOLL_CTL_ADD, param->event_fd, &ev);
+        param->stop = false;
+        param->next_id = 1;
+        param->thread = new std::thread(_loop, param, _type == "tcp", _max_clients, _buff_size);
+        _param = param;
+        return err::ERR_NONE;
+    }
+
+    err::Err SocketServer::close()
+    {
+        socket_param_t *param = (socket_param_t *)_param;
+        if (!param)
+            return err::ERR_NONE;
+        param->stop = true;
+        uint64_t v = 1;
+        if (::write(param->event_fd, &v, sizeof(v)) < 0)
+        {
+            // epoll_wait will timeout
+        }
+        param->thread->join();
+        delete param->thread;
+        {
+            std::lock_guard<std::mutex> lk(param->lock);
+            param->conns.clear();
+            param->ready.clear();
+            param->cond.notify_all();
+        }
+        ::close(param->listen_fd);
+        ::close(param->epoll_fd);
+        ::close(param->event_fd);
+        if (_type == "unix")
+            unlink(_addr.c_str());
+        delete param;
+        _param = nullptr;
+        return err::ERR_NONE;
+    }
+
+    bool SocketServer::is_open()
+    {
+        return _param != nullptr;
+    }
+
+    int SocketServer::client_count()
+    {
+        socket_param_t *param = (socket_param_t *)_param;
+        if (!param)
+            return 0;
+        std::lock_guard<std::mutex> lk(param->lock);
+        return param->conns.size();
+    }
+
+    int SocketServer::read_conn(int *conn, uint8_t *buff, int buff_len, int timeout)
+    {
+        socket_param_t *param = (socket_param_t *)_param;
+        *conn = -1;
+        if (!param)
+            return -err::ERR_NOT_OPEN;
+        std::unique_lock<std::mutex> lk(param->lock);
+        if (param->ready.empty())
+        {
+            if (timeout == 0)
+                return 0;
+            auto pred = [param] { return !param->ready.empty() || param->stop; };
+            if (timeout < 0)
+                param->cond.wait(lk, pred);
+            else if (!param->cond.wait_for(lk, std::chrono::milliseconds(timeout), pred))
+                return 0;
+            if (param->ready.empty())
+                return 0;
+        }
+        conn_ptr c = param->ready.front();
+        param->ready.pop_front();
+        c->queued = false;
+        *conn = c->id;
+        if (c->len == 0)
+            return c->closed ? -err::ERR_NOT_OPEN : 0;
+        int size = c->ring.size();
+        int n = std::min(buff_len, c->len);
+        int first = std::min(n, size - c->head);
+        memcpy(buff, c->ring.data() + c->head, first);
+        if (n > first)
+            memcpy(buff + first, c->ring.data(), n - first);
+        c->head += n;
+        if (c->head >= size)
+            c->head -= size;
+        c->len -= n;
+        if (c->len == 0)
+            c->head = 0;
+        // left data or close event, serve other clients first
+        if (c->len > 0 || c->closed)
+            _mark_ready(param, c);
+        if (c->paused && !c->closed)
+        {
+            c->paused = false;
+            _set_events(param, c.get(), true);
+        }
+        return n;
+    }
+
+    static int _send_all(conn_t *c, const uint8_t *buff, int len)
+    {
+        std::lock_guard<std::mutex> lk(c->write_lock);
+        int sent = 0;
+        uint64_t t = time::ticks_ms();
+        while (sent < len)
+        {
+            ssize_t n = send(c->fd, buff + sent, len - sent, MSG_NOSIGNAL);
+            if (n > 0)
+            {
+                sent += n;
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                int left_ms = 1000 - (int)(time::ticks_ms() - t);
+                if (left_ms <= 0)
+                    return -err::ERR_TIMEOUT;
+                struct pollfd pfd = {c->fd, POLLOUT, 0};
+                poll(&pfd, 1, left_ms);
+                continue;
+            }
+            return -err::ERR_IO;
+        }
+        return sent;
+    }
+
+    int SocketServer::write_conn(int conn, const uint8_t *buff, int len)
+    {
+        socket_param_t *param = (socket_param_t *)_param;
+        if (!param)
+            return -err::ERR_NOT_OPEN;
+        std::vector<conn_ptr> targets;
+        {
+            std::lock_guard<std::mutex> lk(param->lock);
+            if (conn < 0)
+            {
+                for (auto &it : param->conns)
+                    targets.push_back(it.second);
+            }
+            else
+            {
+                auto it = param->conns.find(conn);
+                if (it == param->conns.end())
+                    return -err::ERR_NOT_OPEN;
+                targets.push_back(it->second);
+            }
+        }
+        int ret = len;
+        for (auto &c : targets)
+        {
+            int n = _send_all(c.get(), buff, len);
+            if (n < 0)
+            {
+                log::warn("socket client %d send failed: %s\n", c->id, err::to_str((err::Err)-n).c_str());
+                std::lock_guard<std::mutex> lk(param->lock);
+                if (param->conns.count(c->id))
+                    _remove_conn(param, c);
+                if (conn >= 0)
+                    ret = n;
+            }
+        }
+        return ret;
+    }
+
+    int SocketServer::write(const uint8_t *buff, int len)
+    {
+        return write_conn(-1, buff, len);
+    }
+
+    int SocketServer::write(Bytes &data)
+    {
+        return write_conn(-1, data.data, data.size());
+    }
+
+    int SocketServer::read(uint8_t *buff, int buff_len, int recv_len, int timeout)
+    {
+        if (recv_len != -1)
+            return -err::ERR_NOT_IMPL;
+        int conn;
+        int n = read_conn(&conn, buff, buff_len, timeout);
+        // closed client is not error for any client read
+        return n == -err::ERR_NOT_OPEN && conn >= 0 ? 0 : n;
+    }
+
+    Bytes *SocketServer::read(int len, int timeout)
+    {
+        int buff_len = len > 0 ? len : _buff_size;
+        Bytes *data = new Bytes(nullptr, buff_len);
+        int n = read(data->data, buff_len, -1, timeout);
+        if (n < 0)
+        {
+            delete data;
+            throw err::Exception((err::Err)-n, "socket server read failed");
+        }
+        data->data_len = n;
+        return data;
+    }
+} // namespace maix::comm
@@ -0,0 +1,604 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#pragma once
+#include "maix_basic.hpp"
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+namespace maix::nn
+{
+    /**
+     * Face feature gallery.
+     * Features are L2 normalized and stored in one aligned matrix, float32 or int8 quantized(4x smaller),
+     * search by batched dot product with top-k.
+     * When faces number >= ann_threshold, an IVF(inverted file) approximate index is built to search only part of the gallery.
+     * File saved by save can be loaded by mmap, no parse or copy needed when load.
+     * @maixcdk maix.nn.FaceGallery
+     */
+    class FaceGallery
+    {
+    public:
+        /**
+         * Constructor
+         * @param int8 store features as int8, default false(float32).
+         * @param ann_threshold build IVF approximate index when faces number >= this value, -1 means never, default 4096.
+         * @param ann_probe how many IVF lists to search, more lists more accurate but slower, default 8.
+         * @maixcdk maix.nn.FaceGallery.FaceGallery
+         */
+        FaceGallery(bool int8 = false, int ann_threshold = 4096, int ann_probe = 8)
+            : _int8(int8), _ann_threshold(ann_threshold), _ann_probe(ann_probe)
+        {
+        }
+
+        ~FaceGallery()
+        {
+            _release();
+        }
+
+        FaceGallery(const FaceGallery &) = delete;
+        FaceGallery &operator=(const FaceGallery &) = delete;
+
+        /**
+         * Change storage and index config, stored features will be converted.
+         * @maixcdk maix.nn.FaceGallery.config
+         */
+        void config(bool int8, int ann_threshold, int ann_probe)
+        {
+            _ann_threshold = ann_threshold;
+            _ann_probe = ann_probe > 0 ? ann_probe : 1;
+            _index_dirty = true;
+            if (int8 == _int8)
+                return;
+            if (_count == 0)
+            {
+                _int8 = int8;
+                _release();
+                return;
+            }
+            std::vector<float> all((size_t)_count * _dim);
+            for (int i = 0; i < _count; ++i)
+                _get_row(i, all.data() + (size_t)i * _dim);
+            int count = _count, dim = _dim;
+            _release();
+            _int8 = int8;
+            for (int i = 0; i < count; ++i)
+                add(all.data() + (size_t)i * dim, dim);
+        }
+
+        /**
+         * Faces number
+         * @maixcdk maix.nn.FaceGallery.size
+         */
+        int size()
+        {
+            return _count;
+        }
+
+        /**
+         * Feature length
+         * @maixcdk maix.nn.FaceGallery.dim
+         */
+        int dim()
+        {
+            return _dim;
+        }
+
+        /**
+         * Is int8 storage
+         * @maixcdk maix.nn.FaceGallery.is_int8
+         */
+        bool is_int8()
+        {
+            return _int8;
+        }
+
+        /**
+         * Add one feature, will be normalized.
+         * @return err::ERR_ARGS if len not match features already added.
+         * @maixcdk maix.nn.FaceGallery.add
+         */
+        err::Err add(const float *feature, int len)
+        {
+            if (len <= 0 || (_count > 0 && len != _dim))
+            {
+                log::error("feature length %d not match gallery's %d", len, _dim);
+                return err::ERR_ARGS;
+            }
+            if (_count == 0 && _dim != len)
+            {
+                _release();
+                _dim = len;
+                _dim_pad = (len + 15) & ~15;
+            }
+            err::Err e = _reserve(_count + 1);
+            if (e != err::ERR_NONE)
+                return e;
+            std::vector<float> norm(_dim_pad, 0);
+            _normalize(feature, norm.data());
+            _set_row(_count, norm.data());
+            ++_count;
+            if (_index_built && !_index_dirty)
+                _lists[_nearest_list(norm.data())].push_back(_count - 1);
+            return err::ERR_NONE;
+        }
+
+        /**
+         * Remove one feature
+         * @maixcdk maix.nn.FaceGallery.remove
+         */
+        err::Err remove(int idx)
+        {
+            if (idx < 0 || idx >= _count)
+                return err::ERR_ARGS;
+            if (_detach() != err::ERR_NONE)
+                return err::ERR_NO_MEM;
+            size_t row = _row_bytes();
+            memmove(_data + idx * row, _data + (idx + 1) * row, (_count - idx - 1) * row);
+            if (_int8)
+                memmove(_scales + idx, _scales + idx + 1, (_count - idx - 1) * sizeof(float));
+            --_count;
+            _index_dirty = true;
+            return err::ERR_NONE;
+        }
+
+        /**
+         * Remove all features
+         * @maixcdk maix.nn.FaceGallery.clear
+         */
+        void clear()
+        {
+            _release();
+        }
+
+        /**
+         * Get normalized feature
+         * @maixcdk maix.nn.FaceGallery.get
+         */
+        std::vector<float> get(int idx)
+        {
+            std::vector<float> out;
+            if (idx < 0 || idx >= _count)
+                return out;
+            out.resize(_dim);
+            _get_row(idx, out.data());
+            return out;
+        }
+
+        /**
+         * Search top k most similar features
+         * @param feature feature to search, not need normalized.
+         * @param k max result number.
+         * @param ids result index of features, sorted by similarity from high to low.
+         * @param scores cosine similarity of results, from -1 to 1.
+         * @return result number.
+         * @maixcdk maix.nn.FaceGallery.search
+         */
+        int search(const float *feature, int len, int k, std::vector<int> &ids, std::vector<float> &scores)
+        {
+            ids.clear();
+            scores.clear();
+            if (_count == 0 || len != _dim || k <= 0)
+                return 0;
+            std::vector<float> query(_dim_pad, 0);
+            _normalize(feature, query.data());
+            std::vector<int8_t> query_q;
+            float query_scale = 0;
+            if (_int8)
+            {
+                query_q.resize(_dim_pad);
+                query_scale = _quantize(query.data(), query_q.data());
+            }
+            // min heap of top k
+            std::vector<std::pair<float, int>> heap;
+            auto push = [&](int i) {
+                float s = _int8 ? _dot_int8(query_q.data(), (const int8_t *)(_data + i * _row_bytes()), _dim_pad) * query_scale * _scales[i]
+                                : _dot_f32(query.data(), (const float *)(_data + i * _row_bytes()), _dim_pad);
+                if ((int)heap.size() < k)
+                {
+                    heap.push_back({s, i});
+                    std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<float, int>>());
+                }
+                else if (s > heap.front().first)
+                {
+                    std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<float, int>>());
+                    heap.back() = {s, i};
+                    std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<float, int>>());
+                }
+            };
+            if (_ann_threshold > 0 && _count >= _ann_threshold)
+            {
+                if (!_index_built || _index_dirty)
+                    _build_index();
+                int nlist = _lists.size();
+                std::vector<std::pair<float, int>> list_scores(nlist);
+                for (int l = 0; l < nlist; ++l)
+                    list_scores[l] = {_dot_f32(query.data(), _centroids.data() + (size_t)l * _dim_pad, _dim_pad), l};
+                int probe = std::min(_ann_probe, nlist);
+                std::partial_sort(list_scores.begin(), list_scores.begin() + probe, list_scores.end(), std::greater<std::pair<float, int>>());
+                for (int p = 0; p < probe; ++p)
+                {
+                    for (int i : _lists[list_scores[p].second])
+                        push(i);
+                }
+            }
+            else
+            {
+                for (int i = 0; i < _count; ++i)
+                    push(i);
+            }
+            std::sort(heap.begin(), heap.end(), std::greater<std::pair<float, int>>());
+            for (auto &it : heap)
+            {
+                ids.push_back(it.second);
+                scores.push_back(it.first);
+            }
+            return ids.size();
+        }
+
+        /**
+         * Save gallery and labels to file, file can be loaded by mmap.
+         * @maixcdk maix.nn.FaceGallery.save
+         */
+        err::Err save(const std::string &path, const std::vector<std::string> &labels)
+        {
+            fs::File *f = fs::open(path, "w");
+            if (!f)
+                return err::ERR_IO;
+            _file_header_t header;
+            memset(&header, 0, sizeof(header));
+            memcpy(header.magic, "MXFG", 4);
+            header.version = FILE_VERSION;
+            header.dim = _dim;
+            header.dim_pad = _dim_pad;
+            header.count = _count;
+            header.int8 = _int8;
+            header.data_offset = sizeof(header);
+            header.scales_offset = header.data_offset + (uint64_t)_count * _row_bytes();
+            header.labels_offset = header.scales_offset + (_int8 ? _count * sizeof(float) : 0);
+            int ret = f->write(&header, sizeof(header));
+            if (_count > 0)
+            {
+                ret = ret < 0 ? ret : f->write(_data, _count * _row_bytes());
+                if (_int8)
+                    ret = ret < 0 ? ret : f->write(_scales, _count * sizeof(float));
+            }
+            for (int i = 0; i < _count && ret >= 0; ++i)
+            {
+                const std::string &label = (size_t)i < labels.size() ? labels[i] : std::string();
+                uint16_t len = label.size();
+                ret = f->write(&len, 2);
+                if (ret >= 0 && len > 0)
+                    ret = f->write(label.c_str(), len);
+            }
+            f->flush();
+            f->close();
+            delete f;
+            return ret < 0 ? err::ERR_IO : err::ERR_NONE;
+        }
+
+        /**
+         * Load gallery and labels from file saved by save, features are used from mmap memory directly.
+         * @return err::ERR_ARGS if file is not gallery format, err::ERR_IO if read failed.
+         * @maixcdk maix.nn.FaceGallery.load
+         */
+        err::Err load(const std::string &path, std::vector<std::string> &labels)
+        {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return err::ERR_IO;
+            struct stat st;
+            if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(_file_header_t))
+            {
+                ::close(fd);
+                return err::ERR_ARGS;
+            }
+            void *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (map == MAP_FAILED)
+                return err::ERR_IO;
+            const _file_header_t *header = (const _file_header_t *)map;
+            uint64_t row = header->int8 ? header->dim_pad : header->dim_pad * sizeof(float);
+            bool valid = memcmp(header->magic, "MXFG", 4) == 0 && header->version == FILE_VERSION &&
+                         header->dim_pad >= header->dim && header->dim_pad % 16 == 0 &&
+                         header->data_offset % 16 == 0 && header->scales_offset % 4 == 0 &&
+                         header->scales_offset == header->data_offset + header->count * row &&
+                         header->labels_offset == header->scales_offset + (header->int8 ? header->count * sizeof(float) : 0) &&
+                         header->labels_offset <= (uint64_t)st.st_size;
+            if (!valid)
+            {
+                munmap(map, st.st_size);
+                return err::ERR_ARGS;
+            }
+            std::vector<std::string> names;
+            const uint8_t *p = (const uint8_t *)map + header->labels_offset;
+            const uint8_t *end = (const uint8_t *)map + st.st_size;
+            for (uint32_t i = 0; i < header->count; ++i)
+            {
+                uint16_t len;
+                if (p + 2 > end)
+                    break;
+                memcpy(&len, p, 2);
+                if (p + 2 + len > end)
+                    break;
+                names.push_back(std::string((const char *)p + 2, len));
+                p += 2 + len;
+            }
+            if (names.size() != header->count)
+            {
+                munmap(map, st.st_size);
+                return err::ERR_ARGS;
+            }
+            _release();
+            _map = map;
+            _map_len = st.st_size;
+            _int8 = header->int8;
+            _dim = header->dim;
+            _dim_pad = header->dim_pad;
+            _count = header->count;
+            _capacity = _count;
+            _data = (uint8_t *)map + header->data_offset;
+            _scales = _int8 ? (float *)((uint8_t *)map + header->scales_offset) : nullptr;
+            labels = names;
+            return err::ERR_NONE;
+        }
+
+    private:
+        enum
+        {
+            FILE_VERSION = 1
+        };
+        struct _file_header_t
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t dim;
+            uint32_t dim_pad;
+            uint32_t count;
+            uint32_t int8;
+            uint64_t data_offset;
+            uint64_t scales_offset;
+            uint64_t labels_offset;
+            uint8_t reserved[16];
+        };
+
+        typedef float _v4f __attribute__((vector_size(16)));
+        typedef int8_t _v16i8 __attribute__((vector_size(16)));
+        typedef int16_t _v16i16 __attribute__((vector_size(32)));
+        typedef int32_t _v8i32 __attribute__((vector_size(32)));
+        // load types, query and centroids are std::vector, only 8 bytes aligned on 32-bit ARM
+        typedef float _v4f_u __attribute__((vector_size(16), aligned(4), may_alias));
+        typedef int8_t _v16i8_u __attribute__((vector_size(16), aligned(1), may_alias));
+
+        bool _int8;
+        int _ann_threshold;
+        int _ann_probe;
+        int _dim = 0;
+        int _dim_pad = 0;
+        int _count = 0;
+        int _capacity = 0;
+        uint8_t *_data = nullptr;   // rows of _dim_pad float or int8, 16 bytes aligned
+        float *_scales = nullptr;   // int8 row scale
+        void *_map = nullptr;       // _data and _scales point to mmap memory if not null
+        size_t _map_len = 0;
+        bool _index_built = false;
+        bool _index_dirty = true;
+        std::vector<float> _centroids;
+        std::vector<std::vector<int>> _lists;
+
+        size_t _row_bytes()
+        {
+            return _int8 ? _dim_pad : _dim_pad * sizeof(float);
+        }
+
+        void _release()
+        {
+            if (_map)
+            {
+                munmap(_map, _map_len);
+                _map = nullptr;
+            }
+            else
+            {
+                free(_data);
+                free(_scales);
+            }
+            _data = nullptr;
+            _scales = nullptr;
+            _count = 0;
+            _capacity = 0;
+            _index_built = false;
+            _index_dirty = true;
+            _lists.clear();
+            _centroids.clear();
+        }
+
+        err::Err _reserve(int num)
+        {
+            if (num <= _capacity && !_map)
+                return err::ERR_NONE;
+            int capacity = std::max(num, _capacity * 2);
+            capacity = std::max(capacity, 16);
+            void *data = nullptr;
+            if (posix_memalign(&data, 64, capacity * _row_bytes()) != 0)
+                return err::ERR_NO_MEM;
+            float *scales = nullptr;
+            if (_int8)
+            {
+                scales = (float *)malloc(capacity * sizeof(float));
+                if (!scales)
+                {
+                    free(data);
+                    return err::ERR_NO_MEM;
+                }
+            }
+            if (_count > 0)
+            {
+                memcpy(data, _data, _count * _row_bytes());
+                if (_int8)
+                    memcpy(scales, _scales, _count * sizeof(float));
+            }
+            if (_map)
+            {
+                munmap(_map, _map_len);
+                _map = nullptr;
+            }
+            else
+            {
+                free(_data);
+                free(_scales);
+            }
+            _data = (uint8_t *)data;
+            _scales = scales;
+            _capacity = capacity;
+            return err::ERR_NONE;
+        }
+
+        /**
+         * copy mmap data to heap before modify
+         */
+        err::Err _detach()
+        {
+            return _map ? _reserve(_count) : err::ERR_NONE;
+        }
+
+        void _normalize(const float *feature, float *out)
+        {
+            double sum = 0;
+            for (int i = 0; i < _dim; ++i)
+                sum += feature[i] * feature[i];
+            float inv = sum > 0 ? 1.0 / sqrt(sum) : 0;
+            for (int i = 0; i < _dim; ++i)
+                out[i] = feature[i] * inv;
+        }
+
+        float _quantize(const float *in, int8_t *out)
+        {
+            float max = 0;
+            for (int i = 0; i < _dim; ++i)
+                max = std::max(max, fabsf(in[i]));
+            float scale = max > 0 ? max / 127 : 1;
+            for (int i = 0; i < _dim_pad; ++i)
+                out[i] = i < _dim ? (int8_t)lrintf(in[i] / scale) : 0;
+            return scale;
+        }
+
+        void _set_row(int idx, const float *norm)
+        {
+            uint8_t *row = _data + idx * _row_bytes();
+            if (_int8)
+                _scales[idx] = _quantize(norm, (int8_t *)row);
+            else
+                memcpy(row, norm, _dim_pad * sizeof(float));
+        }
+
+        void _get_row(int idx, float *out)
+        {
+            const uint8_t *row = _data + idx * _row_bytes();
+            for (int i = 0; i < _dim; ++i)
+                out[i] = _int8 ? ((const int8_t *)row)[i] * _scales[idx] : ((const float *)row)[i];
+        }
+
+        static float _dot_f32(const float *a, const float *b, int len)
+        {
+            _v4f s0 = {0, 0, 0, 0}, s1 = s0, s2 = s0, s3 = s0;
+            for (int i = 0; i < len; i += 16)
+            {
+                s0 += *(const _v4f_u *)(a + i) * *(const _v4f_u *)(b + i);
+                s1 += *(const _v4f_u *)(a + i + 4) * *(const _v4f_u *)(b + i + 4);
+                s2 += *(const _v4f_u *)(a + i + 8) * *(const _v4f_u *)(b + i + 8);
+                s3 += *(const _v4f_u *)(a + i + 12) * *(const _v4f_u *)(b + i + 12);
+            }
+            _v4f s = (s0 + s1) + (s2 + s3);
+            return s[0] + s[1] + s[2] + s[3];
+        }
+
+        static int32_t _dot_int8(const int8_t *a, const int8_t *b, int len)
+        {
+            _v8i32 sum = {0, 0, 0, 0, 0, 0, 0, 0};
+            for (int i = 0; i < len; i += 16)
+            {
+                _v16i16 prod = __builtin_convertvector(*(const _v16i8_u *)(a + i), _v16i16) * __builtin_convertvector(*(const _v16i8_u *)(b + i), _v16i16);
+                _v8i32 lo = __builtin_convertvector(__builtin_shufflevector(prod, prod, 0, 1, 2, 3, 4, 5, 6, 7), _v8i32);
+                _v8i32 hi = __builtin_convertvector(__builtin_shufflevector(prod, prod, 8, 9, 10, 11, 12, 13, 14, 15), _v8i32);
+                sum += lo + hi;
+            }
+            return sum[0] + sum[1] + sum[2] + sum[3] + sum[4] + sum[5] + sum[6] + sum[7];
+        }
+
+        int _nearest_list(const float *norm)
+        {
+            int best = 0;
+            float best_score = -2;
+            for (size_t l = 0; l < _lists.size(); ++l)
+            {
+                float s = _dot_f32(norm, _centroids.data() + l * _dim_pad, _dim_pad);
+                if (s > best_score)
+                {
+                    best_score = s;
+                    best = l;
+                }
+            }
+            return best;
+        }
+
+        /**
+         * spherical k-means, sqrt(count) lists
+         */
+        void _build_index()
+        {
+            int nlist = std::max(1, (int)sqrt((double)_count));
+            std::vector<float> rows((size_t)_count * _dim_pad, 0);
+            for (int i = 0; i < _count; ++i)
+                _get_row(i, rows.data() + (size_t)i * _dim_pad);
+            _centroids.assign((size_t)nlist * _dim_pad, 0);
+            for (int l = 0; l < nlist; ++l)
+                memcpy(_centroids.data() + (size_t)l * _dim_pad, rows.data() + (size_t)l * _count / nlist * _dim_pad, _dim_pad * sizeof(float));
+            std::vector<int> assign(_count, 0);
+            _lists.assign(nlist, std::vector<int>());
+            for (int iter = 0; iter < 10; ++iter)
+            {
+                bool changed = false;
+                for (int i = 0; i < _count; ++i)
+                {
+                    int l = _nearest_list(rows.data() + (size_t)i * _dim_pad);
+                    changed = changed || l != assign[i];
+                    assign[i] = l;
+                }
+                if (!changed && iter > 0)
+                    break;
+                std::fill(_centroids.begin(), _centroids.end(), 0);
+                for (int i = 0; i < _count; ++i)
+                {
+                    float *c = _centroids.data() + (size_t)assign[i] * _dim_pad;
+                    const float *r = rows.data() + (size_t)i * _dim_pad;
+                    for (int d = 0; d < _dim; ++d)
+                        c[d] += r[d];
+                }
+                for (int l = 0; l < nlist; ++l)
+                {
+                    float *c = _centroids.data() + (size_t)l * _dim_pad;
+                    double sum = 0;
+                    for (int d = 0; d < _dim; ++d)
+                        sum += c[d] * c[d];
+                    float inv = sum > 0 ? 1.0 / sqrt(sum) : 0;
+                    for (int d = 0; d < _dim; ++d)
+                        c[d] *= inv;
+                }
+            }
+            for (int i = 0; i < _count; ++i)
+                _lists[assign[i]].push_back(i);
+            _index_built = true;
+            _index_dirty = false;
+        }
+    };
+
+} // namespace maix::nn
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2024.5.17: Create this file.
+ * @update 2026.10.18: Store features in FaceGallery, features member is kept as a deprecated copy.
  */
 
 #pragma once
@@ -14,6 +15,7 @@
 #include <tuple>
 // #include "maix_nn_face_detector.hpp"
 #include "maix_nn_retinaface.hpp"
+#include "maix_nn_face_gallery.hpp"
 
 namespace maix::nn
 {
@@ -331,13 +333,13 @@ namespace maix::nn
                 // compare feature from DB
                 float max_score = 0;
                 int max_i = -1;
-                for (size_t i = 0; i < features.size(); ++i)
+                if (_gallery.search(feature, fea_len, 1, _search_ids, _search_scores) > 0)
                 {
-                    float score = _feature_compare(feature, features[i].data(), fea_len);
-                    if (score > max_score && score > compare_th)
+                    float score = 0.5 + 0.5 * _search_scores[0];
+                    if (score > compare_th)
                     {
                         max_score = score;
-                        max_i = i;
+                        max_i = _search_ids[0];
                     }
                 }
                 nn::Object &obj = objs->at(i);
@@ -372,8 +374,12 @@ namespace maix::nn
                 log::error("face no feature");
                 return err::ERR_ARGS;
             }
+            err::Err e = _gallery.add(face->feature.data(), face->feature.size());
+            if (e != err::ERR_NONE)
+                return e;
             labels.push_back(label);
-            features.push_back(face->feature);
+            if (_keep_features)
+                features.push_back(_gallery.get(_gallery.size() - 1));
             return err::ERR_NONE;
         }
 
@@ -394,17 +400,19 @@ namespace maix::nn
             {
                 for (size_t i = 0; i < labels.size(); ++i)
                 {
-                    if (labels[i] == label)
+                    if (i > 0 && labels[i] == label)
                     {
-                        idx = i;
+                        idx = i - 1;
                         break;
                     }
                 }
             }
-            if (idx >= 0 && (size_t)idx < features.size())
+            if (idx >= 0 && idx < _gallery.size())
             {
-                features.erase(features.begin() + idx);
+                _gallery.remove(idx);
                 labels.erase(labels.begin() + idx + 1);
+                if (idx < (int)features.size())
+                    features.erase(features.begin() + idx);
                 return err::ERR_NONE;
             }
             log::info("idx value error: %d", idx);
@@ -412,7 +420,8 @@ namespace maix::nn
         }
 
         /**
-         * Save faces info to a file
+         * Save faces info to a file, features are saved as the gallery storage(float32 or int8),
+         * the file can be mmap loaded by load_faces directly.
          * @param path where to save, string type.
          * @return err.Err type
          * @maixpy maix.nn.FaceRecognizer.save_faces
@@ -425,86 +434,59 @@ namespace maix::nn
             {
                 return e;
             }
-            fs::File *f = fs::open(path, "w");
-            if (!f)
-            {
-                return err::ERR_IO;
-            }
-            for (size_t i = 0; i < features.size(); ++i)
-            {
-                // name + \0 + fea_len(2B) + feature
-                f->write(labels[i + 1].c_str(), (int)labels[i + 1].size());
-                f->write("\0", 1);
-                uint16_t len = (uint16_t)features[i].size();
-                f->write(&len, 2);
-                f->write(features[i].data(), features[i].size() * sizeof(float));
-            }
-            f->flush();
-            f->close();
-            delete f;
-            return err::ERR_NONE;
+            std::vector<std::string> names(labels.begin() + 1, labels.end());
+            return _gallery.save(path, names);
         }
 
         /**
-         * Load faces info from a file
+         * Load faces info from a file, also support the old format file(label + feature list).
          * @param path from where to load, string type.
          * @return err::Err type
          * @maixpy maix.nn.FaceRecognizer.load_faces
          */
         err::Err load_faces(const std::string &path)
         {
-            // Open the file
-            fs::File *f = fs::open(path, "r");
-            if (!f)
+            std::vector<std::string> names;
+            err::Err e = _gallery.load(path, names);
+            if (e == err::ERR_NONE)
             {
-                return err::ERR_IO;
+                labels.clear();
+                labels.push_back("unknown");
+                labels.insert(labels.end(), names.begin(), names.end());
+                _sync_features();
+                return err::ERR_NONE;
             }
+            if (e != err::ERR_ARGS)
+                return e;
+            e = _load_faces_old(path);
+            _sync_features();
+            return e;
+        }
 
-            // Clear current data
-            features.clear();
-            labels.clear();
-            labels.push_back("unknown");
-
-            // Read from the file
-            while (!f->eof())
-            {
-                std::string label;
-                char ch;
-                // Read label until '\0'
-                while (f->read(&ch, 1) && ch != '\0')
-                {
-                    label += ch;
-                }
-
-                // Read the length of the feature vector
-                uint16_t len;
-                if (f->read(&len, 2) != 2)
-                {
-                    // Error handling if we cannot read length
-                    f->close();
-                    delete f;
-                    return err::ERR_IO;
-                }
-
-                // Read the feature vector
-                std::vector<float> feature(len);
-                if (f->read(feature.data(), len * sizeof(float)) != (int)(len * sizeof(float)))
-                {
-                    // Error handling if we cannot read feature data
-                    f->close();
-                    delete f;
-                    return err::ERR_IO;
-                }
-
-                // Add the data to the vectors
-                labels.push_back(label);
-                features.push_back(feature);
-            }
+        /**
+         * Set features storage and search method
+         * @param int8 store features as int8 to reduce memory to 1/4, a little accuracy loss, default false.
+         * @param ann_threshold use approximate index search when faces number >= this value, -1 means always search all faces, default 4096.
+         * @param ann_probe search how many index lists(sqrt(faces number) lists total) for approximate index, more lists more accurate but slower, default 8.
+         * @param keep_features keep the deprecated features member, a copy of all features, set false to save memory for large lib, default true.
+         * @maixpy maix.nn.FaceRecognizer.set_gallery
+         */
+        void set_gallery(bool int8 = false, int ann_threshold = 4096, int ann_probe = 8, bool keep_features = true)
+        {
+            _gallery.config(int8, ann_threshold, ann_probe);
+            _keep_features = keep_features;
+            _sync_features();
+        }
 
-            // Close the file and clean up
-            f->close();
-            delete f;
-            return err::ERR_NONE;
+        /**
+         * Get feature of face in lib
+         * @param idx index of face in lib, labels[idx + 1] is its label.
+         * @return normalized feature, empty if idx invalid.
+         * @maixpy maix.nn.FaceRecognizer.get_feature
+         */
+        std::vector<float> get_feature(int idx)
+        {
+            return _gallery.get(idx);
         }
 
         /**
@@ -579,8 +561,12 @@ namespace maix::nn
         std::vector<std::string> labels;
 
         /**
-         * features
+         * Deprecated, use get_feature instead.
+         * Normalized features of faces in lib, features[i] is the feature of labels[i + 1],
+         * it's only a copy of features in gallery, modify it will not affect recognize.
+         * Empty if set_gallery with keep_features false.
          * @maixpy maix.nn.FaceRecognizer.features
+         * :readonly
          */
         std::vector<std::vector<float>> features;
 
@@ -598,21 +584,73 @@ namespace maix::nn
         int _feature_input_size;
         bool _dual_buff;
         std::vector<int> _std_points;
+        FaceGallery _gallery;
+        std::vector<int> _search_ids;
+        std::vector<float> _search_scores;
+        bool _keep_features = true;
 
     private:
-        float _feature_compare(float *ftr0, float *ftr1, int len)
+        void _sync_features()
         {
-            double sumcorr = 0;
-            double sumftr0 = 0;
-            double sumftr1 = 0;
+            features.clear();
+            if (!_keep_features)
+                return;
+            features.reserve(_gallery.size());
+            for (int i = 0; i < _gallery.size(); ++i)
+                features.push_back(_gallery.get(i));
+        }
 
-            for (int i = 0; i < len; i++)
+        err::Err _load_faces_old(const std::string &path)
+        {
+            fs::File *f = fs::open(path, "r");
+            if (!f)
             {
-                sumftr0 += ftr0[i] * ftr0[i];
-                sumftr1 += ftr1[i] * ftr1[i];
-                sumcorr += ftr0[i] * ftr1[i];
+                return err::ERR_IO;
+            }
+
+            // Clear current data
+            _gallery.clear();
+            labels.clear();
+            labels.push_back("unknown");
+
+            // name + \0 + fea_len(2B) + feature
+            while (!f->eof())
+            {
+                std::string label;
+                char ch;
+                int n = f->read(&ch, 1);
+                if (n <= 0) // end of file
+                    break;
+                while (n > 0 && ch != '\0')
+                {
+                    label += ch;
+                    n = f->read(&ch, 1);
+                }
+                uint16_t len;
+                if (f->read(&len, 2) != 2)
+                {
+                    f->close();
+                    delete f;
+                    return err::ERR_IO;
+                }
+                std::vector<float> feature(len);
+                if (f->read(feature.data(), len * sizeof(float)) != (int)(len * sizeof(float)))
+                {
+                    f->close();
+                    delete f;
+                    return err::ERR_IO;
+                }
+                if (_gallery.add(feature.data(), len) != err::ERR_NONE)
+                {
+                    f->close();
+                    delete f;
+                    return err::ERR_ARGS;
+                }
+                labels.push_back(label);
             }
-            return (0.5 + 0.5 * sumcorr / sqrt(sumftr0 * sumftr1));
+            f->close();
+            delete f;
+            return err::ERR_NONE;
         }
 
         static void split0(std::vector<std::string> &items, const std::string &s, const std::string &delimiter)
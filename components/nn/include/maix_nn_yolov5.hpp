@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Decode outputs with tensor strides and dequantize-on-read, anchor group of layer decided by grid size.
  */
 
 #pragma once
@@ -372,21 +373,31 @@ namespace maix::nn
         {
             std::vector<nn::Object> *objects = new std::vector<nn::Object>();
             int layer_num = outputs->size();
-            int i = 0;
-            for (auto it = outputs->begin(); it != outputs->end(); it++)
+            std::vector<int> grids(layer_num);
+            for (int i = 0; i < layer_num; ++i)
             {
-                if(i == 0)
+                std::vector<int> shape = outputs->get_tensor(i)->shape();
+                if(shape.size() != 4 || (size_t)shape[1] != (labels.size() + 5) * anchors.size() / 2 / layer_num)
                 {
-                    std::vector<int> shape = it->second->shape();
-                    if((size_t)shape[1] != (labels.size() + 5) * anchors.size() / 2 / layer_num)
-                    {
-                        log::error("mud labels or anchors not match model's");
-                        delete objects;
-                        return NULL;
-                    }
+                    log::error("mud labels or anchors not match model's");
+                    delete objects;
+                    return NULL;
                 }
-                // log::info("output: %s, tensor: %s", it->first.c_str(), it->second->to_str().c_str());
-                _get_layer_objs(*objects, *it->second, i++, layer_num);
+                grids[i] = shape[2] * shape[3];
+            }
+            for (int i = 0; i < layer_num; ++i)
+            {
+                // anchors in MUD are from small to large(stride 8, 16, 32 layers),
+                // so anchor group is decided by grid size, the larger grid the smaller anchors, not by output order
+                int group = 0;
+                for (int j = 0; j < layer_num; ++j)
+                {
+                    if (grids[j] > grids[i] || (grids[j] == grids[i] && j < i))
+                        ++group;
+                }
+                tensor::Tensor *output = outputs->get_tensor(i);
+                // log::info("output: %s, tensor: %s", outputs->get_name(i).c_str(), output->to_str().c_str());
+                _get_layer_objs(*objects, *output, group, layer_num);
             }
             if(objects->size() > 0)
             {
@@ -399,41 +410,61 @@ namespace maix::nn
             return objects;
         }
 
-        void _get_layer_objs(std::vector<nn::Object> &objs, tensor::Tensor &output, int layer_i, int layer_num)
+        void _get_layer_objs(std::vector<nn::Object> &objs, tensor::Tensor &output, int anchor_group, int layer_num)
         {
+            // use strides and get() instead of raw float pointer,
+            // so quantized(int8, uint8) or not contiguous NPU output can be decoded without copy.
+            std::vector<int> strides = output.strides();
             int h = output.shape()[2];
             int w = output.shape()[3];
             int class_num = this->labels.size();
             int box_len = class_num + 5;
-            int s = w * h;
+            int s = strides[1];
+            int sy = strides[2];
+            int sx = strides[3];
             int anchor_stride = box_len * s;
             int s4 = 4 * s;
             int s3 = 3 * s;
             int s2 = 2 * s;
-            float *data = (float *)output.data();
+            bool is_f32 = output.dtype() == tensor::FLOAT32;
+            const float *data = (const float *)output.data();
+            auto val = [&](int64_t off) { return is_f32 ? data[off] : output.get(off); };
             int anchor_num = this->anchors.size() / 2 / layer_num;
-            int anchor_start = anchor_num * layer_i * 2;
+            int anchor_start = anchor_num * anchor_group * 2;
             float scale_x = _input_size.width() / w;
             float scale_y = _input_size.height() / h;
+            // sigmoid(x) > conf_th equals x > logit(conf_th), skip sigmoid for most of boxes
+            float obj_th = _conf_th <= 0 ? -1e30f : (_conf_th >= 1 ? 1e30f : logf(_conf_th / (1 - _conf_th)));
             for (int a = 0; a < anchor_num; ++a)
             {
                 for (int y = 0; y < h; ++y)
                 {
                     for (int x = 0; x < w; ++x)
                     {
-                        float *p = data + a * anchor_stride + y * w + x + s4;
-                        float obj_score = _sigmoid(*p);
-                        if (obj_score <= _conf_th)
+                        int64_t p = (int64_t)a * anchor_stride + (int64_t)y * sy + (int64_t)x * sx + s4;
+                        float obj_logit = val(p);
+                        if (obj_logit <= obj_th)
                             continue;
-                        float *cls_scores = p + s;
-                        int class_id = _argmax(cls_scores, class_num, s);
-                        obj_score *= _sigmoid(cls_scores[class_id * s]);
+                        float obj_score = _sigmoid(obj_logit);
+                        int64_t cls_scores = p + s;
+                        int class_id = 0;
+                        float cls_max = val(cls_scores);
+                        for (int c = 1; c < class_num; ++c)
+                        {
+                            float v = val(cls_scores + (int64_t)c * s);
+                            if (v > cls_max)
+                            {
+                                cls_max = v;
+                                class_id = c;
+                            }
+                        }
+                        obj_score *= _sigmoid(cls_max);
                         if (obj_score <= _conf_th)
                             continue;
-                        float bbox_x = (_sigmoid(*(p - s4)) * 2 + x - 0.5) * scale_x;
-                        float bbox_y = (_sigmoid(*(p - s3)) * 2 + y - 0.5) * scale_y;
-                        float bbox_w = pow(_sigmoid(*(p - s2)) * 2, 2) * this->anchors[anchor_start + a * 2];
-                        float bbox_h = pow(_sigmoid(*(p - s)) * 2, 2) * this->anchors[anchor_start + a * 2 + 1];
+                        float bbox_x = (_sigmoid(val(p - s4)) * 2 + x - 0.5) * scale_x;
+                        float bbox_y = (_sigmoid(val(p - s3)) * 2 + y - 0.5) * scale_y;
+                        float bbox_w = pow(_sigmoid(val(p - s2)) * 2, 2) * this->anchors[anchor_start + a * 2];
+                        float bbox_h = pow(_sigmoid(val(p - s)) * 2, 2) * this->anchors[anchor_start + a * 2 + 1];
                         bbox_x -= bbox_w * 0.5; // center x to left top x
                         bbox_y -= bbox_h * 0.5; // center y to left top y
                         Object obj(bbox_x, bbox_y, bbox_w, bbox_h, class_id, obj_score);
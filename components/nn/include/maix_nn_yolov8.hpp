@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2024-
  * @license Apache 2.0
  * @update 2024.6.7: Add yolov8 support.
+ * @update 2026.10.18: Decode outputs with tensor strides, quantized outputs are dequantized only when needed.
  */
 
 #pragma once
@@ -34,6 +35,226 @@ namespace maix::nn
         float stride;
     };
 
+    /**
+     * YOLOv8 detect output decoder.
+     * Candidates are kept in flat arrays(structure of arrays) and reused between frames,
+     * nn::Object only need to be created for the survivors of NMS.
+     * @maixcdk maix.nn.YOLOv8Decoder
+     */
+    class YOLOv8Decoder
+    {
+    public:
+        /**
+         * Decode candidates whose max class score > conf_th.
+         * @param scores class scores, shape [class_num, total_box_num], sigmoid applied.
+         * @param boxes box distances, shape [4, total_box_num], in order left, top, right, bottom.
+         * @param class_num class number.
+         * @param total_box_num anchor number of all levels.
+         * @param w model input width.
+         * @param h model input height.
+         * @param conf_th confidence threshold.
+         * @param score_stride step between class rows of scores, element unit, 0 means total_box_num.
+         * @param box_stride step between rows of boxes, element unit, 0 means total_box_num.
+         * @return candidates number.
+         * @maixcdk maix.nn.YOLOv8Decoder.decode
+         */
+        int decode(const float *scores, const float *boxes, int class_num, int total_box_num, int w, int h, float conf_th,
+                   int score_stride = 0, int box_stride = 0)
+        {
+            if (score_stride <= 0)
+                score_stride = total_box_num;
+            if (box_stride <= 0)
+                box_stride = total_box_num;
+            const int strides[3] = {8, 16, 32};
+            num = 0;
+            _clear();
+            // class scores are the heavy part(class_num x total_box_num), find max class of all anchors in parallel first
+            _max_score.resize(total_box_num);
+            _max_class.resize(total_box_num);
+            thread::parallel_for(0, (total_box_num + BLOCK - 1) / BLOCK, [&](int begin, int end) {
+                float best[BLOCK] __attribute__((aligned(16)));
+                int best_id[BLOCK] __attribute__((aligned(16)));
+                for (int b = begin; b < end; ++b)
+                {
+                    int n = b * BLOCK;
+                    int len = std::min((int)BLOCK, total_box_num - n);
+                    _block_argmax(scores + n, class_num, score_stride, len, best, best_id);
+                    memcpy(_max_score.data() + n, best, len * sizeof(float));
+                    memcpy(_max_class.data() + n, best_id, len * sizeof(int));
+                }
+            }, 4);
+            int start = 0;
+            for (int i = 0; i < 3; ++i)
+            {
+                int nw = w / strides[i];
+                int nh = h / strides[i];
+                int end = std::min(start + nw * nh, total_box_num);
+                for (int offset = start; offset < end; ++offset)
+                {
+                    if (_max_score[offset] <= conf_th)
+                        continue;
+                    int ax = (offset - start) % nw;
+                    int ay = (offset - start) / nw;
+                    float s = strides[i];
+                    float x1 = (ax + 0.5f - boxes[offset]) * s;
+                    float y1 = (ay + 0.5f - boxes[offset + box_stride]) * s;
+                    float x2 = (ax + 0.5f + boxes[offset + box_stride * 2]) * s;
+                    float y2 = (ay + 0.5f + boxes[offset + box_stride * 3]) * s;
+                    this->x1.push_back(x1);
+                    this->y1.push_back(y1);
+                    this->x2.push_back(x2);
+                    this->y2.push_back(y2);
+                    score.push_back(_max_score[offset]);
+                    class_id.push_back(_max_class[offset]);
+                    idx.push_back(offset);
+                    anchor_x.push_back(ax);
+                    anchor_y.push_back(ay);
+                    stride.push_back(s);
+                }
+                start = end;
+            }
+            num = score.size();
+            return num;
+        }
+
+        /**
+         * Class aware NMS on decoded candidates, result indexes are saved to keep, sorted by score from high to low.
+         * @param iou_th IoU threshold.
+         * @param max_det max number of result objects, -1 means no limit.
+         * @return result number.
+         * @maixcdk maix.nn.YOLOv8Decoder.nms
+         */
+        int nms(float iou_th, int max_det = -1)
+        {
+            keep.clear();
+            if (num == 0 || max_det == 0)
+                return 0;
+            // sort by score, then bucket by class, keep score order in bucket
+            _order.resize(num);
+            for (int i = 0; i < num; ++i)
+                _order[i] = i;
+            std::sort(_order.begin(), _order.end(), [this](int a, int b) {
+                return score[a] > score[b];
+            });
+            int class_num = *std::max_element(class_id.begin(), class_id.end()) + 1;
+            _bucket_start.assign(class_num + 1, 0);
+            for (int i = 0; i < num; ++i)
+                ++_bucket_start[class_id[i] + 1];
+            for (int c = 0; c < class_num; ++c)
+                _bucket_start[c + 1] += _bucket_start[c];
+            _bucketed.resize(num);
+            _bucket_pos.assign(_bucket_start.begin(), _bucket_start.end() - 1);
+            for (int i : _order)
+                _bucketed[_bucket_pos[class_id[i]]++] = i;
+            _area.resize(num);
+            for (int i = 0; i < num; ++i)
+                _area[i] = (x2[i] - x1[i]) * (y2[i] - y1[i]);
+            _suppressed.assign(num, 0);
+            for (int c = 0; c < class_num; ++c)
+            {
+                int kept = 0;
+                for (int i = _bucket_start[c]; i < _bucket_start[c + 1]; ++i)
+                {
+                    int a = _bucketed[i];
+                    if (_suppressed[a])
+                        continue;
+                    keep.push_back(a);
+                    if (max_det > 0 && ++kept >= max_det)
+                        break;
+                    for (int j = i + 1; j < _bucket_start[c + 1]; ++j)
+                    {
+                        int b = _bucketed[j];
+                        if (!_suppressed[b] && _iou(a, b) > iou_th)
+                            _suppressed[b] = 1;
+                    }
+                }
+            }
+            std::sort(keep.begin(), keep.end(), [this](int a, int b) {
+                return score[a] > score[b];
+            });
+            if (max_det > 0 && (int)keep.size() > max_det)
+                keep.resize(max_det);
+            return keep.size();
+        }
+
+    public:
+        int num = 0;
+        std::vector<float> x1, y1, x2, y2, score, stride;
+        std::vector<int> class_id, idx, anchor_x, anchor_y;
+        std::vector<int> keep;
+
+    private:
+        enum
+        {
+            BLOCK = 64
+        };
+        typedef float _v4f __attribute__((vector_size(16)));
+        typedef int _v4i __attribute__((vector_size(16)));
+        std::vector<float> _max_score;
+        std::vector<int> _max_class;
+        std::vector<int> _order, _bucketed, _bucket_start, _bucket_pos;
+        std::vector<float> _area;
+        std::vector<uint8_t> _suppressed;
+
+        void _clear()
+        {
+            x1.clear();
+            y1.clear();
+            x2.clear();
+            y2.clear();
+            score.clear();
+            stride.clear();
+            class_id.clear();
+            idx.clear();
+            anchor_x.clear();
+            anchor_y.clear();
+        }
+
+        /**
+         * max score and class of len anchors, walk class rows with 4 anchors a vector,
+         * best and best_id should be 16 bytes aligned and at least BLOCK long.
+         */
+        static void _block_argmax(const float *scores, int class_num, int row_stride, int len, float *best, int *best_id)
+        {
+            int vec_len = len & ~3;
+            memcpy(best, scores, len * sizeof(float));
+            memset(best_id, 0, BLOCK * sizeof(int));
+            for (int c = 1; c < class_num; ++c)
+            {
+                const float *row = scores + (int64_t)c * row_stride;
+                _v4i cls = {c, c, c, c};
+                int j = 0;
+                for (; j < vec_len; j += 4)
+                {
+                    _v4f v;
+                    memcpy(&v, row + j, sizeof(v));
+                    _v4f cur = *(_v4f *)(best + j);
+                    _v4i gt = v > cur;
+                    *(_v4f *)(best + j) = gt ? v : cur;
+                    *(_v4i *)(best_id + j) = gt ? cls : *(_v4i *)(best_id + j);
+                }
+                for (; j < len; ++j)
+                {
+                    if (row[j] > best[j])
+                    {
+                        best[j] = row[j];
+                        best_id[j] = c;
+                    }
+                }
+            }
+        }
+
+        float _iou(int a, int b)
+        {
+            float wi = std::min(x2[a], x2[b]) - std::max(x1[a], x1[b]);
+            float hi = std::min(y2[a], y2[b]) - std::max(y1[a], y1[b]);
+            if (wi <= 0 || hi <= 0)
+                return 0;
+            float area_i = wi * hi;
+            return area_i / (_area[a] + _area[b] - area_i);
+        }
+    };
+
     /**
      * YOLOv8 class
      * @maixpy maix.nn.YOLOv8
@@ -274,16 +495,18 @@ namespace maix::nn
          * @param iou_th IoU threshold, default 0.45.
          * @param fit Resize method, default image.Fit.FIT_CONTAIN.
          * @param keypoint_th keypoint threshold, default 0.5, only for yolov8-pose model.
+         * @param max_det max number of objects to return, objects with higher score first, default -1 means no limit.
          * @throw If image format not match model input format, will throw err::Exception.
          * @return Object list. In C++, you should delete it after use.
          *         If model is yolov8-pose, object's points have value, and if points' value < 0 means that point is invalid(conf < keypoint_th).
          * @maixpy maix.nn.YOLOv8.detect
          */
-        nn::Objects *detect(image::Image &img, float conf_th = 0.5, float iou_th = 0.45, maix::image::Fit fit = maix::image::FIT_CONTAIN, float keypoint_th = 0.5)
+        nn::Objects *detect(image::Image &img, float conf_th = 0.5, float iou_th = 0.45, maix::image::Fit fit = maix::image::FIT_CONTAIN, float keypoint_th = 0.5, int max_det = -1)
         {
             this->_conf_th = conf_th;
             this->_iou_th = iou_th;
             this->_keypoint_th = keypoint_th;
+            this->_max_det = max_det;
             if (img.format() != _input_img_fmt)
             {
                 throw err::Exception("image format not match, input_type: " + image::fmt_names[_input_img_fmt] + ", image format: " + image::fmt_names[img.format()]);
@@ -457,6 +680,8 @@ namespace maix::nn
         float _conf_th = 0.5;
         float _iou_th = 0.45;
         float _keypoint_th = 0.5;
+        int _max_det = -1;
+        YOLOv8Decoder _decoder;
         YOLOv8_Type _type;
         bool _dual_buff;
 
@@ -469,17 +694,12 @@ namespace maix::nn
             float scale_w = 1;
             float scale_h = 1;
 
-            if(!_decode_objs(*objects, outputs, _conf_th, _input_size.width(), _input_size.height(), &kp_out, &mask_out))
+            if(!_decode_objs(outputs, _conf_th, _input_size.width(), _input_size.height(), &kp_out, &mask_out))
             {
                 delete objects;
                 return NULL;
             }
-            if (objects->size() > 0)
-            {
-                nn::Objects *objects_total = objects;
-                objects = _nms(*objects);
-                delete objects_total;
-            }
+            _nms(*objects);
             // decode keypoints
             if (_type == TYPE_POSE)
             {
@@ -496,9 +716,8 @@ namespace maix::nn
             return objects;
         }
 
-        bool _decode_objs(nn::Objects &objs, tensor::Tensors *outputs, float conf_thresh, int w, int h, tensor::Tensor **kp_out, tensor::Tensor **mask_out)
+        bool _decode_objs(tensor::Tensors *outputs, float conf_thresh, int w, int h, tensor::Tensor **kp_out, tensor::Tensor **mask_out)
         {
-            float stride[3] = {8, 16, 32};
             tensor::Tensor *score_out = NULL; // shape 1, 80, 8400, 1
             tensor::Tensor *box_out = NULL;   // shape 1,  1,    4, 8400
             for (auto i : *outputs)
@@ -525,121 +744,72 @@ namespace maix::nn
                     *kp_out = i.second;
                 }
             }
-            if (!score_out || !kp_out)
+            if (!score_out || !box_out)
             {
                 throw err::Exception(err::ERR_ARGS, "model output not valid");
             }
-            int total_box_num = box_out->shape()[3];
-            // int class_num = this->labels.size();
-            int class_num = score_out->shape()[1];
-            float *scores_ptr = (float *)score_out->data();
-            float *dets_ptr = (float *)box_out->data();
-            int idx_start[3] = {
-                0,
-                (int)(h / stride[0] * w / stride[0]),
-                (int)(h / stride[0] * w / stride[0] + h / stride[1] * w / stride[1])};
-            for (int i = 0; i < 3; i++)
-            {
-                int nh = h / stride[i];
-                int nw = w / stride[i];
-                for (int ay = 0; ay < nh; ++ay)
-                {
-                    for (int ax = 0; ax < nw; ++ax)
-                    {
-                        int offset = idx_start[i] + ay * nw + ax;
-                        int class_id = _argmax(scores_ptr + offset, class_num, total_box_num);
-                        // int max_idx = _argmax2(scores_ptr + offset, class_num * total_box_num - offset, total_box_num);
-                        // int class_id = (offset + max_idx) / total_box_num;
-                        float obj_score = scores_ptr[offset + class_id * total_box_num];
-                        if (obj_score <= conf_thresh)
-                        {
-                            continue;
-                        }
-                        float bbox_x = (ax + 0.5 - dets_ptr[offset]) * stride[i];
-                        float bbox_y = (ay + 0.5 - dets_ptr[offset + total_box_num]) * stride[i];
-                        float bbox_w = (ax + 0.5 + dets_ptr[offset + total_box_num * 2]) * stride[i] - bbox_x;
-                        float bbox_h = (ay + 0.5 + dets_ptr[offset + total_box_num * 3]) * stride[i] - bbox_y;
-                        _KpInfo *kp_info = new _KpInfo(offset, ax, ay, stride[i]);
-                        Object *obj = objs.add(bbox_x, bbox_y, bbox_w, bbox_h, class_id, obj_score);
-                        obj->temp = (void *)kp_info;
-                    }
-                }
-            }
+            // decode directly from NPU output buffer if float32 and boxes continuous in memory,
+            // quantized or other layouts are converted to float32 first.
+            tensor::Tensor *score_f = NULL;
+            tensor::Tensor *box_f = NULL;
+            if (score_out->dtype() != tensor::FLOAT32 || score_out->strides()[2] != 1)
+                score_out = score_f = score_out->dequantize();
+            if (box_out->dtype() != tensor::FLOAT32 || box_out->strides()[3] != 1)
+                box_out = box_f = box_out->dequantize();
+            _decoder.decode((float *)score_out->data(), (float *)box_out->data(), score_out->shape()[1], box_out->shape()[3], w, h, conf_thresh,
+                            score_out->strides()[1], box_out->strides()[2]);
+            delete score_f;
+            delete box_f;
             return true;
         }
 
-        nn::Objects *_nms(nn::Objects &objs)
+        void _nms(nn::Objects &result)
         {
-            nn::Objects *result = new nn::Objects();
-            std::sort(objs.begin(), objs.end(), [](const nn::Object *a, const nn::Object *b)
-                      { return a->score < b->score; });
-            for (size_t i = 0; i < objs.size(); ++i)
+            _decoder.nms(this->_iou_th, this->_max_det);
+            for (int i : _decoder.keep)
             {
-                nn::Object *a = objs.at(i);
-                if (a->score == 0)
-                    continue;
-                for (size_t j = i + 1; j < objs.size(); ++j)
+                Object *obj = result.add(_decoder.x1[i], _decoder.y1[i], _decoder.x2[i] - _decoder.x1[i], _decoder.y2[i] - _decoder.y1[i], _decoder.class_id[i], _decoder.score[i]);
+                if (obj->x < 0)
                 {
-                    nn::Object *b = objs.at(j);
-                    {
-                        if (b->score != 0 && a->class_id == b->class_id && _calc_iou(*a, *b) > this->_iou_th)
-                            b->score = 0;
-                    }
+                    obj->w += obj->x;
+                    obj->x = 0;
                 }
-            }
-            for (nn::Object *a : objs)
-            {
-                if (a->score != 0)
+                if (obj->y < 0)
                 {
-                    Object *obj = result->add(a->x, a->y, a->w, a->h, a->class_id, a->score, a->points);
-                    if (obj->x < 0)
-                    {
-                        obj->w += obj->x;
-                        obj->x = 0;
-                    }
-                    if (obj->y < 0)
-                    {
-                        obj->h += obj->y;
-                        obj->y = 0;
-                    }
-                    if (obj->x + obj->w > _input_size.width())
-                    {
-                        obj->w = _input_size.width() - obj->x;
-                    }
-                    if (obj->y + obj->h > _input_size.height())
-                    {
-                        obj->h = _input_size.height() - obj->y;
-                    }
-                    obj->temp = a->temp;
+                    obj->h += obj->y;
+                    obj->y = 0;
                 }
-                else
+                if (obj->x + obj->w > _input_size.width())
+                {
+                    obj->w = _input_size.width() - obj->x;
+                }
+                if (obj->y + obj->h > _input_size.height())
                 {
-                    delete (_KpInfo *)a->temp;
-                    a->temp = NULL;
+                    obj->h = _input_size.height() - obj->y;
                 }
+                obj->temp = (void *)new _KpInfo(_decoder.idx[i], _decoder.anchor_x[i], _decoder.anchor_y[i], _decoder.stride[i]);
             }
-            return result;
         }
 
         void _decode_keypoints(nn::Objects &objs, tensor::Tensor *kp_out)
         {
-            float *data = (float *)kp_out->data();
             int keypoint_num = kp_out->shape()[1] / 3; // 1, 51, 8400, 1
-            int total_box_num = kp_out->shape()[2];    // 1, 51, 8400, 1
+            int64_t row_stride = kp_out->strides()[1];
+            int64_t box_stride = kp_out->strides()[2];
             for (size_t i = 0; i < objs.size(); ++i)
             {
                 nn::Object *o = objs.at(i);
                 _KpInfo *kp_info = (_KpInfo *)o->temp;
-                float *p = data + kp_info->idx;
+                int64_t p = kp_info->idx * box_stride;
                 for (int k = 0; k < keypoint_num; ++k)
                 {
-                    float score = _sigmoid(p[(k * 3 + 2) * total_box_num]);
+                    float score = _sigmoid(kp_out->get(p + (k * 3 + 2) * row_stride));
                     int x = -1;
                     int y = -1;
                     if (score > _keypoint_th)
                     {
-                        x = (p[(k * 3) * total_box_num] * 2.0 + kp_info->anchor_x) * kp_info->stride;
-                        y = (p[(k * 3 + 1) * total_box_num] * 2.0 + kp_info->anchor_y) * kp_info->stride;
+                        x = (kp_out->get(p + (k * 3) * row_stride) * 2.0 + kp_info->anchor_x) * kp_info->stride;
+                        y = (kp_out->get(p + (k * 3 + 1) * row_stride) * 2.0 + kp_info->anchor_y) * kp_info->stride;
                     }
                     o->points.push_back(x);
                     o->points.push_back(y);
@@ -651,13 +821,17 @@ namespace maix::nn
 
         void _decode_seg_points(nn::Objects &objs, tensor::Tensor *kp_out, tensor::Tensor *mask_out)
         {
-            float *data = (float *)kp_out->data();
+            // mask protos are accumulated in place, so need float32 continuous data
+            tensor::Tensor *mask_f = NULL;
+            if (mask_out->dtype() != tensor::FLOAT32 || !mask_out->is_contiguous())
+                mask_out = mask_f = mask_out->dequantize();
             float *mask_data = (float *)mask_out->data(); // 1, 32, 160, 160
             int mask_h = mask_out->shape()[2];
             int mask_w = mask_out->shape()[3];
             int mask_squre = mask_h * mask_w;
             int mask_num = kp_out->shape()[1];      // 1, 32, 8400, 1
-            int total_box_num = kp_out->shape()[2]; // 1, 32, 8400, 1
+            int64_t row_stride = kp_out->strides()[1];
+            int64_t box_stride = kp_out->strides()[2];
             float mask_weights[mask_num];
             for (size_t i = 0; i < objs.size(); ++i)
             {
@@ -667,10 +841,10 @@ namespace maix::nn
                 int mask_x2 = (o->x + o->w) * mask_w / _input_size.width();
                 int mask_y2 = (o->y + o->h) * mask_h / _input_size.height();
                 _KpInfo *kp_info = (_KpInfo *)o->temp;
-                float *p = data + kp_info->idx;
+                int64_t p = kp_info->idx * box_stride;
                 for (int k = 0; k < mask_num; ++k)
                 {
-                    mask_weights[k] = p[k * total_box_num];
+                    mask_weights[k] = kp_out->get(p + k * row_stride);
                 }
                 o->seg_mask = new image::Image(mask_x2 - mask_x, mask_y2 - mask_y, image::Format::FMT_GRAYSCALE);
                 uint8_t *p_img_data = (uint8_t *)o->seg_mask->data();
@@ -701,6 +875,7 @@ namespace maix::nn
                 delete (_KpInfo *)o->temp;
                 o->temp = NULL;
             }
+            delete mask_f;
         }
 
         void _correct_bbox(nn::Objects &objs, int img_w, int img_h, maix::image::Fit fit, float *scale_w, float *scale_h)
@@ -853,47 +1028,6 @@ namespace maix::nn
 
         inline static float _sigmoid(float x) { return 1.0 / (1 + expf(-x)); }
 
-        inline static float _calc_iou(Object &a, Object &b)
-        {
-            float area1 = a.w * a.h;
-            float area2 = b.w * b.h;
-            float wi = std::min((a.x + a.w), (b.x + b.w)) -
-                       std::max(a.x, b.x);
-            float hi = std::min((a.y + a.h), (b.y + b.h)) -
-                       std::max(a.y, b.y);
-            float area_i = std::max(wi, 0.0f) * std::max(hi, 0.0f);
-            return area_i / (area1 + area2 - area_i);
-        }
-
-        template <typename T>
-        static int _argmax(const T *data, size_t len, size_t stride = 1)
-        {
-            int maxIndex = 0;
-            for (size_t i = 1; i < len; i++)
-            {
-                int idx = i * stride;
-                if (data[maxIndex * stride] < data[idx])
-                {
-                    maxIndex = i;
-                }
-            }
-            return maxIndex;
-        }
-
-        template <typename T>
-        static int _argmax2(const T *data, size_t end, size_t stride = 1)
-        {
-            int maxIndex = 0;
-            for (size_t i = stride; i < end; i += stride)
-            {
-                if (data[maxIndex] < data[i])
-                {
-                    maxIndex = i;
-                }
-            }
-            return maxIndex;
-        }
-
         static void split0(std::vector<std::string> &items, const std::string &s, const std::string &delimiter)
         {
             items.clear();
@@ -0,0 +1,1345 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add CPU backend for Linux.
+ */
+
+#include "maix_nn_cpu.hpp"
+#include "maix_basic.hpp"
+#include "maix_image_preprocess.hpp"
+#include <stdio.h>
+#include <math.h>
+#include <limits.h>
+#include <atomic>
+#include <functional>
+
+/*
+ * maixnn model file format, all numbers are little endian uint32 unless noted:
+ *   magic "MXNN", version(1)
+ *   tensor_num, then each tensor:
+ *       name_len, name(char[name_len]), ndim, dims(int32[ndim]), has_data, data(float32[prod(dims)]) if has_data
+ *   node_num, then each node:
+ *       op, in_num, in(tensor index[in_num]), out_num, out(tensor index[out_num]),
+ *       iparam_num, iparams(int32[iparam_num]), fparam_num, fparams(float32[fparam_num])
+ *   input_num, inputs(tensor index[input_num]), output_num, outputs(tensor index[output_num])
+ * All tensors are float32, layout NCHW, batch 1, shapes are all known when converting.
+ */
+
+namespace maix::nn
+{
+    enum
+    {
+        MXNN_VERSION = 1,
+        CONV_NT = 64,     // output pixels per conv task, im2col buffer is K * CONV_NT floats
+        MAX_DIMS = 6,
+        MAX_TENSORS = 65536,        // limits of model file, reject broken headers before allocating
+        MAX_NODES = 65536,
+        MAX_TENSOR_SIZE = 1 << 28,  // elements of one tensor
+    };
+
+    enum cpu_op_t
+    {
+        OP_CONV = 0,            // in: x, w, [b]; i: kh, kw, sh, sw, pt, pl, pb, pr, dh, dw, group, act; f: act_alpha
+        OP_ACT = 1,             // i: act; f: act_alpha
+        OP_ADD = 2,             // broadcast binary ops
+        OP_SUB = 3,
+        OP_MUL = 4,
+        OP_DIV = 5,
+        OP_CONCAT = 6,          // i: axis
+        OP_SLICE = 7,           // i: axis, start, step
+        OP_MAXPOOL = 8,         // i: kh, kw, sh, sw, pt, pl, pb, pr
+        OP_AVGPOOL = 9,         // i: kh, kw, sh, sw, pt, pl, pb, pr, pad not counted
+        OP_GLOBAL_AVGPOOL = 10,
+        OP_RESIZE_NEAREST = 11,
+        OP_RESHAPE = 12,        // out shape is the target shape
+        OP_TRANSPOSE = 13,      // i: perm
+        OP_SOFTMAX = 14,        // i: axis
+        OP_GEMM = 15,           // in: x[M, K], w[N, K], [b]; i: act; f: act_alpha
+        OP_MAX
+    };
+
+    enum cpu_act_t
+    {
+        ACT_NONE = 0,
+        ACT_RELU,
+        ACT_LEAKY_RELU,
+        ACT_SIGMOID,
+        ACT_SILU,
+        ACT_RELU6,
+        ACT_HARDSWISH,
+        ACT_TANH,
+        ACT_MAX
+    };
+
+    typedef float v4f __attribute__((vector_size(16)));
+    typedef float v4f_u __attribute__((vector_size(16), aligned(4))); // unaligned access
+
+    /**
+     * Run tasks in the process wide thread pool with at most num() threads,
+     * every thread gets a thread_id in [0, num()) for its own workspace.
+     */
+    class CPUWorkers
+    {
+    public:
+        void start(int num)
+        {
+            _num = num > 0 ? num : 1;
+        }
+
+        int num()
+        {
+            return _num;
+        }
+
+        /**
+         * run task_num tasks, fn(task_id, thread_id), return after all tasks finished
+         */
+        void run(int task_num, const std::function<void(int, int)> &fn)
+        {
+            int threads = std::min(_num, task_num);
+            if (threads <= 1)
+            {
+                for (int i = 0; i < task_num; ++i)
+                    fn(i, 0);
+                return;
+            }
+            // one range index one thread_id, threads take tasks by an atomic index to balance the load
+            std::atomic<int> next{0};
+            thread::parallel_for(0, threads, [&](int begin, int end) {
+                for (int thread_id = begin; thread_id < end; ++thread_id)
+                {
+                    int i;
+                    while ((i = next.fetch_add(1)) < task_num)
+                        fn(i, thread_id);
+                }
+            }, 1, threads);
+        }
+
+    private:
+        int _num = 1;
+    };
+
+    struct cpu_tensor_t
+    {
+        std::string name;
+        std::vector<int> shape;
+        int size = 0;
+        float *data = nullptr;
+        bool is_const = false;
+        int buff_id = -1;
+    };
+
+    struct cpu_node_t
+    {
+        int op;
+        std::vector<int> in;
+        std::vector<int> out;
+        std::vector<int> ip;
+        std::vector<float> fp;
+    };
+
+    struct cpu_graph_t
+    {
+        std::vector<cpu_tensor_t> tensors;
+        std::vector<cpu_node_t> nodes;
+        std::vector<int> inputs;
+        std::vector<int> outputs;
+        std::vector<float *> buffers;   // activation buffers, shared by tensors not alive at the same time
+        std::vector<float *> workspace; // per thread im2col buffer
+        CPUWorkers workers;
+
+        ~cpu_graph_t()
+        {
+            for (auto &t : tensors)
+            {
+                if (t.is_const)
+                    free(t.data);
+            }
+            for (auto p : buffers)
+                free(p);
+            for (auto p : workspace)
+                free(p);
+        }
+    };
+
+    static float *_alloc_floats(size_t num)
+    {
+        void *p = nullptr;
+        if (posix_memalign(&p, 64, (num ? num : 1) * sizeof(float)) != 0)
+            return nullptr;
+        return (float *)p;
+    }
+
+    static inline float _act(float v, int act, float alpha)
+    {
+        switch (act)
+        {
+        case ACT_RELU:
+            return v > 0 ? v : 0;
+        case ACT_LEAKY_RELU:
+            return v > 0 ? v : v * alpha;
+        case ACT_SIGMOID:
+            return 1.0f / (1.0f + expf(-v));
+        case ACT_SILU:
+            return v / (1.0f + expf(-v));
+        case ACT_RELU6:
+            return v < 0 ? 0 : (v > 6 ? 6 : v);
+        case ACT_HARDSWISH:
+            return v <= -3 ? 0 : (v >= 3 ? v : v * (v + 3) / 6);
+        case ACT_TANH:
+            return tanhf(v);
+        default:
+            return v;
+        }
+    }
+
+    static void _act_array(float *data, int n, int act, float alpha)
+    {
+        if (act == ACT_NONE)
+            return;
+        for (int i = 0; i < n; ++i)
+            data[i] = _act(data[i], act, alpha);
+    }
+
+    /**
+     * C[M, nt](ldc) = A[M, K] * Bp + bias, Bp is packed by 8 columns: [nt / 8][K][8]
+     */
+    static void _gemm_packed(int M, int K, int nt, const float *A, const float *Bp, float *C, int ldc, const float *bias, int act, float alpha)
+    {
+        int panels = (nt + 7) / 8;
+        int m = 0;
+        for (; m + 4 <= M; m += 4)
+        {
+            const float *a0 = A + m * K;
+            const float *a1 = a0 + K;
+            const float *a2 = a1 + K;
+            const float *a3 = a2 + K;
+            for (int p = 0; p < panels; ++p)
+            {
+                const float *b = Bp + p * K * 8;
+                v4f c00, c01, c10, c11, c20, c21, c30, c31;
+                c00 = c01 = (v4f){0, 0, 0, 0} + (bias ? bias[m] : 0);
+                c10 = c11 = (v4f){0, 0, 0, 0} + (bias ? bias[m + 1] : 0);
+                c20 = c21 = (v4f){0, 0, 0, 0} + (bias ? bias[m + 2] : 0);
+                c30 = c31 = (v4f){0, 0, 0, 0} + (bias ? bias[m + 3] : 0);
+                for (int k = 0; k < K; ++k)
+                {
+                    v4f b0 = *(const v4f *)(b + k * 8);
+                    v4f b1 = *(const v4f *)(b + k * 8 + 4);
+                    c00 += a0[k] * b0;
+                    c01 += a0[k] * b1;
+                    c10 += a1[k] * b0;
+                    c11 += a1[k] * b1;
+                    c20 += a2[k] * b0;
+                    c21 += a2[k] * b1;
+                    c30 += a3[k] * b0;
+                    c31 += a3[k] * b1;
+                }
+                int cols = nt - p * 8 < 8 ? nt - p * 8 : 8;
+                v4f rows[4][2] = {{c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}};
+                for (int i = 0; i < 4; ++i)
+                {
+                    float *c = C + (m + i) * ldc + p * 8;
+                    for (int j = 0; j < cols; ++j)
+                        c[j] = _act(rows[i][j / 4][j % 4], act, alpha);
+                }
+            }
+        }
+        for (; m < M; ++m)
+        {
+            const float *a = A + m * K;
+            for (int p = 0; p < panels; ++p)
+            {
+                const float *b = Bp + p * K * 8;
+                v4f c0, c1;
+                c0 = c1 = (v4f){0, 0, 0, 0} + (bias ? bias[m] : 0);
+                for (int k = 0; k < K; ++k)
+                {
+                    c0 += a[k] * *(const v4f *)(b + k * 8);
+                    c1 += a[k] * *(const v4f *)(b + k * 8 + 4);
+                }
+                int cols = nt - p * 8 < 8 ? nt - p * 8 : 8;
+                float *c = C + m * ldc + p * 8;
+                for (int j = 0; j < cols; ++j)
+                    c[j] = _act(j < 4 ? c0[j] : c1[j - 4], act, alpha);
+            }
+        }
+    }
+
+    static void _conv_depthwise(const float *x, int H, int W, const float *w, float bias, float *y, int OH, int OW, const int *ip, int act, float alpha)
+    {
+        int kh = ip[0], kw = ip[1], sh = ip[2], sw = ip[3], pt = ip[4], pl = ip[5], dh = ip[8], dw = ip[9];
+        for (int oy = 0; oy < OH; ++oy)
+        {
+            for (int ox = 0; ox < OW; ++ox)
+            {
+                float sum = bias;
+                int iy0 = oy * sh - pt;
+                int ix0 = ox * sw - pl;
+                for (int ky = 0; ky < kh; ++ky)
+                {
+                    int iy = iy0 + ky * dh;
+                    if (iy < 0 || iy >= H)
+                        continue;
+                    const float *row = x + iy * W;
+                    const float *wrow = w + ky * kw;
+                    for (int kx = 0; kx < kw; ++kx)
+                    {
+                        int ix = ix0 + kx * dw;
+                        if (ix >= 0 && ix < W)
+                            sum += row[ix] * wrow[kx];
+                    }
+                }
+                y[oy * OW + ox] = _act(sum, act, alpha);
+            }
+        }
+    }
+
+    static void _conv(cpu_graph_t &g, const cpu_node_t &node)
+    {
+        const cpu_tensor_t &tx = g.tensors[node.in[0]];
+        const cpu_tensor_t &tw = g.tensors[node.in[1]];
+        const cpu_tensor_t &ty = g.tensors[node.out[0]];
+        const float *x = tx.data;
+        const float *w = tw.data;
+        const float *b = node.in.size() > 2 ? g.tensors[node.in[2]].data : nullptr;
+        float *y = ty.data;
+        const int *ip = node.ip.data();
+        int kh = ip[0], kw = ip[1], sh = ip[2], sw = ip[3], pt = ip[4], pl = ip[5], dh = ip[8], dw = ip[9], group = ip[10], act = ip[11];
+        float alpha = node.fp.empty() ? 0 : node.fp[0];
+        int C = tx.shape[1], H = tx.shape[2], W = tx.shape[3];
+        int OC = ty.shape[1], OH = ty.shape[2], OW = ty.shape[3];
+        int HW = H * W, N = OH * OW;
+
+        if (group == C && group == OC && group > 1)
+        {
+            g.workers.run(C, [&](int c, int) {
+                _conv_depthwise(x + c * HW, H, W, w + c * kh * kw, b ? b[c] : 0, y + c * N, OH, OW, ip, act, alpha);
+            });
+            return;
+        }
+        int Cg = C / group, OCg = OC / group, K = Cg * kh * kw;
+        int chunks = (N + CONV_NT - 1) / CONV_NT;
+        // split output channels too if not enough tasks for all threads
+        int m_split = 1;
+        while (group * chunks * m_split < g.workers.num() * 2 && OCg / (m_split * 2) >= 16)
+            m_split *= 2;
+        int m_step = (OCg + m_split - 1) / m_split;
+        g.workers.run(group * chunks * m_split, [&](int task, int thread_id) {
+            int gi = task / (chunks * m_split);
+            int chunk = task % (chunks * m_split) / m_split;
+            int m0 = task % m_split * m_step;
+            int m_num = std::min(m_step, OCg - m0);
+            if (m_num <= 0)
+                return;
+            int n0 = chunk * CONV_NT;
+            int nt = std::min((int)CONV_NT, N - n0);
+            float *packed = g.workspace[thread_id];
+            int iy0[CONV_NT], ix0[CONV_NT];
+            for (int j = 0; j < nt; ++j)
+            {
+                iy0[j] = (n0 + j) / OW * sh - pt;
+                ix0[j] = (n0 + j) % OW * sw - pl;
+            }
+            const float *xg = x + gi * Cg * HW;
+            int panels = (nt + 7) / 8;
+            for (int p = 0; p < panels; ++p)
+            {
+                float *dst = packed + p * K * 8;
+                int cols = std::min(8, nt - p * 8);
+                for (int k = 0; k < K; ++k)
+                {
+                    int c = k / (kh * kw);
+                    int r = k % (kh * kw);
+                    int ky = r / kw * dh, kx = r % kw * dw;
+                    const float *xc = xg + c * HW;
+                    int j = 0;
+                    for (; j < cols; ++j)
+                    {
+                        int iy = iy0[p * 8 + j] + ky;
+                        int ix = ix0[p * 8 + j] + kx;
+                        dst[k * 8 + j] = (iy >= 0 && iy < H && ix >= 0 && ix < W) ? xc[iy * W + ix] : 0;
+                    }
+                    for (; j < 8; ++j)
+                        dst[k * 8 + j] = 0;
+                }
+            }
+            int m = gi * OCg + m0;
+            _gemm_packed(m_num, K, nt, w + m * K, packed, y + m * N + n0, N, b ? b + m : nullptr, act, alpha);
+        });
+    }
+
+    static void _gemm(cpu_graph_t &g, const cpu_node_t &node)
+    {
+        const cpu_tensor_t &tx = g.tensors[node.in[0]];
+        const cpu_tensor_t &tw = g.tensors[node.in[1]];
+        const float *b = node.in.size() > 2 ? g.tensors[node.in[2]].data : nullptr;
+        int N = tw.shape[0], K = tw.shape[1];
+        int M = tx.size / K;
+        int act = node.ip.empty() ? ACT_NONE : node.ip[0];
+        float alpha = node.fp.empty() ? 0 : node.fp[0];
+        float *y = g.tensors[node.out[0]].data;
+        int step = 16;
+        int tasks = (N + step - 1) / step;
+        g.workers.run(M * tasks, [&](int task, int) {
+            int m = task / tasks;
+            int n_end = std::min(N, (task % tasks + 1) * step);
+            const float *x = tx.data + m * K;
+            for (int n = task % tasks * step; n < n_end; ++n)
+            {
+                const float *w = tw.data + n * K;
+                v4f acc = {0, 0, 0, 0};
+                int k = 0;
+                for (; k + 4 <= K; k += 4)
+                    acc += *(const v4f_u *)(x + k) * *(const v4f_u *)(w + k);
+                float sum = acc[0] + acc[1] + acc[2] + acc[3] + (b ? b[n] : 0);
+                for (; k < K; ++k)
+                    sum += x[k] * w[k];
+                y[m * N + n] = _act(sum, act, alpha);
+            }
+        });
+    }
+
+    static inline float _binary(int op, float a, float b)
+    {
+        switch (op)
+        {
+        case OP_ADD:
+            return a + b;
+        case OP_SUB:
+            return a - b;
+        case OP_MUL:
+            return a * b;
+        default:
+            return a / b;
+        }
+    }
+
+    template <int op>
+    static void _binary_loop(const float *a, int sa, const float *b, int sb, float *y, int n)
+    {
+        for (int i = 0; i < n; ++i)
+            y[i] = _binary(op, a[i * sa], b[i * sb]);
+    }
+
+    static void _binary_loop(int op, const float *a, int sa, const float *b, int sb, float *y, int n)
+    {
+        switch (op)
+        {
+        case OP_ADD:
+            return _binary_loop<OP_ADD>(a, sa, b, sb, y, n);
+        case OP_SUB:
+            return _binary_loop<OP_SUB>(a, sa, b, sb, y, n);
+        case OP_MUL:
+            return _binary_loop<OP_MUL>(a, sa, b, sb, y, n);
+        default:
+            return _binary_loop<OP_DIV>(a, sa, b, sb, y, n);
+        }
+    }
+
+    /**
+     * strides of tensor broadcast to out shape, broadcasted dims stride is 0
+     */
+    static void _broadcast_strides(const std::vector<int> &shape, const std::vector<int> &out_shape, int *strides)
+    {
+        int r = out_shape.size();
+        int offset = r - shape.size();
+        int s = 1;
+        for (int d = r - 1; d >= 0; --d)
+        {
+            int dim = d - offset >= 0 ? shape[d - offset] : 1;
+            strides[d] = dim == 1 ? 0 : s;
+            s *= dim;
+        }
+    }
+
+    static void _binary_op(cpu_graph_t &g, const cpu_node_t &node)
+    {
+        const cpu_tensor_t &ta = g.tensors[node.in[0]];
+        const cpu_tensor_t &tb = g.tensors[node.in[1]];
+        const cpu_tensor_t &ty = g.tensors[node.out[0]];
+        int op = node.op;
+        if (ta.size == ty.size && tb.size == ty.size)
+        {
+            _binary_loop(op, ta.data, 1, tb.data, 1, ty.data, ty.size);
+            return;
+        }
+        if (ta.size == ty.size && tb.size == 1)
+        {
+            _binary_loop(op, ta.data, 1, tb.data, 0, ty.data, ty.size);
+            return;
+        }
+        if (ta.size == 1 && tb.size == ty.size)
+        {
+            _binary_loop(op, ta.data, 0, tb.data, 1, ty.data, ty.size);
+            return;
+        }
+        int r = ty.shape.size();
+        int sa[MAX_DIMS], sb[MAX_DIMS], idx[MAX_DIMS] = {0};
+        _broadcast_strides(ta.shape, ty.shape, sa);
+        _broadcast_strides(tb.shape, ty.shape, sb);
+        int inner = ty.shape[r - 1];
+        float *y = ty.data;
+        for (int o = 0; o < ty.size / inner; ++o)
+        {
+            int oa = 0, ob = 0;
+            for (int d = 0; d < r - 1; ++d)
+            {
+                oa += idx[d] * sa[d];
+                ob += idx[d] * sb[d];
+            }
+            _binary_loop(op, ta.data + oa, sa[r - 1], tb.data + ob, sb[r - 1], y + o * inner, inner);
+            for (int d = r - 2; d >= 0; --d)
+            {
+                if (++idx[d] < ty.shape[d])
+                    break;
+                idx[d] = 0;
+            }
+        }
+    }
+
+    static void _outer_inner(const std::vector<int> &shape, int axis, int &outer, int &inner)
+    {
+        outer = 1;
+        inner = 1;
+        for (int d = 0; d < axis; ++d)
+            outer *= shape[d];
+        for (size_t d = axis + 1; d < shape.size(); ++d)
+            inner *= shape[d];
+    }
+
+    static void _concat(cpu_graph_t &g, const cpu_node_t &node)
+    {
+        const cpu_tensor_t &ty = g.tensors[node.out[0]];
+        int axis = node.ip[0];
+        int outer, inner;
+        _outer_inner(ty.shape, axis, outer, inner);
+        int offset = 0;
+        for (int i : node.in)
+        {
+            const cpu_tensor_t &t = g.tensors[i];
+            int len = t.shape[axis] * inner;
+            for (int o = 0; o < outer; ++o)
+                memcpy(ty.data + o * ty.shape[axis] * inner + offset, t.data + o * len, len * sizeof(float));
+            offset += len;
+        }
+    }
+
+    static void _slice(cpu_graph_t &g, const cpu_node_t &node)
+    {
+        const cpu_tensor_t &tx = g.tensors[node.in[0]];
+        const cpu_tensor_t &ty = g.tensors[node.out[0]];
+        int axis = node.ip[0], start = node.ip[1], step = node.ip[2];
+        int outer, inner;
+        _outer_inner(tx.shape, axis, outer, inner);
+        int count = ty.shape[axis];
+        for (int o = 0; o < outer; ++o)
+        {
+            for (int i = 0; i < count; ++i)
+                memcpy(ty.data + (o * count + i) * inner, tx.data + (o * tx.shape[axis] + start + i * step) * inner, inner * sizeof(float));
+        }
+    }
+
+    static void _pool(cpu_graph_t &g, const cpu_node_t &node)
+    {
+        const cpu_tensor_t &tx = g.tensors[node.in[0]];
+        const cpu_tensor_t &ty = g.tensors[node.out[0]];
+        const int *ip = node.ip.data();
+        int kh = ip[0], kw = ip[1], sh = ip[2], sw = ip[3], pt = ip[4], pl = ip[5];
+        int C = tx.shape[1], H = tx.shape[2], W = tx.shape[3];
+        int OH = ty.shape[2], OW = ty.shape[3];
+        bool is_max = node.op == OP_MAXPOOL;
+        g.workers.run(C, [&](int c, int) {
+            const float *x = tx.data + c * H * W;
+            float *y = ty.data + c * OH * OW;
+            for (int oy = 0; oy < OH; ++oy)
+            {
+                int y0 = std::max(oy * sh - pt, 0), y1 = std::min(oy * sh - pt + kh, H);
+                for (int ox = 0; ox < OW; ++ox)
+                {
+                    int x0 = std::max(ox * sw - pl, 0), x1 = std::min(ox * sw - pl + kw, W);
+                    float v = is_max ? -INFINITY : 0;
+                    for (int iy = y0; iy < y1; ++iy)
+                    {
+                        for (int ix = x0; ix < x1; ++ix)
+                            v = is_max ? std::max(v, x[iy * W + ix]) : v + x[iy * W + ix];
+                    }
+                    if (!is_max)
+                        v /= std::max((y1 - y0) * (x1 - x0), 1);
+                    y[oy * OW + ox] = v;
+                }
+            }
+        });
+    }
+
+    static void _global_avgpool(cpu_graph_t &g, const cpu_node_t &node)
+    {
+        const cpu_tensor_t &tx = g.tensors[node.in[0]];
+        float *y = g.tensors[node.out[0]].data;
+        int C = tx.shape[1], HW = tx.size / C;
+        for (int c = 0; c < C; ++c)
+        {
+            const float *x = tx.data + c * HW;
+            float sum = 0;
+            for (int i = 0; i < HW; ++i)
+                sum += x[i];
+            y[c] = sum / HW;
+        }
+    }
+
+    static void _resize_nearest(cpu_graph_t &g, const cpu_node_t &node)
+    {
+        const cpu_tensor_t &tx = g.tensors[node.in[0]];
+        const cpu_tensor_t &ty = g.tensors[node.out[0]];
+        int C = tx.shape[1], H = tx.shape[2], W = tx.shape[3];
+        int OH = ty.shape[2], OW = ty.shape[3];
+        g.workers.run(C, [&](int c, int) {
+            const float *x = tx.data + c * H * W;
+            float *y = ty.data + c * OH * OW;
+            for (int oy = 0; oy < OH; ++oy)
+            {
+                const float *row = x + oy * H / OH * W;
+                for (int ox = 0; ox < OW; ++ox)
+                    y[oy * OW + ox] = row[ox * W / OW];
+            }
+        });
+    }
+
+    static void _transpose(cpu_graph_t &g, const cpu_node_t &node)
+    {
+        const cpu_tensor_t &tx = g.tensors[node.in[0]];
+        const cpu_tensor_t &ty = g.tensors[node.out[0]];
+        int r = tx.shape.size();
+        int in_strides[MAX_DIMS], strides[MAX_DIMS], idx[MAX_DIMS] = {0};
+        int s = 1;
+        for (int d = r - 1; d >= 0; --d)
+        {
+            in_strides[d] = s;
+            s *= tx.shape[d];
+        }
+        for (int d = 0; d < r; ++d)
+            strides[d] = in_strides[node.ip[d]];
+        int inner = ty.shape[r - 1];
+        int inner_stride = strides[r - 1];
+        for (int o = 0; o < ty.size / inner; ++o)
+        {
+            int offset = 0;
+            for (int d = 0; d < r - 1; ++d)
+                offset += idx[d] * strides[d];
+            const float *x = tx.data + offset;
+            float *y = ty.data + o * inner;
+            for (int i = 0; i < inner; ++i)
+                y[i] = x[i * inner_stride];
+            for (int d = r - 2; d >= 0; --d)
+            {
+                if (++idx[d] < ty.shape[d])
+                    break;
+                idx[d] = 0;
+            }
+        }
+    }
+
+    static void _softmax(cpu_graph_t &g, const cpu_node_t &node)
+    {
+        const cpu_tensor_t &tx = g.tensors[node.in[0]];
+        float *y = g.tensors[node.out[0]].data;
+        int axis = node.ip[0];
+        int outer, inner;
+        _outer_inner(tx.shape, axis, outer, inner);
+        int len = tx.shape[axis];
+        for (int o = 0; o < outer; ++o)
+        {
+            for (int i = 0; i < inner; ++i)
+            {
+                const float *x = tx.data + o * len * inner + i;
+                float *out = y + o * len * inner + i;
+                float max = x[0];
+                for (int k = 1; k < len; ++k)
+                    max = std::max(max, x[k * inner]);
+                float sum = 0;
+                for (int k = 0; k < len; ++k)
+                {
+                    out[k * inner] = expf(x[k * inner] - max);
+                    sum += out[k * inner];
+                }
+                for (int k = 0; k < len; ++k)
+                    out[k * inner] /= sum;
+            }
+        }
+    }
+
+    static bool _positive(const int *v, int n)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            if (v[i] <= 0)
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * Check ranks and shapes a node's kernel relies on, so a broken model file never reads or writes out of buffers.
+     * Indices and params number are checked by caller.
+     */
+    static bool _check_node(const cpu_graph_t &g, const cpu_node_t &n)
+    {
+        const std::vector<int> &xs = g.tensors[n.in[0]].shape;
+        const std::vector<int> &ys = g.tensors[n.out[0]].shape;
+        const cpu_tensor_t &tx = g.tensors[n.in[0]];
+        const cpu_tensor_t &ty = g.tensors[n.out[0]];
+        int rank = ys.size();
+        const int *ip = n.ip.data();
+        switch (n.op)
+        {
+        case OP_CONV:
+        {
+            // kh, kw, sh, sw > 0, pads >= 0, dh, dw, group > 0
+            if (n.in.size() < 2 || n.in.size() > 3 || xs.size() != 4 || rank != 4 || xs[0] != 1 || ys[0] != 1)
+                return false;
+            if (!_positive(ip, 4) || ip[4] < 0 || ip[5] < 0 || ip[6] < 0 || ip[7] < 0 || !_positive(ip + 8, 3))
+                return false;
+            const std::vector<int> &ws = g.tensors[n.in[1]].shape;
+            int group = ip[10];
+            if (xs[1] % group || ys[1] % group || ws.size() != 4 || ws[0] != ys[1] || ws[1] != xs[1] / group || ws[2] != ip[0] || ws[3] != ip[1])
+                return false;
+            return n.in.size() < 3 || g.tensors[n.in[2]].size == ys[1];
+        }
+        case OP_ACT:
+        case OP_RESHAPE:
+            return n.in.size() == 1 && tx.size == ty.size;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV:
+        {
+            if (n.in.size() != 2 || rank < 1)
+                return false;
+            for (int i : n.in)
+            {
+                const std::vector<int> &s = g.tensors[i].shape;
+                if (s.size() > ys.size())
+                    return false;
+                int offset = rank - s.size();
+                for (size_t d = 0; d < s.size(); ++d)
+                {
+                    if (s[d] != 1 && s[d] != ys[d + offset])
+                        return false;
+                }
+            }
+            return true;
+        }
+        case OP_CONCAT:
+        {
+            int axis = ip[0];
+            if (axis < 0 || axis >= rank)
+                return false;
+            int sum = 0;
+            for (int i : n.in)
+            {
+                const std::vector<int> &s = g.tensors[i].shape;
+                if ((int)s.size() != rank)
+                    return false;
+                for (int d = 0; d < rank; ++d)
+                {
+                    if (d != axis && s[d] != ys[d])
+                        return false;
+                }
+                sum += s[axis];
+            }
+            return sum == ys[axis];
+        }
+        case OP_SLICE:
+        {
+            int axis = ip[0], start = ip[1], step = ip[2];
+            if (n.in.size() != 1 || axis < 0 || axis >= rank || (int)xs.size() != rank || start < 0 || step <= 0)
+                return false;
+            for (int d = 0; d < rank; ++d)
+            {
+                if (d != axis && xs[d] != ys[d])
+                    return false;
+            }
+            return (int64_t)start + (int64_t)(ys[axis] - 1) * step < xs[axis];
+        }
+        case OP_MAXPOOL:
+        case OP_AVGPOOL:
+            if (!_positive(ip, 4))
+                return false;
+            // fall through
+        case OP_RESIZE_NEAREST:
+            return n.in.size() == 1 && xs.size() == 4 && rank == 4 && xs[0] == 1 && ys[0] == 1 && xs[1] == ys[1];
+        case OP_GLOBAL_AVGPOOL:
+            return n.in.size() == 1 && xs.size() >= 2 && xs[0] == 1 && ty.size == xs[1];
+        case OP_TRANSPOSE:
+        {
+            if (n.in.size() != 1 || n.ip.size() != xs.size() || (int)xs.size() != rank || rank < 1)
+                return false;
+            bool used[MAX_DIMS] = {false};
+            for (int d = 0; d < rank; ++d)
+            {
+                if (ip[d] < 0 || ip[d] >= rank || used[ip[d]] || ys[d] != xs[ip[d]])
+                    return false;
+                used[ip[d]] = true;
+            }
+            return true;
+        }
+        case OP_SOFTMAX:
+            return n.in.size() == 1 && ip[0] >= 0 && ip[0] < (int)xs.size() && tx.size == ty.size;
+        case OP_GEMM:
+        {
+            const std::vector<int> &ws = g.tensors[n.in[1]].shape;
+            if (n.in.size() < 2 || n.in.size() > 3 || ws.size() != 2 || tx.size % ws[1] || (int64_t)tx.size / ws[1] * ws[0] != ty.size)
+                return false;
+            return n.in.size() < 3 || g.tensors[n.in[2]].size == ws[0];
+        }
+        default:
+            return false;
+        }
+    }
+
+    class ModelReader
+    {
+    public:
+        ModelReader(FILE *fp) : _fp(fp), ok(true) {}
+        uint32_t u32()
+        {
+            uint32_t v = 0;
+            read(&v, 4);
+            return v;
+        }
+        void read(void *data, size_t size)
+        {
+            if (ok && size > 0 && fread(data, 1, size, _fp) != size)
+                ok = false;
+        }
+        std::vector<int> i32_array()
+        {
+            uint32_t n = u32();
+            if (n > 1024)
+            {
+                ok = false;
+                return {};
+            }
+            std::vector<int> v(n);
+            read(v.data(), n * 4);
+            return v;
+        }
+
+    private:
+        FILE *_fp;
+
+    public:
+        bool ok;
+    };
+
+    static err::Err _load_graph(cpu_graph_t &g, const std::string &path)
+    {
+        FILE *fp = fopen(path.c_str(), "rb");
+        if (!fp)
+        {
+            log::error("open model file %s failed\n", path.c_str());
+            return err::ERR_ARGS;
+        }
+        ModelReader r(fp);
+        char magic[4] = {0};
+        r.read(magic, 4);
+        uint32_t version = r.u32();
+        if (!r.ok || memcmp(magic, "MXNN", 4) != 0 || version != MXNN_VERSION)
+        {
+            log::error("%s is not maixnn model or version not support\n", path.c_str());
+            fclose(fp);
+            return err::ERR_ARGS;
+        }
+        uint32_t tensor_num = r.u32();
+        if (tensor_num > MAX_TENSORS)
+            r.ok = false;
+        g.tensors.resize(r.ok ? tensor_num : 0);
+        for (auto &t : g.tensors)
+        {
+            uint32_t name_len = r.u32();
+            if (!r.ok || name_len > 4096)
+            {
+                r.ok = false;
+                break;
+            }
+            t.name.resize(name_len);
+            r.read(&t.name[0], name_len);
+            t.shape = r.i32_array();
+            int64_t size = 1;
+            for (int d : t.shape)
+            {
+                if (d <= 0 || (size *= d) > MAX_TENSOR_SIZE)
+                {
+                    r.ok = false;
+                    break;
+                }
+            }
+            t.size = r.ok ? (int)size : 0;
+            if (t.shape.size() > MAX_DIMS)
+                r.ok = false;
+            if (r.u32() && r.ok)
+            {
+                t.is_const = true;
+                t.data = _alloc_floats(t.size);
+                if (!t.data)
+                {
+                    fclose(fp);
+                    return err::ERR_NO_MEM;
+                }
+                r.read(t.data, t.size * sizeof(float));
+            }
+        }
+        uint32_t node_num = r.u32();
+        if (node_num > MAX_NODES)
+            r.ok = false;
+        g.nodes.resize(r.ok ? node_num : 0);
+        for (auto &n : g.nodes)
+        {
+            n.op = r.u32();
+            n.in = r.i32_array();
+            n.out = r.i32_array();
+            n.ip = r.i32_array();
+            uint32_t fp_num = r.u32();
+            if (!r.ok || fp_num > 64)
+            {
+                r.ok = false;
+                break;
+            }
+            n.fp.resize(fp_num);
+            r.read(n.fp.data(), fp_num * 4);
+        }
+        g.inputs = r.i32_array();
+        g.outputs = r.i32_array();
+        fclose(fp);
+        if (!r.ok)
+        {
+            log::error("model file %s broken\n", path.c_str());
+            return err::ERR_ARGS;
+        }
+        // check nodes
+        static const int param_num[OP_MAX] = {12, 1, 0, 0, 0, 0, 1, 3, 8, 8, 0, 0, 0, -1, 1, 1};
+        for (auto &n : g.nodes)
+        {
+            bool valid = n.op >= 0 && n.op < OP_MAX && n.in.size() > 0 && n.out.size() == 1;
+            for (int i : n.in)
+                valid = valid && i >= 0 && i < (int)tensor_num;
+            for (int i : n.out)
+                valid = valid && i >= 0 && i < (int)tensor_num && !g.tensors[i].is_const;
+            if (valid && param_num[n.op] >= 0)
+                valid = (int)n.ip.size() >= param_num[n.op];
+            if (valid)
+                valid = _check_node(g, n);
+            if (!valid)
+            {
+                log::error("model file %s has invalid node, op: %d\n", path.c_str(), n.op);
+                return err::ERR_ARGS;
+            }
+        }
+        if (g.inputs.empty() || g.outputs.empty())
+        {
+            log::error("model file %s has no input or output\n", path.c_str());
+            return err::ERR_ARGS;
+        }
+        for (int i : g.inputs)
+        {
+            if (i < 0 || i >= (int)tensor_num)
+                return err::ERR_ARGS;
+        }
+        for (int i : g.outputs)
+        {
+            if (i < 0 || i >= (int)tensor_num)
+                return err::ERR_ARGS;
+        }
+        return err::ERR_NONE;
+    }
+
+    /**
+     * Assign activation buffers, a buffer will be reused after the last node use it finished.
+     * Inputs and outputs of graph have their own buffers.
+     */
+    static err::Err _plan_buffers(cpu_graph_t &g)
+    {
+        std::vector<int> last_use(g.tensors.size(), -1);
+        std::vector<size_t> buff_sizes;
+        std::vector<int> free_buffs;
+        for (size_t i = 0; i < g.nodes.size(); ++i)
+        {
+            for (int t : g.nodes[i].in)
+                last_use[t] = i;
+        }
+        auto new_buff = [&](int size) {
+            buff_sizes.push_back(size);
+            return (int)buff_sizes.size() - 1;
+        };
+        for (int t : g.inputs)
+            g.tensors[t].buff_id = new_buff(g.tensors[t].size);
+        for (int t : g.outputs)
+        {
+            last_use[t] = INT_MAX;
+            if (g.tensors[t].buff_id < 0)
+                g.tensors[t].buff_id = new_buff(g.tensors[t].size);
+        }
+        for (int t : g.inputs)
+            last_use[t] = INT_MAX;
+        for (size_t i = 0; i < g.nodes.size(); ++i)
+        {
+            for (int t : g.nodes[i].out)
+            {
+                cpu_tensor_t &tensor = g.tensors[t];
+                if (tensor.buff_id >= 0)
+                    continue;
+                // smallest free buffer big enough, or the biggest one and grow it
+                int best = -1;
+                for (size_t k = 0; k < free_buffs.size(); ++k)
+                {
+                    size_t s = buff_sizes[free_buffs[k]];
+                    if (best < 0)
+                        best = k;
+                    else
+                    {
+                        size_t bs = buff_sizes[free_buffs[best]];
+                        if ((s >= (size_t)tensor.size && (bs < (size_t)tensor.size || s < bs)) || (bs < (size_t)tensor.size && s > bs))
+                            best = k;
+                    }
+                }
+                if (best < 0)
+                    tensor.buff_id = new_buff(tensor.size);
+                else
+                {
+                    tensor.buff_id = free_buffs[best];
+                    free_buffs.erase(free_buffs.begin() + best);
+                    buff_sizes[tensor.buff_id] = std::max(buff_sizes[tensor.buff_id], (size_t)tensor.size);
+                }
+            }
+            auto release = [&](int t) {
+                cpu_tensor_t &tensor = g.tensors[t];
+                if (tensor.is_const || last_use[t] == INT_MAX || last_use[t] > (int)i || tensor.buff_id < 0)
+                    return;
+                if (std::find(free_buffs.begin(), free_buffs.end(), tensor.buff_id) == free_buffs.end())
+                    free_buffs.push_back(tensor.buff_id);
+            };
+            for (int t : g.nodes[i].in)
+                release(t);
+            for (int t : g.nodes[i].out)
+                release(t); // output never used
+        }
+        for (size_t size : buff_sizes)
+        {
+            float *p = _alloc_floats(size);
+            if (!p)
+                return err::ERR_NO_MEM;
+            g.buffers.push_back(p);
+        }
+        for (auto &t : g.tensors)
+        {
+            if (!t.is_const)
+            {
+                if (t.buff_id < 0)
+                {
+                    log::error("tensor %s not produced by any node\n", t.name.c_str());
+                    return err::ERR_ARGS;
+                }
+                t.data = g.buffers[t.buff_id];
+            }
+        }
+        // im2col workspace
+        size_t workspace = 8;
+        for (auto &n : g.nodes)
+        {
+            if (n.op == OP_CONV)
+            {
+                const std::vector<int> &ws = g.tensors[n.in[1]].shape;
+                workspace = std::max(workspace, (size_t)ws[1] * ws[2] * ws[3] * CONV_NT);
+            }
+        }
+        for (int i = 0; i < g.workers.num(); ++i)
+        {
+            float *p = _alloc_floats(workspace);
+            if (!p)
+                return err::ERR_NO_MEM;
+            g.workspace.push_back(p);
+        }
+        size_t total = 0;
+        for (size_t size : buff_sizes)
+            total += size * sizeof(float);
+        log::debug("nn cpu: %ld activation buffers, %ld bytes\n", buff_sizes.size(), total);
+        return err::ERR_NONE;
+    }
+
+    NN_CPU::NN_CPU(bool dual_buff)
+    {
+        _graph = nullptr;
+    }
+
+    NN_CPU::~NN_CPU()
+    {
+        unload();
+    }
+
+    err::Err NN_CPU::load(const MUD &mud, const std::string &dir)
+    {
+        if (_graph)
+        {
+            log::error("model already loaded\n");
+            return err::ERR_NOT_PERMIT;
+        }
+        if (mud.type != "maixnn")
+        {
+            log::error("model type %s not support, only support maixnn on this platform\n", mud.type.c_str());
+            return err::ERR_ARGS;
+        }
+        auto basic = mud.items.find("basic");
+        if (basic == mud.items.end() || basic->second.find("model") == basic->second.end())
+        {
+            log::error("model key not found in basic section\n");
+            return err::ERR_ARGS;
+        }
+        int threads = thread::parallel_threads();
+        auto it = basic->second.find("threads");
+        if (it != basic->second.end())
+        {
+            try
+            {
+                threads = std::stoi(it->second);
+            }
+            catch (std::exception &e)
+            {
+                log::error("threads value error, should int\n");
+                return err::ERR_ARGS;
+            }
+        }
+        cpu_graph_t *g = new cpu_graph_t();
+        std::string path = dir + "/" + basic->second.at("model");
+        err::Err e = _load_graph(*g, path);
+        if (e == err::ERR_NONE)
+        {
+            g->workers.start(threads > 0 ? threads : 1);
+            e = _plan_buffers(*g);
+        }
+        if (e != err::ERR_NONE)
+        {
+            delete g;
+            return e;
+        }
+        _graph = g;
+        return err::ERR_NONE;
+    }
+
+    err::Err NN_CPU::unload()
+    {
+        if (_graph)
+        {
+            delete (cpu_graph_t *)_graph;
+            _graph = nullptr;
+        }
+        return err::ERR_NONE;
+    }
+
+    bool NN_CPU::loaded()
+    {
+        return _graph != nullptr;
+    }
+
+    void NN_CPU::set_dual_buff(bool enable)
+    {
+    }
+
+    std::vector<LayerInfo> NN_CPU::inputs_info()
+    {
+        std::vector<LayerInfo> infos;
+        cpu_graph_t *g = (cpu_graph_t *)_graph;
+        if (!g)
+            return infos;
+        for (int i : g->inputs)
+            infos.push_back(LayerInfo(g->tensors[i].name, tensor::FLOAT32, g->tensors[i].shape));
+        return infos;
+    }
+
+    std::vector<LayerInfo> NN_CPU::outputs_info()
+    {
+        std::vector<LayerInfo> infos;
+        cpu_graph_t *g = (cpu_graph_t *)_graph;
+        if (!g)
+            return infos;
+        for (int i : g->outputs)
+            infos.push_back(LayerInfo(g->tensors[i].name, tensor::FLOAT32, g->tensors[i].shape));
+        return infos;
+    }
+
+    err::Err NN_CPU::_run()
+    {
+        cpu_graph_t &g = *(cpu_graph_t *)_graph;
+        for (const cpu_node_t &node : g.nodes)
+        {
+            const cpu_tensor_t &tx = g.tensors[node.in[0]];
+            const cpu_tensor_t &ty = g.tensors[node.out[0]];
+            switch (node.op)
+            {
+            case OP_CONV:
+                _conv(g, node);
+                break;
+            case OP_ACT:
+                if (ty.data != tx.data)
+                    memcpy(ty.data, tx.data, ty.size * sizeof(float));
+                _act_array(ty.data, ty.size, node.ip[0], node.fp.empty() ? 0 : node.fp[0]);
+                break;
+            case OP_ADD:
+            case OP_SUB:
+            case OP_MUL:
+            case OP_DIV:
+                _binary_op(g, node);
+                break;
+            case OP_CONCAT:
+                _concat(g, node);
+                break;
+            case OP_SLICE:
+                _slice(g, node);
+                break;
+            case OP_MAXPOOL:
+            case OP_AVGPOOL:
+                _pool(g, node);
+                break;
+            case OP_GLOBAL_AVGPOOL:
+                _global_avgpool(g, node);
+                break;
+            case OP_RESIZE_NEAREST:
+                _resize_nearest(g, node);
+                break;
+            case OP_RESHAPE:
+                memcpy(ty.data, tx.data, ty.size * sizeof(float));
+                break;
+            case OP_TRANSPOSE:
+                _transpose(g, node);
+                break;
+            case OP_SOFTMAX:
+                _softmax(g, node);
+                break;
+            case OP_GEMM:
+                _gemm(g, node);
+                break;
+            default:
+                return err::ERR_NOT_IMPL;
+            }
+        }
+        return err::ERR_NONE;
+    }
+
+    void NN_CPU::_get_outputs(tensor::Tensors &outputs, bool copy_result)
+    {
+        cpu_graph_t &g = *(cpu_graph_t *)_graph;
+        for (int i : g.outputs)
+        {
+            cpu_tensor_t &t = g.tensors[i];
+            auto it = outputs.tensors.find(t.name);
+            if (it != outputs.tensors.end() && it->second)
+            {
+                if (it->second->size_int() != t.size || it->second->dtype() != tensor::FLOAT32)
+                    throw err::Exception(err::ERR_ARGS, "output tensor " + t.name + " size or dtype not match");
+                memcpy(it->second->data(), t.data, t.size * sizeof(float));
+                continue;
+            }
+            tensor::Tensor *out;
+            if (copy_result)
+            {
+                out = new tensor::Tensor(t.shape, tensor::FLOAT32);
+                memcpy(out->data(), t.data, t.size * sizeof(float));
+            }
+            else
+                out = new tensor::Tensor(t.shape, tensor::FLOAT32, t.data);
+            outputs.add_tensor(t.name, out, false, true);
+        }
+    }
+
+    err::Err NN_CPU::forward(tensor::Tensors &inputs, tensor::Tensors &outputs, bool copy_result, bool dual_buff_wait)
+    {
+        cpu_graph_t *g = (cpu_graph_t *)_graph;
+        if (!g)
+            return err::ERR_NOT_INIT;
+        for (int i : g->inputs)
+        {
+            cpu_tensor_t &t = g->tensors[i];
+            auto it = inputs.tensors.find(t.name);
+            if (it == inputs.tensors.end() && g->inputs.size() == 1 && inputs.size() == 1)
+                it = inputs.begin();
+            if (it == inputs.tensors.end() || !it->second || it->second->size_int() != t.size)
+            {
+                log::error("input %s not found or size not match\n", t.name.c_str());
+                return err::ERR_ARGS;
+            }
+            if (it->second->dtype() == tensor::FLOAT32)
+                memcpy(t.data, it->second->data(), t.size * sizeof(float));
+            else if (it->second->dtype() == tensor::UINT8)
+            {
+                const uint8_t *src = (const uint8_t *)it->second->data();
+                for (int k = 0; k < t.size; ++k)
+                    t.data[k] = src[k];
+            }
+            else
+            {
+                log::error("input dtype %s not support\n", tensor::dtype_name[it->second->dtype()].c_str());
+                return err::ERR_ARGS;
+            }
+        }
+        err::Err e = _run();
+        if (e != err::ERR_NONE)
+            return e;
+        _get_outputs(outputs, copy_result);
+        return err::ERR_NONE;
+    }
+
+    tensor::Tensors *NN_CPU::forward(tensor::Tensors &inputs, bool copy_result, bool dual_buff_wait)
+    {
+        tensor::Tensors *outputs = new tensor::Tensors();
+        err::Err e = forward(inputs, *outputs, copy_result, dual_buff_wait);
+        if (e != err::ERR_NONE)
+        {
+            delete outputs;
+            throw err::Exception(e, "forward failed");
+        }
+        return outputs;
+    }
+
+    tensor::Tensors *NN_CPU::forward_image(image::Image &img, std::vector<float> mean, std::vector<float> scale, image::Fit fit, bool copy_result, bool dual_buff_wait)
+    {
+        cpu_graph_t *g = (cpu_graph_t *)_graph;
+        if (!g)
+            throw err::Exception(err::ERR_NOT_INIT, "model not loaded");
+        if (g->inputs.empty())
+            throw err::Exception(err::ERR_ARGS, "model has no input");
+        cpu_tensor_t &input = g->tensors[g->inputs[0]];
+        if (input.shape.size() != 4)
+            throw err::Exception(err::ERR_ARGS, "model input is not image");
+        bool chw = input.shape[1] == 1 || input.shape[1] == 3;
+        int c = chw ? input.shape[1] : input.shape[3];
+        int h = chw ? input.shape[2] : input.shape[1];
+        int w = chw ? input.shape[3] : input.shape[2];
+        if (c != 1 && c != 3)
+            throw err::Exception(err::ERR_ARGS, "model input channel should be 1 or 3");
+
+        // fit, resize, color convert and normalize in one pass, write to input tensor directly
+        image::Image *converted = nullptr;
+        image::Image *p = &img;
+        image::Format src_fmt = img.format();
+        if (src_fmt != image::FMT_RGB888 && src_fmt != image::FMT_BGR888 && src_fmt != image::FMT_RGBA8888 && src_fmt != image::FMT_BGRA8888 &&
+            src_fmt != image::FMT_GRAYSCALE && src_fmt != image::FMT_YVU420SP && src_fmt != image::FMT_YUV420SP)
+        {
+            converted = img.to_format(image::FMT_RGB888);
+            p = converted;
+        }
+        image::Format fmt = c == 1 ? image::FMT_GRAYSCALE : (src_fmt == image::FMT_BGR888 ? image::FMT_BGR888 : image::FMT_RGB888);
+        err::Err e = image::preprocessor().run(*p, input.data, w, h, fmt, tensor::FLOAT32, chw, mean, scale, fit);
+        if (converted)
+            delete converted;
+        if (e != err::ERR_NONE)
+            throw err::Exception(e, "preprocess image failed");
+
+        e = _run();
+        if (e != err::ERR_NONE)
+            throw err::Exception(e, "forward failed");
+        tensor::Tensors *outputs = new tensor::Tensors();
+        _get_outputs(*outputs, copy_result);
+        return outputs;
+    }
+
+} // namespace maix::nn
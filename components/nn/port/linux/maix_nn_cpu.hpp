@@ -0,0 +1,94 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add CPU backend for Linux.
+ */
+
+#pragma once
+
+#include "maix_nn.hpp"
+#include "maix_image.hpp"
+
+namespace maix::nn
+{
+    /**
+     * Run maixnn format model on CPU, multi threads, used by Linux platform.
+     * MUD basic section: type = maixnn, model = model file path relative to mud file,
+     * threads = max thread number, optional, default is thread::parallel_threads()(CPU core number by default),
+     * threads are from the process wide thread pool.
+     * maixnn file can be converted from ONNX by tools/nn/onnx2maixnn.py.
+     */
+    class NN_CPU : public NNBase
+    {
+    public:
+        NN_CPU(bool dual_buff = true);
+        ~NN_CPU();
+
+        /**
+         * Load model from file
+         * @param[in] mud simply parsed model describe object
+         * @return error code, if load success, return err::ERR_NONE
+         */
+        virtual err::Err load(const MUD &mud, const std::string &dir) final;
+
+        /**
+         * Unload model
+         * @return error code, if unload success, return err::ERR_NONE
+         */
+        virtual err::Err unload() final;
+
+        /**
+         * Is model loaded
+         * @return true if model loaded, else false
+         */
+        virtual bool loaded() final;
+
+        /**
+         * Enable dual buff or disable dual buff, CPU backend always run synchronously, so this takes no effect.
+         * @param enable true to enable, false to disable
+         */
+        virtual void set_dual_buff(bool enable);
+
+        /**
+         * Get model input layer info
+         * @return input layer info
+         */
+        std::vector<LayerInfo> inputs_info();
+
+        /**
+         * Get model output layer info
+         * @return output layer info
+         */
+        std::vector<LayerInfo> outputs_info();
+
+        /**
+         * forward run model, get output of model
+         * @param[in] input input tensor
+         * @param[out] output output tensor
+         * @return error code, if forward success, return err::ERR_NONE
+         */
+        virtual err::Err forward(tensor::Tensors &inputs, tensor::Tensors &outputs, bool copy_result = true, bool dual_buff_wait = false) final;
+
+        /**
+         * forward run model, get output of model,
+         * this is specially for MaixPy, not efficient, but easy to use in MaixPy
+         * @param[in] input input tensor
+         * @return output tensor
+         */
+        virtual tensor::Tensors *forward(tensor::Tensors &inputs, bool copy_result = true, bool dual_buff_wait = false) final;
+
+        /**
+         * forward model, param is image
+         * @param[in] img input image
+         * @return output tensor
+         */
+        virtual tensor::Tensors *forward_image(image::Image &img, std::vector<float> mean = std::vector<float>(), std::vector<float> scale = std::vector<float>(), image::Fit fit = image::Fit::FIT_CONTAIN, bool copy_result = true, bool dual_buff_wait = false) final;
+
+    private:
+        void *_graph;
+        err::Err _run();
+        void _get_outputs(tensor::Tensors &outputs, bool copy_result);
+    };
+
+} // namespace maix::nn
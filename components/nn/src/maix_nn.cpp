@@ -13,6 +13,8 @@
 
 #if PLATFORM_MAIXCAM
     #include "maix_nn_maixcam.hpp"
+#elif PLATFORM_LINUX
+    #include "maix_nn_cpu.hpp"
 #endif
 
 
@@ -109,6 +111,8 @@ namespace maix::nn
         _impl = nullptr;
 #if PLATFORM_MAIXCAM
         _impl = new NN_MaixCam(dual_buff);
+#elif PLATFORM_LINUX
+        _impl = new NN_CPU(dual_buff);
 #endif
         if(!_impl)
         {
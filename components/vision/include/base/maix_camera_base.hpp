@@ -149,6 +149,15 @@ namespace maix::camera
          * @return returns exposure mode
         */
         virtual int exp_mode(int value = -1) = 0;
+
+        /**
+         * Set zero copy read mode
+         * @param enable if true, read will return image use driver buffer directly when not need convert format,
+         *               buffer will give back to driver when image destroyed.
+         * @param max_hold max frames user can hold at the same time
+         * @return error code, err::ERR_NOT_IMPL if not supported
+        */
+        virtual err::Err set_zero_copy(bool enable, int max_hold = 1) { return err::ERR_NOT_IMPL; }
     };
 
 }
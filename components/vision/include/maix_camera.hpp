@@ -112,6 +112,19 @@ namespace maix::camera
         */
         image::Image *read(void *buff = nullptr, size_t buff_size = 0, bool block = true);
 
+        /**
+         * Set zero copy read mode, read will return image use camera driver buffer directly
+         * if camera output format is the same as driver native format, this will avoid one frame copy.
+         * The buffer will be given back to driver only when the image object is destroyed,
+         * so release image as soon as possible, or the camera will drop frames.
+         * @param enable enable or disable zero copy mode
+         * @param max_hold max frames user can hold at the same time, should less than buff_num,
+         *                 if reach this limit, read will return nullptr(raise exception).
+         * @return error code, err::ERR_NONE means success, err::ERR_NOT_IMPL means platform not support
+         * @maixpy maix.camera.Camera.set_zero_copy
+        */
+        err::Err set_zero_copy(bool enable, int max_hold = 1);
+
         /**
          * Clear buff to ensure the next read image is the latest image
          * @maixpy maix.camera.Camera.clear_buff
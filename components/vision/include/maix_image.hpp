@@ -14,8 +14,10 @@
 #include "maix_image_def.hpp"
 #include "maix_image_color.hpp"
 #include "maix_image_obj.hpp"
+#include "maix_image_pool.hpp"
 #include "maix_type.hpp"
 #include <stdlib.h>
+#include <functional>
 
 /**
  * @brief maix.image module, image related definition and functions
@@ -97,6 +99,11 @@ namespace maix::image
             _data_size = 0;
             _is_malloc = false;
         }
+        /**
+         * Copy constructor, copy image data to new buffer.
+         * Release callback and derived image cache are not copied, only the source image gives its buffer back.
+         */
+        Image(const image::Image &img);
         ~Image();
 
         /**
@@ -105,8 +112,19 @@ namespace maix::image
          */
         err::Err update(int width, int height, image::Format format, uint8_t *data = NULL, int data_size = 0, bool copy = true);
 
+        /**
+         * Copy image data to this image, release callback and derived image cache of img are not copied.
+         */
         void operator=(const image::Image &img);
 
+        /**
+         * Set release callback, will be called when image destroyed or image data updated,
+         * usually used when image not copy data(copy arg is false) and data should be given back to the owner, e.g. camera driver buffer.
+         * @param callback callback function, arg is image data pointer, set to nullptr to remove callback
+         * @maixcdk maix.image.Image.set_release_callback
+         */
+        void set_release_callback(std::function<void(void *)> callback) { _release_cb = callback; }
+
         //************************** get and set basic info **************************//
 
         /**
@@ -256,6 +274,7 @@ namespace maix::image
                 return err::Err::ERR_RUNTIME;
             }
 
+            invalidate_cache();
             switch (_format) {
             case image::Format::FMT_RGB888: // fall through
             case image::Format::FMT_BGR888:
@@ -356,18 +375,70 @@ namespace maix::image
         */
         image::Image *to_jpeg(int quality = 95);
 
+        //************************** derived image cache **************************//
+        // Derived images are converted on demand and kept in this image until it's modified,
+        // so find_xxx methods called on the same frame share them.
+        // draw and image operation methods clear the cache automatically.
+
+        /**
+         * Get grayscale image of this image from cache, convert if not cached yet.
+         * @param roi only make sure area [x, y, w, h] is converted, content out of roi is undefined, default empty means whole image.
+         * @return GRAYSCALE image, owned by this image, don't delete it, it's invalid after cache invalidated or this image destroyed.
+         *         For GRAYSCALE image return this image itself, for YUV image return a view of Y plane without copy.
+         * @throw err.Exception if format not support or roi invalid.
+         * @maixcdk maix.image.Image.cached_gray
+         */
+        image::Image *cached_gray(const std::vector<int> &roi = std::vector<int>());
+
+        /**
+         * Get color working copy of this image from cache, convert if not cached yet.
+         * Only one color format is cached, request another format will drop the former one.
+         * @param format RGB565, RGB888 or BGR888, default RGB565 which imlib LAB algorithms look up LAB directly.
+         * @param roi only make sure area [x, y, w, h] is converted, content out of roi is undefined, default empty means whole image.
+         * @return image of format, owned by this image, don't delete it, it's invalid after cache invalidated or this image destroyed.
+         *         If this image is already the format, return this image itself.
+         * @throw err.Exception if format not support or roi invalid.
+         * @maixcdk maix.image.Image.cached_color
+         */
+        image::Image *cached_color(image::Format format = image::FMT_RGB565, const std::vector<int> &roi = std::vector<int>());
+
+        /**
+         * Get integral image(summed area table) of grayscale image from cache, compute if not cached yet.
+         * @param roi only make sure rows above roi bottom are computed, default empty means whole image.
+         * @return (height + 1) rows x (width + 1) columns table, value at [y * (width + 1) + x] is sum of gray pixels in rect [0, 0, x, y],
+         *         so sum of rect [x, y, w, h] is t[y1][x1] - t[y0][x1] - t[y1][x0] + t[y0][x0], where x0 = x, y0 = y, x1 = x + w, y1 = y + h.
+         *         Owned by this image, it's invalid after cache invalidated or this image destroyed.
+         *         uint32 sum is enough for images not larger than 16M pixels.
+         * @throw err.Exception if format not support or roi invalid.
+         * @maixcdk maix.image.Image.cached_integral
+         */
+        const uint32_t *cached_integral(const std::vector<int> &roi = std::vector<int>());
+
+        /**
+         * Clear derived image cache, the buffers are kept for next use.
+         * Should be called after modifying image data by data() pointer directly, e.g. reuse image buffer for next frame.
+         * @maixcdk maix.image.Image.invalidate_cache
+         */
+        void invalidate_cache();
+
         //************************** draw **************************//
 
         /**
-         * Draw image on this image
-         * @param x left top corner of image point's coordinate x
-         * @param y left top corner of image point's coordinate y
-         * @param img image object to draw, the caller's channel must <= the args' channel,
-         *            e.g. caller is RGB888, args is RGBA8888, will throw exception, but caller is RGBA8888, args is RGB888 or RGBA8888 is ok
+         * Draw image on this image, blend with premultiplied alpha, the part outside this image is clipped.
+         * Support GRAYSCALE, RGB888, BGR888, RGBA8888, BGRA8888, YUV422SP, YUV422P, YVU420SP, YUV420SP, YVU420P and YUV420P,
+         * both images can be any of them, img is converted row by row, no whole image conversion.
+         * For repeated drawing of the same images(e.g. UI on camera frames), use image.Overlay instead.
+         * @param x left top corner of image point's coordinate x, aligned down to even for YUV formats
+         * @param y left top corner of image point's coordinate y, aligned down to even for YUV420 formats
+         * @param img image object to draw, RGBA8888 and BGRA8888 use alpha channel, other formats are opaque.
+         * @param mode blend mode, see image.BlendMode, default source over.
+         *             For YUV formats, additive and multiply only work on Y, chroma uses source over.
+         * @param alpha global alpha of img, [0, 1], multiply to alpha channel of img
          * @return this image object self
+         * @throw err::Exception if format not support, e.g. RGB565 or compressed formats
          * @maixpy maix.image.Image.draw_image
          */
-        image::Image *draw_image(int x, int y, image::Image &img);
+        image::Image *draw_image(int x, int y, image::Image &img, image::BlendMode mode = image::BLEND_SRC_OVER, float alpha = 1);
 
         /**
          * Fill rectangle color to image
@@ -438,6 +509,21 @@ namespace maix::image
         image::Image *draw_string(int x, int y, const std::string &textstring, const image::Color &color = image::COLOR_WHITE, float scale = 1, int thickness = -1,
                                 bool wrap = true, int wrap_space = 4, const std::string &font = "");
 
+        /**
+         * Draw many texts on image in one call, no auto wrap, faster than draw_string one by one,
+         * e.g. labels and scores of detected objects.
+         * @param points left top points of texts, [x0, y0, x1, y1, ...], size should be 2 * texts size
+         * @param texts text contents
+         * @param colors text colors @see image::Color, only one color for all texts, or one color for every text
+         * @param scale font scale, by default(value is 1)
+         * @param thickness text thickness(line width), if negative, the glyph is filled, by default(value is -1)
+         * @param font font name, empty means use default font, by default(value is "")
+         * @return this image object self
+         * @maixpy maix.image.Image.draw_strings
+         */
+        image::Image *draw_strings(const std::vector<int> &points, const std::vector<std::string> &texts, const std::vector<image::Color> &colors,
+                                   float scale = 1, int thickness = -1, const std::string &font = "");
+
         /**
          * Draw cross on image
          * @param x cross center point's coordinate x
@@ -492,7 +578,10 @@ namespace maix::image
          * @param width new width, if value is -1, will use height to calculate aspect ratio
          * @param height new height, if value is -1, will use width to calculate aspect ratio
          * @param object_fit fill, contain, cover, by default is fill
-         * @param method resize method, by default is bilinear
+         * @param method resize method, by default is bilinear.
+         *               YVU420SP(NV21) and YUV420SP(NV12) image are resized on YUV planes directly with NEAREST and BILINEAR,
+         *               other methods convert image to RGB888 to resize then convert back, which is much slower.
+         *               For YVU420SP and YUV420SP image, width and height are aligned down to 2 with a warning log.
          * @return Always return a new resized image object even size not change, So in C++ you should take care of the return value to avoid memory leak.
          *         And it's better to judge whether the size has changed before calling this function to make the program more efficient.
          *         e.g.
@@ -523,10 +612,10 @@ namespace maix::image
 
         /**
          * Crop image, will create a new cropped image object
-         * @param x left top corner of crop rectangle point's coordinate x
-         * @param y left top corner of crop rectangle point's coordinate y
-         * @param w crop rectangle width
-         * @param h crop rectangle height
+         * @param x left top corner of crop rectangle point's coordinate x, for YVU420SP and YUV420SP image, will be aligned down to 2
+         * @param y left top corner of crop rectangle point's coordinate y, for YVU420SP and YUV420SP image, will be aligned down to 2
+         * @param w crop rectangle width, for YVU420SP and YUV420SP image, should be even
+         * @param h crop rectangle height, for YVU420SP and YUV420SP image, should be even
          * @return new cropped image object
          * @maixpy maix.image.Image.crop
          */
@@ -534,7 +623,8 @@ namespace maix::image
 
         /**
          * Rotate image, will create a new rotated image object
-         * @param angle anti-clock wise rotate angle, if angle is 90 or 270, and width or height is -1, will swap width and height, or will throw exception
+         * @param angle anti-clock wise rotate angle, if angle is 90 or 270, and width or height is -1, will swap width and height, or will throw exception.
+         *              YVU420SP and YUV420SP image only support multiple of 90 degrees and no resize.
          * @param width new width, if value is -1, will use height to calculate aspect ratio
          * @param height new height, if value is -1, will use width to calculate aspect ratio
          * @param method resize method, by default is bilinear
@@ -1256,6 +1346,29 @@ namespace maix::image
          */
         std::vector<image::Blob> find_blobs(std::vector<std::vector<int>> thresholds = std::vector<std::vector<int>>(), bool invert = false, std::vector<int> roi = std::vector<int>(), int x_stride = 2, int y_stride = 1, int area_threshold = 10, int pixels_threshold = 10, bool merge = false, int margin = 0, int x_hist_bins_max = 0, int y_hist_bins_max = 0);
 
+        /**
+         * Finds all blobs in the image, output plain data records instead of Blob objects.
+         * Args are same as find_blobs return std::vector<image::Blob>, but no Blob object and vectors created for every blob,
+         * and out keep its memory across calls, so it's much faster when there are many blobs.
+         * Histograms are only computed when x_hist_bins_max or y_hist_bins_max is not zero.
+         * @param out output blob records, cleared before find, reuse it across frames to avoid memory allocation.
+         * @return err::Err type, err::ERR_NONE if success.
+         * @maixcdk maix.image.Image.find_blobs
+         */
+        err::Err find_blobs(image::BlobRecords &out, const std::vector<std::vector<int>> &thresholds, bool invert = false, const std::vector<int> &roi = std::vector<int>(), int x_stride = 2, int y_stride = 1, int area_threshold = 10, int pixels_threshold = 10, bool merge = false, int margin = 0, int x_hist_bins_max = 0, int y_hist_bins_max = 0);
+
+        /**
+         * Finds all blobs in the image, call callback for every blob once it's found, nothing stored.
+         * Args are same as find_blobs return std::vector<image::Blob>.
+         * If merge is true, callback is called after all blobs found and merged.
+         * @param callback called for every blob, args are blob record, x histogram and y histogram,
+         *                 histogram is nullptr if not requested, histograms are only valid in callback,
+         *                 x_hist_offset and y_hist_offset of record are always 0.
+         * @return err::Err type, err::ERR_NONE if success.
+         * @maixcdk maix.image.Image.find_blobs
+         */
+        err::Err find_blobs(const std::function<void(const image::BlobRecord &, const uint16_t *, const uint16_t *)> &callback, const std::vector<std::vector<int>> &thresholds, bool invert = false, const std::vector<int> &roi = std::vector<int>(), int x_stride = 2, int y_stride = 1, int area_threshold = 10, int pixels_threshold = 10, bool merge = false, int margin = 0, int x_hist_bins_max = 0, int y_hist_bins_max = 0);
+
         /**
          * Find lines in image
          *
@@ -1484,10 +1597,13 @@ namespace maix::image
         int _data_size;
         Format _format;
         bool _is_malloc;
+        std::function<void(void *)> _release_cb;
+        void *_cache = nullptr;
 
         int _get_cv_pixel_num(image::Format &format);
         std::vector<int> _get_available_roi(std::vector<int> roi, std::vector<int> other_roi = std::vector<int>());
         void _create_image(int width, int height, image::Format format, uint8_t *data, int data_size, bool copy);
+        void _free_cache();
     }; // class Image
 
     /**
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add BlendMode.
  */
 
 #pragma once
@@ -207,6 +208,18 @@ namespace maix::image
         RESIZE_METHOD_MAX
     };
 
+    /**
+     * Blend mode of draw_image and Overlay, source color is premultiplied by source alpha
+     * @maixpy maix.image.BlendMode
+     */
+    enum BlendMode
+    {
+        BLEND_SRC_OVER = 0, // dst = src + dst * (1 - src_alpha)
+        BLEND_ADD,          // dst = dst + src, saturated
+        BLEND_MULTIPLY,     // dst = dst * (src + 1 - src_alpha)
+        BLEND_MODE_MAX
+    };
+
     /**
      * Family of apriltag
      * @maixpy maix.image.ApriltagFamilies
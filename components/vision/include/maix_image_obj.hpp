@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add BlobRecord and BlobRecords.
  */
 
 #pragma once
@@ -10,6 +11,7 @@
 #include "maix_err.hpp"
 #include <vector>
 #include <valarray>
+#include <stdint.h>
 
 namespace maix::image
 {
@@ -993,6 +995,133 @@ namespace maix::image
         }
     }; // class Blob
 
+    /**
+     * Plain data record of one blob, no heap memory in it, output of find_blobs with BlobRecords or callback.
+     * @maixcdk maix.image.BlobRecord
+     */
+    struct BlobRecord
+    {
+        int x;                  // bounding rectangle x
+        int y;                  // bounding rectangle y
+        int w;                  // bounding rectangle width
+        int h;                  // bounding rectangle height
+        int pixels;             // number of pixels in blob
+        float cx;               // centroid x
+        float cy;               // centroid y
+        float rotation;         // rotation in radians
+        int code;               // bit mask of thresholds matched
+        int count;              // number of blobs merged into this blob
+        int perimeter;          // number of pixels on the edge
+        float roundness;        // 0 ~ 1, 1 means circle
+        int corners[4][2];      // 4 corners on the edge, (x, y), clockwise from top left, same as Blob::corners
+        int mini_corners[4][2]; // 4 corners of min area rectangle, same as Blob::mini_corners
+        int x_hist_offset;      // offset of x histogram in BlobRecords::hist
+        int x_hist_count;       // number of x histogram bins, 0 if x_hist_bins_max of find_blobs is 0
+        int y_hist_offset;      // offset of y histogram in BlobRecords::hist
+        int y_hist_count;       // number of y histogram bins, 0 if y_hist_bins_max of find_blobs is 0
+    };
+
+    /**
+     * Blob records output of Image::find_blobs.
+     * Records are stored in one array and histograms of all blobs in another one,
+     * find_blobs clear them but keep memory, so reuse one object for every frame will not allocate memory after the first frames.
+     * @maixcdk maix.image.BlobRecords
+     */
+    class BlobRecords
+    {
+    public:
+        /**
+         * Blob records
+         * @maixcdk maix.image.BlobRecords.records
+         */
+        std::vector<image::BlobRecord> records;
+
+        /**
+         * Histogram bins of all blobs, use BlobRecord::x_hist_offset and x_hist_count to get bins of one blob.
+         * @maixcdk maix.image.BlobRecords.hist
+         */
+        std::vector<uint16_t> hist;
+
+        /**
+         * Remove all records, memory not released.
+         * @maixcdk maix.image.BlobRecords.clear
+         */
+        void clear()
+        {
+            records.clear();
+            hist.clear();
+        }
+
+        /**
+         * Number of blobs
+         * @maixcdk maix.image.BlobRecords.size
+         */
+        size_t size() const
+        {
+            return records.size();
+        }
+
+        /**
+         * Get record of one blob
+         * @maixcdk maix.image.BlobRecords.operator[]
+         */
+        const image::BlobRecord &operator[](size_t index) const
+        {
+            return records[index];
+        }
+
+        /**
+         * Get x histogram bins of one blob
+         * @return pointer to record.x_hist_count bins, nullptr if no histogram.
+         * @maixcdk maix.image.BlobRecords.x_hist
+         */
+        const uint16_t *x_hist(const image::BlobRecord &record) const
+        {
+            return record.x_hist_count ? hist.data() + record.x_hist_offset : nullptr;
+        }
+
+        /**
+         * Get y histogram bins of one blob
+         * @return pointer to record.y_hist_count bins, nullptr if no histogram.
+         * @maixcdk maix.image.BlobRecords.y_hist
+         */
+        const uint16_t *y_hist(const image::BlobRecord &record) const
+        {
+            return record.y_hist_count ? hist.data() + record.y_hist_offset : nullptr;
+        }
+
+        /**
+         * Convert one record to Blob object
+         * @maixcdk maix.image.BlobRecords.to_blob
+         */
+        image::Blob to_blob(size_t index) const
+        {
+            return to_blob(records[index], x_hist(records[index]), y_hist(records[index]));
+        }
+
+        /**
+         * Convert a record and its histograms to Blob object
+         * @param x_hist x histogram, record.x_hist_count bins, can be nullptr if count is 0.
+         * @param y_hist y histogram, record.y_hist_count bins, can be nullptr if count is 0.
+         * @maixcdk maix.image.BlobRecords.to_blob
+         */
+        static image::Blob to_blob(const image::BlobRecord &record, const uint16_t *x_hist, const uint16_t *y_hist)
+        {
+            std::vector<int> rect = {record.x, record.y, record.w, record.h};
+            std::vector<std::vector<int>> corners(4);
+            std::vector<std::vector<int>> mini_corners(4);
+            for (int i = 0; i < 4; i++)
+            {
+                corners[i] = {record.corners[i][0], record.corners[i][1]};
+                mini_corners[i] = {record.mini_corners[i][0], record.mini_corners[i][1]};
+            }
+            std::vector<int> x_hist_bins(x_hist, x_hist + record.x_hist_count);
+            std::vector<int> y_hist_bins(y_hist, y_hist + record.y_hist_count);
+            return image::Blob(rect, corners, mini_corners, record.cx, record.cy, record.pixels, record.rotation,
+                               record.code, record.count, record.perimeter, record.roundness, x_hist_bins, y_hist_bins);
+        }
+    };
+
     /**
      * QRCode class
      * @maixpy maix.image.QRCode
@@ -0,0 +1,125 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#pragma once
+
+#include "maix_image.hpp"
+#include "maix_err.hpp"
+#include <vector>
+
+namespace maix::image
+{
+    /**
+     * Overlay surface, composite static UI layers(e.g. logo, frame, icons) on every camera frame.
+     * Layers are converted to the overlay format and premultiplied by alpha once when added,
+     * and only the tiles with visible pixels are composited, so per frame cost is only blending the dirty rectangles.
+     * Supported formats are the same as Image::draw_image, e.g. RGB888, RGBA8888, GRAYSCALE and YVU420SP(NV21).
+     * @maixpy maix.image.Overlay
+     */
+    class Overlay
+    {
+    public:
+        /**
+         * Construct a new Overlay object
+         * @param width width of frames to composite on
+         * @param height height of frames to composite on
+         * @param format format of frames to composite on
+         * @throw err::Exception if format not support
+         * @maixpy maix.image.Overlay.__init__
+         * @maixcdk maix.image.Overlay.Overlay
+         */
+        Overlay(int width, int height, image::Format format = image::FMT_RGB888);
+        ~Overlay();
+
+        /**
+         * Add layer on top of other layers
+         * @param img layer image, RGBA8888 or BGRA8888 for transparent layer, or any format supported by draw_image.
+         *            Image is converted when added, change img later will not change layer, use update_layer.
+         * @param x left top corner x of layer, aligned down to even for YUV formats
+         * @param y left top corner y of layer, aligned down to even for YUV formats
+         * @param mode blend mode, see image.BlendMode
+         * @param alpha layer alpha, [0, 1], multiply to image alpha
+         * @return layer id, -1 if failed
+         * @maixpy maix.image.Overlay.add_layer
+         */
+        int add_layer(image::Image &img, int x = 0, int y = 0, image::BlendMode mode = image::BLEND_SRC_OVER, float alpha = 1);
+
+        /**
+         * Update layer image
+         * @param id layer id
+         * @param img new layer image, size can be changed
+         * @param roi region changed in img, [x, y, w, h], default empty means the whole image.
+         *            Only the region is converted again, img size should be the same as before when roi is set.
+         * @return err::ERR_ARGS if id or roi invalid
+         * @maixpy maix.image.Overlay.update_layer
+         */
+        err::Err update_layer(int id, image::Image &img, const std::vector<int> &roi = std::vector<int>());
+
+        /**
+         * Move layer
+         * @param id layer id
+         * @param x new left top corner x of layer
+         * @param y new left top corner y of layer
+         * @return err::ERR_ARGS if id invalid
+         * @maixpy maix.image.Overlay.move_layer
+         */
+        err::Err move_layer(int id, int x, int y);
+
+        /**
+         * Show or hide layer
+         * @param id layer id
+         * @param visible true to show, false to hide
+         * @return err::ERR_ARGS if id invalid
+         * @maixpy maix.image.Overlay.show_layer
+         */
+        err::Err show_layer(int id, bool visible = true);
+
+        /**
+         * Remove layer
+         * @param id layer id
+         * @return err::ERR_ARGS if id invalid
+         * @maixpy maix.image.Overlay.remove_layer
+         */
+        err::Err remove_layer(int id);
+
+        /**
+         * Composite all visible layers on img from bottom to top, only dirty rectangles are blended.
+         * @param img frame to composite on, size and format should be the same as overlay
+         * @return err::ERR_ARGS if img size or format not match
+         * @maixpy maix.image.Overlay.composite
+         */
+        err::Err composite(image::Image &img);
+
+        /**
+         * Get dirty rectangles, the regions composite will blend, covered tiles with visible pixels of visible layers.
+         * @return list of rectangles, [x, y, w, h]
+         * @maixpy maix.image.Overlay.dirty_rects
+         */
+        std::vector<std::vector<int>> dirty_rects();
+
+        /**
+         * Get overlay width
+         * @maixpy maix.image.Overlay.width
+         */
+        int width();
+
+        /**
+         * Get overlay height
+         * @maixpy maix.image.Overlay.height
+         */
+        int height();
+
+        /**
+         * Get overlay format
+         * @maixpy maix.image.Overlay.format
+         */
+        image::Format format();
+
+    private:
+        void *_param;
+    };
+}
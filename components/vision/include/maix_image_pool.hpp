@@ -0,0 +1,170 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#pragma once
+
+#include "maix_err.hpp"
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace maix::image
+{
+    /**
+     * Statistics of one size class of image buffer pool
+     * @maixcdk maix.image.BufferPoolStat
+     */
+    struct BufferPoolStat
+    {
+        size_t block_size;  // buffer size of this class
+        int cached;         // free buffers kept in pool
+        int in_use;         // buffers used by images
+        uint64_t hits;      // alloc requests served by cached buffer
+        uint64_t misses;    // alloc requests served by system allocator
+        uint64_t drops;     // buffers released to system because of pool memory limit
+    };
+
+    /**
+     * Image data buffer pool.
+     * Buffers are grouped by size class(8 classes between two powers of 2, max 12.5% waste),
+     * images alloc data from it and give back when destructed, so images of the same size reuse memory,
+     * no heap allocation in steady state and no memory fragmentation.
+     * Buffers are 4096 bytes aligned.
+     * Use image::buffer_pool() to get the global pool.
+     * @maixcdk maix.image.BufferPool
+     */
+    class BufferPool
+    {
+    public:
+        /**
+         * Construct a new BufferPool object
+         * @param max_cached_size max memory size of free buffers kept in pool, unit: byte.
+         *                        -1 means use 1/8 of physical memory.
+         * @maixcdk maix.image.BufferPool.BufferPool
+         */
+        BufferPool(int64_t max_cached_size = -1);
+        ~BufferPool();
+
+        /**
+         * Alloc buffer
+         * @param size buffer size
+         * @return buffer address, nullptr if no memory.
+         * @maixcdk maix.image.BufferPool.alloc
+         */
+        void *alloc(size_t size);
+
+        /**
+         * Give back buffer
+         * @param ptr buffer address returned by alloc
+         * @param size the same size used when alloc
+         * @maixcdk maix.image.BufferPool.free
+         */
+        void free(void *ptr, size_t size);
+
+        /**
+         * Set max memory size of free buffers kept in pool, buffers over the limit will be released immediately.
+         * @param max_cached_size unit: byte, 0 means not cache any buffer.
+         * @maixcdk maix.image.BufferPool.set_max_cached_size
+         */
+        void set_max_cached_size(int64_t max_cached_size);
+
+        /**
+         * Get max memory size of free buffers kept in pool
+         * @maixcdk maix.image.BufferPool.max_cached_size
+         */
+        int64_t max_cached_size();
+
+        /**
+         * Memory size of free buffers kept in pool now
+         * @maixcdk maix.image.BufferPool.cached_size
+         */
+        int64_t cached_size();
+
+        /**
+         * Memory size of buffers used by images now
+         * @maixcdk maix.image.BufferPool.in_use_size
+         */
+        int64_t in_use_size();
+
+        /**
+         * Release all free buffers to system
+         * @maixcdk maix.image.BufferPool.clear
+         */
+        void clear();
+
+        /**
+         * Get statistics of all size classes, sorted by block size
+         * @maixcdk maix.image.BufferPool.stats
+         */
+        std::vector<image::BufferPoolStat> stats();
+
+        /**
+         * Set memory allocator, e.g. alloc from CMA/ION memory to share buffers with hardware.
+         * Can only be set when no buffer is in use, cached buffers will be released.
+         * @param alloc_func alloc function, should return 4096 bytes aligned memory, nullptr to restore default.
+         * @param free_func free function, nullptr to restore default.
+         * @return err::ERR_NOT_PERMIT if buffers are still in use.
+         * @maixcdk maix.image.BufferPool.set_allocator
+         */
+        err::Err set_allocator(std::function<void *(size_t)> alloc_func, std::function<void(void *)> free_func);
+
+        /**
+         * Get block size of size class which size belongs to
+         * @maixcdk maix.image.BufferPool.block_size
+         */
+        static size_t block_size(size_t size);
+
+    private:
+        struct SizeClass
+        {
+            std::vector<void *> free_list;
+            image::BufferPoolStat stat;
+        };
+        std::mutex _lock;
+        std::unordered_map<size_t, SizeClass> _classes;
+        int64_t _max_cached_size;
+        int64_t _cached_size;
+        int64_t _in_use_size;
+        std::function<void *(size_t)> _alloc_func;
+        std::function<void(void *)> _free_func;
+
+        void *_sys_alloc(size_t size);
+        void _sys_free(void *ptr);
+        void _trim(int64_t max_cached_size);
+    };
+
+    /**
+     * Get the global image buffer pool used by image::Image
+     * @maixcdk maix.image.buffer_pool
+     */
+    image::BufferPool &buffer_pool();
+
+    /**
+     * Set max memory size of free image buffers kept in the global pool
+     * @param max_cached_size unit: byte, 0 means not cache any buffer, -1 means use 1/8 of physical memory.
+     * @maixpy maix.image.set_pool_max_size
+     */
+    void set_pool_max_size(int64_t max_cached_size);
+
+    /**
+     * Get global image buffer pool statistics
+     * @return dict type, keys: max_cached_size, cached_size, in_use_size, hits, misses, drops
+     * @maixpy maix.image.pool_stats
+     */
+    std::map<std::string, int64_t> pool_stats();
+
+    /**
+     * Release all free buffers of global image buffer pool to system
+     * @maixpy maix.image.pool_clear
+     */
+    void pool_clear();
+} // namespace maix::image
@@ -0,0 +1,114 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#pragma once
+
+#include "maix_image.hpp"
+#include "maix_tensor.hpp"
+#include "maix_err.hpp"
+#include <vector>
+
+namespace maix::image
+{
+    /**
+     * Fused preprocessing for neural network input.
+     * Do object fit(letterbox), bilinear resize, color convert and normalize in one pass,
+     * write result to model input buffer directly, no temporary image,
+     * rows are processed by several threads.
+     * Output value is (pixel - mean) * scale, for int8/uint8 output it will be quantized again by (value / qscale + zero_point).
+     * @maixpy maix.image.Preprocessor
+     */
+    class Preprocessor
+    {
+    public:
+        /**
+         * Construct a new Preprocessor object
+         * @param threads max threads number, run in the process wide thread pool(thread::parallel_for),
+         *                0 means thread::parallel_threads()(all CPU cores by default), 1 means only use caller thread.
+         * @maixpy maix.image.Preprocessor.__init__
+         * @maixcdk maix.image.Preprocessor.Preprocessor
+         */
+        Preprocessor(int threads = 0);
+        ~Preprocessor();
+
+        /**
+         * Preprocess image and write to buffer
+         * @param img input image, support format RGB888, BGR888, RGBA8888, BGRA8888, GRAYSCALE, YVU420SP(NV21), YUV420SP(NV12).
+         * @param dst output buffer, size should be at least width * height * channels * dtype size.
+         * @param width output width
+         * @param height output height
+         * @param format output channel order, only support RGB888, BGR888, GRAYSCALE.
+         * @param dtype output data type, only support FLOAT32, INT8, UINT8.
+         * @param chw output layout, true means [C, H, W], false means [H, W, C].
+         * @param mean mean value of each channel, empty means 0, one value means all channels use the same value.
+         * @param scale scale value of each channel, empty means 1, one value means all channels use the same value.
+         * @param fit object fit, FIT_CONTAIN will fill blank area with black(normalized), FIT_NONE is same as FIT_FILL.
+         * @param qscale quantization scale for INT8 or UINT8 output.
+         * @param zero_point quantization zero point for INT8 or UINT8 output.
+         * @return err::Err
+         * @maixcdk maix.image.Preprocessor.run
+         */
+        err::Err run(image::Image &img, void *dst, int width, int height, image::Format format, tensor::DType dtype, bool chw,
+                     const std::vector<float> &mean, const std::vector<float> &scale, image::Fit fit = image::Fit::FIT_CONTAIN,
+                     float qscale = 1.0, int zero_point = 0);
+
+        /**
+         * Preprocess image and write to tensor
+         * @param img input image, support format RGB888, BGR888, RGBA8888, BGRA8888, GRAYSCALE, YVU420SP(NV21), YUV420SP(NV12).
+         * @param dst output tensor, shape should be [N, C, H, W] or [C, H, W] when chw is true, [N, H, W, C] or [H, W, C] when chw is false,
+         *            N should be 1, C should be 1 or 3, dtype should be FLOAT32, INT8 or UINT8, must be contiguous(not a view from slice or transpose).
+         * @param chw tensor layout, true means [C, H, W], false means [H, W, C].
+         * @param mean mean value of each channel, empty means 0, one value means all channels use the same value.
+         * @param scale scale value of each channel, empty means 1, one value means all channels use the same value.
+         * @param fit object fit, FIT_CONTAIN will fill blank area with black(normalized).
+         * @param bgr output channel order is BGR or not, only valid when C is 3.
+         * @param qscale quantization scale for INT8 or UINT8 output.
+         * @param zero_point quantization zero point for INT8 or UINT8 output.
+         * @return err::Err
+         * @maixpy maix.image.Preprocessor.run
+         */
+        err::Err run(image::Image &img, tensor::Tensor &dst, bool chw = true,
+                     const std::vector<float> &mean = std::vector<float>(), const std::vector<float> &scale = std::vector<float>(),
+                     image::Fit fit = image::Fit::FIT_CONTAIN, bool bgr = false, float qscale = 1.0, int zero_point = 0);
+
+        /**
+         * Preprocess image to a new tensor
+         * @param img input image, support format RGB888, BGR888, RGBA8888, BGRA8888, GRAYSCALE, YVU420SP(NV21), YUV420SP(NV12).
+         * @param width output width
+         * @param height output height
+         * @param format output channel order, only support RGB888, BGR888, GRAYSCALE.
+         * @param dtype output data type, only support FLOAT32, INT8, UINT8.
+         * @param chw output layout, true means shape [1, C, H, W], false means shape [1, H, W, C].
+         * @param mean mean value of each channel, empty means 0, one value means all channels use the same value.
+         * @param scale scale value of each channel, empty means 1, one value means all channels use the same value.
+         * @param fit object fit, FIT_CONTAIN will fill blank area with black(normalized).
+         * @param qscale quantization scale for INT8 or UINT8 output.
+         * @param zero_point quantization zero point for INT8 or UINT8 output.
+         * @return new tensor object, you should delete it after use in C++.
+         * @maixpy maix.image.Preprocessor.to_tensor
+         */
+        tensor::Tensor *to_tensor(image::Image &img, int width, int height, image::Format format = image::Format::FMT_RGB888,
+                                  tensor::DType dtype = tensor::DType::FLOAT32, bool chw = true,
+                                  const std::vector<float> &mean = std::vector<float>(), const std::vector<float> &scale = std::vector<float>(),
+                                  image::Fit fit = image::Fit::FIT_CONTAIN, float qscale = 1.0, int zero_point = 0);
+
+        /**
+         * Get max threads number used by run
+         * @maixpy maix.image.Preprocessor.threads
+         */
+        int threads();
+
+    private:
+        void *_param;
+    };
+
+    /**
+     * Global preprocessor instance, shared by nn modules.
+     * @maixcdk maix.image.preprocessor
+     */
+    image::Preprocessor &preprocessor();
+} // namespace maix::image
@@ -0,0 +1,51 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#pragma once
+
+#include "maix_image.hpp"
+#include "maix_err.hpp"
+
+namespace maix::image
+{
+    /**
+     * Resize YVU420SP(NV21) or YUV420SP(NV12) image to dst, work on Y and VU planes directly,
+     * no color convert and no temporary image, dst is written in one pass.
+     * @param src source image, format should be YVU420SP or YUV420SP, width and height should be even.
+     * @param dst destination image, already allocated, format should be same as src, width and height should be even.
+     * @param fit object fit, FIT_CONTAIN fill blank area with black(Y = 0, U = V = 128), blank size is aligned to 2.
+     *            FIT_COVER crop center of src, FIT_NONE is same as FIT_FILL.
+     * @param method only support NEAREST and BILINEAR, other methods will use BILINEAR.
+     * @return err::Err, ERR_ARGS if format or size not valid.
+     * @maixcdk maix.image.yuv420sp_resize
+     */
+    err::Err yuv420sp_resize(image::Image &src, image::Image &dst, image::Fit fit = image::Fit::FIT_FILL, image::ResizeMethod method = image::ResizeMethod::BILINEAR);
+
+    /**
+     * Crop YVU420SP(NV21) or YUV420SP(NV12) image to dst, size of crop rectangle is dst size.
+     * @param src source image, format should be YVU420SP or YUV420SP, width and height should be even.
+     * @param dst destination image, already allocated, format should be same as src, width and height should be even.
+     * @param x left top corner of crop rectangle, will be aligned down to 2 because of chroma subsampling.
+     * @param y left top corner of crop rectangle, will be aligned down to 2.
+     * @return err::Err, ERR_ARGS if crop rectangle out of src.
+     * @maixcdk maix.image.yuv420sp_crop
+     */
+    err::Err yuv420sp_crop(image::Image &src, image::Image &dst, int x, int y);
+
+    /**
+     * Rotate and flip YVU420SP(NV21) or YUV420SP(NV12) image to dst, src is mirrored and flipped first, then rotated.
+     * @param src source image, format should be YVU420SP or YUV420SP, width and height should be even.
+     * @param dst destination image, already allocated, format should be same as src,
+     *            size should be same as src when angle is 0 or 180, or swap width and height when angle is 90 or 270.
+     * @param angle anti-clock wise rotate angle, only support 0, 90, 180, 270(or -90).
+     * @param hmirror horizontally mirror src before rotate.
+     * @param vflip vertically flip src before rotate.
+     * @return err::Err, ERR_ARGS if angle or size not valid.
+     * @maixcdk maix.image.yuv420sp_rotate
+     */
+    err::Err yuv420sp_rotate(image::Image &src, image::Image &dst, int angle, bool hmirror = false, bool vflip = false);
+}
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: One epoll thread serve all clients, encode once and share the frame between clients.
  */
 
 #ifndef __MAIX_JPG_STREAM_HPP
@@ -29,7 +30,7 @@ namespace maix::http
          * @note You can get the picture stream through http://host:port/stream, you can also get it through http://ip:port, and you can add personal style through set_html() at this time
          * @param host http host
          * @param port http port, default is 8000
-         * @param client_number the max number of client
+         * @param client_number the max number of client, more clients will be refused.
          * @maixpy maix.http.JpegStreamer.__init__
          * @maixcdk maix.http.JpegStreamer.JpegStreamer
          */
@@ -46,12 +47,14 @@ namespace maix::http
         /**
          * @brief stop http
          * @return error code, err::ERR_NONE means success, others means failed
-         * @maixpy maix.http.JpegStreamer.start
+         * @maixpy maix.http.JpegStreamer.stop
         */
         err::Err stop();
 
         /**
          * @brief Write data to http
+         * @note Image is encoded to jpeg once and shared by all clients, this function never blocked by clients,
+         *       slow client will skip frames. If no client is watching, image will not be encoded.
          * @param img image object
          * @return error code, err::ERR_NONE means success, others means failed
          * @maixpy maix.http.JpegStreamer.write
@@ -90,9 +93,17 @@ namespace maix::http
         int port() {
             return _port;
         }
+
+        /**
+         * Get number of clients watching the stream
+         * @return number of clients
+         * @maixpy maix.http.JpegStreamer.client_count
+        */
+        int client_count();
     private:
         std::string _host;
         int _port;
+        void *_param;
     };
 } // namespace maix::http
 
@@ -0,0 +1,245 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#pragma once
+
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include <memory>
+
+namespace maix::camera
+{
+    class Camera;
+}
+
+namespace maix::display
+{
+    class Display;
+}
+
+namespace maix::http
+{
+    class JpegStreamer;
+}
+
+namespace maix::pipeline
+{
+    /**
+     * What to do when the input queue of a stage is full
+     * @maixcdk maix.pipeline.QueuePolicy
+     */
+    enum QueuePolicy
+    {
+        QUEUE_BLOCK = 0,    // former stage wait until this stage take one frame, no frame lost
+        QUEUE_DROP_OLDEST,  // drop the oldest frame in queue, former stage never wait, this stage always get latest frames
+    };
+
+    /**
+     * One frame flowing through pipeline stages, only one stage access it at the same time.
+     * @maixcdk maix.pipeline.Frame
+     */
+    class Frame
+    {
+    public:
+        Frame()
+        {
+            seq = 0;
+            t_capture_us = 0;
+            img = nullptr;
+        }
+
+        ~Frame()
+        {
+            delete img;
+        }
+
+        Frame(const Frame &) = delete;
+        Frame &operator=(const Frame &) = delete;
+
+        /**
+         * Frame sequence number, count from 0 by source stage
+         * @maixcdk maix.pipeline.Frame.seq
+         */
+        uint64_t seq;
+
+        /**
+         * time::ticks_us() when source stage got this frame
+         * @maixcdk maix.pipeline.Frame.t_capture_us
+         */
+        uint64_t t_capture_us;
+
+        /**
+         * Frame image, set by source stage, deleted with frame
+         * @maixcdk maix.pipeline.Frame.img
+         */
+        image::Image *img;
+
+        /**
+         * Set result of this frame, e.g. detect result of infer stage, will be deleted with frame,
+         * former result will be deleted.
+         * @param result result object allocated by new, e.g. return value of nn::YOLOv5::detect
+         * @maixcdk maix.pipeline.Frame.set_result
+         */
+        template <typename T>
+        void set_result(T *result)
+        {
+            _result = std::shared_ptr<void>(result, [](void *p) { delete (T *)p; });
+        }
+
+        /**
+         * Get result set by set_result
+         * @return result pointer, owned by frame, nullptr if not set
+         * @maixcdk maix.pipeline.Frame.result
+         */
+        template <typename T>
+        T *result()
+        {
+            return (T *)_result.get();
+        }
+
+    private:
+        std::shared_ptr<void> _result;
+    };
+
+    /**
+     * Stage function, process frame in place.
+     * @return err::ERR_NONE to pass frame to next stage, other errors drop the frame.
+     *         For source stage, fill frame.img and return err::ERR_NONE to generate one frame,
+     *         err::ERR_CANCEL means no more frames(e.g. end of video file), other errors will be retried.
+     */
+    typedef std::function<err::Err(pipeline::Frame &frame)> StageFunc;
+
+    /**
+     * Statistics of one stage
+     * @maixcdk maix.pipeline.StageStats
+     */
+    class StageStats
+    {
+    public:
+        std::string name;       // stage name
+        uint64_t frames;        // frames processed successfully
+        uint64_t dropped;       // frames dropped by input queue(QUEUE_DROP_OLDEST) or stage function error
+        int queue_len;          // frames waiting in input queue now
+        float fps;              // processed frames per second of last second
+        float latency_ms;       // average time of stage function of last second
+        float latency_max_ms;   // max time of stage function since start
+    };
+
+    /**
+     * Staged multithreaded pipeline.
+     * Every stage runs on its own thread(maix::thread::Thread), stages are connected by bounded lock free queues,
+     * so camera, inference and display overlap, and frame rate is limited by the slowest stage instead of sum of all stages.
+     * The first stage set by set_source generates frames, the last stage added is the sink, frame is deleted after sink.
+     * @maixcdk maix.pipeline.Pipeline
+     */
+    class Pipeline
+    {
+    public:
+        /**
+         * Construct a new Pipeline object
+         * @maixcdk maix.pipeline.Pipeline.Pipeline
+         */
+        Pipeline();
+        ~Pipeline();
+
+        /**
+         * Set source stage which generates frames
+         * @param name stage name, used by stats
+         * @param read stage function, fill frame.img, @see StageFunc
+         * @return err::ERR_BUSY if pipeline is running
+         * @maixcdk maix.pipeline.Pipeline.set_source
+         */
+        err::Err set_source(const std::string &name, pipeline::StageFunc read);
+
+        /**
+         * Add one stage after the last stage
+         * @param name stage name, used by stats
+         * @param process stage function, @see StageFunc
+         * @param queue_size input queue size of this stage, > 0, default 2, 1 or 2 is enough usually,
+         *                   larger queue only increase latency. Note camera may have limited buffers when read without copy.
+         * @param policy what to do when input queue is full, @see QueuePolicy
+         *               QUEUE_BLOCK usually for every stage, QUEUE_DROP_OLDEST for a slow stage which only need the latest frame, e.g. streaming.
+         * @return err::ERR_BUSY if pipeline is running, err::ERR_ARGS if queue_size invalid
+         * @maixcdk maix.pipeline.Pipeline.add_stage
+         */
+        err::Err add_stage(const std::string &name, pipeline::StageFunc process, int queue_size = 2, pipeline::QueuePolicy policy = pipeline::QUEUE_BLOCK);
+
+        /**
+         * Start all stage threads
+         * @return err::ERR_NOT_READY if no source or no stage, err::ERR_BUSY if already running
+         * @maixcdk maix.pipeline.Pipeline.start
+         */
+        err::Err start();
+
+        /**
+         * Stop all stage threads and delete frames still in queues, stage function being called will finish first.
+         * @maixcdk maix.pipeline.Pipeline.stop
+         */
+        err::Err stop();
+
+        /**
+         * Wait source finished(returned err::ERR_CANCEL) and all frames passed through stages, or app::need_exit() is true.
+         * Threads are stopped after wait success.
+         * @param timeout_ms -1 means wait forever
+         * @return err::ERR_NONE if finished, err::ERR_TIMEOUT if timeout, err::ERR_CANCEL if app exit, err::ERR_NOT_READY if not started
+         * @maixcdk maix.pipeline.Pipeline.wait
+         */
+        err::Err wait(int timeout_ms = -1);
+
+        /**
+         * Is pipeline running
+         * @maixcdk maix.pipeline.Pipeline.is_running
+         */
+        bool is_running();
+
+        /**
+         * Get statistics of all stages, source stage first
+         * @maixcdk maix.pipeline.Pipeline.stats
+         */
+        std::vector<pipeline::StageStats> stats();
+
+        /**
+         * End to end frames per second of last second, counted at the end of sink stage
+         * @maixcdk maix.pipeline.Pipeline.fps
+         */
+        float fps();
+
+        /**
+         * Average end to end latency of last second, from source got frame to sink finished, unit ms
+         * @maixcdk maix.pipeline.Pipeline.latency_ms
+         */
+        float latency_ms();
+
+        /**
+         * Statistics of all stages in readable string, one line per stage, e.g. for log or draw on image
+         * @maixcdk maix.pipeline.Pipeline.stats_str
+         */
+        std::string stats_str();
+
+    private:
+        void *_param;
+    };
+
+    /**
+     * Camera source stage function, read one image from camera every call
+     * @maixcdk maix.pipeline.camera_source
+     */
+    pipeline::StageFunc camera_source(camera::Camera &cam);
+
+    /**
+     * Display sink stage function, show frame image
+     * @maixcdk maix.pipeline.display_sink
+     */
+    pipeline::StageFunc display_sink(display::Display &disp, image::Fit fit = image::FIT_CONTAIN);
+
+    /**
+     * JpegStreamer sink stage function, write frame image to streamer,
+     * usually add with QUEUE_DROP_OLDEST policy as the last stage.
+     * @maixcdk maix.pipeline.jpeg_streamer_sink
+     */
+    pipeline::StageFunc jpeg_streamer_sink(http::JpegStreamer &streamer);
+} // namespace maix::pipeline
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add H.264 stream type and write image, implement server on Linux.
  */
 
 #ifndef __MAIX_RTSP_HPP
@@ -25,8 +26,11 @@ namespace maix::rtsp
     {
         RTSP_STREAM_NONE = 0,  // format invalid
         RTSP_STREAM_H265,
+        RTSP_STREAM_H264,      // only support on Linux
     };
 
+    class Rtsp;
+
     /**
      * Region class
      * @maixpy maix.rtsp.Region
@@ -57,11 +61,13 @@ namespace maix::rtsp
 
         /**
          * @brief Update canvas
+         * On Linux, region is blended into the frames encoded by Rtsp, transparent pixels(alpha is 0) are skipped.
          * @return error code
          * * @maixpy maix.rtsp.Region.update_canvas
         */
         err::Err update_canvas();
     private:
+        friend class Rtsp;
         int _id;
         int _x;
         int _y;
@@ -86,7 +92,9 @@ namespace maix::rtsp
          * @param ip rtsp ip
          * @param port rtsp port
          * @param fps rtsp fps
-         * @param stream_type rtsp stream type
+         * @param stream_type rtsp stream type, RTSP_STREAM_H264 only support on Linux.
+         *                    On Linux, the server accept several clients, one encoded frame is sent to all clients,
+         *                    client can use RTP over TCP(interleaved) or UDP, a slow client skip frames until next IDR frame.
          * @maixpy maix.rtsp.Rtsp.__init__
          * @maixcdk maix.rtsp.Rtsp.Rtsp
          */
@@ -117,12 +125,21 @@ namespace maix::rtsp
 
         /**
          * @brief Write data to rtsp
-         * @param frame video frame data
+         * @param frame video frame data, H.265 or H.264(same as stream_type) Annex-B stream of one frame
          * @return error code, err::ERR_NONE means success, others means failed
          * @maixpy maix.rtsp.Rtsp.write
         */
         err::Err write(video::Frame &frame);
 
+        /**
+         * @brief Encode image and write to rtsp
+         * Encoder is created at first call, with the size and format of img, regions will be drawn on a copy of img.
+         * @param img image to encode, all images should have the same size and format, recommend FMT_YVU420SP.
+         * @return error code, err::ERR_NONE means success, others means failed
+         * @maixpy maix.rtsp.Rtsp.write
+        */
+        err::Err write(image::Image &img);
+
         /**
          * @brief Get url of rtsp
          * @return url of rtsp
@@ -252,6 +269,7 @@ namespace maix::rtsp
         uint64_t _timestamp;
         uint64_t _last_ms;
         int _region_max_number;
+        void *_param;
     };
 } // namespace maix::rtsp
 
@@ -3,6 +3,8 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add threads and low_latency args for Encoder, type, format and threads args for Decoder.
+ * @update 2026.10.18: Add Packet timestamp getters, Video write mp4 with MP4Muxer.
  */
 
 #pragma once
@@ -261,6 +263,9 @@ namespace maix::video
         Packet() {
             _data = NULL;
             _data_size = 0;
+            _pts = -1;
+            _dts = -1;
+            _duration = 0;
         }
 
         ~Packet() {
@@ -336,6 +341,33 @@ namespace maix::video
         void set_duration(uint64_t duration) {
             _duration = duration;
         }
+
+        /**
+         * @brief Get pts
+         * @return pts value, unit: time_base
+         * @maixpy maix.video.Packet.get_pts
+         */
+        uint64_t get_pts() {
+            return _pts;
+        }
+
+        /**
+         * @brief Get dts
+         * @return dts value, unit: time_base
+         * @maixpy maix.video.Packet.get_dts
+         */
+        uint64_t get_dts() {
+            return _dts;
+        }
+
+        /**
+         * @brief Get duration
+         * @return duration value, unit: time_base
+         * @maixpy maix.video.Packet.get_duration
+         */
+        uint64_t get_duration() {
+            return _duration;
+        }
     };
 
     /**
@@ -359,10 +391,14 @@ namespace maix::video
          * @param bitrate for h264/h265 encoding, used to limit the bandwidth used by compressed data, default is 3000kbps
          * @param time_base frame time base. time_base default is 1000, means 1/1000 ms (not used)
          * @param capture enable capture, if true, you can use capture() function to get an image object
+         * @param threads encode threads number, 0 means auto. only for software encoder(Linux), hardware encoder ignore this arg.
+         * @param low_latency low latency mode, no B-frames and no look ahead, every encode() call output one frame,
+         *                    and use slice threads instead of frame threads. only for software encoder(Linux),
+         *                    hardware encoder always works in low latency mode.
          * @maixpy maix.video.Encoder.__init__
          * @maixcdk maix.video.Encoder.Encoder
          */
-        Encoder(int width = 2560, int height = 1440, image::Format format = image::Format::FMT_YVU420SP, video::VideoType type = video::VideoType::VIDEO_H265_CBR, int framerate = 30, int gop = 50, int bitrate = 3000 * 1000, int time_base = 1000, bool capture = false);
+        Encoder(int width = 2560, int height = 1440, image::Format format = image::Format::FMT_YVU420SP, video::VideoType type = video::VideoType::VIDEO_H265_CBR, int framerate = 30, int gop = 50, int bitrate = 3000 * 1000, int time_base = 1000, bool capture = false, int threads = 0, bool low_latency = false);
         ~Encoder();
 
         /**
@@ -505,6 +541,9 @@ namespace maix::video
         uint64_t _dts;                        // unit: time_base
         uint64_t _start_encode_ms;
         bool _encode_started;
+        int _threads;
+        bool _low_latency;
+        void *_param;
     };
 
 
@@ -517,10 +556,13 @@ namespace maix::video
     public:
         /**
          * @brief Construct a new Decoder object
+         * @param type video type to decode, only the codec is used, VIDEO_H264_* for H.264, VIDEO_H265_* for H.265.
+         * @param format output image format, default is image::Format::FMT_YVU420SP.
+         * @param threads decode threads number, 0 means auto. only for software decoder(Linux).
          * @maixpy maix.video.Decoder.__init__
          * @maixcdk maix.video.Decoder.Decoder
          */
-        Decoder();
+        Decoder(video::VideoType type = video::VideoType::VIDEO_H264_CBR, image::Format format = image::Format::FMT_YVU420SP, int threads = 0);
         ~Decoder();
 
         /**
@@ -544,16 +586,24 @@ namespace maix::video
 
         /**
          * Decode
-         * @param frame the frame will be decode (not used)
-         * @return decode result
+         * @param frame the frame will be decode, if nullptr, decode data set by prepare().
+         *              If nullptr and no data prepared and no decoded image left, means end of stream,
+         *              the last images held by decoder are output, then decoder is reset for a new stream.
+         * @return decode result, nullptr if need more data.
          * @maixpy maix.video.Decoder.decode
         */
         image::Image *decode(video::Frame *frame = nullptr);
     private:
         int _path;
         Bytes *_prepare_data;
+        video::VideoType _type;
+        image::Format _format;
+        int _threads;
+        void *_param;
     };
 
+    class MP4Muxer;
+
     /**
      * Video class
      * @maixpy maix.video.Video
@@ -717,6 +767,8 @@ namespace maix::video
         uint64_t _record_ms;
         uint64_t _record_start_ms;
         int _fd;
+        video::MP4Muxer *_mp4;
+        video::Encoder *_encoder = nullptr;   // software encoder, only used by Linux
         bool _need_capture;
         image::Image *_capture_image;
 
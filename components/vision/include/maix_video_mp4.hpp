@@ -0,0 +1,123 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#pragma once
+
+#include "maix_video.hpp"
+#include <stdint.h>
+#include <string>
+
+namespace maix::video
+{
+    /**
+     * Streaming MP4 muxer, write H.264 or H.265 access units to MP4 file as they arrive, no temporary file and no ffmpeg needed.
+     * File is fragmented MP4: ftyp and moov(codec info) at the front, then one moof + mdat every fragment,
+     * so file is playable even if program crashed or power lost, only the last unfinished fragment lost.
+     * finish() append random access index(mfra) and fill total duration in the moov at the front of file,
+     * so players get duration and seek without scanning the whole file.
+     * Data is written in 4096 bytes aligned blocks from a large write buffer, and disk space is pre-allocated,
+     * to reduce write calls and file system fragmentation on SD card.
+     * @maixpy maix.video.MP4Muxer
+     */
+    class MP4Muxer
+    {
+    public:
+        /**
+         * Construct a new MP4Muxer object, create or truncate file.
+         * @param path mp4 file path.
+         * @param type video type, VIDEO_H264_CBR or VIDEO_H264_CBR_MP4 means H.264,
+         *             VIDEO_H265_CBR, VIDEO_H265_CBR_MP4, VIDEO_ENC_H265_CBR or VIDEO_ENC_MP4_CBR means H.265.
+         * @param width video width.
+         * @param height video height.
+         * @param time_base time base of pts and dts, timestamp unit is 1/time_base second, default 1000 means ms.
+         * @param framerate frame rate, used to generate timestamps if pts not set and the duration of last frame.
+         * @param fragment_ms fragment duration, new fragment starts at the first key frame after this duration, unit ms.
+         *                    Small value lose less data when crash but have more overhead.
+         * @param buff_size write buffer size, unit byte, data is written to file when buffer full or fragment finish.
+         * @param prealloc_size disk space reserved every time file grows over reserved space, unit byte, 0 means not reserve.
+         * @throw err::Exception if type not supported or open file failed.
+         * @maixpy maix.video.MP4Muxer.__init__
+         * @maixcdk maix.video.MP4Muxer.MP4Muxer
+         */
+        MP4Muxer(const std::string &path, video::VideoType type, int width, int height, int time_base = 1000, int framerate = 30,
+                 int fragment_ms = 1000, int buff_size = 512 * 1024, int prealloc_size = 16 * 1024 * 1024);
+
+        /**
+         * Call finish() if not finished.
+         */
+        ~MP4Muxer();
+
+        /**
+         * Write one access unit(all NAL units of one frame).
+         * Frames before the first key frame with parameter sets(SPS, PPS, and VPS for H.265) are dropped.
+         * @param data Annex-B stream data(NAL units with start code) of one frame.
+         * @param len data length.
+         * @param pts presentation time stamp, unit: time_base, -1 means generate by framerate.
+         * @param dts decoding time stamp, unit: time_base, -1 means same as pts.
+         * @return err::ERR_NONE if success, err::ERR_ARGS if data is not Annex-B stream,
+         *         err::ERR_NOT_READY if waiting key frame, err::ERR_IO if write file failed.
+         * @maixcdk maix.video.MP4Muxer.write
+         */
+        err::Err write(const uint8_t *data, int len, uint64_t pts = -1, uint64_t dts = -1);
+
+        /**
+         * Write one encoded frame, e.g. got from video.Encoder.encode.
+         * @param frame encoded frame, use it's pts and dts.
+         * @return err::Err type, @see write
+         * @maixpy maix.video.MP4Muxer.write
+         */
+        err::Err write(video::Frame *frame);
+
+        /**
+         * Write one encoded packet, e.g. got from video.Video.encode.
+         * @param packet encoded packet, use it's pts and dts.
+         * @return err::Err type, @see write
+         * @maixpy maix.video.MP4Muxer.write
+         */
+        err::Err write(video::Packet *packet);
+
+        /**
+         * Finish current fragment and write all buffered data to file, not wait fragment_ms.
+         * @return err::Err type
+         * @maixpy maix.video.MP4Muxer.flush
+         */
+        err::Err flush();
+
+        /**
+         * Finish file, write index and duration, then close file.
+         * Can be called multiple times, only the first call take effect.
+         * @return err::Err type
+         * @maixpy maix.video.MP4Muxer.finish
+         */
+        err::Err finish();
+
+        /**
+         * Get number of frames written.
+         * @return frame count
+         * @maixpy maix.video.MP4Muxer.frame_count
+         */
+        int frame_count();
+
+        /**
+         * Get duration of written frames, unit: time_base.
+         * @return duration
+         * @maixpy maix.video.MP4Muxer.duration
+         */
+        uint64_t duration();
+
+        /**
+         * Get file size written, include data in write buffer.
+         * @return file size, unit byte
+         * @maixpy maix.video.MP4Muxer.size
+         */
+        uint64_t size();
+
+    private:
+        std::string _path;
+        void *_param;
+    };
+} // namespace maix::video
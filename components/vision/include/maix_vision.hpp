@@ -1,4 +1,8 @@
 #include "maix_image.hpp"
+#include "maix_image_preprocess.hpp"
+#include "maix_image_yuv.hpp"
+#include "maix_image_overlay.hpp"
 #include "maix_display.hpp"
 #include "maix_camera.hpp"
 #include "maix_video.hpp"
+#include "maix_pipeline.hpp"
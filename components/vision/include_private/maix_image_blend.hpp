@@ -0,0 +1,86 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#pragma once
+
+#include "maix_image.hpp"
+#include <vector>
+
+namespace maix::image
+{
+    /**
+     * Color space of image layout
+     */
+    enum
+    {
+        BLEND_SPACE_RGB = 0,
+        BLEND_SPACE_YUV,
+        BLEND_SPACE_GRAY
+    };
+
+    /**
+     * One plane of image data
+     */
+    typedef struct
+    {
+        int offset;  // offset of plane in image data
+        int stride;  // bytes per row
+        int bpp;     // bytes per plane pixel
+        int sub_x;   // horizontal subsample, 1 or 2
+        int sub_y;   // vertical subsample, 1 or 2
+        int chan[4]; // channel of every byte, 0 ~ 2 are color channels of space, 3 is alpha
+    } blend_plane_t;
+
+    typedef struct
+    {
+        int space;
+        int num;
+        bool alpha; // has alpha channel
+        blend_plane_t planes[3];
+    } blend_layout_t;
+
+    /**
+     * Premultiplied color and alpha of an image region, in planes of destination format.
+     * Every byte of destination has a color byte and an alpha byte, so blend kernels work on bytes of any format,
+     * chroma of YUV formats is averaged in subsample blocks from the left top corner of region.
+     */
+    typedef struct
+    {
+        int w;
+        int h;
+        blend_layout_t layout;     // layout of destination format with region size, offset is 0
+        std::vector<uint8_t> p[3]; // premultiplied color of every plane
+        std::vector<uint8_t> a[3]; // alpha of every byte of every plane
+    } blend_premul_t;
+
+    /**
+     * Get planes layout of format
+     * @return false if format not support, support GRAYSCALE, RGB888, BGR888, RGBA8888, BGRA8888,
+     *         YUV422SP, YUV422P, YVU420SP, YUV420SP, YVU420P and YUV420P.
+     */
+    bool blend_get_layout(image::Format format, int width, int height, blend_layout_t &layout);
+
+    /**
+     * Convert region of src to premultiplied planes of dst_format, region should be inside src
+     * @param alpha multiply to source alpha, [0, 1]
+     * @throw err::Exception if format not support
+     */
+    void blend_prepare(image::Image &src, int x, int y, int w, int h, image::Format dst_format, float alpha, blend_premul_t &out);
+
+    /**
+     * Composite rectangle [rx, ry, rw, rh] of src on dst, src left top corner is at (x, y) of dst, clip to src and dst.
+     * x, y, rx and ry should be multiple of subsample of dst format, e.g. 2 for YVU420SP.
+     * Additive and multiply modes only work on Y plane of YUV formats, chroma planes use source over.
+     */
+    void blend_composite(image::Image &dst, int x, int y, const blend_premul_t &src, int rx, int ry, int rw, int rh, image::BlendMode mode);
+
+    /**
+     * Composite src on dst at (x, y), in row bands on thread pool, no whole image conversion.
+     * x and y are aligned down to subsample of dst format.
+     */
+    void blend_image(image::Image &dst, int x, int y, image::Image &src, image::BlendMode mode, float alpha);
+}
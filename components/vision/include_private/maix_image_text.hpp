@@ -0,0 +1,68 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#pragma once
+
+#include "maix_image.hpp"
+#include "maix_err.hpp"
+#include "opencv2/opencv.hpp"
+
+namespace maix::image
+{
+    /**
+     * Load FreeType font for cached text rendering, load_font call this too.
+     * @param name font name
+     * @param path font file path, ttf/otf/ttc
+     * @param size font size in pixel
+     * @return err::Err
+     */
+    err::Err text_load_font(const std::string &name, const std::string &path, int size);
+
+    /**
+     * Text renderer with glyph cache, shared by all images.
+     * FreeType glyphs are rendered once per font, pixel height and channels, stored in a glyph atlas,
+     * text is shaped by harfbuzz and the glyph ids of recent strings are cached too.
+     * Hershey fonts are cached as string masks.
+     * Cache is locked until this object destructed, so draw or measure many strings with one object,
+     * and never create another TextRender in the same thread before this one destructed.
+     */
+    class TextRender
+    {
+    public:
+        /**
+         * @param font_name font name, FreeType font should be loaded by text_load_font first
+         * @param font_id -1 means FreeType font, else opencv's HersheyFonts id
+         * @param scale font scale
+         * @param thickness text thickness, negative means filled
+         * @throw err::Exception if font not loaded
+         */
+        TextRender(const std::string &font_name, int font_id, float scale, int thickness);
+        ~TextRender();
+
+        /**
+         * Can draw with cache, FreeType outline text(thickness > 0) can only measure, draw it by cv::freetype
+         */
+        static bool can_draw(int font_id, int thickness) { return font_id != -1 || thickness < 0; }
+
+        /**
+         * Text size, same as Image::draw_string measure, height include baseline
+         */
+        cv::Size size(const std::string &text);
+
+        /**
+         * Draw text by left top corner
+         * @param img CV_8UC1, CV_8UC3 or CV_8UC4 image
+         * @param text text in UTF-8
+         * @param point left top corner of text
+         * @param color color of img channels order, the 4th channel is blended too like opencv
+         */
+        void draw(cv::Mat &img, const std::string &text, const cv::Point &point, const cv::Scalar &color);
+
+    private:
+        void *_param;
+    };
+}
@@ -23,10 +23,14 @@
 #include <assert.h>
 #include <sys/mman.h>
 #include <poll.h>
+#include <mutex>
+#include <memory>
 #include "maix_err.hpp"
 #include "maix_log.hpp"
 #include "maix_image.hpp"
+#include "maix_thread.hpp"
 #include "maix_camera_base.hpp"
+#include "maix_camera_v4l2_convert.hpp"
 
 #ifndef V4L2_PIX_FMT_RGBA32
 #define V4L2_PIX_FMT_RGBA32 v4l2_fourcc('R', 'G', 'B', 'A') /* 32  RGBA-8-8-8-8    */
@@ -47,11 +51,17 @@ namespace maix::camera
         return r;
     }
 
+    static bool is_target_format_support(int target)
+    {
+        return target == image::FMT_RGB888 || target == image::FMT_RGBA8888 ||
+               target == image::FMT_BGR888 || target == image::FMT_BGRA8888 ||
+               target == image::FMT_YVU420SP || target == image::FMT_GRAYSCALE;
+    }
+
     static int choose_format(int target, const std::vector<uint32_t> &formats)
     {
         int final = 0;
-        if (!(target == image::FMT_RGB888 || target == image::FMT_RGBA8888 ||
-              target == image::FMT_BGR888 || target == image::FMT_BGRA8888))
+        if (!is_target_format_support(target))
             throw std::runtime_error("format not support");
 
         for (size_t i = 1; i < formats.size(); i++)
@@ -74,6 +84,18 @@ namespace maix::camera
                 final = i;
                 break;
             }
+            if (target == image::FMT_YVU420SP && formats[i] == V4L2_PIX_FMT_NV21)
+            {
+                log::debug("raw choose NV21 mode\n");
+                final = i;
+                break;
+            }
+            if (target == image::FMT_GRAYSCALE && formats[i] == V4L2_PIX_FMT_GREY)
+            {
+                log::debug("raw choose GREY mode\n");
+                final = i;
+                break;
+            }
             if (formats[i] == V4L2_PIX_FMT_YUYV)
             {
                 log::debug("raw choose YUYV 422 mode\n");
@@ -87,409 +109,90 @@ namespace maix::camera
 
     static bool need_convert_format(uint32_t raw_format, int target_format)
     {
-        if (!(target_format == image::FMT_RGB888 || target_format == image::FMT_RGBA8888 ||
-              target_format == image::FMT_BGR888 || target_format == image::FMT_BGRA8888))
+        if (!is_target_format_support(target_format))
             throw std::runtime_error("format not support");
         return !((target_format == image::FMT_RGB888 && raw_format == V4L2_PIX_FMT_RGB24) ||
                  (target_format == image::FMT_RGBA8888 && raw_format == V4L2_PIX_FMT_RGBA32) ||
                  (target_format == image::FMT_BGR888 && raw_format == V4L2_PIX_FMT_BGR24) ||
-                 (target_format == image::FMT_BGRA8888 && raw_format == V4L2_PIX_FMT_BGRA32));
+                 (target_format == image::FMT_BGRA8888 && raw_format == V4L2_PIX_FMT_BGRA32) ||
+                 (target_format == image::FMT_YVU420SP && raw_format == V4L2_PIX_FMT_NV21) ||
+                 (target_format == image::FMT_GRAYSCALE && raw_format == V4L2_PIX_FMT_GREY));
     }
 
     static void *alloc_buffer(int width, int height, int format)
     {
-        if (!(format == image::FMT_RGB888 || format == image::FMT_RGBA8888 ||
-              format == image::FMT_BGR888 || format == image::FMT_BGRA8888))
+        if (!is_target_format_support(format))
             throw std::runtime_error("format not support");
-        if (format == image::FMT_RGBA8888 || format == image::FMT_BGRA8888)
-            return malloc(width * height * 4);
-        // if (format == image::FMT_YUV422)
-        //     return malloc(width * height * 2);
-        return malloc(width * height * 3);
+        return malloc(width * height * image::fmt_size[format]);
     }
 
-    static void yuyv422_to_rgb888(void *src, void *dst, int width, int height)
-    {
-        uint8_t *rgb = (uint8_t *)dst;
-        uint8_t *yuyv = (uint8_t *)src;
-        uint8_t y0, u, y1, v;
-        float r, g, b;
-        for (int y = 0; y < height; ++y)
-        {
-            for (int x = 0; x < width;)
-            {
-                y0 = yuyv[0];
-                u = yuyv[1];
-                y1 = yuyv[2];
-                v = yuyv[3];
-
-                // BT601 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y0 - 16) + 1.596 * (v - 128);
-                // g = 1.164384 * (y0 - 16) - 0.813 * (v - 128) - 0.391 * (u - 128);
-                // b = 1.164384 * (y0 - 16) + 2.018 * (u - 128);
-                // BT601 YUV data is full range, to RGB[0, 255]
-                // r = y0 + 1.402 * (v - 128);
-                // g = y0 - 0.344 * (u - 128) - 0.714 * (v - 128);
-                // b = y0 + 1.772 * (u - 128);
-                // BT709 YUV data is limited range, to RGB[0, 255]
-                r = 1.164384 * (y0 - 16) + 1.79271 * (v - 128);
-                g = 1.164384 * (y0 - 16) - 0.532909 * (v - 128) - 0.213249 * (u - 128);
-                b = 1.164384 * (y0 - 16) + 2.112402 * (u - 128);
-                // BT709 YUV data is full range, to RGB[0, 255]
-                // r = y0 + 1.5748 * (v - 128);
-                // g = y0 - 0.1873 * (u - 128) - 0.4681 * (v - 128);
-                // b = y0 + 1.8556 * (u - 128);
-                // BT2020 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y0 - 16) + 1.67867 * (v - 128);
-                // g = 1.164384 * (y0 - 16) - 0.65042 * (v - 128) - 0.187326 * (u - 128);
-                // b = 1.164384 * (y0 - 16) + 2.14177 * (u - 128);
-                // BT2020 YUV data is full range, to RGB[0, 255]
-                // r = y0 + 1.4746 * (v - 128)
-                // g = y0 - 0.164553 * (u - 128) - 0.571353 * (u - 128)
-                // b = y0 + 1.8814 * (u - 128)
-
-                r = r > 255 ? 255 : (r < 0 ? 0 : r);
-                g = g > 255 ? 255 : (g < 0 ? 0 : g);
-                b = b > 255 ? 255 : (b < 0 ? 0 : b);
-                rgb[0] = (uint8_t)r;
-                rgb[1] = (uint8_t)g;
-                rgb[2] = (uint8_t)b;
-
-                // BT601 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y1 - 16) + 1.596 * (v - 128);
-                // g = 1.164384 * (y1 - 16) - 0.813 * (v - 128) - 0.391 * (u - 128);
-                // b = 1.164384 * (y1 - 16) + 2.018 * (u - 128);
-                // BT601 YUV data is full range, to RGB[0, 255]
-                // r = y1 + 1.402 * (v - 128);
-                // g = y1 - 0.344 * (u - 128) - 0.714 * (v - 128);
-                // b = y1 + 1.772 * (u - 128);
-                // BT709 YUV data is limited range, to RGB[0, 255]
-                r = 1.164384 * (y1 - 16) + 1.79271 * (v - 128);
-                g = 1.164384 * (y1 - 16) - 0.532909 * (v - 128) - 0.213249 * (u - 128);
-                b = 1.164384 * (y1 - 16) + 2.112402 * (u - 128);
-                // BT709 YUV data is full range, to RGB[0, 255]
-                // r = y1 + 1.5748 * (v - 128);
-                // g = y1 - 0.1873 * (u - 128) - 0.4681 * (v - 128);
-                // b = y1 + 1.8556 * (u - 128);
-                // BT2020 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y1 - 16) + 1.67867 * (v - 128);
-                // g = 1.164384 * (y1 - 16) - 0.65042 * (v - 128) - 0.187326 * (u - 128);
-                // b = 1.164384 * (y1 - 16) + 2.14177 * (u - 128);
-                // BT2020 YUV data is full range, to RGB[0, 255]
-                // r = y1 + 1.4746 * (v - 128)
-                // g = y1 - 0.164553 * (u - 128) - 0.571353 * (u - 128)
-                // b = y1 + 1.8814 * (u - 128)
-
-                r = r > 255 ? 255 : (r < 0 ? 0 : r);
-                g = g > 255 ? 255 : (g < 0 ? 0 : g);
-                b = b > 255 ? 255 : (b < 0 ? 0 : b);
-                rgb[3] = (uint8_t)r;
-                rgb[4] = (uint8_t)g;
-                rgb[5] = (uint8_t)b;
-                yuyv += 4;
-                rgb += 6;
-                x += 2;
-            }
-        }
-    }
-
-    static void yuyv422_to_bgr888(void *src, void *dst, int width, int height)
+    static int convert_format(void *raw_buff, void *buff, uint32_t raw_format, int format, int width, int height)
     {
-        uint8_t *rgb = (uint8_t *)dst;
-        uint8_t *yuyv = (uint8_t *)src;
-        uint8_t y0, u, y1, v;
-        float r, g, b;
-        for (int y = 0; y < height; ++y)
-        {
-            for (int x = 0; x < width;)
-            {
-                y0 = yuyv[0];
-                u = yuyv[1];
-                y1 = yuyv[2];
-                v = yuyv[3];
-
-                // BT601 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y0 - 16) + 1.596 * (v - 128);
-                // g = 1.164384 * (y0 - 16) - 0.813 * (v - 128) - 0.391 * (u - 128);
-                // b = 1.164384 * (y0 - 16) + 2.018 * (u - 128);
-                // BT601 YUV data is full range, to RGB[0, 255]
-                r = y0 + 1.402 * (v - 128);
-                g = y0 - 0.344 * (u - 128) - 0.714 * (v - 128);
-                b = y0 + 1.772 * (u - 128);
-                // BT709 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y0 - 16) + 1.79271 * (v - 128);
-                // g = 1.164384 * (y0 - 16) - 0.532909 * (v - 128) - 0.213249 * (u - 128);
-                // b = 1.164384 * (y0 - 16) + 2.112402 * (u - 128);
-                // BT709 YUV data is full range, to RGB[0, 255]
-                // r = y0 + 1.5748 * (v - 128);
-                // g = y0 - 0.1873 * (u - 128) - 0.4681 * (v - 128);
-                // b = y0 + 1.8556 * (u - 128);
-                // BT2020 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y0 - 16) + 1.67867 * (v - 128);
-                // g = 1.164384 * (y0 - 16) - 0.65042 * (v - 128) - 0.187326 * (u - 128);
-                // b = 1.164384 * (y0 - 16) + 2.14177 * (u - 128);
-                // BT2020 YUV data is full range, to RGB[0, 255]
-                // r = y0 + 1.4746 * (v - 128)
-                // g = y0 - 0.164553 * (u - 128) - 0.571353 * (u - 128)
-                // b = y0 + 1.8814 * (u - 128)
-
-                r = r > 255 ? 255 : (r < 0 ? 0 : r);
-                g = g > 255 ? 255 : (g < 0 ? 0 : g);
-                b = b > 255 ? 255 : (b < 0 ? 0 : b);
-                rgb[0] = (uint8_t)b;
-                rgb[1] = (uint8_t)g;
-                rgb[2] = (uint8_t)r;
-
-                // BT601 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y1 - 16) + 1.596 * (v - 128);
-                // g = 1.164384 * (y1 - 16) - 0.813 * (v - 128) - 0.391 * (u - 128);
-                // b = 1.164384 * (y1 - 16) + 2.018 * (u - 128);
-                // BT601 YUV data is full range, to RGB[0, 255]
-                r = y1 + 1.402 * (v - 128);
-                g = y1 - 0.344 * (u - 128) - 0.714 * (v - 128);
-                b = y1 + 1.772 * (u - 128);
-                // BT709 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y1 - 16) + 1.79271 * (v - 128);
-                // g = 1.164384 * (y1 - 16) - 0.532909 * (v - 128) - 0.213249 * (u - 128);
-                // b = 1.164384 * (y1 - 16) + 2.112402 * (u - 128);
-                // BT709 YUV data is full range, to RGB[0, 255]
-                // r = y1 + 1.5748 * (v - 128);
-                // g = y1 - 0.1873 * (u - 128) - 0.4681 * (v - 128);
-                // b = y1 + 1.8556 * (u - 128);
-                // BT2020 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y1 - 16) + 1.67867 * (v - 128);
-                // g = 1.164384 * (y1 - 16) - 0.65042 * (v - 128) - 0.187326 * (u - 128);
-                // b = 1.164384 * (y1 - 16) + 2.14177 * (u - 128);
-                // BT2020 YUV data is full range, to RGB[0, 255]
-                // r = y1 + 1.4746 * (v - 128)
-                // g = y1 - 0.164553 * (u - 128) - 0.571353 * (u - 128)
-                // b = y1 + 1.8814 * (u - 128)
-
-                r = r > 255 ? 255 : (r < 0 ? 0 : r);
-                g = g > 255 ? 255 : (g < 0 ? 0 : g);
-                b = b > 255 ? 255 : (b < 0 ? 0 : b);
-                rgb[3] = (uint8_t)b;
-                rgb[4] = (uint8_t)g;
-                rgb[5] = (uint8_t)r;
-                yuyv += 4;
-                rgb += 6;
-                x += 2;
-            }
-        }
-    }
+        if (!is_target_format_support(format))
+            throw std::runtime_error("format not support");
+        if (raw_format != V4L2_PIX_FMT_YUYV)
+            throw std::runtime_error("raw format not support");
 
-    // V4L2_PIX_FMT_YUYV to RGBA8888
-    static void yuyv422_to_rgba8888(void *src, void *dst, int width, int height)
-    {
-        uint8_t *rgba = (uint8_t *)dst;
-        uint8_t *yuyv = (uint8_t *)src;
-        uint8_t y0, u, y1, v;
-        float r, g, b;
-        for (int y = 0; y < height; ++y)
+        // kernel chosen once per format, SIMD version if CPU support
+        static yuyv_convert_func_t funcs[image::FMT_UNCOMPRESSED_MAX] = {NULL};
+        if (!funcs[format])
+            funcs[format] = yuyv_convert_func(format);
+        if (!funcs[format])
+            return EINVAL;
+        yuyv_convert_func_t func = funcs[format];
+        const uint8_t *src = (const uint8_t *)raw_buff;
+        uint8_t *dst = (uint8_t *)buff;
+        if (format == image::FMT_YVU420SP)
         {
-            for (int x = 0; x < width;)
-            {
-                y0 = yuyv[0];
-                u = yuyv[1];
-                y1 = yuyv[2];
-                v = yuyv[3];
-                // BT601 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y0 - 16) + 1.596 * (v - 128);
-                // g = 1.164384 * (y0 - 16) - 0.813 * (v - 128) - 0.391 * (u - 128);
-                // b = 1.164384 * (y0 - 16) + 2.018 * (u - 128);
-                // BT601 YUV data is full range, to RGB[0, 255]
-                // r = y0 + 1.402 * (v - 128);
-                // g = y0 - 0.344 * (u - 128) - 0.714 * (v - 128);
-                // b = y0 + 1.772 * (u - 128);
-                // BT709 YUV data is limited range, to RGB[0, 255]
-                r = 1.164384 * (y0 - 16) + 1.793 * (v - 128);
-                g = 1.164384 * (y0 - 16) - 0.534 * (v - 128) - 0.213 * (u - 128);
-                b = 1.164384 * (y0 - 16) + 2.115 * (u - 128);
-                // BT709 YUV data is full range, to RGB[0, 255]
-                // r = y0 + 1.5748 * (v - 128);
-                // g = y0 - 0.1873 * (u - 128) - 0.4681 * (v - 128);
-                // b = y0 + 1.8556 * (u - 128);
-                // BT2020 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y0 - 16) + 1.67867 * (v - 128);
-                // g = 1.164384 * (y0 - 16) - 0.65042 * (v - 128) - 0.187326 * (u - 128);
-                // b = 1.164384 * (y0 - 16) + 2.14177 * (u - 128);
-                // BT2020 YUV data is full range, to RGB[0, 255]
-                // r = y0 + 1.4746 * (v - 128)
-                // g = y0 - 0.164553 * (u - 128) - 0.571353 * (u - 128)
-                // b = y0 + 1.8814 * (u - 128)
-
-                r = r > 255 ? 255 : (r < 0 ? 0 : r);
-                g = g > 255 ? 255 : (g < 0 ? 0 : g);
-                b = b > 255 ? 255 : (b < 0 ? 0 : b);
-                rgba[0] = (uint8_t)r;
-                rgba[1] = (uint8_t)g;
-                rgba[2] = (uint8_t)b;
-                rgba[3] = 255;
-
-                // BT601 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y1 - 16) + 1.596 * (v - 128);
-                // g = 1.164384 * (y1 - 16) - 0.813 * (v - 128) - 0.391 * (u - 128);
-                // b = 1.164384 * (y1 - 16) + 2.018 * (u - 128);
-                // BT601 YUV data is full range, to RGB[0, 255]
-                // r = y1 + 1.402 * (v - 128);
-                // g = y1 - 0.344 * (u - 128) - 0.714 * (v - 128);
-                // b = y1 + 1.772 * (u - 128);
-                // BT709 YUV data is limited range, to RGB[0, 255]
-                r = 1.164384 * (y1 - 16) + 1.793 * (v - 128);
-                g = 1.164384 * (y1 - 16) - 0.534 * (v - 128) - 0.213 * (u - 128);
-                b = 1.164384 * (y1 - 16) + 2.115 * (u - 128);
-                // BT709 YUV data is full range, to RGB[0, 255]
-                // r = y1 + 1.5748 * (v - 128);
-                // g = y1 - 0.1873 * (u - 128) - 0.4681 * (v - 128);
-                // b = y1 + 1.8556 * (u - 128);
-                // BT2020 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y1 - 16) + 1.67867 * (v - 128);
-                // g = 1.164384 * (y1 - 16) - 0.65042 * (v - 128) - 0.187326 * (u - 128);
-                // b = 1.164384 * (y1 - 16) + 2.14177 * (u - 128);
-                // BT2020 YUV data is full range, to RGB[0, 255]
-                // r = y1 + 1.4746 * (v - 128)
-                // g = y1 - 0.164553 * (u - 128) - 0.571353 * (u - 128)
-                // b = y1 + 1.8814 * (u - 128)
-
-                r = r > 255 ? 255 : (r < 0 ? 0 : r);
-                g = g > 255 ? 255 : (g < 0 ? 0 : g);
-                b = b > 255 ? 255 : (b < 0 ? 0 : b);
-                rgba[4] = (uint8_t)r;
-                rgba[5] = (uint8_t)g;
-                rgba[6] = (uint8_t)b;
-                rgba[7] = 255;
-                yuyv += 4;
-                rgba += 8;
-                x += 2;
-            }
+            // VU plane position depends on the whole height, convert in one call
+            func(src, dst, width, height);
+            return 0;
         }
+        // packed and gray output rows only depend on the same source rows, convert row bands in parallel
+        int dst_stride = width * (int)image::fmt_size[format];
+        thread::parallel_for(0, height, [func, src, dst, width, dst_stride](int y_begin, int y_end) {
+            func(src + y_begin * width * 2, dst + y_begin * dst_stride, width, y_end - y_begin);
+        }, 16);
+        return 0;
     }
 
-    // V4L2_PIX_FMT_YUYV to RGBA8888
-    static void yuyv422_to_bgra8888(void *src, void *dst, int width, int height)
+    /**
+     * Driver buffers held by user images in zero copy mode,
+     * shared with images' release callback so camera can be closed before images destroyed.
+     */
+    class V4L2HeldBuffers
     {
-        uint8_t *rgba = (uint8_t *)dst;
-        uint8_t *yuyv = (uint8_t *)src;
-        uint8_t y0, u, y1, v;
-        float r, g, b;
-
-        for (int y = 0; y < height; ++y)
+    public:
+        ~V4L2HeldBuffers()
         {
-            for (int x = 0; x < width;)
-            {
-                y0 = yuyv[0];
-                u = yuyv[1];
-                y1 = yuyv[2];
-                v = yuyv[3];
-
-                // BT601 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y0 - 16) + 1.596 * (v - 128);
-                // g = 1.164384 * (y0 - 16) - 0.813 * (v - 128) - 0.391 * (u - 128);
-                // b = 1.164384 * (y0 - 16) + 2.018 * (u - 128);
-                // BT601 YUV data is full range, to RGB[0, 255]
-                // r = y0 + 1.402 * (v - 128);
-                // g = y0 - 0.344 * (u - 128) - 0.714 * (v - 128);
-                // b = y0 + 1.772 * (u - 128);
-                // BT709 YUV data is limited range, to RGB[0, 255]
-                r = 1.164384 * (y0 - 16) + 1.793 * (v - 128);
-                g = 1.164384 * (y0 - 16) - 0.534 * (v - 128) - 0.213 * (u - 128);
-                b = 1.164384 * (y0 - 16) + 2.115 * (u - 128);
-                // BT709 YUV data is full range, to RGB[0, 255]
-                // r = y0 + 1.5748 * (v - 128);
-                // g = y0 - 0.1873 * (u - 128) - 0.4681 * (v - 128);
-                // b = y0 + 1.8556 * (u - 128);
-                // BT2020 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y0 - 16) + 1.67867 * (v - 128);
-                // g = 1.164384 * (y0 - 16) - 0.65042 * (v - 128) - 0.187326 * (u - 128);
-                // b = 1.164384 * (y0 - 16) + 2.14177 * (u - 128);
-                // BT2020 YUV data is full range, to RGB[0, 255]
-                // r = y0 + 1.4746 * (v - 128)
-                // g = y0 - 0.164553 * (u - 128) - 0.571353 * (u - 128)
-                // b = y0 + 1.8814 * (u - 128)
-
-                r = r > 255 ? 255 : (r < 0 ? 0 : r);
-                g = g > 255 ? 255 : (g < 0 ? 0 : g);
-                b = b > 255 ? 255 : (b < 0 ? 0 : b);
-
-                rgba[0] = (uint8_t)b;
-                rgba[1] = (uint8_t)g;
-                rgba[2] = (uint8_t)r;
-                rgba[3] = 255;
-
-                // BT601 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y1 - 16) + 1.596 * (v - 128);
-                // g = 1.164384 * (y1 - 16) - 0.813 * (v - 128) - 0.391 * (u - 128);
-                // b = 1.164384 * (y1 - 16) + 2.018 * (u - 128);
-                // BT601 YUV data is full range, to RGB[0, 255]
-                // r = y1 + 1.402 * (v - 128);
-                // g = y1 - 0.344 * (u - 128) - 0.714 * (v - 128);
-                // b = y1 + 1.772 * (u - 128);
-                // BT709 YUV data is limited range, to RGB[0, 255]
-                r = 1.164384 * (y1 - 16) + 1.793 * (v - 128);
-                g = 1.164384 * (y1 - 16) - 0.534 * (v - 128) - 0.213 * (u - 128);
-                b = 1.164384 * (y1 - 16) + 2.115 * (u - 128);
-                // BT709 YUV data is full range, to RGB[0, 255]
-                // r = y1 + 1.5748 * (v - 128);
-                // g = y1 - 0.1873 * (u - 128) - 0.4681 * (v - 128);
-                // b = y1 + 1.8556 * (u - 128);
-                // BT2020 YUV data is limited range, to RGB[0, 255]
-                // r = 1.164384 * (y1 - 16) + 1.67867 * (v - 128);
-                // g = 1.164384 * (y1 - 16) - 0.65042 * (v - 128) - 0.187326 * (u - 128);
-                // b = 1.164384 * (y1 - 16) + 2.14177 * (u - 128);
-                // BT2020 YUV data is full range, to RGB[0, 255]
-                // r = y1 + 1.4746 * (v - 128)
-                // g = y1 - 0.164553 * (u - 128) - 0.571353 * (u - 128)
-                // b = y1 + 1.8814 * (u - 128)
-
-                r = r > 255 ? 255 : (r < 0 ? 0 : r);
-                g = g > 255 ? 255 : (g < 0 ? 0 : g);
-                b = b > 255 ? 255 : (b < 0 ? 0 : b);
-
-                rgba[4] = (uint8_t)b;
-                rgba[5] = (uint8_t)g;
-                rgba[6] = (uint8_t)r;
-                rgba[7] = 255;
-                yuyv += 4;
-                rgba += 8;
-                x += 2;
-            }
+            for (size_t i = 0; i < unmap_addrs.size(); ++i)
+                munmap(unmap_addrs[i], unmap_lens[i]);
         }
-    }
-
-    static int convert_format(void *raw_buff, void *buff, uint32_t raw_format, int format, int width, int height)
-    {
-        int ret = 0;
 
-        if (!(format == image::FMT_RGB888 || format == image::FMT_BGR888 ||
-              format == image::FMT_RGBA8888 || format == image::FMT_BGRA8888))
-            throw std::runtime_error("format not support");
-        if (raw_format != V4L2_PIX_FMT_YUYV)
-            throw std::runtime_error("raw format not support");
-
-        if (raw_format == V4L2_PIX_FMT_YUYV)
+        void release(int index)
         {
-            switch (format)
+            std::lock_guard<std::mutex> guard(lock);
+            if (fd >= 0)
             {
-            case image::FMT_RGB888:
-                yuyv422_to_rgb888(raw_buff, buff, width, height);
-                break;
-            case image::FMT_BGR888:
-                yuyv422_to_bgr888(raw_buff, buff, width, height);
-                break;
-            case image::FMT_RGBA8888:
-                yuyv422_to_rgba8888(raw_buff, buff, width, height);
-                break;
-            case image::FMT_BGRA8888:
-                yuyv422_to_bgra8888(raw_buff, buff, width, height);
-                break;
-            default:
-                ret = EINVAL;
-                break;
+                struct v4l2_buffer v4l2_buf;
+                memset(&v4l2_buf, 0, sizeof(struct v4l2_buffer));
+                v4l2_buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+                v4l2_buf.memory = V4L2_MEMORY_MMAP;
+                v4l2_buf.index = index;
+                if (ioctl(fd, VIDIOC_QBUF, &v4l2_buf) < 0)
+                    log::error("ERR(%s):VIDIOC_QBUF failed\n", __func__);
             }
+            held[index] = false;
+            --held_num;
         }
 
-        return ret;
-    }
+        std::mutex lock;
+        int fd = -1;              // -1 means camera closed, buffer will not queue back to driver
+        int held_num = 0;
+        std::vector<bool> held;
+        std::vector<void *> unmap_addrs; // mmap buffers still used by images when camera closed
+        std::vector<int> unmap_lens;
+    };
 
     class CameraV4L2 final : public CameraBase
     {
@@ -510,6 +213,7 @@ namespace maix::camera
             queue_id = -1;
             buff = NULL;
             buff_alloc = false;
+            zero_copy_max_hold = 0;
         }
 
         CameraV4L2(const std::string device, int ch, int width, int height, image::Format format, int buff_num)
@@ -544,6 +248,8 @@ namespace maix::camera
             this->width = width > 0 ? width : this->width;
             this->height = height > 0 ? height : this->height;
             this->buffer_num = buff_num;
+            buffers.assign(buffer_num, NULL);
+            buffers_len.assign(buffer_num, 0);
 
             fd = ::open(device.c_str(), O_RDWR | O_NONBLOCK, 0);
             if (fd == -1)
@@ -825,6 +531,10 @@ namespace maix::camera
                 }
             }
 
+            held_buffers = std::make_shared<V4L2HeldBuffers>();
+            held_buffers->fd = fd;
+            held_buffers->held.assign(buffer_num, false);
+
             enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
             if (ioctl(fd, VIDIOC_STREAMON, &type) < 0)
@@ -837,16 +547,28 @@ namespace maix::camera
         } // open
 
         // read
+        err::Err set_zero_copy(bool enable, int max_hold = 1)
+        {
+            if (enable && (max_hold <= 0 || max_hold >= buffer_num))
+            {
+                log::error("zero copy max_hold should in range [1, %d]\n", buffer_num - 1);
+                return err::ERR_ARGS;
+            }
+            zero_copy_max_hold = enable ? max_hold : 0;
+            return err::ERR_NONE;
+        }
+
         image::Image *read(void *buff = NULL, size_t buff_size = 0)
         {
             struct v4l2_buffer v4l2_buf;
-            if (!buff)
-                buff = this->buff;
             if (fd < 0)
             {
                 log::error("Camera not open\n");
                 return NULL;
             }
+            bool zero_copy = !buff && zero_copy_max_hold > 0 && !need_convert_format(raw_format, format);
+            if (!buff)
+                buff = this->buff;
             //
             if (queue_id >= 0)
             {
@@ -863,6 +585,16 @@ namespace maix::camera
                 queue_id = -1;
             }
 
+            if (zero_copy)
+            {
+                std::lock_guard<std::mutex> guard(held_buffers->lock);
+                if (held_buffers->held_num >= zero_copy_max_hold)
+                {
+                    log::error("zero copy mode user hold %d frames, release image before read new one\n", held_buffers->held_num);
+                    return NULL;
+                }
+            }
+
             struct pollfd poll_fds[1];
 
             poll_fds[0].fd = fd;
@@ -909,6 +641,19 @@ namespace maix::camera
                 }
                 return new image::Image(width, height, format, (uint8_t *)buff, -1, true);
             }
+            else if (zero_copy)
+            {
+                image::Image *img = new image::Image(width, height, format, (uint8_t *)buffers[buffer.index], -1, false);
+                {
+                    std::lock_guard<std::mutex> guard(held_buffers->lock);
+                    held_buffers->held[buffer.index] = true;
+                    ++held_buffers->held_num;
+                }
+                std::shared_ptr<V4L2HeldBuffers> held = held_buffers;
+                int index = buffer.index;
+                img->set_release_callback([held, index](void *) { held->release(index); });
+                return img;
+            }
             else
             {
                 queue_id = buffer.index;
@@ -926,10 +671,31 @@ namespace maix::camera
                     log::error("ERR(%s):VIDIOC_STREAMOFF failed\n", __func__);
                     return;
                 }
-                for (int i = 0; i < buffer_num; ++i)
-                    munmap(buffers[i], buffers_len[i]);
+                if (!held_buffers)
+                {
+                    for (int i = 0; i < buffer_num; ++i)
+                        munmap(buffers[i], buffers_len[i]);
+                }
+                else
+                {
+                    std::lock_guard<std::mutex> guard(held_buffers->lock);
+                    held_buffers->fd = -1;
+                    for (int i = 0; i < buffer_num; ++i)
+                    {
+                        if (held_buffers->held[i])
+                        {
+                            // still used by image, unmap when image destroyed
+                            held_buffers->unmap_addrs.push_back(buffers[i]);
+                            held_buffers->unmap_lens.push_back(buffers_len[i]);
+                        }
+                        else
+                            munmap(buffers[i], buffers_len[i]);
+                    }
+                }
+                held_buffers.reset();
                 ::close(fd);
                 fd = -1;
+                queue_id = -1;
             }
             if (buff_alloc)
             {
@@ -945,6 +711,8 @@ namespace maix::camera
 
         void clear_buff()
         {
+            if (fd < 0 || !held_buffers)
+                return;
             // VIDIOC_DQBUF all buffer
             struct v4l2_buffer buffer;
             buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -955,9 +723,13 @@ namespace maix::camera
                 buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
                 buffer.memory = V4L2_MEMORY_MMAP;
             }
-            // VIDIOC_QBUF all buffer
+            // VIDIOC_QBUF all buffer except held by user
+            std::lock_guard<std::mutex> guard(held_buffers->lock);
+            queue_id = -1;
             for (int i = 0; i < buffer_num; ++i)
             {
+                if (held_buffers->held[i])
+                    continue;
                 memset(&buffer, 0, sizeof(struct v4l2_buffer));
                 buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
                 buffer.memory = V4L2_MEMORY_MMAP;
@@ -1048,6 +820,8 @@ namespace maix::camera
         int height;
         void *buff;
         bool buff_alloc;
+        int zero_copy_max_hold; // 0 means zero copy disabled
+        std::shared_ptr<V4L2HeldBuffers> held_buffers;
     };
 
 } // namespace maix::camera
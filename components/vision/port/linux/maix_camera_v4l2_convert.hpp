@@ -0,0 +1,420 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add fixed point and SIMD YUYV convert kernels.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "maix_image_def.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MAIX_YUYV_X86 1
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MAIX_YUYV_NEON 1
+#endif
+
+namespace maix::camera
+{
+    /**
+     * YUYV(YUY2) convert kernel, src is packed YUYV422, dst is target format.
+     * width must be even, src and dst have no line padding.
+     */
+    typedef void (*yuyv_convert_func_t)(const uint8_t *src, uint8_t *dst, int width, int height);
+
+    /*
+     * BT709 limited range YUV to RGB[0, 255], Q6 fixed point:
+     *   r = 1.164384 * (y - 16) + 1.79271  * (v - 128)
+     *   g = 1.164384 * (y - 16) - 0.532909 * (v - 128) - 0.213249 * (u - 128)
+     *   b = 1.164384 * (y - 16) + 2.112402 * (u - 128)
+     * All intermediate values fit in int16 except the upper bound of b, which
+     * saturates and then clamps to 255 anyway, so scalar and SIMD give the same result.
+     */
+    enum
+    {
+        YUYV_Q = 6,
+        YUYV_YC = 75,  // 1.164384 * 64
+        YUYV_RV = 115, // 1.79271 * 64
+        YUYV_GV = 34,  // 0.532909 * 64
+        YUYV_GU = 14,  // 0.213249 * 64
+        YUYV_BU = 135, // 2.112402 * 64
+    };
+
+    class YUYVTable
+    {
+    public:
+        YUYVTable()
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                y[i] = (i - 16) * YUYV_YC + (1 << (YUYV_Q - 1));
+                rv[i] = (i - 128) * YUYV_RV;
+                gv[i] = (i - 128) * YUYV_GV;
+                gu[i] = (i - 128) * YUYV_GU;
+                bu[i] = (i - 128) * YUYV_BU;
+            }
+        }
+        int32_t y[256];
+        int32_t rv[256];
+        int32_t gv[256];
+        int32_t gu[256];
+        int32_t bu[256];
+    };
+
+    static inline const YUYVTable &yuyv_table()
+    {
+        static const YUYVTable table;
+        return table;
+    }
+
+    static inline uint8_t yuyv_clamp(int32_t v)
+    {
+        v >>= YUYV_Q;
+        return v < 0 ? 0 : (v > 255 ? 255 : (uint8_t)v);
+    }
+
+    /**
+     * Scalar kernel for packed RGB/BGR/RGBA/BGRA, also the tail handler of SIMD kernels.
+     * @param n pixel number, must be even
+     */
+    template <int bpp, bool bgr>
+    static void yuyv_to_packed_scalar(const uint8_t *yuyv, uint8_t *dst, int n)
+    {
+        const YUYVTable &t = yuyv_table();
+        const int ri = bgr ? 2 : 0;
+        const int bi = bgr ? 0 : 2;
+        for (int i = 0; i < n; i += 2)
+        {
+            int32_t y0 = t.y[yuyv[0]];
+            int32_t y1 = t.y[yuyv[2]];
+            int32_t rv = t.rv[yuyv[3]];
+            int32_t guv = t.gu[yuyv[1]] + t.gv[yuyv[3]];
+            int32_t bu = t.bu[yuyv[1]];
+            dst[ri] = yuyv_clamp(y0 + rv);
+            dst[1] = yuyv_clamp(y0 - guv);
+            dst[bi] = yuyv_clamp(y0 + bu);
+            dst[bpp + ri] = yuyv_clamp(y1 + rv);
+            dst[bpp + 1] = yuyv_clamp(y1 - guv);
+            dst[bpp + bi] = yuyv_clamp(y1 + bu);
+            if (bpp == 4)
+            {
+                dst[3] = 255;
+                dst[7] = 255;
+            }
+            yuyv += 4;
+            dst += bpp * 2;
+        }
+    }
+
+    template <int bpp, bool bgr>
+    static void yuyv_to_packed_c(const uint8_t *src, uint8_t *dst, int width, int height)
+    {
+        yuyv_to_packed_scalar<bpp, bgr>(src, dst, width * height);
+    }
+
+    /**
+     * NV21, VU take from the average of two lines.
+     */
+    static void yuyv_to_nv21_rows_scalar(const uint8_t *src0, const uint8_t *src1, uint8_t *y0, uint8_t *y1, uint8_t *vu, int x, int width)
+    {
+        for (; x < width; x += 2)
+        {
+            y0[x] = src0[x * 2];
+            y0[x + 1] = src0[x * 2 + 2];
+            y1[x] = src1[x * 2];
+            y1[x + 1] = src1[x * 2 + 2];
+            vu[x] = (src0[x * 2 + 3] + src1[x * 2 + 3] + 1) >> 1;
+            vu[x + 1] = (src0[x * 2 + 1] + src1[x * 2 + 1] + 1) >> 1;
+        }
+    }
+
+    static void yuyv_to_nv21_c(const uint8_t *src, uint8_t *dst, int width, int height)
+    {
+        uint8_t *vu = dst + width * height;
+        for (int y = 0; y + 1 < height; y += 2)
+        {
+            const uint8_t *src0 = src + y * width * 2;
+            yuyv_to_nv21_rows_scalar(src0, src0 + width * 2, dst + y * width, dst + (y + 1) * width, vu + y / 2 * width, 0, width);
+        }
+    }
+
+    static void yuyv_to_gray_c(const uint8_t *src, uint8_t *dst, int width, int height)
+    {
+        int n = width * height;
+        for (int i = 0; i < n; ++i)
+            dst[i] = src[i * 2];
+    }
+
+#ifdef MAIX_YUYV_X86
+    /**
+     * Convert 8 pixels(Y, U and V as int16 lanes) to r, g, b int16 lanes in Q6 then shift to int16 [0, 255] range(not clamped).
+     */
+    __attribute__((target("ssse3"))) static inline void yuyv_rgb_x8_sse(__m128i yuyv, __m128i &r, __m128i &g, __m128i &b)
+    {
+        const __m128i mask_lo = _mm_set1_epi16(0x00ff);
+        const __m128i mask_dw = _mm_set1_epi32(0x0000ffff);
+        __m128i y = _mm_and_si128(yuyv, mask_lo);
+        __m128i uv = _mm_srli_epi16(yuyv, 8);
+        __m128i u = _mm_and_si128(uv, mask_dw);
+        __m128i v = _mm_srli_epi32(uv, 16);
+        u = _mm_or_si128(u, _mm_slli_epi32(u, 16));
+        v = _mm_or_si128(v, _mm_slli_epi32(v, 16));
+        u = _mm_sub_epi16(u, _mm_set1_epi16(128));
+        v = _mm_sub_epi16(v, _mm_set1_epi16(128));
+        y = _mm_mullo_epi16(_mm_sub_epi16(y, _mm_set1_epi16(16)), _mm_set1_epi16(YUYV_YC));
+        y = _mm_add_epi16(y, _mm_set1_epi16(1 << (YUYV_Q - 1)));
+        r = _mm_adds_epi16(y, _mm_mullo_epi16(v, _mm_set1_epi16(YUYV_RV)));
+        g = _mm_sub_epi16(y, _mm_add_epi16(_mm_mullo_epi16(v, _mm_set1_epi16(YUYV_GV)), _mm_mullo_epi16(u, _mm_set1_epi16(YUYV_GU))));
+        b = _mm_adds_epi16(y, _mm_mullo_epi16(u, _mm_set1_epi16(YUYV_BU)));
+        r = _mm_srai_epi16(r, YUYV_Q);
+        g = _mm_srai_epi16(g, YUYV_Q);
+        b = _mm_srai_epi16(b, YUYV_Q);
+    }
+
+    template <int bpp, bool bgr>
+    __attribute__((target("ssse3"))) static void yuyv_to_packed_ssse3(const uint8_t *src, uint8_t *dst, int width, int height)
+    {
+        int n = width * height;
+        int i = 0;
+        // 3 bytes per pixel store writes 4 bytes more than needed, so keep one more block for the tail
+        int simd_n = bpp == 3 ? n - 16 - 2 : n - 16;
+        const __m128i alpha = _mm_set1_epi8((char)0xff);
+        const __m128i drop_alpha = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        for (; i <= simd_n; i += 16)
+        {
+            __m128i r0, g0, b0, r1, g1, b1;
+            yuyv_rgb_x8_sse(_mm_loadu_si128((const __m128i *)(src + i * 2)), r0, g0, b0);
+            yuyv_rgb_x8_sse(_mm_loadu_si128((const __m128i *)(src + i * 2 + 16)), r1, g1, b1);
+            __m128i r = _mm_packus_epi16(r0, r1);
+            __m128i g = _mm_packus_epi16(g0, g1);
+            __m128i b = _mm_packus_epi16(b0, b1);
+            __m128i c0 = bgr ? b : r;
+            __m128i c2 = bgr ? r : b;
+            __m128i c01_lo = _mm_unpacklo_epi8(c0, g);
+            __m128i c01_hi = _mm_unpackhi_epi8(c0, g);
+            __m128i c2a_lo = _mm_unpacklo_epi8(c2, alpha);
+            __m128i c2a_hi = _mm_unpackhi_epi8(c2, alpha);
+            __m128i p0 = _mm_unpacklo_epi16(c01_lo, c2a_lo);
+            __m128i p1 = _mm_unpackhi_epi16(c01_lo, c2a_lo);
+            __m128i p2 = _mm_unpacklo_epi16(c01_hi, c2a_hi);
+            __m128i p3 = _mm_unpackhi_epi16(c01_hi, c2a_hi);
+            uint8_t *d = dst + i * bpp;
+            if (bpp == 4)
+            {
+                _mm_storeu_si128((__m128i *)d, p0);
+                _mm_storeu_si128((__m128i *)(d + 16), p1);
+                _mm_storeu_si128((__m128i *)(d + 32), p2);
+                _mm_storeu_si128((__m128i *)(d + 48), p3);
+            }
+            else
+            {
+                _mm_storeu_si128((__m128i *)d, _mm_shuffle_epi8(p0, drop_alpha));
+                _mm_storeu_si128((__m128i *)(d + 12), _mm_shuffle_epi8(p1, drop_alpha));
+                _mm_storeu_si128((__m128i *)(d + 24), _mm_shuffle_epi8(p2, drop_alpha));
+                _mm_storeu_si128((__m128i *)(d + 36), _mm_shuffle_epi8(p3, drop_alpha));
+            }
+        }
+        yuyv_to_packed_scalar<bpp, bgr>(src + i * 2, dst + i * bpp, n - i);
+    }
+
+    __attribute__((target("ssse3"))) static void yuyv_to_nv21_ssse3(const uint8_t *src, uint8_t *dst, int width, int height)
+    {
+        const __m128i mask_lo = _mm_set1_epi16(0x00ff);
+        uint8_t *vu = dst + width * height;
+        for (int y = 0; y + 1 < height; y += 2)
+        {
+            const uint8_t *src0 = src + y * width * 2;
+            const uint8_t *src1 = src0 + width * 2;
+            uint8_t *y0 = dst + y * width;
+            uint8_t *y1 = y0 + width;
+            uint8_t *vu_line = vu + y / 2 * width;
+            int x = 0;
+            for (; x + 16 <= width; x += 16)
+            {
+                __m128i a0 = _mm_loadu_si128((const __m128i *)(src0 + x * 2));
+                __m128i a1 = _mm_loadu_si128((const __m128i *)(src0 + x * 2 + 16));
+                __m128i b0 = _mm_loadu_si128((const __m128i *)(src1 + x * 2));
+                __m128i b1 = _mm_loadu_si128((const __m128i *)(src1 + x * 2 + 16));
+                _mm_storeu_si128((__m128i *)(y0 + x), _mm_packus_epi16(_mm_and_si128(a0, mask_lo), _mm_and_si128(a1, mask_lo)));
+                _mm_storeu_si128((__m128i *)(y1 + x), _mm_packus_epi16(_mm_and_si128(b0, mask_lo), _mm_and_si128(b1, mask_lo)));
+                __m128i uv0 = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8));
+                __m128i uv1 = _mm_packus_epi16(_mm_srli_epi16(b0, 8), _mm_srli_epi16(b1, 8));
+                __m128i uv = _mm_avg_epu8(uv0, uv1);
+                const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+                _mm_storeu_si128((__m128i *)(vu_line + x), _mm_shuffle_epi8(uv, swap));
+            }
+            yuyv_to_nv21_rows_scalar(src0, src1, y0, y1, vu_line, x, width);
+        }
+    }
+
+    __attribute__((target("ssse3"))) static void yuyv_to_gray_ssse3(const uint8_t *src, uint8_t *dst, int width, int height)
+    {
+        const __m128i mask_lo = _mm_set1_epi16(0x00ff);
+        int n = width * height;
+        int i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            __m128i a0 = _mm_loadu_si128((const __m128i *)(src + i * 2));
+            __m128i a1 = _mm_loadu_si128((const __m128i *)(src + i * 2 + 16));
+            _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(_mm_and_si128(a0, mask_lo), _mm_and_si128(a1, mask_lo)));
+        }
+        for (; i < n; ++i)
+            dst[i] = src[i * 2];
+    }
+#endif // MAIX_YUYV_X86
+
+#ifdef MAIX_YUYV_NEON
+    static inline void yuyv_rgb_x8_neon(uint8x8_t y8, uint8x8_t u8, uint8x8_t v8, uint8x8_t &r, uint8x8_t &g, uint8x8_t &b)
+    {
+        int16x8_t y = vreinterpretq_s16_u16(vmovl_u8(y8));
+        int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u8)), vdupq_n_s16(128));
+        int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v8)), vdupq_n_s16(128));
+        y = vmulq_n_s16(vsubq_s16(y, vdupq_n_s16(16)), YUYV_YC);
+        y = vaddq_s16(y, vdupq_n_s16(1 << (YUYV_Q - 1)));
+        int16x8_t rr = vqaddq_s16(y, vmulq_n_s16(v, YUYV_RV));
+        int16x8_t gg = vsubq_s16(y, vaddq_s16(vmulq_n_s16(v, YUYV_GV), vmulq_n_s16(u, YUYV_GU)));
+        int16x8_t bb = vqaddq_s16(y, vmulq_n_s16(u, YUYV_BU));
+        r = vqmovun_s16(vshrq_n_s16(rr, YUYV_Q));
+        g = vqmovun_s16(vshrq_n_s16(gg, YUYV_Q));
+        b = vqmovun_s16(vshrq_n_s16(bb, YUYV_Q));
+    }
+
+    template <int bpp, bool bgr>
+    static void yuyv_to_packed_neon(const uint8_t *src, uint8_t *dst, int width, int height)
+    {
+        int n = width * height;
+        int i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            // val[0]: Y even, val[1]: U, val[2]: Y odd, val[3]: V
+            uint8x8x4_t yuyv = vld4_u8(src + i * 2);
+            uint8x8_t r0, g0, b0, r1, g1, b1;
+            yuyv_rgb_x8_neon(yuyv.val[0], yuyv.val[1], yuyv.val[3], r0, g0, b0);
+            yuyv_rgb_x8_neon(yuyv.val[2], yuyv.val[1], yuyv.val[3], r1, g1, b1);
+            uint8x8x2_t r = vzip_u8(r0, r1);
+            uint8x8x2_t g = vzip_u8(g0, g1);
+            uint8x8x2_t b = vzip_u8(b0, b1);
+            uint8x16_t c0 = bgr ? vcombine_u8(b.val[0], b.val[1]) : vcombine_u8(r.val[0], r.val[1]);
+            uint8x16_t c1 = vcombine_u8(g.val[0], g.val[1]);
+            uint8x16_t c2 = bgr ? vcombine_u8(r.val[0], r.val[1]) : vcombine_u8(b.val[0], b.val[1]);
+            if (bpp == 4)
+            {
+                uint8x16x4_t out = {{c0, c1, c2, vdupq_n_u8(255)}};
+                vst4q_u8(dst + i * 4, out);
+            }
+            else
+            {
+                uint8x16x3_t out = {{c0, c1, c2}};
+                vst3q_u8(dst + i * 3, out);
+            }
+        }
+        yuyv_to_packed_scalar<bpp, bgr>(src + i * 2, dst + i * bpp, n - i);
+    }
+
+    static void yuyv_to_nv21_neon(const uint8_t *src, uint8_t *dst, int width, int height)
+    {
+        uint8_t *vu = dst + width * height;
+        for (int y = 0; y + 1 < height; y += 2)
+        {
+            const uint8_t *src0 = src + y * width * 2;
+            const uint8_t *src1 = src0 + width * 2;
+            uint8_t *y0 = dst + y * width;
+            uint8_t *y1 = y0 + width;
+            uint8_t *vu_line = vu + y / 2 * width;
+            int x = 0;
+            for (; x + 16 <= width; x += 16)
+            {
+                // val[0]: Y, val[1]: U or V
+                uint8x16x2_t a = vld2q_u8(src0 + x * 2);
+                uint8x16x2_t b = vld2q_u8(src1 + x * 2);
+                vst1q_u8(y0 + x, a.val[0]);
+                vst1q_u8(y1 + x, b.val[0]);
+                vst1q_u8(vu_line + x, vrev16q_u8(vrhaddq_u8(a.val[1], b.val[1])));
+            }
+            yuyv_to_nv21_rows_scalar(src0, src1, y0, y1, vu_line, x, width);
+        }
+    }
+
+    static void yuyv_to_gray_neon(const uint8_t *src, uint8_t *dst, int width, int height)
+    {
+        int n = width * height;
+        int i = 0;
+        for (; i + 16 <= n; i += 16)
+            vst1q_u8(dst + i, vld2q_u8(src + i * 2).val[0]);
+        for (; i < n; ++i)
+            dst[i] = src[i * 2];
+    }
+#endif // MAIX_YUYV_NEON
+
+    /**
+     * Get YUYV convert kernel for target format, choose the fastest one the running CPU supports.
+     * @param format target format, support RGB888, BGR888, RGBA8888, BGRA8888, YVU420SP(NV21), GRAYSCALE
+     * @param force_c true to always use the scalar kernel(for comparing or debugging)
+     * @return kernel function, NULL if format not support
+     */
+    static yuyv_convert_func_t yuyv_convert_func(int format, bool force_c = false)
+    {
+        bool use_simd = false;
+#if defined(MAIX_YUYV_X86)
+        static bool has_ssse3 = __builtin_cpu_supports("ssse3");
+        use_simd = has_ssse3 && !force_c;
+#elif defined(MAIX_YUYV_NEON)
+        use_simd = !force_c;
+#endif
+        (void)use_simd;
+        switch (format)
+        {
+        case image::FMT_RGB888:
+#if defined(MAIX_YUYV_X86)
+            if (use_simd) return yuyv_to_packed_ssse3<3, false>;
+#elif defined(MAIX_YUYV_NEON)
+            if (use_simd) return yuyv_to_packed_neon<3, false>;
+#endif
+            return yuyv_to_packed_c<3, false>;
+        case image::FMT_BGR888:
+#if defined(MAIX_YUYV_X86)
+            if (use_simd) return yuyv_to_packed_ssse3<3, true>;
+#elif defined(MAIX_YUYV_NEON)
+            if (use_simd) return yuyv_to_packed_neon<3, true>;
+#endif
+            return yuyv_to_packed_c<3, true>;
+        case image::FMT_RGBA8888:
+#if defined(MAIX_YUYV_X86)
+            if (use_simd) return yuyv_to_packed_ssse3<4, false>;
+#elif defined(MAIX_YUYV_NEON)
+            if (use_simd) return yuyv_to_packed_neon<4, false>;
+#endif
+            return yuyv_to_packed_c<4, false>;
+        case image::FMT_BGRA8888:
+#if defined(MAIX_YUYV_X86)
+            if (use_simd) return yuyv_to_packed_ssse3<4, true>;
+#elif defined(MAIX_YUYV_NEON)
+            if (use_simd) return yuyv_to_packed_neon<4, true>;
+#endif
+            return yuyv_to_packed_c<4, true>;
+        case image::FMT_YVU420SP:
+#if defined(MAIX_YUYV_X86)
+            if (use_simd) return yuyv_to_nv21_ssse3;
+#elif defined(MAIX_YUYV_NEON)
+            if (use_simd) return yuyv_to_nv21_neon;
+#endif
+            return yuyv_to_nv21_c;
+        case image::FMT_GRAYSCALE:
+#if defined(MAIX_YUYV_X86)
+            if (use_simd) return yuyv_to_gray_ssse3;
+#elif defined(MAIX_YUYV_NEON)
+            if (use_simd) return yuyv_to_gray_neon;
+#endif
+            return yuyv_to_gray_c;
+        default:
+            return NULL;
+        }
+    }
+
+} // namespace maix::camera
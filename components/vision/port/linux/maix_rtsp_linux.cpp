@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Implement RTSP server with RTP over TCP and UDP, software encoding and regions.
  */
 
 
@@ -10,78 +11,1050 @@
 #include "maix_err.hpp"
 #include <dirent.h>
 #include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <ifaddrs.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <linux/sockios.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
 
 namespace maix::rtsp
 {
+#define RTSP_RTP_PAYLOAD_MAX    1400            // RTP payload size limit, keep packet in one ethernet frame
+#define RTSP_RTP_CLOCK          90000
+#define RTSP_SEND_BUFFER        (1024 * 1024)   // socket send buffer of one client, frame is dropped if not enough
+#define RTSP_SEND_BATCH         64              // max packets in one sendmsg/sendmmsg call
+#define RTSP_REQUEST_MAX        8192
+
+    typedef struct
+    {
+        const uint8_t *data;
+        int size;
+    } nalu_t;
+
+    /**
+     * One RTP packet of the frame, payload point to frame data, header of FU is in hdr.
+     */
+    typedef struct
+    {
+        uint8_t hdr[3];
+        uint8_t hdr_len;
+        bool marker;
+        const uint8_t *payload;
+        int payload_len;
+    } rtp_pkt_t;
+
+    typedef struct
+    {
+        int fd;                         // RTSP connection, also RTP over TCP
+        std::string session;
+        bool tcp;
+        int rtp_channel;
+        int udp_fd;
+        struct sockaddr_in udp_addr;
+        int udp_server_port;
+        bool playing;
+        bool need_idr;
+        uint16_t seq;
+        uint32_t ssrc;
+        std::string in;
+        std::vector<uint8_t> pending;   // unsent tail of a partially written packet or response
+        uint64_t frames;
+        uint64_t dropped;
+    } rtsp_client_t;
+
+    typedef struct
+    {
+        std::mutex lock;
+        std::recursive_mutex region_lock;
+        std::vector<rtsp_client_t *> clients;
+        int listen_fd;
+        int wake_fd[2];
+        std::atomic<bool> running;
+        std::thread *server;
+        std::string bind_ip;
+        bool h265;
+        std::vector<uint8_t> vps, sps, pps;
+        video::Encoder *encoder;
+        std::vector<rtp_pkt_t> pkts;
+        std::vector<rtp_pkt_t> ps_pkts;
+        std::vector<uint8_t> hdrs;     // per packet header scratch of sending client
+        std::vector<struct iovec> iov;
+        image::Image *overlay;
+    } rtsp_param_t;
+
+    static const char *_base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    static std::string _base64(const std::vector<uint8_t> &in)
+    {
+        std::string out;
+        size_t i = 0;
+        for (; i + 2 < in.size(); i += 3)
+        {
+            uint32_t v = in[i] << 16 | in[i + 1] << 8 | in[i + 2];
+            out += _base64_chars[v >> 18 & 0x3F];
+            out += _base64_chars[v >> 12 & 0x3F];
+            out += _base64_chars[v >> 6 & 0x3F];
+            out += _base64_chars[v & 0x3F];
+        }
+        if (i < in.size())
+        {
+            uint32_t v = in[i] << 16 | (i + 1 < in.size() ? in[i + 1] << 8 : 0);
+            out += _base64_chars[v >> 18 & 0x3F];
+            out += _base64_chars[v >> 12 & 0x3F];
+            out += i + 1 < in.size() ? _base64_chars[v >> 6 & 0x3F] : '=';
+            out += '=';
+        }
+        return out;
+    }
+
+    /**
+     * Split Annex-B stream to NAL units without start code
+     */
+    static void _split_nalus(const uint8_t *data, int size, std::vector<nalu_t> &out)
+    {
+        out.clear();
+        int start = -1;
+        int i = 0;
+        while (i + 2 < size)
+        {
+            if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+            {
+                if (start >= 0)
+                {
+                    int end = i;
+                    while (end > start && data[end - 1] == 0)
+                        --end;
+                    if (end > start)
+                        out.push_back({data + start, end - start});
+                }
+                i += 3;
+                start = i;
+                continue;
+            }
+            ++i;
+        }
+        if (start < 0) // no start code, take as one NAL unit
+            start = 0;
+        if (start < size)
+            out.push_back({data + start, size - start});
+    }
+
+    static int _nalu_type(const nalu_t &n, bool h265)
+    {
+        return h265 ? (n.data[0] >> 1) & 0x3F : n.data[0] & 0x1F;
+    }
+
+    static bool _is_idr(int type, bool h265)
+    {
+        return h265 ? (type >= 16 && type <= 21) : type == 5;
+    }
+
+    /**
+     * Single NAL unit packet or fragmentation units(FU-A of RFC 6184, FU of RFC 7798),
+     * payload point to frame data, no copy.
+     */
+    static void _packetize(const nalu_t &n, bool h265, bool last_nalu, std::vector<rtp_pkt_t> &pkts)
+    {
+        if (n.size <= RTSP_RTP_PAYLOAD_MAX)
+        {
+            pkts.push_back({{0}, 0, last_nalu, n.data, n.size});
+            return;
+        }
+        int nal_hdr_len = h265 ? 2 : 1;
+        const uint8_t *p = n.data + nal_hdr_len;
+        int left = n.size - nal_hdr_len;
+        int max = RTSP_RTP_PAYLOAD_MAX - nal_hdr_len - 1;
+        bool first = true;
+        while (left > 0)
+        {
+            rtp_pkt_t pkt;
+            int len = left > max ? max : left;
+            bool end = len == left;
+            if (h265)
+            {
+                pkt.hdr[0] = (n.data[0] & 0x81) | (49 << 1);
+                pkt.hdr[1] = n.data[1];
+                pkt.hdr[2] = (first ? 0x80 : 0) | (end ? 0x40 : 0) | ((n.data[0] >> 1) & 0x3F);
+                pkt.hdr_len = 3;
+            }
+            else
+            {
+                pkt.hdr[0] = (n.data[0] & 0xE0) | 28;
+                pkt.hdr[1] = (first ? 0x80 : 0) | (end ? 0x40 : 0) | (n.data[0] & 0x1F);
+                pkt.hdr_len = 2;
+            }
+            pkt.marker = end && last_nalu;
+            pkt.payload = p;
+            pkt.payload_len = len;
+            pkts.push_back(pkt);
+            p += len;
+            left -= len;
+            first = false;
+        }
+    }
+
+    static void _set_nonblock(int fd)
+    {
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+
+    /**
+     * Flush pending data of client, return true if all pending data sent.
+     */
+    static bool _client_flush(rtsp_client_t *c)
+    {
+        while (!c->pending.empty())
+        {
+            ssize_t n = ::send(c->fd, c->pending.data(), c->pending.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n <= 0)
+                return false;
+            c->pending.erase(c->pending.begin(), c->pending.begin() + n);
+        }
+        return true;
+    }
+
+    /**
+     * Send iovecs on RTSP connection, keep unsent data of the first not fully sent iovec group in pending.
+     * @param groups iovec number of each packet(or response), data after the partially sent packet is not sent
+     * @return number of fully sent groups
+     */
+    static int _client_sendv(rtsp_client_t *c, struct iovec *iov, int iov_num, int group)
+    {
+        if (!_client_flush(c))
+            return 0;
+        int sent_groups = 0;
+        int i = 0;
+        while (i < iov_num)
+        {
+            int num = iov_num - i > RTSP_SEND_BATCH * group ? RTSP_SEND_BATCH * group : iov_num - i;
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov + i;
+            msg.msg_iovlen = num;
+            ssize_t n = sendmsg(c->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n < 0)
+                n = 0;
+            // skip fully sent iovecs
+            int k = i;
+            size_t left = n;
+            while (k < i + num && left >= iov[k].iov_len)
+            {
+                left -= iov[k].iov_len;
+                ++k;
+            }
+            if (k == i + num)
+            {
+                sent_groups += num / group;
+                i += num;
+                continue;
+            }
+            // partially sent, keep rest of this group in pending, drop later groups
+            int group_end = i + ((k - i) / group + 1) * group;
+            sent_groups += (k - i) / group;
+            if (left > 0 || k % group != 0)
+            {
+                for (int j = k; j < group_end; ++j)
+                {
+                    const uint8_t *p = (const uint8_t *)iov[j].iov_base + (j == k ? left : 0);
+                    size_t len = iov[j].iov_len - (j == k ? left : 0);
+                    c->pending.insert(c->pending.end(), p, p + len);
+                }
+                ++sent_groups;
+            }
+            return sent_groups;
+        }
+        return sent_groups;
+    }
+
+    static void _client_send_str(rtsp_client_t *c, const std::string &s)
+    {
+        struct iovec iov = {(void *)s.data(), s.size()};
+        if (_client_sendv(c, &iov, 1, 1) != 1)
+            c->pending.insert(c->pending.end(), s.begin(), s.end());
+    }
+
+    static void _client_close(rtsp_client_t *c)
+    {
+        if (c->fd >= 0)
+            close(c->fd);
+        if (c->udp_fd >= 0)
+            close(c->udp_fd);
+        delete c;
+    }
+
+    /**
+     * Send packets of one frame to client
+     * @return false if frame dropped
+     */
+    static bool _client_send_frame(rtsp_param_t *param, rtsp_client_t *c, const rtp_pkt_t *pkts, int num, uint32_t ts, size_t frame_size)
+    {
+        if (!c->tcp && c->udp_fd < 0)
+            return false;
+        if (c->tcp)
+        {
+            if (!_client_flush(c))
+                return false;
+            int queued = 0, sndbuf = 0;
+            socklen_t optlen = sizeof(sndbuf);
+            // kernel may give larger buffer than asked, limit queued data to keep latency low
+            if (getsockopt(c->fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, &optlen) != 0 || sndbuf > RTSP_SEND_BUFFER)
+                sndbuf = RTSP_SEND_BUFFER;
+            if (ioctl(c->fd, SIOCOUTQ, &queued) == 0 && (size_t)queued + frame_size + num * 20 > (size_t)sndbuf)
+                return false;
+        }
+        // headers: [interleaved 4B] RTP 12B, FU header is in packet
+        const int hdr_size = 16;
+        param->hdrs.resize(num * hdr_size);
+        param->iov.resize(num * 3);
+        uint8_t *h = param->hdrs.data();
+        struct iovec *iov = param->iov.data();
+        for (int i = 0; i < num; ++i)
+        {
+            const rtp_pkt_t &p = pkts[i];
+            uint8_t *rtp = h + i * hdr_size + 4;
+            int rtp_len = 12 + p.hdr_len + p.payload_len;
+            rtp[0] = 0x80;
+            rtp[1] = (p.marker ? 0x80 : 0) | 96;
+            rtp[2] = c->seq >> 8;
+            rtp[3] = c->seq & 0xFF;
+            rtp[4] = ts >> 24;
+            rtp[5] = ts >> 16;
+            rtp[6] = ts >> 8;
+            rtp[7] = ts;
+            rtp[8] = c->ssrc >> 24;
+            rtp[9] = c->ssrc >> 16;
+            rtp[10] = c->ssrc >> 8;
+            rtp[11] = c->ssrc;
+            ++c->seq;
+            if (c->tcp)
+            {
+                rtp[-4] = '$';
+                rtp[-3] = c->rtp_channel;
+                rtp[-2] = rtp_len >> 8;
+                rtp[-1] = rtp_len & 0xFF;
+                iov[i * 3].iov_base = rtp - 4;
+                iov[i * 3].iov_len = 4 + 12;
+            }
+            else
+            {
+                iov[i * 3].iov_base = rtp;
+                iov[i * 3].iov_len = 12;
+            }
+            iov[i * 3 + 1].iov_base = (void *)p.hdr;
+            iov[i * 3 + 1].iov_len = p.hdr_len;
+            iov[i * 3 + 2].iov_base = (void *)p.payload;
+            iov[i * 3 + 2].iov_len = p.payload_len;
+        }
+        if (c->tcp)
+            return _client_sendv(c, iov, num * 3, 3) == num;
+
+        struct mmsghdr msgs[RTSP_SEND_BATCH];
+        for (int i = 0; i < num;)
+        {
+            int batch = num - i > RTSP_SEND_BATCH ? RTSP_SEND_BATCH : num - i;
+            memset(msgs, 0, sizeof(msgs[0]) * batch);
+            for (int k = 0; k < batch; ++k)
+            {
+                msgs[k].msg_hdr.msg_name = &c->udp_addr;
+                msgs[k].msg_hdr.msg_namelen = sizeof(c->udp_addr);
+                msgs[k].msg_hdr.msg_iov = iov + (i + k) * 3;
+                msgs[k].msg_hdr.msg_iovlen = 3;
+            }
+            int n = sendmmsg(c->udp_fd, msgs, batch, MSG_DONTWAIT);
+            if (n <= 0)
+                return false;
+            i += n;
+        }
+        return true;
+    }
+
+    /**
+     * Send one encoded frame to all playing clients
+     */
+    static void _send_frame(rtsp_param_t *param, const uint8_t *data, int size, uint32_t ts)
+    {
+        std::vector<nalu_t> nalus;
+        _split_nalus(data, size, nalus);
+        if (nalus.empty())
+            return;
+        bool h265 = param->h265;
+        bool idr = false, has_ps = false;
+
+        std::lock_guard<std::mutex> lk(param->lock);
+        for (auto &n : nalus)
+        {
+            int type = _nalu_type(n, h265);
+            idr |= _is_idr(type, h265);
+            std::vector<uint8_t> *ps = NULL;
+            if (h265)
+                ps = type == 32 ? &param->vps : type == 33 ? &param->sps : type == 34 ? &param->pps : NULL;
+            else
+                ps = type == 7 ? &param->sps : type == 8 ? &param->pps : NULL;
+            if (ps)
+            {
+                ps->assign(n.data, n.data + n.size);
+                has_ps = true;
+            }
+        }
+        param->pkts.clear();
+        for (size_t i = 0; i < nalus.size(); ++i)
+            _packetize(nalus[i], h265, i == nalus.size() - 1, param->pkts);
+
+        // clients start from IDR frame, send cached parameter sets before it if frame not carry them
+        param->ps_pkts.clear();
+        if (idr && !has_ps)
+        {
+            std::vector<uint8_t> *sets[3] = {&param->vps, &param->sps, &param->pps};
+            for (auto s : sets)
+            {
+                if (!s->empty())
+                    _packetize({s->data(), (int)s->size()}, h265, false, param->ps_pkts);
+            }
+        }
+
+        for (auto c : param->clients)
+        {
+            if (!c->playing)
+                continue;
+            if (c->need_idr && !idr)
+            {
+                ++c->dropped;
+                continue;
+            }
+            bool ok = true;
+            if (c->need_idr && !param->ps_pkts.empty())
+                ok = _client_send_frame(param, c, param->ps_pkts.data(), param->ps_pkts.size(), ts, 0);
+            if (ok)
+                ok = _client_send_frame(param, c, param->pkts.data(), param->pkts.size(), ts, size);
+            if (ok)
+            {
+                c->need_idr = false;
+                ++c->frames;
+            }
+            else
+            {
+                // congestion, skip frames until next IDR so decoder never see broken references
+                if (!c->need_idr)
+                    log::debug("rtsp client %d congested, wait next IDR\n", c->fd);
+                c->need_idr = true;
+                ++c->dropped;
+            }
+        }
+    }
+
+    static std::string _get_header(const std::string &req, const char *name)
+    {
+        size_t pos = 0;
+        size_t name_len = strlen(name);
+        while ((pos = req.find("\r\n", pos)) != std::string::npos)
+        {
+            pos += 2;
+            if (strncasecmp(req.c_str() + pos, name, name_len) == 0 && req[pos + name_len] == ':')
+            {
+                size_t start = req.find_first_not_of(' ', pos + name_len + 1);
+                size_t end = req.find("\r\n", pos);
+                if (start == std::string::npos || start > end)
+                    return "";
+                return req.substr(start, end - start);
+            }
+        }
+        return "";
+    }
+
+    static std::string _local_ip(int fd)
+    {
+        struct sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        char ip[INET_ADDRSTRLEN] = "0.0.0.0";
+        if (getsockname(fd, (struct sockaddr *)&addr, &len) == 0)
+            inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+        return ip;
+    }
+
+    static std::string _sdp(rtsp_param_t *param, const std::string &ip)
+    {
+        std::string sdp = "v=0\r\n"
+                          "o=- 0 0 IN IP4 " + ip + "\r\n"
+                          "s=MaixCDK\r\n"
+                          "c=IN IP4 0.0.0.0\r\n"
+                          "t=0 0\r\n"
+                          "a=range:npt=now-\r\n"
+                          "a=control:*\r\n"
+                          "m=video 0 RTP/AVP 96\r\n";
+        std::lock_guard<std::mutex> lk(param->lock);
+        if (param->h265)
+        {
+            sdp += "a=rtpmap:96 H265/90000\r\n";
+            if (!param->vps.empty() && !param->sps.empty() && !param->pps.empty())
+                sdp += "a=fmtp:96 sprop-vps=" + _base64(param->vps) + ";sprop-sps=" + _base64(param->sps) + ";sprop-pps=" + _base64(param->pps) + "\r\n";
+        }
+        else
+        {
+            sdp += "a=rtpmap:96 H264/90000\r\n";
+            sdp += "a=fmtp:96 packetization-mode=1";
+            if (param->sps.size() >= 4 && !param->pps.empty())
+            {
+                char profile[16];
+                snprintf(profile, sizeof(profile), "%02X%02X%02X", param->sps[1], param->sps[2], param->sps[3]);
+                sdp += std::string(";profile-level-id=") + profile + ";sprop-parameter-sets=" + _base64(param->sps) + "," + _base64(param->pps);
+            }
+            sdp += "\r\n";
+        }
+        sdp += "a=control:track0\r\n";
+        return sdp;
+    }
+
+    /**
+     * Handle one RTSP request, called in server thread
+     */
+    static void _handle_request(rtsp_param_t *param, rtsp_client_t *c, const std::string &req)
+    {
+        char method[32] = {0}, url[512] = {0};
+        if (sscanf(req.c_str(), "%31s %511s", method, url) != 2)
+            return;
+        std::string cseq = _get_header(req, "CSeq");
+        std::string head = "RTSP/1.0 200 OK\r\nCSeq: " + cseq + "\r\nServer: MaixCDK\r\n";
+        std::string resp;
+        std::string m = method;
+        if (m == "OPTIONS")
+        {
+            resp = head + "Public: OPTIONS, DESCRIBE, SETUP, PLAY, PAUSE, TEARDOWN, GET_PARAMETER, SET_PARAMETER\r\n\r\n";
+        }
+        else if (m == "DESCRIBE")
+        {
+            std::string sdp = _sdp(param, _local_ip(c->fd));
+            std::string base = url;
+            if (base.empty() || base.back() != '/')
+                base += "/";
+            resp = head + "Content-Base: " + base + "\r\nContent-Type: application/sdp\r\nContent-Length: " + std::to_string(sdp.size()) + "\r\n\r\n" + sdp;
+        }
+        else if (m == "SETUP")
+        {
+            std::string transport = _get_header(req, "Transport");
+            std::string reply_transport;
+            std::lock_guard<std::mutex> lk(param->lock);
+            if (transport.find("RTP/AVP/TCP") != std::string::npos)
+            {
+                int ch0 = 0, ch1 = 1;
+                size_t pos = transport.find("interleaved=");
+                if (pos != std::string::npos)
+                    sscanf(transport.c_str() + pos, "interleaved=%d-%d", &ch0, &ch1);
+                c->tcp = true;
+                c->rtp_channel = ch0;
+                reply_transport = "RTP/AVP/TCP;unicast;interleaved=" + std::to_string(ch0) + "-" + std::to_string(ch1);
+            }
+            else
+            {
+                int p0 = 0, p1 = 0;
+                size_t pos = transport.find("client_port=");
+                if (pos == std::string::npos || sscanf(transport.c_str() + pos, "client_port=%d-%d", &p0, &p1) < 1)
+                {
+                    resp = "RTSP/1.0 461 Unsupported Transport\r\nCSeq: " + cseq + "\r\n\r\n";
+                    _client_send_str(c, resp);
+                    return;
+                }
+                if (p1 == 0)
+                    p1 = p0 + 1;
+                struct sockaddr_in peer;
+                socklen_t len = sizeof(peer);
+                getpeername(c->fd, (struct sockaddr *)&peer, &len);
+                if (c->udp_fd < 0)
+                {
+                    c->udp_fd = socket(AF_INET, SOCK_DGRAM, 0);
+                    struct sockaddr_in local;
+                    memset(&local, 0, sizeof(local));
+                    local.sin_family = AF_INET;
+                    bind(c->udp_fd, (struct sockaddr *)&local, sizeof(local));
+                    len = sizeof(local);
+                    getsockname(c->udp_fd, (struct sockaddr *)&local, &len);
+                    c->udp_server_port = ntohs(local.sin_port);
+                    int sndbuf = RTSP_SEND_BUFFER;
+                    setsockopt(c->udp_fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+                }
+                c->tcp = false;
+                c->udp_addr = peer;
+                c->udp_addr.sin_port = htons(p0);
+                reply_transport = "RTP/AVP;unicast;client_port=" + std::to_string(p0) + "-" + std::to_string(p1) +
+                                  ";server_port=" + std::to_string(c->udp_server_port) + "-" + std::to_string(c->udp_server_port + 1);
+            }
+            resp = head + "Transport: " + reply_transport + "\r\nSession: " + c->session + ";timeout=60\r\n\r\n";
+        }
+        else if (m == "PLAY")
+        {
+            std::lock_guard<std::mutex> lk(param->lock);
+            c->playing = true;
+            c->need_idr = true;
+            resp = head + "Session: " + c->session + "\r\nRange: npt=0.000-\r\n\r\n";
+        }
+        else if (m == "PAUSE")
+        {
+            std::lock_guard<std::mutex> lk(param->lock);
+            c->playing = false;
+            resp = head + "Session: " + c->session + "\r\n\r\n";
+        }
+        else if (m == "TEARDOWN")
+        {
+            std::lock_guard<std::mutex> lk(param->lock);
+            c->playing = false;
+            resp = head + "Session: " + c->session + "\r\n\r\n";
+        }
+        else if (m == "GET_PARAMETER" || m == "SET_PARAMETER")
+        {
+            resp = head + "Session: " + c->session + "\r\n\r\n";
+        }
+        else
+        {
+            resp = "RTSP/1.0 501 Not Implemented\r\nCSeq: " + cseq + "\r\n\r\n";
+        }
+        std::lock_guard<std::mutex> lk(param->lock);
+        _client_send_str(c, resp);
+    }
+
+    /**
+     * Parse requests in client input buffer, skip interleaved RTCP packets from client.
+     * @return false if client should be closed
+     */
+    static bool _handle_input(rtsp_param_t *param, rtsp_client_t *c)
+    {
+        while (!c->in.empty())
+        {
+            if (c->in[0] == '$')
+            {
+                if (c->in.size() < 4)
+                    break;
+                size_t len = 4 + ((uint8_t)c->in[2] << 8 | (uint8_t)c->in[3]);
+                if (c->in.size() < len)
+                    break;
+                c->in.erase(0, len);
+                continue;
+            }
+            size_t end = c->in.find("\r\n\r\n");
+            if (end == std::string::npos)
+                return c->in.size() < RTSP_REQUEST_MAX;
+            std::string content_len = _get_header(c->in.substr(0, end + 2), "Content-Length");
+            size_t total = end + 4 + (content_len.empty() ? 0 : atoi(content_len.c_str()));
+            if (c->in.size() < total)
+                break;
+            _handle_request(param, c, c->in.substr(0, total));
+            c->in.erase(0, total);
+        }
+        return true;
+    }
+
+    static void _server_loop(rtsp_param_t *param)
+    {
+        std::vector<struct pollfd> fds;
+        std::vector<rtsp_client_t *> polled;
+        while (param->running)
+        {
+            fds.clear();
+            polled.clear();
+            fds.push_back({param->listen_fd, POLLIN, 0});
+            fds.push_back({param->wake_fd[0], POLLIN, 0});
+            {
+                std::lock_guard<std::mutex> lk(param->lock);
+                for (auto c : param->clients)
+                {
+                    fds.push_back({c->fd, (short)(POLLIN | (c->pending.empty() ? 0 : POLLOUT)), 0});
+                    polled.push_back(c);
+                }
+            }
+            // wake up every 100ms to flush pending data
+            int ret = poll(fds.data(), fds.size(), 100);
+            if (ret < 0 && errno != EINTR)
+                break;
+            if (fds[1].revents & POLLIN)
+            {
+                char buf[16];
+                while (read(param->wake_fd[0], buf, sizeof(buf)) > 0)
+                    ;
+            }
+            if (fds[0].revents & POLLIN)
+            {
+                int fd = accept(param->listen_fd, NULL, NULL);
+                if (fd >= 0)
+                {
+                    _set_nonblock(fd);
+                    int one = 1, sndbuf = RTSP_SEND_BUFFER;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+                    rtsp_client_t *c = new rtsp_client_t();
+                    c->fd = fd;
+                    c->udp_fd = -1;
+                    c->tcp = true;
+                    c->rtp_channel = 0;
+                    c->playing = false;
+                    c->need_idr = true;
+                    c->seq = (uint16_t)rand();
+                    c->ssrc = ((uint32_t)rand() << 16) ^ (uint32_t)rand() ^ (uint32_t)fd;
+                    char session[16];
+                    snprintf(session, sizeof(session), "%08X", c->ssrc);
+                    c->session = session;
+                    c->frames = 0;
+                    c->dropped = 0;
+                    std::lock_guard<std::mutex> lk(param->lock);
+                    param->clients.push_back(c);
+                    log::info("rtsp client %d connected, %d clients\n", fd, (int)param->clients.size());
+                }
+            }
+            for (size_t i = 0; i < polled.size(); ++i)
+            {
+                rtsp_client_t *c = polled[i];
+                short ev = fds[i + 2].revents;
+                bool closed = ev & (POLLERR | POLLHUP | POLLNVAL);
+                if (!closed && (ev & POLLIN))
+                {
+                    char buf[2048];
+                    ssize_t n = recv(c->fd, buf, sizeof(buf), 0);
+                    if (n <= 0 && !(n < 0 && (errno == EAGAIN || errno == EINTR)))
+                        closed = true;
+                    else if (n > 0)
+                    {
+                        c->in.append(buf, n);
+                        closed = !_handle_input(param, c);
+                    }
+                }
+                std::lock_guard<std::mutex> lk(param->lock);
+                if (!closed && !c->pending.empty())
+                    _client_flush(c);
+                if (closed)
+                {
+                    for (auto it = param->clients.begin(); it != param->clients.end(); ++it)
+                    {
+                        if (*it == c)
+                        {
+                            param->clients.erase(it);
+                            break;
+                        }
+                    }
+                    log::info("rtsp client %d closed, sent %llu frames, dropped %llu frames, %d clients\n",
+                              c->fd, (unsigned long long)c->frames, (unsigned long long)c->dropped, (int)param->clients.size());
+                    _client_close(c);
+                }
+            }
+        }
+    }
+
+    /**
+     * Blend BGRA8888 regions to YVU420SP image, chroma use the top left pixel of each 2x2 block.
+     */
+    static void _blend_region_nv21(image::Image &img, image::Image &canvas, int x0, int y0)
+    {
+        int w = img.width(), h = img.height();
+        int cw = canvas.width(), ch = canvas.height();
+        uint8_t *y_plane = (uint8_t *)img.data();
+        uint8_t *vu_plane = y_plane + w * h;
+        const uint8_t *src = (const uint8_t *)canvas.data();
+        for (int j = 0; j < ch; ++j)
+        {
+            int y = y0 + j;
+            if (y < 0 || y >= h)
+                continue;
+            for (int i = 0; i < cw; ++i)
+            {
+                int x = x0 + i;
+                const uint8_t *p = src + (j * cw + i) * 4;
+                int a = p[3];
+                if (x < 0 || x >= w || a == 0)
+                    continue;
+                int b = p[0], g = p[1], r = p[2];
+                int yc = (77 * r + 150 * g + 29 * b) >> 8;
+                uint8_t *py = y_plane + y * w + x;
+                *py = (*py * (255 - a) + yc * a) / 255;
+                if (((x | y) & 1) == 0)
+                {
+                    int vc = ((128 * r - 107 * g - 21 * b) >> 8) + 128;
+                    int uc = ((-43 * r - 85 * g + 128 * b) >> 8) + 128;
+                    uint8_t *pvu = vu_plane + (y / 2) * w + x;
+                    pvu[0] = (pvu[0] * (255 - a) + vc * a) / 255;
+                    pvu[1] = (pvu[1] * (255 - a) + uc * a) / 255;
+                }
+            }
+        }
+    }
+
+    static void _wake(rtsp_param_t *param)
+    {
+        char c = 0;
+        if (::write(param->wake_fd[1], &c, 1) < 0)
+            log::debug("wake rtsp server failed\n");
+    }
+
     Region::Region(int x, int y, int width, int height, image::Format format, camera::Camera *camera)
     {
-        (void)x;
-        (void)y;
-        (void)width;
-        (void)height;
-        (void)format;
-        (void)camera;
+        if (format != image::Format::FMT_BGRA8888) {
+            err::check_raise(err::ERR_RUNTIME, "region support FMT_BGRA8888 only!");
+        }
+        this->_id = -1;
+        this->_x = x;
+        this->_y = y;
+        this->_width = width;
+        this->_height = height;
+        this->_format = format;
+        this->_camera = camera;
+        this->_flip = false;
+        this->_mirror = false;
+        // canvas owned by region, blended into frames directly
+        this->_image = new image::Image(width, height, format);
+        memset(this->_image->data(), 0, this->_image->data_size());
     }
 
     Region::~Region() {
-
+        delete this->_image;
     }
 
     image::Image *Region::get_canvas() {
-        return NULL;
+        memset(this->_image->data(), 0, this->_image->data_size());
+        return new image::Image(this->_width, this->_height, this->_format, (uint8_t *)this->_image->data(), this->_image->data_size(), false);
     }
 
     err::Err Region::update_canvas() {
-        return err::ERR_NOT_IMPL;
+        // the canvas is read when next frame is encoded
+        return err::ERR_NONE;
     }
 
     Rtsp::Rtsp(std::string ip, int port, int fps, rtsp::RtspStreamType stream_type) {
-        (void)ip;
-        (void)port;
-        (void)fps;
-        (void)stream_type;
+        err::check_bool_raise(stream_type == rtsp::RtspStreamType::RTSP_STREAM_H265 || stream_type == rtsp::RtspStreamType::RTSP_STREAM_H264,
+                            "support RTSP_STREAM_H265 and RTSP_STREAM_H264 only!");
+        this->_ip = ip;
+        this->_port = port;
+        this->_fps = fps;
+        this->_stream_type = stream_type;
+        this->_bind_camera = false;
+        this->_is_start = false;
+        this->_camera = NULL;
+        this->_thread = NULL;
+        this->_region_max_number = 16;
+        for (int i = 0; i < this->_region_max_number; i ++) {
+            this->_region_list.push_back(NULL);
+            this->_region_type_list.push_back(0);
+            this->_region_used_list.push_back(false);
+        }
+        this->_timestamp = 0;
+        this->_last_ms = time::ticks_ms();
+
+        rtsp_param_t *param = new rtsp_param_t();
+        param->listen_fd = -1;
+        param->wake_fd[0] = param->wake_fd[1] = -1;
+        param->running = false;
+        param->server = NULL;
+        param->bind_ip = ip.empty() ? "0.0.0.0" : ip;
+        param->h265 = stream_type == rtsp::RtspStreamType::RTSP_STREAM_H265;
+        param->encoder = NULL;
+        param->overlay = NULL;
+        this->_param = param;
     }
 
     Rtsp::~Rtsp() {
+        if (this->_is_start) {
+            this->stop();
+        }
+        rtsp_param_t *param = (rtsp_param_t *)this->_param;
+        for (auto &region : this->_region_list) {
+            delete region;
+        }
+        delete param->encoder;
+        delete param->overlay;
+        delete param;
+    }
+
+    static void _camera_push_thread(void *args) {
+        Rtsp *rtsp = (Rtsp *)args;
+        camera::Camera *camera = rtsp->to_camera();
+        while (rtsp->rtsp_is_start() && !app::need_exit()) {
+            image::Image *img = camera->read();
+            if (!img) {
+                time::sleep_ms(5);
+                continue;
+            }
+            rtsp->write(*img);
+            delete img;
+        }
     }
 
     err::Err Rtsp::start() {
-        err::Err err = err::ERR_NOT_IMPL;
-        return err;
+        rtsp_param_t *param = (rtsp_param_t *)this->_param;
+        if (this->_is_start)
+            return err::ERR_NONE;
+
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            log::error("create rtsp socket failed\n");
+            return err::ERR_RUNTIME;
+        }
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(this->_port);
+        if (inet_pton(AF_INET, param->bind_ip.c_str(), &addr.sin_addr) != 1 ||
+            bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 8) != 0) {
+            log::error("rtsp listen on %s:%d failed: %s\n", param->bind_ip.c_str(), this->_port, strerror(errno));
+            close(fd);
+            return err::ERR_IO;
+        }
+        _set_nonblock(fd);
+        if (pipe(param->wake_fd) != 0) {
+            close(fd);
+            return err::ERR_RUNTIME;
+        }
+        _set_nonblock(param->wake_fd[0]);
+        param->listen_fd = fd;
+        param->running = true;
+        param->server = new std::thread(_server_loop, param);
+
+        this->_is_start = true;
+        if (this->_bind_camera) {
+            this->_thread = new thread::Thread(_camera_push_thread, this);
+        }
+        return err::ERR_NONE;
     }
 
     err::Err Rtsp::stop() {
-        err::Err err = err::ERR_NOT_IMPL;
-        return err;
+        rtsp_param_t *param = (rtsp_param_t *)this->_param;
+        if (!this->_is_start)
+            return err::ERR_NONE;
+        this->_is_start = false;
+        if (this->_thread) {
+            this->_thread->join();
+            delete this->_thread;
+            this->_thread = NULL;
+        }
+        param->running = false;
+        _wake(param);
+        param->server->join();
+        delete param->server;
+        param->server = NULL;
+        for (auto c : param->clients)
+            _client_close(c);
+        param->clients.clear();
+        close(param->listen_fd);
+        close(param->wake_fd[0]);
+        close(param->wake_fd[1]);
+        param->listen_fd = -1;
+        param->wake_fd[0] = param->wake_fd[1] = -1;
+        return err::ERR_NONE;
     }
 
     err::Err Rtsp::bind_camera(camera::Camera *camera) {
-        err::Err err = err::ERR_NOT_IMPL;
-        (void)camera;
-        return err;
+        err::check_null_raise(camera, "camera is NULL");
+        this->_camera = camera;
+        this->_bind_camera = true;
+        return err::ERR_NONE;
+    }
+
+    err::Err Rtsp::write(video::Frame &frame) {
+        rtsp_param_t *param = (rtsp_param_t *)this->_param;
+        void *data;
+        int data_len = 0;
+        if (err::ERR_NONE != frame.get(&data, &data_len) || data_len == 0) {
+            return err::ERR_NONE;
+        }
+        if (!this->_is_start) {
+            return err::ERR_NOT_READY;
+        }
+        this->update_timestamp();
+        uint32_t ts = (uint32_t)(this->get_timestamp() * (RTSP_RTP_CLOCK / 1000));
+        _send_frame(param, (const uint8_t *)data, data_len, ts);
+        return err::ERR_NONE;
     }
 
-    err::Err Rtsp::write(video::Frame &stream) {
-        err::Err err = err::ERR_NOT_IMPL;
-        (void)stream;
-        return err;
+    err::Err Rtsp::write(image::Image &img) {
+        rtsp_param_t *param = (rtsp_param_t *)this->_param;
+        if (!param->encoder) {
+            video::VideoType type = param->h265 ? video::VideoType::VIDEO_H265_CBR : video::VideoType::VIDEO_H264_CBR;
+            // one second gop, so congested client recover soon
+            param->encoder = new video::Encoder(img.width(), img.height(), img.format(), type, this->_fps, this->_fps,
+                                                3000 * 1000, 1000, false, 0, true);
+        }
+        image::Image *src = &img;
+        {
+            std::lock_guard<std::recursive_mutex> lk(param->region_lock);
+            bool has_region = false;
+            for (auto r : this->_region_list)
+                has_region |= r != NULL;
+            if (has_region && img.format() == image::Format::FMT_YVU420SP) {
+                if (!param->overlay || param->overlay->width() != img.width() || param->overlay->height() != img.height()) {
+                    delete param->overlay;
+                    param->overlay = new image::Image(img.width(), img.height(), img.format());
+                }
+                memcpy(param->overlay->data(), img.data(), img.data_size());
+                for (auto r : this->_region_list) {
+                    if (r)
+                        _blend_region_nv21(*param->overlay, *r->_image, r->_x, r->_y);
+                }
+                src = param->overlay;
+            }
+        }
+        video::Frame *frame = param->encoder->encode(src);
+        if (!frame) {
+            return err::ERR_RUNTIME;
+        }
+        err::Err e = this->write(*frame);
+        delete frame;
+        return e;
     }
 
     std::string Rtsp::get_url() {
-        return "not supported";
+        rtsp_param_t *param = (rtsp_param_t *)this->_param;
+        std::string ip = param->bind_ip == "0.0.0.0" ? "127.0.0.1" : param->bind_ip;
+        return "rtsp://" + ip + ":" + std::to_string(this->_port) + "/live";
     }
 
     std::vector<std::string> Rtsp::get_urls() {
-        return std::vector<std::string>();
+        rtsp_param_t *param = (rtsp_param_t *)this->_param;
+        std::vector<std::string> urls;
+        if (param->bind_ip != "0.0.0.0") {
+            urls.push_back(this->get_url());
+            return urls;
+        }
+        struct ifaddrs *ifaddr;
+        if (getifaddrs(&ifaddr) != 0) {
+            urls.push_back(this->get_url());
+            return urls;
+        }
+        for (struct ifaddrs *ifa = ifaddr; ifa; ifa = ifa->ifa_next) {
+            if (!ifa->ifa_addr || ifa->ifa_addr->sa_family != AF_INET)
+                continue;
+            char ip[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &((struct sockaddr_in *)ifa->ifa_addr)->sin_addr, ip, sizeof(ip));
+            urls.push_back("rtsp://" + std::string(ip) + ":" + std::to_string(this->_port) + "/live");
+        }
+        freeifaddrs(ifaddr);
+        return urls;
     }
 
     rtsp::Region *Rtsp::add_region(int x, int y, int width, int height, image::Format format) {
-        (void)x;
-        (void)y;
-        (void)width;
-        (void)height;
-        (void)format;
-        return NULL;
+        rtsp_param_t *param = (rtsp_param_t *)this->_param;
+        if (format != image::Format::FMT_BGRA8888) {
+            log::error("region support FMT_BGRA8888 only!\r\n");
+            return NULL;
+        }
+        std::lock_guard<std::recursive_mutex> lk(param->region_lock);
+        int unused_idx = -1;
+        for (int i = 0; i < this->_region_max_number; i ++) {
+            if (this->_region_used_list[i] == false) {
+                unused_idx = i;
+                break;
+            }
+        }
+        err::check_bool_raise(unused_idx != -1, "Unused region not found");
+
+        rtsp::Region *region = new rtsp::Region(x, y, width, height, format, this->_camera);
+        this->_region_list[unused_idx] = region;
+        this->_region_used_list[unused_idx] = true;
+        this->_region_type_list[unused_idx] = 0;
+        return region;
     }
 
     err::Err Rtsp::update_region(rtsp::Region &region) {
@@ -89,13 +1062,70 @@ namespace maix::rtsp
     }
 
     err::Err Rtsp::del_region(rtsp::Region *region) {
+        rtsp_param_t *param = (rtsp_param_t *)this->_param;
         err::check_null_raise(region, "The region object is NULL");
 
-        return err::ERR_NOT_IMPL;
+        std::lock_guard<std::recursive_mutex> lk(param->region_lock);
+        for (int i = 0; i < this->_region_max_number; i ++) {
+            if (this->_region_list[i] == region) {
+                this->_region_list[i] = NULL;
+                this->_region_used_list[i] = false;
+                this->_region_type_list[i] = 0;
+                delete region;
+                return err::ERR_NONE;
+            }
+        }
+        return err::ERR_NONE;
     }
 
     err::Err Rtsp::draw_rect(int id, int x, int y, int width, int height, image::Color color, int thickness) {
-        return err::ERR_NOT_IMPL;
+        rtsp_param_t *param = (rtsp_param_t *)this->_param;
+        if (id < 0 || id > 3) {
+            log::error("region id is invalid! range is [0, 3");
+            err::check_raise(err::ERR_RUNTIME, "invalid parameter");
+        }
+        if (x < 0) {
+            width = width + x < 0 ? 0 : width + x;
+            x = 0;
+        }
+        if (y < 0) {
+            height = height + y < 0 ? 0 : height + y;
+            y = 0;
+        }
+        if (width <= 0 || height <= 0) {
+            return err::ERR_ARGS;
+        }
+
+        std::lock_guard<std::recursive_mutex> lk(param->region_lock);
+        for (int i = id; i < this->_region_max_number && i < id + 4; i ++) {
+            if (_region_used_list[i] == true && _region_type_list[i] != 2) {
+                log::error("In areas %d - %d, %d is used for other functions(%d)", id, id + 4, i, _region_type_list[i]);
+                err::check_raise(err::ERR_RUNTIME, "invalid parameter");
+            }
+        }
+        for (int i = id; i < this->_region_max_number && i < id + 4; i ++) {
+            if (_region_used_list[i] == true) {
+                delete _region_list[i];
+                _region_list[i] = NULL;
+                _region_used_list[i] = false;
+            }
+        }
+
+        // one region of rect, transparent inside if not fill
+        rtsp::Region *region = new rtsp::Region(x, y, width, height, image::Format::FMT_BGRA8888, this->_camera);
+        uint32_t bgra = color.b | (color.g << 8) | (color.r << 16) | (0xFFu << 24);
+        uint32_t *data = (uint32_t *)region->_image->data();
+        int t = thickness < 0 ? (width > height ? width : height) : thickness;
+        for (int i = 0; i < height; i ++) {
+            for (int j = 0; j < width; j ++) {
+                bool edge = i < t || i >= height - t || j < t || j >= width - t;
+                data[i * width + j] = edge ? bgra : 0;
+            }
+        }
+        _region_list[id] = region;
+        _region_used_list[id] = true;
+        _region_type_list[id] = 2;
+        return err::ERR_NONE;
     }
 
     err::Err Rtsp::draw_string(int id, int x, int y, const char *str, image::Color color, int size, int thickness)
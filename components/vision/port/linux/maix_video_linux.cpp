@@ -3,14 +3,28 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Implement Encoder and Decoder with libavcodec.
+ * @update 2026.10.18: Implement Video encoding with Encoder and MP4Muxer.
  */
 
 #include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <list>
 #include "maix_err.hpp"
 #include "maix_log.hpp"
 #include "maix_image.hpp"
 #include "maix_time.hpp"
 #include "maix_video.hpp"
+#include "maix_video_mp4.hpp"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/opt.h>
+#include <libswscale/swscale.h>
+}
 
 namespace maix::video
 {
@@ -22,63 +36,665 @@ namespace maix::video
     maix::image::Image *Encoder::NoneImage = NULL;
 #endif
 
-    Encoder::Encoder(int width, int height, image::Format format, VideoType type, int framerate, int gop, int bitrate, int time_base, bool capture) {
-        throw err::Exception(err::ERR_NOT_IMPL);
+    typedef struct {
+        const AVCodec *codec;
+        AVCodecContext *ctx;
+        AVFrame *frame;             // input frame, planes point to image data directly when zero_copy is true
+        AVFrame *conv_frame;        // frame owned by encoder, image is copied or converted to it when zero_copy is false
+        AVPacket *pkt;
+        SwsContext *sws;
+        AVPixelFormat img_fmt;
+        bool zero_copy;
+    } encoder_param_t;
+
+    typedef struct {
+        AVCodecContext *ctx;
+        AVCodecParserContext *parser;
+        AVPacket *pkt;
+        SwsContext *sws;
+        std::list<AVFrame *> frames;    // decoded frames wait for decode() to get
+    } decoder_param_t;
+
+    static AVPixelFormat _maix_to_av_format(image::Format format)
+    {
+        switch (format)
+        {
+        case image::Format::FMT_RGB888:     return AV_PIX_FMT_RGB24;
+        case image::Format::FMT_BGR888:     return AV_PIX_FMT_BGR24;
+        case image::Format::FMT_RGBA8888:   return AV_PIX_FMT_RGBA;
+        case image::Format::FMT_BGRA8888:   return AV_PIX_FMT_BGRA;
+        case image::Format::FMT_RGB565:     return AV_PIX_FMT_RGB565LE;
+        case image::Format::FMT_BGR565:     return AV_PIX_FMT_BGR565LE;
+        case image::Format::FMT_YUV422SP:   return AV_PIX_FMT_NV16;
+        case image::Format::FMT_YUV422P:    return AV_PIX_FMT_YUV422P;
+        case image::Format::FMT_YVU420SP:   return AV_PIX_FMT_NV21;
+        case image::Format::FMT_YUV420SP:   return AV_PIX_FMT_NV12;
+        case image::Format::FMT_YVU420P:    return AV_PIX_FMT_YUV420P;  // U V planes swapped in _fill_planes
+        case image::Format::FMT_YUV420P:    return AV_PIX_FMT_YUV420P;
+        case image::Format::FMT_GRAYSCALE:  return AV_PIX_FMT_GRAY8;
+        default:                            return AV_PIX_FMT_NONE;
+        }
+    }
+
+    /**
+     * Point planes to continuous image data, no copy
+     */
+    static int _fill_planes(uint8_t *planes[4], int linesize[4], uint8_t *data, int width, int height, image::Format format)
+    {
+        int ret = av_image_fill_arrays(planes, linesize, data, _maix_to_av_format(format), width, height, 1);
+        if (ret >= 0 && format == image::Format::FMT_YVU420P)
+        {
+            std::swap(planes[1], planes[2]);
+            std::swap(linesize[1], linesize[2]);
+        }
+        return ret;
+    }
+
+    static bool _codec_support_format(const AVCodec *codec, AVPixelFormat fmt)
+    {
+        const AVPixelFormat *fmts = NULL;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(61, 13, 100)
+        int num = 0;
+        if (avcodec_get_supported_config(NULL, codec, AV_CODEC_CONFIG_PIX_FORMAT, 0, (const void **)&fmts, &num) < 0)
+            fmts = NULL;
+#else
+        fmts = codec->pix_fmts;
+#endif
+        if (!fmts)
+            return fmt == AV_PIX_FMT_YUV420P;
+        for (; *fmts != AV_PIX_FMT_NONE; ++fmts)
+        {
+            if (*fmts == fmt)
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * x264 and x265 copy input picture to their own buffers in encode call,
+     * so we can pass image memory to them directly, other encoders may hold the frame after avcodec_send_frame returns.
+     */
+    static bool _codec_copy_input(const AVCodec *codec)
+    {
+        return strcmp(codec->name, "libx264") == 0 || strcmp(codec->name, "libx265") == 0;
+    }
+
+    static void _av_buffer_free_none(void *opaque, uint8_t *data)
+    {
+        (void)opaque;
+        (void)data;
+    }
+
+    static const AVCodec *_find_encoder(video::VideoType type)
+    {
+        switch (type)
+        {
+        case VIDEO_H264_CBR:
+        case VIDEO_H264_CBR_MP4:
+        {
+            const AVCodec *codec = avcodec_find_encoder_by_name("libx264");
+            return codec ? codec : avcodec_find_encoder(AV_CODEC_ID_H264);
+        }
+        case VIDEO_ENC_H265_CBR:
+        case VIDEO_H265_CBR:
+        case VIDEO_H265_CBR_MP4:
+        {
+            const AVCodec *codec = avcodec_find_encoder_by_name("libx265");
+            return codec ? codec : avcodec_find_encoder(AV_CODEC_ID_HEVC);
+        }
+        default:
+            return NULL;
+        }
+    }
+
+    static void _encoder_close(encoder_param_t *param)
+    {
+        avcodec_free_context(&param->ctx);
+        av_frame_free(&param->conv_frame);
+        sws_freeContext(param->sws);
+        param->sws = NULL;
+    }
+
+    static err::Err _encoder_open(encoder_param_t *param, int width, int height, image::Format format,
+                                  int framerate, int gop, int bitrate, int time_base, int threads, bool low_latency)
+    {
+        param->img_fmt = _maix_to_av_format(format);
+        if (param->img_fmt == AV_PIX_FMT_NONE)
+        {
+            log::error("video encoder not support image format %d\r\n", format);
+            return err::ERR_ARGS;
+        }
+        // encode image directly if encoder support image format, or convert to YUV420P
+        bool same_format = _codec_support_format(param->codec, param->img_fmt) && format != image::Format::FMT_YVU420P;
+        AVPixelFormat enc_fmt = same_format ? param->img_fmt : AV_PIX_FMT_YUV420P;
+        param->zero_copy = same_format && _codec_copy_input(param->codec);
+
+        AVCodecContext *ctx = avcodec_alloc_context3(param->codec);
+        if (!ctx)
+            return err::ERR_NO_MEM;
+        ctx->width = width;
+        ctx->height = height;
+        ctx->pix_fmt = enc_fmt;
+        ctx->time_base = av_make_q(time_base, 1000000);     // unit of pts, @see Encoder::get_pts
+        ctx->framerate = av_make_q(framerate, 1);
+        ctx->gop_size = gop;
+        ctx->bit_rate = bitrate;
+        ctx->rc_max_rate = bitrate;
+        ctx->rc_buffer_size = bitrate;
+        ctx->thread_count = threads;
+        av_opt_set(ctx->priv_data, "preset", "veryfast", 0);
+        if (low_latency)
+        {
+            // no B-frames and look ahead, and slice threads instead of frame threads,
+            // so every frame will be output in the same encode() call.
+            ctx->max_b_frames = 0;
+            ctx->thread_type = FF_THREAD_SLICE;
+            av_opt_set(ctx->priv_data, "tune", "zerolatency", 0);
+        }
+        int ret = avcodec_open2(ctx, param->codec, NULL);
+        if (ret < 0)
+        {
+            log::error("open encoder %s failed: %d\r\n", param->codec->name, ret);
+            avcodec_free_context(&ctx);
+            return err::ERR_RUNTIME;
+        }
+        param->ctx = ctx;
+
+        if (!same_format)
+        {
+            param->sws = sws_getContext(width, height, param->img_fmt, width, height, enc_fmt, SWS_BILINEAR, NULL, NULL, NULL);
+            if (!param->sws)
+            {
+                _encoder_close(param);
+                return err::ERR_RUNTIME;
+            }
+        }
+        return err::ERR_NONE;
+    }
+
+    static err::Err _encoder_alloc_conv_frame(encoder_param_t *param)
+    {
+        param->conv_frame = av_frame_alloc();
+        if (!param->conv_frame)
+            return err::ERR_NO_MEM;
+        param->conv_frame->format = param->ctx->pix_fmt;
+        param->conv_frame->width = param->ctx->width;
+        param->conv_frame->height = param->ctx->height;
+        if (av_frame_get_buffer(param->conv_frame, 0) < 0)
+        {
+            av_frame_free(&param->conv_frame);
+            return err::ERR_NO_MEM;
+        }
+        return err::ERR_NONE;
+    }
+
+    /**
+     * Send image to encoder, without copy if param->zero_copy is true.
+     */
+    static err::Err _encoder_send(encoder_param_t *param, image::Image *img, int64_t pts)
+    {
+        AVFrame *frame = param->frame;
+        AVBufferRef *buf = NULL;
+        int ret;
+        if (param->zero_copy)
+        {
+            // wrap image memory in a buffer not freed by ffmpeg, so avcodec_send_frame will not copy it.
+            buf = av_buffer_create((uint8_t *)img->data(), img->data_size(), _av_buffer_free_none, NULL, 0);
+            if (!buf)
+                return err::ERR_NO_MEM;
+            frame->buf[0] = av_buffer_ref(buf);
+            if (!frame->buf[0])
+            {
+                av_buffer_unref(&buf);
+                return err::ERR_NO_MEM;
+            }
+            _fill_planes(frame->data, frame->linesize, (uint8_t *)img->data(), img->width(), img->height(), img->format());
+            frame->format = param->img_fmt;
+            frame->width = img->width();
+            frame->height = img->height();
+        }
+        else
+        {
+            if (!param->conv_frame && _encoder_alloc_conv_frame(param) != err::ERR_NONE)
+                return err::ERR_NO_MEM;
+            AVFrame *dst = param->conv_frame;
+            if (av_frame_make_writable(dst) < 0)
+                return err::ERR_NO_MEM;
+            uint8_t *planes[4];
+            int linesize[4];
+            _fill_planes(planes, linesize, (uint8_t *)img->data(), img->width(), img->height(), img->format());
+            if (param->sws)
+                sws_scale(param->sws, (const uint8_t *const *)planes, linesize, 0, img->height(), dst->data, dst->linesize);
+            else
+                av_image_copy(dst->data, dst->linesize, (const uint8_t **)planes, linesize, param->img_fmt, img->width(), img->height());
+            av_frame_ref(frame, dst);
+        }
+        frame->pts = pts;
+        ret = avcodec_send_frame(param->ctx, frame);
+        av_frame_unref(frame);
+        if (buf)
+        {
+            if (av_buffer_get_ref_count(buf) > 1)
+            {
+                // encoder still hold image memory, never do this again
+                log::warn("encoder %s hold input frame, disable zero copy\r\n", param->codec->name);
+                param->zero_copy = false;
+            }
+            av_buffer_unref(&buf);
+        }
+        if (ret < 0)
+        {
+            log::error("send frame to encoder failed: %d\r\n", ret);
+            return err::ERR_RUNTIME;
+        }
+        return err::ERR_NONE;
+    }
+
+    /**
+     * Append all packets can be received from encoder to stream buffer,
+     * pts and dts are set to the first packet's, with B-frames output packet is not the input frame.
+     */
+    static void _encoder_receive(encoder_param_t *param, uint8_t **stream_buffer, int *stream_size, uint64_t *pts, uint64_t *dts)
+    {
+        while (true) {
+            int ret = avcodec_receive_packet(param->ctx, param->pkt);
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                break;
+            if (ret < 0) {
+                log::error("receive packet from encoder failed: %d\r\n", ret);
+                break;
+            }
+            uint8_t *new_buffer = (uint8_t *)realloc(*stream_buffer, *stream_size + param->pkt->size);
+            if (!new_buffer) {
+                log::error("malloc failed!\r\n");
+                av_packet_unref(param->pkt);
+                break;
+            }
+            if (*stream_size == 0) {
+                *pts = param->pkt->pts;
+                *dts = param->pkt->dts;
+            }
+            *stream_buffer = new_buffer;
+            memcpy(*stream_buffer + *stream_size, param->pkt->data, param->pkt->size);
+            *stream_size += param->pkt->size;
+            av_packet_unref(param->pkt);
+        }
+    }
+
+    Encoder::Encoder(int width, int height, image::Format format, VideoType type, int framerate, int gop, int bitrate, int time_base, bool capture, int threads, bool low_latency) {
+        _width = width;
+        _height = height;
+        _format = format;
+        _type = type;
+        _framerate = framerate;
+        _gop = gop;
+        _bitrate = bitrate;
+        _time_base = time_base;
+        _need_capture = capture;
+        _capture_image = NULL;
+        _camera = NULL;
+        _bind_camera = false;
+        _pts = 0;
+        _dts = 0;
+        _start_encode_ms = 0;
+        _encode_started = false;
+        _threads = threads;
+        _low_latency = low_latency;
+
+        const AVCodec *codec = _find_encoder(_type);
+        if (!codec) {
+            std::string err_str = "Encoder not support type: " + std::to_string(_type);
+            err::check_raise(err::ERR_NOT_IMPL, err_str);
+        }
+        encoder_param_t *param = new encoder_param_t();
+        param->codec = codec;
+        param->frame = av_frame_alloc();
+        param->pkt = av_packet_alloc();
+        if (!param->frame || !param->pkt) {
+            av_frame_free(&param->frame);
+            av_packet_free(&param->pkt);
+            delete param;
+            err::check_raise(err::ERR_NO_MEM, "alloc encoder frame failed!");
+        }
+        err::Err e = _encoder_open(param, _width, _height, _format, _framerate, _gop, _bitrate, _time_base, _threads, _low_latency);
+        if (e != err::ERR_NONE) {
+            av_frame_free(&param->frame);
+            av_packet_free(&param->pkt);
+            delete param;
+            err::check_raise(e, "init encoder failed!");
+        }
+        _param = param;
     }
 
     Encoder::~Encoder() {
-        throw err::Exception(err::ERR_NOT_IMPL);
+        encoder_param_t *param = (encoder_param_t *)_param;
+        if (param) {
+            _encoder_close(param);
+            av_frame_free(&param->frame);
+            av_packet_free(&param->pkt);
+            delete param;
+            _param = NULL;
+        }
+
+        if (_capture_image && _capture_image->data()) {
+            delete _capture_image;
+            _capture_image = nullptr;
+        }
     }
 
     err::Err Encoder::bind_camera(camera::Camera *camera) {
-        (void)camera;
-        throw err::Exception(err::ERR_NOT_IMPL);
-        return err::ERR_NOT_IMPL;
+        this->_camera = camera;
+        this->_bind_camera = true;
+        return err::ERR_NONE;
     }
 
     video::Frame *Encoder::encode(image::Image *img) {
-        (void)img;
-        throw err::Exception(err::ERR_NOT_IMPL);
-        return nullptr;
+        encoder_param_t *param = (encoder_param_t *)_param;
+        uint8_t *stream_buffer = NULL;
+        int stream_size = 0;
+        image::Image *camera_img = NULL;
+        uint64_t pts = 0, dts = 0;
+        uint64_t curr_ms = time::ticks_ms();
+        if (!_encode_started) {
+            _encode_started = true;
+            _start_encode_ms = curr_ms;
+        }
+
+        do {
+            if (!img || !img->data()) {  // encode from camera
+                if (!this->_bind_camera) {
+                    log::warn("You need use bind_camera() function to bind the camera!\r\n");
+                    break;
+                }
+                camera_img = _camera->read();
+                if (!camera_img) {
+                    log::error("read camera image failed!\r\n");
+                    break;
+                }
+                img = camera_img;
+                if (_need_capture) {
+                    if (_capture_image) {
+                        delete _capture_image;
+                    }
+                    _capture_image = camera_img;
+                    camera_img = NULL;
+                }
+            }
+
+            if (img->width() != _width || img->height() != _height || img->format() != _format) {
+                log::warn("image size or format is incorrect, try to reinit encoder!\r\n");
+                // open the new encoder first, the old one is still usable if failed
+                encoder_param_t new_param = *param;
+                new_param.ctx = NULL;
+                new_param.conv_frame = NULL;
+                new_param.sws = NULL;
+                if (err::ERR_NONE != _encoder_open(&new_param, img->width(), img->height(), img->format(), _framerate, _gop, _bitrate, _time_base, _threads, _low_latency)) {
+                    if (camera_img)
+                        delete camera_img;
+                    err::check_raise(err::ERR_RUNTIME, "encoder init failed!\r\n");
+                }
+                // drain frames delayed by the old encoder(e.g. B-frames, look ahead), output them with this frame
+                if (avcodec_send_frame(param->ctx, NULL) >= 0)
+                    _encoder_receive(param, &stream_buffer, &stream_size, &pts, &dts);
+                _encoder_close(param);
+                *param = new_param;
+                _width = img->width();
+                _height = img->height();
+                _format = img->format();
+            }
+
+            // pts must increase strictly
+            uint64_t frame_pts = get_pts(curr_ms - _start_encode_ms);
+            if (_pts && frame_pts <= _pts)
+                frame_pts = _pts + 1;
+            _pts = frame_pts;
+            if (stream_size == 0) {
+                pts = frame_pts;
+                dts = frame_pts;
+            }
+            if (err::ERR_NONE != _encoder_send(param, img, frame_pts)) {
+                break;
+            }
+            _encoder_receive(param, &stream_buffer, &stream_size, &pts, &dts);
+        } while (0);
+
+        if (camera_img) {
+            delete camera_img;
+        }
+        video::Frame *frame = new video::Frame(stream_buffer, stream_size, pts, dts, 0, true, false);
+        return frame;
     }
 
-    Decoder::Decoder() {
-        throw err::Exception(err::ERR_NOT_IMPL);
+    Decoder::Decoder(video::VideoType type, image::Format format, int threads) {
+        _prepare_data = NULL;
+        _type = type;
+        _format = format;
+        _threads = threads;
+        _param = NULL;
+
+        AVCodecID codec_id = AV_CODEC_ID_NONE;
+        switch (_type) {
+        case VIDEO_H264_CBR:
+        case VIDEO_H264_CBR_MP4:
+            codec_id = AV_CODEC_ID_H264;
+            break;
+        case VIDEO_ENC_H265_CBR:
+        case VIDEO_DEC_H265_CBR:
+        case VIDEO_H265_CBR:
+        case VIDEO_H265_CBR_MP4:
+            codec_id = AV_CODEC_ID_HEVC;
+            break;
+        default:
+        {
+            std::string err_str = "Decoder not support type: " + std::to_string(_type);
+            err::check_raise(err::ERR_NOT_IMPL, err_str);
+            return;
+        }
+        }
+        if (_maix_to_av_format(_format) == AV_PIX_FMT_NONE) {
+            err::check_raise(err::ERR_ARGS, "Decoder not support format: " + std::to_string(_format));
+        }
+        const AVCodec *codec = avcodec_find_decoder(codec_id);
+        if (!codec) {
+            err::check_raise(err::ERR_NOT_IMPL, "can not find decoder");
+        }
+
+        decoder_param_t *param = new decoder_param_t();
+        param->ctx = avcodec_alloc_context3(codec);
+        param->parser = av_parser_init(codec_id);
+        param->pkt = av_packet_alloc();
+        if (param->ctx) {
+            // frame threads delay output thread_count frames, use slice threads to get image in the same decode() call.
+            param->ctx->thread_count = _threads;
+            param->ctx->thread_type = FF_THREAD_SLICE;
+        }
+        if (!param->ctx || !param->parser || !param->pkt || avcodec_open2(param->ctx, codec, NULL) < 0) {
+            avcodec_free_context(&param->ctx);
+            if (param->parser)
+                av_parser_close(param->parser);
+            av_packet_free(&param->pkt);
+            delete param;
+            err::check_raise(err::ERR_RUNTIME, "init decoder failed!");
+        }
+        _param = param;
     }
 
     Decoder::~Decoder() {
-        throw err::Exception(err::ERR_NOT_IMPL);
+        decoder_param_t *param = (decoder_param_t *)_param;
+        if (param) {
+            for (AVFrame *frame : param->frames)
+                av_frame_free(&frame);
+            av_parser_close(param->parser);
+            avcodec_free_context(&param->ctx);
+            av_packet_free(&param->pkt);
+            sws_freeContext(param->sws);
+            delete param;
+            _param = NULL;
+        }
+        if (_prepare_data) {
+            delete _prepare_data;
+            _prepare_data = NULL;
+        }
     }
 
     err::Err Decoder::prepare(Bytes *data, bool copy) {
-        (void)data;
-        (void)copy;
-        return err::ERR_NONE;
+        err::check_null_raise(data, "data is null");
+        return prepare(data->data, data->size(), copy);
     }
 
     err::Err Decoder::prepare(void *data, int data_size, bool copy) {
-        (void)data;
-        (void)data_size;
-        (void)copy;
+        if (_prepare_data) {
+            delete _prepare_data;
+            _prepare_data = NULL;
+        }
+        if (!data || data_size <= 0)
+            return err::ERR_ARGS;
+        _prepare_data = new Bytes((uint8_t *)data, data_size, false, copy);
         return err::ERR_NONE;
     }
 
+    /**
+     * Send packet to decoder, move decoded frames to frame list when decoder is full.
+     * pkt NULL means end of stream, drain the decoder.
+     */
+    static err::Err _decoder_send(decoder_param_t *param, AVPacket *pkt)
+    {
+        while (true) {
+            int ret = avcodec_send_packet(param->ctx, pkt);
+            if (ret != AVERROR(EAGAIN)) {
+                if (ret < 0) {
+                    log::error("send packet to decoder failed: %d\r\n", ret);
+                    return err::ERR_RUNTIME;
+                }
+                return err::ERR_NONE;
+            }
+            AVFrame *frame = av_frame_alloc();
+            if (!frame)
+                return err::ERR_NO_MEM;
+            if (avcodec_receive_frame(param->ctx, frame) < 0) {
+                av_frame_free(&frame);
+                return err::ERR_RUNTIME;
+            }
+            param->frames.push_back(frame);
+        }
+    }
+
+    /**
+     * End of stream, send the last access unit held by parser and get frames delayed by decoder,
+     * then reset parser and decoder for the next stream.
+     */
+    static void _decoder_flush(decoder_param_t *param)
+    {
+        av_parser_parse2(param->parser, param->ctx, &param->pkt->data, &param->pkt->size,
+                         NULL, 0, AV_NOPTS_VALUE, AV_NOPTS_VALUE, 0);
+        if (param->pkt->size > 0)
+            _decoder_send(param, param->pkt);
+        if (_decoder_send(param, NULL) == err::ERR_NONE) {
+            while (true) {
+                AVFrame *av_frame = av_frame_alloc();
+                if (!av_frame || avcodec_receive_frame(param->ctx, av_frame) < 0) {
+                    av_frame_free(&av_frame);
+                    break;
+                }
+                param->frames.push_back(av_frame);
+            }
+        }
+        avcodec_flush_buffers(param->ctx);
+        AVCodecParserContext *parser = av_parser_init(param->ctx->codec_id);
+        if (parser) {
+            av_parser_close(param->parser);
+            param->parser = parser;
+        }
+    }
+
     image::Image *Decoder::decode(video::Frame *frame) {
-        (void)frame;
-        return NULL;
+        decoder_param_t *param = (decoder_param_t *)_param;
+        if (frame && frame->is_valid()) {
+            // one frame is a complete access unit, no need to parse
+            param->pkt->data = frame->data();
+            param->pkt->size = frame->size();
+            param->pkt->pts = frame->get_pts();
+            param->pkt->dts = frame->get_dts();
+            _decoder_send(param, param->pkt);
+            av_packet_unref(param->pkt);
+        } else if (_prepare_data) {
+            uint8_t *data = _prepare_data->data;
+            int data_size = _prepare_data->size();
+            while (data_size > 0) {
+                int len = av_parser_parse2(param->parser, param->ctx, &param->pkt->data, &param->pkt->size,
+                                           data, data_size, AV_NOPTS_VALUE, AV_NOPTS_VALUE, 0);
+                if (len < 0) {
+                    log::error("parse video data failed\r\n");
+                    break;
+                }
+                data += len;
+                data_size -= len;
+                if (param->pkt->size > 0)
+                    _decoder_send(param, param->pkt);
+            }
+            delete _prepare_data;
+            _prepare_data = NULL;
+        } else if (param->frames.empty()) {
+            _decoder_flush(param);
+        }
+
+        while (true) {
+            AVFrame *av_frame = av_frame_alloc();
+            if (!av_frame || avcodec_receive_frame(param->ctx, av_frame) < 0) {
+                av_frame_free(&av_frame);
+                break;
+            }
+            param->frames.push_back(av_frame);
+        }
+        if (param->frames.empty())
+            return NULL;
+
+        AVFrame *av_frame = param->frames.front();
+        param->frames.pop_front();
+        image::Image *img = new image::Image(av_frame->width, av_frame->height, _format);
+        uint8_t *planes[4];
+        int linesize[4];
+        _fill_planes(planes, linesize, (uint8_t *)img->data(), img->width(), img->height(), _format);
+        param->sws = sws_getCachedContext(param->sws, av_frame->width, av_frame->height, (AVPixelFormat)av_frame->format,
+                                          img->width(), img->height(), _maix_to_av_format(_format), SWS_BILINEAR, NULL, NULL, NULL);
+        if (!param->sws) {
+            log::error("convert decoded frame failed\r\n");
+            av_frame_free(&av_frame);
+            delete img;
+            return NULL;
+        }
+        sws_scale(param->sws, (const uint8_t *const *)av_frame->data, av_frame->linesize, 0, av_frame->height, planes, linesize);
+        av_frame_free(&av_frame);
+        return img;
     }
 
     Video::Video(std::string path, int width, int height, image::Format format, int time_base, int framerate, bool capture, bool open)
     {
-        (void)path;
-        (void)width;
-        (void)height;
         (void)format;
-        (void)time_base;
-        (void)framerate;
-        (void)capture;
-        (void)open;
-        throw err::Exception(err::ERR_NOT_IMPL);
+        this->_pre_path = path;
+        this->_pre_fps = framerate;
+        this->_video_type = VIDEO_NONE;
+        this->_bind_camera = false;
+        this->_is_recording = false;
+        this->_camera = NULL;
+        this->_fd = -1;
+        this->_mp4 = nullptr;
+        this->_encoder = nullptr;
+        this->_time_base = time_base;
+        this->_framerate = framerate;
+        this->_need_auto_config = true;
+        this->_pre_width = width;
+        this->_pre_height = height;
+        this->_width = width;
+        this->_height = height;
+        this->_last_pts = 0;
+        this->_capture_image = nullptr;
+        this->_need_capture = capture;
+        this->_is_opened = false;
+
+        if (open) {
+            err::check_bool_raise(err::ERR_NONE == this->open(), "Video open failed!\r\n");
+        }
     }
 
     Video::~Video() {
@@ -89,27 +705,164 @@ namespace maix::video
 
     err::Err Video::open(std::string path, double fps)
     {
-        (void)path;
-        (void)fps;
-        throw err::Exception(err::ERR_NOT_IMPL);
+        if (this->_is_opened) {
+            return err::ERR_NONE;
+        }
+
+        if (path == std::string()) {
+            this->_path = this->_pre_path;
+        } else {
+            this->_path = path;
+        }
+
+        if (fps == 30.0) {
+            this->_fps = this->_pre_fps;
+        } else {
+            this->_fps = fps;
+        }
+
+        // encoder is created at the first encode() call, with the size and format of the first image
+        this->_need_auto_config = true;
+        this->_is_opened = true;
         return err::ERR_NONE;
     }
 
     void Video::close()
     {
-        throw err::Exception(err::ERR_NOT_IMPL);
+        if (this->_is_opened) {
+            this->finish();
+        }
+        if (this->_encoder) {
+            delete this->_encoder;
+            this->_encoder = nullptr;
+        }
+        if (_capture_image && _capture_image->data()) {
+            delete _capture_image;
+            _capture_image = nullptr;
+        }
+        this->_is_opened = false;
     }
 
     err::Err Video::bind_camera(camera::Camera *camera) {
-        (void)camera;
-        err::Err err = err::ERR_NONE;
-        throw err::Exception(err::ERR_NOT_IMPL);
-        return err;
+        err::check_null_raise(camera, "camera is null");
+        this->_camera = camera;
+        this->_bind_camera = true;
+        return err::ERR_NONE;
+    }
+
+    static video::VideoType get_video_type(std::string &path)
+    {
+        std::string ext;
+        size_t pos = path.rfind('.');
+        if (pos != std::string::npos) {
+            ext = path.substr(pos);
+        }
+
+        if (ext == ".h265") {
+            return VIDEO_ENC_H265_CBR;
+        } else if (ext == ".mp4") {
+            return VIDEO_ENC_MP4_CBR;
+        }
+        log::error("Video not support %s!\r\n", ext.c_str());
+        return VIDEO_NONE;
     }
 
     video::Packet *Video::encode(image::Image *img) {
-        (void)img;
-        return nullptr;
+        bool from_camera = !img || !img->data();
+        if (!this->_is_opened) {
+            log::error("video not opened!\r\n");
+            return new video::Packet();
+        }
+        if (from_camera && !this->_bind_camera) {
+            log::warn("You need use bind_camera() function to bind the camera!\r\n");
+            return new video::Packet();
+        }
+
+        if (_need_auto_config) {
+            _video_type = get_video_type(_path);
+            err::check_bool_raise(_video_type != VIDEO_NONE, "Can't parse video type!");
+            _width = from_camera ? _camera->width() : img->width();
+            _height = from_camera ? _camera->height() : img->height();
+            image::Format format = from_camera ? _camera->format() : img->format();
+            int framerate = _fps > 0 ? (int)(_fps + 0.5) : (_framerate > 0 ? _framerate : 30);
+            delete _encoder;    // left by a failed config before
+            _encoder = nullptr;
+            // software H.265 encoder, low latency mode so every encode() outputs the frame of this image,
+            // pts unit is ms(time_base 1000), the same as MP4Muxer
+            _encoder = new video::Encoder(_width, _height, format, VIDEO_H265_CBR, framerate, 50, 3000 * 1000, 1000, false, 0, true);
+            if (_video_type == VIDEO_ENC_MP4_CBR) {
+                _mp4 = new video::MP4Muxer(_path, VIDEO_H265_CBR, _width, _height, 1000, framerate);
+            }
+            _record_start_ms = time::ticks_ms();
+            _need_auto_config = false;
+        }
+
+        image::Image *camera_img = NULL;
+        if (from_camera) {
+            camera_img = _camera->read();
+            if (!camera_img) {
+                log::error("read camera image failed!\r\n");
+                return new video::Packet();
+            }
+            img = camera_img;
+            if (_need_capture) {
+                if (_capture_image && _capture_image->data()) {
+                    delete _capture_image;
+                }
+                _capture_image = camera_img;
+                camera_img = NULL;
+            }
+        }
+
+        video::Frame *frame = NULL;
+        try {
+            frame = _encoder->encode(img);
+        } catch (...) {
+            if (camera_img)
+                delete camera_img;
+            throw;
+        }
+        if (camera_img) {
+            delete camera_img;
+        }
+
+        uint8_t *frame_data = NULL;
+        int frame_size = 0;
+        frame->get((void **)&frame_data, &frame_size);
+        uint64_t pts = frame->get_pts();
+        uint64_t dts = frame->get_dts();
+        uint8_t *stream_buffer = NULL;
+        if (frame_size > 0) {
+            stream_buffer = (uint8_t *)malloc(frame_size);
+            if (!stream_buffer) {
+                log::error("malloc failed!\r\n");
+                frame_size = 0;
+            } else {
+                memcpy(stream_buffer, frame_data, frame_size);
+            }
+        }
+        delete frame;
+
+        if (stream_buffer && _path.size() > 0) {
+            if (_video_type == VIDEO_ENC_H265_CBR) {
+                if (_fd < 0) {
+                    _fd = ::open((char *)_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0777);
+                    if (_fd < 0) {
+                        log::error("Open %s failed!\r\n", (char *)_path.c_str());
+                    }
+                }
+                if (_fd > 2 && ::write(_fd, stream_buffer, frame_size) != frame_size) {
+                    log::error("Write %s failed!\r\n", (char *)_path.c_str());
+                }
+            } else if (_mp4) {
+                err::Err e = _mp4->write(stream_buffer, frame_size, pts, dts);
+                if (e != err::ERR_NONE && e != err::ERR_NOT_READY) {
+                    log::error("Write mp4 failed, err = %d\r\n", e);
+                }
+            }
+        }
+        _last_pts = pts;
+        return new video::Packet(stream_buffer, frame_size, pts, dts);
     }
 
     image::Image *Video::decode(video::Frame *frame) {
@@ -118,7 +871,18 @@ namespace maix::video
     }
 
     err::Err Video::finish() {
-        throw err::Exception(err::ERR_NOT_IMPL);
-        return err::ERR_NOT_IMPL;
+        err::Err e = err::ERR_NONE;
+        if (this->_mp4) {
+            // index and duration are written in place, no remux needed
+            e = this->_mp4->finish();
+            delete this->_mp4;
+            this->_mp4 = nullptr;
+        }
+        if (this->_fd > 2) {
+            ::fsync(this->_fd);
+            ::close(this->_fd);
+            this->_fd = -1;
+        }
+        return e;
     }
 } // namespace maix::video
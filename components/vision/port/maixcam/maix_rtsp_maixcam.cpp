@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add write image.
  */
 
 #include "maix_rtsp.hpp"
@@ -132,6 +133,7 @@ namespace maix::rtsp
         this->_bind_camera = false;
         this->_is_start = false;
         this->_thread = NULL;
+        this->_param = NULL;
         this->_region_max_number = 16;
         for (int i = 0; i < this->_region_max_number; i ++) {
             this->_region_list.push_back(NULL);
@@ -160,6 +162,11 @@ namespace maix::rtsp
         for (auto &region : this->_region_list) {
             delete region;
         }
+
+        if (this->_param) {
+            delete (video::Encoder *)this->_param;
+            this->_param = NULL;
+        }
     }
 
     static void _camera_push_thread(void *args) {
@@ -288,6 +295,26 @@ namespace maix::rtsp
         return err;
     }
 
+    err::Err Rtsp::write(image::Image &img) {
+        video::Encoder *encoder = (video::Encoder *)this->_param;
+        if (!encoder) {
+            encoder = new video::Encoder(img.width(), img.height(), img.format(), video::VideoType::VIDEO_H265_CBR, this->_fps);
+            this->_param = encoder;
+        }
+
+        video::Frame *frame = encoder->encode(&img);
+        if (!frame) {
+            return err::ERR_RUNTIME;
+        }
+        err::Err err = err::ERR_NONE;
+        if (frame->size() > 0) {
+            this->update_timestamp();
+            rtsp_send_h265_data(this->get_timestamp(), frame->data(), frame->size());
+        }
+        delete frame;
+        return err;
+    }
+
     std::string Rtsp::get_url() {
         std::string real_ip = std::string(rtsp_get_server_ip());
         std::string real_port = std::to_string(rtsp_get_server_port());
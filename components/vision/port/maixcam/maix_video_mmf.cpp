@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Write mp4 with MP4Muxer instead of remuxing temporary file with ffmpeg.
  */
 
 
@@ -11,6 +12,7 @@
 #include "maix_image.hpp"
 #include "maix_time.hpp"
 #include "maix_video.hpp"
+#include "maix_video_mp4.hpp"
 #include "sophgo_middleware.hpp"
 #include <sys/ioctl.h>
 #include <sys/types.h>
@@ -29,7 +31,7 @@ namespace maix::video
     maix::image::Image *Encoder::NoneImage = NULL;
 #endif
 
-    Encoder::Encoder(int width, int height, image::Format format, VideoType type, int framerate, int gop, int bitrate, int time_base, bool capture) {
+    Encoder::Encoder(int width, int height, image::Format format, VideoType type, int framerate, int gop, int bitrate, int time_base, bool capture, int threads, bool low_latency) {
         _width = width;
         _height = height;
         _format = format;
@@ -44,6 +46,9 @@ namespace maix::video
         _bind_camera = NULL;
         _start_encode_ms = 0;
         _encode_started = false;
+        _threads = threads;             // hardware encoder, not used
+        _low_latency = low_latency;     // hardware encoder, not used
+        _param = NULL;
 
         switch (_type) {
         case VIDEO_H265_CBR:
@@ -534,8 +539,12 @@ _exit:
         return frame;
     }
 
-    Decoder::Decoder() {
-
+    Decoder::Decoder(video::VideoType type, image::Format format, int threads) {
+        _prepare_data = NULL;
+        _type = type;
+        _format = format;
+        _threads = threads;
+        _param = NULL;
     }
 
     Decoder::~Decoder() {
@@ -564,6 +573,7 @@ _exit:
         this->_is_recording = false;
         this->_camera = NULL;
         this->_fd = -1;
+        this->_mp4 = nullptr;
         this->_time_base = time_base;
         this->_framerate = framerate;
         this->_need_auto_config = true;
@@ -580,6 +590,10 @@ _exit:
     }
 
     Video::~Video() {
+        if (this->_mp4) {
+            delete this->_mp4;
+            this->_mp4 = nullptr;
+        }
         if (this->_is_opened) {
             this->close();
         }
@@ -674,12 +688,21 @@ _exit:
             _video_type = get_video_type(_path, true);
             err::check_bool_raise(_video_type != VIDEO_NONE, "Can't parse video type!");
             if (_video_type == VIDEO_ENC_MP4_CBR) {
-                system("rm _encode_video_tmp.h265 &> /dev/zero");
-                _tmp_path = "_encode_video_tmp.h265";
+                _record_start_ms = time::ticks_ms();
             }
             _need_auto_config = false;
         }
 
+        if (_video_type == VIDEO_ENC_MP4_CBR && !_mp4) {
+            // mp4 header use the size of frames pushed to encoder, not the size given to constructor
+            bool from_img = img && img->data() != NULL;
+            if (from_img || this->_bind_camera) {
+                int width = from_img ? img->width() : _camera->width();
+                int height = from_img ? img->height() : _camera->height();
+                _mp4 = new video::MP4Muxer(_path, _video_type, width, height, 1000, _framerate > 0 ? _framerate : 30);
+            }
+        }
+
         if (img && img->data() != NULL) {  // encode from image
             if (img->data_size() > 2560 * 1440 * 3 / 2) {
                 log::error("image is too large!\r\n");
@@ -800,25 +823,11 @@ _exit:
                     goto _exit;
                 }
 
-                if (_tmp_path.size() > 0) {
-                    if (_fd < 0) {
-                        _fd = ::open((char *)_tmp_path.c_str(), O_WRONLY | O_CREAT, 0777);
-                        if (_fd < 0) {
-                            log::error("Open %s failed!\r\n", (char *)_tmp_path.c_str());
-                            free(stream_buffer);
-                            stream_buffer = NULL;
-                            goto _exit;
-                        }
-                    }
-
-                    if (_fd > 2) {
-                        int res = 0;
-                        if ((res = write(_fd, stream_buffer, stream_size)) < 0) {
-                            log::error("Write failed, res = %d\r\n", res);
-                            free(stream_buffer);
-                            stream_buffer = NULL;
-                            goto _exit;
-                        }
+                if (_mp4) {
+                    uint64_t pts = time::ticks_ms() - _record_start_ms;
+                    err::Err e = _mp4->write(stream_buffer, stream_size, pts, pts);
+                    if (e != err::ERR_NONE && e != err::ERR_NOT_READY) {
+                        log::error("Write mp4 failed, err = %d\r\n", e);
                     }
                 }
             }
@@ -1031,25 +1040,11 @@ _retry_enc_mp4:
                     goto _retry_enc_mp4;
                 }
 
-                if (_tmp_path.size() > 0) {
-                    if (_fd < 0) {
-                        _fd = ::open((char *)_tmp_path.c_str(), O_WRONLY | O_CREAT, 0777);
-                        if (_fd < 0) {
-                            log::error("Open %s failed!\r\n", (char *)_tmp_path.c_str());
-                            free(stream_buffer);
-                            stream_buffer = NULL;
-                            goto _exit;
-                        }
-                    }
-
-                    if (_fd > 2) {
-                        int res = 0;
-                        if ((res = write(_fd, stream_buffer, stream_size)) < 0) {
-                            log::error("Write failed, res = %d\r\n", res);
-                            free(stream_buffer);
-                            stream_buffer = NULL;
-                            goto _exit;
-                        }
+                if (_mp4) {
+                    uint64_t pts = time::ticks_ms() - _record_start_ms;
+                    err::Err e = _mp4->write(stream_buffer, stream_size, pts, pts);
+                    if (e != err::ERR_NONE && e != err::ERR_NOT_READY) {
+                        log::error("Write mp4 failed, err = %d\r\n", e);
                     }
                 }
             }
@@ -1067,28 +1062,18 @@ _exit:
     }
 
     err::Err Video::finish() {
+        err::Err e = err::ERR_NONE;
+        if (this->_mp4) {
+            // index and duration are written in place, no remux needed
+            e = this->_mp4->finish();
+            delete this->_mp4;
+            this->_mp4 = nullptr;
+        }
         if (this->_fd > 2) {
             ::close(this->_fd);
-
-            switch (this->_video_type) {
-            case VIDEO_ENC_H265_CBR:
-                // do nothing
-                break;
-            case VIDEO_ENC_MP4_CBR:
-            {
-                char cmd[128];
-                snprintf(cmd, sizeof(cmd), "ffmpeg -loglevel quiet -i %s -c:v copy -c:a copy %s -y", this->_tmp_path.c_str(), this->_path.c_str());
-                system(cmd);
-
-                snprintf(cmd, sizeof(cmd), "rm %s", this->_tmp_path.c_str());
-                system(cmd);
-            }
-                break;
-            default:
-                log::error("%s not support\r\n", this->_video_type);
-            }
+            this->_fd = -1;
             system("sync");
         }
-        return err::ERR_NONE;
+        return e;
     }
 } // namespace maix::video
@@ -330,6 +330,13 @@ namespace maix::camera
         }
     }
 
+    err::Err Camera::set_zero_copy(bool enable, int max_hold)
+    {
+        if (_impl == NULL)
+            return err::ERR_NOT_INIT;
+        return _impl->set_zero_copy(enable, max_hold);
+    }
+
     void Camera::clear_buff()
     {
         if (_impl == NULL)
@@ -3,9 +3,18 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Resize, crop and rotate YVU420SP/YUV420SP on planes directly.
+ * @update 2026.10.18: Add derived image cache, invalidate cache when draw.
+ * @update 2026.10.18: Convert uncompressed formats in row bands on thread pool.
+ * @update 2026.10.18: Draw and measure text with glyph cache, add draw_strings.
+ * @update 2026.10.18: Composite draw_image with premultiplied alpha kernels.
  */
 
 #include "maix_image.hpp"
+#include "maix_image_yuv.hpp"
+#include "maix_image_text.hpp"
+#include "maix_image_blend.hpp"
+#include "maix_thread.hpp"
 #include "opencv2/opencv.hpp"
 #include "opencv2/freetype.hpp"
 #include <map>
@@ -22,6 +31,9 @@ namespace maix::image
 
     static void _get_cv_format_color(image::Format _format, const image::Color &color_in, int *ch_format, cv::Scalar &cv_color);
 
+    // min rows of one band when convert format in parallel
+    static const int _convert_grain = 16;
+
     static bool path_is_format(const std::string &str, const std::string ext)
     {
         std::string lower_path(str);
@@ -258,6 +270,10 @@ namespace maix::image
             log::error("load font failed\n");
             return err::ERR_ARGS;
         }
+        // glyph cache draw filled text and measure, ft2 draw outline text
+        err::Err e = text_load_font(name, path, size);
+        if (e != err::ERR_NONE)
+            return e;
         ft2->loadFontData(path, 0);
         fonts_info[name] = ft2;
         fonts_size_info[name] = size;
@@ -288,55 +304,24 @@ namespace maix::image
         return fonts;
     }
 
-    static void _get_text_size(cv::Size &size, const std::string &text, const std::string &font_name, int font_id, float scale, int thickness)
-    {
-        int baseLine = 0;
-        if (font_id == -1)
-        {
-            int font_height = fonts_size_info[font_name];
-            cv::Ptr<cv::freetype::FreeType2> ft2 = fonts_info[font_name];
-            if (ft2 == cv::Ptr<cv::freetype::FreeType2>())
-            {
-                log::error("font %d not load\n", font_name.c_str());
-                throw std::runtime_error("font not load");
-            }
-            size = ft2->getTextSize(text, scale * font_height, thickness, &baseLine);
-            if (thickness > 0)
-                baseLine += thickness;
-            size.height = size.height + baseLine;
-        }
-        else
-        {
-            size = cv::getTextSize(text, font_id, scale, thickness > 0 ? thickness : -thickness, &baseLine);
-            baseLine += baseLine > 0 ? 0 : -thickness;
-            size.height += baseLine;
-        }
-    }
-
-    static void _put_text(cv::Mat &img, const std::string &text, const cv::Point &point,
+    static void _put_text(cv::Mat &img, TextRender &render, const std::string &text, const cv::Point &point,
                           const cv::Scalar &color, float scale, int thickness, const std::string &font_name, int font_id)
     {
-        if (font_id == -1)
+        if (TextRender::can_draw(font_id, thickness))
         {
-            cv::Ptr<cv::freetype::FreeType2> ft2 = fonts_info[font_name];
-            if (ft2 == cv::Ptr<cv::freetype::FreeType2>())
-            {
-                log::error("font %d not load\n", font_name.c_str());
-                throw std::runtime_error("font not load");
-            }
-            // point from left top to left center
-            const std::string text_tmp(text, 0, 1);
-            cv::Point point_tmp(point.x, point.y + ft2->getTextSize(text, scale * fonts_size_info[font_name], thickness, nullptr).height);
-            ft2->putText(img, text, point_tmp, scale * fonts_size_info[font_name], color, thickness, cv::LINE_AA, true);
+            render.draw(img, text, point, color);
+            return;
         }
-        else
+        // FreeType outline text
+        cv::Ptr<cv::freetype::FreeType2> ft2 = fonts_info[font_name];
+        if (ft2 == cv::Ptr<cv::freetype::FreeType2>())
         {
-            // left top corner to point left bottom corner by first char height
-            const std::string text_tmp(text, 0, 1);
-            int baseLine = 0;
-            cv::Point point_tmp(point.x, point.y + cv::getTextSize(text_tmp, font_id, scale, thickness > 0 ? thickness : -thickness, &baseLine).height);
-            cv::putText(img, text, point_tmp, font_id, scale, color, thickness > 0 ? thickness : -thickness, cv::LINE_AA, false);
+            log::error("font %s not load\n", font_name.c_str());
+            throw std::runtime_error("font not load");
         }
+        // point from left top to left center
+        cv::Point point_tmp(point.x, point.y + ft2->getTextSize(text, scale * fonts_size_info[font_name], thickness, nullptr).height);
+        ft2->putText(img, text, point_tmp, scale * fonts_size_info[font_name], color, thickness, cv::LINE_AA, true);
     }
 
     void Image::_create_image(int width, int height, image::Format format, uint8_t *data, int data_size, bool copy)
@@ -364,11 +349,11 @@ namespace maix::image
 
         if (!data)
         {
-            _actual_data = malloc(_data_size + 0x1000);
+            // 4096 bytes aligned buffer from pool
+            _actual_data = image::buffer_pool().alloc(_data_size);
             if (!_actual_data)
                 throw err::Exception(err::ERR_NO_MEM, "malloc image data failed");
-            _data = (void *)(((uint64_t)_actual_data + 0x1000) & ~0xFFF);
-            // log::debug("malloc image data\n");
+            _data = _actual_data;
             _is_malloc = true;
         }
         else
@@ -381,12 +366,11 @@ namespace maix::image
             }
             else
             {
-                _actual_data = malloc(_data_size + 0x1000);
+                _actual_data = image::buffer_pool().alloc(_data_size);
                 if (!_actual_data)
                     throw std::bad_alloc();
-                _data = (void *)(((uint64_t)_actual_data + 0x1000) & ~0xFFF);
+                _data = _actual_data;
                 memcpy(_data, data, _data_size);
-                // log::debug("malloc image data\n");
                 _is_malloc = true;
             }
         }
@@ -408,12 +392,35 @@ namespace maix::image
         // _create_image(width, height, format, data->data, data->size(), copy);
     }
 
+    Image::Image(const image::Image &img)
+    {
+        // deep copy, _release_cb stays with img, or borrowed buffer will be given back twice
+        _release_cb = nullptr;
+        if (!img._data)
+        {
+            _width = 0;
+            _height = 0;
+            _format = image::Format::FMT_INVALID;
+            _actual_data = nullptr;
+            _data = nullptr;
+            _data_size = 0;
+            _is_malloc = false;
+            return;
+        }
+        _create_image(img._width, img._height, img._format, (uint8_t *)img._data, img._data_size, true);
+    }
+
     Image::~Image()
     {
+        _free_cache();
+        if (_release_cb)
+        {
+            _release_cb(_data);
+            _release_cb = nullptr;
+        }
         if (_is_malloc)
         {
-            // log::debug("free image data\n");
-            free(_actual_data);
+            image::buffer_pool().free(_actual_data, _data_size);
             _actual_data = NULL;
             _data = NULL;
         }
@@ -421,10 +428,15 @@ namespace maix::image
 
     err::Err Image::update(int width, int height, image::Format format, uint8_t *data, int data_size, bool copy)
     {
+        invalidate_cache();
+        if (_release_cb)
+        {
+            _release_cb(_data);
+            _release_cb = nullptr;
+        }
         if (_actual_data && _is_malloc)
         {
-            // log::debug("free image data\n");
-            free(_actual_data);
+            image::buffer_pool().free(_actual_data, _data_size);
             _actual_data = NULL;
             _data = NULL;
         }
@@ -434,13 +446,9 @@ namespace maix::image
 
     void Image::operator=(const image::Image &img)
     {
-        _format = img._format;
-        _width = img._width;
-        _height = img._height;
-        _data = malloc(_width * _height * image::fmt_size[_format]);
-        if (!_data)
-            throw std::bad_alloc();
-        memcpy(_data, img._data, _width * _height * image::fmt_size[_format]);
+        if (this == &img)
+            return;
+        update(img._width, img._height, img._format, (uint8_t *)img._data, img._data_size, true);
     }
 
     std::string Image::__str__()
@@ -899,18 +907,21 @@ namespace maix::image
             if (uv_temp)
                 free(uv_temp);
         } else if (_format == image::FMT_RGB888 && format == image::FMT_GRAYSCALE) {
-            int height = _width;
-            int width = _height;
+            int width = _width;
             uint8_t *src = (uint8_t *)_data;
             uint8_t *dst = (uint8_t *)img->data();
-            for (int i = 0; i < height; i ++) {
-                for (int j = 0; j < width; j ++) {
-                    dst[i * width + j] = (src[(i * width + j) * 3 + 0] * 38 + src[(i * width + j) * 3 + 1] * 75 + src[(i * width + j) * 3 + 2] * 15) >> 7;
+            thread::parallel_for(0, _height, [width, src, dst](int y_begin, int y_end) {
+                for (int i = y_begin * width; i < y_end * width; i ++) {
+                    dst[i] = (src[i * 3 + 0] * 38 + src[i * 3 + 1] * 75 + src[i * 3 + 2] * 15) >> 7;
                 }
-            }
+            }, _convert_grain);
         } else {
             cv::Mat dst(src.rows, src.cols, CV_8UC((int)image::fmt_size[format]), img->data());
-            cv::cvtColor(src, dst, cvt_code);
+            // pixel wise conversion, so convert row bands in parallel, every band writes its own rows of dst
+            thread::parallel_for(0, src.rows, [&src, &dst, cvt_code](int y_begin, int y_end) {
+                cv::Mat dst_rows = dst.rowRange(y_begin, y_end);
+                cv::cvtColor(src.rowRange(y_begin, y_end), dst_rows, cvt_code);
+            }, _convert_grain);
         }
 
         return img;
@@ -1007,86 +1018,16 @@ namespace maix::image
         return nullptr;
     }
 
-    image::Image *Image::draw_image(int x, int y, image::Image &img)
+    image::Image *Image::draw_image(int x, int y, image::Image &img, image::BlendMode mode, float alpha)
     {
-        image::Format fmt = img.format();
-        if (!(fmt == image::FMT_GRAYSCALE || fmt == image::FMT_RGB888 || fmt == image::FMT_BGR888 ||
-              fmt == image::FMT_RGBA8888 || fmt == image::FMT_BGRA8888))
-            throw std::runtime_error("image format not support");
-        // check format
-        if (image::fmt_size[img.format()] > image::fmt_size[_format])
-            throw std::runtime_error("image format not match");
-        cv::Mat src(img.height(), img.width(), CV_8UC((int)image::fmt_size[img.format()]), img.data());
-        cv::Mat dst(_height, _width, CV_8UC((int)image::fmt_size[_format]), _data);
-        cv::Rect rect(x, y, img.width(), img.height());
-        if (_format == fmt && image::fmt_size[fmt] < 4)
-        {
-            src.copyTo(dst(rect));
-        }
-        else
-        {
-            // convert format
-            bool img_alloc = false;
-            image::Image *img_new = nullptr;
-            if (_format != fmt)
-            {
-                img_new = img.to_format(_format);
-                if (!img_new)
-                {
-                    return img_new;
-                }
-                img_alloc = true;
-            }
-            else
-                img_new = &img;
-            cv::Mat src_new(img_new->height(), img_new->width(), CV_8UC((int)image::fmt_size[_format]), img_new->data());
-            if (image::fmt_size[_format] < 4)
-            {
-                src_new.copyTo(dst(rect));
-            }
-            else // merge two BGRA images
-            {
-                for (int y = 0; y < src_new.rows; y++)
-                {
-                    if(y + rect.y >= dst.rows)
-                        break;
-                    for (int x = 0; x < src_new.cols; x++)
-                    {
-                        if(x + rect.x >= dst.cols)
-                            break;
-                        cv::Vec4b &pixel = src_new.at<cv::Vec4b>(y, x);
-                        // ignore transparent pixel
-                        if (pixel[3] == 0)
-                            continue;
-                        cv::Vec4b &pixel_dst = dst.at<cv::Vec4b>(y + rect.y, x + rect.x);
-                        // alpha is 255, just copy
-                        if (pixel[3] == 255)
-                        {
-                            pixel_dst[0] = pixel[0];
-                            pixel_dst[1] = pixel[1];
-                            pixel_dst[2] = pixel[2];
-                            pixel_dst[3] = pixel[3];
-                        }
-                        // alpha > 0 and < 255, blend
-                        else
-                        {
-                            // TODO: optimize blend algorithm
-                            pixel_dst[0] = (uint32_t)((pixel[0] * pixel[3] + pixel_dst[0] * (255 - pixel[3]))) >> 8;
-                            pixel_dst[1] = (uint32_t)((pixel[1] * pixel[3] + pixel_dst[1] * (255 - pixel[3]))) >> 8;
-                            pixel_dst[2] = (uint32_t)((pixel[2] * pixel[3] + pixel_dst[2] * (255 - pixel[3]))) >> 8;
-                            pixel_dst[3] = 255 - (255 - pixel[3]) * (255 - pixel_dst[3]);
-                        }
-                    }
-                }
-            }
-            if (img_alloc)
-                delete img_new;
-        }
+        invalidate_cache();
+        image::blend_image(*this, x, y, img, mode, alpha);
         return this;
     }
 
     image::Image *Image::draw_rect(int x, int y, int w, int h, const image::Color &color, int thickness)
     {
+        invalidate_cache();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1105,6 +1046,7 @@ namespace maix::image
 
     image::Image *Image::draw_line(int x1, int y1, int x2, int y2, const image::Color &color, int thickness)
     {
+        invalidate_cache();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1115,6 +1057,7 @@ namespace maix::image
 
     image::Image *Image::draw_circle(int x, int y, int radius, const image::Color &color, int thickness)
     {
+        invalidate_cache();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1125,6 +1068,7 @@ namespace maix::image
 
     image::Image *Image::draw_ellipse(int x, int y, int a, int b, float angle, float start_angle, float end_angle, const image::Color &color, int thickness)
     {
+        invalidate_cache();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1136,6 +1080,7 @@ namespace maix::image
     image::Image *image::Image::draw_string(int x, int y, const std::string &text, const image::Color &color, float scale, int thickness,
                                           bool wrap, int wrap_space, const std::string &font)
     {
+        invalidate_cache();
         int ch_format = 0;
         cv::Scalar cv_color;
         add_default_fonts(fonts_info);
@@ -1156,15 +1101,16 @@ namespace maix::image
             final_font = &font;
             final_font_id = get_default_fonts_id(font);
         }
+        // lock glyph cache once for all lines and measurements
+        TextRender render(*final_font, final_font_id, scale, thickness);
         // auto wrap if text width > image width
         if (!wrap)
         {
-            _put_text(img, text, point, cv_color, scale, thickness, *final_font, final_font_id);
+            _put_text(img, render, text, point, cv_color, scale, thickness, *final_font, final_font_id);
         }
         else
         {
-            cv::Size size;
-            _get_text_size(size, text, *final_font, final_font_id, scale, thickness);
+            cv::Size size = render.size(text);
             int text_width = size.width;
             int text_height = size.height;
             int text_max_width = _width - x;
@@ -1208,7 +1154,7 @@ namespace maix::image
                     }
                     if(wrap_now)
                     {
-                        _put_text(img, text_tmp, point, cv_color, scale, thickness, *final_font, final_font_id);
+                        _put_text(img, render, text_tmp, point, cv_color, scale, thickness, *final_font, final_font_id);
                         point.x = x;
                         point.y += text_height + wrap_space;
                         text_tmp.clear();
@@ -1219,15 +1165,14 @@ namespace maix::image
                     }
                     char_size = _get_char_size(c);
                     text_tmp += text.substr(idx, char_size);
-                    cv::Size size_tmp;
-                    _get_text_size(size_tmp, text_tmp, *final_font, final_font_id, scale, thickness);
+                    cv::Size size_tmp = render.size(text_tmp);
                     if (size_tmp.width >= text_max_width)
                     {
                         if (size_tmp.width > text_max_width)
                         {
                             text_tmp.erase(text_tmp.length() - char_size, char_size);
                         }
-                        _put_text(img, text_tmp, point, cv_color, scale, thickness, *final_font, final_font_id);
+                        _put_text(img, render, text_tmp, point, cv_color, scale, thickness, *final_font, final_font_id);
                         point.x = x;
                         point.y += text_height + wrap_space;
                         text_tmp.clear();
@@ -1241,19 +1186,57 @@ namespace maix::image
                 // draw last line
                 if (!text_tmp.empty())
                 {
-                    _put_text(img, text_tmp, point, cv_color, scale, thickness, *final_font, final_font_id);
+                    _put_text(img, render, text_tmp, point, cv_color, scale, thickness, *final_font, final_font_id);
                 }
             }
             else
             {
-                _put_text(img, text, point, cv_color, scale, thickness, *final_font, final_font_id);
+                _put_text(img, render, text, point, cv_color, scale, thickness, *final_font, final_font_id);
             }
         }
         return this;
     }
 
+    image::Image *Image::draw_strings(const std::vector<int> &points, const std::vector<std::string> &texts, const std::vector<image::Color> &colors,
+                                      float scale, int thickness, const std::string &font)
+    {
+        if (points.size() != texts.size() * 2)
+            throw err::Exception(err::ERR_ARGS, "points size should be 2 * texts size");
+        if (colors.size() != 1 && colors.size() != texts.size())
+            throw err::Exception(err::ERR_ARGS, "colors size should be 1 or texts size");
+        if (texts.empty())
+            return this;
+        invalidate_cache();
+        add_default_fonts(fonts_info);
+        const std::string *final_font = &curr_font_name;
+        int final_font_id = curr_font_id;
+        if (!font.empty())
+        {
+            if (fonts_info.find(font) == fonts_info.end())
+            {
+                log::error("font %s not load\n", font.c_str());
+                throw std::runtime_error("font not load");
+            }
+            final_font = &font;
+            final_font_id = get_default_fonts_id(font);
+        }
+        int ch_format = 0;
+        std::vector<cv::Scalar> cv_colors(colors.size());
+        for (size_t i = 0; i < colors.size(); ++i)
+            _get_cv_format_color(_format, colors[i], &ch_format, cv_colors[i]);
+        cv::Mat img(_height, _width, ch_format, _data);
+        TextRender render(*final_font, final_font_id, scale, thickness);
+        for (size_t i = 0; i < texts.size(); ++i)
+        {
+            _put_text(img, render, texts[i], cv::Point(points[i * 2], points[i * 2 + 1]), cv_colors[cv_colors.size() == 1 ? 0 : i],
+                      scale, thickness, *final_font, final_font_id);
+        }
+        return this;
+    }
+
     image::Image *Image::draw_cross(int x, int y, const image::Color &color, int size, int thickness)
     {
+        invalidate_cache();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1265,6 +1248,7 @@ namespace maix::image
 
     image::Image *Image::draw_arrow(int x0, int y0, int x1, int y1, const image::Color &color, int thickness)
     {
+        invalidate_cache();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1277,6 +1261,7 @@ namespace maix::image
 
     image::Image *Image::draw_edges(std::vector<std::vector<int>> corners, const image::Color &color, int size, int thickness, bool fill)
     {
+        invalidate_cache();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1300,6 +1285,7 @@ namespace maix::image
 
     image::Image *Image::draw_keypoints(std::vector<int> keypoints, const image::Color &color, int size, int thickness)
     {
+        invalidate_cache();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1322,76 +1308,93 @@ namespace maix::image
 
     image::Image *Image::resize(int width, int height, image::Fit object_fit, image::ResizeMethod method)
     {
+        /// calculate size if width or height is -1
+        if (width == -1)
+        {
+            width = height * _width / _height;
+        }
+        else if (height == -1)
+        {
+            height = width * _height / _width;
+        }
+        if (_format == image::FMT_YVU420SP || _format == image::FMT_YUV420SP)
+        {
+            // chroma is subsampled, so size should be even
+            if ((width & 1) || (height & 1))
+            {
+                log::warn("yuv420sp image size should be even, resize to %dx%d instead of %dx%d\n", width & ~1, height & ~1, width, height);
+                width &= ~1;
+                height &= ~1;
+            }
+            if (method != image::ResizeMethod::NEAREST && method != image::ResizeMethod::BILINEAR)
+            {
+                // other methods only for RGB, convert to RGB and back
+                cv::Mat yuv(_height * 3 / 2, _width, CV_8UC1, _data);
+                image::Image rgb(_width, _height, image::FMT_RGB888);
+                cv::Mat rgb_mat(_height, _width, CV_8UC3, rgb.data());
+                cv::cvtColor(yuv, rgb_mat, _format == image::FMT_YVU420SP ? cv::COLOR_YUV2RGB_NV21 : cv::COLOR_YUV2RGB_NV12);
+                image::Image *resized = rgb.resize(width, height, object_fit, method);
+                image::Image *ret = new image::Image(width, height, _format);
+                cv::Mat resized_mat(height, width, CV_8UC3, resized->data());
+                cv::Mat dst(height * 3 / 2, width, CV_8UC1, ret->data());
+                _cv_rgb_nv21(resized_mat, dst, width, height);
+                delete resized;
+                if (_format == image::FMT_YUV420SP)
+                {
+                    uint8_t *uv = (uint8_t *)ret->data() + width * height;
+                    for (int i = 0; i < width * height / 2; i += 2)
+                        std::swap(uv[i], uv[i + 1]);
+                }
+                return ret;
+            }
+            // resize Y and VU planes directly
+            image::Image *ret = new image::Image(width, height, _format);
+            err::Err e = image::yuv420sp_resize(*this, *ret, object_fit, method);
+            if (e != err::ERR_NONE)
+            {
+                delete ret;
+                throw err::Exception(e, "resize yuv420sp image failed");
+            }
+            return ret;
+        }
         int pixel_num = 0;
-        int cv_h = 0;
-        int cv_dst_h = 0;
         switch (_format)
         {
         case image::FMT_RGB888:
         case image::FMT_BGR888:
             pixel_num = CV_8UC3;
-            cv_h = _height;
-            cv_dst_h = height;
             break;
         case image::FMT_GRAYSCALE:
             pixel_num = CV_8UC1;
-            cv_h = _height;
-            cv_dst_h = height;
             break;
         case image::FMT_BGRA8888:
         case image::FMT_RGBA8888:
             pixel_num = CV_8UC4;
-            cv_h = _height;
-            cv_dst_h = height;
             break;
         case image::FMT_RGB565:
         case image::FMT_BGR565:
             pixel_num = CV_8UC2;
-            cv_h = _height;
-            cv_dst_h = height;
-            break;
-        case image::FMT_YVU420SP:
-            pixel_num = CV_8UC1;
-            cv_h = _height + _height / 2;
-            cv_dst_h = height + height / 2;
             break;
         default:
             throw std::runtime_error("not support format");
             break;
         }
-        /// calculate size if width or height is -1
-        if (width == -1)
-        {
-            width = height * _width / _height;
-        }
-        else if (height == -1)
-        {
-            height = width * _height / _width;
-        }
         image::Image *ret = new image::Image(width, height, _format);
 
-        cv::Mat img(cv_h, _width, pixel_num, _data);
+        cv::Mat img(_height, _width, pixel_num, _data);
         cv::Mat dst;
         cv::InterpolationFlags inter_method = (cv::InterpolationFlags)method;
         if (object_fit == image::Fit::FIT_FILL)
         {
-            if (_format == image::FMT_YVU420SP) {
-                cv::Mat rgb, resize_rgb;
-                cv::cvtColor(img, rgb, cv::COLOR_YUV2RGB_NV21);
-                cv::resize(rgb, resize_rgb, cv::Size(width, height), 0, 0, inter_method);
-                dst = cv::Mat(cv_dst_h, width, pixel_num, ret->data());
-                _cv_rgb_nv21(resize_rgb, dst, width, height);
-            } else {
-                dst = cv::Mat(height, width, pixel_num, ret->data());
-                cv::resize(img, dst, cv::Size(width, height), 0, 0, inter_method);
-            }
+            dst = cv::Mat(height, width, pixel_num, ret->data());
+            cv::resize(img, dst, cv::Size(width, height), 0, 0, inter_method);
         }
         else if (object_fit == image::Fit::FIT_CONTAIN)
         {
             cv::Mat tmp;
             float scale = std::min((float)width / _width, (float)height / _height);
             cv::resize(img, tmp, cv::Size(), scale, scale, inter_method);
-            dst = cv::Mat(cv_dst_h, width, pixel_num, ret->data());
+            dst = cv::Mat(height, width, pixel_num, ret->data());
             cv::Rect rect((width - tmp.cols) / 2, (height - tmp.rows) / 2, tmp.cols, tmp.rows);
             tmp.copyTo(dst(rect));
             // fill black color
@@ -1437,7 +1440,7 @@ namespace maix::image
             cv::Mat tmp;
             float scale = std::max((float)width / _width, (float)height / _height);
             cv::resize(img, tmp, cv::Size(), scale, scale, inter_method);
-            dst = cv::Mat(cv_dst_h, width, pixel_num, ret->data());
+            dst = cv::Mat(height, width, pixel_num, ret->data());
             cv::Rect rect((tmp.cols - width) / 2, (tmp.rows - height) / 2, width, height);
             tmp(rect).copyTo(dst);
         }
@@ -1492,6 +1495,16 @@ namespace maix::image
     {
         image::Image *ret = new image::Image(w, h, _format);
         ;
+        if (_format == image::FMT_YVU420SP || _format == image::FMT_YUV420SP)
+        {
+            err::Err e = image::yuv420sp_crop(*this, *ret, x, y);
+            if (e != err::ERR_NONE)
+            {
+                delete ret;
+                throw err::Exception(e, "crop yuv420sp image failed");
+            }
+            return ret;
+        }
         int pixel_num = _get_cv_pixel_num(_format);
         cv::Mat img(_height, _width, pixel_num, _data);
         cv::Mat dst(h, w, pixel_num, ret->data());
@@ -1502,6 +1515,23 @@ namespace maix::image
 
     image::Image *Image::rotate(float angle, int width, int height, image::ResizeMethod method)
     {
+        if (_format == image::FMT_YVU420SP || _format == image::FMT_YUV420SP)
+        {
+            // only multiple of 90 degrees, move pixels of Y and VU planes directly
+            bool swap = fmodf(fabsf(angle), 180) == 90;
+            int w = swap ? _height : _width;
+            int h = swap ? _width : _height;
+            if (fmodf(angle, 90) != 0 || (width >= 0 && width != w) || (height >= 0 && height != h))
+                throw err::Exception(err::ERR_NOT_IMPL, "yuv420sp image only support rotate multiple of 90 degrees without resize");
+            image::Image *ret = new image::Image(w, h, _format);
+            err::Err e = image::yuv420sp_rotate(*this, *ret, (int)angle);
+            if (e != err::ERR_NONE)
+            {
+                delete ret;
+                throw err::Exception(e, "rotate yuv420sp image failed");
+            }
+            return ret;
+        }
         int pixel_num = _get_cv_pixel_num(_format);
         if (width < 0 && height < 0)
         {
@@ -1673,8 +1703,7 @@ namespace maix::image
             final_font = &font;
             final_font_id = get_default_fonts_id(font);
         }
-        cv::Size size;
-        _get_text_size(size, text, *final_font, final_font_id, scale, thickness);
+        cv::Size size = TextRender(*final_font, final_font_id, scale, thickness).size(text);
         return Size(size.width, size.height);
     }
 
@@ -0,0 +1,493 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#include "maix_image_blend.hpp"
+#include "maix_thread.hpp"
+#include <string.h>
+#include <algorithm>
+
+namespace maix::image
+{
+    typedef uint8_t v16u8 __attribute__((vector_size(16)));
+    typedef uint16_t v16u16 __attribute__((vector_size(32)));
+
+    // rows of one band when blend image in parallel, multiple of subsample
+    static const int _blend_band = 16;
+
+    static void _set_plane(blend_plane_t &plane, int offset, int stride, int bpp, int sub_x, int sub_y, const int *chan)
+    {
+        plane.offset = offset;
+        plane.stride = stride;
+        plane.bpp = bpp;
+        plane.sub_x = sub_x;
+        plane.sub_y = sub_y;
+        for (int i = 0; i < bpp; ++i)
+            plane.chan[i] = chan[i];
+    }
+
+    bool blend_get_layout(image::Format format, int width, int height, blend_layout_t &layout)
+    {
+        static const int gray[] = {0};
+        static const int rgb[] = {0, 1, 2};
+        static const int bgr[] = {2, 1, 0};
+        static const int rgba[] = {0, 1, 2, 3};
+        static const int bgra[] = {2, 1, 0, 3};
+        static const int uv[] = {1, 2};
+        static const int vu[] = {2, 1};
+        static const int u[] = {1};
+        static const int v[] = {2};
+        int cw = (width + 1) / 2;
+        int ch = (height + 1) / 2;
+        int y_size = width * height;
+        layout.alpha = false;
+        switch (format)
+        {
+        case image::FMT_GRAYSCALE:
+            layout.space = BLEND_SPACE_GRAY;
+            layout.num = 1;
+            _set_plane(layout.planes[0], 0, width, 1, 1, 1, gray);
+            return true;
+        case image::FMT_RGB888:
+        case image::FMT_BGR888:
+            layout.space = BLEND_SPACE_RGB;
+            layout.num = 1;
+            _set_plane(layout.planes[0], 0, width * 3, 3, 1, 1, format == image::FMT_RGB888 ? rgb : bgr);
+            return true;
+        case image::FMT_RGBA8888:
+        case image::FMT_BGRA8888:
+            layout.space = BLEND_SPACE_RGB;
+            layout.num = 1;
+            layout.alpha = true;
+            _set_plane(layout.planes[0], 0, width * 4, 4, 1, 1, format == image::FMT_RGBA8888 ? rgba : bgra);
+            return true;
+        default:
+            break;
+        }
+        layout.space = BLEND_SPACE_YUV;
+        _set_plane(layout.planes[0], 0, width, 1, 1, 1, gray);
+        switch (format)
+        {
+        case image::FMT_YUV422SP:
+            layout.num = 2;
+            _set_plane(layout.planes[1], y_size, cw * 2, 2, 2, 1, uv);
+            return true;
+        case image::FMT_YUV422P:
+            layout.num = 3;
+            _set_plane(layout.planes[1], y_size, cw, 1, 2, 1, u);
+            _set_plane(layout.planes[2], y_size + cw * height, cw, 1, 2, 1, v);
+            return true;
+        case image::FMT_YVU420SP:
+        case image::FMT_YUV420SP:
+            layout.num = 2;
+            _set_plane(layout.planes[1], y_size, cw * 2, 2, 2, 2, format == image::FMT_YVU420SP ? vu : uv);
+            return true;
+        case image::FMT_YVU420P:
+        case image::FMT_YUV420P:
+            layout.num = 3;
+            _set_plane(layout.planes[1], y_size, cw, 1, 2, 2, format == image::FMT_YVU420P ? v : u);
+            _set_plane(layout.planes[2], y_size + cw * ch, cw, 1, 2, 2, format == image::FMT_YVU420P ? u : v);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    static inline uint8_t _clamp(int v)
+    {
+        return v < 0 ? 0 : (v > 255 ? 255 : v);
+    }
+
+    static inline int _div255(int v)
+    {
+        v += 128;
+        return (v + (v >> 8)) >> 8;
+    }
+
+    // in place, 32 bytes vector argument or return value changes ABI without AVX
+    static inline void _div255_v(v16u16 &v)
+    {
+        v += 128;
+        v = (v + (v >> 8)) >> 8;
+    }
+
+    /**
+     * Convert canonical pixel between color spaces, BT.601 limited range for YUV, same as OpenCV
+     */
+    static inline void _convert_space(uint8_t *px, int from, int to)
+    {
+        int c0 = px[0], c1 = px[1], c2 = px[2];
+        if (from == BLEND_SPACE_GRAY)
+        {
+            if (to == BLEND_SPACE_RGB)
+                px[1] = px[2] = c0;
+            else
+                px[1] = px[2] = 128; // gray as Y, same as to_format
+        }
+        else if (from == BLEND_SPACE_RGB)
+        {
+            if (to == BLEND_SPACE_GRAY)
+                px[0] = (c0 * 38 + c1 * 75 + c2 * 15) >> 7; // same as to_format
+            else
+            {
+                px[0] = ((66 * c0 + 129 * c1 + 25 * c2 + 128) >> 8) + 16;
+                px[1] = ((-38 * c0 - 74 * c1 + 112 * c2 + 128) >> 8) + 128;
+                px[2] = ((112 * c0 - 94 * c1 - 18 * c2 + 128) >> 8) + 128;
+            }
+        }
+        else if (to == BLEND_SPACE_RGB)
+        {
+            int y = c0 > 16 ? (c0 - 16) * 298 : 0;
+            int u = c1 - 128, v = c2 - 128;
+            px[0] = _clamp((y + 409 * v + 128) >> 8);
+            px[1] = _clamp((y - 100 * u - 208 * v + 128) >> 8);
+            px[2] = _clamp((y + 516 * u + 128) >> 8);
+        }
+        // YUV to gray is Y
+    }
+
+    /**
+     * Read w pixels from (x, y) of src to 4 bytes canonical pixels in color space, alpha is multiplied by alpha / 255
+     */
+    static void _read_row(image::Image &src, const blend_layout_t &layout, int x, int y, int w, int space, int alpha, uint8_t *out)
+    {
+        const uint8_t *data = (const uint8_t *)src.data();
+        if (!layout.alpha)
+        {
+            for (int i = 0; i < w; ++i)
+                out[i * 4 + 3] = 255;
+        }
+        for (int i = 0; i < layout.num; ++i)
+        {
+            const blend_plane_t &plane = layout.planes[i];
+            const uint8_t *row = data + plane.offset + y / plane.sub_y * plane.stride;
+            int bpp = plane.bpp;
+            if (plane.sub_x == 1)
+            {
+                row += x * bpp;
+                const int *chan = plane.chan;
+                if (bpp == 1)
+                {
+                    for (int j = 0; j < w; ++j)
+                        out[j * 4 + chan[0]] = row[j];
+                }
+                else if (bpp == 3)
+                {
+                    const int c0 = chan[0], c1 = chan[1], c2 = chan[2];
+                    for (int j = 0; j < w; ++j, row += 3)
+                    {
+                        out[j * 4 + c0] = row[0];
+                        out[j * 4 + c1] = row[1];
+                        out[j * 4 + c2] = row[2];
+                    }
+                }
+                else if (chan[0] == 0) // RGBA8888, the same as canonical pixel
+                    memcpy(out, row, w * 4);
+                else
+                {
+                    for (int j = 0; j < w; ++j, row += 4)
+                    {
+                        out[j * 4] = row[2];
+                        out[j * 4 + 1] = row[1];
+                        out[j * 4 + 2] = row[0];
+                        out[j * 4 + 3] = row[3];
+                    }
+                }
+            }
+            else
+            {
+                for (int j = 0; j < w; ++j)
+                {
+                    const uint8_t *p = row + (x + j) / plane.sub_x * bpp;
+                    for (int k = 0; k < bpp; ++k)
+                        out[j * 4 + plane.chan[k]] = p[k];
+                }
+            }
+        }
+        if (layout.space != space)
+        {
+            for (int i = 0; i < w; ++i)
+                _convert_space(out + i * 4, layout.space, space);
+        }
+        if (alpha < 255)
+        {
+            for (int i = 0; i < w; ++i)
+                out[i * 4 + 3] = _div255(out[i * 4 + 3] * alpha);
+        }
+    }
+
+    /**
+     * p = p * a / 255, rounded
+     */
+    static void _premultiply(uint8_t *p, const uint8_t *a, int n)
+    {
+        int i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            v16u8 p8, a8;
+            memcpy(&p8, p + i, 16);
+            memcpy(&a8, a + i, 16);
+            v16u16 v = __builtin_convertvector(p8, v16u16) * __builtin_convertvector(a8, v16u16);
+            _div255_v(v);
+            p8 = __builtin_convertvector(v, v16u8);
+            memcpy(p + i, &p8, 16);
+        }
+        for (; i < n; ++i)
+            p[i] = _div255(p[i] * a[i]);
+    }
+
+    void blend_prepare(image::Image &src, int x, int y, int w, int h, image::Format dst_format, float alpha, blend_premul_t &out)
+    {
+        blend_layout_t src_layout;
+        if (!blend_get_layout(src.format(), src.width(), src.height(), src_layout))
+            throw err::Exception(err::ERR_NOT_IMPL, "blend not support source format " + image::fmt_names[src.format()]);
+        if (!blend_get_layout(dst_format, w, h, out.layout))
+            throw err::Exception(err::ERR_NOT_IMPL, "blend not support format " + image::fmt_names[dst_format]);
+        out.w = w;
+        out.h = h;
+        int a = _clamp((int)(alpha * 255 + 0.5f));
+        int space = out.layout.space;
+        static thread_local std::vector<uint8_t> rows;
+        rows.resize(w * 4 * 2);
+        for (int i = 0; i < out.layout.num; ++i)
+        {
+            const blend_plane_t &plane = out.layout.planes[i];
+            int bpp = plane.bpp;
+            int pw = (w + plane.sub_x - 1) / plane.sub_x;
+            int ph = (h + plane.sub_y - 1) / plane.sub_y;
+            int n = pw * bpp;
+            out.p[i].resize(n * ph);
+            out.a[i].resize(n * ph);
+            for (int r = 0; r < ph; ++r)
+            {
+                uint8_t *P = out.p[i].data() + r * n;
+                uint8_t *A = out.a[i].data() + r * n;
+                int num_rows = std::min(plane.sub_y, h - r * plane.sub_y);
+                for (int j = 0; j < num_rows; ++j)
+                    _read_row(src, src_layout, x, y + r * plane.sub_y + j, w, space, a, rows.data() + j * w * 4);
+                if (plane.sub_x == 1 && plane.sub_y == 1)
+                {
+                    const uint8_t *px = rows.data();
+                    const int c0 = plane.chan[0], c1 = bpp > 1 ? plane.chan[1] : 0, c2 = bpp > 1 ? plane.chan[2] : 0;
+                    for (int j = 0; j < w; ++j, px += 4, P += bpp, A += bpp)
+                    {
+                        uint8_t a = px[3];
+                        P[0] = px[c0];
+                        A[0] = a;
+                        if (bpp == 1)
+                            continue;
+                        P[1] = px[c1];
+                        P[2] = px[c2];
+                        A[1] = A[2] = a;
+                        if (bpp == 4) // alpha channel of RGBA8888 and BGRA8888
+                        {
+                            P[3] = 255;
+                            A[3] = a;
+                        }
+                    }
+                    _premultiply(out.p[i].data() + r * n, out.a[i].data() + r * n, n);
+                    continue;
+                }
+                // average premultiplied color and alpha of subsample block
+                for (int j = 0; j < pw; ++j)
+                {
+                    int sum_a = 0;
+                    int sum_c[4] = {0, 0, 0, 0};
+                    int num = 0;
+                    for (int yy = 0; yy < num_rows; ++yy)
+                    {
+                        for (int xx = j * plane.sub_x; xx < std::min((j + 1) * plane.sub_x, w); ++xx)
+                        {
+                            const uint8_t *px = rows.data() + (yy * w + xx) * 4;
+                            sum_a += px[3];
+                            for (int k = 0; k < bpp; ++k)
+                                sum_c[k] += px[plane.chan[k]] * px[3];
+                            ++num;
+                        }
+                    }
+                    for (int k = 0; k < bpp; ++k)
+                    {
+                        A[j * bpp + k] = (sum_a + num / 2) / num;
+                        P[j * bpp + k] = (sum_c[k] + 255 * num / 2) / (255 * num);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Composite n bytes, p is premultiplied color, a is alpha of every byte
+     */
+    template <int MODE>
+    static void _composite_row(uint8_t *d, const uint8_t *p, const uint8_t *a, int n)
+    {
+        int i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            uint64_t a64[2];
+            memcpy(a64, a + i, 16);
+            if ((a64[0] | a64[1]) == 0) // transparent, p <= a so p is 0 too
+                continue;
+            v16u8 p8, d8;
+            memcpy(&p8, p + i, 16);
+            if (MODE == BLEND_SRC_OVER && (a64[0] & a64[1]) == ~(uint64_t)0)
+            {
+                memcpy(d + i, &p8, 16);
+                continue;
+            }
+            memcpy(&d8, d + i, 16);
+            if (MODE == BLEND_ADD)
+            {
+                v16u8 s = d8 + p8;
+                d8 = s | (v16u8)(s < d8); // saturate
+            }
+            else
+            {
+                v16u8 a8;
+                memcpy(&a8, a + i, 16);
+                v16u16 dd = __builtin_convertvector(d8, v16u16);
+                v16u16 pp = __builtin_convertvector(p8, v16u16);
+                v16u16 aa = __builtin_convertvector(a8, v16u16);
+                if (MODE == BLEND_MULTIPLY)
+                {
+                    dd *= pp + 255 - aa;
+                    _div255_v(dd);
+                }
+                else
+                {
+                    dd *= 255 - aa;
+                    _div255_v(dd);
+                    dd += pp;
+                }
+                d8 = __builtin_convertvector(dd, v16u8);
+            }
+            memcpy(d + i, &d8, 16);
+        }
+        for (; i < n; ++i)
+        {
+            if (a[i] == 0)
+                continue;
+            if (MODE == BLEND_ADD)
+                d[i] = std::min(d[i] + p[i], 255);
+            else if (MODE == BLEND_MULTIPLY)
+                d[i] = _div255(d[i] * (p[i] + 255 - a[i]));
+            else
+                d[i] = p[i] + _div255(d[i] * (255 - a[i]));
+        }
+    }
+
+    static void _composite(image::Image &dst, const blend_layout_t &layout, int x, int y, const blend_premul_t &src,
+                           int rx, int ry, int rw, int rh, image::BlendMode mode, bool parallel)
+    {
+        rw = std::min(rw, src.w - rx);
+        rh = std::min(rh, src.h - ry);
+        int x0 = std::max(x + std::max(rx, 0), 0);
+        int y0 = std::max(y + std::max(ry, 0), 0);
+        int x1 = std::min(x + rx + rw, dst.width());
+        int y1 = std::min(y + ry + rh, dst.height());
+        if (x0 >= x1 || y0 >= y1)
+            return;
+        uint8_t *data = (uint8_t *)dst.data();
+        for (int i = 0; i < layout.num; ++i)
+        {
+            const blend_plane_t &plane = layout.planes[i];
+            const blend_plane_t &src_plane = src.layout.planes[i];
+            int bpp = plane.bpp;
+            int px0 = x0 / plane.sub_x;
+            int px1 = std::min((x1 + plane.sub_x - 1) / plane.sub_x, plane.stride / bpp);
+            int py0 = y0 / plane.sub_y;
+            int py1 = (y1 + plane.sub_y - 1) / plane.sub_y;
+            int sx = x / plane.sub_x;
+            int sy = y / plane.sub_y;
+            int n = (px1 - px0) * bpp;
+            uint8_t *d = data + plane.offset + px0 * bpp;
+            const uint8_t *p = src.p[i].data() + (px0 - sx) * bpp;
+            const uint8_t *a = src.a[i].data() + (px0 - sx) * bpp;
+            int dst_stride = plane.stride;
+            int src_stride = src_plane.stride;
+            void (*kernel)(uint8_t *, const uint8_t *, const uint8_t *, int) = _composite_row<BLEND_SRC_OVER>;
+            if (i == 0 || layout.space != BLEND_SPACE_YUV)
+            {
+                if (mode == BLEND_ADD)
+                    kernel = _composite_row<BLEND_ADD>;
+                else if (mode == BLEND_MULTIPLY)
+                    kernel = _composite_row<BLEND_MULTIPLY>;
+            }
+            thread::parallel_for(py0, py1, [=](int begin, int end) {
+                for (int r = begin; r < end; ++r)
+                    kernel(d + r * dst_stride, p + (r - sy) * src_stride, a + (r - sy) * src_stride, n);
+            }, _blend_band, parallel ? 0 : 1);
+        }
+    }
+
+    void blend_composite(image::Image &dst, int x, int y, const blend_premul_t &src, int rx, int ry, int rw, int rh, image::BlendMode mode)
+    {
+        blend_layout_t layout;
+        if (!blend_get_layout(dst.format(), dst.width(), dst.height(), layout))
+            throw err::Exception(err::ERR_NOT_IMPL, "blend not support format " + image::fmt_names[dst.format()]);
+        if (layout.space != src.layout.space || layout.num != src.layout.num || layout.planes[0].bpp != src.layout.planes[0].bpp)
+            throw err::Exception(err::ERR_ARGS, "blend source not prepared for destination format");
+        _composite(dst, layout, x, y, src, rx, ry, rw, rh, mode, true);
+    }
+
+    void blend_image(image::Image &dst, int x, int y, image::Image &src, image::BlendMode mode, float alpha)
+    {
+        blend_layout_t layout, src_layout;
+        if (!blend_get_layout(dst.format(), dst.width(), dst.height(), layout))
+            throw err::Exception(err::ERR_NOT_IMPL, "blend not support format " + image::fmt_names[dst.format()]);
+        if (!blend_get_layout(src.format(), src.width(), src.height(), src_layout))
+            throw err::Exception(err::ERR_NOT_IMPL, "blend not support source format " + image::fmt_names[src.format()]);
+        if (mode < 0 || mode >= BLEND_MODE_MAX)
+            throw err::Exception(err::ERR_ARGS, "invalid blend mode");
+        // align to chroma subsample
+        for (int i = 1; i < layout.num; ++i)
+        {
+            x &= ~(layout.planes[i].sub_x - 1);
+            y &= ~(layout.planes[i].sub_y - 1);
+        }
+        int x0 = std::max(x, 0);
+        int y0 = std::max(y, 0);
+        int x1 = std::min(x + src.width(), dst.width());
+        int y1 = std::min(y + src.height(), dst.height());
+        if (x0 >= x1 || y0 >= y1 || alpha <= 0)
+            return;
+        int sx = x0 - x;
+        int sy = y0 - y;
+        int w = x1 - x0;
+        int h = y1 - y0;
+
+        // same format without alpha, copy planes
+        if (src.format() == dst.format() && !layout.alpha && mode == BLEND_SRC_OVER && alpha >= 1)
+        {
+            const uint8_t *s = (const uint8_t *)src.data();
+            uint8_t *d = (uint8_t *)dst.data();
+            for (int i = 0; i < layout.num; ++i)
+            {
+                const blend_plane_t &plane = layout.planes[i];
+                const blend_plane_t &src_plane = src_layout.planes[i];
+                int bytes = (w + plane.sub_x - 1) / plane.sub_x * plane.bpp;
+                int rows = (h + plane.sub_y - 1) / plane.sub_y;
+                const uint8_t *sp = s + src_plane.offset + sy / plane.sub_y * src_plane.stride + sx / plane.sub_x * plane.bpp;
+                uint8_t *dp = d + plane.offset + y0 / plane.sub_y * plane.stride + x0 / plane.sub_x * plane.bpp;
+                for (int r = 0; r < rows; ++r)
+                    memcpy(dp + r * plane.stride, sp + r * src_plane.stride, bytes);
+            }
+            return;
+        }
+
+        // convert and composite in bands, only band size buffers
+        image::Format format = dst.format();
+        thread::parallel_for(0, h, [&](int begin, int end) {
+            static thread_local blend_premul_t premul;
+            for (int b = begin; b < end; b += _blend_band)
+            {
+                int band = std::min(_blend_band, end - b);
+                blend_prepare(src, sx, sy + b, w, band, format, alpha, premul);
+                _composite(dst, layout, x0, y0 + b, premul, 0, 0, w, band, mode, false);
+            }
+        }, _blend_band);
+    }
+} // namespace maix::image
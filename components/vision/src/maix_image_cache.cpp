@@ -0,0 +1,348 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ * @update 2026.10.18: Convert rows on thread pool.
+ */
+
+#include "maix_image.hpp"
+#include "maix_thread.hpp"
+#include <string.h>
+
+namespace maix::image
+{
+    /**
+     * Derived images of one image, valid until the image modified.
+     * Each one records the area already converted, so finders with small roi only convert what they use.
+     * Buffers are kept after invalidated, so camera loop reuse them every frame.
+     */
+    typedef struct
+    {
+        image::Image *gray;             // GRAYSCALE copy, or Y plane view of YUV image
+        bool gray_view;                 // gray is a view of this image's data, recreate every time
+        int gray_rect[4];               // converted area of gray, [x, y, w, h], w is 0 means nothing
+        image::Image *color;            // RGB565/RGB888/BGR888 working copy
+        int color_rect[4];
+        std::vector<uint32_t> integral; // (height + 1) x (width + 1) sum table of gray
+        int integral_rows;              // computed rows of integral, not include the first zero row
+    } image_cache_t;
+
+    static inline bool _is_y_first_yuv(image::Format format)
+    {
+        return format >= image::FMT_YUV422SP && format <= image::FMT_YUV420P;
+    }
+
+    /**
+     * Merge roi to converted rect.
+     * @return false if roi already in rect, else true and rect is the area need convert now.
+     */
+    static bool _rect_merge(int rect[4], const std::vector<int> &roi)
+    {
+        if (rect[2] > 0 && roi[0] >= rect[0] && roi[1] >= rect[1] &&
+            roi[0] + roi[2] <= rect[0] + rect[2] && roi[1] + roi[3] <= rect[1] + rect[3])
+            return false;
+        if (rect[2] <= 0)
+        {
+            memcpy(rect, roi.data(), sizeof(int) * 4);
+            return true;
+        }
+        int x0 = std::min(rect[0], roi[0]);
+        int y0 = std::min(rect[1], roi[1]);
+        int x1 = std::max(rect[0] + rect[2], roi[0] + roi[2]);
+        int y1 = std::max(rect[1] + rect[3], roi[1] + roi[3]);
+        rect[0] = x0;
+        rect[1] = y0;
+        rect[2] = x1 - x0;
+        rect[3] = y1 - y0;
+        return true;
+    }
+
+    static inline void _yuv_to_rgb(int y, int u, int v, uint8_t *rgb)
+    {
+        // BT.601, 8 bits fixed point
+        int r = y + ((359 * (v - 128)) >> 8);
+        int g = y - ((88 * (u - 128) + 183 * (v - 128)) >> 8);
+        int b = y + ((454 * (u - 128)) >> 8);
+        rgb[0] = r < 0 ? 0 : (r > 255 ? 255 : r);
+        rgb[1] = g < 0 ? 0 : (g > 255 ? 255 : g);
+        rgb[2] = b < 0 ? 0 : (b > 255 ? 255 : b);
+    }
+
+    /**
+     * Read pixels [x, x + w) of row y as RGB888.
+     * @param buff at least w * 3 bytes, used if source is not RGB888
+     * @return RGB888 row pointer, points to source directly if source is RGB888
+     */
+    static const uint8_t *_read_rgb_row(const uint8_t *data, image::Format format, int width, int height, int x, int y, int w, uint8_t *buff)
+    {
+        uint8_t *out = buff;
+        switch (format)
+        {
+        case image::FMT_RGB888:
+            return data + (y * width + x) * 3;
+        case image::FMT_BGR888:
+        {
+            const uint8_t *p = data + (y * width + x) * 3;
+            for (int i = 0; i < w; ++i, p += 3, out += 3)
+            {
+                out[0] = p[2];
+                out[1] = p[1];
+                out[2] = p[0];
+            }
+            break;
+        }
+        case image::FMT_RGBA8888:
+        case image::FMT_BGRA8888:
+        {
+            const uint8_t *p = data + (y * width + x) * 4;
+            int r = format == image::FMT_RGBA8888 ? 0 : 2;
+            for (int i = 0; i < w; ++i, p += 4, out += 3)
+            {
+                out[0] = p[r];
+                out[1] = p[1];
+                out[2] = p[2 - r];
+            }
+            break;
+        }
+        case image::FMT_RGB565:
+        {
+            const uint16_t *p = (const uint16_t *)data + y * width + x;
+            for (int i = 0; i < w; ++i, ++p, out += 3)
+            {
+                int r = *p >> 11, g = (*p >> 5) & 0x3f, b = *p & 0x1f;
+                out[0] = (r << 3) | (r >> 2);
+                out[1] = (g << 2) | (g >> 4);
+                out[2] = (b << 3) | (b >> 2);
+            }
+            break;
+        }
+        case image::FMT_GRAYSCALE:
+        {
+            const uint8_t *p = data + y * width + x;
+            for (int i = 0; i < w; ++i, ++p, out += 3)
+                out[0] = out[1] = out[2] = *p;
+            break;
+        }
+        case image::FMT_YVU420SP:
+        case image::FMT_YUV420SP:
+        {
+            const uint8_t *py = data + y * width + x;
+            const uint8_t *puv = data + width * height + (y / 2) * width;
+            int u_off = format == image::FMT_YUV420SP ? 0 : 1;
+            for (int i = 0; i < w; ++i, out += 3)
+            {
+                const uint8_t *uv = puv + ((x + i) & ~1);
+                _yuv_to_rgb(py[i], uv[u_off], uv[1 - u_off], out);
+            }
+            break;
+        }
+        default:
+            throw err::Exception(err::ERR_NOT_IMPL, "image cache not support format " + image::fmt_names[format]);
+        }
+        return buff;
+    }
+
+    static void _write_rgb_row(const uint8_t *rgb, uint8_t *data, image::Format format, int width, int x, int y, int w)
+    {
+        switch (format)
+        {
+        case image::FMT_GRAYSCALE:
+        {
+            // the same weights as to_format
+            uint8_t *p = data + y * width + x;
+            for (int i = 0; i < w; ++i, rgb += 3)
+                p[i] = (rgb[0] * 38 + rgb[1] * 75 + rgb[2] * 15) >> 7;
+            break;
+        }
+        case image::FMT_RGB888:
+            memcpy(data + (y * width + x) * 3, rgb, w * 3);
+            break;
+        case image::FMT_BGR888:
+        {
+            uint8_t *p = data + (y * width + x) * 3;
+            for (int i = 0; i < w; ++i, p += 3, rgb += 3)
+            {
+                p[0] = rgb[2];
+                p[1] = rgb[1];
+                p[2] = rgb[0];
+            }
+            break;
+        }
+        case image::FMT_RGB565:
+        {
+            uint16_t *p = (uint16_t *)data + y * width + x;
+            for (int i = 0; i < w; ++i, rgb += 3)
+                p[i] = ((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3);
+            break;
+        }
+        default:
+            throw err::Exception(err::ERR_NOT_IMPL, "image cache not support format " + image::fmt_names[format]);
+        }
+    }
+
+    static void _convert_rect(image::Image *src, image::Image *dst, const int rect[4])
+    {
+        const uint8_t *data = (const uint8_t *)src->data();
+        uint8_t *out = (uint8_t *)dst->data();
+        thread::parallel_for(rect[1], rect[1] + rect[3], [src, dst, rect, data, out](int y_begin, int y_end) {
+            // one RGB888 row per thread, kept for next frames
+            static thread_local std::vector<uint8_t> row;
+            row.resize(rect[2] * 3);
+            for (int y = y_begin; y < y_end; ++y)
+            {
+                const uint8_t *rgb = _read_rgb_row(data, src->format(), src->width(), src->height(), rect[0], y, rect[2], row.data());
+                _write_rgb_row(rgb, out, dst->format(), dst->width(), rect[0], y, rect[2]);
+            }
+        }, 8);
+    }
+
+    static image_cache_t *_get_cache(void **cache)
+    {
+        if (!*cache)
+        {
+            image_cache_t *c = new image_cache_t();
+            c->gray = nullptr;
+            c->gray_view = false;
+            c->color = nullptr;
+            c->integral_rows = 0;
+            *cache = c;
+        }
+        return (image_cache_t *)*cache;
+    }
+
+    void Image::_free_cache()
+    {
+        image_cache_t *c = (image_cache_t *)_cache;
+        if (!c)
+            return;
+        delete c->gray;
+        delete c->color;
+        delete c;
+        _cache = nullptr;
+    }
+
+    image::Image *Image::cached_gray(const std::vector<int> &roi)
+    {
+        if (_format == image::FMT_GRAYSCALE)
+            return this;
+        std::vector<int> rect = _get_available_roi(roi);
+        image_cache_t *c = _get_cache(&_cache);
+        if (c->gray && (c->gray->width() != _width || c->gray->height() != _height))
+        {
+            delete c->gray;
+            c->gray = nullptr;
+        }
+        if (c->gray && c->gray_view != _is_y_first_yuv(_format))
+        {
+            delete c->gray;
+            c->gray = nullptr;
+        }
+        if (_is_y_first_yuv(_format))
+        {
+            // Y plane is grayscale already, view it without copy, view is dropped when invalidated as data may change
+            if (!c->gray)
+            {
+                c->gray = new image::Image(_width, _height, image::FMT_GRAYSCALE, (uint8_t *)_data, _width * _height, false);
+                c->gray_view = true;
+            }
+            return c->gray;
+        }
+        if (_format > image::FMT_COMPRESSED_MIN)
+        {
+            // decode whole image once, roi not help
+            if (!c->gray || c->gray_rect[2] == 0)
+            {
+                delete c->gray;
+                c->gray = to_format(image::FMT_GRAYSCALE);
+                c->gray_rect[0] = 0;
+                c->gray_rect[1] = 0;
+                c->gray_rect[2] = _width;
+                c->gray_rect[3] = _height;
+            }
+            return c->gray;
+        }
+        if (!c->gray)
+        {
+            c->gray = new image::Image(_width, _height, image::FMT_GRAYSCALE);
+            c->gray_view = false;
+            c->gray_rect[2] = 0;
+        }
+        if (_rect_merge(c->gray_rect, rect))
+            _convert_rect(this, c->gray, c->gray_rect);
+        return c->gray;
+    }
+
+    image::Image *Image::cached_color(image::Format format, const std::vector<int> &roi)
+    {
+        if (format != image::FMT_RGB565 && format != image::FMT_RGB888 && format != image::FMT_BGR888)
+            throw err::Exception(err::ERR_ARGS, "cached_color only support RGB565, RGB888 and BGR888");
+        if (_format == format)
+            return this;
+        if (_format > image::FMT_COMPRESSED_MIN)
+            throw err::Exception(err::ERR_NOT_IMPL, "cached_color not support compressed image");
+        std::vector<int> rect = _get_available_roi(roi);
+        image_cache_t *c = _get_cache(&_cache);
+        if (c->color && (c->color->format() != format || c->color->width() != _width || c->color->height() != _height))
+        {
+            delete c->color;
+            c->color = nullptr;
+        }
+        if (!c->color)
+        {
+            c->color = new image::Image(_width, _height, format);
+            c->color_rect[2] = 0;
+        }
+        if (_rect_merge(c->color_rect, rect))
+            _convert_rect(this, c->color, c->color_rect);
+        return c->color;
+    }
+
+    const uint32_t *Image::cached_integral(const std::vector<int> &roi)
+    {
+        std::vector<int> rect = _get_available_roi(roi);
+        int rows = rect[1] + rect[3];
+        // every row depends on rows above, so compute from top to roi bottom with whole width
+        image::Image *gray = cached_gray({0, 0, _width, rows});
+        image_cache_t *c = _get_cache(&_cache);
+        int stride = _width + 1;
+        if (c->integral.size() != (size_t)(stride * (_height + 1)))
+        {
+            c->integral.assign(stride * (_height + 1), 0);
+            c->integral_rows = 0;
+        }
+        uint32_t *t = c->integral.data();
+        const uint8_t *p = (const uint8_t *)gray->data();
+        for (int y = c->integral_rows; y < rows; ++y)
+        {
+            const uint8_t *src = p + y * _width;
+            const uint32_t *up = t + y * stride;
+            uint32_t *cur = t + (y + 1) * stride;
+            uint32_t sum = 0;
+            cur[0] = 0;
+            for (int x = 0; x < _width; ++x)
+            {
+                sum += src[x];
+                cur[x + 1] = up[x + 1] + sum;
+            }
+        }
+        if (rows > c->integral_rows)
+            c->integral_rows = rows;
+        return t;
+    }
+
+    void Image::invalidate_cache()
+    {
+        image_cache_t *c = (image_cache_t *)_cache;
+        if (!c)
+            return;
+        if (c->gray && c->gray_view)
+        {
+            delete c->gray;
+            c->gray = nullptr;
+        }
+        c->gray_rect[2] = 0;
+        c->color_rect[2] = 0;
+        c->integral_rows = 0;
+    }
+} // namespace maix::image
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Use cached grayscale image.
  */
 
 #include "maix_image.hpp"
@@ -14,13 +15,7 @@ namespace maix::image
     std::vector<image::BarCode> Image::find_barcodes(std::vector<int> roi)
     {
         image_t src_img;
-        Image *gray_img = NULL;
-        if (_format == image::FMT_GRAYSCALE) {
-            convert_to_imlib_image(this, &src_img);
-        } else {
-            gray_img = to_format(image::FMT_GRAYSCALE);
-            convert_to_imlib_image(gray_img, &src_img);
-        }
+        convert_to_imlib_image(cached_gray(roi), &src_img);
 
         rectangle_t roi_rect;
         std::vector<int> avail_roi = _get_available_roi(roi);
@@ -59,10 +54,6 @@ namespace maix::image
             barcodes.push_back(barcode);
         }
 
-        if (_format != image::FMT_GRAYSCALE) {
-            delete gray_img;
-        }
-
         return barcodes;
     }
 } // namespace maix::image
@@ -3,6 +3,8 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add find_blobs output to BlobRecords and callback, fix histogram size.
+ * @update 2026.10.18: Cache LAB thresholds, use cached RGB565 copy for formats imlib not support.
  */
 
 #include "maix_image.hpp"
@@ -10,11 +12,11 @@
 
 namespace maix::image
 {
-    void _convert_to_lab_thresholds(std::vector<std::vector<int>> &in, list_t *out)
+    void _convert_to_lab_thresholds(const std::vector<std::vector<int>> &in, list_t *out)
     {
         for (size_t i = 0; i < in.size(); i ++) {
             color_thresholds_list_lnk_data_t lnk_data;
-            std::vector<int> &threshold = in[i];
+            const std::vector<int> &threshold = in[i];
             int threshold_len = threshold.size();
             if (threshold_len > 0) {
                 lnk_data.LMin = (threshold_len > 0) ? std::max(std::min((threshold[0]),
@@ -51,79 +53,137 @@ namespace maix::image
         }
     }
 
-    std::vector<image::Blob> Image::find_blobs(std::vector<std::vector<int>> thresholds, bool invert, std::vector<int> roi, int x_stride, int y_stride, int area_threshold, int pixels_threshold, bool merge, int margin, int x_hist_bins_max, int y_hist_bins_max)
+    typedef struct
     {
-        err::check_bool_raise(thresholds.size() != 0, "You need to set thresholds");
-        image_t src_img;
-        convert_to_imlib_image(this, &src_img);
+        image::BlobRecords *out;                // records output, or nullptr for callback
+        const std::function<void(const image::BlobRecord &, const uint16_t *, const uint16_t *)> *callback;
+        std::vector<uint16_t> hist;             // histograms of one blob for callback
+    } find_blobs_ctx_t;
 
-        rectangle_t roi_rect;
-        std::vector<int> avail_roi = _get_available_roi(roi);
-        roi_rect.x = avail_roi[0];
-        roi_rect.y = avail_roi[1];
-        roi_rect.w = avail_roi[2];
-        roi_rect.h = avail_roi[3];
+    /**
+     * LAB thresholds converted last time, thresholds are usually the same for every frame.
+     */
+    class LabThresholdsCache
+    {
+    public:
+        std::vector<std::vector<int>> in;
+        list_t list;
+        bool valid = false;
 
-        list_t thresholds_list;
-        list_init(&thresholds_list, sizeof(color_thresholds_list_lnk_data_t));
-        _convert_to_lab_thresholds(thresholds, &thresholds_list);
+        ~LabThresholdsCache()
+        {
+            if (valid)
+                list_free(&list);
+        }
 
-        list_t out;
-        std::vector<image::Blob> blobs;
-        imlib_find_blobs(&out, &src_img, &roi_rect, x_stride, y_stride, &thresholds_list, invert,  area_threshold, pixels_threshold, merge, margin, NULL, NULL, NULL, NULL, x_hist_bins_max, y_hist_bins_max);
-        list_free(&thresholds_list);
+        list_t *get(const std::vector<std::vector<int>> &thresholds)
+        {
+            if (valid && in == thresholds)
+                return &list;
+            if (valid)
+                list_free(&list);
+            list_init(&list, sizeof(color_thresholds_list_lnk_data_t));
+            _convert_to_lab_thresholds(thresholds, &list);
+            in = thresholds;
+            valid = true;
+            return &list;
+        }
+    };
 
-        for (size_t i = 0; list_size(&out); i++) {
-            find_blobs_list_lnk_data_t lnk_data;
-            list_pop_front(&out, &lnk_data);
+    /**
+     * imlib only support GRAYSCALE RGB565 and RGB888, use cached RGB565 working copy for other formats.
+     */
+    static image::Image *_find_blobs_source(image::Image *img, const std::vector<int> &roi)
+    {
+        image::Format format = img->format();
+        if (format == image::FMT_GRAYSCALE || format == image::FMT_RGB565 || format == image::FMT_RGB888 || format == image::FMT_BGR888)
+            return img;
+        return img->cached_color(image::FMT_RGB565, roi);
+    }
 
-            std::vector<int> rect = {lnk_data.rect.x,
-                                     lnk_data.rect.y,
-                                     lnk_data.rect.w,
-                                     lnk_data.rect.h};
-            std::vector<std::vector<int>> corners = {
-                {(int)lnk_data.corners[((FIND_BLOBS_CORNERS_RESOLUTION * 0) / 4)].x, (int)lnk_data.corners[((FIND_BLOBS_CORNERS_RESOLUTION * 0) / 4)].y},
-                {(int)lnk_data.corners[((FIND_BLOBS_CORNERS_RESOLUTION * 1) / 4)].x, (int)lnk_data.corners[((FIND_BLOBS_CORNERS_RESOLUTION * 1) / 4)].y},
-                {(int)lnk_data.corners[((FIND_BLOBS_CORNERS_RESOLUTION * 2) / 4)].x, (int)lnk_data.corners[((FIND_BLOBS_CORNERS_RESOLUTION * 2) / 4)].y},
-                {(int)lnk_data.corners[((FIND_BLOBS_CORNERS_RESOLUTION * 3) / 4)].x, (int)lnk_data.corners[((FIND_BLOBS_CORNERS_RESOLUTION * 3) / 4)].y},
-            };
-
-            point_t min_corners_tmp[4];
-            point_min_area_rectangle(lnk_data.corners, min_corners_tmp, FIND_BLOBS_CORNERS_RESOLUTION);
-            std::vector<std::vector<int>> mini_corners {
-                {(int)min_corners_tmp[0].x, (int)min_corners_tmp[0].y},
-                {(int)min_corners_tmp[1].x, (int)min_corners_tmp[1].y},
-                {(int)min_corners_tmp[2].x, (int)min_corners_tmp[2].y},
-                {(int)min_corners_tmp[3].x, (int)min_corners_tmp[3].y},
-            };
-
-            std::vector<int> hist_x_bins;
-            std::vector<int> hist_y_bins;
-            hist_x_bins.resize(lnk_data.x_hist_bins_count);
-            for (size_t i = 0; i < lnk_data.x_hist_bins_count; i ++) {
-                hist_x_bins.push_back(lnk_data.x_hist_bins[i]);
-            }
-            hist_y_bins.resize(lnk_data.x_hist_bins_count);
-            for (size_t i = 0; i < lnk_data.x_hist_bins_count; i ++) {
-                hist_y_bins.push_back(lnk_data.y_hist_bins[i]);
-            }
+    static void _lnk_to_record(find_blobs_list_lnk_data_t *lnk_data, image::BlobRecord *record)
+    {
+        record->x = lnk_data->rect.x;
+        record->y = lnk_data->rect.y;
+        record->w = lnk_data->rect.w;
+        record->h = lnk_data->rect.h;
+        record->pixels = lnk_data->pixels;
+        record->cx = lnk_data->centroid_x;
+        record->cy = lnk_data->centroid_y;
+        record->rotation = lnk_data->rotation;
+        record->code = lnk_data->code;
+        record->count = lnk_data->count;
+        record->perimeter = lnk_data->perimeter;
+        record->roundness = lnk_data->roundness;
+        for (int i = 0; i < 4; i ++) {
+            const point_t &corner = lnk_data->corners[(FIND_BLOBS_CORNERS_RESOLUTION * i) / 4];
+            record->corners[i][0] = corner.x;
+            record->corners[i][1] = corner.y;
+        }
+        point_t min_corners_tmp[4];
+        point_min_area_rectangle(lnk_data->corners, min_corners_tmp, FIND_BLOBS_CORNERS_RESOLUTION);
+        for (int i = 0; i < 4; i ++) {
+            record->mini_corners[i][0] = min_corners_tmp[i].x;
+            record->mini_corners[i][1] = min_corners_tmp[i].y;
+        }
+    }
 
-            image::Blob blob(rect,
-                            corners,
-                            mini_corners,
-                            lnk_data.centroid_x,
-                            lnk_data.centroid_y,
-                            lnk_data.pixels,
-                            lnk_data.rotation,
-                            lnk_data.code,
-                            lnk_data.count,
-                            lnk_data.perimeter,
-                            lnk_data.roundness,
-                            hist_x_bins,
-                            hist_y_bins
-            );
-            blobs.push_back(blob);
+    static void _find_blobs_output(find_blobs_ctx_t *ctx, find_blobs_list_lnk_data_t *lnk_data)
+    {
+        image::BlobRecord record;
+        _lnk_to_record(lnk_data, &record);
+        std::vector<uint16_t> &hist = ctx->out ? ctx->out->hist : ctx->hist;
+        if (!ctx->out) {
+            hist.clear();
+        }
+        record.x_hist_offset = hist.size();
+        record.x_hist_count = lnk_data->x_hist_bins ? lnk_data->x_hist_bins_count : 0;
+        hist.insert(hist.end(), lnk_data->x_hist_bins, lnk_data->x_hist_bins + record.x_hist_count);
+        record.y_hist_offset = hist.size();
+        record.y_hist_count = lnk_data->y_hist_bins ? lnk_data->y_hist_bins_count : 0;
+        hist.insert(hist.end(), lnk_data->y_hist_bins, lnk_data->y_hist_bins + record.y_hist_count);
+        if (ctx->out) {
+            ctx->out->records.push_back(record);
+            return;
+        }
+        const uint16_t *x_hist = record.x_hist_count ? hist.data() + record.x_hist_offset : nullptr;
+        const uint16_t *y_hist = record.y_hist_count ? hist.data() + record.y_hist_offset : nullptr;
+        record.x_hist_offset = 0;
+        record.y_hist_offset = 0;
+        (*ctx->callback)(record, x_hist, y_hist);
+    }
+
+    // called by imlib for every blob passed area and pixels threshold
+    static bool _find_blobs_threshold_cb(void *arg, find_blobs_list_lnk_data_t *lnk_data)
+    {
+        _find_blobs_output((find_blobs_ctx_t *)arg, lnk_data);
+        // not add to output list, imlib will free histograms
+        return false;
+    }
 
+    static err::Err _find_blobs(find_blobs_ctx_t *ctx, image_t *src_img, rectangle_t *roi_rect, const std::vector<std::vector<int>> &thresholds, bool invert, int x_stride, int y_stride, int area_threshold, int pixels_threshold, bool merge, int margin, int x_hist_bins_max, int y_hist_bins_max)
+    {
+        if (thresholds.size() == 0 || x_stride <= 0 || y_stride <= 0) {
+            log::error("find_blobs: invalid args, thresholds is empty or stride <= 0");
+            return err::ERR_ARGS;
+        }
+        static thread_local LabThresholdsCache lab_thresholds;
+        list_t *thresholds_list = lab_thresholds.get(thresholds);
+
+        list_t out;
+        if (!merge) {
+            // get blobs once found, no list node and copy
+            imlib_find_blobs(&out, src_img, roi_rect, x_stride, y_stride, thresholds_list, invert, area_threshold, pixels_threshold, merge, margin,
+                             _find_blobs_threshold_cb, ctx, NULL, NULL, x_hist_bins_max, y_hist_bins_max);
+        } else {
+            imlib_find_blobs(&out, src_img, roi_rect, x_stride, y_stride, thresholds_list, invert, area_threshold, pixels_threshold, merge, margin,
+                             NULL, NULL, NULL, NULL, x_hist_bins_max, y_hist_bins_max);
+        }
+
+        while (list_size(&out)) {
+            find_blobs_list_lnk_data_t lnk_data;
+            list_pop_front(&out, &lnk_data);
+            _find_blobs_output(ctx, &lnk_data);
             if (lnk_data.x_hist_bins) {
                 xfree(lnk_data.x_hist_bins);
             }
@@ -131,6 +191,54 @@ namespace maix::image
                 xfree(lnk_data.y_hist_bins);
             }
         }
+        return err::ERR_NONE;
+    }
+
+    err::Err Image::find_blobs(image::BlobRecords &out, const std::vector<std::vector<int>> &thresholds, bool invert, const std::vector<int> &roi, int x_stride, int y_stride, int area_threshold, int pixels_threshold, bool merge, int margin, int x_hist_bins_max, int y_hist_bins_max)
+    {
+        out.clear();
+        image_t src_img;
+        convert_to_imlib_image(_find_blobs_source(this, roi), &src_img);
+
+        rectangle_t roi_rect;
+        std::vector<int> avail_roi = _get_available_roi(roi);
+        roi_rect.x = avail_roi[0];
+        roi_rect.y = avail_roi[1];
+        roi_rect.w = avail_roi[2];
+        roi_rect.h = avail_roi[3];
+
+        find_blobs_ctx_t ctx;
+        ctx.out = &out;
+        ctx.callback = nullptr;
+        return _find_blobs(&ctx, &src_img, &roi_rect, thresholds, invert, x_stride, y_stride, area_threshold, pixels_threshold, merge, margin, x_hist_bins_max, y_hist_bins_max);
+    }
+
+    err::Err Image::find_blobs(const std::function<void(const image::BlobRecord &, const uint16_t *, const uint16_t *)> &callback, const std::vector<std::vector<int>> &thresholds, bool invert, const std::vector<int> &roi, int x_stride, int y_stride, int area_threshold, int pixels_threshold, bool merge, int margin, int x_hist_bins_max, int y_hist_bins_max)
+    {
+        image_t src_img;
+        convert_to_imlib_image(_find_blobs_source(this, roi), &src_img);
+
+        rectangle_t roi_rect;
+        std::vector<int> avail_roi = _get_available_roi(roi);
+        roi_rect.x = avail_roi[0];
+        roi_rect.y = avail_roi[1];
+        roi_rect.w = avail_roi[2];
+        roi_rect.h = avail_roi[3];
+
+        find_blobs_ctx_t ctx;
+        ctx.out = nullptr;
+        ctx.callback = &callback;
+        return _find_blobs(&ctx, &src_img, &roi_rect, thresholds, invert, x_stride, y_stride, area_threshold, pixels_threshold, merge, margin, x_hist_bins_max, y_hist_bins_max);
+    }
+
+    std::vector<image::Blob> Image::find_blobs(std::vector<std::vector<int>> thresholds, bool invert, std::vector<int> roi, int x_stride, int y_stride, int area_threshold, int pixels_threshold, bool merge, int margin, int x_hist_bins_max, int y_hist_bins_max)
+    {
+        err::check_bool_raise(thresholds.size() != 0, "You need to set thresholds");
+        std::vector<image::Blob> blobs;
+        err::Err e = find_blobs([&blobs](const image::BlobRecord &record, const uint16_t *x_hist, const uint16_t *y_hist) {
+            blobs.push_back(image::BlobRecords::to_blob(record, x_hist, y_hist));
+        }, thresholds, invert, roi, x_stride, y_stride, area_threshold, pixels_threshold, merge, margin, x_hist_bins_max, y_hist_bins_max);
+        err::check_raise(e, "find blobs failed");
         return blobs;
     }
 } // namespace maix::image
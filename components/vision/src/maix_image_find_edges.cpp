@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Use cached grayscale image, support YUV image.
  */
 
 #include "maix_image.hpp"
@@ -13,14 +14,15 @@ namespace maix::image
 {
     image::Image* Image::find_edges(EdgeDetector edge_type, std::vector<int> roi, std::vector<int> threshold)
     {
-        image_t src_img;
-        Image *gray_img = NULL;
-        if (_format == image::FMT_GRAYSCALE) {
-            convert_to_imlib_image(this, &src_img);
-        } else {
-            gray_img = to_format(image::FMT_GRAYSCALE);
-            convert_to_imlib_image(gray_img, &src_img);
+        // edges are written back to the whole image, YUV image get edges in Y plane directly
+        bool yuv = _format >= image::FMT_YUV422SP && _format <= image::FMT_YUV420P;
+        if (_format != image::FMT_GRAYSCALE && !yuv && _format != image::FMT_RGB888 && _format != image::FMT_BGR888 &&
+            _format != image::FMT_RGBA8888 && _format != image::FMT_BGRA8888) {
+            throw err::Exception(err::ERR_NOT_IMPL, "find_edges not support format " + image::fmt_names[_format]);
         }
+        image_t src_img;
+        Image *gray_img = cached_gray();
+        convert_to_imlib_image(gray_img, &src_img);
 
         rectangle_t roi_rect;
         std::vector<int> avail_roi = _get_available_roi(roi);
@@ -39,12 +41,14 @@ namespace maix::image
                 break;
         }
 
-        if (_format != image::FMT_GRAYSCALE) {
-            Image *out = gray_img->to_format(image::FMT_RGB888);
-            memcpy(this->data(), out->data(), out->data_size());
-            delete gray_img;
+        if (yuv) {
+            memset((uint8_t *)_data + _width * _height, 128, _data_size - _width * _height);
+        } else if (_format != image::FMT_GRAYSCALE) {
+            Image *out = gray_img->to_format(_format);
+            memcpy(this->data(), out->data(), _data_size);
             delete out;
         }
+        invalidate_cache();
 
         return this;
     }
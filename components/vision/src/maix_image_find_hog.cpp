@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Use cached grayscale image.
  */
 
 #include "maix_image.hpp"
@@ -14,13 +15,8 @@ namespace maix::image
     image::Image* Image::find_hog(std::vector<int> roi, int size)
     {
         image_t src_img;
-        Image *gray_img = NULL;
-        if (_format == image::FMT_GRAYSCALE) {
-            convert_to_imlib_image(this, &src_img);
-        } else {
-            gray_img = to_format(image::FMT_GRAYSCALE);
-            convert_to_imlib_image(gray_img, &src_img);
-        }
+        Image *gray_img = cached_gray();
+        convert_to_imlib_image(gray_img, &src_img);
 
         rectangle_t roi_rect;
         std::vector<int> avail_roi = _get_available_roi(roi);
@@ -40,11 +36,12 @@ namespace maix::image
         imlib_find_hog(&src_img, &roi_rect, size);
 
         if (_format != image::FMT_GRAYSCALE) {
+            // gray_img is owned by cache, convert before delete this
             Image *out = gray_img->to_format(image::FMT_RGB888);
             delete this;
-            delete gray_img;
             return out;
         }
+        invalidate_cache();
 
         return this;
     }
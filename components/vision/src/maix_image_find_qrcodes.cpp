@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Use cached grayscale image.
  */
 
 #include "maix_image.hpp"
@@ -14,20 +15,10 @@ namespace maix::image
     std::vector<image::QRCode> Image::find_qrcodes(std::vector<int> roi)
     {
         image_t src_img;
-        Image *gray_img = NULL;
         std::vector<image::QRCode> qrcodes;
 
-        if (_format == image::FMT_GRAYSCALE) {
-            convert_to_imlib_image(this, &src_img);
-        } else {
-            if (image::FMT_YVU420SP == _format) {
-                gray_img = new image::Image(_width, _height, image::FMT_GRAYSCALE);
-                memcpy(gray_img->data(), _data, _width * _height);
-            } else {
-                gray_img = this->to_format(image::FMT_GRAYSCALE);
-            }
-            convert_to_imlib_image(gray_img, &src_img);
-        }
+        // YUV image use Y plane directly without copy
+        convert_to_imlib_image(cached_gray(roi), &src_img);
 
         rectangle_t roi_rect;
         std::vector<int> avail_roi = _get_available_roi(roi);
@@ -77,10 +68,6 @@ namespace maix::image
             qrcodes.push_back(qrcode);
         }
 
-        if (_format != image::FMT_GRAYSCALE) {
-            delete gray_img;
-        }
-
         return qrcodes;
     }
 } // namespace maix::image
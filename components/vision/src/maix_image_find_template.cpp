@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Use cached grayscale image.
  */
 
 #include "maix_image.hpp"
@@ -14,20 +15,9 @@ namespace maix::image
     std::vector<int> Image::find_template(image::Image &template_image, float threshold, std::vector<int> roi, int step, TemplateMatch search)
     {
         image_t src_img, template_img;
-        Image *src_gray_img = NULL, *template_gray_img = NULL;
-        if (_format == image::FMT_GRAYSCALE) {
-            convert_to_imlib_image(this, &src_img);
-        } else {
-            src_gray_img = to_format(image::FMT_GRAYSCALE);
-            convert_to_imlib_image(src_gray_img, &src_img);
-        }
-
-        if (template_image.format() == image::FMT_GRAYSCALE) {
-            convert_to_imlib_image(&template_image, &template_img);
-        } else {
-            template_gray_img = template_image.to_format(image::FMT_GRAYSCALE);
-            convert_to_imlib_image(template_gray_img, &template_img);
-        }
+        convert_to_imlib_image(cached_gray(roi), &src_img);
+        // template image is usually the same one for every frame, cache its grayscale too
+        convert_to_imlib_image(template_image.cached_gray(), &template_img);
 
         rectangle_t roi_rect;
         std::vector<int> avail_roi = _get_available_roi(roi);
@@ -54,13 +44,6 @@ namespace maix::image
             corr = imlib_template_match_ex(&src_img, &template_img, &roi_rect, step, &r);
         }
 
-        if (_format != image::FMT_GRAYSCALE) {
-            delete src_gray_img;
-        }
-        if (template_image.format() != image::FMT_GRAYSCALE) {
-            delete template_gray_img;
-        }
-
         if (corr > threshold) {
             return {(int)r.x, (int)r.y, (int)r.w, (int)r.h};
         } else {
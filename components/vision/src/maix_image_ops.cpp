@@ -3,10 +3,13 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Invalidate derived image cache when image modified.
+ * @update 2026.10.18: midpoint_pool rows on thread pool.
  */
 
 #include "maix_image.hpp"
 #include "maix_image_util.hpp"
+#include "maix_thread.hpp"
 #include "maix_err.hpp"
 #include <omv.hpp>
 #include <opencv2/opencv.hpp>
@@ -38,6 +41,8 @@ namespace maix::image {
     }
 
     image::Image *Image::mean_pool(int x_div, int y_div, bool copy) {
+        if (!copy)
+            invalidate_cache();
         err::check_bool_raise(x_div > 0 && x_div <= _width && y_div > 0 && y_div <= _height, "mean pool get invalid param");
 
         image_t src_img, out_img;
@@ -71,6 +76,8 @@ namespace maix::image {
     }
 
     image::Image *Image::midpoint_pool(int x_div, int y_div, double bias, bool copy) {
+        if (!copy)
+            invalidate_cache();
         if (x_div <= 0 || x_div > _width || y_div <= 0 || y_div > _height) {
             log::warn("midpoint pool invalid div: %d, %d", x_div, y_div);
             return nullptr;
@@ -94,57 +101,60 @@ namespace maix::image {
         int min_bias = 256 - bias;
         int max_bias = bias;
 
-        switch (_format) {
-        case Format::FMT_GRAYSCALE:
-            for (int y = 0, yy = _dst_height, yyy = (_height % y_div) / 2; y < yy; y++) {
-                for (int x = 0, xx = _dst_width, xxx = (_width % x_div) / 2; x < xx; x++) {
-                    int min = 255, max = 0;
-                    uint8_t *src_data = (uint8_t *)_data;
-                    uint8_t *dst_data = (uint8_t *)dst->data();
-                    for (int i = 0; i < y_div; i++) {
-                        for (int j = 0; j < x_div; j++) {
-                            int pixel = src_data[(yyy + (y * y_div) + i) * _width + (xxx + (x * x_div) + j)];
-                            min = std::min(min, pixel);
-                            max = std::max(max, pixel);
+        // rows of a new image can be computed in parallel, in place pooling overwrite source rows not read yet by others
+        thread::parallel_for(0, _dst_height, [&](int y_begin, int y_end) {
+            switch (_format) {
+            case Format::FMT_GRAYSCALE:
+                for (int y = y_begin, yy = y_end, yyy = (_height % y_div) / 2; y < yy; y++) {
+                    for (int x = 0, xx = _dst_width, xxx = (_width % x_div) / 2; x < xx; x++) {
+                        int min = 255, max = 0;
+                        uint8_t *src_data = (uint8_t *)_data;
+                        uint8_t *dst_data = (uint8_t *)dst->data();
+                        for (int i = 0; i < y_div; i++) {
+                            for (int j = 0; j < x_div; j++) {
+                                int pixel = src_data[(yyy + (y * y_div) + i) * _width + (xxx + (x * x_div) + j)];
+                                min = std::min(min, pixel);
+                                max = std::max(max, pixel);
+                            }
                         }
+                        dst_data[y * _dst_width + x] = (min_bias * min + max_bias * max) >> 8;
                     }
-                    dst_data[y * _dst_width + x] = (min_bias * min + max_bias * max) >> 8;
                 }
-            }
-            break;
-        case Format::FMT_RGB888: // fall through
-        case Format::FMT_BGR888:
-            for (int y = 0, yy = _dst_height, yyy = (_height % y_div) / 2; y < yy; y++) {
-                for (int x = 0, xx = _dst_width, xxx = (_width % x_div) / 2; x < xx; x++) {
-                    int v0_min = 255, v0_max = 0;
-                    int v1_min = 255, v1_max = 0;
-                    int v2_min = 255, v2_max = 0;
-                    uint8_t *src_data = (uint8_t *)_data;
-                    uint8_t *dst_data = (uint8_t *)dst->data();
-                    for (int i = 0; i < y_div; i++) {
-                        for (int j = 0; j < x_div; j++) {
-                            int v0 = src_data[((yyy + (y * y_div) + i) * _width + (xxx + (x * x_div) + j)) * 3];
-                            int v1 = src_data[((yyy + (y * y_div) + i) * _width + (xxx + (x * x_div) + j)) * 3 + 1];
-                            int v2 = src_data[((yyy + (y * y_div) + i) * _width + (xxx + (x * x_div) + j)) * 3 + 2];
-                            v0_min = std::min(v0_min, v0);
-                            v0_max = std::max(v0_max, v0);
-                            v1_min = std::min(v1_min, v1);
-                            v1_max = std::max(v1_max, v1);
-                            v2_min = std::min(v2_min, v2);
-                            v2_max = std::max(v2_max, v2);
+                break;
+            case Format::FMT_RGB888: // fall through
+            case Format::FMT_BGR888:
+                for (int y = y_begin, yy = y_end, yyy = (_height % y_div) / 2; y < yy; y++) {
+                    for (int x = 0, xx = _dst_width, xxx = (_width % x_div) / 2; x < xx; x++) {
+                        int v0_min = 255, v0_max = 0;
+                        int v1_min = 255, v1_max = 0;
+                        int v2_min = 255, v2_max = 0;
+                        uint8_t *src_data = (uint8_t *)_data;
+                        uint8_t *dst_data = (uint8_t *)dst->data();
+                        for (int i = 0; i < y_div; i++) {
+                            for (int j = 0; j < x_div; j++) {
+                                int v0 = src_data[((yyy + (y * y_div) + i) * _width + (xxx + (x * x_div) + j)) * 3];
+                                int v1 = src_data[((yyy + (y * y_div) + i) * _width + (xxx + (x * x_div) + j)) * 3 + 1];
+                                int v2 = src_data[((yyy + (y * y_div) + i) * _width + (xxx + (x * x_div) + j)) * 3 + 2];
+                                v0_min = std::min(v0_min, v0);
+                                v0_max = std::max(v0_max, v0);
+                                v1_min = std::min(v1_min, v1);
+                                v1_max = std::max(v1_max, v1);
+                                v2_min = std::min(v2_min, v2);
+                                v2_max = std::max(v2_max, v2);
+                            }
                         }
-                    }
 
-                    dst_data[(y * _dst_width + x) * 3] = ((v0_min * min_bias) + (v0_max * max_bias)) >> 8;
-                    dst_data[(y * _dst_width + x) * 3 + 1] =((v1_min * min_bias) + (v1_max * max_bias)) >> 8;
-                    dst_data[(y * _dst_width + x) * 3 + 2] = ((v2_min * min_bias) + (v2_max * max_bias)) >> 8;
+                        dst_data[(y * _dst_width + x) * 3] = ((v0_min * min_bias) + (v0_max * max_bias)) >> 8;
+                        dst_data[(y * _dst_width + x) * 3 + 1] =((v1_min * min_bias) + (v1_max * max_bias)) >> 8;
+                        dst_data[(y * _dst_width + x) * 3 + 2] = ((v2_min * min_bias) + (v2_max * max_bias)) >> 8;
+                    }
                 }
+            break;
+            default:
+                // should not be here
+            break;
             }
-        break;
-        default:
-            // should not be here
-        break;
-        }
+        }, 1, copy ? 0 : 1);
 
         if (!copy) {
             _width = _dst_width;
@@ -167,6 +177,7 @@ namespace maix::image {
     }
 
     image::Image *Image::clear(image::Image *mask) {
+        invalidate_cache();
         if (!mask) {
             memset(_data, 0, _data_size);
         } else {
@@ -228,6 +239,8 @@ namespace maix::image {
     }
 
     image::Image *Image::binary(std::vector<std::vector<int>> thresholds, bool invert, bool zero, image::Image *mask, bool to_bitmap, bool copy) {
+        if (!copy)
+            invalidate_cache();
         err::check_bool_raise(thresholds.size() != 0, "You need to set thresholds");
         err::check_bool_raise(to_bitmap == false, "Parameter to_bitmap is not supported");
 
@@ -256,6 +269,7 @@ namespace maix::image {
     }
 
     image::Image *Image::invert() {
+        invalidate_cache();
         int remain_len = _data_size % 4;
         int u32_len = (_data_size - remain_len) >> 2;
         uint8_t *remain_data = (uint8_t *)((uint8_t *)_data + (u32_len << 2));
@@ -272,6 +286,7 @@ namespace maix::image {
     }
 
     image::Image *Image::b_and(image::Image *other, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
@@ -304,6 +319,7 @@ namespace maix::image {
     }
 
     image::Image *Image::b_nand(image::Image *other, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
@@ -336,6 +352,7 @@ namespace maix::image {
     }
 
     image::Image *Image::b_or(image::Image *other, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
@@ -369,6 +386,7 @@ namespace maix::image {
     }
 
     image::Image *Image::b_nor(image::Image *other, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
@@ -402,6 +420,7 @@ namespace maix::image {
     }
 
     image::Image *Image::b_xor(image::Image *other, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
@@ -434,6 +453,7 @@ namespace maix::image {
     }
 
     image::Image *Image::b_xnor(image::Image *other, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
@@ -466,6 +486,7 @@ namespace maix::image {
     }
 
     image::Image *Image::awb(bool max) {
+        invalidate_cache();
         image_t src_img;
         Image *rgb565_img = nullptr;
         if (_format == image::FMT_RGB888 || _format == image::FMT_BGR888) {
@@ -488,6 +509,7 @@ namespace maix::image {
     }
 
     image::Image *Image::ccm(std::vector<float> &matrix) {
+        invalidate_cache();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -508,6 +530,7 @@ namespace maix::image {
     }
 
     image::Image *Image::gamma(double gamma, double contrast, double brightness) {
+        invalidate_cache();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -520,6 +543,7 @@ namespace maix::image {
     }
 
     image::Image *Image::negate(void) {
+        invalidate_cache();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
         imlib_negate(&src_img);
@@ -527,6 +551,7 @@ namespace maix::image {
     }
 
     image::Image *Image::replace(image::Image *other, bool hmirror, bool vflip, bool transpose, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -561,6 +586,7 @@ namespace maix::image {
     }
 
     image::Image *Image::add(image::Image *other, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -575,6 +601,7 @@ namespace maix::image {
     }
 
     image::Image *Image::sub(image::Image *other, bool reverse, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -589,6 +616,7 @@ namespace maix::image {
     }
 
     image::Image *Image::mul(image::Image *other, bool invert, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -603,6 +631,7 @@ namespace maix::image {
     }
 
     image::Image *Image::div(image::Image *other, bool invert, bool mod, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -617,6 +646,7 @@ namespace maix::image {
     }
 
     image::Image *Image::min(image::Image *other, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -631,6 +661,7 @@ namespace maix::image {
     }
 
     image::Image *Image::max(image::Image *other, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -645,6 +676,7 @@ namespace maix::image {
     }
 
     image::Image *Image::difference(image::Image *other, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -659,6 +691,7 @@ namespace maix::image {
     }
 
     image::Image *Image::blend(image::Image *other, int alpha, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -679,6 +712,7 @@ namespace maix::image {
     }
 
     image::Image *Image::histeq(bool adaptive, int clip_limit, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -702,6 +736,7 @@ namespace maix::image {
     }
 
     image::Image *Image::mean(int size, bool threshold, int offset, bool invert, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -715,6 +750,7 @@ namespace maix::image {
     }
 
     image::Image *Image::median(int size, double percentile, bool threshold, int offset, bool invert, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -729,6 +765,7 @@ namespace maix::image {
     }
 
     image::Image *Image::mode(int size, bool threshold, int offset, bool invert, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -742,6 +779,7 @@ namespace maix::image {
     }
 
     image::Image *Image::midpoint(int size, double bias, bool threshold, int offset, bool invert, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -755,6 +793,7 @@ namespace maix::image {
     }
 
     image::Image *Image::morph(int size, std::vector<int> kernel, float mul, float add, bool threshold, int offset, bool invert, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -785,6 +824,7 @@ namespace maix::image {
     }
 
     image::Image *Image::gaussian(int size, bool unsharp, float mul, float add, bool threshold, int offset, bool invert, image::Image *mask) {
+        invalidate_cache();
         std::vector<int> pascal;
         std::vector<int> kernel;
         int m = 0;
@@ -829,6 +869,7 @@ namespace maix::image {
     }
 
     image::Image *Image::laplacian(int size, bool sharpen, float mul, float add, bool threshold, int offset, bool invert, image::Image *mask) {
+        invalidate_cache();
         std::vector<int> pascal;
         std::vector<int> kernel;
         int m = 0;
@@ -874,6 +915,7 @@ namespace maix::image {
     }
 
     image::Image *Image::bilateral(int size, double color_sigma, double space_sigma, bool threshold, int offset, bool invert, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -887,6 +929,7 @@ namespace maix::image {
     }
 
     image::Image *Image::linpolar(bool reverse) {
+        invalidate_cache();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
         imlib_logpolar(&src_img, true, reverse);
@@ -894,6 +937,7 @@ namespace maix::image {
     }
 
     image::Image *Image::logpolar(bool reverse) {
+        invalidate_cache();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
         imlib_logpolar(&src_img, false, reverse);
@@ -901,6 +945,7 @@ namespace maix::image {
     }
 
     image::Image *Image::lens_corr(double strength, double zoom, double x_corr, double y_corr) {
+        invalidate_cache();
         if (_width % 2 || _height % 2) {
             log::error("lens_corr image size must be even");
             return this;
@@ -913,6 +958,7 @@ namespace maix::image {
     }
 
     image::Image *Image::rotation_corr(double x_rotation, double y_rotation, double z_rotation, double x_translation, double y_translation, double zoom, double fov, std::vector<float> corners) {
+        invalidate_cache();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
         imlib_rotation_corr(&src_img, x_rotation, y_rotation, z_rotation, x_translation, y_translation, zoom, fov, (float *)corners.data());
@@ -1187,6 +1233,7 @@ namespace maix::image {
     }
 
     image::Image *Image::flood_fill(int x, int y, float seed_threshold, float floating_threshold, image::Color color , bool invert, bool clear_background, image::Image *mask) {
+        invalidate_cache();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -1200,6 +1247,7 @@ namespace maix::image {
     }
 
     image::Image *Image::erode(int size, int threshold, image::Image *mask) {
+        invalidate_cache();
         err::check_bool_raise(size > 0, "erode size must be greater than 0");
         err::check_bool_raise(threshold == -1 || threshold >= 0, "erode threshold must be greater than or equal to 0");
 
@@ -1220,6 +1268,7 @@ namespace maix::image {
     }
 
     image::Image *Image::dilate(int size, int threshold, image::Image *mask) {
+        invalidate_cache();
         err::check_bool_raise(size > 0, "dilate size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "dilate threshold must be greater than or equal to 0");
 
@@ -1236,6 +1285,7 @@ namespace maix::image {
     }
 
     image::Image *Image::open(int size, int threshold, image::Image *mask) {
+        invalidate_cache();
         err::check_bool_raise(size > 0, "open size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "open threshold must be greater than or equal to 0");
 
@@ -1252,6 +1302,7 @@ namespace maix::image {
     }
 
     image::Image *Image::close(int size, int threshold, image::Image *mask) {
+        invalidate_cache();
         err::check_bool_raise(size > 0, "close size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "close threshold must be greater than or equal to 0");
 
@@ -1268,6 +1319,7 @@ namespace maix::image {
     }
 
     image::Image *Image::top_hat(int size, int threshold, image::Image *mask) {
+        invalidate_cache();
         err::check_bool_raise(size > 0, "top_hat size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "top_hat threshold must be greater than or equal to 0");
 
@@ -1284,6 +1336,7 @@ namespace maix::image {
     }
 
     image::Image *Image::black_hat(int size, int threshold, image::Image *mask) {
+        invalidate_cache();
         err::check_bool_raise(size > 0, "black_hat size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "black_hat threshold must be greater than or equal to 0");
 
@@ -0,0 +1,359 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#include "maix_image_overlay.hpp"
+#include "maix_image_blend.hpp"
+#include "maix_log.hpp"
+#include <string.h>
+#include <algorithm>
+#include <mutex>
+
+namespace maix::image
+{
+    #define OVERLAY_TILE_W      32
+    #define OVERLAY_TILE_H      16
+
+    typedef struct
+    {
+        int x, y, w, h; // unit: tile
+    } overlay_rect_t;
+
+    typedef struct
+    {
+        int id;
+        int x;
+        int y;
+        image::BlendMode mode;
+        float alpha;
+        bool visible;
+        blend_premul_t premul;
+        int tiles_x;
+        int tiles_y;
+        std::vector<uint8_t> tiles;       // tile has visible pixel or not
+        std::vector<overlay_rect_t> rects; // merged visible tiles
+    } overlay_layer_t;
+
+    typedef struct
+    {
+        int width;
+        int height;
+        image::Format format;
+        int sub_x; // max subsample of format planes, position of layers are aligned to it
+        int sub_y;
+        int next_id;
+        std::vector<overlay_layer_t *> layers; // bottom to top
+        std::mutex mutex;
+    } overlay_param_t;
+
+    static overlay_layer_t *_find_layer(overlay_param_t *param, int id)
+    {
+        for (auto layer : param->layers)
+        {
+            if (layer->id == id)
+                return layer;
+        }
+        return nullptr;
+    }
+
+    /**
+     * Update visible flag of tiles [tx0, tx1) x [ty0, ty1), by alpha of the first plane
+     */
+    static void _update_tiles(overlay_layer_t *layer, int tx0, int ty0, int tx1, int ty1)
+    {
+        const blend_premul_t &premul = layer->premul;
+        const blend_plane_t &plane = premul.layout.planes[0];
+        const uint8_t *a = premul.a[0].data();
+        for (int ty = ty0; ty < ty1; ++ty)
+        {
+            int y1 = std::min((ty + 1) * OVERLAY_TILE_H, premul.h);
+            for (int tx = tx0; tx < tx1; ++tx)
+            {
+                int x0 = tx * OVERLAY_TILE_W * plane.bpp;
+                int n = (std::min((tx + 1) * OVERLAY_TILE_W, premul.w) - tx * OVERLAY_TILE_W) * plane.bpp;
+                bool visible = false;
+                for (int y = ty * OVERLAY_TILE_H; y < y1 && !visible; ++y)
+                {
+                    const uint8_t *row = a + y * plane.stride + x0;
+                    for (int i = 0; i < n; ++i)
+                    {
+                        if (row[i])
+                        {
+                            visible = true;
+                            break;
+                        }
+                    }
+                }
+                layer->tiles[ty * layer->tiles_x + tx] = visible;
+            }
+        }
+    }
+
+    /**
+     * Merge visible tiles to rectangles, horizontal runs first, then runs with the same span in adjacent rows
+     */
+    static void _update_rects(overlay_layer_t *layer)
+    {
+        layer->rects.clear();
+        size_t open = 0; // rects extended to the previous row start from here
+        for (int ty = 0; ty < layer->tiles_y; ++ty)
+        {
+            size_t row_start = layer->rects.size();
+            const uint8_t *tiles = layer->tiles.data() + ty * layer->tiles_x;
+            for (int tx = 0; tx < layer->tiles_x;)
+            {
+                if (!tiles[tx])
+                {
+                    ++tx;
+                    continue;
+                }
+                int start = tx;
+                while (tx < layer->tiles_x && tiles[tx])
+                    ++tx;
+                bool merged = false;
+                for (size_t i = open; i < row_start; ++i)
+                {
+                    overlay_rect_t &r = layer->rects[i];
+                    if (r.x == start && r.w == tx - start && r.y + r.h == ty)
+                    {
+                        ++r.h;
+                        merged = true;
+                        break;
+                    }
+                }
+                if (!merged)
+                    layer->rects.push_back({start, ty, tx - start, 1});
+            }
+            // keep rects ending at this row open for the next row
+            size_t keep = layer->rects.size();
+            for (size_t i = open; i < layer->rects.size(); ++i)
+            {
+                if (layer->rects[i].y + layer->rects[i].h == ty + 1)
+                {
+                    keep = i;
+                    break;
+                }
+            }
+            open = keep;
+        }
+    }
+
+    static void _prepare_layer(overlay_param_t *param, overlay_layer_t *layer, image::Image &img)
+    {
+        blend_prepare(img, 0, 0, img.width(), img.height(), param->format, layer->alpha, layer->premul);
+        layer->tiles_x = (img.width() + OVERLAY_TILE_W - 1) / OVERLAY_TILE_W;
+        layer->tiles_y = (img.height() + OVERLAY_TILE_H - 1) / OVERLAY_TILE_H;
+        layer->tiles.assign(layer->tiles_x * layer->tiles_y, 0);
+        _update_tiles(layer, 0, 0, layer->tiles_x, layer->tiles_y);
+        _update_rects(layer);
+    }
+
+    Overlay::Overlay(int width, int height, image::Format format)
+    {
+        blend_layout_t layout;
+        if (width <= 0 || height <= 0 || !blend_get_layout(format, width, height, layout))
+            throw err::Exception(err::ERR_ARGS, "overlay not support format " + image::fmt_names[format]);
+        overlay_param_t *param = new overlay_param_t();
+        param->width = width;
+        param->height = height;
+        param->format = format;
+        param->sub_x = 1;
+        param->sub_y = 1;
+        for (int i = 0; i < layout.num; ++i)
+        {
+            param->sub_x = std::max(param->sub_x, layout.planes[i].sub_x);
+            param->sub_y = std::max(param->sub_y, layout.planes[i].sub_y);
+        }
+        param->next_id = 0;
+        _param = param;
+    }
+
+    Overlay::~Overlay()
+    {
+        overlay_param_t *param = (overlay_param_t *)_param;
+        for (auto layer : param->layers)
+            delete layer;
+        delete param;
+    }
+
+    int Overlay::add_layer(image::Image &img, int x, int y, image::BlendMode mode, float alpha)
+    {
+        overlay_param_t *param = (overlay_param_t *)_param;
+        blend_layout_t layout;
+        if (!blend_get_layout(img.format(), img.width(), img.height(), layout))
+        {
+            log::error("overlay layer not support format %s\n", image::fmt_names[img.format()].c_str());
+            return -1;
+        }
+        if (mode < 0 || mode >= BLEND_MODE_MAX)
+        {
+            log::error("invalid blend mode %d\n", mode);
+            return -1;
+        }
+        overlay_layer_t *layer = new overlay_layer_t();
+        layer->x = x & ~(param->sub_x - 1);
+        layer->y = y & ~(param->sub_y - 1);
+        layer->mode = mode;
+        layer->alpha = std::min(std::max(alpha, 0.0f), 1.0f);
+        layer->visible = true;
+        _prepare_layer(param, layer, img);
+        std::lock_guard<std::mutex> lock(param->mutex);
+        layer->id = param->next_id++;
+        param->layers.push_back(layer);
+        return layer->id;
+    }
+
+    err::Err Overlay::update_layer(int id, image::Image &img, const std::vector<int> &roi)
+    {
+        overlay_param_t *param = (overlay_param_t *)_param;
+        std::lock_guard<std::mutex> lock(param->mutex);
+        overlay_layer_t *layer = _find_layer(param, id);
+        if (!layer)
+            return err::ERR_ARGS;
+        blend_layout_t layout;
+        if (!blend_get_layout(img.format(), img.width(), img.height(), layout))
+        {
+            log::error("overlay layer not support format %s\n", image::fmt_names[img.format()].c_str());
+            return err::ERR_ARGS;
+        }
+        if (roi.empty())
+        {
+            _prepare_layer(param, layer, img);
+            return err::ERR_NONE;
+        }
+        if (roi.size() != 4 || img.width() != layer->premul.w || img.height() != layer->premul.h)
+            return err::ERR_ARGS;
+        // align to subsample, so chroma blocks are the same as the whole layer
+        int x0 = std::max(roi[0], 0) & ~(param->sub_x - 1);
+        int y0 = std::max(roi[1], 0) & ~(param->sub_y - 1);
+        int x1 = std::min(roi[0] + roi[2], img.width());
+        int y1 = std::min(roi[1] + roi[3], img.height());
+        if (x0 >= x1 || y0 >= y1)
+            return err::ERR_NONE;
+        x1 = std::min((x1 + param->sub_x - 1) & ~(param->sub_x - 1), img.width());
+        y1 = std::min((y1 + param->sub_y - 1) & ~(param->sub_y - 1), img.height());
+        static thread_local blend_premul_t region;
+        blend_prepare(img, x0, y0, x1 - x0, y1 - y0, param->format, layer->alpha, region);
+        blend_premul_t &premul = layer->premul;
+        for (int i = 0; i < premul.layout.num; ++i)
+        {
+            const blend_plane_t &plane = premul.layout.planes[i];
+            const blend_plane_t &region_plane = region.layout.planes[i];
+            int offset = y0 / plane.sub_y * plane.stride + x0 / plane.sub_x * plane.bpp;
+            int bytes = (x1 - x0 + plane.sub_x - 1) / plane.sub_x * plane.bpp;
+            int rows = (y1 - y0 + plane.sub_y - 1) / plane.sub_y;
+            for (int r = 0; r < rows; ++r)
+            {
+                memcpy(premul.p[i].data() + offset + r * plane.stride, region.p[i].data() + r * region_plane.stride, bytes);
+                memcpy(premul.a[i].data() + offset + r * plane.stride, region.a[i].data() + r * region_plane.stride, bytes);
+            }
+        }
+        _update_tiles(layer, x0 / OVERLAY_TILE_W, y0 / OVERLAY_TILE_H,
+                      (x1 + OVERLAY_TILE_W - 1) / OVERLAY_TILE_W, (y1 + OVERLAY_TILE_H - 1) / OVERLAY_TILE_H);
+        _update_rects(layer);
+        return err::ERR_NONE;
+    }
+
+    err::Err Overlay::move_layer(int id, int x, int y)
+    {
+        overlay_param_t *param = (overlay_param_t *)_param;
+        std::lock_guard<std::mutex> lock(param->mutex);
+        overlay_layer_t *layer = _find_layer(param, id);
+        if (!layer)
+            return err::ERR_ARGS;
+        layer->x = x & ~(param->sub_x - 1);
+        layer->y = y & ~(param->sub_y - 1);
+        return err::ERR_NONE;
+    }
+
+    err::Err Overlay::show_layer(int id, bool visible)
+    {
+        overlay_param_t *param = (overlay_param_t *)_param;
+        std::lock_guard<std::mutex> lock(param->mutex);
+        overlay_layer_t *layer = _find_layer(param, id);
+        if (!layer)
+            return err::ERR_ARGS;
+        layer->visible = visible;
+        return err::ERR_NONE;
+    }
+
+    err::Err Overlay::remove_layer(int id)
+    {
+        overlay_param_t *param = (overlay_param_t *)_param;
+        std::lock_guard<std::mutex> lock(param->mutex);
+        for (auto it = param->layers.begin(); it != param->layers.end(); ++it)
+        {
+            if ((*it)->id == id)
+            {
+                delete *it;
+                param->layers.erase(it);
+                return err::ERR_NONE;
+            }
+        }
+        return err::ERR_ARGS;
+    }
+
+    err::Err Overlay::composite(image::Image &img)
+    {
+        overlay_param_t *param = (overlay_param_t *)_param;
+        if (img.width() != param->width || img.height() != param->height || img.format() != param->format)
+        {
+            log::error("overlay is %dx%d %s, but image is %dx%d %s\n", param->width, param->height, image::fmt_names[param->format].c_str(),
+                       img.width(), img.height(), image::fmt_names[img.format()].c_str());
+            return err::ERR_ARGS;
+        }
+        img.invalidate_cache();
+        std::lock_guard<std::mutex> lock(param->mutex);
+        for (auto layer : param->layers)
+        {
+            if (!layer->visible)
+                continue;
+            for (auto &r : layer->rects)
+            {
+                blend_composite(img, layer->x, layer->y, layer->premul, r.x * OVERLAY_TILE_W, r.y * OVERLAY_TILE_H,
+                                r.w * OVERLAY_TILE_W, r.h * OVERLAY_TILE_H, layer->mode);
+            }
+        }
+        return err::ERR_NONE;
+    }
+
+    std::vector<std::vector<int>> Overlay::dirty_rects()
+    {
+        overlay_param_t *param = (overlay_param_t *)_param;
+        std::lock_guard<std::mutex> lock(param->mutex);
+        std::vector<std::vector<int>> rects;
+        for (auto layer : param->layers)
+        {
+            if (!layer->visible)
+                continue;
+            for (auto &r : layer->rects)
+            {
+                int x0 = std::max(layer->x + r.x * OVERLAY_TILE_W, 0);
+                int y0 = std::max(layer->y + r.y * OVERLAY_TILE_H, 0);
+                int x1 = std::min(layer->x + std::min((r.x + r.w) * OVERLAY_TILE_W, layer->premul.w), param->width);
+                int y1 = std::min(layer->y + std::min((r.y + r.h) * OVERLAY_TILE_H, layer->premul.h), param->height);
+                if (x0 < x1 && y0 < y1)
+                    rects.push_back({x0, y0, x1 - x0, y1 - y0});
+            }
+        }
+        return rects;
+    }
+
+    int Overlay::width()
+    {
+        return ((overlay_param_t *)_param)->width;
+    }
+
+    int Overlay::height()
+    {
+        return ((overlay_param_t *)_param)->height;
+    }
+
+    image::Format Overlay::format()
+    {
+        return ((overlay_param_t *)_param)->format;
+    }
+} // namespace maix::image
@@ -0,0 +1,249 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#include "maix_image_pool.hpp"
+#include "maix_log.hpp"
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace maix::image
+{
+    #define POOL_ALIGN          4096
+    #define POOL_MIN_BLOCK      4096
+    #define POOL_CLASS_STEPS    8       // size classes between two powers of 2
+
+    static int64_t _default_max_cached_size()
+    {
+        long pages = sysconf(_SC_PHYS_PAGES);
+        long page_size = sysconf(_SC_PAGESIZE);
+        if (pages <= 0 || page_size <= 0)
+            return 32 * 1024 * 1024;
+        return (int64_t)pages * page_size / 8;
+    }
+
+    size_t BufferPool::block_size(size_t size)
+    {
+        if (size <= POOL_MIN_BLOCK)
+            return POOL_MIN_BLOCK;
+        // base is the max power of 2 < size, round up to base + n * base / POOL_CLASS_STEPS
+        size_t base = (size_t)1 << (sizeof(size_t) * 8 - 1 - __builtin_clzl(size - 1));
+        size_t step = base / POOL_CLASS_STEPS;
+        return base + (size - base + step - 1) / step * step;
+    }
+
+    BufferPool::BufferPool(int64_t max_cached_size)
+    {
+        _max_cached_size = max_cached_size < 0 ? _default_max_cached_size() : max_cached_size;
+        _cached_size = 0;
+        _in_use_size = 0;
+    }
+
+    BufferPool::~BufferPool()
+    {
+        clear();
+    }
+
+    void *BufferPool::_sys_alloc(size_t size)
+    {
+        if (_alloc_func)
+            return _alloc_func(size);
+        void *ptr = nullptr;
+        if (posix_memalign(&ptr, POOL_ALIGN, size) != 0)
+            return nullptr;
+        return ptr;
+    }
+
+    void BufferPool::_sys_free(void *ptr)
+    {
+        if (_free_func)
+            _free_func(ptr);
+        else
+            ::free(ptr);
+    }
+
+    void *BufferPool::alloc(size_t size)
+    {
+        size_t block = block_size(size);
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            SizeClass &c = _classes[block];
+            c.stat.block_size = block;
+            c.stat.in_use++;
+            _in_use_size += block;
+            if (!c.free_list.empty())
+            {
+                void *ptr = c.free_list.back();
+                c.free_list.pop_back();
+                c.stat.cached--;
+                c.stat.hits++;
+                _cached_size -= block;
+                return ptr;
+            }
+            c.stat.misses++;
+        }
+        void *ptr = _sys_alloc(block);
+        if (!ptr)
+        {
+            // release cached buffers of other sizes and try again
+            clear();
+            ptr = _sys_alloc(block);
+        }
+        if (!ptr)
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            SizeClass &c = _classes[block];
+            c.stat.in_use--;
+            _in_use_size -= block;
+        }
+        return ptr;
+    }
+
+    void BufferPool::free(void *ptr, size_t size)
+    {
+        if (!ptr)
+            return;
+        size_t block = block_size(size);
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            SizeClass &c = _classes[block];
+            c.stat.in_use--;
+            _in_use_size -= block;
+            if (_cached_size + (int64_t)block <= _max_cached_size)
+            {
+                c.free_list.push_back(ptr);
+                c.stat.cached++;
+                _cached_size += block;
+                return;
+            }
+            c.stat.drops++;
+        }
+        _sys_free(ptr);
+    }
+
+    void BufferPool::_trim(int64_t max_cached_size)
+    {
+        std::vector<void *> release;
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            // release big buffers first
+            std::vector<size_t> blocks;
+            for (auto &item : _classes)
+                blocks.push_back(item.first);
+            std::sort(blocks.begin(), blocks.end(), std::greater<size_t>());
+            for (size_t block : blocks)
+            {
+                SizeClass &c = _classes[block];
+                while (_cached_size > max_cached_size && !c.free_list.empty())
+                {
+                    release.push_back(c.free_list.back());
+                    c.free_list.pop_back();
+                    c.stat.cached--;
+                    _cached_size -= block;
+                }
+            }
+        }
+        for (void *ptr : release)
+            _sys_free(ptr);
+    }
+
+    void BufferPool::set_max_cached_size(int64_t max_cached_size)
+    {
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _max_cached_size = max_cached_size < 0 ? _default_max_cached_size() : max_cached_size;
+        }
+        _trim(_max_cached_size);
+    }
+
+    int64_t BufferPool::max_cached_size()
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        return _max_cached_size;
+    }
+
+    int64_t BufferPool::cached_size()
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        return _cached_size;
+    }
+
+    int64_t BufferPool::in_use_size()
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        return _in_use_size;
+    }
+
+    void BufferPool::clear()
+    {
+        _trim(0);
+    }
+
+    std::vector<image::BufferPoolStat> BufferPool::stats()
+    {
+        std::vector<image::BufferPoolStat> ret;
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            for (auto &item : _classes)
+                ret.push_back(item.second.stat);
+        }
+        std::sort(ret.begin(), ret.end(), [](const image::BufferPoolStat &a, const image::BufferPoolStat &b)
+                  { return a.block_size < b.block_size; });
+        return ret;
+    }
+
+    err::Err BufferPool::set_allocator(std::function<void *(size_t)> alloc_func, std::function<void(void *)> free_func)
+    {
+        if (in_use_size() > 0)
+        {
+            log::error("can not change allocator when image buffers are in use\n");
+            return err::ERR_NOT_PERMIT;
+        }
+        clear();
+        std::lock_guard<std::mutex> guard(_lock);
+        _alloc_func = alloc_func;
+        _free_func = free_func;
+        return err::ERR_NONE;
+    }
+
+    image::BufferPool &buffer_pool()
+    {
+        // never destructed, images may be released after static objects destructed
+        static image::BufferPool *pool = new image::BufferPool();
+        return *pool;
+    }
+
+    void set_pool_max_size(int64_t max_cached_size)
+    {
+        buffer_pool().set_max_cached_size(max_cached_size);
+    }
+
+    std::map<std::string, int64_t> pool_stats()
+    {
+        image::BufferPool &pool = buffer_pool();
+        std::map<std::string, int64_t> ret;
+        int64_t hits = 0, misses = 0, drops = 0;
+        for (auto &s : pool.stats())
+        {
+            hits += s.hits;
+            misses += s.misses;
+            drops += s.drops;
+        }
+        ret["max_cached_size"] = pool.max_cached_size();
+        ret["cached_size"] = pool.cached_size();
+        ret["in_use_size"] = pool.in_use_size();
+        ret["hits"] = hits;
+        ret["misses"] = misses;
+        ret["drops"] = drops;
+        return ret;
+    }
+
+    void pool_clear()
+    {
+        buffer_pool().clear();
+    }
+} // namespace maix::image
@@ -0,0 +1,594 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#include "maix_image_preprocess.hpp"
+#include "maix_log.hpp"
+#include "maix_thread.hpp"
+#include <math.h>
+#include <mutex>
+
+namespace maix::image
+{
+    typedef float v4f __attribute__((vector_size(16)));
+    typedef float v4f_u __attribute__((vector_size(16), aligned(4))); // unaligned access
+
+    enum src_kind_t
+    {
+        SRC_RGB = 0, // packed 3 or 4 bytes, planes R G B
+        SRC_GRAY,    // one plane
+        SRC_YUV,     // semi planar yuv420, planes Y U V
+    };
+
+    /**
+     * Sample position of one output axis, only content area(not include letterbox border)
+     */
+    struct axis_map_t
+    {
+        int offset = 0;         // content start in output
+        int len = 0;            // content length in output
+        std::vector<int> i0;    // first source index
+        std::vector<int> i1;    // second source index
+        std::vector<float> w;   // weight of second source index
+    };
+
+    /**
+     * Per thread buffers
+     */
+    struct thread_buff_t
+    {
+        std::vector<float> rows[2]; // horizontal resampled source rows, planes with stride cw4
+        int row_id[2] = {-1, -1};
+        std::vector<float> blend;   // vertical blended planes
+        std::vector<float> color;   // output channel planes
+    };
+
+    typedef struct
+    {
+        int threads; // 0 means thread::parallel_threads()
+        std::mutex lock;
+        std::vector<thread_buff_t> buffs; // one for each band
+        // geometry cache
+        int src_w = -1, src_h = -1, dst_w = -1, dst_h = -1;
+        image::Fit fit = image::Fit::FIT_FILL;
+        axis_map_t xmap, ymap;
+    } preprocess_param_t;
+
+    static void _build_axis(axis_map_t &m, int src_len, int offset, int len, float src_start, float step)
+    {
+        m.offset = offset;
+        m.len = len;
+        m.i0.resize(len);
+        m.i1.resize(len);
+        m.w.resize(len);
+        for (int i = 0; i < len; ++i)
+        {
+            float f = src_start + (i + 0.5f) * step - 0.5f;
+            int i0 = (int)floorf(f);
+            float w = f - i0;
+            if (i0 < 0)
+            {
+                i0 = 0;
+                w = 0;
+            }
+            if (i0 >= src_len - 1)
+            {
+                i0 = src_len - 1;
+                w = 0;
+            }
+            m.i0[i] = i0;
+            m.i1[i] = i0 + 1 < src_len ? i0 + 1 : i0;
+            m.w[i] = w;
+        }
+    }
+
+    static void _build_maps(preprocess_param_t *p, int sw, int sh, int dw, int dh, image::Fit fit)
+    {
+        if (p->src_w == sw && p->src_h == sh && p->dst_w == dw && p->dst_h == dh && p->fit == fit)
+            return;
+        p->src_w = sw;
+        p->src_h = sh;
+        p->dst_w = dw;
+        p->dst_h = dh;
+        p->fit = fit;
+        if (fit == image::Fit::FIT_CONTAIN)
+        {
+            // same as image.resize, keep aspect ratio and center
+            float r = std::min((float)dw / sw, (float)dh / sh);
+            int cw = std::min(dw, std::max(1, (int)roundf(sw * r)));
+            int ch = std::min(dh, std::max(1, (int)roundf(sh * r)));
+            _build_axis(p->xmap, sw, (dw - cw) / 2, cw, 0, (float)sw / cw);
+            _build_axis(p->ymap, sh, (dh - ch) / 2, ch, 0, (float)sh / ch);
+        }
+        else if (fit == image::Fit::FIT_COVER)
+        {
+            // keep aspect ratio and crop center
+            float r = std::max((float)dw / sw, (float)dh / sh);
+            _build_axis(p->xmap, sw, 0, dw, (sw - dw / r) / 2, 1 / r);
+            _build_axis(p->ymap, sh, 0, dh, (sh - dh / r) / 2, 1 / r);
+        }
+        else
+        {
+            _build_axis(p->xmap, sw, 0, dw, 0, (float)sw / dw);
+            _build_axis(p->ymap, sh, 0, dh, 0, (float)sh / dh);
+        }
+    }
+
+    /**
+     * Output description of one run
+     */
+    struct job_t
+    {
+        const uint8_t *src;
+        int src_w, src_h;
+        src_kind_t kind;
+        int bpp;          // bytes per pixel for SRC_RGB
+        int off[3];       // R G B byte offset for SRC_RGB, U V byte offset for SRC_YUV
+        uint8_t *dst;
+        int dst_w, dst_h, dst_c;
+        bool bgr;
+        bool chw;
+        tensor::DType dtype;
+        float a[3], b[3]; // out = pixel * a + b, quantization included
+        float q_min, q_max;
+        const axis_map_t *xmap, *ymap;
+        int cw4;          // plane stride, content width align to 4
+    };
+
+    static void _hpass(const job_t &j, int r, float *out)
+    {
+        const axis_map_t &m = *j.xmap;
+        const int *x0 = m.i0.data();
+        const int *x1 = m.i1.data();
+        const float *wx = m.w.data();
+        int n = m.len;
+        int stride = j.cw4;
+        if (j.kind == SRC_RGB)
+        {
+            const uint8_t *row = j.src + (size_t)r * j.src_w * j.bpp;
+            int bpp = j.bpp;
+            for (int k = 0; k < 3; ++k)
+            {
+                const uint8_t *base = row + j.off[k];
+                float *o = out + k * stride;
+                for (int x = 0; x < n; ++x)
+                {
+                    float p0 = base[x0[x] * bpp];
+                    float p1 = base[x1[x] * bpp];
+                    o[x] = p0 + (p1 - p0) * wx[x];
+                }
+            }
+        }
+        else if (j.kind == SRC_GRAY)
+        {
+            const uint8_t *row = j.src + (size_t)r * j.src_w;
+            for (int x = 0; x < n; ++x)
+            {
+                float p0 = row[x0[x]];
+                float p1 = row[x1[x]];
+                out[x] = p0 + (p1 - p0) * wx[x];
+            }
+        }
+        else
+        {
+            // chroma is nearest upsampled, then bilinear with luma weights
+            const uint8_t *row = j.src + (size_t)r * j.src_w;
+            const uint8_t *uv = j.src + (size_t)j.src_w * j.src_h + (size_t)(r >> 1) * j.src_w;
+            float *oy = out;
+            float *ou = out + stride;
+            float *ov = out + 2 * stride;
+            for (int x = 0; x < n; ++x)
+            {
+                float w = wx[x];
+                float p0 = row[x0[x]];
+                float p1 = row[x1[x]];
+                oy[x] = p0 + (p1 - p0) * w;
+                const uint8_t *c0 = uv + (x0[x] & ~1);
+                const uint8_t *c1 = uv + (x1[x] & ~1);
+                p0 = c0[j.off[0]];
+                p1 = c1[j.off[0]];
+                ou[x] = p0 + (p1 - p0) * w;
+                p0 = c0[j.off[1]];
+                p1 = c1[j.off[1]];
+                ov[x] = p0 + (p1 - p0) * w;
+            }
+        }
+    }
+
+    static const float *_get_row(const job_t &j, thread_buff_t &buff, int r)
+    {
+        if (buff.row_id[0] == r)
+            return buff.rows[0].data();
+        if (buff.row_id[1] == r)
+            return buff.rows[1].data();
+        // replace the older one, rows are visited from top to bottom
+        int slot = (buff.row_id[0] < buff.row_id[1]) ? 0 : 1;
+        _hpass(j, r, buff.rows[slot].data());
+        buff.row_id[slot] = r;
+        return buff.rows[slot].data();
+    }
+
+    static void _vblend(const float *__restrict r0, const float *__restrict r1, float *__restrict out, float w, int n4)
+    {
+        v4f vw = {w, w, w, w};
+        for (int x = 0; x < n4; x += 4)
+        {
+            v4f p0 = *(const v4f *)(r0 + x);
+            v4f p1 = *(const v4f *)(r1 + x);
+            *(v4f *)(out + x) = p0 + (p1 - p0) * vw;
+        }
+    }
+
+    static inline v4f _clamp255(v4f v)
+    {
+        v4f zero = {0, 0, 0, 0};
+        v4f max = {255, 255, 255, 255};
+        v = v < zero ? zero : v;
+        return v > max ? max : v;
+    }
+
+    /**
+     * Blended source planes to output channel planes, return R G B(or gray) plane pointers
+     */
+    static void _convert(const job_t &j, const float *src, float *color, const float *chan[3])
+    {
+        int stride = j.cw4;
+        if (j.kind == SRC_RGB)
+        {
+            if (j.dst_c == 3)
+            {
+                chan[0] = src;
+                chan[1] = src + stride;
+                chan[2] = src + 2 * stride;
+                return;
+            }
+            v4f kr = {0.299f, 0.299f, 0.299f, 0.299f};
+            v4f kg = {0.587f, 0.587f, 0.587f, 0.587f};
+            v4f kb = {0.114f, 0.114f, 0.114f, 0.114f};
+            for (int x = 0; x < stride; x += 4)
+            {
+                v4f r = *(const v4f *)(src + x);
+                v4f g = *(const v4f *)(src + stride + x);
+                v4f b = *(const v4f *)(src + 2 * stride + x);
+                *(v4f *)(color + x) = r * kr + g * kg + b * kb;
+            }
+            chan[0] = color;
+            return;
+        }
+        if (j.kind == SRC_GRAY || j.dst_c == 1)
+        {
+            // gray from YUV is Y plane
+            chan[0] = chan[1] = chan[2] = src;
+            return;
+        }
+        // BT.601 limited range, same as COLOR_YUV2RGB_NV21 of OpenCV
+        v4f k16 = {16, 16, 16, 16};
+        v4f k128 = {128, 128, 128, 128};
+        v4f zero = {0, 0, 0, 0};
+        v4f cy = {1.164f, 1.164f, 1.164f, 1.164f};
+        v4f cvr = {1.596f, 1.596f, 1.596f, 1.596f};
+        v4f cug = {-0.391f, -0.391f, -0.391f, -0.391f};
+        v4f cvg = {-0.813f, -0.813f, -0.813f, -0.813f};
+        v4f cub = {2.018f, 2.018f, 2.018f, 2.018f};
+        float *r = color, *g = color + stride, *b = color + 2 * stride;
+        for (int x = 0; x < stride; x += 4)
+        {
+            v4f y = *(const v4f *)(src + x) - k16;
+            y = (y < zero ? zero : y) * cy;
+            v4f u = *(const v4f *)(src + stride + x) - k128;
+            v4f v = *(const v4f *)(src + 2 * stride + x) - k128;
+            *(v4f *)(r + x) = _clamp255(y + v * cvr);
+            *(v4f *)(g + x) = _clamp255(y + u * cug + v * cvg);
+            *(v4f *)(b + x) = _clamp255(y + u * cub);
+        }
+        chan[0] = r;
+        chan[1] = g;
+        chan[2] = b;
+    }
+
+    template <typename T>
+    static inline T _quant(float v, float q_min, float q_max)
+    {
+        v = v < q_min ? q_min : (v > q_max ? q_max : v);
+        return (T)(v + (v >= 0 ? 0.5f : -0.5f));
+    }
+
+    /**
+     * Write n pixels of channel planes to output row at x offset
+     */
+    static void _store(const job_t &j, const float *chan[3], int y, int x_off, int n)
+    {
+        int c = j.dst_c;
+        size_t hw = (size_t)j.dst_w * j.dst_h;
+        size_t pix = (size_t)y * j.dst_w + x_off;
+        for (int i = 0; i < c; ++i)
+        {
+            const float *__restrict s = chan[j.bgr ? c - 1 - i : i];
+            float a = j.a[i], b = j.b[i];
+            if (j.dtype == tensor::FLOAT32)
+            {
+                float *__restrict d = (float *)j.dst;
+                if (j.chw)
+                {
+                    d += i * hw + pix;
+                    v4f va = {a, a, a, a};
+                    v4f vb = {b, b, b, b};
+                    int x = 0;
+                    for (; x + 4 <= n; x += 4)
+                        *(v4f_u *)(d + x) = *(const v4f *)(s + x) * va + vb;
+                    for (; x < n; ++x)
+                        d[x] = s[x] * a + b;
+                }
+                else
+                {
+                    d += pix * c + i;
+                    for (int x = 0; x < n; ++x)
+                        d[x * c] = s[x] * a + b;
+                }
+            }
+            else if (j.dtype == tensor::INT8)
+            {
+                int8_t *__restrict d = (int8_t *)j.dst;
+                int step = j.chw ? 1 : c;
+                d += j.chw ? i * hw + pix : pix * c + i;
+                for (int x = 0; x < n; ++x)
+                    d[x * step] = _quant<int8_t>(s[x] * a + b, j.q_min, j.q_max);
+            }
+            else
+            {
+                uint8_t *__restrict d = (uint8_t *)j.dst;
+                int step = j.chw ? 1 : c;
+                d += j.chw ? i * hw + pix : pix * c + i;
+                for (int x = 0; x < n; ++x)
+                    d[x * step] = _quant<uint8_t>(s[x] * a + b, j.q_min, j.q_max);
+            }
+        }
+    }
+
+    /**
+     * Fill letterbox border with black pixel value
+     */
+    static void _fill(const job_t &j, int y, int x_off, int n)
+    {
+        if (n <= 0)
+            return;
+        int c = j.dst_c;
+        size_t hw = (size_t)j.dst_w * j.dst_h;
+        size_t pix = (size_t)y * j.dst_w + x_off;
+        for (int i = 0; i < c; ++i)
+        {
+            int step = j.chw ? 1 : c;
+            size_t start = j.chw ? i * hw + pix : pix * c + i;
+            if (j.dtype == tensor::FLOAT32)
+            {
+                float *d = (float *)j.dst + start;
+                for (int x = 0; x < n; ++x)
+                    d[x * step] = j.b[i];
+            }
+            else if (j.dtype == tensor::INT8)
+            {
+                int8_t v = _quant<int8_t>(j.b[i], j.q_min, j.q_max);
+                int8_t *d = (int8_t *)j.dst + start;
+                for (int x = 0; x < n; ++x)
+                    d[x * step] = v;
+            }
+            else
+            {
+                uint8_t v = _quant<uint8_t>(j.b[i], j.q_min, j.q_max);
+                uint8_t *d = (uint8_t *)j.dst + start;
+                for (int x = 0; x < n; ++x)
+                    d[x * step] = v;
+            }
+        }
+    }
+
+    static void _process_rows(const job_t &j, thread_buff_t &buff, int y_start, int y_end)
+    {
+        const axis_map_t &xm = *j.xmap;
+        const axis_map_t &ym = *j.ymap;
+        int src_planes = j.kind == SRC_GRAY ? 1 : 3;
+        size_t plane_size = (size_t)j.cw4 * src_planes;
+        for (int k = 0; k < 2; ++k)
+        {
+            if (buff.rows[k].size() < plane_size)
+                buff.rows[k].resize(plane_size);
+            buff.row_id[k] = -1;
+        }
+        if (buff.blend.size() < plane_size)
+            buff.blend.resize(plane_size);
+        if (buff.color.size() < (size_t)j.cw4 * 3)
+            buff.color.resize((size_t)j.cw4 * 3);
+        for (int y = y_start; y < y_end; ++y)
+        {
+            int cy = y - ym.offset;
+            if (cy < 0 || cy >= ym.len)
+            {
+                _fill(j, y, 0, j.dst_w);
+                continue;
+            }
+            const float *r0 = _get_row(j, buff, ym.i0[cy]);
+            const float *src = r0;
+            if (ym.w[cy] != 0)
+            {
+                const float *r1 = _get_row(j, buff, ym.i1[cy]);
+                r0 = _get_row(j, buff, ym.i0[cy]);
+                _vblend(r0, r1, buff.blend.data(), ym.w[cy], (int)plane_size);
+                src = buff.blend.data();
+            }
+            const float *chan[3];
+            _convert(j, src, buff.color.data(), chan);
+            _fill(j, y, 0, xm.offset);
+            _store(j, chan, y, xm.offset, xm.len);
+            _fill(j, y, xm.offset + xm.len, j.dst_w - xm.offset - xm.len);
+        }
+    }
+
+    Preprocessor::Preprocessor(int threads)
+    {
+        preprocess_param_t *param = new preprocess_param_t();
+        param->threads = threads > 0 ? threads : 0;
+        _param = param;
+    }
+
+    Preprocessor::~Preprocessor()
+    {
+        preprocess_param_t *param = (preprocess_param_t *)_param;
+        if (param)
+        {
+            delete param;
+            _param = nullptr;
+        }
+    }
+
+    int Preprocessor::threads()
+    {
+        preprocess_param_t *param = (preprocess_param_t *)_param;
+        return param->threads > 0 ? param->threads : thread::parallel_threads();
+    }
+
+    err::Err Preprocessor::run(image::Image &img, void *dst, int width, int height, image::Format format, tensor::DType dtype, bool chw,
+                               const std::vector<float> &mean, const std::vector<float> &scale, image::Fit fit,
+                               float qscale, int zero_point)
+    {
+        preprocess_param_t *param = (preprocess_param_t *)_param;
+        if (!dst || width <= 0 || height <= 0 || img.width() <= 0 || img.height() <= 0 || !img.data())
+            return err::ERR_ARGS;
+        job_t j;
+        j.src = (const uint8_t *)img.data();
+        j.src_w = img.width();
+        j.src_h = img.height();
+        j.bpp = 1;
+        switch (img.format())
+        {
+        case image::FMT_RGB888:
+        case image::FMT_BGR888:
+        case image::FMT_RGBA8888:
+        case image::FMT_BGRA8888:
+        {
+            bool src_bgr = img.format() == image::FMT_BGR888 || img.format() == image::FMT_BGRA8888;
+            j.kind = SRC_RGB;
+            j.bpp = (img.format() == image::FMT_RGB888 || img.format() == image::FMT_BGR888) ? 3 : 4;
+            j.off[0] = src_bgr ? 2 : 0;
+            j.off[1] = 1;
+            j.off[2] = src_bgr ? 0 : 2;
+            break;
+        }
+        case image::FMT_GRAYSCALE:
+            j.kind = SRC_GRAY;
+            break;
+        case image::FMT_YVU420SP:
+        case image::FMT_YUV420SP:
+            if ((j.src_w & 1) || (j.src_h & 1))
+            {
+                log::error("yuv420sp image size should be even\n");
+                return err::ERR_ARGS;
+            }
+            j.kind = SRC_YUV;
+            j.off[0] = img.format() == image::FMT_YUV420SP ? 0 : 1; // U
+            j.off[1] = img.format() == image::FMT_YUV420SP ? 1 : 0; // V
+            break;
+        default:
+            log::error("preprocess not support image format %d\n", img.format());
+            return err::ERR_NOT_IMPL;
+        }
+        if (format == image::FMT_RGB888 || format == image::FMT_BGR888)
+            j.dst_c = 3;
+        else if (format == image::FMT_GRAYSCALE)
+            j.dst_c = 1;
+        else
+        {
+            log::error("preprocess output format only support RGB888, BGR888, GRAYSCALE\n");
+            return err::ERR_ARGS;
+        }
+        if (dtype != tensor::FLOAT32 && dtype != tensor::INT8 && dtype != tensor::UINT8)
+        {
+            log::error("preprocess output dtype only support float32, int8, uint8\n");
+            return err::ERR_ARGS;
+        }
+        j.bgr = format == image::FMT_BGR888;
+        j.chw = chw;
+        j.dtype = dtype;
+        j.dst = (uint8_t *)dst;
+        j.dst_w = width;
+        j.dst_h = height;
+        float qk = (dtype == tensor::FLOAT32 || qscale == 0) ? 1 : 1 / qscale;
+        for (int i = 0; i < j.dst_c; ++i)
+        {
+            float m = mean.empty() ? 0 : mean[mean.size() > (size_t)i ? i : 0];
+            float s = scale.empty() ? 1 : scale[scale.size() > (size_t)i ? i : 0];
+            j.a[i] = s * qk;
+            j.b[i] = -m * s * qk;
+            if (dtype != tensor::FLOAT32)
+                j.b[i] += zero_point;
+        }
+        j.q_min = dtype == tensor::INT8 ? -128 : 0;
+        j.q_max = dtype == tensor::INT8 ? 127 : 255;
+
+        std::lock_guard<std::mutex> lk(param->lock);
+        _build_maps(param, j.src_w, j.src_h, width, height, fit);
+        j.xmap = &param->xmap;
+        j.ymap = &param->ymap;
+        j.cw4 = (param->xmap.len + 3) & ~3;
+
+        // split rows to bands, one band one thread, every band reuse cached source rows of its own buffer
+        int tasks = threads();
+        if (tasks > height)
+            tasks = height;
+        int band = (height + tasks - 1) / tasks;
+        tasks = (height + band - 1) / band;
+        if ((int)param->buffs.size() < tasks)
+            param->buffs.resize(tasks);
+        thread::parallel_for(0, tasks, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i)
+                _process_rows(j, param->buffs[i], i * band, std::min(height, (i + 1) * band));
+        }, 1, tasks);
+        return err::ERR_NONE;
+    }
+
+    err::Err Preprocessor::run(image::Image &img, tensor::Tensor &dst, bool chw, const std::vector<float> &mean, const std::vector<float> &scale,
+                               image::Fit fit, bool bgr, float qscale, int zero_point)
+    {
+        std::vector<int> shape = dst.shape();
+        if (shape.size() == 4)
+        {
+            if (shape[0] != 1)
+                return err::ERR_ARGS;
+            shape.erase(shape.begin());
+        }
+        if (shape.size() != 3 || !dst.is_contiguous())
+            return err::ERR_ARGS;
+        int c = chw ? shape[0] : shape[2];
+        int h = chw ? shape[1] : shape[0];
+        int w = chw ? shape[2] : shape[1];
+        if (c != 1 && c != 3)
+            return err::ERR_ARGS;
+        image::Format format = c == 1 ? image::FMT_GRAYSCALE : (bgr ? image::FMT_BGR888 : image::FMT_RGB888);
+        return run(img, dst.data(), w, h, format, dst.dtype(), chw, mean, scale, fit, qscale, zero_point);
+    }
+
+    tensor::Tensor *Preprocessor::to_tensor(image::Image &img, int width, int height, image::Format format, tensor::DType dtype, bool chw,
+                                            const std::vector<float> &mean, const std::vector<float> &scale, image::Fit fit,
+                                            float qscale, int zero_point)
+    {
+        int c = format == image::FMT_GRAYSCALE ? 1 : 3;
+        std::vector<int> shape = chw ? std::vector<int>{1, c, height, width} : std::vector<int>{1, height, width, c};
+        tensor::Tensor *t = new tensor::Tensor(shape, dtype);
+        err::Err e = run(img, t->data(), width, height, format, dtype, chw, mean, scale, fit, qscale, zero_point);
+        if (e != err::ERR_NONE)
+        {
+            delete t;
+            throw err::Exception(e, "preprocess failed");
+        }
+        return t;
+    }
+
+    image::Preprocessor &preprocessor()
+    {
+        // never destructed, nn modules may use it in static objects destructor
+        static image::Preprocessor *p = new image::Preprocessor();
+        return *p;
+    }
+} // namespace maix::image
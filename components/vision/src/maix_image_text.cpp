@@ -0,0 +1,532 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#include "maix_image_text.hpp"
+#include "maix_log.hpp"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_OUTLINE_H
+#include FT_BBOX_H
+#include <hb.h>
+#include <hb-ft.h>
+#include <mutex>
+#include <map>
+#include <unordered_map>
+#include <limits.h>
+#include <string.h>
+
+namespace maix::image
+{
+    typedef uint8_t v16u8 __attribute__((vector_size(16)));
+    typedef uint16_t v16u16 __attribute__((vector_size(32)));
+
+    static const uint32_t _no_coverage = 0xffffffff;
+    static const size_t _atlas_max_bytes = 256 * 1024;  // coverage of one font size, flush all when full
+    static const size_t _atlas_max_num = 8;             // font sizes of one font
+    static const size_t _shape_cache_num = 256;         // strings of one generation
+    static const size_t _mask_cache_bytes = 256 * 1024; // Hershey string masks of one generation
+
+    /**
+     * Glyph metrics and coverage offset in atlas, all in pixel except adv and bbox.
+     */
+    typedef struct
+    {
+        int w, h;
+        int left, top;                 // horiBearingX >> 6, horiBearingY >> 6
+        int advance;                   // advance.x >> 6
+        FT_Pos adv;                    // advance.x, 26.6
+        FT_BBox bbox;                  // outline bounding box, y down, 26.6
+        bool empty;                    // no outline, e.g. space
+        uint32_t offset[5];            // coverage offset in atlas of 1, 3, 4 channels
+    } glyph_t;
+
+    typedef struct
+    {
+        std::unordered_map<uint32_t, glyph_t> glyphs;
+        std::vector<uint8_t> coverage[5]; // w * h * channels bytes every glyph, alpha expanded to channels
+    } atlas_t;
+
+    /**
+     * Two generations map, when new generation is full, it becomes old one and the oldest is dropped,
+     * entries hit in old generation move to new one, so frequently used entries are kept.
+     */
+    template <typename T>
+    class GenCache
+    {
+    public:
+        std::unordered_map<std::string, T> curr;
+        std::unordered_map<std::string, T> old;
+        size_t bytes = 0;
+
+        T *find(const std::string &key)
+        {
+            auto it = curr.find(key);
+            if (it != curr.end())
+                return &it->second;
+            it = old.find(key);
+            if (it == old.end())
+                return nullptr;
+            T *v = &curr.emplace(key, std::move(it->second)).first->second;
+            old.erase(it);
+            return v;
+        }
+
+        T *add(const std::string &key, T &&v)
+        {
+            return &curr.emplace(key, std::move(v)).first->second;
+        }
+
+        void next_gen()
+        {
+            std::swap(curr, old);
+            curr.clear();
+            bytes = 0;
+        }
+    };
+
+    typedef struct
+    {
+        FT_Face face;
+        hb_font_t *hb_font;
+        int size;
+        int curr_height;
+        std::map<int, atlas_t> atlases;            // by pixel height
+        GenCache<std::vector<uint32_t>> shapes;    // text to glyph ids
+    } font_t;
+
+    typedef struct
+    {
+        int x, y, w, h;                     // mask rect relative to text left top point
+        std::vector<uint8_t> coverage[5];   // [1] is mask, others are expanded on demand
+    } text_mask_t;
+
+    typedef struct
+    {
+        std::unique_lock<std::mutex> lock;
+        font_t *font;       // nullptr for Hershey font
+        int font_id;
+        float scale;
+        int thickness;
+        int height;         // FreeType font pixel height
+        std::vector<uint8_t> pattern; // color repeat in channels order
+        cv::Scalar pattern_color;
+        int pattern_ch;
+    } render_param_t;
+
+    static std::mutex _text_mutex;
+    static FT_Library _ft_library = nullptr;
+    static hb_buffer_t *_hb_buffer = nullptr;
+    static std::map<std::string, font_t *> _fonts;
+    static GenCache<text_mask_t> _masks;
+    static uint8_t _alpha_lut[256];
+
+    /**
+     * opencv blend coverage a twice, c += ((C - c) * a + 127) >> 8,
+     * we blend once with equivalent alpha 255 * (1 - (1 - a / 256)^2), result differ at most 1.
+     */
+    static void _init_alpha_lut()
+    {
+        for (int a = 0; a < 256; ++a)
+        {
+            double t = 1 - a / 256.0;
+            _alpha_lut[a] = (uint8_t)(255 * (1 - t * t) + 0.5);
+        }
+    }
+
+    static inline int _ftd(FT_Pos v)
+    {
+        return v > 0 ? (int)((v + 32) / 64) : (int)((v - 32) / 64);
+    }
+
+    /**
+     * dst = (dst * (255 - a) + color * a) / 255, rounded, n bytes.
+     */
+    static inline void _blend_row(uint8_t *dst, const uint8_t *alpha, const uint8_t *color, int n)
+    {
+        int i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            uint64_t a64[2];
+            memcpy(a64, alpha + i, 16);
+            if ((a64[0] | a64[1]) == 0)
+                continue;
+            v16u8 d8, a8, c8;
+            memcpy(&d8, dst + i, 16);
+            memcpy(&a8, alpha + i, 16);
+            memcpy(&c8, color + i, 16);
+            v16u16 a = __builtin_convertvector(a8, v16u16);
+            v16u16 x = __builtin_convertvector(d8, v16u16) * (255 - a) + __builtin_convertvector(c8, v16u16) * a + 128;
+            x = (x + (x >> 8)) >> 8;
+            d8 = __builtin_convertvector(x, v16u8);
+            memcpy(dst + i, &d8, 16);
+        }
+        for (; i < n; ++i)
+        {
+            if (alpha[i] == 0)
+                continue;
+            int x = dst[i] * (255 - alpha[i]) + color[i] * alpha[i] + 128;
+            dst[i] = (uint8_t)((x + (x >> 8)) >> 8);
+        }
+    }
+
+    /**
+     * Blend w x h coverage to img at (x, y), clip to img.
+     */
+    static void _blit(cv::Mat &img, int x, int y, int w, int h, const uint8_t *coverage, const uint8_t *pattern)
+    {
+        int ch = img.channels();
+        int x0 = std::max(x, 0);
+        int y0 = std::max(y, 0);
+        int x1 = std::min(x + w, img.cols);
+        int y1 = std::min(y + h, img.rows);
+        if (x0 >= x1 || y0 >= y1)
+            return;
+        int n = (x1 - x0) * ch;
+        for (int row = y0; row < y1; ++row)
+            _blend_row(img.ptr<uint8_t>(row) + x0 * ch, coverage + ((row - y) * w + x0 - x) * ch, pattern, n);
+    }
+
+    static void _expand(const uint8_t *src, int num, int ch, std::vector<uint8_t> &dst)
+    {
+        size_t offset = dst.size();
+        dst.resize(offset + num * ch);
+        uint8_t *p = dst.data() + offset;
+        for (int i = 0; i < num; ++i)
+        {
+            for (int c = 0; c < ch; ++c)
+                *p++ = src[i];
+        }
+    }
+
+    static void _free_font(font_t *font)
+    {
+        hb_font_destroy(font->hb_font);
+        FT_Done_Face(font->face);
+        delete font;
+    }
+
+    err::Err text_load_font(const std::string &name, const std::string &path, int size)
+    {
+        std::lock_guard<std::mutex> lock(_text_mutex);
+        if (!_ft_library)
+        {
+            if (FT_Init_FreeType(&_ft_library) != 0)
+            {
+                log::error("init freetype failed\n");
+                return err::ERR_RUNTIME;
+            }
+            _hb_buffer = hb_buffer_create();
+            _init_alpha_lut();
+        }
+        FT_Face face;
+        if (FT_New_Face(_ft_library, path.c_str(), 0, &face) != 0)
+        {
+            log::error("load font %s failed\n", path.c_str());
+            return err::ERR_ARGS;
+        }
+        font_t *font = new font_t();
+        font->face = face;
+        font->hb_font = hb_ft_font_create(face, NULL);
+        font->size = size;
+        font->curr_height = 0;
+        auto it = _fonts.find(name);
+        if (it != _fonts.end())
+        {
+            _free_font(it->second);
+            it->second = font;
+        }
+        else
+            _fonts[name] = font;
+        return err::ERR_NONE;
+    }
+
+    static const std::vector<uint32_t> &_shape(font_t *font, const std::string &text)
+    {
+        std::vector<uint32_t> *ids = font->shapes.find(text);
+        if (ids)
+            return *ids;
+        if (font->shapes.curr.size() >= _shape_cache_num)
+            font->shapes.next_gen();
+        hb_buffer_clear_contents(_hb_buffer);
+        hb_buffer_add_utf8(_hb_buffer, text.c_str(), -1, 0, -1);
+        hb_buffer_guess_segment_properties(_hb_buffer);
+        hb_shape(font->hb_font, _hb_buffer, NULL, 0);
+        unsigned int len = 0;
+        hb_glyph_info_t *info = hb_buffer_get_glyph_infos(_hb_buffer, &len);
+        std::vector<uint32_t> v(len);
+        for (unsigned int i = 0; i < len; ++i)
+            v[i] = info[i].codepoint;
+        return *font->shapes.add(text, std::move(v));
+    }
+
+    static void _load_glyph(font_t *font, int height, uint32_t id)
+    {
+        if (font->curr_height != height)
+        {
+            if (FT_Set_Pixel_Sizes(font->face, height, height) != 0)
+                throw err::Exception(err::ERR_ARGS, "set font size failed");
+            font->curr_height = height;
+        }
+        if (FT_Load_Glyph(font->face, id, 0) != 0)
+            throw err::Exception(err::ERR_RUNTIME, "load glyph failed");
+    }
+
+    /**
+     * Get glyph from atlas, load it if not in atlas
+     * @param ch 0 means only metrics needed, else coverage of ch channels needed too
+     */
+    static glyph_t *_get_glyph(font_t *font, atlas_t &atlas, int height, uint32_t id, int ch)
+    {
+        auto it = atlas.glyphs.find(id);
+        glyph_t *g = it == atlas.glyphs.end() ? nullptr : &it->second;
+        if (g && (ch == 0 || g->offset[ch] != _no_coverage))
+            return g;
+        _load_glyph(font, height, id);
+        FT_GlyphSlot slot = font->face->glyph;
+        if (!g)
+        {
+            glyph_t glyph;
+            FT_BBox bbox;
+            FT_Outline_Get_BBox(&slot->outline, &bbox);
+            glyph.bbox.xMin = bbox.xMin;
+            glyph.bbox.xMax = bbox.xMax;
+            glyph.bbox.yMin = -bbox.yMax;
+            glyph.bbox.yMax = -bbox.yMin;
+            glyph.empty = slot->outline.n_points == 0;
+            glyph.adv = slot->advance.x;
+            glyph.advance = (int)(slot->advance.x >> 6);
+            glyph.left = (int)(slot->metrics.horiBearingX >> 6);
+            glyph.top = (int)(slot->metrics.horiBearingY >> 6);
+            glyph.w = 0;
+            glyph.h = 0;
+            for (int i = 0; i < 5; ++i)
+                glyph.offset[i] = _no_coverage;
+            g = &atlas.glyphs.emplace(id, glyph).first->second;
+        }
+        if (ch == 0)
+            return g;
+        if (FT_Render_Glyph(slot, FT_RENDER_MODE_NORMAL) != 0)
+            throw err::Exception(err::ERR_RUNTIME, "render glyph failed");
+        FT_Bitmap *bmp = &slot->bitmap;
+        size_t bytes = 0;
+        for (int i = 0; i < 5; ++i)
+            bytes += atlas.coverage[i].size();
+        if (bytes + bmp->width * bmp->rows * ch > _atlas_max_bytes)
+        {
+            for (auto &item : atlas.glyphs)
+            {
+                for (int i = 0; i < 5; ++i)
+                    item.second.offset[i] = _no_coverage;
+            }
+            for (int i = 0; i < 5; ++i)
+                atlas.coverage[i].clear();
+        }
+        g->w = (int)bmp->width;
+        g->h = (int)bmp->rows;
+        g->offset[ch] = (uint32_t)atlas.coverage[ch].size();
+        std::vector<uint8_t> alpha(g->w);
+        for (int row = 0; row < g->h; ++row)
+        {
+            const uint8_t *src = bmp->buffer + row * bmp->pitch;
+            for (int col = 0; col < g->w; ++col)
+                alpha[col] = _alpha_lut[src[col]];
+            _expand(alpha.data(), g->w, ch, atlas.coverage[ch]);
+        }
+        return g;
+    }
+
+    static atlas_t &_get_atlas(font_t *font, int height)
+    {
+        auto it = font->atlases.find(height);
+        if (it != font->atlases.end())
+            return it->second;
+        if (font->atlases.size() >= _atlas_max_num)
+            font->atlases.clear();
+        return font->atlases[height];
+    }
+
+    /**
+     * Same as cv::freetype::FreeType2::getTextSize
+     */
+    static cv::Size _ft_text_size(font_t *font, int height, const std::string &text, int thickness, int *baseline)
+    {
+        if (text.empty() || height <= 0)
+            return cv::Size(0, 0);
+        const std::vector<uint32_t> &ids = _shape(font, text);
+        atlas_t &atlas = _get_atlas(font, height);
+        int x_min = INT_MAX, y_min = INT_MAX;
+        int x_max = INT_MIN, y_max = INT_MIN;
+        FT_Pos pos = 0;
+        for (uint32_t id : ids)
+        {
+            glyph_t *g = _get_glyph(font, atlas, height, id, 0);
+            if (g->empty)
+            {
+                x_min = std::min(x_min, _ftd(pos));
+                x_max = std::max(x_max, _ftd(pos + g->adv));
+            }
+            else
+            {
+                x_min = std::min(x_min, _ftd(pos + g->bbox.xMin));
+                x_max = std::max(x_max, _ftd(pos + g->bbox.xMax));
+                y_min = std::min(y_min, _ftd(g->bbox.yMin));
+                y_max = std::max(y_max, _ftd(g->bbox.yMax));
+            }
+            pos += g->adv;
+        }
+        if (x_min > x_max)
+            x_min = x_max = 0;
+        if (y_min > y_max)
+            y_min = y_max = 0;
+        int width = x_max - x_min;
+        int h = -y_min;
+        if (thickness > 0)
+        {
+            width += thickness * 2;
+            h += thickness;
+        }
+        else
+        {
+            width += 1;
+            h += 1;
+        }
+        if (baseline)
+            *baseline = y_max;
+        return cv::Size(width, h);
+    }
+
+    static text_mask_t *_get_mask(int font_id, float scale, int thickness, const std::string &text)
+    {
+        std::string key;
+        key.append((const char *)&font_id, sizeof(font_id));
+        key.append((const char *)&scale, sizeof(scale));
+        key.append((const char *)&thickness, sizeof(thickness));
+        key.append(text);
+        text_mask_t *mask = _masks.find(key);
+        if (mask)
+            return mask;
+
+        // render to a mask with margin for script fonts and thickness, then crop
+        int base_line = 0;
+        int first_h = cv::getTextSize(std::string(text, 0, 1), font_id, scale, thickness, &base_line).height;
+        cv::Size size = cv::getTextSize(text, font_id, scale, thickness, &base_line);
+        int margin = thickness + 2 + (size.height + base_line) / 2;
+        cv::Mat m = cv::Mat::zeros(size.height + base_line + margin * 2, size.width + margin * 2, CV_8UC1);
+        cv::putText(m, text, cv::Point(margin, margin + size.height), font_id, scale, cv::Scalar(255), thickness, cv::LINE_AA, false);
+        cv::Rect rect = cv::boundingRect(m);
+        text_mask_t v;
+        v.x = rect.x - margin;
+        v.y = rect.y - margin - size.height + first_h;
+        v.w = rect.width;
+        v.h = rect.height;
+        v.coverage[1].resize(v.w * v.h);
+        for (int row = 0; row < v.h; ++row)
+            memcpy(v.coverage[1].data() + row * v.w, m.ptr<uint8_t>(rect.y + row) + rect.x, v.w);
+        if (_masks.bytes + v.coverage[1].size() > _mask_cache_bytes)
+            _masks.next_gen();
+        _masks.bytes += v.coverage[1].size();
+        return _masks.add(key, std::move(v));
+    }
+
+    TextRender::TextRender(const std::string &font_name, int font_id, float scale, int thickness)
+    {
+        render_param_t *param = new render_param_t();
+        param->lock = std::unique_lock<std::mutex>(_text_mutex);
+        param->font = nullptr;
+        param->font_id = font_id;
+        param->scale = scale;
+        param->thickness = thickness;
+        param->height = 0;
+        param->pattern_ch = 0;
+        if (font_id == -1)
+        {
+            auto it = _fonts.find(font_name);
+            if (it == _fonts.end())
+            {
+                delete param;
+                log::error("font %s not load\n", font_name.c_str());
+                throw err::Exception(err::ERR_ARGS, "font not load");
+            }
+            param->font = it->second;
+            param->height = (int)(scale * param->font->size);
+        }
+        _param = param;
+    }
+
+    TextRender::~TextRender()
+    {
+        delete (render_param_t *)_param;
+    }
+
+    cv::Size TextRender::size(const std::string &text)
+    {
+        render_param_t *param = (render_param_t *)_param;
+        int base_line = 0;
+        cv::Size size;
+        if (param->font)
+        {
+            size = _ft_text_size(param->font, param->height, text, param->thickness, &base_line);
+            if (param->thickness > 0)
+                base_line += param->thickness;
+        }
+        else
+        {
+            int thickness = param->thickness > 0 ? param->thickness : -param->thickness;
+            size = cv::getTextSize(text, param->font_id, param->scale, thickness, &base_line);
+            base_line += base_line > 0 ? 0 : -param->thickness;
+        }
+        size.height += base_line;
+        return size;
+    }
+
+    void TextRender::draw(cv::Mat &img, const std::string &text, const cv::Point &point, const cv::Scalar &color)
+    {
+        render_param_t *param = (render_param_t *)_param;
+        if (text.empty())
+            return;
+        int ch = img.channels();
+        if (img.depth() != CV_8U || (ch != 1 && ch != 3 && ch != 4))
+            throw err::Exception(err::ERR_ARGS, "text render only support CV_8UC1, CV_8UC3 and CV_8UC4");
+        if (param->pattern_ch != ch || param->pattern_color != color || (int)param->pattern.size() < img.cols * ch)
+        {
+            param->pattern.resize(img.cols * ch);
+            for (int i = 0; i < img.cols * ch; ++i)
+                param->pattern[i] = cv::saturate_cast<uint8_t>(color[i % ch]);
+            param->pattern_ch = ch;
+            param->pattern_color = color;
+        }
+        const uint8_t *pattern = param->pattern.data();
+
+        if (!param->font)
+        {
+            int thickness = param->thickness > 0 ? param->thickness : -param->thickness;
+            text_mask_t *mask = _get_mask(param->font_id, param->scale, thickness, text);
+            if (mask->coverage[ch].empty() && mask->w * mask->h > 0)
+            {
+                _expand(mask->coverage[1].data(), mask->w * mask->h, ch, mask->coverage[ch]);
+                _masks.bytes += mask->coverage[ch].size();
+            }
+            _blit(img, point.x + mask->x, point.y + mask->y, mask->w, mask->h, mask->coverage[ch].data(), pattern);
+            return;
+        }
+
+        font_t *font = param->font;
+        int height = param->height;
+        if (height <= 0)
+            return;
+        // left top to baseline origin, same as draw_string before
+        cv::Point org(point.x, point.y + _ft_text_size(font, height, text, param->thickness, nullptr).height);
+        const std::vector<uint32_t> &ids = _shape(font, text);
+        atlas_t &atlas = _get_atlas(font, height);
+        for (uint32_t id : ids)
+        {
+            glyph_t *g = _get_glyph(font, atlas, height, id, ch);
+            _blit(img, org.x + g->left, org.y - g->top, g->w, g->h, atlas.coverage[ch].data() + g->offset[ch], pattern);
+            org.x += g->advance;
+        }
+    }
+} // namespace maix::image
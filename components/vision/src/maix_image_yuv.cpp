@@ -0,0 +1,416 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ * @update 2026.10.18: Resize and rotate planes in row bands on thread pool.
+ */
+
+#include "maix_image_yuv.hpp"
+#include "maix_log.hpp"
+#include "maix_thread.hpp"
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+namespace maix::image
+{
+    typedef uint32_t v8u32 __attribute__((vector_size(32)));
+    typedef uint16_t v8u16 __attribute__((vector_size(16)));
+    typedef uint8_t v8u8 __attribute__((vector_size(8)));
+
+    /**
+     * Sample positions of one destination axis, in element of plane row,
+     * one VU pair is two elements, so both channels are in the table.
+     */
+    typedef struct
+    {
+        std::vector<int> i0;      // left(top) source element index
+        std::vector<int> i1;      // right(bottom) source element index
+        std::vector<uint16_t> w;  // weight of i1, 0 ~ 256
+    } yuv_axis_t;
+
+    /**
+     * @param src_len source length in pixels of this plane
+     * @param len destination length in pixels of this plane
+     * @param src_start source start position in pixels
+     * @param step source pixels per destination pixel
+     * @param ch channels of this plane, Y is 1, VU is 2
+     */
+    static void _build_axis(yuv_axis_t &m, int src_len, int len, float src_start, float step, int ch, bool bilinear)
+    {
+        m.i0.resize(len * ch);
+        m.i1.resize(len * ch);
+        m.w.resize(len * ch);
+        for (int i = 0; i < len; ++i)
+        {
+            float f = src_start + (i + 0.5f) * step - 0.5f;
+            int i0, w = 0;
+            if (bilinear)
+            {
+                i0 = (int)floorf(f);
+                w = (int)((f - i0) * 256 + 0.5f);
+                if (w == 256)
+                {
+                    ++i0;
+                    w = 0;
+                }
+            }
+            else
+                i0 = (int)floorf(f + 0.5f);
+            if (i0 < 0)
+            {
+                i0 = 0;
+                w = 0;
+            }
+            if (i0 >= src_len - 1)
+            {
+                i0 = src_len - 1;
+                w = 0;
+            }
+            int i1 = i0 + 1 < src_len ? i0 + 1 : i0;
+            for (int c = 0; c < ch; ++c)
+            {
+                m.i0[i * ch + c] = i0 * ch + c;
+                m.i1[i * ch + c] = i1 * ch + c;
+                m.w[i * ch + c] = w;
+            }
+        }
+    }
+
+    static void _hpass(const uint8_t *s, const yuv_axis_t &x, uint16_t *out, int n)
+    {
+        const int *i0 = x.i0.data();
+        const int *i1 = x.i1.data();
+        const uint16_t *w = x.w.data();
+        for (int i = 0; i < n; ++i)
+            out[i] = s[i0[i]] * (256 - w[i]) + s[i1[i]] * w[i];
+    }
+
+    static void _vblend(const uint16_t *r0, const uint16_t *r1, uint32_t wy, uint8_t *d, int n)
+    {
+        int i = 0;
+        if (wy == 0)
+        {
+            for (; i + 8 <= n; i += 8)
+            {
+                v8u16 a;
+                memcpy(&a, r0 + i, sizeof(a));
+                v8u8 v = __builtin_convertvector((a + 128) >> 8, v8u8);
+                memcpy(d + i, &v, sizeof(v));
+            }
+            for (; i < n; ++i)
+                d[i] = (r0[i] + 128) >> 8;
+            return;
+        }
+        v8u32 w0 = (v8u32){} + (256 - wy);
+        v8u32 w1 = (v8u32){} + wy;
+        for (; i + 8 <= n; i += 8)
+        {
+            v8u16 a, b;
+            memcpy(&a, r0 + i, sizeof(a));
+            memcpy(&b, r1 + i, sizeof(b));
+            v8u32 v = (__builtin_convertvector(a, v8u32) * w0 + __builtin_convertvector(b, v8u32) * w1 + 32768) >> 16;
+            v8u8 o = __builtin_convertvector(v, v8u8);
+            memcpy(d + i, &o, sizeof(o));
+        }
+        for (; i < n; ++i)
+            d[i] = (r0[i] * (256 - wy) + r1[i] * wy + 32768) >> 16;
+    }
+
+    /**
+     * Resize one plane, write dw x dh pixels to dst.
+     * @param sw source plane width in pixels, row stride is sw * ch
+     * @param dst_stride destination plane row stride in bytes
+     */
+    static void _resize_plane(const uint8_t *src, int sw, int sh, float sx, float sy, float step_x, float step_y,
+                              uint8_t *dst, int dst_stride, int dw, int dh, int ch, bool bilinear)
+    {
+        yuv_axis_t xm, ym;
+        _build_axis(xm, sw, dw, sx, step_x, ch, bilinear);
+        _build_axis(ym, sh, dh, sy, step_y, 1, bilinear);
+        int n = dw * ch;
+        int src_stride = sw * ch;
+        if (!bilinear)
+        {
+            const int *xi = xm.i0.data();
+            thread::parallel_for(0, dh, [&](int y_begin, int y_end) {
+                int last = -1;
+                for (int y = y_begin; y < y_end; ++y)
+                {
+                    uint8_t *d = dst + y * dst_stride;
+                    int sy_i = ym.i0[y];
+                    if (sy_i == last)
+                    {
+                        memcpy(d, d - dst_stride, n);
+                        continue;
+                    }
+                    last = sy_i;
+                    const uint8_t *s = src + sy_i * src_stride;
+                    for (int i = 0; i < n; ++i)
+                        d[i] = s[xi[i]];
+                }
+            }, 8);
+            return;
+        }
+        thread::parallel_for(0, dh, [&](int y_begin, int y_end) {
+            // two horizontal passed source rows, reused when adjacent destination rows share source rows
+            std::vector<uint16_t> buf(n * 2);
+            uint16_t *rows[2] = {buf.data(), buf.data() + n};
+            int idx[2] = {-1, -1};
+            for (int y = y_begin; y < y_end; ++y)
+            {
+                int y0 = ym.i0[y], y1 = ym.i1[y];
+                uint32_t wy = ym.w[y];
+                if (idx[0] != y0)
+                {
+                    if (idx[1] == y0)
+                    {
+                        std::swap(rows[0], rows[1]);
+                        std::swap(idx[0], idx[1]);
+                    }
+                    else
+                    {
+                        _hpass(src + y0 * src_stride, xm, rows[0], n);
+                        idx[0] = y0;
+                    }
+                }
+                if (wy != 0 && idx[1] != y1)
+                {
+                    _hpass(src + y1 * src_stride, xm, rows[1], n);
+                    idx[1] = y1;
+                }
+                _vblend(rows[0], rows[1], wy, dst + y * dst_stride, n);
+            }
+        }, 8);
+    }
+
+    /**
+     * Fill plane except rect (x, y, w, rh), row is plane row stride in bytes
+     */
+    static void _fill_border(uint8_t *plane, int row, int h, int x, int y, int w, int rh, int ch, uint8_t value)
+    {
+        memset(plane, value, y * row);
+        memset(plane + (y + rh) * row, value, (h - y - rh) * row);
+        for (int i = y; i < y + rh; ++i)
+        {
+            uint8_t *d = plane + i * row;
+            memset(d, value, x * ch);
+            memset(d + (x + w) * ch, value, row - (x + w) * ch);
+        }
+    }
+
+    static bool _check_yuv420sp(image::Image &img)
+    {
+        if (img.format() != image::FMT_YVU420SP && img.format() != image::FMT_YUV420SP)
+        {
+            log::error("only support YVU420SP and YUV420SP, but format is %d\n", img.format());
+            return false;
+        }
+        if (img.width() <= 0 || img.height() <= 0 || (img.width() & 1) || (img.height() & 1))
+        {
+            log::error("yuv420sp image size should be even, but %dx%d\n", img.width(), img.height());
+            return false;
+        }
+        return true;
+    }
+
+    static bool _check_pair(image::Image &src, image::Image &dst)
+    {
+        if (!_check_yuv420sp(src) || !_check_yuv420sp(dst))
+            return false;
+        if (src.format() != dst.format())
+        {
+            log::error("src and dst format not match\n");
+            return false;
+        }
+        return true;
+    }
+
+    err::Err yuv420sp_resize(image::Image &src, image::Image &dst, image::Fit fit, image::ResizeMethod method)
+    {
+        if (!_check_pair(src, dst))
+            return err::ERR_ARGS;
+        int sw = src.width(), sh = src.height();
+        int dw = dst.width(), dh = dst.height();
+        const uint8_t *s = (const uint8_t *)src.data();
+        uint8_t *d = (uint8_t *)dst.data();
+        bool bilinear = method != image::ResizeMethod::NEAREST;
+
+        // destination rect and source window, rect is aligned to 2 to keep chroma sited with luma
+        int rx = 0, ry = 0, rw = dw, rh = dh;
+        float cx = 0, cy = 0, cw = sw, ch = sh;
+        if (fit == image::Fit::FIT_CONTAIN)
+        {
+            float r = std::min((float)dw / sw, (float)dh / sh);
+            rw = std::min(dw, std::max(2, (int)(sw * r + 0.5f) & ~1));
+            rh = std::min(dh, std::max(2, (int)(sh * r + 0.5f) & ~1));
+            rx = ((dw - rw) / 2) & ~1;
+            ry = ((dh - rh) / 2) & ~1;
+        }
+        else if (fit == image::Fit::FIT_COVER)
+        {
+            float r = std::max((float)dw / sw, (float)dh / sh);
+            cw = dw / r;
+            ch = dh / r;
+            cx = (sw - cw) / 2;
+            cy = (sh - ch) / 2;
+        }
+        float step_x = cw / rw, step_y = ch / rh;
+
+        // Y plane
+        _resize_plane(s, sw, sh, cx, cy, step_x, step_y, d + ry * dw + rx, dw, rw, rh, 1, bilinear);
+        // VU plane, half size, two bytes per pixel
+        _resize_plane(s + sw * sh, sw / 2, sh / 2, cx / 2, cy / 2, step_x, step_y,
+                      d + dw * dh + ry / 2 * dw + rx, dw, rw / 2, rh / 2, 2, bilinear);
+        if (rw != dw || rh != dh)
+        {
+            _fill_border(d, dw, dh, rx, ry, rw, rh, 1, 0);
+            _fill_border(d + dw * dh, dw, dh / 2, rx / 2, ry / 2, rw / 2, rh / 2, 2, 128);
+        }
+        return err::ERR_NONE;
+    }
+
+    err::Err yuv420sp_crop(image::Image &src, image::Image &dst, int x, int y)
+    {
+        if (!_check_pair(src, dst))
+            return err::ERR_ARGS;
+        int sw = src.width(), sh = src.height();
+        int w = dst.width(), h = dst.height();
+        x &= ~1;
+        y &= ~1;
+        if (x < 0 || y < 0 || x + w > sw || y + h > sh)
+        {
+            log::error("crop rect (%d, %d, %d, %d) out of image %dx%d\n", x, y, w, h, sw, sh);
+            return err::ERR_ARGS;
+        }
+        const uint8_t *s = (const uint8_t *)src.data();
+        uint8_t *d = (uint8_t *)dst.data();
+        for (int i = 0; i < h; ++i)
+            memcpy(d + i * w, s + (y + i) * sw + x, w);
+        s += sw * sh;
+        d += w * h;
+        for (int i = 0; i < h / 2; ++i)
+            memcpy(d + i * w, s + (y / 2 + i) * sw + x, w);
+        return err::ERR_NONE;
+    }
+
+    /**
+     * dst(x, y) = src[base + x * step_x + y * step_y], T is one pixel of plane
+     */
+    template <typename T>
+    static void _remap_plane(const T *src, T *dst, int dw, int dh, long base, long step_x, long step_y)
+    {
+        if (step_x == 1)
+        {
+            for (int y = 0; y < dh; ++y)
+                memcpy(dst + y * dw, src + base + y * step_y, dw * sizeof(T));
+            return;
+        }
+        if (step_x == -1)
+        {
+            for (int y = 0; y < dh; ++y)
+            {
+                const T *s = src + base + y * step_y;
+                T *d = dst + y * dw;
+                for (int x = 0; x < dw; ++x)
+                    d[x] = s[-x];
+            }
+            return;
+        }
+        // transpose, walk in tiles so both source columns and destination rows stay in cache
+        // tile rows in parallel, bands are aligned to tile
+        const int tile = 32;
+        thread::parallel_for(0, dh, [&](int y_begin, int y_end) {
+            for (int by = y_begin; by < y_end; by += tile)
+            {
+                int ey = std::min(by + tile, y_end);
+                for (int bx = 0; bx < dw; bx += tile)
+                {
+                    int ex = std::min(bx + tile, dw);
+                    for (int y = by; y < ey; ++y)
+                    {
+                        const T *s = src + base + y * step_y;
+                        T *d = dst + y * dw;
+                        for (int x = bx; x < ex; ++x)
+                            d[x] = s[x * step_x];
+                    }
+                }
+            }
+        }, tile);
+    }
+
+    /**
+     * Position of dst(dx, dy) in a sw x sh plane, rotate anti-clock wise after mirror and flip.
+     */
+    static long _rotate_src_offset(int dx, int dy, int sw, int sh, int angle, bool hmirror, bool vflip)
+    {
+        long x, y;
+        switch (angle)
+        {
+        case 90:
+            x = sw - 1 - dy;
+            y = dx;
+            break;
+        case 180:
+            x = sw - 1 - dx;
+            y = sh - 1 - dy;
+            break;
+        case 270:
+            x = dy;
+            y = sh - 1 - dx;
+            break;
+        default:
+            x = dx;
+            y = dy;
+            break;
+        }
+        if (hmirror)
+            x = sw - 1 - x;
+        if (vflip)
+            y = sh - 1 - y;
+        return y * sw + x;
+    }
+
+    template <typename T>
+    static void _rotate_plane(const uint8_t *src, uint8_t *dst, int sw, int sh, int angle, bool hmirror, bool vflip)
+    {
+        int dw = (angle == 90 || angle == 270) ? sh : sw;
+        int dh = (angle == 90 || angle == 270) ? sw : sh;
+        long base = _rotate_src_offset(0, 0, sw, sh, angle, hmirror, vflip);
+        long step_x = _rotate_src_offset(1, 0, sw, sh, angle, hmirror, vflip) - base;
+        long step_y = _rotate_src_offset(0, 1, sw, sh, angle, hmirror, vflip) - base;
+        _remap_plane<T>((const T *)src, (T *)dst, dw, dh, base, step_x, step_y);
+    }
+
+    err::Err yuv420sp_rotate(image::Image &src, image::Image &dst, int angle, bool hmirror, bool vflip)
+    {
+        if (!_check_pair(src, dst))
+            return err::ERR_ARGS;
+        angle = (angle % 360 + 360) % 360;
+        if (angle % 90 != 0)
+        {
+            log::error("only support rotate 0, 90, 180, 270, but angle is %d\n", angle);
+            return err::ERR_ARGS;
+        }
+        int sw = src.width(), sh = src.height();
+        bool swap = angle == 90 || angle == 270;
+        if (dst.width() != (swap ? sh : sw) || dst.height() != (swap ? sw : sh))
+        {
+            log::error("dst size %dx%d not match rotated size\n", dst.width(), dst.height());
+            return err::ERR_ARGS;
+        }
+        if (src.data() == dst.data())
+        {
+            log::error("rotate not support in place\n");
+            return err::ERR_ARGS;
+        }
+        const uint8_t *s = (const uint8_t *)src.data();
+        uint8_t *d = (uint8_t *)dst.data();
+        _rotate_plane<uint8_t>(s, d, sw, sh, angle, hmirror, vflip);
+        // VU pair keep together, rotate as one 16 bits pixel
+        _rotate_plane<uint16_t>(s + sw * sh, d + sw * sh, sw / 2, sh / 2, angle, hmirror, vflip);
+        return err::ERR_NONE;
+    }
+}
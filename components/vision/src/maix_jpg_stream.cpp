@@ -0,0 +1,521 @@
+/**
+ * @author lxowalle@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2024.5.17: Add framework, create this file.
+ * @update 2026.10.18: Rewrite with one epoll thread for all platforms, frames are shared by clients.
+ */
+
+#include "maix_jpg_stream.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#define BOUNDARY "frame"
+#define REQUEST_MAX_SIZE 4096
+
+static const char *default_index_str =
+"<html>\n"
+"<body>\n"
+"<h1>JPG Stream</h1>\n"
+"<img src='/stream'>\n"
+"</body>\n"
+"</html>";
+
+namespace maix::http
+{
+    /**
+     * One jpeg frame, encoded once and shared by all clients,
+     * released after the last client sent it.
+     */
+    typedef struct {
+        uint64_t seq;
+        std::string head;           // multipart part header
+        image::Image *jpg;          // jpeg image owned by frame, or nullptr if data is copied to buff
+        std::vector<uint8_t> buff;
+        const uint8_t *data;
+        size_t size;
+    } jpeg_frame_t;
+
+    typedef std::shared_ptr<jpeg_frame_t> jpeg_frame_ptr;
+
+    enum client_state_t {
+        CLIENT_REQUEST = 0,         // reading http request
+        CLIENT_PAGE,                // sending html page, close after sent
+        CLIENT_STREAM,              // sending jpeg stream
+    };
+
+    typedef struct {
+        int fd;
+        client_state_t state;
+        uint32_t events;
+        std::string req;
+        std::string out;            // http response header or html page
+        size_t out_sent;
+        jpeg_frame_ptr frame;       // frame being sent
+        size_t frame_sent;
+        uint64_t last_seq;
+    } client_t;
+
+    typedef struct {
+        int listen_fd;
+        int epoll_fd;
+        int event_fd;
+        int client_max;
+        std::thread *thread;
+        std::atomic<bool> running;
+        std::atomic<int> stream_client_cnt;
+        std::mutex lock;            // protect latest and html
+        jpeg_frame_ptr latest;
+        uint64_t seq;
+        std::string html;
+        std::unordered_map<int, client_t *> clients;
+    } priv_t;
+
+    static void jpeg_frame_delete(jpeg_frame_t *frame)
+    {
+        if (frame->jpg)
+            delete frame->jpg;
+        delete frame;
+    }
+
+    static int create_listen_socket(const std::string &host, int port)
+    {
+        struct addrinfo hints, *res = NULL;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        std::string port_str = std::to_string(port);
+        int ret = getaddrinfo(host.empty() ? NULL : host.c_str(), port_str.c_str(), &hints, &res);
+        if (ret != 0) {
+            log::error("can not parse host %s: %s\r\n", host.c_str(), gai_strerror(ret));
+            return -1;
+        }
+
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            log::error("create socket failed: %s\r\n", strerror(errno));
+            freeaddrinfo(res);
+            return -1;
+        }
+        int opt = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        if (bind(fd, res->ai_addr, res->ai_addrlen) < 0 || listen(fd, 16) < 0) {
+            log::error("bind %s:%d failed: %s\r\n", host.c_str(), port, strerror(errno));
+            freeaddrinfo(res);
+            close(fd);
+            return -1;
+        }
+        freeaddrinfo(res);
+        return fd;
+    }
+
+    static void client_set_events(priv_t *priv, client_t *c, uint32_t events)
+    {
+        if (c->events == events)
+            return;
+        struct epoll_event ev;
+        ev.events = events;
+        ev.data.fd = c->fd;
+        epoll_ctl(priv->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+        c->events = events;
+    }
+
+    static void client_close(priv_t *priv, client_t *c)
+    {
+        if (c->state == CLIENT_STREAM)
+            priv->stream_client_cnt--;
+        epoll_ctl(priv->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+        close(c->fd);
+        priv->clients.erase(c->fd);
+        delete c;
+    }
+
+    static void client_start_frame(client_t *c, const jpeg_frame_ptr &frame)
+    {
+        c->frame = frame;
+        c->frame_sent = 0;
+        c->last_seq = frame->seq;
+    }
+
+    static jpeg_frame_ptr get_latest(priv_t *priv)
+    {
+        std::lock_guard<std::mutex> guard(priv->lock);
+        return priv->latest;
+    }
+
+    /**
+     * Send pending data of client without blocking, start the latest frame after one frame sent.
+     * @return false if client closed
+     */
+    static bool client_flush(priv_t *priv, client_t *c)
+    {
+        while (true) {
+            struct iovec iov[4];
+            int iov_cnt = 0;
+            if (c->out_sent < c->out.size()) {
+                iov[iov_cnt].iov_base = (void *)(c->out.data() + c->out_sent);
+                iov[iov_cnt++].iov_len = c->out.size() - c->out_sent;
+            }
+            if (c->frame) {
+                // frame = head + jpeg data + "\r\n", write from shared buffer directly
+                size_t offset = c->frame_sent;
+                const uint8_t *parts[3] = {(const uint8_t *)c->frame->head.data(), c->frame->data, (const uint8_t *)"\r\n"};
+                size_t sizes[3] = {c->frame->head.size(), c->frame->size, 2};
+                for (int i = 0; i < 3; ++i) {
+                    if (offset >= sizes[i]) {
+                        offset -= sizes[i];
+                        continue;
+                    }
+                    iov[iov_cnt].iov_base = (void *)(parts[i] + offset);
+                    iov[iov_cnt++].iov_len = sizes[i] - offset;
+                    offset = 0;
+                }
+            }
+            if (iov_cnt == 0) {
+                if (c->state == CLIENT_PAGE) {
+                    client_close(priv, c);
+                    return false;
+                }
+                c->out.clear();
+                c->out_sent = 0;
+                c->frame.reset();
+                if (c->state == CLIENT_STREAM) {
+                    // skip frames written while sending, only send the latest one
+                    jpeg_frame_ptr latest = get_latest(priv);
+                    if (latest && latest->seq != c->last_seq) {
+                        client_start_frame(c, latest);
+                        continue;
+                    }
+                }
+                client_set_events(priv, c, EPOLLIN | EPOLLRDHUP);
+                return true;
+            }
+
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = iov_cnt;
+            ssize_t n = sendmsg(c->fd, &msg, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    client_set_events(priv, c, EPOLLIN | EPOLLOUT | EPOLLRDHUP);
+                    return true;
+                }
+                client_close(priv, c);
+                return false;
+            }
+            size_t sent = n;
+            size_t out_left = c->out.size() - c->out_sent;
+            if (sent <= out_left) {
+                c->out_sent += sent;
+            } else {
+                c->out_sent = c->out.size();
+                c->frame_sent += sent - out_left;
+            }
+        }
+    }
+
+    static void client_on_request(priv_t *priv, client_t *c)
+    {
+        if (c->req.compare(0, 11, "GET /stream") == 0) {
+            c->out = "HTTP/1.1 200 OK\r\n"
+                     "Content-Type: multipart/x-mixed-replace; boundary=" BOUNDARY "\r\n"
+                     "Cache-Control: no-cache\r\n"
+                     "Connection: close\r\n"
+                     "\r\n";
+            c->state = CLIENT_STREAM;
+            priv->stream_client_cnt++;
+            jpeg_frame_ptr latest = get_latest(priv);
+            if (latest)
+                client_start_frame(c, latest);
+        } else {
+            std::string html;
+            {
+                std::lock_guard<std::mutex> guard(priv->lock);
+                html = priv->html;
+            }
+            c->out = "HTTP/1.1 200 OK\r\n"
+                     "Content-Type: text/html\r\n"
+                     "Content-Length: " + std::to_string(html.size()) + "\r\n"
+                     "Connection: close\r\n"
+                     "\r\n" + html;
+            c->state = CLIENT_PAGE;
+        }
+        c->req.clear();
+        c->req.shrink_to_fit();
+        c->out_sent = 0;
+        client_flush(priv, c);
+    }
+
+    static void client_on_readable(priv_t *priv, client_t *c)
+    {
+        char buff[1024];
+        while (true) {
+            ssize_t n = read(c->fd, buff, sizeof(buff));
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    return;
+                client_close(priv, c);
+                return;
+            }
+            if (n == 0) {
+                client_close(priv, c);
+                return;
+            }
+            if (c->state != CLIENT_REQUEST)
+                continue;   // ignore data after request
+            c->req.append(buff, n);
+            if (c->req.find("\r\n\r\n") != std::string::npos) {
+                client_on_request(priv, c);
+                return;
+            }
+            if (c->req.size() > REQUEST_MAX_SIZE) {
+                client_close(priv, c);
+                return;
+            }
+        }
+    }
+
+    static void on_accept(priv_t *priv)
+    {
+        while (true) {
+            int fd = accept4(priv->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    log::error("accept failed: %s\r\n", strerror(errno));
+                return;
+            }
+            if ((int)priv->clients.size() >= priv->client_max) {
+                log::warn("can not create more client! max:%d\r\n", priv->client_max);
+                const char *resp = "HTTP/1.1 503 Service Unavailable\r\nConnection: close\r\n\r\n";
+                send(fd, resp, strlen(resp), MSG_NOSIGNAL);
+                close(fd);
+                continue;
+            }
+            int opt = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+            client_t *c = new client_t();
+            c->fd = fd;
+            c->state = CLIENT_REQUEST;
+            c->events = EPOLLIN | EPOLLRDHUP;
+            c->out_sent = 0;
+            c->frame_sent = 0;
+            c->last_seq = 0;
+            struct epoll_event ev;
+            ev.events = c->events;
+            ev.data.fd = fd;
+            if (epoll_ctl(priv->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                close(fd);
+                delete c;
+                continue;
+            }
+            priv->clients[fd] = c;
+        }
+    }
+
+    static void on_new_frame(priv_t *priv)
+    {
+        uint64_t cnt;
+        while (read(priv->event_fd, &cnt, sizeof(cnt)) > 0)
+            ;
+        jpeg_frame_ptr latest = get_latest(priv);
+        if (!latest)
+            return;
+        // clients still sending old frame will get the latest one after finished
+        std::vector<client_t *> idle;
+        for (auto &item : priv->clients) {
+            client_t *c = item.second;
+            if (c->state == CLIENT_STREAM && !c->frame && c->last_seq != latest->seq)
+                idle.push_back(c);
+        }
+        for (client_t *c : idle) {
+            client_start_frame(c, latest);
+            client_flush(priv, c);
+        }
+    }
+
+    static void server_loop(priv_t *priv)
+    {
+        struct epoll_event events[64];
+        while (priv->running) {
+            int n = epoll_wait(priv->epoll_fd, events, 64, 500);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                log::error("epoll_wait failed: %s\r\n", strerror(errno));
+                break;
+            }
+            for (int i = 0; i < n; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == priv->listen_fd) {
+                    on_accept(priv);
+                    continue;
+                }
+                if (fd == priv->event_fd) {
+                    on_new_frame(priv);
+                    continue;
+                }
+                auto iter = priv->clients.find(fd);
+                if (iter == priv->clients.end())
+                    continue;   // closed in this loop
+                client_t *c = iter->second;
+                if (events[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+                    client_close(priv, c);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT) {
+                    if (!client_flush(priv, c))
+                        continue;
+                }
+                if (events[i].events & EPOLLIN)
+                    client_on_readable(priv, c);
+            }
+        }
+    }
+
+    JpegStreamer::JpegStreamer(std::string host, int port, int client_number) {
+        priv_t *priv = new priv_t();
+        priv->listen_fd = create_listen_socket(host, port);
+        priv->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        priv->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (priv->listen_fd < 0 || priv->epoll_fd < 0 || priv->event_fd < 0) {
+            if (priv->listen_fd >= 0) close(priv->listen_fd);
+            if (priv->epoll_fd >= 0) close(priv->epoll_fd);
+            if (priv->event_fd >= 0) close(priv->event_fd);
+            delete priv;
+            err::check_raise(err::ERR_RUNTIME, "http_jpeg_server_create failed!");
+        }
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = priv->listen_fd;
+        epoll_ctl(priv->epoll_fd, EPOLL_CTL_ADD, priv->listen_fd, &ev);
+        ev.events = EPOLLIN;
+        ev.data.fd = priv->event_fd;
+        epoll_ctl(priv->epoll_fd, EPOLL_CTL_ADD, priv->event_fd, &ev);
+        priv->client_max = client_number > 0 ? client_number : 1;
+        priv->thread = NULL;
+        priv->running = false;
+        priv->stream_client_cnt = 0;
+        priv->seq = 0;
+        priv->html = default_index_str;
+
+        _param = priv;
+        _host = host.size() == 0 ? "0.0.0.0" : host;
+        _port = port;
+    }
+
+    JpegStreamer::~JpegStreamer() {
+        priv_t *priv = (priv_t *)_param;
+        stop();
+        close(priv->listen_fd);
+        close(priv->epoll_fd);
+        close(priv->event_fd);
+        delete priv;
+    }
+
+    err::Err JpegStreamer::start() {
+        priv_t *priv = (priv_t *)_param;
+        if (priv->thread)
+            return err::ERR_NONE;
+        priv->running = true;
+        priv->thread = new std::thread(server_loop, priv);
+        return err::ERR_NONE;
+    }
+
+    err::Err JpegStreamer::stop() {
+        priv_t *priv = (priv_t *)_param;
+        if (!priv->thread)
+            return err::ERR_NONE;
+        priv->running = false;
+        uint64_t one = 1;
+        if (::write(priv->event_fd, &one, sizeof(one)) < 0) {
+            // epoll_wait will timeout
+        }
+        priv->thread->join();
+        delete priv->thread;
+        priv->thread = NULL;
+        while (!priv->clients.empty())
+            client_close(priv, priv->clients.begin()->second);
+        return err::ERR_NONE;
+    }
+
+    err::Err JpegStreamer::write(image::Image *img) {
+        priv_t *priv = (priv_t *)_param;
+        err::check_null_raise(img, "image is null");
+        // nobody watching, not encode
+        if (priv->stream_client_cnt == 0)
+            return err::ERR_NONE;
+
+        jpeg_frame_t *frame = new jpeg_frame_t();
+        frame->jpg = NULL;
+        if (img->format() != image::Format::FMT_JPEG) {
+            frame->jpg = img->to_jpeg();
+            if (frame->jpg == NULL) {
+                log::error("invert to jpeg failed!\r\n");
+                delete frame;
+                return err::ERR_RUNTIME;
+            }
+            frame->data = (const uint8_t *)frame->jpg->data();
+            frame->size = frame->jpg->data_size();
+        } else {
+            // image owned by caller, copy once
+            frame->buff.assign((uint8_t *)img->data(), (uint8_t *)img->data() + img->data_size());
+            frame->data = frame->buff.data();
+            frame->size = frame->buff.size();
+        }
+        frame->head = "--" BOUNDARY "\r\n"
+                      "Content-Type: image/jpeg\r\n"
+                      "Content-Length: " + std::to_string(frame->size) + "\r\n"
+                      "\r\n";
+        jpeg_frame_ptr ptr(frame, jpeg_frame_delete);
+        {
+            std::lock_guard<std::mutex> guard(priv->lock);
+            frame->seq = ++priv->seq;
+            priv->latest = ptr;
+        }
+        uint64_t one = 1;
+        if (::write(priv->event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            log::error("notify new frame failed: %s\r\n", strerror(errno));
+            return err::ERR_IO;
+        }
+        return err::ERR_NONE;
+    }
+
+    err::Err JpegStreamer::set_html(std::string data) {
+        priv_t *priv = (priv_t *)_param;
+        if (data.size() == 0) {
+            log::error("html code is none!\r\n");
+            return err::ERR_RUNTIME;
+        }
+        std::lock_guard<std::mutex> guard(priv->lock);
+        priv->html = data;
+        return err::ERR_NONE;
+    }
+
+    int JpegStreamer::client_count() {
+        priv_t *priv = (priv_t *)_param;
+        return priv->stream_client_cnt;
+    }
+}
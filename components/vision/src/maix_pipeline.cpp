@@ -0,0 +1,563 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#include "maix_pipeline.hpp"
+#include "maix_camera.hpp"
+#include "maix_display.hpp"
+#include "maix_jpg_stream.hpp"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+namespace maix::pipeline
+{
+    /**
+     * Bounded queue between two stages, one producer(former stage) and one consumer(this stage).
+     * Push and pop are lock free, head and tail are monotonic counters, slot index is counter % capacity.
+     * Producer drops the oldest frame by taking head with CAS, consumer pops with CAS too,
+     * so only one of them owns the oldest frame.
+     * Mutex and condition variable are only used for sleep when empty(consumer) or full(producer in QUEUE_BLOCK),
+     * and notify only when someone is waiting.
+     */
+    class FrameQueue
+    {
+    public:
+        FrameQueue(int size, pipeline::QueuePolicy policy)
+            : _slots(new std::atomic<pipeline::Frame *>[size]), _cap(size), _policy(policy)
+        {
+            for (int i = 0; i < size; ++i)
+                _slots[i].store(nullptr, std::memory_order_relaxed);
+            _head.store(0);
+            _tail.store(0);
+            _waiters.store(0);
+            _done.store(false);
+            dropped.store(0);
+        }
+
+        ~FrameQueue()
+        {
+            clear();
+        }
+
+        /**
+         * @return false if stopped before pushed, frame is not taken
+         */
+        bool push(pipeline::Frame *frame, const std::atomic<bool> &stop)
+        {
+            uint64_t t = _tail.load(std::memory_order_relaxed);
+            while (true)
+            {
+                uint64_t h = _head.load();
+                if (t - h < _cap)
+                    break;
+                if (_policy == pipeline::QUEUE_DROP_OLDEST)
+                {
+                    pipeline::Frame *old = _slots[h % _cap].load(std::memory_order_acquire);
+                    if (_head.compare_exchange_strong(h, h + 1))
+                    {
+                        delete old;
+                        dropped.fetch_add(1, std::memory_order_relaxed);
+                        break;
+                    }
+                    continue;
+                }
+                if (stop.load(std::memory_order_relaxed) || app::need_exit())
+                    return false;
+                _wait([this, t]() { return t - _head.load() < _cap; });
+            }
+            _slots[t % _cap].store(frame, std::memory_order_release);
+            _tail.store(t + 1);
+            _notify();
+            return true;
+        }
+
+        /**
+         * @return nullptr if queue empty after waited a while
+         */
+        pipeline::Frame *pop()
+        {
+            for (int i = 0; i < 2; ++i)
+            {
+                uint64_t h = _head.load();
+                while (h != _tail.load())
+                {
+                    pipeline::Frame *frame = _slots[h % _cap].load(std::memory_order_acquire);
+                    if (_head.compare_exchange_strong(h, h + 1))
+                    {
+                        _notify();
+                        return frame;
+                    }
+                }
+                if (i == 0)
+                    _wait([this]() { return _head.load() != _tail.load() || _done.load(); });
+            }
+            return nullptr;
+        }
+
+        int size()
+        {
+            uint64_t h = _head.load();
+            uint64_t t = _tail.load();
+            return t > h ? (int)(t - h) : 0;
+        }
+
+        /**
+         * Former stage finished, no more frames will be pushed
+         */
+        void set_done()
+        {
+            _done.store(true);
+            _notify();
+        }
+
+        bool done()
+        {
+            return _done.load() && size() == 0;
+        }
+
+        void clear()
+        {
+            pipeline::Frame *frame;
+            while (size() > 0 && (frame = pop()) != nullptr)
+                delete frame;
+        }
+
+        void reset()
+        {
+            clear();
+            _done.store(false);
+            dropped.store(0);
+        }
+
+        std::atomic<uint64_t> dropped;
+
+    private:
+        std::unique_ptr<std::atomic<pipeline::Frame *>[]> _slots;
+        uint64_t _cap;
+        pipeline::QueuePolicy _policy;
+        std::atomic<uint64_t> _head;
+        std::atomic<uint64_t> _tail;
+        std::atomic<bool> _done;
+        std::atomic<int> _waiters;
+        std::mutex _mutex;
+        std::condition_variable _cond;
+
+        template <typename T>
+        void _wait(T ready)
+        {
+            _waiters.fetch_add(1);
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                // timeout to check stop flag
+                _cond.wait_for(lock, std::chrono::milliseconds(20), ready);
+            }
+            _waiters.fetch_sub(1);
+        }
+
+        void _notify()
+        {
+            if (_waiters.load() > 0)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _cond.notify_all();
+            }
+        }
+    };
+
+    /**
+     * Counters of last second, written by stage thread, read by stats()
+     */
+    class WindowStats
+    {
+    public:
+        WindowStats()
+        {
+            reset();
+        }
+
+        void reset()
+        {
+            _start_us = 0;
+            _count = 0;
+            _sum_us = 0;
+            fps.store(0);
+            avg_ms.store(0);
+            max_ms.store(0);
+            update_us.store(0);
+        }
+
+        void add(uint64_t now_us, uint64_t cost_us)
+        {
+            if (_start_us == 0)
+                _start_us = now_us;
+            ++_count;
+            _sum_us += cost_us;
+            if (cost_us / 1000.0f > max_ms.load(std::memory_order_relaxed))
+                max_ms.store(cost_us / 1000.0f, std::memory_order_relaxed);
+            if (now_us - _start_us >= 1000000)
+            {
+                fps.store(_count * 1000000.0f / (now_us - _start_us), std::memory_order_relaxed);
+                avg_ms.store(_sum_us / 1000.0f / _count, std::memory_order_relaxed);
+                update_us.store(now_us, std::memory_order_relaxed);
+                _start_us = now_us;
+                _count = 0;
+                _sum_us = 0;
+            }
+        }
+
+        /**
+         * fps of last second, 0 if no frame for more than 2 seconds
+         */
+        float get_fps()
+        {
+            uint64_t update = update_us.load(std::memory_order_relaxed);
+            if (update == 0 || time::ticks_us() - update > 2000000)
+                return 0;
+            return fps.load(std::memory_order_relaxed);
+        }
+
+        std::atomic<float> fps;
+        std::atomic<float> avg_ms;
+        std::atomic<float> max_ms;
+        std::atomic<uint64_t> update_us;
+
+    private:
+        uint64_t _start_us;
+        int _count;
+        uint64_t _sum_us;
+    };
+
+    class Stage
+    {
+    public:
+        Stage(const std::string &name, pipeline::StageFunc func, int queue_size, pipeline::QueuePolicy policy)
+            : name(name), func(func)
+        {
+            in = queue_size > 0 ? new FrameQueue(queue_size, policy) : nullptr;
+            thread = nullptr;
+            frames.store(0);
+            errors.store(0);
+        }
+
+        ~Stage()
+        {
+            delete thread;
+            delete in;
+        }
+
+        std::string name;
+        pipeline::StageFunc func;
+        FrameQueue *in;             // input queue, nullptr for source
+        Stage *next;
+        thread::Thread *thread;
+        std::atomic<uint64_t> frames;
+        std::atomic<uint64_t> errors;
+        WindowStats window;
+    };
+
+    typedef struct
+    {
+        Stage *source;
+        std::vector<Stage *> stages;
+        std::atomic<bool> stop;
+        std::atomic<bool> running;
+        std::atomic<bool> finished;
+        WindowStats e2e;            // end to end fps and latency
+        std::mutex mutex;
+        std::condition_variable cond;
+    } pipeline_param_t;
+
+    static void _finish(pipeline_param_t *param)
+    {
+        std::lock_guard<std::mutex> lock(param->mutex);
+        param->finished.store(true);
+        param->cond.notify_all();
+    }
+
+    static err::Err _call(Stage *stage, pipeline::Frame &frame)
+    {
+        try
+        {
+            return stage->func(frame);
+        }
+        catch (std::exception &e)
+        {
+            log::error("pipeline stage %s exception: %s", stage->name.c_str(), e.what());
+            return err::ERR_RUNTIME;
+        }
+    }
+
+    static void _source_thread(pipeline_param_t *param)
+    {
+        Stage *stage = param->source;
+        uint64_t seq = 0;
+        while (!param->stop.load() && !app::need_exit())
+        {
+            pipeline::Frame *frame = new pipeline::Frame();
+            frame->seq = seq;
+            uint64_t t = time::ticks_us();
+            err::Err e = _call(stage, *frame);
+            if (e == err::ERR_CANCEL)
+            {
+                delete frame;
+                break;
+            }
+            if (e != err::ERR_NONE)
+            {
+                delete frame;
+                stage->errors.fetch_add(1, std::memory_order_relaxed);
+                thread::sleep_ms(1);
+                continue;
+            }
+            uint64_t now = time::ticks_us();
+            if (frame->t_capture_us == 0)
+                frame->t_capture_us = now;
+            stage->frames.fetch_add(1, std::memory_order_relaxed);
+            stage->window.add(now, now - t);
+            ++seq;
+            if (!stage->next->in->push(frame, param->stop))
+                delete frame;
+        }
+        stage->next->in->set_done();
+    }
+
+    static void _stage_thread(pipeline_param_t *param, Stage *stage)
+    {
+        while (!param->stop.load() && !app::need_exit())
+        {
+            pipeline::Frame *frame = stage->in->pop();
+            if (!frame)
+            {
+                if (stage->in->done())
+                    break;
+                continue;
+            }
+            uint64_t t = time::ticks_us();
+            err::Err e = _call(stage, *frame);
+            uint64_t now = time::ticks_us();
+            if (e != err::ERR_NONE)
+            {
+                delete frame;
+                stage->errors.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            stage->frames.fetch_add(1, std::memory_order_relaxed);
+            stage->window.add(now, now - t);
+            if (stage->next)
+            {
+                if (!stage->next->in->push(frame, param->stop))
+                    delete frame;
+            }
+            else
+            {
+                param->e2e.add(now, now - frame->t_capture_us);
+                delete frame;
+            }
+        }
+        if (stage->next)
+            stage->next->in->set_done();
+        else
+            _finish(param);
+    }
+
+    Pipeline::Pipeline()
+    {
+        pipeline_param_t *param = new pipeline_param_t();
+        param->source = nullptr;
+        param->stop.store(false);
+        param->running.store(false);
+        param->finished.store(false);
+        _param = param;
+    }
+
+    Pipeline::~Pipeline()
+    {
+        pipeline_param_t *param = (pipeline_param_t *)_param;
+        stop();
+        delete param->source;
+        for (auto stage : param->stages)
+            delete stage;
+        delete param;
+    }
+
+    err::Err Pipeline::set_source(const std::string &name, pipeline::StageFunc read)
+    {
+        pipeline_param_t *param = (pipeline_param_t *)_param;
+        if (param->running.load())
+            return err::ERR_BUSY;
+        delete param->source;
+        param->source = new Stage(name, read, 0, pipeline::QUEUE_BLOCK);
+        return err::ERR_NONE;
+    }
+
+    err::Err Pipeline::add_stage(const std::string &name, pipeline::StageFunc process, int queue_size, pipeline::QueuePolicy policy)
+    {
+        pipeline_param_t *param = (pipeline_param_t *)_param;
+        if (param->running.load())
+            return err::ERR_BUSY;
+        if (queue_size <= 0)
+        {
+            log::error("pipeline stage %s queue_size should > 0", name.c_str());
+            return err::ERR_ARGS;
+        }
+        param->stages.push_back(new Stage(name, process, queue_size, policy));
+        return err::ERR_NONE;
+    }
+
+    err::Err Pipeline::start()
+    {
+        pipeline_param_t *param = (pipeline_param_t *)_param;
+        if (param->running.load())
+            return err::ERR_BUSY;
+        if (!param->source || param->stages.empty())
+        {
+            log::error("pipeline need one source and at least one stage");
+            return err::ERR_NOT_READY;
+        }
+        param->stop.store(false);
+        param->finished.store(false);
+        param->e2e.reset();
+        param->source->next = param->stages[0];
+        for (size_t i = 0; i < param->stages.size(); ++i)
+            param->stages[i]->next = i + 1 < param->stages.size() ? param->stages[i + 1] : nullptr;
+        std::vector<Stage *> all = {param->source};
+        all.insert(all.end(), param->stages.begin(), param->stages.end());
+        for (auto stage : all)
+        {
+            stage->frames.store(0);
+            stage->errors.store(0);
+            stage->window.reset();
+            if (stage->in)
+                stage->in->reset();
+        }
+        param->running.store(true);
+        // start from sink, so frames are taken as soon as source starts
+        for (auto it = param->stages.rbegin(); it != param->stages.rend(); ++it)
+        {
+            Stage *stage = *it;
+            delete stage->thread;
+            stage->thread = new thread::Thread([param, stage](void *) { _stage_thread(param, stage); });
+        }
+        delete param->source->thread;
+        param->source->thread = new thread::Thread([param](void *) { _source_thread(param); });
+        return err::ERR_NONE;
+    }
+
+    err::Err Pipeline::stop()
+    {
+        pipeline_param_t *param = (pipeline_param_t *)_param;
+        if (!param->running.load())
+            return err::ERR_NONE;
+        param->stop.store(true);
+        param->source->thread->join();
+        for (auto stage : param->stages)
+        {
+            stage->thread->join();
+            stage->in->clear();
+        }
+        param->running.store(false);
+        return err::ERR_NONE;
+    }
+
+    err::Err Pipeline::wait(int timeout_ms)
+    {
+        pipeline_param_t *param = (pipeline_param_t *)_param;
+        if (!param->running.load())
+            return err::ERR_NOT_READY;
+        uint64_t t = time::ticks_ms();
+        std::unique_lock<std::mutex> lock(param->mutex);
+        while (!param->finished.load())
+        {
+            if (app::need_exit())
+                return err::ERR_CANCEL;
+            if (timeout_ms >= 0 && time::ticks_ms() - t >= (uint64_t)timeout_ms)
+                return err::ERR_TIMEOUT;
+            param->cond.wait_for(lock, std::chrono::milliseconds(20));
+        }
+        lock.unlock();
+        stop();
+        return err::ERR_NONE;
+    }
+
+    bool Pipeline::is_running()
+    {
+        pipeline_param_t *param = (pipeline_param_t *)_param;
+        return param->running.load();
+    }
+
+    std::vector<pipeline::StageStats> Pipeline::stats()
+    {
+        pipeline_param_t *param = (pipeline_param_t *)_param;
+        std::vector<pipeline::StageStats> stats;
+        std::vector<Stage *> all;
+        if (param->source)
+            all.push_back(param->source);
+        all.insert(all.end(), param->stages.begin(), param->stages.end());
+        for (auto stage : all)
+        {
+            pipeline::StageStats s;
+            s.name = stage->name;
+            s.frames = stage->frames.load(std::memory_order_relaxed);
+            s.dropped = stage->errors.load(std::memory_order_relaxed) + (stage->in ? stage->in->dropped.load(std::memory_order_relaxed) : 0);
+            s.queue_len = stage->in ? stage->in->size() : 0;
+            s.fps = stage->window.get_fps();
+            s.latency_ms = stage->window.avg_ms.load(std::memory_order_relaxed);
+            s.latency_max_ms = stage->window.max_ms.load(std::memory_order_relaxed);
+            stats.push_back(s);
+        }
+        return stats;
+    }
+
+    float Pipeline::fps()
+    {
+        pipeline_param_t *param = (pipeline_param_t *)_param;
+        return param->e2e.get_fps();
+    }
+
+    float Pipeline::latency_ms()
+    {
+        pipeline_param_t *param = (pipeline_param_t *)_param;
+        return param->e2e.avg_ms.load(std::memory_order_relaxed);
+    }
+
+    std::string Pipeline::stats_str()
+    {
+        std::string str;
+        char buf[160];
+        for (auto &s : stats())
+        {
+            snprintf(buf, sizeof(buf), "%s: %.1f fps, %.1f ms(max %.1f), queue %d, dropped %llu\n",
+                     s.name.c_str(), s.fps, s.latency_ms, s.latency_max_ms, s.queue_len, (unsigned long long)s.dropped);
+            str += buf;
+        }
+        snprintf(buf, sizeof(buf), "all: %.1f fps, latency %.1f ms", fps(), latency_ms());
+        str += buf;
+        return str;
+    }
+
+    pipeline::StageFunc camera_source(camera::Camera &cam)
+    {
+        return [&cam](pipeline::Frame &frame) {
+            frame.img = cam.read();
+            return frame.img ? err::ERR_NONE : err::ERR_READ;
+        };
+    }
+
+    pipeline::StageFunc display_sink(display::Display &disp, image::Fit fit)
+    {
+        return [&disp, fit](pipeline::Frame &frame) {
+            return disp.show(*frame.img, fit);
+        };
+    }
+
+    pipeline::StageFunc jpeg_streamer_sink(http::JpegStreamer &streamer)
+    {
+        return [&streamer](pipeline::Frame &frame) {
+            return streamer.write(frame.img);
+        };
+    }
+} // namespace maix::pipeline
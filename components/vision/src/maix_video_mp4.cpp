@@ -0,0 +1,850 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#include "maix_video_mp4.hpp"
+#include "maix_log.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+
+namespace maix::video
+{
+    #define MP4_WRITE_ALIGN         4096
+    #define MP4_TIME_OFFSET         2082844800ULL   // seconds from 1904-01-01 to 1970-01-01
+    #define MP4_MAX_FRAGMENT_TIMES  5               // force new fragment if no key frame after fragment_ms * MP4_MAX_FRAGMENT_TIMES
+
+    #define SAMPLE_FLAGS_SYNC       0x02000000      // sample_depends_on = 2
+    #define SAMPLE_FLAGS_NON_SYNC   0x01010000      // sample_depends_on = 1, sample_is_non_sync_sample = 1
+
+    typedef struct
+    {
+        uint32_t size;
+        uint32_t duration;
+        uint32_t flags;
+        int32_t cts;        // pts - dts
+        uint64_t dts;
+    } mp4_sample_t;
+
+    typedef struct
+    {
+        uint64_t time;          // presentation time of the first key frame
+        uint64_t moof_offset;
+        uint32_t sample_number; // 1 based index of the first key frame in fragment
+    } mp4_fragment_t;
+
+    typedef struct
+    {
+        int fd;
+        uint8_t *buff;          // write buffer, MP4_WRITE_ALIGN aligned
+        int buff_size;
+        int buff_used;
+        uint64_t file_offset;   // data written to file, always MP4_WRITE_ALIGN aligned before finish
+        uint64_t prealloc_end;
+        int prealloc_size;
+
+        bool h265;
+        int width;
+        int height;
+        int time_base;
+        uint32_t default_duration;
+        int fragment_ms;
+        std::vector<uint8_t> vps;
+        std::vector<uint8_t> sps;
+        std::vector<uint8_t> pps;
+        bool header_written;
+        bool finished;
+        bool warned;
+        uint64_t duration_pos[4];   // file offset of duration fields of mvhd, tkhd, mdhd and mehd
+
+        std::vector<std::pair<int, int>> nals;  // NAL units of current frame, offset and length
+        std::vector<uint8_t> mdat;              // data of current fragment
+        std::vector<mp4_sample_t> samples;      // samples of current fragment
+        int frag_key;                           // index of first key frame in current fragment, -1 means no key frame
+        uint32_t seq;
+        std::vector<mp4_fragment_t> fragments;
+        std::vector<uint8_t> box;               // boxes build buffer
+
+        int frame_count;
+        uint64_t first_dts;
+        uint64_t last_dts;
+        uint32_t last_duration;
+    } mp4_param_t;
+
+    static inline void _put8(std::vector<uint8_t> &b, uint8_t v)
+    {
+        b.push_back(v);
+    }
+
+    static inline void _put16(std::vector<uint8_t> &b, uint16_t v)
+    {
+        b.push_back(v >> 8);
+        b.push_back(v);
+    }
+
+    static inline void _put32(std::vector<uint8_t> &b, uint32_t v)
+    {
+        b.push_back(v >> 24);
+        b.push_back(v >> 16);
+        b.push_back(v >> 8);
+        b.push_back(v);
+    }
+
+    static inline void _put64(std::vector<uint8_t> &b, uint64_t v)
+    {
+        _put32(b, v >> 32);
+        _put32(b, v);
+    }
+
+    static inline void _set32(uint8_t *p, uint32_t v)
+    {
+        p[0] = v >> 24;
+        p[1] = v >> 16;
+        p[2] = v >> 8;
+        p[3] = v;
+    }
+
+    static inline void _put_bytes(std::vector<uint8_t> &b, const uint8_t *data, size_t len)
+    {
+        b.insert(b.end(), data, data + len);
+    }
+
+    static inline void _put_zeros(std::vector<uint8_t> &b, size_t len)
+    {
+        b.insert(b.end(), len, 0);
+    }
+
+    static inline void _put_fourcc(std::vector<uint8_t> &b, const char *type)
+    {
+        _put_bytes(b, (const uint8_t *)type, 4);
+    }
+
+    static inline size_t _box_begin(std::vector<uint8_t> &b, const char *type)
+    {
+        size_t pos = b.size();
+        _put32(b, 0);
+        _put_fourcc(b, type);
+        return pos;
+    }
+
+    static inline size_t _full_box_begin(std::vector<uint8_t> &b, const char *type, uint8_t version, uint32_t flags)
+    {
+        size_t pos = _box_begin(b, type);
+        _put32(b, (uint32_t)version << 24 | flags);
+        return pos;
+    }
+
+    static inline void _box_end(std::vector<uint8_t> &b, size_t pos)
+    {
+        _set32(b.data() + pos, b.size() - pos);
+    }
+
+    static void _put_matrix(std::vector<uint8_t> &b)
+    {
+        const uint32_t matrix[9] = {0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000};
+        for (int i = 0; i < 9; ++i)
+            _put32(b, matrix[i]);
+    }
+
+    /**
+     * find start code(00 00 01 or 00 00 00 01) from pos
+     * @return offset of start code, len if not found
+     */
+    static int _find_start_code(const uint8_t *data, int len, int pos, int *sc_len)
+    {
+        int i = pos;
+        while (i + 2 < len)
+        {
+            const uint8_t *p = (const uint8_t *)memchr(data + i + 2, 1, len - i - 2);
+            if (!p)
+                break;
+            int k = p - data;
+            if (data[k - 1] == 0 && data[k - 2] == 0)
+            {
+                int s = k - 2;
+                if (s > pos && data[s - 1] == 0)
+                {
+                    *sc_len = 4;
+                    return s - 1;
+                }
+                *sc_len = 3;
+                return s;
+            }
+            i = k - 1;
+        }
+        *sc_len = 0;
+        return len;
+    }
+
+    static void _prealloc(mp4_param_t *param, size_t len)
+    {
+        if (param->prealloc_size <= 0 || param->file_offset + len <= param->prealloc_end)
+            return;
+        uint64_t size = std::max((uint64_t)param->prealloc_size, (uint64_t)len);
+        // keep file size, file is still valid if crash
+        if (fallocate(param->fd, FALLOC_FL_KEEP_SIZE, param->file_offset, size) != 0)
+        {
+            log::debug("mp4 file not support preallocate(%d), disable it\r\n", errno);
+            param->prealloc_size = 0;
+            return;
+        }
+        param->prealloc_end = param->file_offset + size;
+    }
+
+    /**
+     * write len bytes from the head of write buffer to file, keep the rest in buffer
+     */
+    static err::Err _write_buff(mp4_param_t *param, int len)
+    {
+        _prealloc(param, len);
+        int done = 0;
+        while (done < len)
+        {
+            ssize_t n = ::write(param->fd, param->buff + done, len - done);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                log::error("write mp4 file failed: %d\r\n", errno);
+                return err::ERR_IO;
+            }
+            done += n;
+        }
+        param->file_offset += len;
+        param->buff_used -= len;
+        if (param->buff_used > 0)
+            memmove(param->buff, param->buff + len, param->buff_used);
+        return err::ERR_NONE;
+    }
+
+    static err::Err _out(mp4_param_t *param, const uint8_t *data, size_t len)
+    {
+        while (len > 0)
+        {
+            size_t n = std::min(len, (size_t)(param->buff_size - param->buff_used));
+            memcpy(param->buff + param->buff_used, data, n);
+            param->buff_used += n;
+            data += n;
+            len -= n;
+            if (param->buff_used == param->buff_size)
+            {
+                err::Err e = _write_buff(param, param->buff_used);
+                if (e != err::ERR_NONE)
+                    return e;
+            }
+        }
+        return err::ERR_NONE;
+    }
+
+    /**
+     * write buffered data, only aligned blocks if not all, the tail is kept in buffer to be written with the next data
+     */
+    static err::Err _flush(mp4_param_t *param, bool all)
+    {
+        int len = all ? param->buff_used : param->buff_used & ~(MP4_WRITE_ALIGN - 1);
+        if (len == 0)
+            return err::ERR_NONE;
+        return _write_buff(param, len);
+    }
+
+    /**
+     * remove emulation prevention bytes
+     */
+    static std::vector<uint8_t> _nal_to_rbsp(const uint8_t *data, size_t len)
+    {
+        std::vector<uint8_t> rbsp;
+        rbsp.reserve(len);
+        int zeros = 0;
+        for (size_t i = 0; i < len; ++i)
+        {
+            if (zeros >= 2 && data[i] == 3)
+            {
+                zeros = 0;
+                continue;
+            }
+            zeros = data[i] == 0 ? zeros + 1 : 0;
+            rbsp.push_back(data[i]);
+        }
+        return rbsp;
+    }
+
+    static void _put_avcc(mp4_param_t *param, std::vector<uint8_t> &b)
+    {
+        size_t pos = _box_begin(b, "avcC");
+        _put8(b, 1);
+        _put8(b, param->sps[1]);    // profile_idc
+        _put8(b, param->sps[2]);    // constraint flags
+        _put8(b, param->sps[3]);    // level_idc
+        _put8(b, 0xFF);             // 4 bytes NAL length
+        _put8(b, 0xE1);             // 1 SPS
+        _put16(b, param->sps.size());
+        _put_bytes(b, param->sps.data(), param->sps.size());
+        _put8(b, 1);                // 1 PPS
+        _put16(b, param->pps.size());
+        _put_bytes(b, param->pps.data(), param->pps.size());
+        _box_end(b, pos);
+    }
+
+    static void _put_hvcc(mp4_param_t *param, std::vector<uint8_t> &b)
+    {
+        // skip 2 bytes NAL header, then sps_video_parameter_set_id(4), sps_max_sub_layers_minus1(3), sps_temporal_id_nesting_flag(1),
+        // general profile_tier_level: profile space, tier, profile idc(1 byte), compatibility flags(4), constraint flags(6), level idc(1)
+        std::vector<uint8_t> rbsp = _nal_to_rbsp(param->sps.data() + 2, std::min(param->sps.size() - 2, (size_t)32));
+        if (rbsp.size() < 13)
+            rbsp.resize(13, 0);
+        int max_sub_layers = (rbsp[0] >> 1 & 0x07) + 1;
+        int temporal_id_nested = rbsp[0] & 0x01;
+        size_t pos = _box_begin(b, "hvcC");
+        _put8(b, 1);
+        _put_bytes(b, rbsp.data() + 1, 12);
+        _put16(b, 0xF000);          // min_spatial_segmentation_idc 0
+        _put8(b, 0xFC);             // parallelismType 0
+        _put8(b, 0xFD);             // chroma_format_idc 1(4:2:0), encoders of maix output 8bit 4:2:0 only
+        _put8(b, 0xF8);             // bit_depth_luma_minus8 0
+        _put8(b, 0xF8);             // bit_depth_chroma_minus8 0
+        _put16(b, 0);               // avgFrameRate
+        _put8(b, max_sub_layers << 3 | temporal_id_nested << 2 | 0x03); // 4 bytes NAL length
+        _put8(b, 3);
+        const std::vector<uint8_t> *sets[3] = {&param->vps, &param->sps, &param->pps};
+        const uint8_t types[3] = {32, 33, 34};
+        for (int i = 0; i < 3; ++i)
+        {
+            _put8(b, 0x80 | types[i]); // array_completeness 1, parameter sets only in hvcC
+            _put16(b, 1);
+            _put16(b, sets[i]->size());
+            _put_bytes(b, sets[i]->data(), sets[i]->size());
+        }
+        _box_end(b, pos);
+    }
+
+    static bool _has_param_sets(mp4_param_t *param)
+    {
+        if (param->h265)
+            return param->vps.size() > 2 && param->sps.size() >= 16 && param->pps.size() > 2;
+        return param->sps.size() >= 4 && param->pps.size() > 1;
+    }
+
+    /**
+     * ftyp and moov, moov has empty sample tables and mvex, samples are in fragments
+     */
+    static err::Err _write_header(mp4_param_t *param)
+    {
+        std::vector<uint8_t> &b = param->box;
+        b.clear();
+        uint64_t base = param->file_offset + param->buff_used;
+        uint64_t now = (uint64_t)::time(NULL) + MP4_TIME_OFFSET;
+
+        size_t pos = _box_begin(b, "ftyp");
+        _put_fourcc(b, "isom");
+        _put32(b, 0x200);
+        _put_fourcc(b, "isom");
+        _put_fourcc(b, "iso6");
+        _put_fourcc(b, "mp41");
+        _box_end(b, pos);
+
+        size_t moov = _box_begin(b, "moov");
+        pos = _full_box_begin(b, "mvhd", 1, 0);
+        _put64(b, now);
+        _put64(b, now);
+        _put32(b, param->time_base);
+        param->duration_pos[0] = base + b.size();
+        _put64(b, 0);
+        _put32(b, 0x00010000);      // rate 1.0
+        _put16(b, 0x0100);          // volume 1.0
+        _put_zeros(b, 10);
+        _put_matrix(b);
+        _put_zeros(b, 24);
+        _put32(b, 2);               // next_track_ID
+        _box_end(b, pos);
+
+        size_t trak = _box_begin(b, "trak");
+        pos = _full_box_begin(b, "tkhd", 1, 0x03); // enabled, in movie
+        _put64(b, now);
+        _put64(b, now);
+        _put32(b, 1);               // track_ID
+        _put32(b, 0);
+        param->duration_pos[1] = base + b.size();
+        _put64(b, 0);
+        _put_zeros(b, 8);
+        _put32(b, 0);               // layer, alternate_group
+        _put32(b, 0);               // volume, reserved
+        _put_matrix(b);
+        _put32(b, (uint32_t)param->width << 16);
+        _put32(b, (uint32_t)param->height << 16);
+        _box_end(b, pos);
+
+        size_t mdia = _box_begin(b, "mdia");
+        pos = _full_box_begin(b, "mdhd", 1, 0);
+        _put64(b, now);
+        _put64(b, now);
+        _put32(b, param->time_base);
+        param->duration_pos[2] = base + b.size();
+        _put64(b, 0);
+        _put16(b, 0x55C4);          // language "und"
+        _put16(b, 0);
+        _box_end(b, pos);
+        pos = _full_box_begin(b, "hdlr", 0, 0);
+        _put32(b, 0);
+        _put_fourcc(b, "vide");
+        _put_zeros(b, 12);
+        _put_bytes(b, (const uint8_t *)"VideoHandler", 13);
+        _box_end(b, pos);
+
+        size_t minf = _box_begin(b, "minf");
+        pos = _full_box_begin(b, "vmhd", 0, 1);
+        _put_zeros(b, 8);
+        _box_end(b, pos);
+        size_t dinf = _box_begin(b, "dinf");
+        size_t dref = _full_box_begin(b, "dref", 0, 0);
+        _put32(b, 1);
+        pos = _full_box_begin(b, "url ", 0, 1); // data in this file
+        _box_end(b, pos);
+        _box_end(b, dref);
+        _box_end(b, dinf);
+
+        size_t stbl = _box_begin(b, "stbl");
+        size_t stsd = _full_box_begin(b, "stsd", 0, 0);
+        _put32(b, 1);
+        size_t entry = _box_begin(b, param->h265 ? "hvc1" : "avc1");
+        _put_zeros(b, 6);
+        _put16(b, 1);               // data_reference_index
+        _put_zeros(b, 16);
+        _put16(b, param->width);
+        _put16(b, param->height);
+        _put32(b, 0x00480000);      // 72 dpi
+        _put32(b, 0x00480000);
+        _put32(b, 0);
+        _put16(b, 1);               // frame_count
+        _put_zeros(b, 32);          // compressorname
+        _put16(b, 0x0018);          // depth
+        _put16(b, 0xFFFF);
+        if (param->h265)
+            _put_hvcc(param, b);
+        else
+            _put_avcc(param, b);
+        _box_end(b, entry);
+        _box_end(b, stsd);
+        const char *empty_tables[] = {"stts", "stsc", "stco"};
+        for (int i = 0; i < 3; ++i)
+        {
+            pos = _full_box_begin(b, empty_tables[i], 0, 0);
+            _put32(b, 0);
+            _box_end(b, pos);
+        }
+        pos = _full_box_begin(b, "stsz", 0, 0);
+        _put32(b, 0);
+        _put32(b, 0);
+        _box_end(b, pos);
+        _box_end(b, stbl);
+        _box_end(b, minf);
+        _box_end(b, mdia);
+        _box_end(b, trak);
+
+        size_t mvex = _box_begin(b, "mvex");
+        pos = _full_box_begin(b, "mehd", 1, 0);
+        param->duration_pos[3] = base + b.size();
+        _put64(b, 0);
+        _box_end(b, pos);
+        pos = _full_box_begin(b, "trex", 0, 0);
+        _put32(b, 1);               // track_ID
+        _put32(b, 1);               // default_sample_description_index
+        _put32(b, 0);
+        _put32(b, 0);
+        _put32(b, 0);
+        _box_end(b, pos);
+        _box_end(b, mvex);
+        _box_end(b, moov);
+
+        param->header_written = true;
+        return _out(param, b.data(), b.size());
+    }
+
+    /**
+     * write moof and mdat of current fragment
+     */
+    static err::Err _write_fragment(mp4_param_t *param)
+    {
+        if (param->samples.empty())
+            return err::ERR_NONE;
+        std::vector<uint8_t> &b = param->box;
+        b.clear();
+        uint64_t moof_offset = param->file_offset + param->buff_used;
+        const mp4_sample_t &first = param->samples[0];
+
+        size_t moof = _box_begin(b, "moof");
+        size_t pos = _full_box_begin(b, "mfhd", 0, 0);
+        _put32(b, ++param->seq);
+        _box_end(b, pos);
+        size_t traf = _box_begin(b, "traf");
+        pos = _full_box_begin(b, "tfhd", 0, 0x020000); // default-base-is-moof
+        _put32(b, 1);
+        _box_end(b, pos);
+        pos = _full_box_begin(b, "tfdt", 1, 0);
+        _put64(b, first.dts - param->first_dts);
+        _box_end(b, pos);
+        // data offset, sample duration, size, flags and composition time offset present, version 1 for signed offset
+        pos = _full_box_begin(b, "trun", 1, 0x000F01);
+        _put32(b, param->samples.size());
+        size_t data_offset_pos = b.size();
+        _put32(b, 0);
+        for (const mp4_sample_t &s : param->samples)
+        {
+            _put32(b, s.duration);
+            _put32(b, s.size);
+            _put32(b, s.flags);
+            _put32(b, (uint32_t)s.cts);
+        }
+        _box_end(b, pos);
+        _box_end(b, traf);
+        _box_end(b, moof);
+        _set32(b.data() + data_offset_pos, b.size() - moof + 8);
+        _put32(b, param->mdat.size() + 8);
+        _put_fourcc(b, "mdat");
+
+        if (param->frag_key >= 0)
+        {
+            const mp4_sample_t &key = param->samples[param->frag_key];
+            param->fragments.push_back({key.dts - param->first_dts + key.cts, moof_offset, (uint32_t)param->frag_key + 1});
+        }
+        param->samples.clear();
+        param->frag_key = -1;
+        err::Err e = _out(param, b.data(), b.size());
+        if (e == err::ERR_NONE)
+            e = _out(param, param->mdat.data(), param->mdat.size());
+        param->mdat.clear();
+        if (e != err::ERR_NONE)
+            return e;
+        // fragment complete, write it to file so it's safe if crash
+        return _flush(param, false);
+    }
+
+    /**
+     * random access index, players can seek without reading all moof
+     */
+    static err::Err _write_mfra(mp4_param_t *param)
+    {
+        std::vector<uint8_t> &b = param->box;
+        b.clear();
+        size_t mfra = _box_begin(b, "mfra");
+        size_t pos = _full_box_begin(b, "tfra", 1, 0);
+        _put32(b, 1);               // track_ID
+        _put32(b, 0);               // traf, trun and sample number are all 1 byte
+        _put32(b, param->fragments.size());
+        for (const mp4_fragment_t &f : param->fragments)
+        {
+            _put64(b, f.time);
+            _put64(b, f.moof_offset);
+            _put8(b, 1);
+            _put8(b, 1);
+            _put8(b, std::min(f.sample_number, (uint32_t)255));
+        }
+        _box_end(b, pos);
+        pos = _full_box_begin(b, "mfro", 0, 0);
+        _put32(b, b.size() - mfra + 4);
+        _box_end(b, pos);
+        _box_end(b, mfra);
+        return _out(param, b.data(), b.size());
+    }
+
+    static uint64_t _duration(mp4_param_t *param)
+    {
+        if (param->frame_count == 0)
+            return 0;
+        return param->last_dts - param->first_dts + param->last_duration;
+    }
+
+    MP4Muxer::MP4Muxer(const std::string &path, video::VideoType type, int width, int height, int time_base, int framerate,
+                       int fragment_ms, int buff_size, int prealloc_size)
+    {
+        bool h265;
+        switch (type)
+        {
+        case VIDEO_H264_CBR:
+        case VIDEO_H264_CBR_MP4:
+            h265 = false;
+            break;
+        case VIDEO_H265_CBR:
+        case VIDEO_H265_CBR_MP4:
+        case VIDEO_ENC_H265_CBR:
+        case VIDEO_ENC_MP4_CBR:
+            h265 = true;
+            break;
+        default:
+            throw err::Exception(err::ERR_ARGS, "mp4 muxer only support H.264 and H.265");
+        }
+        if (width <= 0 || height <= 0 || time_base <= 0 || framerate <= 0 || fragment_ms <= 0)
+            throw err::Exception(err::ERR_ARGS, "invalid mp4 muxer args");
+        _path = path;
+        buff_size = std::max(MP4_WRITE_ALIGN * 2, (buff_size + MP4_WRITE_ALIGN - 1) & ~(MP4_WRITE_ALIGN - 1));
+        uint8_t *buff = NULL;
+        if (posix_memalign((void **)&buff, MP4_WRITE_ALIGN, buff_size) != 0)
+            throw err::Exception(err::ERR_NO_MEM, "alloc mp4 write buffer failed");
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (fd < 0)
+        {
+            free(buff);
+            throw err::Exception(err::ERR_IO, "open " + path + " failed");
+        }
+        mp4_param_t *param = new mp4_param_t();
+        param->fd = fd;
+        param->buff = buff;
+        param->buff_size = buff_size;
+        param->buff_used = 0;
+        param->file_offset = 0;
+        param->prealloc_end = 0;
+        param->prealloc_size = std::max(prealloc_size, 0);
+        param->h265 = h265;
+        param->width = width;
+        param->height = height;
+        param->time_base = time_base;
+        param->default_duration = std::max(1, (time_base + framerate / 2) / framerate);
+        param->fragment_ms = fragment_ms;
+        param->header_written = false;
+        param->finished = false;
+        param->warned = false;
+        param->frag_key = -1;
+        param->seq = 0;
+        param->frame_count = 0;
+        param->first_dts = 0;
+        param->last_dts = 0;
+        param->last_duration = param->default_duration;
+        _param = param;
+    }
+
+    MP4Muxer::~MP4Muxer()
+    {
+        finish();
+        mp4_param_t *param = (mp4_param_t *)_param;
+        if (param)
+        {
+            free(param->buff);
+            delete param;
+            _param = nullptr;
+        }
+    }
+
+    err::Err MP4Muxer::write(const uint8_t *data, int len, uint64_t pts, uint64_t dts)
+    {
+        mp4_param_t *param = (mp4_param_t *)_param;
+        if (param->finished)
+            return err::ERR_NOT_OPEN;
+        if (!data || len <= 0)
+            return err::ERR_ARGS;
+
+        // split NAL units, keep parameter sets for codec config
+        param->nals.clear();
+        bool key = false;
+        int sc_len;
+        int start = _find_start_code(data, len, 0, &sc_len);
+        if (start == len)
+            return err::ERR_ARGS;
+        while (start < len)
+        {
+            int nal = start + sc_len;
+            int next = _find_start_code(data, len, nal, &sc_len);
+            int end = next;
+            while (end > nal && data[end - 1] == 0)
+                --end;
+            start = next;
+            if (end - nal < (param->h265 ? 3 : 2))
+                continue;
+            std::vector<uint8_t> *param_set = nullptr;
+            if (param->h265)
+            {
+                int type = data[nal] >> 1 & 0x3F;
+                if (type == 32)
+                    param_set = &param->vps;
+                else if (type == 33)
+                    param_set = &param->sps;
+                else if (type == 34)
+                    param_set = &param->pps;
+                else if (type == 35 || type == 38) // AUD, filler data
+                    continue;
+                else if (type >= 16 && type <= 21)
+                    key = true;
+            }
+            else
+            {
+                int type = data[nal] & 0x1F;
+                if (type == 7)
+                    param_set = &param->sps;
+                else if (type == 8)
+                    param_set = &param->pps;
+                else if (type == 9 || type == 12) // AUD, filler data
+                    continue;
+                else if (type == 5)
+                    key = true;
+            }
+            if (param_set)
+            {
+                if (!param->header_written)
+                    param_set->assign(data + nal, data + end);
+                else if (param_set->size() != (size_t)(end - nal) || memcmp(param_set->data(), data + nal, end - nal) != 0)
+                    log::warn("mp4 muxer not support parameter sets change, ignore new one\r\n");
+                continue;
+            }
+            param->nals.push_back({nal, end - nal});
+        }
+        if (param->nals.empty())
+            return err::ERR_NONE;
+        if (!param->header_written)
+        {
+            if (!key || !_has_param_sets(param))
+            {
+                if (!param->warned)
+                {
+                    log::warn("mp4 muxer wait key frame with parameter sets, drop frame\r\n");
+                    param->warned = true;
+                }
+                return err::ERR_NOT_READY;
+            }
+            err::Err e = _write_header(param);
+            if (e != err::ERR_NONE)
+                return e;
+        }
+
+        // timestamps, dts must increase
+        if (pts == (uint64_t)-1)
+            pts = param->frame_count > 0 ? param->last_dts + param->default_duration : 0;
+        if (dts == (uint64_t)-1)
+            dts = pts;
+        if (param->frame_count > 0)
+        {
+            if (dts <= param->last_dts)
+            {
+                dts = param->last_dts + 1;
+                pts = std::max(pts, dts);
+            }
+            param->last_duration = dts - param->last_dts;
+            if (!param->samples.empty())
+                param->samples.back().duration = param->last_duration;
+        }
+        else
+        {
+            param->first_dts = dts;
+        }
+
+        // new fragment at key frame
+        if (!param->samples.empty())
+        {
+            uint64_t frag_ms = (dts - param->samples[0].dts) * 1000 / param->time_base;
+            if ((key && frag_ms >= (uint64_t)param->fragment_ms) || frag_ms >= (uint64_t)param->fragment_ms * MP4_MAX_FRAGMENT_TIMES)
+            {
+                err::Err e = _write_fragment(param);
+                if (e != err::ERR_NONE)
+                    return e;
+            }
+        }
+
+        // Annex-B to 4 bytes length prefixed NAL units
+        size_t size = 0;
+        for (auto &nal : param->nals)
+            size += nal.second + 4;
+        size_t pos = param->mdat.size();
+        param->mdat.resize(pos + size);
+        uint8_t *p = param->mdat.data() + pos;
+        for (auto &nal : param->nals)
+        {
+            _set32(p, nal.second);
+            memcpy(p + 4, data + nal.first, nal.second);
+            p += nal.second + 4;
+        }
+        if (key && param->frag_key < 0)
+            param->frag_key = param->samples.size();
+        param->samples.push_back({(uint32_t)size, param->last_duration, (uint32_t)(key ? SAMPLE_FLAGS_SYNC : SAMPLE_FLAGS_NON_SYNC),
+                                  (int32_t)(int64_t)(pts - dts), dts});
+        param->last_dts = dts;
+        ++param->frame_count;
+        return err::ERR_NONE;
+    }
+
+    err::Err MP4Muxer::write(video::Frame *frame)
+    {
+        if (!frame || !frame->is_valid())
+            return err::ERR_ARGS;
+        return write(frame->data(), frame->size(), frame->get_pts(), frame->get_dts());
+    }
+
+    err::Err MP4Muxer::write(video::Packet *packet)
+    {
+        if (!packet || !packet->is_valid())
+            return err::ERR_ARGS;
+        return write(packet->data(), packet->data_size(), packet->get_pts(), packet->get_dts());
+    }
+
+    err::Err MP4Muxer::flush()
+    {
+        mp4_param_t *param = (mp4_param_t *)_param;
+        if (param->finished)
+            return err::ERR_NOT_OPEN;
+        err::Err e = _write_fragment(param);
+        if (e != err::ERR_NONE)
+            return e;
+        return _flush(param, true);
+    }
+
+    err::Err MP4Muxer::finish()
+    {
+        mp4_param_t *param = (mp4_param_t *)_param;
+        if (!param || param->finished)
+            return err::ERR_NONE;
+        param->finished = true;
+        err::Err e = err::ERR_NONE;
+        if (param->header_written)
+        {
+            e = _write_fragment(param);
+            if (e == err::ERR_NONE)
+                e = _write_mfra(param);
+        }
+        if (e == err::ERR_NONE)
+            e = _flush(param, true);
+        // release preallocated space after file end
+        if (param->prealloc_end > param->file_offset && ftruncate(param->fd, param->file_offset) != 0)
+            log::warn("truncate %s failed: %d\r\n", _path.c_str(), errno);
+        // fill duration in the moov at the front of file
+        if (e == err::ERR_NONE && param->header_written)
+        {
+            uint8_t v[8];
+            uint64_t duration = _duration(param);
+            for (int i = 0; i < 8; ++i)
+                v[i] = duration >> (56 - i * 8);
+            for (int i = 0; i < 4; ++i)
+            {
+                if (pwrite(param->fd, v, 8, param->duration_pos[i]) != 8)
+                {
+                    log::error("write mp4 duration failed: %d\r\n", errno);
+                    e = err::ERR_IO;
+                    break;
+                }
+            }
+        }
+        fsync(param->fd);
+        ::close(param->fd);
+        param->fd = -1;
+        return e;
+    }
+
+    int MP4Muxer::frame_count()
+    {
+        return ((mp4_param_t *)_param)->frame_count;
+    }
+
+    uint64_t MP4Muxer::duration()
+    {
+        return _duration((mp4_param_t *)_param);
+    }
+
+    uint64_t MP4Muxer::size()
+    {
+        mp4_param_t *param = (mp4_param_t *)_param;
+        return param->file_offset + param->buff_used + param->mdat.size();
+    }
+} // namespace maix::video
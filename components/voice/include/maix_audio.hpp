@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add period size, device and xrun count, implement ALSA backend on Linux.
  */
 
 #pragma once
@@ -50,6 +51,7 @@ namespace maix::audio
         size_t _buffer_size;
         FILE *_file;
         int _period_size;
+        uint64_t _xrun_count;
     public:
         /**
          * @brief Construct a new Recorder object. currectly only pcm and wav formats supported.
@@ -57,10 +59,15 @@ namespace maix::audio
          * @param sample_rate record sample rate, default is 48000(48KHz), means 48000 samples per second.
          * @param format record sample format, default is audio::Format::FMT_S16_LE, means sampling 16 bits at a time and save as signed 16 bits, little endian. see @audio::Format
          * @param channel record sample channel, default is 1, means 1 channel sampling at the same time
+         * @param period_size frames of one ALSA period, smaller period means lower latency and more wakeups,
+         *                    default is 0, means use driver default on MaixCAM, and 10ms on Linux.
+         * @param device ALSA pcm device name, default is empty, means "hw:0,0" on MaixCAM and "default" on Linux,
+         *               you can use "null", "hw:Loopback,1,0" or other ALSA device for test.
          * @maixpy maix.audio.Recorder.__init__
          * @maixcdk maix.audio.Recorder.Recorder
          */
-        Recorder(std::string path = std::string(), int sample_rate = 48000, audio::Format format = audio::Format::FMT_S16_LE, int channel = 1);
+        Recorder(std::string path = std::string(), int sample_rate = 48000, audio::Format format = audio::Format::FMT_S16_LE, int channel = 1,
+                int period_size = 0, std::string device = std::string());
         ~Recorder();
 
         /**
@@ -75,6 +82,7 @@ namespace maix::audio
         /**
          * Record, Read all cached data in buffer and return. If there is no audio data in the buffer, may return empty data.
          * @param record_ms Block and record audio data lasting `record_ms` milliseconds and save it to a file, the return value does not return audio data. Only valid if the initialisation `path` is set.
+         * On Linux, data is captured by a background thread since created, and written to file period by period, no whole clip is kept in memory.
          * @return pcm data. datatype @see Bytes. If you pass in record_ms parameter, the return value is an empty Bytes object.
          * @maixpy maix.audio.Recorder.record
         */
@@ -87,6 +95,22 @@ namespace maix::audio
         */
         err::Err finish();
 
+        /**
+         * Get frames of one ALSA period
+         * @return returns period size in frames
+         * @maixpy maix.audio.Recorder.period_size
+         */
+        int period_size() {
+            return _period_size;
+        }
+
+        /**
+         * Get count of xrun, xrun means overrun(capture data not read in time, or record buffer full), samples are lost when xrun happens.
+         * @return returns xrun count since created
+         * @maixpy maix.audio.Recorder.xrun_count
+         */
+        uint64_t xrun_count();
+
         /**
          * Get sample rate
          * @return returns sample rate
@@ -131,6 +155,7 @@ namespace maix::audio
         size_t _buffer_size;
         FILE *_file;
         int _period_size;
+        uint64_t _xrun_count;
     public:
         static maix::Bytes *NoneBytes;
 
@@ -140,10 +165,15 @@ namespace maix::audio
          * @param sample_rate player sample rate, default is 48000(48KHz), means 48000 samples per second.
          * @param format player sample format, default is audio::Format::FMT_S16_LE, means sampling 16 bits at a time and save as signed 16 bits, little endian. see @audio::Format
          * @param channel player sample channel, default is 1, means 1 channel sampling at the same time
+         * @param period_size frames of one ALSA period, smaller period means lower latency and more wakeups,
+         *                    default is 0, means use driver default on MaixCAM, and 10ms on Linux.
+         * @param device ALSA pcm device name, default is empty, means "hw:1,0" on MaixCAM and "default" on Linux,
+         *               you can use "null", "hw:Loopback,0,0" or other ALSA device for test.
          * @maixpy maix.audio.Player.__init__
          * @maixcdk maix.audio.Player.Player
          */
-        Player(std::string path = std::string(), int sample_rate = 48000, audio::Format format = audio::Format::FMT_S16_LE, int channel = 1);
+        Player(std::string path = std::string(), int sample_rate = 48000, audio::Format format = audio::Format::FMT_S16_LE, int channel = 1,
+                int period_size = 0, std::string device = std::string());
         ~Player();
 
         /**
@@ -157,12 +187,30 @@ namespace maix::audio
 
         /**
          * Play
-         * @param data audio data, must be raw data
+         * @param data audio data, must be raw data.
+         * On Linux, data is queued to the playback thread and this function returns when all data is queued,
+         * if data is not passed in, play file of `path` and return when file is played.
          * @return error code, err::ERR_NONE means success, others means failed
          * @maixpy maix.audio.Player.play
         */
         err::Err play(maix::Bytes *data = maix::audio::Player::NoneBytes);
 
+        /**
+         * Get frames of one ALSA period
+         * @return returns period size in frames
+         * @maixpy maix.audio.Player.period_size
+         */
+        int period_size() {
+            return _period_size;
+        }
+
+        /**
+         * Get count of xrun, xrun means underrun(playback data not written in time), samples are lost when xrun happens.
+         * @return returns xrun count since created
+         * @maixpy maix.audio.Player.xrun_count
+         */
+        uint64_t xrun_count();
+
         /**
          * Get sample rate
          * @return returns sample rate
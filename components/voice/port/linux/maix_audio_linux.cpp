@@ -3,65 +3,791 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Implement Recorder and Player with ALSA, capture and playback run in their own thread.
  */
 
 #include <stdint.h>
 #include "maix_basic.hpp"
 #include "maix_err.hpp"
 #include "maix_audio.hpp"
+#include "alsa/asoundlib.h"
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <thread>
+#include <atomic>
 
 using namespace maix;
 
 namespace maix::audio
 {
-    Recorder::Recorder(std::string path, int sample_rate, audio::Format format, int channel) {
+    /**
+     * Single producer single consumer ring buffer, the ALSA thread and the user thread never wait for each other.
+     * Data is pushed in whole chunks, so the consumer always see complete frames.
+     */
+    class SpscRing
+    {
+    public:
+        SpscRing(size_t size)
+        {
+            _size = 1;
+            while (_size < size)
+                _size <<= 1;
+            _buf = new uint8_t[_size];
+            _read = 0;
+            _write = 0;
+        }
 
-        err::check_raise(err::ERR_NOT_IMPL, "not support this function");
+        ~SpscRing()
+        {
+            delete[] _buf;
+        }
+
+        size_t capacity() { return _size; }
+
+        size_t readable() { return _write.load(std::memory_order_acquire) - _read.load(std::memory_order_relaxed); }
+
+        /**
+         * Push all data or nothing, called by producer only.
+         */
+        bool push(const void *data, size_t len)
+        {
+            size_t w = _write.load(std::memory_order_relaxed);
+            size_t r = _read.load(std::memory_order_acquire);
+            if (_size - (w - r) < len)
+                return false;
+            size_t pos = w & (_size - 1);
+            size_t first = len < _size - pos ? len : _size - pos;
+            memcpy(_buf + pos, data, first);
+            memcpy(_buf, (const uint8_t *)data + first, len - first);
+            _write.store(w + len, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Pop at most max bytes, called by consumer only.
+         */
+        size_t pop(void *data, size_t max)
+        {
+            size_t r = _read.load(std::memory_order_relaxed);
+            size_t w = _write.load(std::memory_order_acquire);
+            size_t len = w - r < max ? w - r : max;
+            size_t pos = r & (_size - 1);
+            size_t first = len < _size - pos ? len : _size - pos;
+            memcpy(data, _buf + pos, first);
+            memcpy((uint8_t *)data + first, _buf, len - first);
+            _read.store(r + len, std::memory_order_release);
+            return len;
+        }
+
+    private:
+        uint8_t *_buf;
+        size_t _size;
+        std::atomic<size_t> _read;
+        std::atomic<size_t> _write;
+    };
+
+    typedef struct {
+        snd_pcm_t *pcm;
+        SpscRing *ring;
+        std::thread *thread;
+        std::atomic<bool> running;
+        std::atomic<bool> idle;         // playback only, all queued data is written to pcm
+        std::atomic<uint64_t> xrun;
+        int frame_bytes;
+        int period_bytes;
+        int period_us;
+        int buffer_frames;
+        long file_offset;               // playback only, offset of pcm data in file
+    } alsa_stream_t;
+
+    typedef struct {
+        int file_size;  // pcm + 44
+        int channel;
+        int sample_rate;
+        int sample_bit;
+        int bitrate;
+        int data_size;  // size of pcm
+    } wav_header_t;
+
+    static int _create_wav_header(wav_header_t *header, uint8_t *data, size_t size)
+    {
+        if (size < 44) return -1;
+
+        int cnt = 0;
+        data[cnt ++] = 'R';
+        data[cnt ++] = 'I';
+        data[cnt ++] = 'F';
+        data[cnt ++] = 'F';
+
+        data[cnt ++] = (uint8_t)((header->file_size - 8) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->file_size - 8) >> 8) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->file_size - 8) >> 16) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->file_size - 8) >> 24) & 0xff);
+
+        data[cnt ++] = 'W';
+        data[cnt ++] = 'A';
+        data[cnt ++] = 'V';
+        data[cnt ++] = 'E';
+
+        data[cnt ++] = 'f';
+        data[cnt ++] = 'm';
+        data[cnt ++] = 't';
+        data[cnt ++] = ' ';
+
+        data[cnt ++] = 16;
+        data[cnt ++] = 0;
+        data[cnt ++] = 0;
+        data[cnt ++] = 0;
+
+        data[cnt ++] = 1;
+        data[cnt ++] = 0;
+
+        data[cnt ++] = (uint8_t)header->channel;
+        data[cnt ++] = 0;
+
+        data[cnt ++] = (uint8_t)((header->sample_rate) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->sample_rate) >> 8) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->sample_rate) >> 16) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->sample_rate) >> 24) & 0xff);
+
+        data[cnt ++] = (uint8_t)((header->bitrate) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->bitrate) >> 8) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->bitrate) >> 16) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->bitrate) >> 24) & 0xff);
+
+        data[cnt ++] = (uint8_t)(header->channel * header->sample_bit / 8);
+        data[cnt ++] = 0;
+
+        data[cnt ++] = (uint8_t)header->sample_bit;
+        data[cnt ++] = 0;
+
+        data[cnt ++] = 'd';
+        data[cnt ++] = 'a';
+        data[cnt ++] = 't';
+        data[cnt ++] = 'a';
+
+        data[cnt ++] = (uint8_t)((header->data_size) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->data_size) >> 8) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->data_size) >> 16) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->data_size) >> 24) & 0xff);
+
+        return 0;
+    }
+
+    static uint32_t _le_read(const uint8_t *data, int bytes)
+    {
+        uint32_t v = 0;
+        for (int i = bytes - 1; i >= 0; i --)
+            v = v << 8 | data[i];
+        return v;
+    }
+
+    /**
+     * Read wav header, skip chunks other than fmt and data, e.g. LIST.
+     * @return offset of pcm data, negative if failed
+     */
+    static int _read_wav_header(wav_header_t *header, FILE *file)
+    {
+        uint8_t data[16];
+        if (fread(data, 1, 12, file) != 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) {
+            log::error("RIFF or WAVE not found in wav header!\r\n");
+            return -1;
+        }
+        header->file_size = _le_read(data + 4, 4) + 8;
+        int offset = 12;
+        bool fmt_found = false;
+        while (fread(data, 1, 8, file) == 8) {
+            uint32_t chunk_size = _le_read(data + 4, 4);
+            offset += 8;
+            if (memcmp(data, "fmt ", 4) == 0) {
+                if (chunk_size < 16 || fread(data, 1, 16, file) != 16) {
+                    return -2;
+                }
+                if (_le_read(data, 2) != 1) {
+                    log::error("audio format is not pcm!\r\n");
+                    return -3;
+                }
+                header->channel = _le_read(data + 2, 2);
+                header->sample_rate = _le_read(data + 4, 4);
+                header->bitrate = _le_read(data + 8, 4);
+                header->sample_bit = _le_read(data + 14, 2);
+                fmt_found = true;
+                fseek(file, offset + chunk_size, SEEK_SET);
+            } else if (memcmp(data, "data", 4) == 0) {
+                header->data_size = chunk_size;
+                return fmt_found ? offset : -2;
+            } else {
+                fseek(file, chunk_size, SEEK_CUR);
+            }
+            offset += chunk_size;
+        }
+        log::error("data not found in wav file!\r\n");
+        return -4;
+    }
+
+    static snd_pcm_format_t _alsa_format_from_maix(audio::Format format) {
+        switch (format)
+        {
+        case audio::Format::FMT_S8: return SND_PCM_FORMAT_S8;
+        case audio::Format::FMT_U8: return SND_PCM_FORMAT_U8;
+        case audio::Format::FMT_S16_LE: return SND_PCM_FORMAT_S16_LE;
+        case audio::Format::FMT_S32_LE: return SND_PCM_FORMAT_S32_LE;
+        case audio::Format::FMT_S16_BE: return SND_PCM_FORMAT_S16_BE;
+        case audio::Format::FMT_S32_BE: return SND_PCM_FORMAT_S32_BE;
+        case audio::Format::FMT_U16_LE: return SND_PCM_FORMAT_U16_LE;
+        case audio::Format::FMT_U32_LE: return SND_PCM_FORMAT_U32_LE;
+        case audio::Format::FMT_U16_BE: return SND_PCM_FORMAT_U16_BE;
+        case audio::Format::FMT_U32_BE: return SND_PCM_FORMAT_U32_BE;
+        default: return SND_PCM_FORMAT_UNKNOWN;
+        }
+        return SND_PCM_FORMAT_UNKNOWN;
+    }
+
+    static int format_to_sample_bit(audio::Format format)
+    {
+        switch (format) {
+        case audio::Format::FMT_NONE: return 0;
+        case audio::Format::FMT_S8: return 8;
+        case audio::Format::FMT_S16_LE: return 16;
+        case audio::Format::FMT_S32_LE: return 32;
+        case audio::Format::FMT_S16_BE: return 16;
+        case audio::Format::FMT_S32_BE: return 32;
+        case audio::Format::FMT_U8: return 8;
+        case audio::Format::FMT_U16_LE: return 16;
+        case audio::Format::FMT_U32_LE: return 32;
+        case audio::Format::FMT_U16_BE: return 16;
+        case audio::Format::FMT_U32_BE: return 32;
+        default: return 0;
+        }
+        return 0;
+    }
+
+    static audio::Format wav_sample_bit_to_format(int sample_bit)
+    {
+        switch (sample_bit) {
+            case 8: return audio::Format::FMT_U8;
+            case 16: return audio::Format::FMT_S16_LE;
+            case 32: return audio::Format::FMT_S32_LE;
+            default: return audio::Format::FMT_NONE;
+        }
+
+        return audio::Format::FMT_NONE;
+    }
+
+    /**
+     * Open pcm in blocking mode, buffer is 4 periods.
+     * @param period_size frames of one period, 0 means 10ms, returns real period size
+     */
+    static int _alsa_open(snd_pcm_t **handle, const char *device, snd_pcm_stream_t stream, int *period_size, int *buffer_frames,
+                            snd_pcm_format_t format, unsigned int sample_rate, unsigned int channels)
+    {
+        int err = 0;
+        snd_pcm_hw_params_t *hw_params = NULL;
+        snd_pcm_sw_params_t *sw_params = NULL;
+        snd_pcm_uframes_t period_value = *period_size > 0 ? *period_size : sample_rate / 100;
+        snd_pcm_uframes_t buffer_value = period_value * 4;
+        unsigned int rate = sample_rate;
+
+        *handle = NULL;
+        if ((err = snd_pcm_open(handle, device, stream, 0)) < 0) {
+            log::error("Cannot open audio device %s (%s)\r\n", device, snd_strerror(err));
+            goto _exit;
+        }
+
+        if ((err = snd_pcm_hw_params_malloc(&hw_params)) < 0
+            || (err = snd_pcm_hw_params_any(*handle, hw_params)) < 0
+            || (err = snd_pcm_hw_params_set_access(*handle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0
+            || (err = snd_pcm_hw_params_set_format(*handle, hw_params, format)) < 0
+            || (err = snd_pcm_hw_params_set_channels(*handle, hw_params, channels)) < 0
+            || (err = snd_pcm_hw_params_set_rate_near(*handle, hw_params, &rate, 0)) < 0
+            || (err = snd_pcm_hw_params_set_period_size_near(*handle, hw_params, &period_value, 0)) < 0
+            || (err = snd_pcm_hw_params_set_buffer_size_near(*handle, hw_params, &buffer_value)) < 0
+            || (err = snd_pcm_hw_params(*handle, hw_params)) < 0) {
+            log::error("Can't set hardware parameters of %s (%s)\r\n", device, snd_strerror(err));
+            goto _exit;
+        }
+        if (rate != sample_rate) {
+            log::warn("%s not support sample rate %d, use %d\r\n", device, sample_rate, rate);
+        }
+        snd_pcm_hw_params_get_period_size(hw_params, &period_value, 0);
+        snd_pcm_hw_params_get_buffer_size(hw_params, &buffer_value);
+
+        // playback start after 2 periods queued, so the thread has one period time to write the next one
+        if ((err = snd_pcm_sw_params_malloc(&sw_params)) < 0
+            || (err = snd_pcm_sw_params_current(*handle, sw_params)) < 0
+            || (err = snd_pcm_sw_params_set_avail_min(*handle, sw_params, period_value)) < 0
+            || (err = snd_pcm_sw_params_set_start_threshold(*handle, sw_params, stream == SND_PCM_STREAM_PLAYBACK ? period_value * 2 : 1)) < 0
+            || (err = snd_pcm_sw_params(*handle, sw_params)) < 0) {
+            log::error("Can't set software parameters of %s (%s)\r\n", device, snd_strerror(err));
+            goto _exit;
+        }
+
+        if ((err = snd_pcm_prepare(*handle)) < 0) {
+            log::error("not perpare (%s)\r\n", snd_strerror(err));
+            goto _exit;
+        }
+
+        *period_size = (int)period_value;
+        *buffer_frames = (int)buffer_value;
+        snd_pcm_hw_params_free(hw_params);
+        snd_pcm_sw_params_free(sw_params);
+        return 0;
+    _exit:
+        if (hw_params) snd_pcm_hw_params_free(hw_params);
+        if (sw_params) snd_pcm_sw_params_free(sw_params);
+        if (*handle) snd_pcm_close(*handle);
+        *handle = NULL;
+        return err;
+    }
+
+    static void _set_realtime(std::thread *thread)
+    {
+        struct sched_param param;
+        param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10;
+        if (pthread_setschedparam(thread->native_handle(), SCHED_FIFO, &param) != 0) {
+            log::debug("set audio thread to SCHED_FIFO failed, need root or CAP_SYS_NICE, use normal priority\r\n");
+        }
+    }
+
+    static void _capture_loop(alsa_stream_t *s)
+    {
+        std::vector<uint8_t> buffer(s->period_bytes);
+        int period_size = s->period_bytes / s->frame_bytes;
+        while (s->running) {
+            snd_pcm_sframes_t len = snd_pcm_readi(s->pcm, buffer.data(), period_size);
+            if (len < 0) {
+                if (len == -EPIPE) {
+                    s->xrun ++;
+                }
+                if (snd_pcm_recover(s->pcm, (int)len, 1) < 0) {
+                    log::error("capture failed, %s\r\n", snd_strerror((int)len));
+                    time::sleep_ms(10);
+                }
+                continue;
+            }
+            // record() not called in time, drop this period
+            if (!s->ring->push(buffer.data(), len * s->frame_bytes)) {
+                s->xrun ++;
+            }
+        }
+    }
+
+    static void _playback_loop(alsa_stream_t *s)
+    {
+        std::vector<uint8_t> buffer(s->period_bytes);
+        bool writing = false;
+        while (s->running) {
+            if (s->ring->readable() == 0) {
+                if (writing) {
+                    // data less than start threshold is queued, start it
+                    if (snd_pcm_state(s->pcm) == SND_PCM_STATE_PREPARED) {
+                        snd_pcm_start(s->pcm);
+                    }
+                    writing = false;
+                    s->idle = true;
+                }
+                usleep(s->period_us / 4 > 1000 ? 1000 : s->period_us / 4);
+                continue;
+            }
+            if (!writing) {
+                // pcm underrun while there was nothing to play, not an xrun of stream
+                if (snd_pcm_state(s->pcm) == SND_PCM_STATE_XRUN) {
+                    snd_pcm_prepare(s->pcm);
+                }
+                writing = true;
+                s->idle = false;
+            }
+            size_t len = s->ring->pop(buffer.data(), buffer.size());
+            uint8_t *p = buffer.data();
+            snd_pcm_uframes_t frames = len / s->frame_bytes;
+            while (frames > 0 && s->running) {
+                snd_pcm_sframes_t n = snd_pcm_writei(s->pcm, p, frames);
+                if (n < 0) {
+                    if (n == -EPIPE) {
+                        s->xrun ++;
+                    }
+                    if (snd_pcm_recover(s->pcm, (int)n, 1) < 0) {
+                        log::error("playback failed, %s\r\n", snd_strerror((int)n));
+                        break;
+                    }
+                    continue;
+                }
+                p += n * s->frame_bytes;
+                frames -= n;
+            }
+        }
+        s->idle = true;
+    }
+
+    static alsa_stream_t *_stream_open(const std::string &device, snd_pcm_stream_t stream, int *period_size,
+                                        audio::Format format, int sample_rate, int channel, int ring_ms)
+    {
+        snd_pcm_format_t format_p = _alsa_format_from_maix(format);
+        err::check_bool_raise(format_p != SND_PCM_FORMAT_UNKNOWN, "audio format not support");
+        snd_pcm_t *handle = NULL;
+        int buffer_frames = 0;
+        if (0 > _alsa_open(&handle, device.empty() ? "default" : device.c_str(), stream, period_size, &buffer_frames, format_p, sample_rate, channel)) {
+            return NULL;
+        }
+        alsa_stream_t *s = new alsa_stream_t();
+        s->pcm = handle;
+        s->frame_bytes = snd_pcm_format_physical_width(format_p) / 8 * channel;
+        s->period_bytes = *period_size * s->frame_bytes;
+        s->period_us = (int)((uint64_t)*period_size * 1000000 / sample_rate);
+        s->buffer_frames = buffer_frames;
+        size_t ring_size = (size_t)sample_rate * ring_ms / 1000 * s->frame_bytes;
+        if (ring_size < (size_t)s->period_bytes * 8)
+            ring_size = (size_t)s->period_bytes * 8;
+        s->ring = new SpscRing(ring_size);
+        s->thread = NULL;
+        s->running = false;
+        s->idle = true;
+        s->xrun = 0;
+        s->file_offset = 0;
+        return s;
+    }
+
+    static void _stream_start(alsa_stream_t *s, void (*loop)(alsa_stream_t *))
+    {
+        if (s->thread)
+            return;
+        s->running = true;
+        s->thread = new std::thread(loop, s);
+        _set_realtime(s->thread);
+    }
+
+    static void _stream_close(alsa_stream_t *s, bool drain)
+    {
+        if (s->thread) {
+            s->running = false;
+            s->thread->join();
+            delete s->thread;
+            s->thread = NULL;
+        }
+        if (drain)
+            snd_pcm_drain(s->pcm);
+        else
+            snd_pcm_drop(s->pcm);
+        snd_pcm_close(s->pcm);
+        delete s->ring;
+        delete s;
+    }
+
+    /**
+     * Set and get volume of first simple mixer element with capture or playback volume, percentage.
+     */
+    static int _mixer_volume(const std::string &device, bool capture, int value)
+    {
+        snd_mixer_t *mixer = NULL;
+        int ret = -1;
+        std::string card = device.compare(0, 3, "hw:") == 0 ? device.substr(0, device.find(',')) : "default";
+        if (snd_mixer_open(&mixer, 0) < 0)
+            return -1;
+        if (snd_mixer_attach(mixer, card.c_str()) < 0 || snd_mixer_selem_register(mixer, NULL, NULL) < 0 || snd_mixer_load(mixer) < 0) {
+            snd_mixer_close(mixer);
+            return -1;
+        }
+        for (snd_mixer_elem_t *elem = snd_mixer_first_elem(mixer); elem; elem = snd_mixer_elem_next(elem)) {
+            long min, max, vol;
+            if (capture && snd_mixer_selem_has_capture_volume(elem)) {
+                snd_mixer_selem_get_capture_volume_range(elem, &min, &max);
+                if (value >= 0)
+                    snd_mixer_selem_set_capture_volume_all(elem, min + (max - min) * value / 100);
+                snd_mixer_selem_get_capture_volume(elem, SND_MIXER_SCHN_FRONT_LEFT, &vol);
+            } else if (!capture && snd_mixer_selem_has_playback_volume(elem)) {
+                snd_mixer_selem_get_playback_volume_range(elem, &min, &max);
+                if (value >= 0)
+                    snd_mixer_selem_set_playback_volume_all(elem, min + (max - min) * value / 100);
+                snd_mixer_selem_get_playback_volume(elem, SND_MIXER_SCHN_FRONT_LEFT, &vol);
+            } else {
+                continue;
+            }
+            ret = max > min ? (int)((vol - min) * 100 / (max - min)) : 0;
+            break;
+        }
+        snd_mixer_close(mixer);
+        return ret;
+    }
+
+    Recorder::Recorder(std::string path, int sample_rate, audio::Format format, int channel, int period_size, std::string device) {
+        _path = path;
+        _sample_rate = sample_rate;
+        _format = format;
+        _channel = channel;
+        _period_size = period_size;
+        _xrun_count = 0;
+        _file = NULL;
+        _buffer = NULL;
+        _buffer_size = 0;
+
+        if (path.size() > 0) {
+            if (fs::splitext(_path)[1] != ".wav"
+                && fs::splitext(_path)[1] != ".pcm") {
+                err::check_raise(err::ERR_RUNTIME, "Only files with the `.pcm` and `.wav` extensions are supported.");
+            }
+        }
+
+        // keep 1 second in ring buffer, capture thread start at the first record()
+        alsa_stream_t *s = _stream_open(device, SND_PCM_STREAM_CAPTURE, &_period_size, format, sample_rate, channel, 1000);
+        err::check_null_raise(s, "capture init failed");
+        _handle = s;
+        _buffer_size = s->period_bytes * 4;
+        _buffer = malloc(_buffer_size);
+        err::check_null_raise(_buffer, "record buffer init failed!");
     }
 
     Recorder::~Recorder() {
-        err::check_raise(err::ERR_NOT_IMPL, "not support this function");
+        finish();
+        if (_handle) {
+            _stream_close((alsa_stream_t *)_handle, false);
+            _handle = NULL;
+        }
+
+        if (_buffer) {
+            free(_buffer);
+            _buffer = NULL;
+            _buffer_size = 0;
+        }
     }
 
     int Recorder::volume(int value) {
-        (void)value;
-        err::check_raise(err::ERR_NOT_IMPL, "not support this function");
-        return 0;
+        return _mixer_volume(std::string(), true, value > 100 ? 100 : value);
+    }
+
+    uint64_t Recorder::xrun_count() {
+        alsa_stream_t *s = (alsa_stream_t *)_handle;
+        return s->xrun;
     }
 
     maix::Bytes *Recorder::record(int record_ms) {
-        (void)record_ms;
-        err::check_raise(err::ERR_NOT_IMPL, "not support this function");
-        return NULL;
+        alsa_stream_t *s = (alsa_stream_t *)_handle;
+        _stream_start(s, _capture_loop);
+
+        if (_file == NULL && _path.size() > 0) {
+            _file = fopen(_path.c_str(), "w+");
+            err::check_null_raise(_file, "Open file failed!");
+
+            if (fs::splitext(_path)[1] == ".wav") {
+                wav_header_t header = {
+                    .file_size = 44,
+                    .channel = _channel,
+                    .sample_rate = _sample_rate,
+                    .sample_bit = format_to_sample_bit(_format),
+                    .bitrate = _channel * _sample_rate * format_to_sample_bit(_format) / 8,
+                    .data_size = 0,
+                };
+
+                uint8_t buffer[44];
+                if (0 != _create_wav_header(&header, buffer, sizeof(buffer))) {
+                    err::check_raise(err::ERR_RUNTIME, "create wav failed!");
+                }
+
+                if (sizeof(buffer) != fwrite(buffer, 1, sizeof(buffer), _file)) {
+                    err::check_raise(err::ERR_RUNTIME, "write wav header failed!");
+                }
+            }
+        }
+
+        if (record_ms > 0) {
+            if (_path.size() <= 0) {
+                log::error("If you pass in the record_ms parameter, you must also set the correct path in audio::Audio()\r\n");
+                return new Bytes();
+            }
+
+            // count by samples instead of time, file always has record_ms audio
+            size_t total = (uint64_t)_sample_rate * record_ms / 1000 * s->frame_bytes;
+            size_t written = 0;
+            while (written < total && !app::need_exit()) {
+                size_t want = total - written < _buffer_size ? total - written : _buffer_size;
+                size_t len = s->ring->pop(_buffer, want);
+                if (len == 0) {
+                    usleep(s->period_us / 2);
+                    continue;
+                }
+                if (len != fwrite(_buffer, 1, len, _file)) {
+                    log::error("write record file failed\r\n");
+                    break;
+                }
+                written += len;
+            }
+            return new Bytes();
+        }
+
+        size_t len = s->ring->readable();
+        if (len == 0) {
+            return new Bytes();
+        }
+        Bytes *data = new Bytes(NULL, len);
+        len = s->ring->pop(data->data, len);
+        if (_file)
+            fwrite(data->data, 1, len, _file);
+        return data;
     }
 
     err::Err Recorder::finish() {
-        err::check_raise(err::ERR_NOT_IMPL, "not support this function");
-        return err::ERR_NOT_IMPL;
+        if (_file) {
+            if (fs::splitext(_path)[1] == ".wav") {
+                int file_size = ftell(_file);
+                int pcm_size = file_size - 44;
+                char buffer[4];
+                buffer[0] = (uint8_t)((file_size - 8) & 0xff);
+                buffer[1] = (uint8_t)(((file_size - 8) >> 8) & 0xff);
+                buffer[2] = (uint8_t)(((file_size - 8) >> 16) & 0xff);
+                buffer[3] = (uint8_t)(((file_size - 8) >> 24) & 0xff);
+
+                fseek(_file, 4, SEEK_SET);
+                if (sizeof(buffer) != fwrite(buffer, 1, sizeof(buffer), _file)) {
+                    err::check_raise(err::ERR_RUNTIME, "write wav file size failed!");
+                }
+
+                buffer[0] = (uint8_t)((pcm_size) & 0xff);
+                buffer[1] = (uint8_t)(((pcm_size) >> 8) & 0xff);
+                buffer[2] = (uint8_t)(((pcm_size) >> 16) & 0xff);
+                buffer[3] = (uint8_t)(((pcm_size) >> 24) & 0xff);
+                fseek(_file, 40, SEEK_SET);
+                if (sizeof(buffer) != fwrite(buffer, 1, sizeof(buffer), _file)) {
+                    err::check_raise(err::ERR_RUNTIME, "write wav data size failed!");
+                }
+            }
+
+            fflush(_file);
+            fclose(_file);
+            _file = NULL;
+        }
+
+        return err::ERR_NONE;
     }
 
+#if CONFIG_BUILD_WITH_MAIXPY
     maix::Bytes *Player::NoneBytes = new maix::Bytes();
+#else
+    maix::Bytes *Player::NoneBytes = NULL;
+#endif
+
+    Player::Player(std::string path, int sample_rate, audio::Format format, int channel, int period_size, std::string device) {
+        _path = path;
+        _sample_rate = sample_rate;
+        _format = format;
+        _channel = channel;
+        _period_size = period_size;
+        _xrun_count = 0;
+        _file = NULL;
+        _buffer = NULL;
+        _buffer_size = 0;
+        int data_offset = 0;
+
+        if (path.size() > 0) {
+            if (fs::splitext(_path)[1] != ".wav"
+                && fs::splitext(_path)[1] != ".pcm") {
+                err::check_raise(err::ERR_RUNTIME, "Only files with the `.pcm` and `.wav` extensions are supported.");
+            }
+
+            _file = fopen(_path.c_str(), "rb");
+            err::check_null_raise(_file, "Open file failed!");
+
+            if (fs::splitext(_path)[1] == ".wav") {
+                wav_header_t header = {0};
+                data_offset = _read_wav_header(&header, _file);
+                if (data_offset < 0) {
+                    err::check_raise(err::ERR_RUNTIME, "parse wav header failed!");
+                }
+
+                _sample_rate = header.sample_rate;
+                _channel = header.channel;
+                _format = wav_sample_bit_to_format(header.sample_bit);
+            }
+        }
 
-    Player::Player(std::string path, int sample_rate, audio::Format format, int channel) {
-        (void)path;
-        (void)sample_rate;
-        (void)format;
-        (void)channel;
-        err::check_raise(err::ERR_NOT_IMPL, "not support this function");
+        // queue about 8 periods, play() blocks when queue is full, keep latency low
+        alsa_stream_t *s = _stream_open(device, SND_PCM_STREAM_PLAYBACK, &_period_size, _format, _sample_rate, _channel, 0);
+        err::check_null_raise(s, "player init failed");
+        s->file_offset = data_offset;
+        _handle = s;
+        _buffer_size = s->period_bytes;
+        _buffer = malloc(_buffer_size);
+        err::check_null_raise(_buffer, "player buffer init failed!");
+        _stream_start(s, _playback_loop);
     }
 
     Player::~Player() {
-        err::check_raise(err::ERR_NOT_IMPL, "not support this function");
+        if (_handle) {
+            alsa_stream_t *s = (alsa_stream_t *)_handle;
+            // play queued data before close
+            uint64_t timeout = time::ticks_ms() + (uint64_t)s->ring->capacity() * 1000 / s->frame_bytes / _sample_rate + 1000;
+            while ((s->ring->readable() > 0 || !s->idle) && time::ticks_ms() < timeout) {
+                usleep(s->period_us / 2);
+            }
+            _stream_close(s, true);
+            _handle = NULL;
+        }
+
+        if (_file) {
+            fclose(_file);
+            _file = NULL;
+        }
+
+        if (_buffer) {
+            free(_buffer);
+            _buffer = NULL;
+            _buffer_size = 0;
+        }
     }
 
     int Player::volume(int value) {
-        (void)value;
-        err::check_raise(err::ERR_NOT_IMPL, "not support this function");
-        return 0;
+        return _mixer_volume(std::string(), false, value > 100 ? 100 : value);
+    }
+
+    uint64_t Player::xrun_count() {
+        alsa_stream_t *s = (alsa_stream_t *)_handle;
+        return s->xrun;
+    }
+
+    /**
+     * Queue data to playback thread, split to periods, wait when ring buffer is full.
+     */
+    static err::Err _player_queue(alsa_stream_t *s, const uint8_t *data, size_t len)
+    {
+        len -= len % s->frame_bytes;
+        while (len > 0) {
+            size_t n = len < (size_t)s->period_bytes ? len : s->period_bytes;
+            if (!s->ring->push(data, n)) {
+                if (app::need_exit())
+                    return err::ERR_CANCEL;
+                usleep(s->period_us / 2);
+                continue;
+            }
+            data += n;
+            len -= n;
+        }
+        return err::ERR_NONE;
     }
 
     err::Err Player::play(maix::Bytes *data) {
-        err::check_raise(err::ERR_NOT_IMPL, "not support this function");
-        return err::ERR_NOT_IMPL;
+        alsa_stream_t *s = (alsa_stream_t *)_handle;
+        err::Err ret = err::ERR_NONE;
+
+        if (data && data->data && data->size()) {
+            return _player_queue(s, data->data, data->data_len);
+        }
+
+        if (!_file) {
+            log::error("no data to play, and path is not set\r\n");
+            return err::ERR_ARGS;
+        }
+
+        fseek(_file, s->file_offset, SEEK_SET);
+        size_t read_len = 0;
+        while ((read_len = fread(_buffer, 1, _buffer_size, _file)) > 0) {
+            ret = _player_queue(s, (uint8_t *)_buffer, read_len);
+            if (ret != err::ERR_NONE)
+                return ret;
+        }
+
+        // block until file played
+        while ((s->ring->readable() > 0 || !s->idle) && !app::need_exit()) {
+            usleep(s->period_us / 2);
+        }
+        return ret;
     }
-} // namespace maix::audio
\ No newline at end of file
+} // namespace maix::audio
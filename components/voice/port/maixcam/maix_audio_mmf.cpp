@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add period size, device and xrun count, recover from xrun.
  */
 
 #include <stdint.h>
@@ -141,15 +142,16 @@ namespace maix::audio
     }
 
     static int _alsa_capture_init(  snd_pcm_t **handle, snd_pcm_hw_params_t **hw_params, int *period_size,
-                                    snd_pcm_format_t format, unsigned int sample_rate, unsigned int channels)
+                                    snd_pcm_format_t format, unsigned int sample_rate, unsigned int channels,
+                                    const char *device = "hw:0,0")
     {
         int err = 0;
 
         if (handle) *handle = NULL;
         if (hw_params) *hw_params = NULL;
 
-        if ((err = snd_pcm_open(handle, "hw:0,0", SND_PCM_STREAM_CAPTURE, SND_PCM_NONBLOCK)) < 0) {
-            printf("Cannot open audio device hw:0,0 (%s)\n", snd_strerror(err));
+        if ((err = snd_pcm_open(handle, device, SND_PCM_STREAM_CAPTURE, SND_PCM_NONBLOCK)) < 0) {
+            printf("Cannot open audio device %s (%s)\n", device, snd_strerror(err));
             goto _exit;
         }
 
@@ -183,6 +185,14 @@ namespace maix::audio
             goto _exit;
         }
 
+        if (period_size && *period_size > 0) {
+            snd_pcm_uframes_t period_frames = *period_size;
+            if ((err = snd_pcm_hw_params_set_period_size_near(*handle, *hw_params, &period_frames, 0)) < 0) {
+                printf("Can't set period size (%s)\n", snd_strerror(err));
+                goto _exit;
+            }
+        }
+
         if ((err = snd_pcm_hw_params(*handle, *hw_params)) < 0) {
             printf("Can't set hardware parameters (%s)\n", snd_strerror(err));
             goto _exit;
@@ -251,16 +261,30 @@ namespace maix::audio
         return len * frame_byte * channels;
     }
 
+    /**
+     * Prepare pcm again if overrun or underrun happened, otherwise the pcm stays in XRUN state.
+     * @return true if xrun recovered
+     */
+    static bool _alsa_recover_xrun(snd_pcm_t *handle, int len, uint64_t *xrun_count)
+    {
+        if (len != -EPIPE) {
+            return false;
+        }
+        if (xrun_count) (*xrun_count) ++;
+        return snd_pcm_prepare(handle) == 0;
+    }
+
     static int _alsa_player_init(  snd_pcm_t **handle, snd_pcm_hw_params_t **hw_params, int *period_size,
-                                    snd_pcm_format_t format, unsigned int sample_rate, unsigned int channels)
+                                    snd_pcm_format_t format, unsigned int sample_rate, unsigned int channels,
+                                    const char *device = "hw:1,0")
     {
         int err = 0;
 
         if (handle) *handle = NULL;
         if (hw_params) *hw_params = NULL;
 
-        if ((err = snd_pcm_open(handle, "hw:1,0", SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK)) < 0) {
-            printf("Cannot open audio device hw:1,0 (%s)\n", snd_strerror(err));
+        if ((err = snd_pcm_open(handle, device, SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK)) < 0) {
+            printf("Cannot open audio device %s (%s)\n", device, snd_strerror(err));
             goto _exit;
         }
 
@@ -294,6 +318,14 @@ namespace maix::audio
             goto _exit;
         }
 
+        if (period_size && *period_size > 0) {
+            snd_pcm_uframes_t period_frames = *period_size;
+            if ((err = snd_pcm_hw_params_set_period_size_near(*handle, *hw_params, &period_frames, 0)) < 0) {
+                printf("Can't set period size (%s)\n", snd_strerror(err));
+                goto _exit;
+            }
+        }
+
         if ((err = snd_pcm_hw_params(*handle, *hw_params)) < 0) {
             printf("Can't set hardware parameters (%s)\n", snd_strerror(err));
             goto _exit;
@@ -359,7 +391,7 @@ namespace maix::audio
             char buffer[1024];
             snd_pcm_t *handle;
             snd_pcm_hw_params_t *hwparams;
-            int period_size;
+            int period_size = 0;
             _alsa_capture_init(&handle, &hwparams, &period_size, SND_PCM_FORMAT_S16_LE, 48000, 1);
             _alsa_capture_pop(handle, SND_PCM_FORMAT_S16_LE, 1, period_size, buffer, sizeof(buffer));
             _alsa_capture_deinit(handle);
@@ -399,11 +431,16 @@ namespace maix::audio
         return SND_PCM_FORMAT_UNKNOWN;
     }
 
-    Recorder::Recorder(std::string path, int sample_rate, audio::Format format, int channel) {
+    Recorder::Recorder(std::string path, int sample_rate, audio::Format format, int channel, int period_size, std::string device) {
         _path = path;
         _sample_rate = sample_rate;
         _format = format;
         _channel = channel;
+        _period_size = period_size;
+        _xrun_count = 0;
+        if (device.empty()) {
+            device = "hw:0,0";
+        }
 
         if (path.size() > 0) {
             if (fs::splitext(_path)[1] != ".wav"
@@ -417,7 +454,7 @@ namespace maix::audio
         snd_pcm_hw_params_t *hwparams;
         snd_pcm_format_t format_p = _alsa_format_from_maix(format);
         _fix_segmentation_fault_bug();
-        err::check_bool_raise(0 <= _alsa_capture_init(&handle, &hwparams, &_period_size, format_p, sample_rate, channel), "capture init failed");
+        err::check_bool_raise(0 <= _alsa_capture_init(&handle, &hwparams, &_period_size, format_p, sample_rate, channel, device.c_str()), "capture init failed");
         _handle = handle;
         snd_pcm_uframes_t buffer_size = 0;
         _buffer = _alsa_prepare_buffer(format_p, channel, _period_size, &buffer_size);
@@ -552,6 +589,7 @@ namespace maix::audio
                             fwrite(buffer, 1, len, _file);
                     }
                 }
+                _alsa_recover_xrun(handle, len, &_xrun_count);
                 time::sleep_ms(10);
             }
 
@@ -580,6 +618,7 @@ namespace maix::audio
                         fwrite(buffer, len, 1, _file);
                 }
             }
+            _alsa_recover_xrun(handle, len, &_xrun_count);
 
             if (valid_len > 0) {
                 return new Bytes(&data[0], valid_len, true, true);
@@ -590,6 +629,10 @@ namespace maix::audio
         return new Bytes();
     }
 
+    uint64_t Recorder::xrun_count() {
+        return _xrun_count;
+    }
+
     err::Err Recorder::finish() {
         if (_file) {
             if (fs::splitext(_path)[1] == ".wav") {
@@ -628,13 +671,17 @@ namespace maix::audio
 #else
     maix::Bytes *Player::NoneBytes = NULL;
 #endif
-    Player::Player(std::string path, int sample_rate, audio::Format format, int channel) {
+    Player::Player(std::string path, int sample_rate, audio::Format format, int channel, int period_size, std::string device) {
         _path = path;
         _sample_rate = sample_rate;
         _format = format;
         _channel = channel;
-        _period_size = 0;
+        _period_size = period_size;
+        _xrun_count = 0;
         _file = NULL;
+        if (device.empty()) {
+            device = "hw:1,0";
+        }
 
         if (path.size() > 0) {
             if (fs::splitext(_path)[1] != ".wav"
@@ -670,7 +717,7 @@ namespace maix::audio
         snd_pcm_hw_params_t *hwparams;
         snd_pcm_format_t format_p = _alsa_format_from_maix(format);
         _fix_segmentation_fault_bug();
-        err::check_bool_raise(0 <= _alsa_player_init(&handle, &hwparams, &_period_size, format_p, sample_rate, channel), "capture init failed");
+        err::check_bool_raise(0 <= _alsa_player_init(&handle, &hwparams, &_period_size, format_p, sample_rate, channel, device.c_str()), "player init failed");
         _handle = handle;
         snd_pcm_uframes_t buffer_size = 0;
         _buffer = _alsa_prepare_buffer(format_p, channel, _period_size, &buffer_size);
@@ -701,6 +748,10 @@ namespace maix::audio
         return -1;
     }
 
+    uint64_t Player::xrun_count() {
+        return _xrun_count;
+    }
+
     err::Err Player::play(maix::Bytes *data) {
         err::Err ret = err::ERR_NONE;
         snd_pcm_t *handle = (snd_pcm_t *)_handle;
@@ -723,6 +774,9 @@ namespace maix::audio
             int read_len = 0;
             while ((read_len = fread(buffer, 1, buffer_size, _file)) > 0) {
                 len = _alsa_player_push(handle, format, channel, buffer, read_len);
+                if (_alsa_recover_xrun(handle, len, &_xrun_count)) {
+                    len = _alsa_player_push(handle, format, channel, buffer, read_len);
+                }
                 if (len < 0) {
                     log::error("play failed, %s\r\n", snd_strerror(len));
                     ret = err::ERR_RUNTIME;
@@ -735,6 +789,9 @@ namespace maix::audio
             }
         } else {
             len = _alsa_player_push(handle, format, channel, data->data, data->data_len);
+            if (_alsa_recover_xrun(handle, len, &_xrun_count)) {
+                len = _alsa_player_push(handle, format, channel, data->data, data->data_len);
+            }
             if (len < 0) {
                 log::error("play failed, %s\r\n", snd_strerror(len));
                 ret = err::ERR_RUNTIME;
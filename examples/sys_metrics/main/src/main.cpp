@@ -0,0 +1,48 @@
+#include "maix_basic.hpp"
+#include "main.h"
+
+using namespace maix;
+
+/**
+ * Sample system metrics in background with sys::MetricsSampler, print the latest sample.
+ */
+
+int _main(int argc, char *argv[])
+{
+    int interval_ms = argc > 1 ? atoi(argv[1]) : 500;
+    int seconds = argc > 2 ? atoi(argv[2]) : 10;
+    sys::MetricsSampler sampler(interval_ms, 60);
+    sampler.start();
+    uint64_t end = time::ticks_ms() + seconds * 1000;
+    uint64_t last = 0;
+    while (time::ticks_ms() < end && !app::need_exit())
+    {
+        sys::Metrics m = sampler.latest();
+        if (m.timestamp != last)
+        {
+            last = m.timestamp;
+            std::string cores;
+            for (float v : m.cpu_cores())
+                cores += std::to_string((int)v) + "% ";
+            log::info("cpu %5.1f%% [%s], mem %s / %s, temp %.1f, rss %s, threads %d",
+                      m.cpu, cores.c_str(), sys::bytes_to_human(m.mem_used).c_str(), sys::bytes_to_human(m.mem_total).c_str(),
+                      m.temp, sys::bytes_to_human(m.rss).c_str(), m.threads);
+        }
+        time::sleep_ms(10);
+    }
+    log::info("%d samples in history", (int)sampler.history().size());
+    sampler.stop();
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch SIGINT signal(e.g. Ctrl + C), and set exit flag to true.
+    signal(SIGINT, [](int sig)
+           { app::set_exit_flag(true); });
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,130 @@
+#include "maix_basic.hpp"
+#include "maix_video.hpp"
+#include "maix_video_mp4.hpp"
+#include "main.h"
+
+using namespace maix;
+
+/**
+ * Mux H.264/H.265 Annex-B stream file to mp4 with video::MP4Muxer.
+ * If no input file, encode test images with video::Encoder to get the stream.
+ */
+
+static bool read_file(const std::string &path, std::vector<uint8_t> &data)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+    fseek(f, 0, fs::SEEK_END);
+    data.resize(ftell(f));
+    fseek(f, 0, fs::SEEK_SET);
+    bool ok = fread(data.data(), 1, data.size(), f) == data.size();
+    fclose(f);
+    return ok;
+}
+
+/**
+ * split Annex-B stream to access units, new access unit starts at AUD, parameter sets, SEI or first slice after slice.
+ * @return start offsets of access units
+ */
+static std::vector<size_t> split_access_units(const std::vector<uint8_t> &s, bool h265)
+{
+    std::vector<size_t> aus;
+    bool has_vcl = false;
+    size_t i = 0, n = s.size();
+    while (i + 5 < n)
+    {
+        if (!(s[i] == 0 && s[i + 1] == 0 && s[i + 2] == 1))
+        {
+            ++i;
+            continue;
+        }
+        size_t sc = (i > 0 && s[i - 1] == 0) ? i - 1 : i;
+        size_t nal = i + 3;
+        int type = h265 ? s[nal] >> 1 & 0x3F : s[nal] & 0x1F;
+        bool vcl = h265 ? type < 32 : (type >= 1 && type <= 5);
+        bool first_slice = vcl && (s[nal + (h265 ? 2 : 1)] & 0x80);
+        bool prefix = h265 ? ((type >= 32 && type <= 35) || type == 39) : (type >= 6 && type <= 9);
+        if (aus.empty() || (has_vcl && (prefix || first_slice)))
+        {
+            aus.push_back(sc);
+            has_vcl = false;
+        }
+        if (vcl)
+            has_vcl = true;
+        i = nal;
+    }
+    return aus;
+}
+
+static void encode_test_stream(std::vector<uint8_t> &stream, bool h265, int w, int h, int fps, int frames)
+{
+    video::Encoder e(w, h, image::FMT_YVU420SP, h265 ? video::VIDEO_H265_CBR : video::VIDEO_H264_CBR, fps, fps, 2000 * 1000);
+    image::Image img(w, h, image::FMT_YVU420SP);
+    uint8_t *p = (uint8_t *)img.data();
+    for (int i = 0; i < frames && !app::need_exit(); ++i)
+    {
+        for (int k = 0; k < w * h; ++k)
+            p[k] = (uint8_t)(k % w + k / w + i * 4);
+        memset(p + w * h, 128, w * h / 2);
+        video::Frame *frame = e.encode(&img);
+        uint8_t *data = frame->data();
+        stream.insert(stream.end(), data, data + frame->size());
+        delete frame;
+    }
+}
+
+int _main(int argc, char *argv[])
+{
+    std::string help = "Usage: " + std::string(argv[0]) + " [input.h264|input.h265 output.mp4 fps fragment_ms]";
+    std::string input = argc > 1 ? argv[1] : "";
+    std::string output = argc > 2 ? argv[2] : "/tmp/video_mp4_muxer.mp4";
+    int fps = argc > 3 ? atoi(argv[3]) : 30;
+    int fragment_ms = argc > 4 ? atoi(argv[4]) : 1000;
+    bool h265 = input.size() > 5 && (input.substr(input.size() - 5) == ".h265" || input.substr(input.size() - 5) == ".hevc");
+    int width = 640, height = 480;
+
+    std::vector<uint8_t> stream;
+    if (input.empty())
+    {
+        log::info(help.c_str());
+        log::info("no input, encode test stream");
+        encode_test_stream(stream, h265, width, height, fps, fps * 10);
+    }
+    else if (!read_file(input, stream))
+    {
+        log::error("read %s failed", input.c_str());
+        return -1;
+    }
+    std::vector<size_t> aus = split_access_units(stream, h265);
+    aus.push_back(stream.size());
+
+    // width and height only used by mp4 header, player use the size in SPS
+    video::MP4Muxer muxer(output, h265 ? video::VIDEO_H265_CBR : video::VIDEO_H264_CBR, width, height, 1000, fps, fragment_ms);
+    for (size_t i = 0; i + 1 < aus.size() && !app::need_exit(); ++i)
+    {
+        uint64_t pts = i * 1000 / fps;
+        err::Err e = muxer.write(stream.data() + aus[i], aus[i + 1] - aus[i], pts, pts);
+        if (e != err::ERR_NONE && e != err::ERR_NOT_READY)
+        {
+            log::error("mux frame %d failed: %d", (int)i, e);
+            return -1;
+        }
+    }
+    muxer.finish();
+    log::info("MP4Muxer: %d frames, %d ms, %d bytes -> %s",
+              muxer.frame_count(), (int)muxer.duration(), (int)muxer.size(), output.c_str());
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch SIGINT signal(e.g. Ctrl + C), and set exit flag to true.
+    signal(SIGINT, [](int sig)
+           { app::set_exit_flag(true); });
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
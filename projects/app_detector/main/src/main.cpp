@@ -40,34 +40,41 @@ int _main(int argc, char *argv[])
     camera::Camera cam = camera::Camera(input_size.width(), input_size.height(), detector.input_format());
     log::info("open camera success");
     display::Display disp = display::Display();
-    uint64_t t, t2, t3, t_show, t_all = 0;
-    while (!app::need_exit())
-    {
-        ts.read(ts_x, ts_y, ts_pressed);
-        if (ts_pressed && ts_x < 64 && ts_y < 40)
-        {
-            break;
-        }
-        t = time::ticks_ms();
-        maix::image::Image *img = cam.read();
-        err::check_null_raise(img, "read camera failed");
-        t2 = time::ticks_ms();
-        std::vector<nn::Object> *result = detector.detect(*img, conf_threshold, iou_threshold);
-        t3 = time::ticks_ms();
+
+    // camera, detect and show run on their own threads, so they overlap
+    pipeline::Pipeline p;
+    p.set_source("cam", pipeline::camera_source(cam));
+    p.add_stage("detect", [&](pipeline::Frame &frame) {
+        frame.set_result(detector.detect(*frame.img, conf_threshold, iou_threshold));
+        return err::ERR_NONE;
+    });
+    p.add_stage("show", [&](pipeline::Frame &frame) {
+        image::Image *img = frame.img;
+        std::vector<nn::Object> *result = frame.result<std::vector<nn::Object>>();
         for (auto &r : *result)
         {
             img->draw_rect(r.x, r.y, r.w, r.h, maix::image::Color::from_rgb(255, 0, 0));
             img->draw_string(r.x, r.y, detector.labels[r.class_id], maix::image::Color::from_rgb(255, 0, 0));
         }
         img->draw_image(0, 0, *ret_img);
-        snprintf(tmp_chars, sizeof(tmp_chars), "All: %ldms, fps: %ld\ncam: %ldms, detect: %ldms, show: %ldms", t_all, 1000 / t_all, t2 - t, t3 - t2, t_show);
+        std::vector<pipeline::StageStats> stats = p.stats();
+        snprintf(tmp_chars, sizeof(tmp_chars), "All: %.1fms, fps: %.1f\ncam: %.1fms, detect: %.1fms, show: %.1fms",
+                 p.latency_ms(), p.fps(), stats[0].latency_ms, stats[1].latency_ms, stats[2].latency_ms);
         img->draw_string(2, img->height() - 40, tmp_chars, image::COLOR_RED);
-        disp.show(*img);
-        t_show = time::ticks_ms() - t3;
-        t_all = time::ticks_ms() - t;
-        delete result;
-        delete img;
+        return disp.show(*img);
+    });
+    e = p.start();
+    err::check_raise(e, "start pipeline failed");
+    while (!app::need_exit())
+    {
+        ts.read(ts_x, ts_y, ts_pressed);
+        if (ts_pressed && ts_x < 64 && ts_y < 40)
+        {
+            break;
+        }
+        time::sleep_ms(20);
     }
+    p.stop();
     log::info("Program exit");
 
     return ret;
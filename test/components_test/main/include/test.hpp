@@ -0,0 +1,98 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Create this file.
+ */
+
+#pragma once
+
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include <functional>
+#include <string>
+
+namespace maix::test
+{
+    /**
+     * Failed checks count of all test suites
+     */
+    extern int fails;
+
+    /**
+     * Run benchmarks after checks, set by -b argument
+     */
+    extern bool bench;
+
+    /**
+     * Get value of name=value argument
+     * @param name argument name
+     * @param default_value returned if argument not set
+     * @return argument value
+     */
+    std::string arg(const std::string &name, const std::string &default_value = "");
+
+    /**
+     * Get int value of name=value argument
+     * @param name argument name
+     * @param default_value returned if argument not set
+     * @return argument value
+     */
+    int arg_int(const std::string &name, int default_value);
+
+    /**
+     * Average time of func in ms, func is called once more before timing to warm up, e.g. create pool and buffers
+     * @param loop run times
+     * @param func function to time
+     * @return average time in ms
+     */
+    double time_ms(int loop, const std::function<void()> &func);
+
+    /**
+     * Fill image data with a pattern not repeat in short range
+     * @param img image to fill
+     * @param seed pattern seed, different seed get different pattern
+     */
+    void fill_pattern(image::Image &img, int seed);
+
+    /**
+     * Max difference of bytes of two images with the same data size
+     */
+    int max_diff(image::Image &a, image::Image &b);
+}
+
+/**
+ * Check condition, print and count failure but continue test.
+ * Use printf but not log, log output may be redirected by log test.
+ */
+#define CHECK(cond)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            printf("-- [E] check failed, %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            ++maix::test::fails;                                                 \
+        }                                                                        \
+    } while (0)
+
+/**
+ * Test suites, one per source file in src dir
+ */
+void test_audio_alsa();
+void test_camera_yuyv_convert();
+void test_comm_socket();
+void test_image_cache();
+void test_image_find_blobs();
+void test_image_preprocess();
+void test_image_yuv_resize();
+void test_log_async();
+void test_nn_yolov8();
+void test_overlay();
+void test_pipeline();
+void test_protocol();
+void test_protocol_decode();
+void test_rtsp_server();
+void test_sys_metrics();
+void test_tensor_ops();
+void test_text();
+void test_thread_pool();
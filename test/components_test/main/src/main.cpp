@@ -0,0 +1,147 @@
+
+#include "maix_basic.hpp"
+#include "main.h"
+#include "test.hpp"
+#include <algorithm>
+#include <map>
+
+using namespace maix;
+
+/**
+ * Correctness checks of components, and benchmarks with -b.
+ * Usage: components_test [-b] [name=value ...] [suite ...]
+ */
+
+namespace maix::test
+{
+    int fails = 0;
+    bool bench = false;
+    static std::map<std::string, std::string> _args;
+
+    std::string arg(const std::string &name, const std::string &default_value)
+    {
+        auto it = _args.find(name);
+        return it == _args.end() ? default_value : it->second;
+    }
+
+    int arg_int(const std::string &name, int default_value)
+    {
+        auto it = _args.find(name);
+        return it == _args.end() ? default_value : atoi(it->second.c_str());
+    }
+
+    double time_ms(int loop, const std::function<void()> &func)
+    {
+        func();
+        uint64_t t = time::ticks_us();
+        for (int i = 0; i < loop; ++i)
+            func();
+        return (time::ticks_us() - t) / 1000.0 / loop;
+    }
+
+    void fill_pattern(image::Image &img, int seed)
+    {
+        uint8_t *p = (uint8_t *)img.data();
+        for (int i = 0; i < img.data_size(); ++i)
+            p[i] = (uint8_t)(i * 7 + seed + i / 97);
+    }
+
+    int max_diff(image::Image &a, image::Image &b)
+    {
+        uint8_t *pa = (uint8_t *)a.data();
+        uint8_t *pb = (uint8_t *)b.data();
+        int diff = 0;
+        for (int i = 0; i < a.data_size(); ++i)
+            diff = std::max(diff, abs(pa[i] - pb[i]));
+        return diff;
+    }
+}
+
+static const std::pair<const char *, void (*)()> suites[] = {
+    {"thread_pool", test_thread_pool},
+    {"tensor_ops", test_tensor_ops},
+    {"log_async", test_log_async},
+    {"sys_metrics", test_sys_metrics},
+    {"image_cache", test_image_cache},
+    {"image_find_blobs", test_image_find_blobs},
+    {"image_yuv_resize", test_image_yuv_resize},
+    {"image_preprocess", test_image_preprocess},
+    {"camera_yuyv_convert", test_camera_yuyv_convert},
+    {"overlay", test_overlay},
+    {"text", test_text},
+    {"pipeline", test_pipeline},
+    {"nn_yolov8", test_nn_yolov8},
+    {"protocol", test_protocol},
+    {"protocol_decode", test_protocol_decode},
+    {"comm_socket", test_comm_socket},
+    {"rtsp_server", test_rtsp_server},
+    {"audio_alsa", test_audio_alsa},
+};
+
+int _main(int argc, char *argv[])
+{
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        size_t pos = a.find('=');
+        if (a == "-b")
+            test::bench = true;
+        else if (a == "-h" || a == "--help")
+        {
+            log::info("Usage: %s [-b] [name=value ...] [suite ...]", argv[0]);
+            log::info("    -b: run benchmarks after checks");
+            log::info("    name=value: suite arguments, see README.md");
+            std::string all;
+            for (auto &s : suites)
+                all += std::string(" ") + s.first;
+            log::info("    suites:%s", all.c_str());
+            return 0;
+        }
+        else if (pos != std::string::npos)
+            test::_args[a.substr(0, pos)] = a.substr(pos + 1);
+        else
+            names.push_back(a);
+    }
+    for (auto &name : names)
+    {
+        bool found = false;
+        for (auto &s : suites)
+            found = found || name == s.first;
+        if (!found)
+        {
+            log::error("no suite %s", name.c_str());
+            return -1;
+        }
+    }
+
+    std::vector<std::string> failed;
+    for (auto &s : suites)
+    {
+        if (app::need_exit())
+            break;
+        if (!names.empty() && std::find(names.begin(), names.end(), s.first) == names.end())
+            continue;
+        log::info("==== %s", s.first);
+        int fails = test::fails;
+        s.second();
+        if (test::fails != fails)
+            failed.push_back(s.first);
+    }
+    for (auto &name : failed)
+        log::error("suite %s failed", name.c_str());
+    log::info("test %s, %d checks failed", test::fails ? "FAIL" : "PASS", test::fails);
+    return test::fails ? -1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch SIGINT signal(e.g. Ctrl + C), and set exit flag to true.
+    signal(SIGINT, [](int sig)
+           { app::set_exit_flag(true); });
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,174 @@
+#include "maix_basic.hpp"
+#include "maix_audio.hpp"
+#include "test.hpp"
+#include <math.h>
+#include <algorithm>
+
+using namespace maix;
+
+/**
+ * Test audio::Recorder and audio::Player with ALSA devices that need no sound card,
+ * capture from "null" plugin, playback to "file" plugin, then check WAV file and played data.
+ * If capture and playback devices are loopback(snd-aloop), measure round trip latency of different period sizes.
+ */
+
+static const char *wav_path = "/tmp/components_test_audio.wav";
+static const char *raw_path = "/tmp/components_test_audio_out.raw";
+
+static uint32_t read_le32(const uint8_t *p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static std::vector<int16_t> make_sine(int sample_rate, int ms, int freq)
+{
+    std::vector<int16_t> pcm(sample_rate * ms / 1000);
+    for (size_t i = 0; i < pcm.size(); ++i)
+        pcm[i] = (int16_t)(10000 * sin(2 * M_PI * freq * i / sample_rate));
+    return pcm;
+}
+
+static void test_record(const std::string &device, int period_size)
+{
+    const int sample_rate = 16000;
+    {
+        audio::Recorder r(wav_path, sample_rate, audio::Format::FMT_S16_LE, 1, period_size, device);
+        log::info("recorder %s, period size %d", device.c_str(), r.period_size());
+        CHECK(period_size <= 0 || r.period_size() == period_size);
+        uint64_t t = time::ticks_ms();
+        delete r.record(300);
+        log::info("record 300 ms to wav cost %d ms", (int)(time::ticks_ms() - t));
+
+        // capture thread keep running, nonblock record get data captured since last call
+        time::sleep_ms(100);
+        Bytes *data = r.record();
+        log::info("record() after 100 ms get %d bytes, xrun %d", (int)data->data_len, (int)r.xrun_count());
+        CHECK(data->data_len > 0 && data->data_len % 2 == 0);
+        int extra = data->data_len;
+        delete data;
+        CHECK(r.finish() == err::ERR_NONE);
+
+        FILE *f = fopen(wav_path, "rb");
+        CHECK(f != NULL);
+        if (!f)
+            return;
+        uint8_t header[44];
+        CHECK(fread(header, 1, 44, f) == 44);
+        fseek(f, 0, fs::SEEK_END);
+        int size = ftell(f);
+        fclose(f);
+        int pcm_size = sample_rate * 300 / 1000 * 2 + extra;
+        CHECK(size == 44 + pcm_size);
+        CHECK(memcmp(header, "RIFF", 4) == 0 && read_le32(header + 4) == (uint32_t)size - 8);
+        CHECK(read_le32(header + 24) == (uint32_t)sample_rate && read_le32(header + 40) == (uint32_t)pcm_size);
+    }
+}
+
+static void test_play(const std::string &device, int period_size)
+{
+    const int sample_rate = 16000;
+    std::vector<int16_t> pcm = make_sine(sample_rate, 500, 440);
+    remove(raw_path);
+    {
+        audio::Player p("", sample_rate, audio::Format::FMT_S16_LE, 1, period_size, device);
+        log::info("player %s, period size %d", device.c_str(), p.period_size());
+        Bytes data((uint8_t *)pcm.data(), pcm.size() * 2, false, false);
+        uint64_t t = time::ticks_ms();
+        CHECK(p.play(&data) == err::ERR_NONE);
+        log::info("queue 500 ms cost %d ms, xrun %d", (int)(time::ticks_ms() - t), (int)p.xrun_count());
+    }
+    // destructor wait all data played
+    if (device.find("file:") != 0)
+        return;
+    FILE *f = fopen(raw_path, "rb");
+    CHECK(f != NULL);
+    if (!f)
+        return;
+    std::vector<int16_t> out(pcm.size());
+    size_t n = fread(out.data(), 2, out.size(), f);
+    fclose(f);
+    CHECK(n == pcm.size() && memcmp(out.data(), pcm.data(), pcm.size() * 2) == 0);
+}
+
+/**
+ * Play an impulse and find it in captured data, latency = time of play() call to record() get it.
+ */
+static void bench_latency(const std::string &capture, const std::string &playback, int period_size)
+{
+    const int sample_rate = 48000;
+    audio::Recorder r("", sample_rate, audio::Format::FMT_S16_LE, 1, period_size, capture);
+    audio::Player p("", sample_rate, audio::Format::FMT_S16_LE, 1, period_size, playback);
+    std::vector<int16_t> silence(r.period_size(), 0);
+    std::vector<int16_t> impulse(r.period_size(), 20000);
+    Bytes silence_bytes((uint8_t *)silence.data(), silence.size() * 2, false, false);
+    Bytes impulse_bytes((uint8_t *)impulse.data(), impulse.size() * 2, false, false);
+    std::vector<int> latency;
+    uint64_t period_us = (uint64_t)r.period_size() * 1000000 / sample_rate;
+    // feed playback one period per period time, like a real time source
+    uint64_t next_feed = time::ticks_us();
+    auto feed = [&](Bytes *data) {
+        p.play(data);
+        next_feed += period_us;
+    };
+    for (int k = 0; k < 4; ++k)
+        feed(&silence_bytes);
+    delete r.record();
+    for (int i = 0; i < 20 && !app::need_exit(); ++i)
+    {
+        while (time::ticks_us() < next_feed)
+            time::sleep_us(200);
+        delete r.record();
+        uint64_t t = time::ticks_us();
+        feed(&impulse_bytes);
+        bool found = false;
+        while (!found && time::ticks_us() - t < 1000000)
+        {
+            if (time::ticks_us() >= next_feed)
+                feed(&silence_bytes);
+            Bytes *data = r.record();
+            int16_t *s = (int16_t *)data->data;
+            for (size_t k = 0; k < data->data_len / 2; ++k)
+            {
+                if (s[k] > 10000)
+                {
+                    found = true;
+                    break;
+                }
+            }
+            delete data;
+            if (!found)
+                time::sleep_us(200);
+        }
+        if (found)
+            latency.push_back((int)(time::ticks_us() - t));
+    }
+    std::sort(latency.begin(), latency.end());
+    if (latency.empty())
+    {
+        log::error("period %d: impulse not found, check loopback devices", period_size);
+        ++test::fails;
+        return;
+    }
+    log::info("period %d(%.1f ms): latency min %.2f ms, p50 %.2f ms, max %.2f ms, record xrun %d, play xrun %d",
+              r.period_size(), r.period_size() * 1000.0 / sample_rate, latency[0] / 1000.0, latency[latency.size() / 2] / 1000.0,
+              latency.back() / 1000.0, (int)r.xrun_count(), (int)p.xrun_count());
+}
+
+void test_audio_alsa()
+{
+    std::string capture = test::arg("capture", "null");
+    std::string playback = test::arg("playback", std::string("file:'") + raw_path + "',raw");
+    int period_size = test::arg_int("period_size", 0);
+    test_record(capture, period_size);
+    test_play(playback, period_size);
+    if (test::bench && capture.find("Loopback") != std::string::npos && playback.find("Loopback") != std::string::npos)
+    {
+        int periods[] = {64, 128, 256, 480, 960};
+        for (int period : periods)
+        {
+            if (app::need_exit())
+                break;
+            bench_latency(capture, playback, period);
+        }
+    }
+}
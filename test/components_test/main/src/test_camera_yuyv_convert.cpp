@@ -0,0 +1,115 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_camera_v4l2_convert.hpp"
+#include "test.hpp"
+
+using namespace maix;
+
+/**
+ * Test SIMD YUYV convert kernels of V4L2 camera give the same output as the scalar kernels,
+ * and print Mpixel/s of scalar and SIMD(SSSE3 on x86, NEON on ARM) kernels for every output format.
+ */
+
+static const image::Format formats[] = {image::FMT_RGB888, image::FMT_BGR888, image::FMT_RGBA8888, image::FMT_BGRA8888,
+                                        image::FMT_YVU420SP, image::FMT_GRAYSCALE};
+
+static const char *simd_name()
+{
+#if defined(MAIX_YUYV_X86)
+    return __builtin_cpu_supports("ssse3") ? "SSSE3" : "";
+#elif defined(MAIX_YUYV_NEON)
+    return "NEON";
+#else
+    return "";
+#endif
+}
+
+static void fill_yuyv(std::vector<uint8_t> &yuyv, int seed)
+{
+    uint32_t s = seed * 2654435761u + 1;
+    for (size_t i = 0; i < yuyv.size(); ++i)
+    {
+        s = s * 1103515245 + 12345;
+        yuyv[i] = s >> 16;
+    }
+}
+
+static int dst_size(image::Format fmt, int w, int h)
+{
+    return (int)(w * h * image::fmt_size[fmt]);
+}
+
+/**
+ * Widths not multiple of SIMD width test the scalar tail of SIMD kernels
+ */
+static void test_same_as_scalar()
+{
+    int sizes[][2] = {{640, 480}, {2, 2}, {18, 4}, {34, 6}, {1278, 720}};
+    for (image::Format fmt : formats)
+    {
+        camera::yuyv_convert_func_t c = camera::yuyv_convert_func(fmt, true);
+        camera::yuyv_convert_func_t simd = camera::yuyv_convert_func(fmt);
+        CHECK(c != NULL && simd != NULL);
+        if (!c || !simd)
+            continue;
+        for (auto &size : sizes)
+        {
+            int w = size[0], h = size[1];
+            std::vector<uint8_t> yuyv(w * h * 2);
+            std::vector<uint8_t> a(dst_size(fmt, w, h)), b(a.size());
+            fill_yuyv(yuyv, w + h);
+            c(yuyv.data(), a.data(), w, h);
+            simd(yuyv.data(), b.data(), w, h);
+            if (a != b)
+            {
+                log::error("%s %dx%d SIMD output differs from scalar", image::fmt_names[fmt].c_str(), w, h);
+                ++test::fails;
+            }
+        }
+    }
+    CHECK(camera::yuyv_convert_func(image::FMT_RGB565) == NULL);
+}
+
+/**
+ * Mpixel/s of kernel
+ */
+static double mpixel_s(camera::yuyv_convert_func_t func, const std::vector<uint8_t> &yuyv, std::vector<uint8_t> &dst, int w, int h, int loop)
+{
+    func(yuyv.data(), dst.data(), w, h); // warm up
+    uint64_t t = time::ticks_us();
+    for (int i = 0; i < loop; ++i)
+        func(yuyv.data(), dst.data(), w, h);
+    uint64_t us = time::ticks_us() - t;
+    return us ? (double)w * h * loop / us : 0;
+}
+
+static void bench(int w, int h, int loop)
+{
+    std::vector<uint8_t> yuyv(w * h * 2);
+    fill_yuyv(yuyv, 1);
+    const char *simd = simd_name();
+    for (image::Format fmt : formats)
+    {
+        std::vector<uint8_t> dst(dst_size(fmt, w, h));
+        double c = mpixel_s(camera::yuyv_convert_func(fmt, true), yuyv, dst, w, h, loop);
+        if (simd[0])
+        {
+            double s = mpixel_s(camera::yuyv_convert_func(fmt), yuyv, dst, w, h, loop);
+            log::info("%dx%d YUYV -> %-9s scalar %8.1f Mpixel/s, %s %8.1f Mpixel/s(x%.1f)",
+                      w, h, image::fmt_names[fmt].c_str(), c, simd, s, c > 0 ? s / c : 0);
+        }
+        else
+            log::info("%dx%d YUYV -> %-9s scalar %8.1f Mpixel/s, no SIMD kernel on this CPU", w, h, image::fmt_names[fmt].c_str(), c);
+    }
+}
+
+void test_camera_yuyv_convert()
+{
+    test_same_as_scalar();
+    if (!test::bench)
+        return;
+
+    int loop = test::arg_int("loop", 50);
+    bench(640, 480, loop);
+    bench(1920, 1080, loop);
+}
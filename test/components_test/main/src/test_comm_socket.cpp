@@ -0,0 +1,234 @@
+#include "maix_basic.hpp"
+#include "maix_comm.hpp"
+#include "maix_uart.hpp"
+#include "test.hpp"
+#include <thread>
+#include <atomic>
+#include <pty.h>
+#include <termios.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace maix;
+
+/**
+ * Test and benchmark comm::CommProtocol request -> response round trip over tcp, unix socket and UART(pty pair).
+ * Server echo request body back with resp_ok, clients run in this process, every response should match its request.
+ * Report should be sent to all clients.
+ */
+
+static const int tcp_port = 15555;
+static const char *unix_path = "/tmp/components_test_comm.sock";
+
+static int connect_server(bool tcp)
+{
+    int fd;
+    if (tcp)
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(tcp_port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        {
+            ::close(fd);
+            return -1;
+        }
+    }
+    else
+    {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        struct sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", unix_path);
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        {
+            ::close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+/**
+ * send requests one by one and wait response, return error responses count, -1 if connection error
+ */
+static int client_run(int fd, int id, int rounds, int body_len)
+{
+    protocol::Protocol dec(64 * 1024);
+    std::vector<uint8_t> body(body_len), tx(body_len + 12);
+    uint8_t rx[4096];
+    int bad = 0;
+    for (int i = 0; i < rounds && !app::need_exit(); ++i)
+    {
+        memcpy(body.data(), &id, 4);
+        memcpy(body.data() + 4, &i, 4);
+        int len = protocol::encode(tx.data(), tx.size(), 0x10, protocol::FLAG_REQ, body.data(), body.size());
+        for (int sent = 0; sent < len;)
+        {
+            int n = ::write(fd, tx.data() + sent, len - sent);
+            if (n < 0)
+                return -1;
+            sent += n;
+        }
+        protocol::MSG *msg = nullptr;
+        while (!msg)
+        {
+            int n = ::read(fd, rx, sizeof(rx));
+            if (n <= 0)
+                return -1;
+            msg = dec.decode(rx, n);
+        }
+        if (!msg->is_resp || msg->body_len != body_len || memcmp(msg->body, body.data(), 8) != 0)
+            ++bad;
+        delete msg;
+    }
+    return bad;
+}
+
+static void print_result(const char *name, int clients, int body_len, int rounds, int bad, uint64_t t_us)
+{
+    if (t_us == 0)
+        t_us = 1;
+    int total = clients * rounds;
+    log::info("%-5s clients %2d, body %5d: %8.1f us/rtt, %8.0f req/s, %6.2f MB/s, %d bad",
+              name, clients, body_len, t_us * 1.0 * clients / total, total * 1000000.0 / t_us,
+              total * 2.0 * (body_len + 12) / t_us, bad);
+}
+
+static void bench_socket(bool tcp, int clients, int body_len, int rounds)
+{
+    std::string addr = tcp ? ":" + std::to_string(tcp_port) : std::string(unix_path);
+    comm::SocketServer server(tcp ? "tcp" : "unix", addr);
+    comm::CommProtocol p(&server, 64 * 1024);
+    std::atomic<bool> stop{false};
+    std::thread th([&]()
+                   {
+        while (!stop)
+        {
+            protocol::MSG *msg = p.get_msg(100);
+            if (!msg)
+                continue;
+            p.resp_ok(msg->cmd, msg->body, msg->body_len);
+            delete msg;
+        } });
+    std::vector<std::thread> threads;
+    std::atomic<int> bad{0};
+    uint64_t t = time::ticks_us();
+    for (int i = 0; i < clients; ++i)
+    {
+        threads.emplace_back([&, i]()
+                             {
+            int fd = connect_server(tcp);
+            int n = fd < 0 ? -1 : client_run(fd, i, rounds, body_len);
+            if (fd >= 0)
+                ::close(fd);
+            bad += n < 0 ? rounds : n; });
+    }
+    for (auto &th : threads)
+        th.join();
+    t = time::ticks_us() - t;
+    stop = true;
+    th.join();
+    print_result(tcp ? "tcp" : "unix", clients, body_len, rounds, bad, t);
+    CHECK(bad == 0);
+}
+
+/**
+ * One report should reach all connected clients, also when no message got so there is no last connection
+ */
+static void test_report(bool tcp)
+{
+    std::string addr = tcp ? ":" + std::to_string(tcp_port) : std::string(unix_path);
+    comm::SocketServer server(tcp ? "tcp" : "unix", addr);
+    comm::CommProtocol p(&server, 1024);
+    int fds[2] = {connect_server(tcp), connect_server(tcp)};
+    CHECK(fds[0] >= 0 && fds[1] >= 0);
+    uint64_t t = time::ticks_ms();
+    while (server.client_count() < 2 && time::ticks_ms() - t < 1000)
+        time::sleep_ms(1);
+    CHECK(server.client_count() == 2);
+    CHECK(p.get_msg() == nullptr);
+
+    uint8_t body[] = {1, 2, 3, 4};
+    CHECK(p.report(0x10, body, sizeof(body)) == err::ERR_NONE);
+    for (int fd : fds)
+    {
+        if (fd < 0)
+            continue;
+        struct timeval tv = {1, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        protocol::Protocol dec(1024);
+        protocol::MSG *msg = nullptr;
+        uint8_t rx[256];
+        while (!msg)
+        {
+            int n = ::read(fd, rx, sizeof(rx));
+            if (n <= 0)
+                break;
+            msg = dec.decode(rx, n);
+        }
+        CHECK(msg && msg->cmd == 0x10 && msg->body_len == sizeof(body) && memcmp(msg->body, body, sizeof(body)) == 0);
+        delete msg;
+        ::close(fd);
+    }
+}
+
+static void bench_uart(int body_len, int rounds)
+{
+    int master, slave;
+    char name[128];
+    if (openpty(&master, &slave, name, NULL, NULL) < 0)
+    {
+        log::error("openpty failed");
+        return;
+    }
+    struct termios opt;
+    tcgetattr(master, &opt);
+    cfmakeraw(&opt);
+    tcsetattr(master, TCSANOW, &opt);
+    peripheral::uart::UART uart(name, 115200);
+    comm::CommProtocol p(&uart, 64 * 1024);
+    std::atomic<bool> stop{false};
+    std::thread th([&]()
+                   {
+        while (!stop)
+        {
+            protocol::MSG *msg = p.get_msg(100);
+            if (!msg)
+                continue;
+            p.resp_ok(msg->cmd, msg->body, msg->body_len);
+            delete msg;
+        } });
+    uint64_t t = time::ticks_us();
+    int bad = client_run(master, 0, rounds, body_len);
+    t = time::ticks_us() - t;
+    stop = true;
+    th.join();
+    ::close(master);
+    ::close(slave);
+    print_result("uart", 1, body_len, rounds, bad < 0 ? rounds : bad, t);
+    CHECK(bad == 0);
+}
+
+void test_comm_socket()
+{
+    test_report(true);
+    test_report(false);
+
+    // few rounds to check responses only, more rounds for benchmark
+    int rounds = test::arg_int("rounds", test::bench ? 2000 : 20);
+    int body_lens[] = {16, 1024};
+    for (int body_len : body_lens)
+    {
+        bench_uart(body_len, rounds);
+        for (int tcp = 1; tcp >= 0; --tcp)
+        {
+            bench_socket(tcp, 1, body_len, rounds);
+            bench_socket(tcp, 4, body_len, rounds);
+        }
+    }
+}
@@ -0,0 +1,130 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "test.hpp"
+
+using namespace maix;
+
+/**
+ * Test derived image cache(cached_gray, cached_color, cached_integral) content and invalidation,
+ * then benchmark several finders on the same frame like a line follower app does.
+ */
+
+static void test_gray()
+{
+    image::Image img(64, 48, image::FMT_RGB888);
+    test::fill_pattern(img, 0);
+    image::Image *full = img.to_format(image::FMT_GRAYSCALE);
+
+    // roi only convert roi area, the whole image result should be the same as to_format
+    image::Image *gray = img.cached_gray({8, 8, 16, 16});
+    CHECK(gray != &img && gray->format() == image::FMT_GRAYSCALE);
+    CHECK(img.cached_gray({10, 10, 4, 4}) == gray);
+    gray = img.cached_gray();
+    CHECK(memcmp(gray->data(), full->data(), full->data_size()) == 0);
+    delete full;
+
+    // draw invalidate cache
+    img.draw_rect(0, 0, 10, 10, image::COLOR_WHITE, -1);
+    gray = img.cached_gray({0, 0, 4, 4});
+    CHECK(((uint8_t *)gray->data())[0] == 255);
+
+    // modify data directly need invalidate_cache
+    memset(img.data(), 0, img.data_size());
+    img.invalidate_cache();
+    gray = img.cached_gray({0, 0, 4, 4});
+    CHECK(((uint8_t *)gray->data())[0] == 0);
+
+    image::Image gray_img(64, 48, image::FMT_GRAYSCALE);
+    CHECK(gray_img.cached_gray() == &gray_img);
+
+    image::Image nv21(64, 48, image::FMT_YVU420SP);
+    test::fill_pattern(nv21, 1);
+    gray = nv21.cached_gray({4, 4, 8, 8});
+    CHECK(gray->data() == nv21.data()); // Y plane view, no copy
+}
+
+static void test_color_integral()
+{
+    image::Image img(64, 48, image::FMT_RGBA8888);
+    test::fill_pattern(img, 2);
+    image::Image *rgb565 = img.cached_color(image::FMT_RGB565, {0, 0, 2, 1});
+    const uint8_t *p = (const uint8_t *)img.data();
+    uint16_t v = ((uint16_t *)rgb565->data())[1];
+    CHECK(v == (((p[4] >> 3) << 11) | ((p[5] >> 2) << 5) | (p[6] >> 3)));
+    image::Image *rgb888 = img.cached_color(image::FMT_RGB888);
+    CHECK(rgb888->format() == image::FMT_RGB888 && ((uint8_t *)rgb888->data())[3] == p[4]);
+
+    image::Image *gray = img.cached_gray();
+    const uint8_t *g = (const uint8_t *)gray->data();
+    const uint32_t *t = img.cached_integral({0, 0, 64, 20});
+    int stride = img.width() + 1;
+    uint32_t sum = 0;
+    for (int y = 5; y < 20; ++y)
+        for (int x = 3; x < 30; ++x)
+            sum += g[y * img.width() + x];
+    CHECK(t[20 * stride + 30] - t[5 * stride + 30] - t[20 * stride + 3] + t[5 * stride + 3] == sum);
+    t = img.cached_integral();
+    sum = 0;
+    for (int i = 0; i < img.width() * img.height(); ++i)
+        sum += g[i];
+    CHECK(t[img.height() * stride + img.width()] == sum);
+}
+
+static void bench(image::Format format, int loop)
+{
+    image::Image img(640, 480, format);
+    test::fill_pattern(img, 3);
+    std::vector<std::vector<int>> rois = {{0, 360, 640, 40}, {0, 240, 640, 40}, {0, 120, 640, 40}, {0, 0, 640, 40}};
+
+    // before: every finder convert the whole image
+    uint64_t t = time::ticks_us();
+    for (int i = 0; i < loop; ++i)
+    {
+        for (size_t j = 0; j < rois.size(); ++j)
+        {
+            image::Image *gray = img.to_format(image::FMT_GRAYSCALE);
+            delete gray;
+        }
+    }
+    uint64_t t_convert = time::ticks_us() - t;
+
+    t = time::ticks_us();
+    for (int i = 0; i < loop; ++i)
+    {
+        img.invalidate_cache(); // new frame
+        for (auto &roi : rois)
+            img.cached_gray(roi);
+    }
+    uint64_t t_cache = time::ticks_us() - t;
+    log::info("%s 640x480, 4 roi of 640x40 per frame: to_format %.2f ms, cached_gray %.2f ms",
+              image::fmt_names[format].c_str(), t_convert / 1000.0 / loop, t_cache / 1000.0 / loop);
+
+    // finders share the grayscale image of one frame
+    t = time::ticks_us();
+    for (int i = 0; i < loop; ++i)
+    {
+        img.invalidate_cache();
+        img.find_qrcodes();
+        img.find_line_segments(rois[0]);
+        img.find_rects(rois[1]);
+    }
+    log::info("%s 640x480, find_qrcodes + find_line_segments + find_rects per frame: %.2f ms",
+              image::fmt_names[format].c_str(), (time::ticks_us() - t) / 1000.0 / loop);
+}
+
+void test_image_cache()
+{
+    test_gray();
+    test_color_integral();
+    if (!test::bench)
+        return;
+
+    int loop = test::arg_int("loop", 20);
+    image::Format formats[] = {image::FMT_RGB888, image::FMT_BGRA8888};
+    for (auto format : formats)
+    {
+        bench(format, loop);
+        if (app::need_exit())
+            break;
+    }
+}
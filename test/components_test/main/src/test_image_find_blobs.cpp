@@ -0,0 +1,142 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "test.hpp"
+
+using namespace maix;
+
+/**
+ * Test find_blobs with BlobRecords and callback output get the same blobs as find_blobs return std::vector<image::Blob>,
+ * then benchmark them with many blobs in one image.
+ */
+
+/**
+ * Draw cols x rows white squares on black grayscale image
+ */
+static void draw_squares(image::Image &img, int cols, int rows, int size)
+{
+    int w = img.width(), h = img.height();
+    uint8_t *p = (uint8_t *)img.data();
+    memset(p, 0, w * h);
+    int step_x = w / cols, step_y = h / rows;
+    for (int r = 0; r < rows; ++r)
+    {
+        for (int c = 0; c < cols; ++c)
+        {
+            int x0 = c * step_x + (step_x - size) / 2;
+            int y0 = r * step_y + (step_y - size) / 2;
+            for (int y = y0; y < y0 + size; ++y)
+                memset(p + y * w + x0, 255, size);
+        }
+    }
+}
+
+static bool same_blob(image::Blob &blob, const image::BlobRecord &record)
+{
+    std::vector<std::vector<int>> corners = blob.corners();
+    std::vector<std::vector<int>> mini_corners = blob.mini_corners();
+    for (int i = 0; i < 4; ++i)
+    {
+        if (corners[i][0] != record.corners[i][0] || corners[i][1] != record.corners[i][1] ||
+            mini_corners[i][0] != record.mini_corners[i][0] || mini_corners[i][1] != record.mini_corners[i][1])
+            return false;
+    }
+    return blob.x() == record.x && blob.y() == record.y && blob.w() == record.w && blob.h() == record.h &&
+           blob.pixels() == record.pixels && blob.cxf() == record.cx && blob.cyf() == record.cy && blob.code() == record.code;
+}
+
+static void test_blobs(image::Image &img, int blobs_num, int size)
+{
+    std::vector<std::vector<int>> thresholds = {{200, 255}};
+    const int x_bins = 4, y_bins = 6;
+    std::vector<image::Blob> blobs = img.find_blobs(thresholds, false, {}, 1, 1, 10, 10, false, 0, x_bins, y_bins);
+    CHECK((int)blobs.size() == blobs_num);
+    for (auto &blob : blobs)
+    {
+        // histogram size was doubled before
+        CHECK(blob.x_hist_bins().size() > 0 && blob.x_hist_bins().size() <= x_bins);
+        CHECK(blob.y_hist_bins().size() > 0 && blob.y_hist_bins().size() <= y_bins);
+        CHECK(blob.w() == size && blob.h() == size && blob.pixels() == size * size);
+    }
+
+    image::BlobRecords records;
+    CHECK(img.find_blobs(records, thresholds, false, {}, 1, 1, 10, 10, false, 0, x_bins, y_bins) == err::ERR_NONE);
+    CHECK(records.size() == blobs.size());
+    for (size_t i = 0; i < records.size() && i < blobs.size(); ++i)
+    {
+        const image::BlobRecord &r = records[i];
+        CHECK(same_blob(blobs[i], r));
+        std::vector<int> x_hist(records.x_hist(r), records.x_hist(r) + r.x_hist_count);
+        std::vector<int> y_hist(records.y_hist(r), records.y_hist(r) + r.y_hist_count);
+        CHECK(x_hist == blobs[i].x_hist_bins() && y_hist == blobs[i].y_hist_bins());
+    }
+
+    // no histogram requested
+    CHECK(img.find_blobs(records, thresholds, false, {}, 1, 1) == err::ERR_NONE);
+    CHECK((int)records.size() == blobs_num && records.hist.empty());
+
+    size_t index = 0;
+    int mismatch = 0;
+    img.find_blobs([&](const image::BlobRecord &r, const uint16_t *x_hist, const uint16_t *y_hist) {
+        if (index >= blobs.size() || !same_blob(blobs[index], r) || !x_hist || !y_hist ||
+            std::vector<int>(x_hist, x_hist + r.x_hist_count) != blobs[index].x_hist_bins())
+            ++mismatch;
+        ++index;
+    }, thresholds, false, {}, 1, 1, 10, 10, false, 0, x_bins, y_bins);
+    CHECK(index == blobs.size() && mismatch == 0);
+
+    // merge all squares to one blob with large margin
+    int merged = 0;
+    img.find_blobs([&](const image::BlobRecord &r, const uint16_t *x_hist, const uint16_t *y_hist) {
+        ++merged;
+        CHECK(r.count == blobs_num);
+    }, thresholds, false, {}, 1, 1, 10, 10, true, img.width());
+    CHECK(merged == 1);
+
+    CHECK(img.find_blobs(records, {}) == err::ERR_ARGS);
+}
+
+static void bench(image::Image &img, int loop, int hist_bins)
+{
+    std::vector<std::vector<int>> thresholds = {{200, 255}};
+    image::BlobRecords records;
+    uint64_t t = time::ticks_us();
+    size_t n = 0;
+    for (int i = 0; i < loop; ++i)
+        n = img.find_blobs(thresholds, false, {}, 2, 1, 10, 10, false, 0, hist_bins, hist_bins).size();
+    uint64_t t_blob = time::ticks_us() - t;
+    t = time::ticks_us();
+    for (int i = 0; i < loop; ++i)
+        img.find_blobs(records, thresholds, false, {}, 2, 1, 10, 10, false, 0, hist_bins, hist_bins);
+    uint64_t t_record = time::ticks_us() - t;
+    int count = 0;
+    t = time::ticks_us();
+    for (int i = 0; i < loop; ++i)
+    {
+        img.find_blobs([&count](const image::BlobRecord &r, const uint16_t *x_hist, const uint16_t *y_hist) {
+            ++count;
+        }, thresholds, false, {}, 2, 1, 10, 10, false, 0, hist_bins, hist_bins);
+    }
+    uint64_t t_callback = time::ticks_us() - t;
+    log::info("%dx%d, %d blobs, hist bins %d: Blob %.2f ms, BlobRecords %.2f ms, callback %.2f ms",
+              img.width(), img.height(), (int)n, hist_bins, t_blob / 1000.0 / loop, t_record / 1000.0 / loop, t_callback / 1000.0 / loop);
+}
+
+void test_image_find_blobs()
+{
+    image::Image img(640, 480, image::FMT_GRAYSCALE);
+    draw_squares(img, 20, 15, 6);
+    test_blobs(img, 20 * 15, 6);
+    if (!test::bench)
+        return;
+
+    int loop = test::arg_int("loop", 20);
+    int grids[][2] = {{4, 3}, {20, 15}, {40, 30}};
+    for (auto &grid : grids)
+    {
+        draw_squares(img, grid[0], grid[1], 6);
+        bench(img, loop, 0);
+        bench(img, loop, 8);
+        if (app::need_exit())
+            break;
+    }
+}
@@ -0,0 +1,87 @@
+
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_image_preprocess.hpp"
+#include "test.hpp"
+#include <math.h>
+#include <algorithm>
+
+using namespace maix;
+
+/**
+ * Test image::Preprocessor output, and benchmark model input preprocess, compare image.to_format + image.resize + normalize loop with it.
+ */
+
+static void old_preprocess(image::Image &img, float *dst, int w, int h, const float *mean, const float *scale, image::Fit fit)
+{
+    image::Image *rgb = img.to_format(image::FMT_RGB888);
+    image::Image *resized = rgb->resize(w, h, fit, image::ResizeMethod::BILINEAR);
+    const uint8_t *src = (const uint8_t *)resized->data();
+    int hw = w * h;
+    for (int i = 0; i < hw; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+            dst[c * hw + i] = (src[i * 3 + c] - mean[c]) * scale[c];
+    }
+    delete resized;
+    delete rgb;
+}
+
+void test_image_preprocess()
+{
+    std::vector<float> mean_v(3, 0), scale_v(3, 1 / 255.0);
+
+    // same size RGB888, output should be pixel * scale in CHW layout
+    {
+        image::Image rgb(64, 48, image::FMT_RGB888);
+        test::fill_pattern(rgb, 1);
+        std::vector<float> out(3 * 64 * 48);
+        image::Preprocessor pre(1);
+        CHECK(pre.run(rgb, out.data(), 64, 48, image::FMT_RGB888, tensor::FLOAT32, true, mean_v, scale_v, image::Fit::FIT_FILL) == err::ERR_NONE);
+        const uint8_t *p = (const uint8_t *)rgb.data();
+        float diff = 0;
+        for (int i = 0; i < 64 * 48; ++i)
+            for (int c = 0; c < 3; ++c)
+                diff = std::max(diff, fabsf(out[c * 64 * 48 + i] - p[i * 3 + c] / 255.0f));
+        CHECK(diff < 1e-4);
+    }
+
+    int src_w = test::arg_int("src_w", 640), src_h = test::arg_int("src_h", 480);
+    int dst_w = test::arg_int("dst_w", 320), dst_h = test::arg_int("dst_h", 224);
+    int threads = test::arg_int("threads", 0);
+    image::Image img(src_w, src_h, image::FMT_YVU420SP);
+    uint8_t *p = (uint8_t *)img.data();
+    for (int i = 0; i < img.data_size(); ++i)
+        p[i] = i < src_w * src_h ? (uint8_t)(i % src_w + i / src_w) : (uint8_t)(128 + i % 16);
+
+    float mean[3] = {0, 0, 0};
+    float scale[3] = {1 / 255.0, 1 / 255.0, 1 / 255.0};
+    std::vector<float> out(3 * dst_w * dst_h);
+    image::Preprocessor pre(threads);
+    image::Fit fits[] = {image::Fit::FIT_FILL, image::Fit::FIT_CONTAIN};
+    const char *fit_names[] = {"fill", "contain"};
+
+    // NV21 resize, all values normalized to [0, 1]
+    for (auto fit : fits)
+    {
+        CHECK(pre.run(img, out.data(), dst_w, dst_h, image::FMT_RGB888, tensor::FLOAT32, true, mean_v, scale_v, fit) == err::ERR_NONE);
+        CHECK(std::all_of(out.begin(), out.end(), [](float v) { return v >= -1e-5f && v <= 1 + 1e-5f; }));
+    }
+    if (!test::bench)
+        return;
+
+    int loop = test::arg_int("loop", 20);
+    for (int k = 0; k < 2; ++k)
+    {
+        uint64_t t = time::ticks_us();
+        for (int i = 0; i < loop; ++i)
+            old_preprocess(img, out.data(), dst_w, dst_h, mean, scale, fits[k]);
+        uint64_t t_old = (time::ticks_us() - t) / loop;
+        t = time::ticks_us();
+        for (int i = 0; i < loop; ++i)
+            pre.run(img, out.data(), dst_w, dst_h, image::FMT_RGB888, tensor::FLOAT32, true, mean_v, scale_v, fits[k]);
+        uint64_t t_new = (time::ticks_us() - t) / loop;
+        log::info("NV21 %dx%d -> float CHW %dx%d %s: old %d us, fused %d us (%d threads), %.1fx",
+                  src_w, src_h, dst_w, dst_h, fit_names[k], (int)t_old, (int)t_new, pre.threads(), (float)t_old / (t_new ? t_new : 1));
+    }
+}
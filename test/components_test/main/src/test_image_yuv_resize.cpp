@@ -0,0 +1,177 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_image_yuv.hpp"
+#include "test.hpp"
+#include <math.h>
+
+using namespace maix;
+
+/**
+ * Test NV21 resize, crop and rotate on Y and VU planes directly,
+ * and benchmark with the RGB round trip path(to_format RGB888 + resize + to_format YVU420SP).
+ */
+
+static void fill_test_image(image::Image &img)
+{
+    int w = img.width(), h = img.height();
+    uint8_t *p = (uint8_t *)img.data();
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            p[y * w + x] = (uint8_t)(x * 255 / w / 2 + y * 255 / h / 2);
+    for (int y = 0; y < h / 2; ++y)
+    {
+        for (int x = 0; x < w / 2; ++x)
+        {
+            p[w * h + y * w + x * 2] = (uint8_t)(64 + x * 128 / (w / 2));
+            p[w * h + y * w + x * 2 + 1] = (uint8_t)(192 - y * 128 / (h / 2));
+        }
+    }
+}
+
+static image::Image *old_resize(image::Image &img, int w, int h, image::Fit fit, image::ResizeMethod method)
+{
+    image::Image *rgb = img.to_format(image::FMT_RGB888);
+    image::Image *resized = rgb->resize(w, h, fit, method);
+    image::Image *ret = resized->to_format(image::FMT_YVU420SP);
+    delete resized;
+    delete rgb;
+    return ret;
+}
+
+static double mean_diff(image::Image &a, image::Image &b, int offset, int len)
+{
+    const uint8_t *pa = (const uint8_t *)a.data() + offset;
+    const uint8_t *pb = (const uint8_t *)b.data() + offset;
+    double sum = 0;
+    for (int i = 0; i < len; ++i)
+        sum += abs(pa[i] - pb[i]);
+    return sum / len;
+}
+
+static void test_resize()
+{
+    image::Image img(64, 48, image::FMT_YVU420SP);
+    fill_test_image(img);
+    uint8_t *p = (uint8_t *)img.data();
+
+    // same size bilinear resize is a copy
+    image::Image *same = img.resize(64, 48, image::Fit::FIT_FILL, image::ResizeMethod::BILINEAR);
+    CHECK(memcmp(same->data(), img.data(), 64 * 48 * 3 / 2) == 0);
+    delete same;
+
+    // letterbox keep blank area black
+    image::Image *contain = img.resize(40, 40, image::Fit::FIT_CONTAIN, image::ResizeMethod::BILINEAR);
+    uint8_t *c = (uint8_t *)contain->data();
+    CHECK(c[0] == 0 && c[40 * 40 - 1] == 0 && c[40 * 40] == 128 && c[40 * 40 + 1] == 128);
+    CHECK(c[20 * 40 + 20] != 0);
+    delete contain;
+
+    // compare with RGB round trip, chroma loss of NV21 -> RGB -> NV21 make them not exactly same
+    image::Fit fits[] = {image::Fit::FIT_FILL, image::Fit::FIT_CONTAIN, image::Fit::FIT_COVER};
+    for (auto fit : fits)
+    {
+        image::Image *a = img.resize(32, 32, fit, image::ResizeMethod::BILINEAR);
+        image::Image *b = old_resize(img, 32, 32, fit, image::ResizeMethod::BILINEAR);
+        double dy = mean_diff(*a, *b, 0, 32 * 32);
+        double duv = mean_diff(*a, *b, 32 * 32, 32 * 16);
+        log::info("fit %d, mean diff with RGB round trip: Y %.2f, VU %.2f", fit, dy, duv);
+        CHECK(dy < 3 && duv < 3);
+        delete a;
+        delete b;
+    }
+
+    // crop align to 2
+    image::Image *crop = img.crop(5, 3, 8, 4);
+    uint8_t *cp = (uint8_t *)crop->data();
+    CHECK(cp[0] == p[2 * 64 + 4] && cp[8 * 4] == p[64 * 48 + 64 + 4] && cp[8 * 4 + 1] == p[64 * 48 + 64 + 5]);
+    delete crop;
+
+    // rotate 90 anti-clock wise, right top corner move to left top
+    image::Image *r90 = img.rotate(90);
+    CHECK(r90->width() == 48 && r90->height() == 64);
+    uint8_t *rp = (uint8_t *)r90->data();
+    CHECK(rp[0] == p[63] && rp[48 * 64] == p[64 * 48 + 62] && rp[48 * 64 + 1] == p[64 * 48 + 63]);
+    image::Image *r180 = r90->rotate(90);
+    image::Image *r270 = r180->rotate(90);
+    image::Image *r360 = r270->rotate(90);
+    CHECK(memcmp(r360->data(), img.data(), 64 * 48 * 3 / 2) == 0);
+    image::Image *back = r180->rotate(-180);
+    CHECK(memcmp(back->data(), img.data(), 64 * 48 * 3 / 2) == 0);
+    delete back;
+    delete r360;
+    delete r270;
+    delete r180;
+    delete r90;
+
+    // mirror twice
+    image::Image m(64, 48, image::FMT_YVU420SP), m2(64, 48, image::FMT_YVU420SP);
+    CHECK(image::yuv420sp_rotate(img, m, 0, true, true) == err::ERR_NONE);
+    CHECK(image::yuv420sp_rotate(m, m2, 180) == err::ERR_NONE);
+    CHECK(memcmp(m2.data(), img.data(), 64 * 48 * 3 / 2) == 0);
+}
+
+static void bench(int src_w, int src_h, int dst_w, int dst_h, int loop)
+{
+    image::Image img(src_w, src_h, image::FMT_YVU420SP);
+    fill_test_image(img);
+    image::Image dst(dst_w, dst_h, image::FMT_YVU420SP);
+    image::Fit fits[] = {image::Fit::FIT_FILL, image::Fit::FIT_CONTAIN, image::Fit::FIT_COVER};
+    const char *fit_names[] = {"fill", "contain", "cover"};
+    image::ResizeMethod methods[] = {image::ResizeMethod::NEAREST, image::ResizeMethod::BILINEAR};
+    const char *method_names[] = {"nearest", "bilinear"};
+    for (int k = 0; k < 3 && !app::need_exit(); ++k)
+    {
+        for (int m = 0; m < 2; ++m)
+        {
+            uint64_t t = time::ticks_us();
+            for (int i = 0; i < loop; ++i)
+                delete old_resize(img, dst_w, dst_h, fits[k], methods[m]);
+            uint64_t t_old = time::ticks_us() - t;
+            t = time::ticks_us();
+            for (int i = 0; i < loop; ++i)
+                delete img.resize(dst_w, dst_h, fits[k], methods[m]);
+            uint64_t t_new = time::ticks_us() - t;
+            t = time::ticks_us();
+            for (int i = 0; i < loop; ++i)
+                image::yuv420sp_resize(img, dst, fits[k], methods[m]);
+            uint64_t t_into = time::ticks_us() - t;
+            log::info("%dx%d -> %dx%d %s %s: RGB round trip %d us, resize %d us, yuv420sp_resize into dst %d us",
+                      src_w, src_h, dst_w, dst_h, fit_names[k], method_names[m],
+                      (int)(t_old / loop), (int)(t_new / loop), (int)(t_into / loop));
+        }
+    }
+}
+
+static void bench_rotate(int w, int h, int loop)
+{
+    image::Image img(w, h, image::FMT_YVU420SP);
+    fill_test_image(img);
+    image::Image r90(h, w, image::FMT_YVU420SP), mirror(w, h, image::FMT_YVU420SP);
+    uint64_t t = time::ticks_us();
+    for (int i = 0; i < loop; ++i)
+        image::yuv420sp_rotate(img, r90, 90);
+    uint64_t t_rotate = time::ticks_us() - t;
+    t = time::ticks_us();
+    for (int i = 0; i < loop; ++i)
+        image::yuv420sp_rotate(img, mirror, 0, true);
+    uint64_t t_mirror = time::ticks_us() - t;
+    t = time::ticks_us();
+    for (int i = 0; i < loop; ++i)
+        delete img.crop(w / 4, h / 4, w / 2, h / 2);
+    uint64_t t_crop = time::ticks_us() - t;
+    log::info("%dx%d: rotate 90 %d us, hmirror %d us, crop center %d us",
+              w, h, (int)(t_rotate / loop), (int)(t_mirror / loop), (int)(t_crop / loop));
+}
+
+void test_image_yuv_resize()
+{
+    test_resize();
+    if (!test::bench)
+        return;
+
+    int loop = test::arg_int("loop", 10);
+    bench(1920, 1080, 640, 640, loop);
+    bench(1280, 720, 320, 224, loop);
+    if (!app::need_exit())
+        bench_rotate(1920, 1080, loop);
+}
@@ -0,0 +1,315 @@
+#include "maix_basic.hpp"
+#include "test.hpp"
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace maix;
+
+/**
+ * Test asynchronous log: format result same as printf, order of every thread, drop when ring buffer full and rate limit,
+ * and benchmark time of one log call in synchronous and asynchronous mode with different threads number.
+ * Logs are written to a file with stdout disabled, so results are printed with printf.
+ */
+
+static const char *log_path = "/tmp/components_test.log";
+
+typedef struct
+{
+    int tid;
+    char level;
+    std::string msg;
+} line_t;
+
+/**
+ * Reset log file and read lines written, line format "date time tid level msg".
+ */
+static std::vector<line_t> read_log(bool reset = true)
+{
+    log::flush();
+    std::vector<line_t> lines;
+    std::ifstream f(log_path);
+    std::string s;
+    while (std::getline(f, s))
+    {
+        line_t line;
+        int off = 0;
+        if (sscanf(s.c_str(), "%*s %*s %d %c %n", &line.tid, &line.level, &off) < 2 || off == 0)
+            continue;
+        line.msg = s.substr(off);
+        lines.push_back(line);
+    }
+    if (reset)
+    {
+        remove(log_path);
+        log::set_file(log_path, 0);
+    }
+    return lines;
+}
+
+static std::string sprintf_str(const char *fmt, ...)
+{
+    char buff[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buff, sizeof(buff), fmt, args);
+    va_end(args);
+    return buff;
+}
+
+static void test_format()
+{
+    std::vector<std::string> expected;
+#define LOG_AND_EXPECT(fmt, ...)                               \
+    do                                                         \
+    {                                                          \
+        log::info(fmt, ##__VA_ARGS__);                         \
+        expected.push_back(sprintf_str(fmt, ##__VA_ARGS__));   \
+    } while (0)
+
+    std::string heap_str = "heap string";
+    char not_terminated[4] = {'a', 'b', 'c', 'd'};
+    std::string heap_fmt = "heap format %d %s";
+    LOG_AND_EXPECT("no args");
+    LOG_AND_EXPECT("int %d %i %5d %-5d| %05d %+d", -1, 2, 3, 4, 5, 6);
+    LOG_AND_EXPECT("unsigned %u %x %X %#o %hhu %hd", 4000000000U, 0xabcdU, 0xabcdU, 8U, 300, 70000);
+    LOG_AND_EXPECT("long %ld %lu %lld %llu %zu %zd %jd %td", -1L, 2UL, -(1LL << 40), 1ULL << 63, (size_t)5, (ssize_t)-6, (intmax_t)7, (ptrdiff_t)-8);
+    LOG_AND_EXPECT("double %f %.2f %e %g %10.3f %a", 1.5, 3.14159, 12345.678, 0.0001, -2.5, 1.0);
+    LOG_AND_EXPECT("float %f long double %Lf", 0.25f, (long double)1.125);
+    LOG_AND_EXPECT("star %*d %-*.*f %.*s", 6, 42, 8, 2, 1.23456, 3, "abcdef");
+    LOG_AND_EXPECT("char %c%c percent %% %5%", 'o', 'k');
+    LOG_AND_EXPECT("string %s %s %10s %-4s| %s", "literal", heap_str.c_str(), "right", "l", (const char *)NULL);
+    LOG_AND_EXPECT("not terminated %.4s %.*s", not_terminated, 2, not_terminated);
+    LOG_AND_EXPECT("pointer %p", (void *)&heap_str);
+    LOG_AND_EXPECT(heap_fmt.c_str(), 1, "two");
+    // not supported in ring buffer, formatted in caller thread
+    LOG_AND_EXPECT("positional %2$d %1$d", 1, 2);
+    LOG_AND_EXPECT("wide %ls", L"wide");
+    std::string long_str(3000, 'x');
+    log::info("long %s end", long_str.c_str());
+    // free strings after log, they are copied
+    heap_str.assign(heap_str.size(), '?');
+    heap_fmt.assign(heap_fmt.size(), '?');
+
+    std::vector<line_t> lines = read_log();
+    CHECK(lines.size() == expected.size() + 1);
+    for (size_t i = 0; i < expected.size() && i < lines.size(); ++i)
+    {
+        if (lines[i].msg != expected[i])
+        {
+            printf("-- [E] format not match:\n   got: %s\nexpect: %s\n", lines[i].msg.c_str(), expected[i].c_str());
+            ++test::fails;
+        }
+    }
+    if (lines.size() == expected.size() + 1)
+    {
+        const std::string &msg = lines.back().msg;
+        CHECK(msg.find("long xxxx") == 0 && msg.size() > 1000 && msg.size() < 2048);
+    }
+}
+
+static void test_order(int threads, int count)
+{
+    uint64_t dropped = log::dropped_count();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([t, count]() {
+            for (int i = 0; i < count; ++i)
+                log::info("thread %d seq %d", t, i);
+        });
+    }
+    for (auto &w : workers)
+        w.join();
+    std::vector<line_t> lines = read_log();
+    std::vector<int> next(threads, 0);
+    int bad = 0;
+    for (auto &line : lines)
+    {
+        int t, seq;
+        if (sscanf(line.msg.c_str(), "thread %d seq %d", &t, &seq) != 2 || t < 0 || t >= threads || seq != next[t]++)
+            ++bad;
+    }
+    CHECK(bad == 0);
+    CHECK((int)lines.size() == threads * count);
+    CHECK(log::dropped_count() == dropped);
+}
+
+static void test_drop()
+{
+    // small ring buffer and long flush interval, new thread will use new ring size
+    CHECK(log::set_async(false) == err::ERR_NONE);
+    CHECK(log::set_async(true, 8192, 1000) == err::ERR_NONE);
+    uint64_t dropped = log::dropped_count();
+    const int count = 2000;
+    std::thread([]() {
+        for (int i = 0; i < count; ++i)
+            log::info("drop test %d", i);
+    }).join();
+    dropped = log::dropped_count() - dropped;
+    std::vector<line_t> lines = read_log();
+    int logs = 0, warns = 0;
+    for (auto &line : lines)
+    {
+        if (line.msg.find("drop test") == 0)
+            ++logs;
+        else if (line.level == 'W' && line.msg.find("dropped, ring buffer full") != std::string::npos)
+            ++warns;
+    }
+    printf("ring 8192 bytes, %d logs, %d written, %d dropped\n", count, logs, (int)dropped);
+    CHECK(dropped > 0 && logs + (int)dropped == count && warns > 0);
+    CHECK(log::set_async(false) == err::ERR_NONE);
+    CHECK(log::set_async(true) == err::ERR_NONE);
+}
+
+static void test_rate_limit()
+{
+    uint64_t suppressed = log::suppressed_count();
+    log::set_rate_limit(10);
+    // wait a new second, all logs in one window
+    uint64_t sec = time::time_ms() / 1000;
+    while (time::time_ms() / 1000 == sec)
+        time::sleep_ms(1);
+    for (int i = 0; i < 1000; ++i)
+        log::info("rate limit test %d", i);
+    log::warn("other call site");
+    log::set_rate_limit(0);
+    suppressed = log::suppressed_count() - suppressed;
+    std::vector<line_t> lines = read_log();
+    int logs = 0;
+    for (auto &line : lines)
+        logs += line.msg.find("rate limit test") == 0;
+    printf("rate limit 10/s, 1000 logs, %d written, %d suppressed\n", logs, (int)suppressed);
+    CHECK(logs == 10 && suppressed == 990 && lines.size() == 11);
+}
+
+static void test_rotate()
+{
+    CHECK(log::set_file(log_path, 4096, 2) == err::ERR_NONE);
+    for (int i = 0; i < 300; ++i)
+        log::info("rotate test %d", i);
+    log::flush();
+    std::string rotated[] = {log_path, std::string(log_path) + ".1", std::string(log_path) + ".2", std::string(log_path) + ".3"};
+    for (int i = 0; i < 3; ++i)
+    {
+        std::ifstream f(rotated[i], std::ios::binary | std::ios::ate);
+        CHECK(f.is_open() && f.tellg() > 0 && f.tellg() <= 4096);
+    }
+    CHECK(!fs::exists(rotated[3]));
+    // last lines in current file
+    std::vector<line_t> lines = read_log();
+    CHECK(!lines.empty() && lines.back().msg == "rotate test 299");
+    for (int i = 1; i < 4; ++i)
+        remove(rotated[i].c_str());
+}
+
+static void test_syslog()
+{
+    const char *sock_path = "/tmp/components_test_syslog.sock";
+    remove(sock_path);
+    int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sock_path, sizeof(addr.sun_path) - 1);
+    CHECK(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    CHECK(log::set_syslog("bench", sock_path) == err::ERR_NONE);
+    log::warn("syslog test %d", 1);
+    log::flush();
+    char buff[256] = {0};
+    struct timeval tv = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    ssize_t n = recv(fd, buff, sizeof(buff) - 1, 0);
+    std::string expected = "<12>bench[" + std::to_string(getpid()) + "]: syslog test 1";
+    CHECK(n > 0 && expected == buff);
+    log::set_syslog("");
+    close(fd);
+    remove(sock_path);
+    read_log();
+}
+
+/**
+ * @return ns per log call, p50, p99 and max in p50, p99 and max
+ */
+static double bench(int threads, int count, double *p50, double *p99, double *max)
+{
+    std::vector<std::vector<uint32_t>> costs(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&costs, t, count]() {
+            std::vector<uint32_t> &cost = costs[t];
+            cost.reserve(count);
+            for (int i = 0; i < count; ++i)
+            {
+                struct timespec a, b;
+                clock_gettime(CLOCK_MONOTONIC, &a);
+                log::info("bench thread %d seq %d value %.3f %s", t, i, i * 0.5, "literal");
+                clock_gettime(CLOCK_MONOTONIC, &b);
+                cost.push_back((b.tv_sec - a.tv_sec) * 1000000000 + b.tv_nsec - a.tv_nsec);
+            }
+        });
+    }
+    for (auto &w : workers)
+        w.join();
+    std::vector<uint32_t> all;
+    for (auto &c : costs)
+        all.insert(all.end(), c.begin(), c.end());
+    std::sort(all.begin(), all.end());
+    *p50 = all[all.size() / 2];
+    *p99 = all[all.size() * 99 / 100];
+    *max = all.back();
+    double mean = 0;
+    for (uint32_t c : all)
+        mean += c;
+    read_log();
+    return mean / all.size();
+}
+
+void test_log_async()
+{
+    remove(log_path);
+    log::set_stdout(false);
+    CHECK(log::set_file(log_path, 0) == err::ERR_NONE);
+    CHECK(log::set_async(true, 1 << 20) == err::ERR_NONE);
+
+    test_format();
+    test_order(4, 5000);
+    test_drop();
+    test_rate_limit();
+    test_rotate();
+    test_syslog();
+
+    // bench, ring buffer large enough to hold all logs of one thread, so no drop
+    CHECK(log::set_async(false) == err::ERR_NONE);
+    int count = test::arg_int("count", 20000);
+    uint64_t dropped = log::dropped_count();
+    int threads_list[] = {1, 2, 4};
+    std::vector<std::string> results;
+    for (int mode = 0; mode < 2 && test::bench; ++mode)
+    {
+        if (mode == 1)
+            CHECK(log::set_async(true, 1 << 22) == err::ERR_NONE);
+        for (int threads : threads_list)
+        {
+            if (app::need_exit())
+                break;
+            double p50, p99, max;
+            double mean = bench(threads, count, &p50, &p99, &max);
+            results.push_back(sprintf_str("%-5s %d threads: %8.1f ns/log, p50 %8.1f ns, p99 %8.1f ns, max %8.1f us",
+                                          mode ? "async" : "sync", threads, mean, p50, p99, max / 1000));
+        }
+    }
+    CHECK(log::dropped_count() == dropped);
+
+    // restore log settings for other tests
+    log::set_async(false);
+    log::set_file("");
+    remove(log_path);
+    log::set_stdout(true);
+    for (auto &r : results)
+        log::info("%s", r.c_str());
+}
@@ -0,0 +1,190 @@
+
+#include "maix_basic.hpp"
+#include "maix_nn_yolov8.hpp"
+#include "test.hpp"
+#include <math.h>
+
+using namespace maix;
+
+/**
+ * Test nn::YOLOv8Decoder get the same objects as the old per object decode + pairwise NMS, and benchmark them.
+ * Use recorded model output tensors(raw float32 files) or generated data.
+ */
+
+static void gen_outputs(std::vector<float> &scores, std::vector<float> &boxes, int class_num, int total_box_num, int obj_num)
+{
+    // background low scores, some objects with several anchors around each
+    scores.resize(class_num * total_box_num);
+    boxes.resize(4 * total_box_num);
+    for (auto &s : scores)
+        s = (rand() % 1000) / 1000.0f * 0.2f;
+    for (auto &b : boxes)
+        b = 0.5f + (rand() % 1000) / 1000.0f * 2;
+    for (int i = 0; i < obj_num; ++i)
+    {
+        int center = rand() % total_box_num;
+        int class_id = rand() % class_num;
+        for (int k = -20; k <= 20; ++k)
+        {
+            int n = center + k;
+            if (n < 0 || n >= total_box_num)
+                continue;
+            // unique score of every anchor, so NMS order of old and new path are the same
+            scores[class_id * total_box_num + n] = 0.3f + 0.6f * ((n * 7919) % total_box_num) / total_box_num;
+        }
+    }
+}
+
+static bool load_raw(const char *path, std::vector<float> &data, size_t num)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+        return false;
+    data.resize(num);
+    size_t n = fread(data.data(), sizeof(float), num, fp);
+    fclose(fp);
+    return n == num;
+}
+
+static float calc_iou(nn::Object &a, nn::Object &b)
+{
+    float area1 = a.w * a.h;
+    float area2 = b.w * b.h;
+    float wi = std::min((a.x + a.w), (b.x + b.w)) - std::max(a.x, b.x);
+    float hi = std::min((a.y + a.h), (b.y + b.h)) - std::max(a.y, b.y);
+    float area_i = std::max(wi, 0.0f) * std::max(hi, 0.0f);
+    return area_i / (area1 + area2 - area_i);
+}
+
+// old path of YOLOv8::_decode_objs and YOLOv8::_nms, sort by score from high to low so results can be compared
+static nn::Objects *old_post_process(const float *scores_ptr, const float *dets_ptr, int class_num, int total_box_num, int w, int h, float conf_th, float iou_th)
+{
+    float stride[3] = {8, 16, 32};
+    nn::Objects objs;
+    int idx_start[3] = {0, (int)(h / stride[0] * w / stride[0]), (int)(h / stride[0] * w / stride[0] + h / stride[1] * w / stride[1])};
+    for (int i = 0; i < 3; i++)
+    {
+        int nh = h / stride[i];
+        int nw = w / stride[i];
+        for (int ay = 0; ay < nh; ++ay)
+        {
+            for (int ax = 0; ax < nw; ++ax)
+            {
+                int offset = idx_start[i] + ay * nw + ax;
+                int class_id = 0;
+                for (int c = 1; c < class_num; ++c)
+                {
+                    if (scores_ptr[offset + class_id * total_box_num] < scores_ptr[offset + c * total_box_num])
+                        class_id = c;
+                }
+                float obj_score = scores_ptr[offset + class_id * total_box_num];
+                if (obj_score <= conf_th)
+                    continue;
+                float bbox_x = (ax + 0.5 - dets_ptr[offset]) * stride[i];
+                float bbox_y = (ay + 0.5 - dets_ptr[offset + total_box_num]) * stride[i];
+                float bbox_w = (ax + 0.5 + dets_ptr[offset + total_box_num * 2]) * stride[i] - bbox_x;
+                float bbox_h = (ay + 0.5 + dets_ptr[offset + total_box_num * 3]) * stride[i] - bbox_y;
+                nn::Object *obj = objs.add(bbox_x, bbox_y, bbox_w, bbox_h, class_id, obj_score);
+                obj->temp = (void *)new nn::_KpInfo(offset, ax, ay, stride[i]);
+            }
+        }
+    }
+    nn::Objects *result = new nn::Objects();
+    std::sort(objs.begin(), objs.end(), [](const nn::Object *a, const nn::Object *b) { return a->score > b->score; });
+    for (size_t i = 0; i < objs.size(); ++i)
+    {
+        nn::Object *a = objs.at(i);
+        if (a->score == 0)
+            continue;
+        for (size_t j = i + 1; j < objs.size(); ++j)
+        {
+            nn::Object *b = objs.at(j);
+            if (b->score != 0 && a->class_id == b->class_id && calc_iou(*a, *b) > iou_th)
+                b->score = 0;
+        }
+    }
+    for (nn::Object *a : objs)
+    {
+        if (a->score != 0)
+            result->add(a->x, a->y, a->w, a->h, a->class_id, a->score);
+        delete (nn::_KpInfo *)a->temp;
+    }
+    return result;
+}
+
+static nn::Objects *new_post_process(nn::YOLOv8Decoder &decoder, const float *scores, const float *boxes, int class_num, int total_box_num, int w, int h, float conf_th, float iou_th, int max_det)
+{
+    nn::Objects *result = new nn::Objects();
+    decoder.decode(scores, boxes, class_num, total_box_num, w, h, conf_th);
+    decoder.nms(iou_th, max_det);
+    for (int i : decoder.keep)
+        result->add(decoder.x1[i], decoder.y1[i], decoder.x2[i] - decoder.x1[i], decoder.y2[i] - decoder.y1[i], decoder.class_id[i], decoder.score[i]);
+    return result;
+}
+
+void test_nn_yolov8()
+{
+    // scores: float32 [class_num, anchor_num], boxes: float32 [4, anchor_num], dumped from model outputs
+    std::string scores_path = test::arg("scores");
+    std::string boxes_path = test::arg("boxes");
+    int class_num = test::arg_int("class_num", 80);
+    int w = test::arg_int("input_w", 640);
+    int h = test::arg_int("input_h", 640);
+    int total_box_num = (w / 8) * (h / 8) + (w / 16) * (h / 16) + (w / 32) * (h / 32);
+    std::vector<float> scores, boxes;
+    if (!scores_path.empty())
+    {
+        if (!load_raw(scores_path.c_str(), scores, class_num * total_box_num) || !load_raw(boxes_path.c_str(), boxes, 4 * total_box_num))
+        {
+            log::error("load %s or %s failed", scores_path.c_str(), boxes_path.c_str());
+            ++test::fails;
+            return;
+        }
+    }
+    else
+        gen_outputs(scores, boxes, class_num, total_box_num, 50);
+
+    nn::YOLOv8Decoder decoder;
+    float iou_th = 0.45;
+    float conf_ths[] = {0.5, 0.25, 0.1};
+    // background scores of generated data are lower than 0.2 and not unique, only compare objects above them
+    for (float conf_th : {0.5f, 0.25f})
+    {
+        nn::Objects *old_res = old_post_process(scores.data(), boxes.data(), class_num, total_box_num, w, h, conf_th, iou_th);
+        nn::Objects *new_res = new_post_process(decoder, scores.data(), boxes.data(), class_num, total_box_num, w, h, conf_th, iou_th, -1);
+        CHECK(old_res->size() == new_res->size());
+        for (size_t i = 0; i < old_res->size() && i < new_res->size(); ++i)
+        {
+            nn::Object *a = old_res->at(i), *b = new_res->at(i);
+            CHECK(a->class_id == b->class_id && a->score == b->score && fabs(a->x - b->x) < 0.01 && fabs(a->y - b->y) < 0.01);
+        }
+        delete old_res;
+        delete new_res;
+    }
+    if (!test::bench)
+        return;
+
+    int loop = test::arg_int("loop", 20);
+    for (float conf_th : conf_ths)
+    {
+        uint64_t t = time::ticks_us();
+        size_t old_num = 0, new_num = 0;
+        for (int i = 0; i < loop; ++i)
+        {
+            nn::Objects *res = old_post_process(scores.data(), boxes.data(), class_num, total_box_num, w, h, conf_th, iou_th);
+            old_num = res->size();
+            delete res;
+        }
+        uint64_t t_old = (time::ticks_us() - t) / loop;
+        t = time::ticks_us();
+        for (int i = 0; i < loop; ++i)
+        {
+            nn::Objects *res = new_post_process(decoder, scores.data(), boxes.data(), class_num, total_box_num, w, h, conf_th, iou_th, -1);
+            new_num = res->size();
+            delete res;
+        }
+        uint64_t t_new = (time::ticks_us() - t) / loop;
+        log::info("conf_th %.2f: candidates %d, old %d objs %d us, new %d objs %d us, %.1fx",
+                  conf_th, decoder.num, (int)old_num, (int)t_old, (int)new_num, (int)t_new, (float)t_old / (t_new ? t_new : 1));
+    }
+}
@@ -0,0 +1,406 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_image_overlay.hpp"
+#include "test.hpp"
+#include <math.h>
+
+using namespace maix;
+
+/**
+ * Test draw_image blending against a float reference for all supported formats and blend modes,
+ * test Overlay is the same as draw_image layer by layer, then compare UI drawing time of
+ * the old per pixel draw_image, draw_image and Overlay on camera size frames.
+ */
+
+static const image::Format formats[] = {image::FMT_GRAYSCALE, image::FMT_RGB888, image::FMT_BGR888, image::FMT_RGBA8888, image::FMT_BGRA8888,
+                                        image::FMT_YUV422SP, image::FMT_YUV422P, image::FMT_YVU420SP, image::FMT_YUV420SP, image::FMT_YVU420P, image::FMT_YUV420P};
+
+static bool is_yuv(image::Format fmt)
+{
+    return fmt >= image::FMT_YUV422SP && fmt <= image::FMT_YUV420P;
+}
+
+static bool is_yuv422(image::Format fmt)
+{
+    return fmt == image::FMT_YUV422SP || fmt == image::FMT_YUV422P;
+}
+
+static bool has_alpha(image::Format fmt)
+{
+    return fmt == image::FMT_RGBA8888 || fmt == image::FMT_BGRA8888;
+}
+
+/**
+ * Random bytes, alpha is 0, 255 or random
+ */
+static void fill_random(image::Image &img, int seed)
+{
+    uint8_t *p = (uint8_t *)img.data();
+    uint32_t s = seed * 2654435761u + 1;
+    for (int i = 0; i < img.data_size(); ++i)
+    {
+        s = s * 1103515245 + 12345;
+        p[i] = s >> 16;
+    }
+    if (has_alpha(img.format()))
+    {
+        for (int i = 3; i < img.data_size(); i += 4)
+            p[i] = p[i] % 4 == 0 ? 0 : (p[i] % 4 == 1 ? 255 : p[i]);
+    }
+}
+
+/**
+ * Y, U and V address of pixel
+ */
+static void yuv_ptr(image::Image &img, int x, int y, uint8_t **Y, uint8_t **U, uint8_t **V)
+{
+    int w = img.width(), h = img.height();
+    int cw = (w + 1) / 2, ch = (h + 1) / 2;
+    uint8_t *data = (uint8_t *)img.data();
+    uint8_t *c = data + w * h;
+    *Y = data + y * w + x;
+    switch (img.format())
+    {
+    case image::FMT_YUV422SP: *U = c + y * cw * 2 + x / 2 * 2; *V = *U + 1; break;
+    case image::FMT_YUV422P: *U = c + y * cw + x / 2; *V = *U + cw * h; break;
+    case image::FMT_YVU420SP: *V = c + y / 2 * cw * 2 + x / 2 * 2; *U = *V + 1; break;
+    case image::FMT_YUV420SP: *U = c + y / 2 * cw * 2 + x / 2 * 2; *V = *U + 1; break;
+    case image::FMT_YVU420P: *V = c + y / 2 * cw + x / 2; *U = *V + cw * ch; break;
+    default: *U = c + y / 2 * cw + x / 2; *V = *U + cw * ch; break;
+    }
+}
+
+/**
+ * Channel address of pixel, RGB order, or Y only for GRAYSCALE, alpha is nullptr if no alpha channel
+ */
+static void pixel_ptr(image::Image &img, int x, int y, uint8_t *c[3], uint8_t **a)
+{
+    uint8_t *p = (uint8_t *)img.data() + (y * img.width() + x) * (int)image::fmt_size[img.format()];
+    bool bgr = img.format() == image::FMT_BGR888 || img.format() == image::FMT_BGRA8888;
+    *a = has_alpha(img.format()) ? p + 3 : nullptr;
+    if (img.format() == image::FMT_GRAYSCALE)
+        c[0] = c[1] = c[2] = p;
+    else if (is_yuv(img.format()))
+        yuv_ptr(img, x, y, &c[0], &c[1], &c[2]);
+    else
+    {
+        c[0] = bgr ? p + 2 : p;
+        c[1] = p + 1;
+        c[2] = bgr ? p : p + 2;
+    }
+}
+
+/**
+ * Source pixel in color space of dst format, float BT.601
+ */
+static void get_pixel(image::Image &src, int x, int y, image::Format dst_format, float c[3], float *a)
+{
+    uint8_t *p[3], *pa;
+    pixel_ptr(src, x, y, p, &pa);
+    float v0 = *p[0], v1 = *p[1], v2 = *p[2];
+    *a = pa ? *pa : 255;
+    c[0] = v0, c[1] = v1, c[2] = v2;
+    image::Format sf = src.format();
+    if (sf == image::FMT_GRAYSCALE && is_yuv(dst_format))
+        c[1] = c[2] = 128;
+    else if (!is_yuv(sf) && sf != image::FMT_GRAYSCALE && dst_format == image::FMT_GRAYSCALE)
+        c[0] = (v0 * 38 + v1 * 75 + v2 * 15) / 128;
+    else if (!is_yuv(sf) && sf != image::FMT_GRAYSCALE && is_yuv(dst_format))
+    {
+        c[0] = 16 + (66 * v0 + 129 * v1 + 25 * v2) / 256;
+        c[1] = 128 + (-38 * v0 - 74 * v1 + 112 * v2) / 256;
+        c[2] = 128 + (112 * v0 - 94 * v1 - 18 * v2) / 256;
+    }
+    else if (is_yuv(sf) && !is_yuv(dst_format) && dst_format != image::FMT_GRAYSCALE)
+    {
+        float yy = std::max(v0 - 16, 0.f) * 1.164f;
+        c[0] = std::min(std::max(yy + 1.596f * (v2 - 128), 0.f), 255.f);
+        c[1] = std::min(std::max(yy - 0.391f * (v1 - 128) - 0.813f * (v2 - 128), 0.f), 255.f);
+        c[2] = std::min(std::max(yy + 2.018f * (v1 - 128), 0.f), 255.f);
+    }
+}
+
+static uint8_t blend(uint8_t d, float c, float a, image::BlendMode mode)
+{
+    float p = c * a / 255;
+    float v = p + d * (255 - a) / 255;
+    if (mode == image::BLEND_ADD)
+        v = std::min(d + p, 255.f);
+    else if (mode == image::BLEND_MULTIPLY)
+        v = d * (p + 255 - a) / 255;
+    return (uint8_t)lrintf(v);
+}
+
+/**
+ * Float reference of draw_image, pixel by pixel, chroma of YUV averaged in subsample blocks
+ */
+static void ref_draw_image(image::Image &dst, int x, int y, image::Image &src, image::BlendMode mode, float alpha)
+{
+    image::Format fmt = dst.format();
+    int sub_y = is_yuv422(fmt) ? 1 : 2;
+    if (is_yuv(fmt))
+    {
+        x &= ~1;
+        y &= ~(sub_y - 1);
+    }
+    auto src_pixel = [&](int dx, int dy, float c[3], float *a) {
+        int sx = dx - x, sy = dy - y;
+        if (sx < 0 || sy < 0 || sx >= src.width() || sy >= src.height())
+            return false;
+        get_pixel(src, sx, sy, fmt, c, a);
+        *a *= alpha;
+        return true;
+    };
+    for (int dy = 0; dy < dst.height(); ++dy)
+    {
+        for (int dx = 0; dx < dst.width(); ++dx)
+        {
+            float c[3], a;
+            if (!src_pixel(dx, dy, c, &a))
+                continue;
+            uint8_t *p[3], *pa;
+            pixel_ptr(dst, dx, dy, p, &pa);
+            if (a > 0)
+            {
+                if (fmt == image::FMT_GRAYSCALE || is_yuv(fmt))
+                    *p[0] = blend(*p[0], c[0], a, mode);
+                else
+                {
+                    for (int i = 0; i < 3; ++i)
+                        *p[i] = blend(*p[i], c[i], a, mode);
+                }
+                if (pa)
+                    *pa = blend(*pa, 255, a, mode);
+            }
+            if (!is_yuv(fmt) || dx % 2 || dy % sub_y)
+                continue;
+            float sum_a = 0, sum_u = 0, sum_v = 0;
+            int n = 0;
+            for (int yy = dy; yy < std::min(dy + sub_y, dst.height()); ++yy)
+            {
+                for (int xx = dx; xx < std::min(dx + 2, dst.width()); ++xx)
+                {
+                    float c2[3], a2;
+                    if (!src_pixel(xx, yy, c2, &a2))
+                        continue;
+                    sum_a += a2;
+                    sum_u += c2[1] * a2;
+                    sum_v += c2[2] * a2;
+                    ++n;
+                }
+            }
+            float a_avg = sum_a / n;
+            if (a_avg > 0)
+            {
+                *p[1] = blend(*p[1], sum_u / n / a_avg, a_avg, image::BLEND_SRC_OVER);
+                *p[2] = blend(*p[2], sum_v / n / a_avg, a_avg, image::BLEND_SRC_OVER);
+            }
+        }
+    }
+}
+
+static void test_draw_image()
+{
+    image::Format srcs[] = {image::FMT_RGBA8888, image::FMT_BGRA8888, image::FMT_RGB888, image::FMT_BGR888, image::FMT_GRAYSCALE, image::FMT_YVU420SP};
+    image::BlendMode modes[] = {image::BLEND_SRC_OVER, image::BLEND_ADD, image::BLEND_MULTIPLY};
+    int points[][2] = {{0, 0}, {13, 7}, {-9, -5}, {90, 60}, {-200, 0}, {37, -3}}; // include clipped and out of image
+    float alphas[] = {1, 0.5};
+    for (image::Format df : formats)
+    {
+        for (image::Format sf : srcs)
+        {
+            int fails_before = test::fails;
+            for (image::BlendMode mode : modes)
+            {
+                for (auto &point : points)
+                {
+                    for (float alpha : alphas)
+                    {
+                        int w = is_yuv(df) ? 100 : 101; // odd size for formats without subsample
+                        image::Image a(w, 70, df), b(w, 70, df);
+                        image::Image src(44, 34, sf);
+                        fill_random(a, 1);
+                        memcpy(b.data(), a.data(), a.data_size());
+                        fill_random(src, 2);
+                        a.draw_image(point[0], point[1], src, mode, alpha);
+                        ref_draw_image(b, point[0], point[1], src, mode, alpha);
+                        // integer rounding and color conversion differ 2 at most
+                        CHECK(test::max_diff(a, b) <= 2);
+                    }
+                }
+            }
+            if (test::fails != fails_before)
+                log::error("draw %s on %s failed", image::fmt_names[sf].c_str(), image::fmt_names[df].c_str());
+        }
+    }
+
+    bool caught = false;
+    try
+    {
+        image::Image a(64, 64, image::FMT_RGB565), b(16, 16, image::FMT_RGBA8888);
+        a.draw_image(0, 0, b);
+    }
+    catch (err::Exception &e)
+    {
+        caught = true;
+    }
+    CHECK(caught);
+}
+
+static void test_overlay_layers()
+{
+    image::Format overlay_formats[] = {image::FMT_RGB888, image::FMT_RGBA8888, image::FMT_GRAYSCALE, image::FMT_YVU420SP, image::FMT_YUV420P};
+    for (image::Format fmt : overlay_formats)
+    {
+        image::Image a(320, 240, fmt), b(320, 240, fmt);
+        image::Image l1(100, 50, image::FMT_RGBA8888), l2(64, 64, image::FMT_BGRA8888), l3(40, 30, image::FMT_RGB888);
+        fill_random(a, 3);
+        memcpy(b.data(), a.data(), a.data_size());
+        fill_random(l1, 4);
+        fill_random(l2, 5);
+        fill_random(l3, 6);
+        // only left bottom corner of l2 is visible
+        uint8_t *p = (uint8_t *)l2.data();
+        for (int y = 0; y < 64; ++y)
+        {
+            for (int x = 0; x < 64; ++x)
+            {
+                if (y <= 40 || x >= 20)
+                    p[(y * 64 + x) * 4 + 3] = 0;
+            }
+        }
+
+        image::Overlay overlay(320, 240, fmt);
+        int id1 = overlay.add_layer(l1, 10, 10);
+        int id2 = overlay.add_layer(l2, 290, 200, image::BLEND_ADD, 0.8);
+        int id3 = overlay.add_layer(l3, -11, 101, image::BLEND_MULTIPLY);
+        CHECK(id1 >= 0 && id2 >= 0 && id3 >= 0);
+        CHECK(overlay.composite(a) == err::ERR_NONE);
+        b.draw_image(10, 10, l1);
+        b.draw_image(290, 200, l2, image::BLEND_ADD, 0.8);
+        b.draw_image(-11, 101, l3, image::BLEND_MULTIPLY);
+        CHECK(test::max_diff(a, b) == 0);
+        std::vector<std::vector<int>> rects = overlay.dirty_rects();
+        CHECK(rects.size() == 3);
+        if (rects.size() == 3)
+            CHECK(rects[1][0] == 290 && rects[1][1] >= 232 && rects[1][2] == 30);
+
+        // update part of layer, the same as a new layer
+        uint8_t *q = (uint8_t *)l1.data();
+        for (int y = 5; y < 20; ++y)
+        {
+            for (int x = 33; x < 60; ++x)
+            {
+                q[(y * 100 + x) * 4] = 10;
+                q[(y * 100 + x) * 4 + 3] = 200;
+            }
+        }
+        CHECK(overlay.update_layer(id1, l1, {33, 5, 27, 15}) == err::ERR_NONE);
+        CHECK(overlay.move_layer(id3, -10, 100) == err::ERR_NONE);
+        fill_random(a, 3);
+        memcpy(b.data(), a.data(), a.data_size());
+        overlay.composite(a);
+        b.draw_image(10, 10, l1);
+        b.draw_image(290, 200, l2, image::BLEND_ADD, 0.8);
+        b.draw_image(-10, 100, l3, image::BLEND_MULTIPLY);
+        CHECK(test::max_diff(a, b) == 0);
+
+        CHECK(overlay.show_layer(id2, false) == err::ERR_NONE);
+        CHECK(overlay.remove_layer(id3) == err::ERR_NONE);
+        CHECK(overlay.remove_layer(id3) == err::ERR_ARGS);
+        CHECK(overlay.dirty_rects().size() == 1);
+        image::Image other(160, 120, fmt);
+        CHECK(overlay.composite(other) == err::ERR_ARGS);
+    }
+}
+
+/**
+ * draw_image before premultiplied kernels, convert whole image then blend pixel by pixel
+ */
+static void old_draw_image(image::Image &dst, int x, int y, image::Image &img)
+{
+    image::Image *src = img.format() == dst.format() ? &img : img.to_format(dst.format());
+    uint8_t *s = (uint8_t *)src->data();
+    uint8_t *d = (uint8_t *)dst.data();
+    for (int i = 0; i < src->height() && i + y < dst.height(); ++i)
+    {
+        for (int j = 0; j < src->width() && j + x < dst.width(); ++j)
+        {
+            uint8_t *ps = s + (i * src->width() + j) * 4;
+            uint8_t *pd = d + ((i + y) * dst.width() + j + x) * 4;
+            if (ps[3] == 0)
+                continue;
+            if (ps[3] == 255)
+            {
+                memcpy(pd, ps, 4);
+                continue;
+            }
+            for (int k = 0; k < 3; ++k)
+                pd[k] = (ps[k] * ps[3] + pd[k] * (255 - ps[3])) >> 8;
+            pd[3] = 255 - (255 - ps[3]) * (255 - pd[3]);
+        }
+    }
+    if (src != &img)
+        delete src;
+}
+
+/**
+ * Camera UI, full screen RGBA8888 layer with top and bottom bars and a side panel, and a logo
+ */
+static void bench(int w, int h, image::Format fmt, int loop)
+{
+    image::Image frame(w, h, fmt), ui(w, h, image::FMT_RGBA8888), logo(200, 80, image::FMT_RGBA8888);
+    fill_random(frame, 1);
+    fill_random(logo, 2);
+    memset(ui.data(), 0, ui.data_size());
+    uint8_t *p = (uint8_t *)ui.data();
+    for (int y = 0; y < h; ++y)
+    {
+        for (int x = 0; x < w; ++x)
+        {
+            if (y < 48 || y >= h - 48 || (x >= w - 160 && y < h / 2))
+            {
+                p[(y * w + x) * 4] = 40;
+                p[(y * w + x) * 4 + 3] = 160;
+            }
+        }
+    }
+    image::Overlay overlay(w, h, fmt);
+    overlay.add_layer(ui);
+    overlay.add_layer(logo, 20, h - 120);
+
+    std::string old_str = "not support";
+    if (fmt == image::FMT_RGBA8888)
+    {
+        double t_old = test::time_ms(loop, [&]() {
+            old_draw_image(frame, 0, 0, ui);
+            old_draw_image(frame, 20, h - 120, logo);
+        });
+        old_str = std::to_string(t_old) + " ms";
+    }
+    double t_draw = test::time_ms(loop, [&]() {
+        frame.draw_image(0, 0, ui);
+        frame.draw_image(20, h - 120, logo);
+    });
+    double t_overlay = test::time_ms(loop, [&]() {
+        overlay.composite(frame);
+    });
+    log::info("%dx%d %s, old draw_image %s, draw_image %.3f ms, overlay %.3f ms(%d dirty rects)",
+              w, h, image::fmt_names[fmt].c_str(), old_str.c_str(), t_draw, t_overlay, (int)overlay.dirty_rects().size());
+}
+
+void test_overlay()
+{
+    test_draw_image();
+    test_overlay_layers();
+    if (!test::bench)
+        return;
+
+    int loop = test::arg_int("loop", 20);
+    image::Format bench_formats[] = {image::FMT_RGBA8888, image::FMT_RGB888, image::FMT_YVU420SP};
+    for (image::Format fmt : bench_formats)
+    {
+        bench(640, 480, fmt, loop);
+        bench(1280, 720, fmt, loop);
+    }
+}
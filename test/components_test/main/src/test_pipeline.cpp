@@ -0,0 +1,139 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_pipeline.hpp"
+#include "test.hpp"
+
+using namespace maix;
+
+/**
+ * Test pipeline frame order, queue policies and stop, then compare serial loop and pipeline
+ * with simulated capture, infer and render stages.
+ */
+
+/**
+ * Source generate num frames, then return err::ERR_CANCEL
+ */
+static pipeline::StageFunc counter_source(int num, int cost_ms)
+{
+    std::shared_ptr<int> count = std::make_shared<int>(0);
+    return [count, num, cost_ms](pipeline::Frame &frame) {
+        if (*count >= num)
+            return err::ERR_CANCEL;
+        ++*count;
+        if (cost_ms > 0)
+            time::sleep_ms(cost_ms);
+        frame.img = new image::Image(32, 32, image::FMT_GRAYSCALE);
+        return err::ERR_NONE;
+    };
+}
+
+static void test_block()
+{
+    const int num = 100;
+    std::vector<uint64_t> seqs;
+    pipeline::Pipeline p;
+    p.set_source("source", counter_source(num, 0));
+    p.add_stage("infer", [](pipeline::Frame &frame) {
+        frame.set_result(new std::vector<int>(1, (int)frame.seq));
+        return frame.seq == 50 ? err::ERR_RUNTIME : err::ERR_NONE; // drop one frame
+    }, 1);
+    p.add_stage("sink", [&seqs](pipeline::Frame &frame) {
+        std::vector<int> *result = frame.result<std::vector<int>>();
+        if (!result || (*result)[0] != (int)frame.seq)
+            return err::ERR_ARGS;
+        seqs.push_back(frame.seq);
+        return err::ERR_NONE;
+    }, 2);
+    CHECK(p.add_stage("bad", nullptr, 0) == err::ERR_ARGS);
+    CHECK(p.start() == err::ERR_NONE);
+    CHECK(p.start() == err::ERR_BUSY);
+    CHECK(p.wait(10000) == err::ERR_NONE);
+    CHECK(!p.is_running());
+    CHECK(seqs.size() == num - 1);
+    for (size_t i = 1; i < seqs.size(); ++i)
+        CHECK(seqs[i] > seqs[i - 1]);
+    std::vector<pipeline::StageStats> stats = p.stats();
+    CHECK(stats.size() == 3 && stats[0].frames == num && stats[1].dropped == 1 && stats[2].frames == num - 1 && stats[2].dropped == 0);
+}
+
+static void test_drop_oldest()
+{
+    const int num = 60;
+    std::vector<uint64_t> seqs;
+    pipeline::Pipeline p;
+    p.set_source("source", counter_source(num, 1));
+    p.add_stage("slow_sink", [&seqs](pipeline::Frame &frame) {
+        time::sleep_ms(10);
+        seqs.push_back(frame.seq);
+        return err::ERR_NONE;
+    }, 2, pipeline::QUEUE_DROP_OLDEST);
+    p.start();
+    CHECK(p.wait(10000) == err::ERR_NONE);
+    std::vector<pipeline::StageStats> stats = p.stats();
+    CHECK(seqs.size() < num && seqs.size() + stats[1].dropped == num);
+    CHECK(!seqs.empty() && seqs.back() == num - 1); // latest frame always processed
+    for (size_t i = 1; i < seqs.size(); ++i)
+        CHECK(seqs[i] > seqs[i - 1]);
+}
+
+static void test_stop()
+{
+    pipeline::Pipeline p;
+    p.set_source("source", counter_source(1000000, 0));
+    p.add_stage("sink", [](pipeline::Frame &frame) {
+        time::sleep_ms(1);
+        return err::ERR_NONE;
+    }, 4);
+    p.start();
+    time::sleep_ms(100);
+    CHECK(p.wait(10) == err::ERR_TIMEOUT);
+    CHECK(p.stop() == err::ERR_NONE && !p.is_running());
+    // restart
+    CHECK(p.start() == err::ERR_NONE);
+    time::sleep_ms(50);
+    p.stop();
+    CHECK(p.stats()[1].frames > 0);
+}
+
+static void bench(int frames, int capture_ms, int infer_ms, int render_ms)
+{
+    uint64_t t = time::ticks_ms();
+    for (int i = 0; i < frames && !app::need_exit(); ++i)
+    {
+        time::sleep_ms(capture_ms);
+        time::sleep_ms(infer_ms);
+        time::sleep_ms(render_ms);
+    }
+    float fps_serial = frames * 1000.0f / (time::ticks_ms() - t);
+
+    pipeline::Pipeline p;
+    p.set_source("capture", counter_source(frames, capture_ms));
+    p.add_stage("infer", [infer_ms](pipeline::Frame &frame) {
+        time::sleep_ms(infer_ms);
+        return err::ERR_NONE;
+    });
+    p.add_stage("render", [render_ms](pipeline::Frame &frame) {
+        time::sleep_ms(render_ms);
+        return err::ERR_NONE;
+    });
+    t = time::ticks_ms();
+    p.start();
+    p.wait();
+    float fps_pipeline = frames * 1000.0f / (time::ticks_ms() - t);
+    log::info("capture %d ms, infer %d ms, render %d ms: serial %.1f fps, pipeline %.1f fps, slowest stage %.1f fps",
+              capture_ms, infer_ms, render_ms, fps_serial, fps_pipeline, 1000.0f / std::max(capture_ms, std::max(infer_ms, render_ms)));
+    log::info("\n%s", p.stats_str().c_str());
+}
+
+void test_pipeline()
+{
+    test_block();
+    test_drop_oldest();
+    test_stop();
+    if (!test::bench)
+        return;
+
+    int frames = test::arg_int("frames", 100);
+    bench(frames, 10, 30, 10);
+    bench(frames, 15, 15, 15);
+}
@@ -0,0 +1,130 @@
+
+#include "maix_basic.hpp"
+#include "maix_protocol.hpp"
+#include "test.hpp"
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace maix;
+
+/**
+ * Test maix.protocol encode ways get the same frame, and benchmark them, compare bitwise CRC16 and slice by 8 CRC16,
+ * and Bytes encode(allocate per message), buffer encode, FrameRing encode, scatter-gather encode.
+ */
+
+static uint16_t crc16_IBM_bitwise(uint8_t *ptr, size_t len)
+{
+    uint16_t crc = 0x0000;
+    while (len--)
+    {
+        crc ^= *ptr++;
+        for (int i = 0; i < 8; ++i)
+        {
+            if (crc & 1)
+                crc = (crc >> 1) ^ 0xA001;
+            else
+                crc = (crc >> 1);
+        }
+    }
+    return crc;
+}
+
+static void print_result(const char *name, int body_len, int count, uint64_t t_us)
+{
+    if (t_us == 0)
+        t_us = 1;
+    double msgs = count * 1000000.0 / t_us;
+    log::info("%-16s body %5d: %10.0f msg/s, %8.1f MB/s", name, body_len, msgs, msgs * (body_len + 12) / 1024 / 1024);
+}
+
+void test_protocol()
+{
+    int body_lens[] = {16, 256, 4096};
+    uint8_t cmd = 1;
+    uint8_t flags = protocol::FLAG_RESP | protocol::FLAG_RESP_OK | protocol::FLAG_REPORT;
+    std::vector<uint8_t> body(4096);
+    for (auto &b : body)
+        b = rand();
+    std::vector<uint8_t> buff(4096 + 13);
+    protocol::FrameRing ring(64 * 1024);
+
+    // bitwise CRC and all encode ways should get the same frame
+    for (int len : body_lens)
+    {
+        CHECK(crc16_IBM_bitwise(body.data(), len) == protocol::crc16_IBM(body.data(), len));
+        int n = protocol::encode(buff.data(), buff.size(), cmd, flags, body.data(), len);
+        CHECK(n == len + 12);
+        uint8_t head[11], tail[2];
+        int head_len = protocol::encode_head_tail(head, tail, cmd, flags, body.data(), len);
+        CHECK(head_len + len + 2 == n);
+        CHECK(head_len > 0 && memcmp(head, buff.data(), head_len) == 0 && memcmp(tail, buff.data() + n - 2, 2) == 0);
+        ring.clear();
+        uint8_t *data;
+        CHECK(ring.encode(cmd, flags, body.data(), len) == n && ring.peek(&data) == n && memcmp(data, buff.data(), n) == 0);
+    }
+    if (!test::bench)
+        return;
+
+    int out_fd = open("/dev/null", O_WRONLY);
+    for (int len : body_lens)
+    {
+        int count = 4 * 1024 * 1024 / (len + 12);
+        uint64_t t;
+        volatile uint16_t crc = 0;
+
+        t = time::ticks_us();
+        for (int i = 0; i < count; ++i)
+            crc = crc + crc16_IBM_bitwise(body.data(), len);
+        print_result("crc bitwise", len, count, time::ticks_us() - t);
+
+        t = time::ticks_us();
+        for (int i = 0; i < count; ++i)
+            crc = crc + protocol::crc16_IBM(body.data(), len);
+        print_result("crc slice by 8", len, count, time::ticks_us() - t);
+
+        // allocate Bytes every message, the way MaixPy API works
+        protocol::Protocol p;
+        t = time::ticks_us();
+        for (int i = 0; i < count; ++i)
+        {
+            Bytes *data = p.encode_report(cmd, body.data(), len);
+            delete data;
+        }
+        print_result("encode Bytes", len, count, time::ticks_us() - t);
+
+        t = time::ticks_us();
+        for (int i = 0; i < count; ++i)
+            protocol::encode(buff.data(), buff.size(), cmd, flags, body.data(), len);
+        print_result("encode buffer", len, count, time::ticks_us() - t);
+
+        // encode to ring, send(write to /dev/null) when full
+        ring.clear();
+        t = time::ticks_us();
+        for (int i = 0; i < count; ++i)
+        {
+            while (ring.encode(cmd, flags, body.data(), len) == -err::ERR_BUFF_FULL)
+            {
+                uint8_t *data;
+                int n = ring.peek(&data);
+                ssize_t ret = write(out_fd, data, n);
+                ring.consume(ret > 0 ? ret : n);
+            }
+        }
+        print_result("encode ring", len, count, time::ticks_us() - t);
+
+        // encode head and tail, send with body by writev
+        uint8_t head[11], tail[2];
+        t = time::ticks_us();
+        for (int i = 0; i < count; ++i)
+        {
+            int head_len = protocol::encode_head_tail(head, tail, cmd, flags, body.data(), len);
+            struct iovec iov[3] = {{head, (size_t)head_len}, {body.data(), (size_t)len}, {tail, 2}};
+            ssize_t ret = writev(out_fd, iov, 3);
+            (void)ret;
+        }
+        print_result("scatter-gather", len, count, time::ticks_us() - t);
+        (void)crc;
+    }
+    close(out_fd);
+}
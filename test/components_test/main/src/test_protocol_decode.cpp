@@ -0,0 +1,258 @@
+#include "maix_basic.hpp"
+#include "maix_protocol.hpp"
+#include "test.hpp"
+
+using namespace maix;
+
+/**
+ * Fuzz test protocol::Protocol decode, and benchmark the old linear buffer decoder and the ring buffer decoder.
+ */
+
+struct frame_t
+{
+    uint8_t cmd;
+    uint8_t flags;
+    std::vector<uint8_t> body;
+};
+
+/**
+ * Old decoder, linear buffer, alloc MSG every call, rescan from start and memmove after every frame.
+ */
+class OldDecoder
+{
+public:
+    OldDecoder(int size) : _buff(size), _data_len(0) {}
+
+    err::Err push_data(const uint8_t *data, int len)
+    {
+        if (_data_len + len > (int)_buff.size())
+            return err::ERR_BUFF_FULL;
+        memcpy(_buff.data() + _data_len, data, len);
+        _data_len += len;
+        return err::ERR_NONE;
+    }
+
+    protocol::MSG *decode()
+    {
+        protocol::MSG *frame = new protocol::MSG();
+        int idx = 0;
+        bool ok = _get_msg(_buff.data(), _data_len, frame, &idx);
+        if (idx > 0)
+        {
+            memmove(_buff.data(), _buff.data() + idx, _data_len - idx);
+            _data_len -= idx;
+        }
+        if (ok)
+            return frame;
+        delete frame;
+        return nullptr;
+    }
+
+private:
+    std::vector<uint8_t> _buff;
+    int _data_len;
+
+    bool _get_msg(uint8_t *data, int len, protocol::MSG *frame, int *idx)
+    {
+        uint32_t header = protocol::HEADER;
+        *idx = 0;
+        if (len < 12)
+            return false;
+        uint32_t i = 0;
+        bool found = false;
+        for (; i < (uint32_t)len - 4; i++)
+        {
+            if (data[i] == (header & 0xFF) && data[i + 1] == ((header >> 8) & 0xFF) &&
+                data[i + 2] == ((header >> 16) & 0xFF) && data[i + 3] == ((header >> 24) & 0xFF))
+            {
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+        {
+            *idx = i;
+            return false;
+        }
+        if (len - i < 12)
+            return false;
+        size_t data_len = data[i + 4] | (data[i + 5] << 8) | (data[i + 6] << 16) | (data[i + 7] << 24);
+        if (data_len > len - i - 8)
+            return false;
+        *idx = i + 8 + data_len;
+        uint16_t crc16 = protocol::crc16_IBM(data + i, data_len + 6);
+        if (data[i + 6 + data_len] != (crc16 & 0xFF) || data[i + 7 + data_len] != (crc16 >> 8 & 0xFF))
+            return false;
+        frame->is_resp = data[i + 8] & protocol::FLAG_IS_RESP_MASK;
+        frame->cmd = data[i + 9];
+        frame->set_body(data + i + 10, data_len - 4);
+        return true;
+    }
+};
+
+static void append_frame(std::vector<uint8_t> &stream, const frame_t &f)
+{
+    size_t pos = stream.size();
+    stream.resize(pos + f.body.size() + 12);
+    protocol::encode(stream.data() + pos, f.body.size() + 12, f.cmd, f.flags, (uint8_t *)f.body.data(), f.body.size());
+}
+
+/**
+ * generate valid frames mixed with garbage, fake headers and corrupted frames
+ */
+static void gen_stream(std::vector<uint8_t> &stream, std::vector<frame_t> &frames, int num, int max_body, int buff_size)
+{
+    uint8_t header[4] = {(uint8_t)(protocol::HEADER & 0xFF), (uint8_t)(protocol::HEADER >> 8 & 0xFF),
+                         (uint8_t)(protocol::HEADER >> 16 & 0xFF), (uint8_t)(protocol::HEADER >> 24 & 0xFF)};
+    for (int i = 0; i < num; ++i)
+    {
+        int r = rand() % 10;
+        if (r == 0)
+        {
+            // garbage, sometimes with part of header
+            int n = rand() % 64;
+            for (int k = 0; k < n; ++k)
+                stream.push_back(rand() % 4 == 0 ? header[rand() % 4] : rand());
+        }
+        else if (r == 1)
+        {
+            // fake header with random length, not longer than buffer
+            stream.insert(stream.end(), header, header + 4);
+            uint32_t len = rand() % (buff_size - 8);
+            for (int k = 0; k < 4; ++k)
+                stream.push_back(len >> (k * 8) & 0xFF);
+        }
+        else if (r == 2)
+        {
+            // corrupted frame
+            frame_t f = {(uint8_t)rand(), (uint8_t)(rand() & 0xE3), std::vector<uint8_t>(rand() % (max_body + 1))};
+            append_frame(stream, f);
+            stream[stream.size() - 1 - rand() % (f.body.size() + 4)] ^= 0x5A;
+        }
+        frame_t f = {(uint8_t)rand(), (uint8_t)(rand() & 0xE3), std::vector<uint8_t>(rand() % (max_body + 1))};
+        for (auto &b : f.body)
+            b = rand();
+        append_frame(stream, f);
+        frames.push_back(f);
+    }
+    // fake header at the end waits for data, padding to let it complete
+    stream.insert(stream.end(), buff_size, 0);
+}
+
+static bool check_msg(protocol::MSG *msg, const frame_t &f)
+{
+    return msg->cmd == f.cmd && msg->is_resp == (bool)(f.flags & protocol::FLAG_IS_RESP_MASK) &&
+           msg->body_len == (int)f.body.size() && memcmp(msg->body, f.body.data(), f.body.size()) == 0;
+}
+
+/**
+ * feed stream in random chunks, return decoded frames count, -1 if frames not match
+ */
+static int fuzz_once(int buff_size, bool batch)
+{
+    std::vector<uint8_t> stream;
+    std::vector<frame_t> frames;
+    gen_stream(stream, frames, 200, 300, buff_size);
+    protocol::Protocol p(buff_size);
+    size_t pos = 0, idx = 0;
+    while (pos < stream.size() || p.data_len() > 0)
+    {
+        int n = std::min((int)(stream.size() - pos), 1 + rand() % 700);
+        n = std::min(n, p.buff_size() - p.data_len());
+        if (batch)
+        {
+            const std::vector<protocol::MSG *> &msgs = p.decode_all(stream.data() + pos, n);
+            for (auto msg : msgs)
+            {
+                if (idx >= frames.size() || !check_msg(msg, frames[idx]))
+                    return -1;
+                ++idx;
+            }
+        }
+        else
+        {
+            protocol::MSG *msg = p.decode(stream.data() + pos, n);
+            while (msg)
+            {
+                bool ok = idx < frames.size() && check_msg(msg, frames[idx]);
+                delete msg;
+                if (!ok)
+                    return -1;
+                ++idx;
+                msg = p.decode((uint8_t *)nullptr, 0);
+            }
+        }
+        pos += n;
+        if (n == 0 && pos >= stream.size())
+            break;
+    }
+    return idx == frames.size() ? (int)idx : -1;
+}
+
+static void print_result(const char *name, int chunk, size_t bytes, int frames, uint64_t t_us)
+{
+    if (t_us == 0)
+        t_us = 1;
+    log::info("%-6s chunk %6d: %8.1f MB/s, %10.0f frames/s", name, chunk, bytes * 1.0 / t_us, frames * 1000000.0 / t_us);
+}
+
+void test_protocol_decode()
+{
+    int rounds = test::arg_int("rounds", 200);
+    int buff_sizes[] = {1024, 4096, 64 * 1024};
+    for (int buff_size : buff_sizes)
+    {
+        for (int batch = 0; batch < 2; ++batch)
+        {
+            int total = 0;
+            for (int i = 0; i < rounds && !app::need_exit(); ++i)
+            {
+                int n = fuzz_once(buff_size, batch);
+                CHECK(n >= 0);
+                if (n < 0)
+                {
+                    log::error("fuzz failed, buff size %d, %s, round %d", buff_size, batch ? "decode_all" : "decode", i);
+                    return;
+                }
+                total += n;
+            }
+            log::info("fuzz buff size %6d %-10s: %d rounds, %d frames ok", buff_size, batch ? "decode_all" : "decode", rounds, total);
+        }
+    }
+    if (!test::bench)
+        return;
+
+    // benchmark, 64 bytes body, push chunk size from 64 bytes to 32KB
+    std::vector<uint8_t> stream;
+    int frame_num = 20000;
+    for (int i = 0; i < frame_num; ++i)
+    {
+        frame_t f = {1, protocol::FLAG_REQ, std::vector<uint8_t>(64, (uint8_t)i)};
+        append_frame(stream, f);
+    }
+    int chunks[] = {64, 1024, 8192, 32768};
+    for (int chunk : chunks)
+    {
+        OldDecoder old(64 * 1024);
+        int frames = 0;
+        uint64_t t = time::ticks_us();
+        for (size_t pos = 0; pos < stream.size(); pos += chunk)
+        {
+            old.push_data(stream.data() + pos, std::min((size_t)chunk, stream.size() - pos));
+            protocol::MSG *msg;
+            while ((msg = old.decode()) != nullptr)
+            {
+                ++frames;
+                delete msg;
+            }
+        }
+        print_result("old", chunk, stream.size(), frames, time::ticks_us() - t);
+
+        protocol::Protocol p(64 * 1024);
+        frames = 0;
+        t = time::ticks_us();
+        for (size_t pos = 0; pos < stream.size(); pos += chunk)
+            frames += p.decode_all(stream.data() + pos, std::min((size_t)chunk, stream.size() - pos)).size();
+        print_result("ring", chunk, stream.size(), frames, time::ticks_us() - t);
+    }
+}
@@ -0,0 +1,463 @@
+#include "maix_basic.hpp"
+#include "maix_vision.hpp"
+#include "maix_rtsp.hpp"
+#include "test.hpp"
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <poll.h>
+
+using namespace maix;
+
+/**
+ * Test rtsp::Rtsp server with in-process clients over RTP/TCP(interleaved) and RTP/UDP,
+ * frames are synthetic H.264 access units carry frame index and send time, so clients can check
+ * integrity, order and latency. A slow client should skip frames until next IDR without affecting others.
+ */
+
+static const int port = 18554;
+static const int gop = 15;
+
+/**
+ * Synthetic H.264 access unit, only first frame carry SPS and PPS, so server should send cached
+ * parameter sets to clients joined later. Slice payload: 16 hex chars of index, 16 hex chars of time, then filler.
+ * No zero byte in payload, so there is no start code emulation.
+ */
+static std::vector<uint8_t> make_frame(int idx, int size)
+{
+    std::vector<uint8_t> f;
+    const uint8_t start[] = {0, 0, 0, 1};
+    bool idr = idx % gop == 0;
+    if (idx == 0)
+    {
+        const uint8_t sps[] = {0x67, 0x42, 0xC0, 0x1F, 0xDA, 0x01, 0x40, 0x16, 0xEC, 0x04};
+        const uint8_t pps[] = {0x68, 0xCE, 0x3C, 0x80};
+        f.insert(f.end(), start, start + 4);
+        f.insert(f.end(), sps, sps + sizeof(sps));
+        f.insert(f.end(), start, start + 4);
+        f.insert(f.end(), pps, pps + sizeof(pps));
+    }
+    f.insert(f.end(), start, start + 4);
+    f.push_back(idr ? 0x65 : 0x41);
+    char head[40];
+    snprintf(head, sizeof(head), "%016llx%016llx", (unsigned long long)idx, (unsigned long long)time::ticks_us());
+    f.insert(f.end(), head, head + 32);
+    int filler = (idr ? size * 4 : size) - 33;
+    for (int i = 0; i < filler; ++i)
+        f.push_back((uint8_t)((i * 7 + idx) % 255 + 1));
+    return f;
+}
+
+static bool check_filler(const uint8_t *p, int len, int idx)
+{
+    for (int i = 0; i < len; ++i)
+    {
+        if (p[i] != (uint8_t)((i * 7 + idx) % 255 + 1))
+            return false;
+    }
+    return true;
+}
+
+class TestClient
+{
+public:
+    std::string name;
+    bool tcp;
+    int recv_buf;
+    int pause_ms;                   // stop reading after first frame, simulate slow client
+    std::vector<int> frames;        // index of complete frames received
+    std::vector<bool> idr;
+    std::vector<uint64_t> latency;  // us, from make_frame to last packet received
+    int broken = 0;
+    bool sps_before_idr = true;
+    bool setup_ok = false;
+
+    TestClient(const std::string &name, bool tcp, int recv_buf = 0, int pause_ms = 0)
+        : name(name), tcp(tcp), recv_buf(recv_buf), pause_ms(pause_ms) {}
+
+    void start() { _thread = std::thread([this]() { run(); }); }
+
+    void stop()
+    {
+        _stop = true;
+        _thread.join();
+    }
+
+private:
+    std::thread _thread;
+    std::atomic<bool> _stop{false};
+    int _fd = -1, _udp = -1, _cseq = 0;
+    std::string _in;
+    std::vector<uint8_t> _nal;
+    std::vector<std::vector<uint8_t>> _au;
+    bool _au_broken = false;
+    bool _have_seq = false;
+    uint16_t _seq = 0;
+    bool _have_sps = false, _have_pps = false;
+
+    std::string request(const std::string &method, const std::string &extra)
+    {
+        std::string req = method + " rtsp://127.0.0.1:" + std::to_string(port) + "/live" + (method == "SETUP" ? "/track0" : "") +
+                          " RTSP/1.0\r\nCSeq: " + std::to_string(++_cseq) + "\r\n" + extra + "\r\n";
+        if (send(_fd, req.data(), req.size(), MSG_NOSIGNAL) != (ssize_t)req.size())
+            return "";
+        // response header and body
+        while (true)
+        {
+            size_t end = _in.find("\r\n\r\n");
+            if (end != std::string::npos)
+            {
+                size_t body = 0;
+                size_t pos = _in.find("Content-Length:");
+                if (pos != std::string::npos && pos < end)
+                    body = atoi(_in.c_str() + pos + 15);
+                if (_in.size() >= end + 4 + body)
+                {
+                    std::string resp = _in.substr(0, end + 4 + body);
+                    _in.erase(0, end + 4 + body);
+                    return resp;
+                }
+            }
+            char buf[4096];
+            ssize_t n = recv(_fd, buf, sizeof(buf), 0);
+            if (n <= 0)
+                return "";
+            _in.append(buf, n);
+        }
+    }
+
+    void on_access_unit()
+    {
+        int slice_idx = -1;
+        bool is_idr = false;
+        const std::vector<uint8_t> *slice = NULL;
+        for (auto &nal : _au)
+        {
+            int type = nal[0] & 0x1F;
+            if (type == 7)
+                _have_sps = true;
+            else if (type == 8)
+                _have_pps = true;
+            else if (type == 5 || type == 1)
+            {
+                slice = &nal;
+                is_idr = type == 5;
+            }
+        }
+        if (_au_broken || !slice || slice->size() < 33)
+        {
+            ++broken;
+            return;
+        }
+        std::string head((const char *)slice->data() + 1, 32);
+        slice_idx = (int)strtoull(head.substr(0, 16).c_str(), NULL, 16);
+        uint64_t t = strtoull(head.substr(16).c_str(), NULL, 16);
+        if (!check_filler(slice->data() + 33, slice->size() - 33, slice_idx))
+        {
+            ++broken;
+            return;
+        }
+        if (is_idr && !(_have_sps && _have_pps))
+            sps_before_idr = false;
+        frames.push_back(slice_idx);
+        idr.push_back(is_idr);
+        latency.push_back(time::ticks_us() - t);
+    }
+
+    void on_rtp(const uint8_t *p, int len)
+    {
+        if (len < 13)
+            return;
+        uint16_t seq = p[2] << 8 | p[3];
+        if (_have_seq && seq != (uint16_t)(_seq + 1))
+        {
+            _au_broken = true;
+            _nal.clear();
+        }
+        _have_seq = true;
+        _seq = seq;
+        bool marker = p[1] & 0x80;
+        const uint8_t *payload = p + 12;
+        int payload_len = len - 12;
+        int type = payload[0] & 0x1F;
+        if (type == 28)
+        {
+            if (payload_len < 3)
+                return;
+            bool s = payload[1] & 0x80, e = payload[1] & 0x40;
+            if (s)
+            {
+                _nal.clear();
+                _nal.push_back((payload[0] & 0xE0) | (payload[1] & 0x1F));
+            }
+            else if (_nal.empty())
+            {
+                _au_broken = true;
+            }
+            if (!_nal.empty())
+                _nal.insert(_nal.end(), payload + 2, payload + payload_len);
+            if (e && !_nal.empty())
+            {
+                _au.push_back(_nal);
+                _nal.clear();
+            }
+        }
+        else
+        {
+            _au.push_back(std::vector<uint8_t>(payload, payload + payload_len));
+        }
+        if (marker)
+        {
+            on_access_unit();
+            _au.clear();
+            _nal.clear();
+            _au_broken = false;
+        }
+    }
+
+    void run()
+    {
+        _fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (recv_buf > 0)
+            setsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &recv_buf, sizeof(recv_buf));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            close(_fd);
+            return;
+        }
+        std::string transport;
+        if (tcp)
+        {
+            transport = "Transport: RTP/AVP/TCP;unicast;interleaved=0-1\r\n";
+        }
+        else
+        {
+            _udp = socket(AF_INET, SOCK_DGRAM, 0);
+            int buf = 4 * 1024 * 1024;
+            setsockopt(_udp, SOL_SOCKET, SO_RCVBUF, &buf, sizeof(buf));
+            struct sockaddr_in local = addr;
+            local.sin_port = 0;
+            bind(_udp, (struct sockaddr *)&local, sizeof(local));
+            socklen_t len = sizeof(local);
+            getsockname(_udp, (struct sockaddr *)&local, &len);
+            int p = ntohs(local.sin_port);
+            transport = "Transport: RTP/AVP;unicast;client_port=" + std::to_string(p) + "-" + std::to_string(p + 1) + "\r\n";
+        }
+        std::string resp = request("OPTIONS", "");
+        resp = request("DESCRIBE", "Accept: application/sdp\r\n");
+        bool sdp_ok = resp.find("RTSP/1.0 200") == 0 && resp.find("a=rtpmap:96 H264/90000") != std::string::npos;
+        resp = request("SETUP", transport);
+        size_t pos = resp.find("Session: ");
+        std::string session = pos == std::string::npos ? "" : resp.substr(pos + 9, 8);
+        resp = request("PLAY", "Session: " + session + "\r\n");
+        setup_ok = sdp_ok && !session.empty() && resp.find("RTSP/1.0 200") == 0;
+
+        bool paused = false;
+        while (!_stop)
+        {
+            if (pause_ms > 0 && !paused && !frames.empty())
+            {
+                paused = true;
+                time::sleep_ms(pause_ms);
+            }
+            struct pollfd pfd = {tcp ? _fd : _udp, POLLIN, 0};
+            if (poll(&pfd, 1, 20) <= 0)
+                continue;
+            if (!tcp)
+            {
+                uint8_t buf[2048];
+                ssize_t n = recv(_udp, buf, sizeof(buf), 0);
+                if (n > 0)
+                    on_rtp(buf, n);
+                continue;
+            }
+            char buf[65536];
+            ssize_t n = recv(_fd, buf, sizeof(buf), 0);
+            if (n <= 0)
+                break;
+            _in.append(buf, n);
+            size_t off = 0;
+            while (_in.size() - off >= 4 && _in[off] == '$')
+            {
+                size_t len = (uint8_t)_in[off + 2] << 8 | (uint8_t)_in[off + 3];
+                if (_in.size() - off < 4 + len)
+                    break;
+                if (_in[off + 1] == 0)
+                    on_rtp((const uint8_t *)_in.data() + off + 4, len);
+                off += 4 + len;
+            }
+            _in.erase(0, off);
+        }
+        request("TEARDOWN", "Session: " + session + "\r\n");
+        close(_fd);
+        if (_udp >= 0)
+            close(_udp);
+    }
+};
+
+static void print_latency(TestClient &c)
+{
+    if (c.latency.empty())
+        return;
+    std::vector<uint64_t> l = c.latency;
+    std::sort(l.begin(), l.end());
+    log::info("%s: %d frames, %d broken, latency p50 %d us, p99 %d us, max %d us", c.name.c_str(), (int)c.frames.size(), c.broken,
+              (int)l[l.size() / 2], (int)l[l.size() * 99 / 100], (int)l.back());
+}
+
+/**
+ * Frames should be continuous, except jump to an IDR frame after dropped.
+ */
+static bool check_order(TestClient &c)
+{
+    if (c.frames.empty() || !c.idr[0])
+        return false;
+    for (size_t i = 1; i < c.frames.size(); ++i)
+    {
+        if (c.frames[i] != c.frames[i - 1] + 1 && (!c.idr[i] || c.frames[i] <= c.frames[i - 1]))
+            return false;
+    }
+    return true;
+}
+
+static void test_stream(int frame_num, int frame_size, int fps)
+{
+    rtsp::Rtsp server("127.0.0.1", port, fps, rtsp::RtspStreamType::RTSP_STREAM_H264);
+    CHECK(server.start() == err::ERR_NONE);
+
+    std::vector<TestClient *> clients;
+    for (int i = 0; i < 3; ++i)
+        clients.push_back(new TestClient("tcp" + std::to_string(i), true));
+    clients.push_back(new TestClient("udp", false));
+    TestClient *slow = new TestClient("slow", true, 8 * 1024, 2000);
+    clients.push_back(slow);
+    for (auto c : clients)
+        c->start();
+    time::sleep_ms(300);
+
+    uint64_t write_us = 0;
+    for (int i = 0; i < frame_num && !app::need_exit(); ++i)
+    {
+        std::vector<uint8_t> data = make_frame(i, frame_size);
+        video::Frame frame(data.data(), data.size());
+        uint64_t t = time::ticks_us();
+        CHECK(server.write(frame) == err::ERR_NONE);
+        write_us += time::ticks_us() - t;
+        time::sleep_ms(1000 / fps);
+    }
+    time::sleep_ms(300);
+    for (auto c : clients)
+        c->stop();
+
+    for (auto c : clients)
+    {
+        print_latency(*c);
+        CHECK(c->setup_ok);
+        CHECK(c->sps_before_idr);
+        CHECK(check_order(*c));
+        if (c == slow)
+        {
+            // dropped while not reading, then resync at IDR and receive the last frame
+            CHECK(c->frames.size() < (size_t)frame_num && c->frames.back() == frame_num - 1);
+        }
+        else if (c->tcp)
+        {
+            CHECK(c->broken == 0 && c->frames.size() == (size_t)frame_num);
+        }
+        else
+        {
+            CHECK(c->frames.size() > (size_t)frame_num / 2);
+        }
+        delete c;
+    }
+    log::info("write %d frames of %d bytes to %d clients, %d us per frame", frame_num, frame_size, (int)clients.size(),
+              (int)(write_us / frame_num));
+    CHECK(server.stop() == err::ERR_NONE);
+}
+
+static void bench(int client_num, int frame_size, int loop)
+{
+    rtsp::Rtsp server("127.0.0.1", port, 30, rtsp::RtspStreamType::RTSP_STREAM_H264);
+    server.start();
+    std::vector<TestClient *> clients;
+    for (int i = 0; i < client_num; ++i)
+        clients.push_back(new TestClient("bench" + std::to_string(i), true, 4 * 1024 * 1024));
+    for (auto c : clients)
+        c->start();
+    time::sleep_ms(300);
+    std::vector<std::vector<uint8_t>> frames;
+    for (int i = 0; i < gop; ++i)
+        frames.push_back(make_frame(i, frame_size));
+    uint64_t t = time::ticks_us();
+    for (int i = 0; i < loop && !app::need_exit(); ++i)
+    {
+        std::vector<uint8_t> &data = frames[i % gop];
+        video::Frame frame(data.data(), data.size());
+        server.write(frame);
+    }
+    uint64_t t_write = time::ticks_us() - t;
+    time::sleep_ms(300);
+    uint64_t bytes = 0;
+    for (int i = 0; i < loop; ++i)
+        bytes += frames[i % gop].size();
+    int received = 0;
+    for (auto c : clients)
+    {
+        c->stop();
+        received += c->frames.size();
+        delete c;
+    }
+    log::info("%d clients, %d frames unpaced: %d us per frame, %.1f MB/s per client, %d of %d frames received(others dropped by congestion)",
+              client_num, loop, (int)(t_write / loop), bytes * 1.0 / t_write, received, loop * client_num);
+    server.stop();
+}
+
+static void serve(int seconds)
+{
+    // real encoding, open printed url with ffplay or VLC
+    rtsp::Rtsp server("", 8554, 30, rtsp::RtspStreamType::RTSP_STREAM_H264);
+    server.start();
+    for (auto &url : server.get_urls())
+        log::info("ffplay -rtsp_transport tcp %s", url.c_str());
+    rtsp::Region *region = server.add_region(16, 16, 128, 64);
+    image::Image *canvas = region->get_canvas();
+    canvas->draw_rect(0, 0, 128, 64, image::COLOR_RED, -1);
+    delete canvas;
+    server.draw_rect(0, 200, 120, 160, 120, image::COLOR_GREEN, 4);
+    image::Image img(640, 480, image::FMT_YVU420SP);
+    uint64_t end = time::ticks_ms() + seconds * 1000;
+    for (int i = 0; time::ticks_ms() < end && !app::need_exit(); ++i)
+    {
+        uint8_t *p = (uint8_t *)img.data();
+        for (int y = 0; y < 480; ++y)
+            memset(p + y * 640, (uint8_t)(y + i * 4), 640);
+        memset(p + 640 * 480, 128, 640 * 240);
+        server.write(img);
+        time::sleep_ms(33);
+    }
+    server.stop();
+}
+
+void test_rtsp_server()
+{
+    int frame_size = test::arg_int("frame_size", 20000);
+    test_stream(90, frame_size, 30);
+    if (test::bench)
+    {
+        bench(1, frame_size, 300);
+        bench(4, frame_size, 300);
+    }
+    int serve_seconds = test::arg_int("serve", 0);
+    if (serve_seconds > 0)
+        serve(serve_seconds);
+}
@@ -0,0 +1,121 @@
+#include "maix_basic.hpp"
+#include "test.hpp"
+#include <math.h>
+#include <sys/stat.h>
+
+using namespace maix;
+
+/**
+ * Test sys::MetricsSampler with fake procfs files, and benchmark reading metrics.
+ */
+
+static void write_file(const std::string &path, const std::string &content)
+{
+    FILE *f = fopen(path.c_str(), "w");
+    if (!f)
+    {
+        log::error("open %s failed", path.c_str());
+        return;
+    }
+    fwrite(content.data(), 1, content.size(), f);
+    fclose(f);
+}
+
+static void test_fake_root()
+{
+    std::string root = "/tmp/components_test_sys_root";
+    std::string cmd = "mkdir -p " + root + "/proc/123 " + root + "/sys/class/thermal/thermal_zone0";
+    if (system(cmd.c_str()) != 0)
+    {
+        log::error("create fake root failed");
+        ++test::fails;
+        return;
+    }
+    // user nice system idle iowait irq softirq steal guest guest_nice
+    write_file(root + "/proc/stat",
+               "cpu  100 0 100 700 100 0 0 0 0 0\n"
+               "cpu0 50 0 50 350 50 0 0 0 0 0\n"
+               "cpu1 50 0 50 350 50 0 0 0 0 0\n"
+               "intr 12345 0 0\n");
+    write_file(root + "/proc/meminfo",
+               "MemTotal:         262144 kB\n"
+               "MemFree:           10000 kB\n"
+               "MemAvailable:     131072 kB\n");
+    write_file(root + "/proc/123/status",
+               "Name:\ttest\n"
+               "VmRSS:\t    2048 kB\n"
+               "Threads:\t5\n");
+    write_file(root + "/sys/class/thermal/thermal_zone0/temp", "-5500\n");
+
+    sys::MetricsSampler sampler(1000, 4, root, 123);
+    CHECK(sampler.latest().timestamp == 0);
+    CHECK(sampler.sample() == err::ERR_NONE);
+    sys::Metrics m = sampler.latest();
+    CHECK(fabsf(m.cpu - 20) < 0.01f); // first sample is since boot, idle + iowait = 800 of 1000
+    CHECK(m.core_num == 2);
+    CHECK(m.mem_total == 262144ULL * 1024 && m.mem_used == 131072ULL * 1024);
+    CHECK(fabsf(m.temp + 5.5f) < 0.001f);
+    CHECK(m.rss == 2048 * 1024 && m.threads == 5);
+
+    // cpu0 busy 100 of 100, cpu1 busy 0 of 100, file size changed, pread read the new content
+    write_file(root + "/proc/stat",
+               "cpu  200 0 100 800 100 0 0 0 0 0\n"
+               "cpu0 150 0 50 350 50 0 0 0 0 0\n"
+               "cpu1 50 0 50 450 50 0 0 0 0 0\n");
+    CHECK(sampler.sample() == err::ERR_NONE);
+    m = sampler.latest();
+    CHECK(fabsf(m.cpu - 50) < 0.01f);
+    CHECK(fabsf(m.cores[0] - 100) < 0.01f && fabsf(m.cores[1]) < 0.01f);
+    CHECK(m.cpu_cores().size() == 2);
+
+    // ring keep the last 4 samples
+    for (int i = 0; i < 5; ++i)
+        sampler.sample();
+    CHECK(sampler.count() == 7);
+    std::vector<sys::Metrics> h = sampler.history();
+    CHECK(h.size() == 4);
+    CHECK(sampler.history(2).size() == 2);
+    for (size_t i = 1; i < h.size(); ++i)
+        CHECK(h[i].timestamp >= h[i - 1].timestamp);
+    CHECK(sampler.start() == err::ERR_NONE);
+    CHECK(sampler.sample() == err::ERR_BUSY);
+    sampler.stop();
+    cmd = "rm -rf " + root;
+    system(cmd.c_str());
+}
+
+/**
+ * Time of reading metrics from sampler and reading procfs directly
+ */
+static void bench(int interval_ms)
+{
+    sys::MetricsSampler sampler(interval_ms, 60);
+    sampler.start();
+    time::sleep_ms(interval_ms * 3);
+    const int rounds = 10000;
+    uint64_t t = time::ticks_us();
+    for (int i = 0; i < rounds; ++i)
+        sampler.latest();
+    uint64_t t_latest = time::ticks_us() - t;
+    t = time::ticks_us();
+    for (int i = 0; i < rounds / 100; ++i)
+        sampler.history();
+    uint64_t t_history = time::ticks_us() - t;
+    t = time::ticks_us();
+    for (int i = 0; i < rounds / 100; ++i)
+    {
+        sys::cpu_usage();
+        sys::memory_info();
+    }
+    uint64_t t_read = time::ticks_us() - t;
+    log::info("latest() %.3f us, history() %.1f us, cpu_usage() + memory_info() %.1f us",
+              t_latest * 1.0 / rounds, t_history * 100.0 / rounds, t_read * 100.0 / rounds);
+    sampler.stop();
+}
+
+void test_sys_metrics()
+{
+    test_fake_root();
+    if (test::bench)
+        bench(test::arg_int("interval_ms", 100));
+}
@@ -0,0 +1,191 @@
+#include "maix_basic.hpp"
+#include "maix_tensor.hpp"
+#include "test.hpp"
+#include <math.h>
+
+using namespace maix;
+
+/**
+ * Test tensor::Tensor views and math ops, and benchmark them on a YOLO like output.
+ */
+
+static void test_views()
+{
+    tensor::Tensor a({2, 3, 4}, tensor::FLOAT32);
+    float *p = (float *)a.data();
+    for (int i = 0; i < 24; ++i)
+        p[i] = i;
+
+    tensor::Tensor *s = a.slice(2, 1, 4, 2); // a[:, :, 1:4:2]
+    CHECK(s->shape() == std::vector<int>({2, 3, 2}));
+    CHECK(!s->is_contiguous());
+    CHECK(s->at({1, 2, 1}) == 23);
+    tensor::Tensor *sel = a.select(1, -1); // a[:, -1]
+    CHECK(sel->shape() == std::vector<int>({2, 4}));
+    CHECK(sel->at({1, 3}) == 23);
+    tensor::Tensor *t = a.transpose({2, 0, 1});
+    CHECK(t->shape() == std::vector<int>({4, 2, 3}));
+    CHECK(t->at({3, 1, 2}) == 23);
+    tensor::Tensor *c = t->contiguous();
+    CHECK(c->is_contiguous());
+    CHECK(((float *)c->data())[3 * 6 + 1 * 3 + 2] == 23);
+    tensor::Tensor copy(*s);
+    CHECK(copy.data() != s->data() && copy.at({1, 2, 1}) == 23);
+    tensor::Tensor *am = t->argmax(0);
+    CHECK(am->shape() == std::vector<int>({2, 3}) && ((int *)am->data())[0] == 3);
+    CHECK(t->argmax1() == 23);
+    delete am;
+    delete c;
+    delete t;
+    delete sel;
+    delete s;
+
+    int8_t q[6] = {-128, -10, 0, 10, 20, 127};
+    tensor::Tensor qt({2, 3}, tensor::INT8, q);
+    qt.set_quant(0.5f, 10);
+    CHECK(qt.at({0, 2}) == -5.0f);
+    tensor::Tensor *qtt = qt.transpose();
+    tensor::Tensor *dq = qtt->dequantize();
+    CHECK(dq->at({2, 1}) == (127 - 10) * 0.5f);
+    CHECK(qt.sigmoid() == err::ERR_ARGS); // only float32 support in place
+    delete dq;
+    delete qtt;
+
+    tensor::Tensors ts;
+    ts.add_tensor("z", new tensor::Tensor({1}, tensor::FLOAT32), false, true);
+    ts.add_tensor("a", new tensor::Tensor({2}, tensor::FLOAT32), false, true);
+    CHECK(ts[0]->shape()[0] == 1 && ts[1]->shape()[0] == 2 && ts.get_name(-1) == "a");
+}
+
+static void test_math()
+{
+    tensor::Tensor x({1000}, tensor::FLOAT32), y({1000}, tensor::FLOAT32);
+    float *xp = (float *)x.data();
+    float *yp = (float *)y.data();
+    for (int i = 0; i < 1000; ++i)
+        xp[i] = (i - 500) * 0.17f;
+    double max_err = 0;
+    x.exp(&y);
+    for (int i = 0; i < 1000; ++i)
+        max_err = std::max(max_err, (double)fabsf(yp[i] - expf(xp[i])) / expf(xp[i]));
+    log::info("exp max relative error: %g", max_err);
+    CHECK(max_err < 1e-6);
+    max_err = 0;
+    x.sigmoid(&y);
+    for (int i = 0; i < 1000; ++i)
+        max_err = std::max(max_err, (double)fabsf(yp[i] - 1 / (1 + expf(-xp[i]))));
+    log::info("sigmoid max error: %g", max_err);
+    CHECK(max_err < 1e-6);
+
+    // softmax along the middle axis of a transposed view
+    tensor::Tensor a({3, 5, 7}, tensor::FLOAT32), out({3, 7, 5}, tensor::FLOAT32);
+    float *ap = (float *)a.data();
+    for (int i = 0; i < 105; ++i)
+        ap[i] = sinf(i) * 3;
+    tensor::Tensor *t = a.transpose({0, 2, 1});
+    CHECK(t->softmax(-1, &out) == err::ERR_NONE);
+    max_err = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int k = 0; k < 7; ++k)
+        {
+            double sum = 0;
+            for (int j = 0; j < 5; ++j)
+                sum += exp(ap[i * 35 + j * 7 + k]);
+            for (int j = 0; j < 5; ++j)
+                max_err = std::max(max_err, fabs(exp(ap[i * 35 + j * 7 + k]) / sum - out.at({i, k, j})));
+        }
+    }
+    log::info("softmax max error: %g", max_err);
+    CHECK(max_err < 1e-6);
+    delete t;
+}
+
+static void bench(int rounds)
+{
+    const int class_num = 80, box_num = 8400;
+    tensor::Tensor out({1, class_num, box_num}, tensor::FLOAT32);
+    tensor::Tensor tmp({1, class_num, box_num}, tensor::FLOAT32);
+    tensor::Tensor q({1, class_num, box_num}, tensor::INT8);
+    float *p = (float *)out.data();
+    int8_t *qp = (int8_t *)q.data();
+    for (int i = 0; i < class_num * box_num; ++i)
+    {
+        p[i] = sinf(i * 0.37f) * 6;
+        qp[i] = (int8_t)(p[i] * 20);
+    }
+    q.set_quant(0.05f, 0);
+    float *tp = (float *)tmp.data();
+
+    uint64_t t = time::ticks_us();
+    for (int r = 0; r < rounds; ++r)
+        for (int i = 0; i < class_num * box_num; ++i)
+            tp[i] = 1 / (1 + expf(-p[i]));
+    uint64_t t_scalar = time::ticks_us() - t;
+    t = time::ticks_us();
+    for (int r = 0; r < rounds; ++r)
+        out.sigmoid(&tmp);
+    uint64_t t_vec = time::ticks_us() - t;
+    log::info("sigmoid %dx%d: expf loop %d us, Tensor::sigmoid %d us", class_num, box_num, (int)(t_scalar / rounds), (int)(t_vec / rounds));
+
+    t = time::ticks_us();
+    for (int r = 0; r < rounds; ++r)
+        out.softmax(1, &tmp);
+    log::info("softmax along class axis: %d us", (int)((time::ticks_us() - t) / rounds));
+
+    t = time::ticks_us();
+    for (int r = 0; r < rounds; ++r)
+        delete out.argmax(1);
+    log::info("argmax along class axis: %d us", (int)((time::ticks_us() - t) / rounds));
+
+    // int8 output, count boxes with max class score > th, read on the fly or convert to float first
+    float th = 5.95f;
+    int n_get = 0, n_copy = 0;
+    t = time::ticks_us();
+    for (int r = 0; r < rounds; ++r)
+    {
+        n_get = 0;
+        for (int b = 0; b < box_num; ++b)
+        {
+            for (int c = 0; c < class_num; ++c)
+            {
+                if (q.get(q.offset({0, c, b})) > th)
+                {
+                    ++n_get;
+                    break;
+                }
+            }
+        }
+    }
+    uint64_t t_get = time::ticks_us() - t;
+    t = time::ticks_us();
+    for (int r = 0; r < rounds; ++r)
+    {
+        n_copy = 0;
+        tensor::Tensor *f = q.dequantize();
+        float *fp = (float *)f->data();
+        for (int b = 0; b < box_num; ++b)
+        {
+            for (int c = 0; c < class_num; ++c)
+            {
+                if (fp[c * box_num + b] > th)
+                {
+                    ++n_copy;
+                    break;
+                }
+            }
+        }
+        delete f;
+    }
+    uint64_t t_copy = time::ticks_us() - t;
+    CHECK(n_get == n_copy);
+    log::info("int8 scan: dequantize on read %d us, dequantize copy %d us, %d boxes", (int)(t_get / rounds), (int)(t_copy / rounds), n_get);
+}
+
+void test_tensor_ops()
+{
+    test_views();
+    test_math();
+    if (test::bench)
+        bench(test::arg_int("rounds", 20));
+}
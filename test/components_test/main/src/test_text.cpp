@@ -0,0 +1,187 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "test.hpp"
+#include "opencv2/opencv.hpp"
+#include "opencv2/freetype.hpp"
+
+using namespace maix;
+
+/**
+ * Test cached text rendering against opencv, then compare HUD drawing time of
+ * opencv putText, draw_string and draw_strings.
+ */
+
+static const int font_size = 24;
+
+static cv::Mat to_mat(image::Image &img)
+{
+    int type = img.format() == image::FMT_GRAYSCALE ? CV_8UC1 : (img.format() == image::FMT_RGBA8888 || img.format() == image::FMT_BGRA8888) ? CV_8UC4 : CV_8UC3;
+    return cv::Mat(img.height(), img.width(), type, img.data());
+}
+
+static cv::Scalar to_scalar(image::Image &img, image::Color color)
+{
+    image::Color *c = color.to_format2(img.format());
+    cv::Scalar s;
+    switch (img.format())
+    {
+    case image::FMT_GRAYSCALE:
+        s = cv::Scalar(c->gray);
+        break;
+    case image::FMT_BGR888:
+    case image::FMT_BGRA8888:
+        s = cv::Scalar(c->b, c->g, c->r, c->alpha * 255);
+        break;
+    default:
+        s = cv::Scalar(c->r, c->g, c->b, c->alpha * 255);
+        break;
+    }
+    delete c;
+    return s;
+}
+
+/**
+ * Draw text by opencv directly, same as draw_string before glyph cache
+ */
+static void cv_put_text(image::Image &img, const std::string &text, int x, int y, const image::Color &color, float scale,
+                        cv::Ptr<cv::freetype::FreeType2> ft2)
+{
+    cv::Mat mat = to_mat(img);
+    if (ft2)
+    {
+        int h = scale * font_size;
+        cv::Point point(x, y + ft2->getTextSize(text, h, -1, nullptr).height);
+        ft2->putText(mat, text, point, h, to_scalar(img, color), -1, cv::LINE_AA, true);
+    }
+    else
+    {
+        int base_line = 0;
+        cv::Point point(x, y + cv::getTextSize(std::string(text, 0, 1), cv::FONT_HERSHEY_PLAIN, scale, 1, &base_line).height);
+        cv::putText(mat, text, point, cv::FONT_HERSHEY_PLAIN, scale, to_scalar(img, color), 1, cv::LINE_AA, false);
+    }
+}
+
+static void test_same_as_opencv(const std::string &font, cv::Ptr<cv::freetype::FreeType2> ft2)
+{
+    image::Format formats[] = {image::FMT_RGB888, image::FMT_BGR888, image::FMT_GRAYSCALE, image::FMT_RGBA8888, image::FMT_BGRA8888};
+    const char *texts[] = {"FPS: 29.8", "person 0.87", "gjpqy|", "Hello MaixCDK"};
+    float scales[] = {1, 1.5, 2};
+    for (image::Format fmt : formats)
+    {
+        for (float scale : scales)
+        {
+            image::Image a(320, 240, fmt), b(320, 240, fmt);
+            test::fill_pattern(a, 1);
+            test::fill_pattern(b, 1);
+            int y = 10;
+            for (const char *text : texts)
+            {
+                image::Color color = image::Color::from_rgb(255, 60, 120);
+                cv_put_text(a, text, 5, y, color, scale, ft2);
+                b.draw_string(5, y, text, color, scale, -1, false, 0, font);
+                y += 50;
+            }
+            // blend once with equivalent alpha instead of twice, differ 1 at most, overlapped strokes 2 at most
+            CHECK(test::max_diff(a, b) <= 2);
+        }
+    }
+    if (ft2)
+    {
+        int base_line = 0;
+        cv::Size size = ft2->getTextSize("Hello MaixCDK", font_size, 1, &base_line);
+        image::Size size2 = image::string_size("Hello MaixCDK", 1, 1, font);
+        CHECK(size2.width() == size.width && size2.height() == size.height + base_line + 1);
+    }
+}
+
+static void test_draw_strings(const std::string &font)
+{
+    std::vector<std::string> texts = {"cat 0.91", "dog 0.45", "FPS 30"};
+    std::vector<int> points = {0, 0, 100, 50, 280, 220}; // last one clipped
+    std::vector<image::Color> colors = {image::COLOR_RED, image::COLOR_GREEN, image::COLOR_BLUE};
+    image::Image a(320, 240, image::FMT_RGB888), b(320, 240, image::FMT_RGB888);
+    test::fill_pattern(a, 2);
+    test::fill_pattern(b, 2);
+    a.draw_strings(points, texts, colors, 1.5, -1, font);
+    for (size_t i = 0; i < texts.size(); ++i)
+        b.draw_string(points[i * 2], points[i * 2 + 1], texts[i], colors[i], 1.5, -1, false, 0, font);
+    CHECK(test::max_diff(a, b) == 0);
+
+    bool caught = false;
+    try
+    {
+        a.draw_strings({0, 0}, texts, colors);
+    }
+    catch (err::Exception &e)
+    {
+        caught = true;
+    }
+    CHECK(caught);
+}
+
+/**
+ * HUD like overlay, FPS and labels of 20 objects every frame
+ */
+static void bench(const std::string &name, const std::string &font, cv::Ptr<cv::freetype::FreeType2> ft2, int loop)
+{
+    image::Image img(640, 480, image::FMT_RGB888);
+    test::fill_pattern(img, 3);
+    std::vector<std::string> texts;
+    std::vector<int> points;
+    const char *labels[] = {"person", "car", "dog", "bicycle"};
+    for (int i = 0; i < 20; ++i)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%s %.2f", labels[i % 4], 0.5 + i * 0.02);
+        texts.push_back(buf);
+        points.push_back(i % 4 * 150 + 10);
+        points.push_back(i / 4 * 80 + 40);
+    }
+    std::vector<image::Color> colors = {image::COLOR_GREEN};
+    int frame = 0;
+    double t_cv = test::time_ms(loop, [&]() {
+        cv_put_text(img, "FPS: " + std::to_string(25 + frame++ % 10), 0, 0, image::COLOR_RED, 1, ft2);
+        for (size_t i = 0; i < texts.size(); ++i)
+            cv_put_text(img, texts[i], points[i * 2], points[i * 2 + 1], colors[0], 1, ft2);
+    });
+    double t_one = test::time_ms(loop, [&]() {
+        img.draw_string(0, 0, "FPS: " + std::to_string(25 + frame++ % 10), image::COLOR_RED, 1, -1, false, 0, font);
+        for (size_t i = 0; i < texts.size(); ++i)
+            img.draw_string(points[i * 2], points[i * 2 + 1], texts[i], colors[0], 1, -1, false, 0, font);
+    });
+    double t_batch = test::time_ms(loop, [&]() {
+        img.draw_string(0, 0, "FPS: " + std::to_string(25 + frame++ % 10), image::COLOR_RED, 1, -1, false, 0, font);
+        img.draw_strings(points, texts, colors, 1, -1, font);
+    });
+    double t_size = test::time_ms(loop, [&]() {
+        for (size_t i = 0; i < texts.size(); ++i)
+            image::string_size(texts[i], 1, -1, font);
+    });
+    log::info("%s, 21 strings per frame: opencv putText %.3f ms, draw_string %.3f ms(x%.1f), draw_strings %.3f ms(x%.1f), string_size %.3f ms",
+              name.c_str(), t_cv, t_one, t_cv / t_one, t_batch, t_cv / t_batch, t_size);
+}
+
+void test_text()
+{
+    std::string font_path = test::arg("font", "/maixapp/share/font/SourceHanSansCN-Regular.otf");
+    test_same_as_opencv("hershey_plain", nullptr);
+    test_draw_strings("hershey_plain");
+    cv::Ptr<cv::freetype::FreeType2> ft2;
+    if (fs::exists(font_path))
+    {
+        CHECK(image::load_font("bench_font", font_path.c_str(), font_size) == err::ERR_NONE);
+        ft2 = cv::freetype::createFreeType2();
+        ft2->loadFontData(font_path, 0);
+        test_same_as_opencv("bench_font", ft2);
+        test_draw_strings("bench_font");
+    }
+    else
+        log::warn("font %s not found, skip FreeType font", font_path.c_str());
+    if (!test::bench)
+        return;
+
+    int loop = test::arg_int("loop", 50);
+    bench("hershey_plain", "hershey_plain", nullptr, loop);
+    if (ft2)
+        bench(font_path, "bench_font", ft2, loop);
+}
@@ -0,0 +1,187 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "test.hpp"
+#include <atomic>
+
+using namespace maix;
+
+/**
+ * Test thread pool tasks, futures and parallel_for, benchmark image operators with 1 to N threads.
+ */
+
+static void test_submit()
+{
+    thread::ThreadPool pool(4);
+    CHECK(pool.size() == 4);
+    std::future<int> f = pool.submit([]() { return 42; });
+    CHECK(f.get() == 42);
+
+    std::future<void> f_err = pool.submit([]() { throw err::Exception(err::ERR_RUNTIME, "test"); });
+    bool caught = false;
+    try
+    {
+        f_err.get();
+    }
+    catch (err::Exception &e)
+    {
+        caught = true;
+    }
+    CHECK(caught);
+
+    // nested parallel_for in tasks, caller of parallel_for runs chunks too so no dead lock
+    std::vector<std::future<long>> futures;
+    for (int i = 0; i < 16; ++i)
+    {
+        futures.push_back(pool.submit([&pool]() {
+            std::atomic<long> sum{0};
+            pool.parallel_for(0, 1000, [&sum](int begin, int end) {
+                long s = 0;
+                for (int i = begin; i < end; ++i)
+                    s += i;
+                sum += s;
+            }, 1, 4);
+            return (long)sum;
+        }));
+    }
+    for (auto &f : futures)
+        CHECK(f.get() == 499500);
+}
+
+static void test_parallel_for()
+{
+    thread::ThreadPool pool(4);
+    int grains[] = {1, 2, 7, 64};
+    int sizes[] = {0, 1, 5, 100, 479, 480, 1000};
+    for (int grain : grains)
+    {
+        for (int threads = 1; threads <= 6; ++threads)
+        {
+            for (int n : sizes)
+            {
+                std::vector<std::atomic<int>> hits(n);
+                std::atomic<int> bad_begin{0};
+                pool.parallel_for(0, n, [&](int begin, int end) {
+                    if (begin % grain != 0)
+                        ++bad_begin;
+                    for (int i = begin; i < end; ++i)
+                        ++hits[i];
+                }, grain, threads);
+                CHECK(bad_begin == 0);
+                for (int i = 0; i < n; ++i)
+                    CHECK(hits[i] == 1);
+            }
+        }
+    }
+
+    // exception rethrown after all chunks finished
+    bool caught = false;
+    try
+    {
+        pool.parallel_for(0, 100, [](int begin, int end) {
+            if (begin <= 50 && 50 < end)
+                throw err::Exception(err::ERR_ARGS, "test");
+        }, 1, 4);
+    }
+    catch (err::Exception &e)
+    {
+        caught = true;
+    }
+    CHECK(caught);
+
+    // thread count setting
+    int old = thread::parallel_threads();
+    thread::set_parallel_threads(3);
+    CHECK(thread::parallel_threads() == 3);
+    thread::Thread th([](void *args) {
+        thread::set_parallel_threads(1, true);
+        *(bool *)args = thread::parallel_threads() == 1;
+    }, &caught);
+    th.join();
+    CHECK(caught && thread::parallel_threads() == 3);
+    thread::set_parallel_threads(0);
+    CHECK(thread::parallel_threads() == thread::cpu_count());
+    thread::set_parallel_threads(old);
+}
+
+static bool same(image::Image *a, image::Image *b)
+{
+    return a->data_size() == b->data_size() && memcmp(a->data(), b->data(), a->data_size()) == 0;
+}
+
+/**
+ * Multi threads result should be the same as single thread
+ */
+static void test_image()
+{
+    image::Image rgb(640, 480, image::FMT_RGB888);
+    image::Image nv21(640, 480, image::FMT_YVU420SP);
+    test::fill_pattern(rgb, 1);
+    test::fill_pattern(nv21, 2);
+    int old = thread::parallel_threads();
+    image::Image *res[2][4];
+    for (int i = 0; i < 2; ++i)
+    {
+        thread::set_parallel_threads(i == 0 ? 1 : 4);
+        res[i][0] = rgb.to_format(image::FMT_GRAYSCALE);
+        res[i][1] = rgb.to_format(image::FMT_BGRA8888);
+        res[i][2] = nv21.resize(320, 224);
+        res[i][3] = rgb.midpoint_pool(2, 2, 0.5, true);
+    }
+    for (int j = 0; j < 4; ++j)
+    {
+        CHECK(same(res[0][j], res[1][j]));
+        delete res[0][j];
+        delete res[1][j];
+    }
+    thread::set_parallel_threads(old);
+}
+
+static void bench(int max_threads, int loop)
+{
+    image::Image rgb(1280, 720, image::FMT_RGB888);
+    image::Image nv21(1280, 720, image::FMT_YVU420SP);
+    image::Image rgba(1280, 720, image::FMT_RGBA8888);
+    test::fill_pattern(rgb, 3);
+    test::fill_pattern(nv21, 4);
+    test::fill_pattern(rgba, 5);
+    int old = thread::parallel_threads();
+    std::vector<double> base;
+    for (int threads = 1; threads <= max_threads && !app::need_exit(); ++threads)
+    {
+        thread::set_parallel_threads(threads);
+        std::vector<double> t;
+        t.push_back(test::time_ms(loop, [&rgb]() { delete rgb.to_format(image::FMT_GRAYSCALE); }));
+        t.push_back(test::time_ms(loop, [&rgb]() { delete rgb.to_format(image::FMT_BGRA8888); }));
+        t.push_back(test::time_ms(loop, [&nv21]() { delete nv21.resize(640, 360, image::Fit::FIT_FILL, image::ResizeMethod::BILINEAR); }));
+        t.push_back(test::time_ms(loop, [&nv21]() { delete nv21.rotate(90); }));
+        t.push_back(test::time_ms(loop, [&rgba]() {
+            rgba.invalidate_cache();
+            rgba.cached_gray();
+        }));
+        t.push_back(test::time_ms(loop, [&rgb]() { delete rgb.midpoint_pool(4, 4, 0.5, true); }));
+        if (base.empty())
+            base = t;
+        log::info("%d threads: to gray %.2f ms(x%.2f), to bgra %.2f ms(x%.2f), nv21 resize %.2f ms(x%.2f), nv21 rotate %.2f ms(x%.2f), "
+                  "cached_gray %.2f ms(x%.2f), midpoint_pool %.2f ms(x%.2f)",
+                  threads, t[0], base[0] / t[0], t[1], base[1] / t[1], t[2], base[2] / t[2],
+                  t[3], base[3] / t[3], t[4], base[4] / t[4], t[5], base[5] / t[5]);
+    }
+    thread::set_parallel_threads(old);
+}
+
+void test_thread_pool()
+{
+    test_submit();
+    test_parallel_for();
+    test_image();
+    if (!test::bench)
+        return;
+
+    int max_threads = test::arg_int("max_threads", thread::cpu_count());
+    int loop = test::arg_int("loop", 20);
+    // caller thread runs chunks too, so pool need max_threads - 1 workers at least
+    if (max_threads - 1 > thread::pool().size())
+        thread::config_pool(max_threads - 1);
+    log::info("cpu cores: %d, pool workers: %d", thread::cpu_count(), thread::pool().size());
+    bench(max_threads, loop);
+}
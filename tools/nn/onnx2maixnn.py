@@ -0,0 +1,315 @@
+#
+# Convert ONNX model to maixnn format, which can run by CPU backend of maix.nn.NN on Linux.
+# @author neucrack@sipeed
+# @license Apache 2.0
+#
+# Usage:
+#   python onnx2maixnn.py model.onnx model.maixnn
+# Then write a mud file like:
+#   [basic]
+#   type = maixnn
+#   model = model.maixnn
+#
+# Requirements: pip install onnx numpy
+# Only batch 1 and static shape supported, all tensors are float32.
+#
+
+import argparse
+import struct
+import sys
+
+import numpy as np
+import onnx
+from onnx import numpy_helper, shape_inference
+
+MXNN_VERSION = 1
+
+OP_CONV = 0
+OP_ACT = 1
+OP_ADD = 2
+OP_SUB = 3
+OP_MUL = 4
+OP_DIV = 5
+OP_CONCAT = 6
+OP_SLICE = 7
+OP_MAXPOOL = 8
+OP_AVGPOOL = 9
+OP_GLOBAL_AVGPOOL = 10
+OP_RESIZE_NEAREST = 11
+OP_RESHAPE = 12
+OP_TRANSPOSE = 13
+OP_SOFTMAX = 14
+OP_GEMM = 15
+
+ACT_NONE = 0
+ACT_RELU = 1
+ACT_LEAKY_RELU = 2
+ACT_SIGMOID = 3
+ACT_SILU = 4
+ACT_RELU6 = 5
+ACT_HARDSWISH = 6
+ACT_TANH = 7
+
+BINARY_OPS = {"Add": OP_ADD, "Sub": OP_SUB, "Mul": OP_MUL, "Div": OP_DIV}
+RESHAPE_OPS = ("Reshape", "Flatten", "Squeeze", "Unsqueeze", "Identity", "Dropout")
+
+
+class Converter:
+    def __init__(self, model):
+        model = shape_inference.infer_shapes(model)
+        self.graph = model.graph
+        self.consts = {}
+        self.shapes = {}
+        self.tensors = []   # [name, shape, data]
+        self.tensor_ids = {}
+        self.nodes = []     # [op, ins, outs, iparams, fparams]
+        for init in self.graph.initializer:
+            self.consts[init.name] = numpy_helper.to_array(init)
+        for v in list(self.graph.input) + list(self.graph.value_info) + list(self.graph.output):
+            dims = v.type.tensor_type.shape.dim
+            self.shapes[v.name] = [d.dim_value if d.dim_value > 0 else 1 for d in dims]
+        self.consumers = {}
+        for node in self.graph.node:
+            for name in node.input:
+                self.consumers.setdefault(name, []).append(node)
+        self.fused = set()
+
+    def attr(self, node, name, default=None):
+        for a in node.attribute:
+            if a.name == name:
+                return onnx.helper.get_attribute_value(a)
+        return default
+
+    def shape(self, name):
+        if name in self.consts:
+            return list(self.consts[name].shape)
+        if name not in self.shapes:
+            raise Exception("shape of {} unknown, please simplify model with onnxsim first".format(name))
+        return self.shapes[name]
+
+    def tensor(self, name, data=None):
+        if name in self.tensor_ids:
+            return self.tensor_ids[name]
+        if data is None and name in self.consts:
+            data = self.consts[name]
+        if data is not None:
+            data = np.ascontiguousarray(data, dtype=np.float32)
+            shape = list(data.shape) if data.ndim > 0 else [1]
+        else:
+            shape = self.shape(name)
+        self.tensor_ids[name] = len(self.tensors)
+        self.tensors.append([name, shape, data])
+        return self.tensor_ids[name]
+
+    def add_node(self, op, ins, outs, iparams=(), fparams=()):
+        self.nodes.append([op, [self.tensor(i) if isinstance(i, str) else i for i in ins],
+                           [self.tensor(o) for o in outs], list(iparams), list(fparams)])
+
+    def only_consumer(self, name):
+        consumers = self.consumers.get(name, [])
+        outputs = [o.name for o in self.graph.output]
+        return consumers[0] if len(consumers) == 1 and name not in outputs else None
+
+    def act_of(self, node):
+        '''
+        return (act, alpha) if node is activation, else None
+        '''
+        if node.op_type == "Relu":
+            return ACT_RELU, 0
+        if node.op_type == "LeakyRelu":
+            return ACT_LEAKY_RELU, self.attr(node, "alpha", 0.01)
+        if node.op_type == "Sigmoid":
+            return ACT_SIGMOID, 0
+        if node.op_type == "HardSwish":
+            return ACT_HARDSWISH, 0
+        if node.op_type == "Tanh":
+            return ACT_TANH, 0
+        if node.op_type == "Clip":
+            lo = self.consts.get(node.input[1]) if len(node.input) > 1 and node.input[1] else self.attr(node, "min")
+            hi = self.consts.get(node.input[2]) if len(node.input) > 2 and node.input[2] else self.attr(node, "max")
+            if lo is not None and hi is not None and float(lo) == 0 and float(hi) == 6:
+                return ACT_RELU6, 0
+        return None
+
+    def fuse_act(self, out):
+        '''
+        try fuse activation after out, return (act, alpha, final output name)
+        '''
+        consumers = self.consumers.get(out, [])
+        outputs = [o.name for o in self.graph.output]
+        if out in outputs:
+            return ACT_NONE, 0, out
+        # SiLU: x * sigmoid(x)
+        if len(consumers) == 2:
+            sig = [n for n in consumers if n.op_type == "Sigmoid"]
+            mul = [n for n in consumers if n.op_type == "Mul"]
+            if sig and mul and self.only_consumer(sig[0].output[0]) is mul[0] and sig[0].output[0] in mul[0].input:
+                self.fused.update([id(sig[0]), id(mul[0])])
+                return ACT_SILU, 0, mul[0].output[0]
+        if len(consumers) == 1:
+            act = self.act_of(consumers[0])
+            if act:
+                self.fused.add(id(consumers[0]))
+                return act[0], act[1], consumers[0].output[0]
+        return ACT_NONE, 0, out
+
+    def pads(self, node, ndim=2):
+        pads = self.attr(node, "pads", [0] * ndim * 2)
+        auto_pad = self.attr(node, "auto_pad", b"NOTSET")
+        if auto_pad not in (b"NOTSET", b"VALID"):
+            in_shape = self.shape(node.input[0])
+            out_shape = self.shape(node.output[0])
+            kernel = self.attr(node, "kernel_shape") or self.shape(node.input[1])[2:]
+            strides = self.attr(node, "strides", [1] * ndim)
+            pads = [0] * ndim * 2
+            for i in range(ndim):
+                total = max((out_shape[2 + i] - 1) * strides[i] + kernel[i] - in_shape[2 + i], 0)
+                small, big = total // 2, total - total // 2
+                pads[i], pads[i + ndim] = (small, big) if auto_pad == b"SAME_UPPER" else (big, small)
+        return pads
+
+    def convert_node(self, node):
+        t = node.op_type
+        if t == "Conv":
+            w_shape = self.shape(node.input[1])
+            if len(w_shape) != 4:
+                raise Exception("only support Conv2d")
+            kernel = self.attr(node, "kernel_shape", w_shape[2:])
+            strides = self.attr(node, "strides", [1, 1])
+            dilations = self.attr(node, "dilations", [1, 1])
+            pads = self.pads(node)
+            group = self.attr(node, "group", 1)
+            act, alpha, out = self.fuse_act(node.output[0])
+            ins = [node.input[0], node.input[1]] + ([node.input[2]] if len(node.input) > 2 and node.input[2] else [])
+            self.add_node(OP_CONV, ins, [out],
+                          [kernel[0], kernel[1], strides[0], strides[1], pads[0], pads[1], pads[2], pads[3],
+                           dilations[0], dilations[1], group, act], [alpha])
+        elif self.act_of(node):
+            act, alpha = self.act_of(node)
+            if act == ACT_SIGMOID:
+                consumer = self.only_consumer(node.output[0])
+                if consumer and consumer.op_type == "Mul" and node.input[0] in consumer.input:
+                    self.fused.add(id(consumer))
+                    self.add_node(OP_ACT, [node.input[0]], [consumer.output[0]], [ACT_SILU], [0])
+                    return
+            self.add_node(OP_ACT, [node.input[0]], [node.output[0]], [act], [alpha])
+        elif t in BINARY_OPS:
+            self.add_node(BINARY_OPS[t], list(node.input), [node.output[0]])
+        elif t == "Concat":
+            axis = self.attr(node, "axis")
+            if axis < 0:
+                axis += len(self.shape(node.output[0]))
+            self.add_node(OP_CONCAT, list(node.input), [node.output[0]], [axis])
+        elif t == "Split":
+            in_shape = self.shape(node.input[0])
+            axis = self.attr(node, "axis", 0)
+            if axis < 0:
+                axis += len(in_shape)
+            start = 0
+            for out in node.output:
+                count = self.shape(out)[axis]
+                self.add_node(OP_SLICE, [node.input[0]], [out], [axis, start, 1])
+                start += count
+        elif t == "Slice":
+            in_shape = self.shape(node.input[0])
+            starts = self.consts[node.input[1]].tolist()
+            axes = self.consts[node.input[3]].tolist() if len(node.input) > 3 and node.input[3] else list(range(len(starts)))
+            steps = self.consts[node.input[4]].tolist() if len(node.input) > 4 and node.input[4] else [1] * len(starts)
+            if len(starts) != 1:
+                raise Exception("Slice only support one axis")
+            axis = axes[0] + len(in_shape) if axes[0] < 0 else axes[0]
+            start = starts[0] + in_shape[axis] if starts[0] < 0 else starts[0]
+            start = min(max(start, 0), in_shape[axis] - 1)
+            if steps[0] <= 0:
+                raise Exception("Slice only support positive step")
+            self.add_node(OP_SLICE, [node.input[0]], [node.output[0]], [axis, start, steps[0]])
+        elif t in ("MaxPool", "AveragePool"):
+            kernel = self.attr(node, "kernel_shape")
+            strides = self.attr(node, "strides", [1, 1])
+            pads = self.pads(node)
+            self.add_node(OP_MAXPOOL if t == "MaxPool" else OP_AVGPOOL, [node.input[0]], [node.output[0]],
+                          [kernel[0], kernel[1], strides[0], strides[1], pads[0], pads[1], pads[2], pads[3]])
+        elif t == "GlobalAveragePool":
+            self.add_node(OP_GLOBAL_AVGPOOL, [node.input[0]], [node.output[0]])
+        elif t in ("Resize", "Upsample"):
+            if self.attr(node, "mode", b"nearest") != b"nearest":
+                raise Exception("Resize only support nearest mode")
+            self.add_node(OP_RESIZE_NEAREST, [node.input[0]], [node.output[0]])
+        elif t in RESHAPE_OPS:
+            self.add_node(OP_RESHAPE, [node.input[0]], [node.output[0]])
+        elif t == "Transpose":
+            perm = self.attr(node, "perm", list(reversed(range(len(self.shape(node.input[0]))))))
+            self.add_node(OP_TRANSPOSE, [node.input[0]], [node.output[0]], perm)
+        elif t == "Softmax":
+            axis = self.attr(node, "axis", -1)
+            if axis < 0:
+                axis += len(self.shape(node.input[0]))
+            self.add_node(OP_SOFTMAX, [node.input[0]], [node.output[0]], [axis])
+        elif t in ("Gemm", "MatMul"):
+            w = self.consts.get(node.input[1])
+            if w is None or w.ndim != 2:
+                raise Exception("{} only support constant 2D weight".format(t))
+            trans_b = self.attr(node, "transB", 0) if t == "Gemm" else 0
+            if self.attr(node, "transA", 0) or self.attr(node, "alpha", 1.0) != 1.0 or self.attr(node, "beta", 1.0) != 1.0:
+                raise Exception("Gemm only support transA = 0, alpha = beta = 1")
+            w = w if trans_b else w.T
+            ins = [node.input[0], self.tensor(node.input[1] + "_maixnn", w)]
+            if t == "Gemm" and len(node.input) > 2 and node.input[2]:
+                ins.append(node.input[2])
+            self.add_node(OP_GEMM, ins, [node.output[0]], [ACT_NONE], [0])
+        elif t == "Constant":
+            self.consts[node.output[0]] = numpy_helper.to_array(self.attr(node, "value"))
+        elif t == "Shape":
+            self.consts[node.output[0]] = np.array(self.shape(node.input[0]), dtype=np.int64)
+        else:
+            raise Exception("op {} not support yet".format(t))
+
+    def convert(self):
+        init_names = set(self.consts.keys())
+        self.inputs = [self.tensor(i.name) for i in self.graph.input if i.name not in init_names]
+        for node in self.graph.node:
+            if id(node) in self.fused:
+                continue
+            # fold nodes with all constant inputs, e.g. shape compute of Reshape
+            if node.op_type not in ("Constant", "Shape") and all(i in self.consts for i in node.input if i) \
+                    and node.op_type in ("Gather", "Concat", "Unsqueeze", "Cast", "Mul", "Add", "Div", "Sub"):
+                raise Exception("please simplify model with onnxsim first, node {} can be folded".format(node.name))
+            self.convert_node(node)
+        self.outputs = [self.tensor(o.name) for o in self.graph.output]
+
+    def save(self, path):
+        with open(path, "wb") as f:
+            f.write(b"MXNN" + struct.pack("<I", MXNN_VERSION))
+            f.write(struct.pack("<I", len(self.tensors)))
+            for name, shape, data in self.tensors:
+                name = name.encode()
+                f.write(struct.pack("<I", len(name)) + name)
+                f.write(struct.pack("<I", len(shape)) + struct.pack("<{}i".format(len(shape)), *shape))
+                f.write(struct.pack("<I", 0 if data is None else 1))
+                if data is not None:
+                    f.write(data.astype("<f4").tobytes())
+            f.write(struct.pack("<I", len(self.nodes)))
+            for op, ins, outs, iparams, fparams in self.nodes:
+                f.write(struct.pack("<I", op))
+                for arr in (ins, outs, iparams):
+                    f.write(struct.pack("<I", len(arr)) + struct.pack("<{}i".format(len(arr)), *arr))
+                f.write(struct.pack("<I", len(fparams)) + struct.pack("<{}f".format(len(fparams)), *fparams))
+            for arr in (self.inputs, self.outputs):
+                f.write(struct.pack("<I", len(arr)) + struct.pack("<{}i".format(len(arr)), *arr))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="convert onnx model to maixnn format")
+    parser.add_argument("input", help="onnx model path")
+    parser.add_argument("output", help="output maixnn model path")
+    args = parser.parse_args()
+
+    c = Converter(onnx.load(args.input))
+    try:
+        c.convert()
+    except Exception as e:
+        print("-- [ERROR] {}".format(e))
+        sys.exit(1)
+    c.save(args.output)
+    print("-- convert done, {} nodes, inputs: {}, outputs: {}".format(
+        len(c.nodes), [c.tensors[i][0] for i in c.inputs], [c.tensors[i][0] for i in c.outputs]))